@@ -163,6 +163,7 @@ INCLUDEPATH += \
 
 FORMS += \
     src/QGCQmlWidgetHolder.ui \
+    src/ui/ImpairedLinkConfigurationWidget.ui \
     src/ui/Linechart.ui \
     src/ui/LogReplayLinkConfigurationWidget.ui \
     src/ui/MainWindow.ui \
@@ -205,6 +206,7 @@ FORMS += \
 HEADERS += \
     src/audio/QGCAudioWorker.h \
     src/CmdLineOptParser.h \
+    src/comm/ImpairedLink.h \
     src/comm/LinkConfiguration.h \
     src/comm/LinkInterface.h \
     src/comm/LinkManager.h \
@@ -227,15 +229,18 @@ HEADERS += \
     src/LogCompressor.h \
     src/MG.h \
     src/MissionEditor/MissionEditor.h \
+    src/MissionEditor/MissionItemStore.h \
     src/MissionManager/MissionManager.h \
     src/QGC.h \
     src/QGCApplication.h \
     src/QGCComboBox.h \
     src/QGCConfig.h \
     src/QGCDockWidget.h \
+    src/EventLoopMonitor.h \
     src/QGCFileDialog.h \
     src/QGCGeo.h \
     src/QGCLoggingCategory.h \
+    src/QGCTrace.h \
     src/QGCMessageBox.h \
     src/QGCPalette.h \
     src/QGCQmlWidgetHolder.h \
@@ -245,12 +250,16 @@ HEADERS += \
     src/QmlControls/CoordinateVector.h \
     src/QmlControls/MavlinkQmlSingleton.h \
     src/QmlControls/ParameterEditorController.h \
+    src/QmlControls/ParameterListModel.h \
+    src/QmlControls/ParameterSearchIndex.h \
     src/QmlControls/ScreenToolsController.h \
     src/QmlControls/QGCQGeoCoordinate.h \
     src/QmlControls/QGroundControlQmlGlobal.h \
     src/QmlControls/QmlObjectListModel.h \
     src/SerialPortIds.h \
     src/uas/FileManager.h \
+    src/uas/FileSync.h \
+    src/uas/ImageReassembler.h \
     src/uas/UAS.h \
     src/uas/UASInterface.h \
     src/uas/UASMessageHandler.h \
@@ -261,6 +270,8 @@ HEADERS += \
     src/ui/linechart/LinechartWidget.h \
     src/ui/linechart/Scrollbar.h \
     src/ui/linechart/ScrollZoomer.h \
+    src/ui/EventLoopMonitorWidget.h \
+    src/ui/ImpairedLinkConfigurationWidget.h \
     src/ui/LogReplayLinkConfigurationWidget.h \
     src/ui/MainWindow.h \
     src/ui/mavlink/QGCMAVLinkMessageSender.h \
@@ -321,6 +332,7 @@ HEADERS += \
 SOURCES += \
     src/audio/QGCAudioWorker.cpp \
     src/CmdLineOptParser.cc \
+    src/comm/ImpairedLink.cc \
     src/comm/LinkConfiguration.cc \
     src/comm/LinkManager.cc \
     src/comm/LogReplayLink.cc \
@@ -340,13 +352,16 @@ SOURCES += \
     src/LogCompressor.cc \
     src/main.cc \
     src/MissionEditor/MissionEditor.cc \
+    src/MissionEditor/MissionItemStore.cc \
     src/MissionManager/MissionManager.cc \
     src/QGC.cc \
     src/QGCApplication.cc \
     src/QGCComboBox.cc \
     src/QGCDockWidget.cc \
+    src/EventLoopMonitor.cc \
     src/QGCFileDialog.cc \
     src/QGCLoggingCategory.cc \
+    src/QGCTrace.cc \
     src/QGCPalette.cc \
     src/QGCQmlWidgetHolder.cpp \
     src/QGCQuickWidget.cc \
@@ -354,11 +369,15 @@ SOURCES += \
     src/QGCTemporaryFile.cc \
     src/QmlControls/CoordinateVector.cc \
     src/QmlControls/ParameterEditorController.cc \
+    src/QmlControls/ParameterListModel.cc \
+    src/QmlControls/ParameterSearchIndex.cc \
     src/QmlControls/ScreenToolsController.cc \
     src/QmlControls/QGCQGeoCoordinate.cc \
     src/QmlControls/QGroundControlQmlGlobal.cc \
     src/QmlControls/QmlObjectListModel.cc \
     src/uas/FileManager.cc \
+    src/uas/FileSync.cc \
+    src/uas/ImageReassembler.cc \
     src/uas/UAS.cc \
     src/uas/UASMessageHandler.cc \
     src/ui/linechart/ChartPlot.cc \
@@ -368,6 +387,8 @@ SOURCES += \
     src/ui/linechart/LinechartWidget.cc \
     src/ui/linechart/Scrollbar.cc \
     src/ui/linechart/ScrollZoomer.cc \
+    src/ui/EventLoopMonitorWidget.cc \
+    src/ui/ImpairedLinkConfigurationWidget.cc \
     src/ui/LogReplayLinkConfigurationWidget.cc \
     src/ui/MainWindow.cc \
     src/ui/mavlink/QGCMAVLinkMessageSender.cc \
@@ -443,44 +464,89 @@ SOURCES += src/QmlControls/QmlTestWidget.cc
 INCLUDEPATH += \
 	src/qgcunittest
 
+# QGCTileStoreTest drives the map plugin's tile fetcher, which is built on the QtLocation private api
+QT += location-private
+
 HEADERS += \
     src/FactSystem/FactSystemTestBase.h \
     src/FactSystem/FactSystemTestGeneric.h \
     src/FactSystem/FactSystemTestPX4.h \
+    src/FactSystem/ParameterLoaderTest.h \
     src/MissionItemTest.h \
     src/MissionManager/MissionManagerTest.h \
+    src/qgcunittest/EventLoopMonitorTest.h \
+    src/qgcunittest/FactValueBenchmark.h \
     src/qgcunittest/FileDialogTest.h \
     src/qgcunittest/FileManagerTest.h \
+    src/qgcunittest/FileSyncTest.h \
     src/qgcunittest/FlightGearTest.h \
+    src/qgcunittest/ImageReassemblerTest.h \
+    src/qgcunittest/ImpairedLinkTest.h \
     src/qgcunittest/LinkManagerTest.h \
     src/qgcunittest/MainWindowTest.h \
     src/qgcunittest/MavlinkLogTest.h \
     src/qgcunittest/MessageBoxTest.h \
+    src/qgcunittest/MissionItemStoreTest.h \
+    src/qgcunittest/MockLinkSwarmTest.h \
+    src/qgcunittest/MockTileServer.h \
     src/qgcunittest/MultiSignalSpy.h \
+    src/qgcunittest/OfflineVehicleFixture.h \
+    src/qgcunittest/ParameterSearchIndexTest.h \
     src/qgcunittest/PX4RCCalibrationTest.h \
+    src/qgcunittest/QGCDecodedTileCacheTest.h \
+    src/qgcunittest/QGCTileSchedulerTest.h \
+    src/qgcunittest/QGCTileStoreTest.h \
+    src/qgcunittest/QGCTraceTest.h \
+    src/qgcunittest/ReceivePipelineBenchmark.h \
     src/qgcunittest/TCPLinkTest.h \
     src/qgcunittest/TCPLoopBackServer.h \
+    src/qgcunittest/TrajectoryStoreTest.h \
+    src/qgcunittest/UASMessageHandlerTest.h \
     src/qgcunittest/UnitTest.h \
+    src/qgcunittest/VehicleCommandManagerTest.h \
+    src/qgcunittest/VehiclePropertyFlushTest.h \
+    src/qgcunittest/VehicleTimeSyncTest.h \
     src/VehicleSetup/SetupViewTest.h \
 
 SOURCES += \
     src/FactSystem/FactSystemTestBase.cc \
     src/FactSystem/FactSystemTestGeneric.cc \
     src/FactSystem/FactSystemTestPX4.cc \
+    src/FactSystem/ParameterLoaderTest.cc \
     src/MissionItemTest.cc \
     src/MissionManager/MissionManagerTest.cc \
+    src/qgcunittest/EventLoopMonitorTest.cc \
+    src/qgcunittest/FactValueBenchmark.cc \
     src/qgcunittest/FileDialogTest.cc \
     src/qgcunittest/FileManagerTest.cc \
+    src/qgcunittest/FileSyncTest.cc \
     src/qgcunittest/FlightGearTest.cc \
+    src/qgcunittest/ImageReassemblerTest.cc \
+    src/qgcunittest/ImpairedLinkTest.cc \
     src/qgcunittest/LinkManagerTest.cc \
     src/qgcunittest/MainWindowTest.cc \
     src/qgcunittest/MavlinkLogTest.cc \
     src/qgcunittest/MessageBoxTest.cc \
+    src/qgcunittest/MissionItemStoreTest.cc \
+    src/qgcunittest/MockLinkSwarmTest.cc \
+    src/qgcunittest/MockTileServer.cc \
     src/qgcunittest/MultiSignalSpy.cc \
+    src/qgcunittest/OfflineVehicleFixture.cc \
+    src/qgcunittest/ParameterSearchIndexTest.cc \
     src/qgcunittest/PX4RCCalibrationTest.cc \
+    src/qgcunittest/QGCDecodedTileCacheTest.cc \
+    src/qgcunittest/QGCTileSchedulerTest.cc \
+    src/qgcunittest/QGCTileStoreTest.cc \
+    src/qgcunittest/QGCTraceTest.cc \
+    src/qgcunittest/ReceivePipelineBenchmark.cc \
     src/qgcunittest/TCPLinkTest.cc \
     src/qgcunittest/TCPLoopBackServer.cc \
+    src/qgcunittest/TrajectoryStoreTest.cc \
+    src/qgcunittest/UASMessageHandlerTest.cc \
     src/qgcunittest/UnitTest.cc \
+    src/qgcunittest/VehicleCommandManagerTest.cc \
+    src/qgcunittest/VehiclePropertyFlushTest.cc \
+    src/qgcunittest/VehicleTimeSyncTest.cc \
     src/VehicleSetup/SetupViewTest.cc \
 
 } # DebugBuild|WindowsDebugAndRelease
@@ -523,7 +589,11 @@ HEADERS+= \
     src/FirmwarePlugin/Generic/GenericFirmwarePlugin.h \
     src/FirmwarePlugin/PX4/PX4FirmwarePlugin.h \
     src/Vehicle/MultiVehicleManager.h \
+    src/Vehicle/TrajectoryStore.h \
     src/Vehicle/Vehicle.h \
+    src/Vehicle/VehicleCommandManager.h \
+    src/Vehicle/VehicleSyncScheduler.h \
+    src/Vehicle/VehicleTimeSync.h \
     src/VehicleSetup/SetupView.h \
     src/VehicleSetup/VehicleComponent.h \
 
@@ -562,7 +632,11 @@ SOURCES += \
     src/FirmwarePlugin/Generic/GenericFirmwarePlugin.cc \
     src/FirmwarePlugin/PX4/PX4FirmwarePlugin.cc \
     src/Vehicle/MultiVehicleManager.cc \
+    src/Vehicle/TrajectoryStore.cc \
     src/Vehicle/Vehicle.cc \
+    src/Vehicle/VehicleCommandManager.cc \
+    src/Vehicle/VehicleSyncScheduler.cc \
+    src/Vehicle/VehicleTimeSync.cc \
     src/VehicleSetup/SetupView.cc \
     src/VehicleSetup/VehicleComponent.cc \
 
@@ -586,6 +660,7 @@ HEADERS += \
     src/FactSystem/FactMetaData.h \
     src/FactSystem/FactSystem.h \
     src/FactSystem/FactValidator.h \
+    src/FactSystem/FactValue.h \
     src/FactSystem/ParameterLoader.h \
     src/FactSystem/FactControls/FactPanelController.h \
 
@@ -594,6 +669,7 @@ SOURCES += \
     src/FactSystem/FactMetaData.cc \
     src/FactSystem/FactSystem.cc \
     src/FactSystem/FactValidator.cc \
+    src/FactSystem/FactValue.cc \
     src/FactSystem/ParameterLoader.cc \
     src/FactSystem/FactControls/FactPanelController.cc \
 
@@ -626,6 +702,21 @@ contains (DEFINES, DISABLE_VIDEOSTREAMING) {
     include(src/VideoStreaming/VideoStreaming.pri)
 }
 
+#-------------------------------------------------------------------------------------
+# Hot path tracing
+#
+# Tracing is compiled in by default. It can be removed completely from the build by adding
+# DEFINES+=DISABLE_TRACING to the qmake command line or to user_config.pri.
+
+contains (DEFINES, DISABLE_TRACING) {
+    message("Skipping support for tracing (manual override from command line)")
+    DEFINES -= DISABLE_TRACING
+} else:exists(user_config.pri):infile(user_config.pri, DEFINES, DISABLE_TRACING) {
+    message("Skipping support for tracing (manual override from user_config.pri)")
+} else {
+    DEFINES += QGC_TRACING_ENABLED
+}
+
 #-------------------------------------------------------------------------------------
 # Android
 
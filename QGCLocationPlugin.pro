@@ -3,7 +3,7 @@ include(QGCCommon.pri)
 TEMPLATE     = lib
 TARGET       = QGeoServiceProviderFactoryQGC
 CONFIG      += plugin static
-QT          += location-private positioning-private network
+QT          += location-private positioning-private network sql
 PLUGIN_TYPE  = geoservices
 
 DESTDIR      = $${LOCATION_PLUGIN_DESTDIR}
@@ -17,7 +17,11 @@ HEADERS += \
     src/QtLocationPlugin/qgeomapreplyqgc.h \
     src/QtLocationPlugin/qgeocodingmanagerengineqgc.h \
     src/QtLocationPlugin/qgeocodereplyqgc.h \
-    src/QtLocationPlugin/OpenPilotMaps.h
+    src/QtLocationPlugin/OpenPilotMaps.h \
+    src/QtLocationPlugin/QGCDecodedTileCache.h \
+    src/QtLocationPlugin/QGCTileScheduler.h \
+    src/QtLocationPlugin/QGCTileSeeder.h \
+    src/QtLocationPlugin/QGCTileStore.h
 
 SOURCES += \
     src/QtLocationPlugin/qgeoserviceproviderpluginqgc.cpp \
@@ -26,7 +30,11 @@ SOURCES += \
     src/QtLocationPlugin/qgeomapreplyqgc.cpp \
     src/QtLocationPlugin/qgeocodingmanagerengineqgc.cpp \
     src/QtLocationPlugin/qgeocodereplyqgc.cpp \
-    src/QtLocationPlugin/OpenPilotMaps.cc
+    src/QtLocationPlugin/OpenPilotMaps.cc \
+    src/QtLocationPlugin/QGCDecodedTileCache.cc \
+    src/QtLocationPlugin/QGCTileScheduler.cc \
+    src/QtLocationPlugin/QGCTileSeeder.cc \
+    src/QtLocationPlugin/QGCTileStore.cc
 
 OTHER_FILES += \
     src/QtLocationPlugin/qgc_maps_plugin.json
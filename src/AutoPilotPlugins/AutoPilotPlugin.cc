@@ -111,6 +111,11 @@ void AutoPilotPlugin::refreshAllParameters(void)
 	_getParameterLoader()->refreshAllParameters();
 }
 
+int AutoPilotPlugin::parameterCount(void)
+{
+    return _getParameterLoader()->parameterCount();
+}
+
 void AutoPilotPlugin::refreshParameter(int componentId, const QString& name)
 {
 	_getParameterLoader()->refreshParameter(componentId, name);
@@ -176,3 +181,8 @@ QString AutoPilotPlugin::readParametersFromStream(QTextStream &stream)
 {
 	return _getParameterLoader()->readParametersFromStream(stream);
 }
+
+bool AutoPilotPlugin::parameterWriteInProgress(void)
+{
+    return _getParameterLoader()->bulkWriteInProgress();
+}
@@ -83,6 +83,9 @@ public:
 	
 	/// Returns all parameter names
 	QStringList parameterNames(int componentId);
+    
+    /// Returns the number of parameters across all components
+    int parameterCount(void);
 	
 	/// Returns the specified parameter Fact from the default component
 	/// WARNING: Returns a default Fact if parameter does not exists. If that possibility exists, check for existince first with
@@ -92,9 +95,13 @@ public:
 	/// Writes the parameter facts to the specified stream
 	void writeParametersToStream(QTextStream &stream);
 	
-	/// Reads the parameters from the stream and updates values
+	/// Reads the parameters from the stream and writes changed values to the vehicle as a bulk write. The
+    /// outcome of the writes is signalled by parameterWriteComplete.
     /// @return Errors during load. Empty string for no errors
 	QString readParametersFromStream(QTextStream &stream);
+    
+    /// @return true: A bulk parameter write is in progress
+    bool parameterWriteInProgress(void);
 	
     /// Returns true if the specifed fact exists
     Q_INVOKABLE bool factExists(FactSystem::Provider_t  provider,       ///< fact provider
@@ -127,6 +134,11 @@ signals:
     void missingParametersChanged(bool missingParameters);
 	void setupCompleteChanged(bool setupComplete);
     void parameterListProgress(float value);
+    
+    /// Signalled when a bulk parameter write completes
+    ///     @param accepted Parameters the vehicle now holds at the written value, "componentId:name"
+    ///     @param rejected Parameters the vehicle did not take, one message each
+    void parameterWriteComplete(const QStringList& accepted, const QStringList& rejected);
 	
 protected:
     /// All access to AutoPilotPugin objects is through getInstanceForAutoPilotPlugin
@@ -36,6 +36,8 @@ GenericAutoPilotPlugin::GenericAutoPilotPlugin(Vehicle* vehicle, QObject* parent
     
     connect(_parameterFacts, &GenericParameterFacts::parametersReady, this, &GenericAutoPilotPlugin::_parametersReadySlot);
     connect(_parameterFacts, &GenericParameterFacts::parameterListProgress, this, &GenericAutoPilotPlugin::parameterListProgress);
+    connect(_parameterFacts, &GenericParameterFacts::bulkWriteProgress, this, &GenericAutoPilotPlugin::parameterListProgress);
+    connect(_parameterFacts, &GenericParameterFacts::bulkWriteComplete, this, &GenericAutoPilotPlugin::parameterWriteComplete);
 }
 
 void GenericAutoPilotPlugin::clearStaticData(void)
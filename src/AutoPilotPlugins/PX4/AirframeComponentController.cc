@@ -31,6 +31,7 @@
 #include "AutoPilotPluginManager.h"
 #include "QGCApplication.h"
 #include "QGCMessageBox.h"
+#include "VehicleCommandManager.h"
 
 #include <QVariant>
 #include <QQmlProperty>
@@ -132,13 +133,31 @@ void AirframeComponentController::_waitParamWriteSignal(QVariant value)
 }
 
 void AirframeComponentController::_rebootAfterStackUnwind(void)
-{    
-    _uas->executeCommand(MAV_CMD_PREFLIGHT_REBOOT_SHUTDOWN, 1, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0);
-    qgcApp()->processEvents(QEventLoop::ExcludeUserInputEvents);
-    for (unsigned i = 0; i < 2000; i++) {
-        QGC::SLEEP::usleep(500);
-        qgcApp()->processEvents(QEventLoop::ExcludeUserInputEvents);
+{
+    // The links are kept up until the reboot is acked, or the command times out, so the command makes it out
+    VehicleCommandManager* commandManager = _vehicle->commandManager();
+    connect(commandManager, &VehicleCommandManager::commandResult, this, &AirframeComponentController::_rebootCommandResult);
+    if (!commandManager->sendCommandOnce(0, MAV_CMD_PREFLIGHT_REBOOT_SHUTDOWN, 1.0f)) {
+        qWarning() << "Reboot already pending";
     }
+}
+
+void AirframeComponentController::_rebootCommandResult(int component, int command, int result, bool timedOut)
+{
+    Q_UNUSED(component);
+    
+    if (command != MAV_CMD_PREFLIGHT_REBOOT_SHUTDOWN) {
+        return;
+    }
+    disconnect(_vehicle->commandManager(), &VehicleCommandManager::commandResult, this, &AirframeComponentController::_rebootCommandResult);
+    
+    if (!timedOut && result != MAV_RESULT_ACCEPTED) {
+        qgcApp()->restoreOverrideCursor();
+        QGCMessageBox::warning("Airframe Config", "Vehicle rejected the reboot. Reboot the vehicle for the new airframe to take effect.");
+        return;
+    }
+    
+    // A vehicle which reboots right away may never get its ack out, it is gone either way
     LinkManager::instance()->disconnectAll();
     qgcApp()->restoreOverrideCursor();
 }
@@ -66,6 +66,7 @@ signals:
 private slots:
     void _waitParamWriteSignal(QVariant value);
     void _rebootAfterStackUnwind(void);
+    void _rebootCommandResult(int component, int command, int result, bool timedOut);
     
 private:
     static bool _typesRegistered;
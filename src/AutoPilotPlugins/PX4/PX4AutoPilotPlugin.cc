@@ -81,6 +81,8 @@ PX4AutoPilotPlugin::PX4AutoPilotPlugin(Vehicle* vehicle, QObject* parent) :
     
     connect(_parameterFacts, &PX4ParameterLoader::parametersReady, this, &PX4AutoPilotPlugin::_parametersReadyPreChecks);
     connect(_parameterFacts, &PX4ParameterLoader::parameterListProgress, this, &PX4AutoPilotPlugin::parameterListProgress);
+    connect(_parameterFacts, &PX4ParameterLoader::bulkWriteProgress, this, &PX4AutoPilotPlugin::parameterListProgress);
+    connect(_parameterFacts, &PX4ParameterLoader::bulkWriteComplete, this, &PX4AutoPilotPlugin::parameterWriteComplete);
 
     _airframeFacts = new PX4AirframeLoader(this, _vehicle->uas(), this);
     Q_CHECK_PTR(_airframeFacts);
@@ -44,40 +44,6 @@ PX4ParameterLoader::PX4ParameterLoader(AutoPilotPlugin* autopilot, Vehicle* vehi
     Q_ASSERT(vehicle);
 }
 
-/// Converts a string to a typed QVariant
-///     @param string String to convert
-///     @param type Type for Fact which dictates the QVariant type as well
-///     @param convertOk Returned: true: conversion success, false: conversion failure
-/// @return Returns the correctly type QVariant
-QVariant PX4ParameterLoader::_stringToTypedVariant(const QString& string, FactMetaData::ValueType_t type, bool* convertOk)
-{
-    QVariant var(string);
-
-    int convertTo = QVariant::Int; // keep compiler warning happy
-    switch (type) {
-        case FactMetaData::valueTypeUint8:
-        case FactMetaData::valueTypeUint16:
-        case FactMetaData::valueTypeUint32:
-            convertTo = QVariant::UInt;
-            break;
-        case FactMetaData::valueTypeInt8:
-        case FactMetaData::valueTypeInt16:
-        case FactMetaData::valueTypeInt32:
-            convertTo = QVariant::Int;
-            break;
-        case FactMetaData::valueTypeFloat:
-            convertTo = QMetaType::Float;
-            break;
-        case FactMetaData::valueTypeDouble:
-            convertTo = QVariant::Double;
-            break;
-    }
-    
-    *convertOk = var.convert(convertTo);
-    
-    return var;
-}
-
 /// Load Parameter Fact meta data
 ///
 /// The meta data comes from firmware parameters.xml file.
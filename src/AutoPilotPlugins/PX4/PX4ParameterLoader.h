@@ -68,9 +68,6 @@ private:
     // Overrides from ParameterLoader
     virtual void _addMetaDataToFact(Fact* fact);
 
-    // Class methods
-    static QVariant _stringToTypedVariant(const QString& string, FactMetaData::ValueType_t type, bool* convertOk);
-
     static bool _parameterMetaDataLoaded;   ///< true: parameter meta data already loaded
     static QMap<QString, FactMetaData*> _mapParameterName2FactMetaData; ///< Maps from a parameter name to FactMetaData
 };
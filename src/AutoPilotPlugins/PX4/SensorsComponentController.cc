@@ -27,6 +27,7 @@
 #include "SensorsComponentController.h"
 #include "QGCMAVLink.h"
 #include "QGCMessageBox.h"
+#include "VehicleCommandManager.h"
 
 #include <QVariant>
 #include <QQmlProperty>
@@ -93,6 +94,7 @@ void SensorsComponentController::_startLogCalibration(void)
     _hideAllCalAreas();
     
     connect(_uas, &UASInterface::textMessageReceived, this, &SensorsComponentController::_handleUASTextMessage);
+    connect(_vehicle->commandManager(), &VehicleCommandManager::commandResult, this, &SensorsComponentController::_commandResult);
     
     _cancelButton->setEnabled(false);
 }
@@ -112,6 +114,7 @@ void SensorsComponentController::_startVisualCalibration(void)
 void SensorsComponentController::_stopCalibration(SensorsComponentController::StopCalibrationCode code)
 {
     disconnect(_uas, &UASInterface::textMessageReceived, this, &SensorsComponentController::_handleUASTextMessage);
+    disconnect(_vehicle->commandManager(), &VehicleCommandManager::commandResult, this, &SensorsComponentController::_commandResult);
     
     _compassButton->setEnabled(true);
     _gyroButton->setEnabled(true);
@@ -409,6 +412,24 @@ void SensorsComponentController::_handleUASTextMessage(int uasId, int compId, in
     }
 }
 
+void SensorsComponentController::_commandResult(int component, int command, int result, bool timedOut)
+{
+    Q_UNUSED(component);
+    
+    if (command != MAV_CMD_PREFLIGHT_CALIBRATION || _waitingForCancel) {
+        return;
+    }
+    
+    if (timedOut) {
+        // Progress still comes through the status text, the ack may just have been lost
+        _appendStatusLog("Calibration command was not acknowledged by vehicle");
+    } else if (result != MAV_RESULT_ACCEPTED) {
+        // The vehicle will not send any status text for a calibration it refused to start
+        _appendStatusLog(QString("Calibration rejected by vehicle, result: %1").arg(result));
+        _stopCalibration(StopCalibrationFailed);
+    }
+}
+
 void SensorsComponentController::_refreshParams(void)
 {
     QStringList fastRefreshList;
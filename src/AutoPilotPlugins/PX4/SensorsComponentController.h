@@ -108,6 +108,7 @@ signals:
     
 private slots:
     void _handleUASTextMessage(int uasId, int compId, int severity, QString text);
+    void _commandResult(int component, int command, int result, bool timedOut);
     
 private:
     void _startLogCalibration(void);
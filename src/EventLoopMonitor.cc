@@ -0,0 +1,319 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "EventLoopMonitor.h"
+#include "QGCTrace.h"
+#include "QGCApplication.h"
+
+#include <QEvent>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <QStringList>
+
+QGC_LOGGING_CATEGORY(EventLoopMonitorLog, "EventLoopMonitorLog")
+
+IMPLEMENT_QGC_SINGLETON(EventLoopMonitor, EventLoopMonitor)
+
+const int EventLoopMonitor::_histogramBucketUpperMsecs[EventLoopMonitor::histogramBucketCount - 1] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000 };
+const char* EventLoopMonitor::_logFileName = "EventLoopStalls.log";
+
+QAtomicInt                  EventLoopMonitor::_activityTracking(0);
+QAtomicPointer<const char>  EventLoopMonitor::_activityClassName(NULL);
+QAtomicInt                  EventLoopMonitor::_activityEventType(0);
+
+EventLoopWatchdog::EventLoopWatchdog(EventLoopMonitor* monitor, int probeIntervalMsecs, int stallThresholdMsecs)
+    : _monitor(monitor)
+    , _timer(NULL)
+    , _probeIntervalMsecs(probeIntervalMsecs)
+    , _stallThresholdNsecs((qint64)stallThresholdMsecs * 1000000)
+    , _probeOutstanding(false)
+    , _probeSentNsecs(0)
+{
+
+}
+
+void EventLoopWatchdog::start(void)
+{
+    // The timer is created here so that it belongs to the watchdog thread
+    _timer = new QTimer(this);
+    _timer->setTimerType(Qt::PreciseTimer);
+    connect(_timer, &QTimer::timeout, this, &EventLoopWatchdog::_tick);
+    _timer->start(_probeIntervalMsecs);
+}
+
+void EventLoopWatchdog::stop(void)
+{
+    if (_timer) {
+        _timer->stop();
+    }
+}
+
+void EventLoopWatchdog::_tick(void)
+{
+    qint64 nowNsecs = QGCTrace::nsecsNow();
+    bool sendProbe = false;
+    bool captureActivity = false;
+
+    _probeMutex.lock();
+    if (!_probeOutstanding) {
+        _probeOutstanding = true;
+        _probeSentNsecs = nowNsecs;
+        _capturedActivity.clear();
+        sendProbe = true;
+    } else if (nowNsecs - _probeSentNsecs > _stallThresholdNsecs && _capturedActivity.isEmpty()) {
+        captureActivity = true;
+    }
+    _probeMutex.unlock();
+
+    if (sendProbe) {
+        emit probe(nowNsecs);
+    } else if (captureActivity) {
+        // Capture while the stall is still in progress, once the probe is answered the main thread has moved on
+        QString activity = _monitor->_captureActivity();
+
+        _probeMutex.lock();
+        if (_probeOutstanding) {
+            _capturedActivity = activity;
+        }
+        _probeMutex.unlock();
+    }
+}
+
+QString EventLoopWatchdog::probeAnswered(void)
+{
+    _probeMutex.lock();
+    QString activity = _capturedActivity;
+    _capturedActivity.clear();
+    _probeOutstanding = false;
+    _probeMutex.unlock();
+
+    return activity;
+}
+
+EventLoopMonitor::EventLoopMonitor(QObject* parent)
+    : QObject(parent)
+    , _watchdog(NULL)
+    , _mainThread(thread())
+    , _probeIntervalMsecs(_defaultProbeIntervalMsecs)
+    , _stallThresholdMsecs(_defaultStallThresholdMsecs)
+{
+    _thread.setObjectName("EventLoopMonitor");
+    resetStatistics();
+
+    QString savedFilesLocation = qgcApp()->savedFilesLocation();
+    if (!savedFilesLocation.isEmpty()) {
+        _logFilename = QDir(savedFilesLocation).absoluteFilePath(_logFileName);
+    }
+}
+
+EventLoopMonitor::~EventLoopMonitor()
+{
+    stop();
+}
+
+int EventLoopMonitor::histogramBucketUpperMsecs(int bucket)
+{
+    Q_ASSERT(bucket >= 0 && bucket < histogramBucketCount);
+
+    return bucket < histogramBucketCount - 1 ? _histogramBucketUpperMsecs[bucket] : -1;
+}
+
+void EventLoopMonitor::start(void)
+{
+    if (_watchdog) {
+        return;
+    }
+
+    qCDebug(EventLoopMonitorLog) << "start probeInterval:stallThreshold" << _probeIntervalMsecs << _stallThresholdMsecs;
+
+    _watchdog = new EventLoopWatchdog(this, _probeIntervalMsecs, _stallThresholdMsecs);
+    _watchdog->moveToThread(&_thread);
+    connect(_watchdog, &EventLoopWatchdog::probe, this, &EventLoopMonitor::_probeReceived, Qt::QueuedConnection);
+    connect(&_thread, &QThread::finished, _watchdog, &QObject::deleteLater);
+
+    _activityTracking.store(1);
+    _thread.start();
+    QMetaObject::invokeMethod(_watchdog, "start", Qt::QueuedConnection);
+}
+
+void EventLoopMonitor::stop(void)
+{
+    if (!_watchdog) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(_watchdog, "stop", Qt::BlockingQueuedConnection);
+    _thread.quit();
+    _thread.wait();
+    _watchdog = NULL;
+    _activityTracking.store(0);
+
+    if (_probeCount) {
+        QString summary;
+        QTextStream stream(&summary);
+
+        stream << QDateTime::currentDateTime().toString(Qt::ISODate) << "\tSummary: probes " << _probeCount
+               << " mean " << meanLatencyMsecs() << "ms max " << maxLatencyMsecs() << "ms stalls " << _stallCount << "\n";
+        for (int bucket=0; bucket<histogramBucketCount; bucket++) {
+            int upperMsecs = histogramBucketUpperMsecs(bucket);
+            stream << "\t" << (upperMsecs == -1 ? QString(">%1ms").arg(_histogramBucketUpperMsecs[bucket - 1]) : QString("<=%1ms").arg(upperMsecs))
+                   << "\t" << _histogram[bucket] << "\n";
+        }
+        stream.flush();
+        _writeLog(summary);
+    }
+}
+
+void EventLoopMonitor::resetStatistics(void)
+{
+    for (int bucket=0; bucket<histogramBucketCount; bucket++) {
+        _histogram[bucket] = 0;
+    }
+    _probeCount = 0;
+    _totalLatencyNsecs = 0;
+    _maxLatencyNsecs = 0;
+    _stallCount = 0;
+    _recentStalls.clear();
+
+    emit statisticsChanged();
+}
+
+double EventLoopMonitor::meanLatencyMsecs(void)
+{
+    return _probeCount ? ((double)_totalLatencyNsecs / _probeCount) / 1000000.0 : 0.0;
+}
+
+void EventLoopMonitor::_probeReceived(qint64 sentNsecs)
+{
+    if (!_watchdog) {
+        // Probe was in flight when we stopped
+        return;
+    }
+
+    qint64 latencyNsecs = QGCTrace::nsecsNow() - sentNsecs;
+    QString activity = _watchdog->probeAnswered();
+
+    _probeCount++;
+    _totalLatencyNsecs += latencyNsecs;
+    _maxLatencyNsecs = qMax(_maxLatencyNsecs, latencyNsecs);
+
+    int bucket = 0;
+    while (bucket < histogramBucketCount - 1 && latencyNsecs > (qint64)_histogramBucketUpperMsecs[bucket] * 1000000) {
+        bucket++;
+    }
+    _histogram[bucket]++;
+
+    int latencyMsecs = latencyNsecs / 1000000;
+    if (latencyMsecs > _stallThresholdMsecs) {
+        Stall_t stall;
+
+        stall.time = QDateTime::currentDateTime();
+        stall.durationMsecs = latencyMsecs;
+        stall.activity = activity;
+
+        _stallCount++;
+        _recentStalls.append(stall);
+        if (_recentStalls.count() > _maxRecentStalls) {
+            _recentStalls.removeFirst();
+        }
+
+        qCDebug(EventLoopMonitorLog) << "Stall" << latencyMsecs << "ms" << activity;
+        _writeLog(QString("%1\t%2ms\t%3\n").arg(stall.time.toString(Qt::ISODate)).arg(latencyMsecs).arg(activity.isEmpty() ? QString("unknown") : activity));
+
+        emit stallDetected(latencyMsecs, activity);
+    }
+
+    emit statisticsChanged();
+}
+
+QString EventLoopMonitor::_captureActivity(void)
+{
+    QStringList parts;
+
+    const char* span = QGCTrace::activeSpan(_mainThread);
+    if (span) {
+        parts << QString("span: %1").arg(span);
+    }
+
+    // The class name and event type are read separately so may come from adjacent events. That is good enough
+    // for a diagnostic.
+    const char* className = _activityClassName.loadAcquire();
+    if (className) {
+        parts << QString("event: %1 to %2").arg(_eventTypeName(_activityEventType.load())).arg(className);
+    }
+
+    return parts.join(", ");
+}
+
+void EventLoopMonitor::_enterActivity(const char* className, int eventType, const char** previousClassName, int* previousEventType)
+{
+    *previousClassName = _activityClassName.fetchAndStoreRelease(className);
+    *previousEventType = _activityEventType.fetchAndStoreRelaxed(eventType);
+}
+
+void EventLoopMonitor::_exitActivity(const char* previousClassName, int previousEventType)
+{
+    _activityEventType.store(previousEventType);
+    _activityClassName.storeRelease(previousClassName);
+}
+
+QString EventLoopMonitor::_eventTypeName(int eventType)
+{
+    switch (eventType) {
+        case QEvent::Timer:
+            return QString("Timer");
+        case QEvent::MetaCall:
+            return QString("MetaCall");
+        case QEvent::Paint:
+            return QString("Paint");
+        case QEvent::UpdateRequest:
+            return QString("UpdateRequest");
+        case QEvent::Resize:
+            return QString("Resize");
+        case QEvent::MouseButtonPress:
+            return QString("MouseButtonPress");
+        case QEvent::MouseButtonRelease:
+            return QString("MouseButtonRelease");
+        case QEvent::KeyPress:
+            return QString("KeyPress");
+        case QEvent::DeferredDelete:
+            return QString("DeferredDelete");
+        default:
+            return QString("QEvent(%1)").arg(eventType);
+    }
+}
+
+void EventLoopMonitor::_writeLog(const QString& text)
+{
+    if (_logFilename.isEmpty()) {
+        return;
+    }
+
+    QFile file(_logFilename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qWarning() << "EventLoopMonitor unable to open log file" << _logFilename << file.errorString();
+        return;
+    }
+    file.write(text.toUtf8());
+}
@@ -0,0 +1,189 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef EventLoopMonitor_H
+#define EventLoopMonitor_H
+
+#include "QGCSingleton.h"
+#include "QGCLoggingCategory.h"
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QMutex>
+#include <QDateTime>
+#include <QList>
+#include <QAtomicInt>
+
+Q_DECLARE_LOGGING_CATEGORY(EventLoopMonitorLog)
+
+/// @file
+///     @brief Watchdog which measures how long the main thread event loop takes to dispatch a probe event.
+///             Latencies are kept in a histogram. When the main thread stalls for longer than the stall
+///             threshold the watchdog captures what the main thread is busy with and records the stall.
+
+class EventLoopMonitor;
+
+/// Runs on the monitor thread. Posts probes to the main thread and captures the main thread activity
+/// when a probe is not answered in time.
+class EventLoopWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    EventLoopWatchdog(EventLoopMonitor* monitor, int probeIntervalMsecs, int stallThresholdMsecs);
+
+    /// Called on the main thread when a probe has been dispatched
+    ///     @return Activity captured while the probe was outstanding, empty if none
+    QString probeAnswered(void);
+
+public slots:
+    void start(void);
+    void stop(void);
+
+signals:
+    /// Probe sent to the main thread through a queued connection
+    ///     @param sentNsecs Time the probe was sent in QGCTrace::nsecsNow time base
+    void probe(qint64 sentNsecs);
+
+private slots:
+    void _tick(void);
+
+private:
+    EventLoopMonitor*   _monitor;
+    QTimer*             _timer;
+    int                 _probeIntervalMsecs;
+    qint64              _stallThresholdNsecs;
+
+    QMutex              _probeMutex;        ///< Protects the fields below which are shared with the main thread
+    bool                _probeOutstanding;
+    qint64              _probeSentNsecs;
+    QString             _capturedActivity;
+};
+
+class EventLoopMonitor : public QObject
+{
+    Q_OBJECT
+
+    DECLARE_QGC_SINGLETON(EventLoopMonitor, EventLoopMonitor)
+
+public:
+    /// A single stall of the main thread event loop
+    typedef struct {
+        QDateTime   time;           ///< Time the stall ended
+        int         durationMsecs;  ///< Probe dispatch latency
+        QString     activity;       ///< What the main thread was doing, empty if not captured
+    } Stall_t;
+
+    /// Number of buckets in the latency histogram
+    static const int histogramBucketCount = 12;
+
+    /// @return Upper bound in msecs for the specified histogram bucket, -1 for the last open ended bucket
+    static int histogramBucketUpperMsecs(int bucket);
+
+    /// Starts the watchdog thread
+    void start(void);
+
+    /// Stops the watchdog thread and writes the histogram summary to the log file
+    void stop(void);
+
+    bool running(void) { return _watchdog != NULL; }
+
+    /// Interval in msecs at which probes are posted. Takes effect on next start.
+    int probeIntervalMsecs(void) { return _probeIntervalMsecs; }
+    void setProbeIntervalMsecs(int msecs) { _probeIntervalMsecs = msecs; }
+
+    /// Dispatch latency in msecs above which a probe is recorded as a stall. Takes effect on next start.
+    int stallThresholdMsecs(void) { return _stallThresholdMsecs; }
+    void setStallThresholdMsecs(int msecs) { _stallThresholdMsecs = msecs; }
+
+    /// File which stalls are appended to. Defaults to EventLoopStalls.log in the saved files location, empty
+    /// for no log file.
+    QString logFilename(void) { return _logFilename; }
+    void setLogFilename(const QString& filename) { _logFilename = filename; }
+
+    int     histogramCount(int bucket) { return _histogram[bucket]; }
+    quint32 probeCount(void) { return _probeCount; }
+    double  meanLatencyMsecs(void);
+    int     maxLatencyMsecs(void) { return _maxLatencyNsecs / 1000000; }
+    quint32 stallCount(void) { return _stallCount; }
+
+    /// @return Most recent stalls, oldest first
+    QList<Stall_t> recentStalls(void) { return _recentStalls; }
+
+    void resetStatistics(void);
+
+    /// Called by QGCApplication::notify to track the event being dispatched on the main thread
+    static void _enterActivity(const char* className, int eventType, const char** previousClassName, int* previousEventType);
+    static void _exitActivity(const char* previousClassName, int previousEventType);
+
+    /// @return true: QGCApplication::notify should track the main thread activity
+    static bool _trackingActivity(void) { return _activityTracking.load() != 0; }
+
+    /// Called on the watchdog thread to describe what the main thread is doing
+    QString _captureActivity(void);
+
+signals:
+    /// Signalled on the main thread after a stall has been recorded
+    void stallDetected(int durationMsecs, const QString& activity);
+
+    /// Signalled when the statistics have been updated
+    void statisticsChanged(void);
+
+private slots:
+    void _probeReceived(qint64 sentNsecs);
+
+private:
+    /// All access to EventLoopMonitor is through EventLoopMonitor::instance
+    EventLoopMonitor(QObject* parent = NULL);
+    ~EventLoopMonitor();
+
+    void _writeLog(const QString& text);
+    static QString _eventTypeName(int eventType);
+
+    QThread             _thread;
+    EventLoopWatchdog*  _watchdog;
+    QThread*            _mainThread;
+    int                 _probeIntervalMsecs;
+    int                 _stallThresholdMsecs;
+    QString             _logFilename;
+
+    int             _histogram[histogramBucketCount];
+    quint32         _probeCount;
+    qint64          _totalLatencyNsecs;
+    qint64          _maxLatencyNsecs;
+    quint32         _stallCount;
+    QList<Stall_t>  _recentStalls;
+
+    static QAtomicInt                   _activityTracking;
+    static QAtomicPointer<const char>   _activityClassName;
+    static QAtomicInt                   _activityEventType;
+
+    static const int _histogramBucketUpperMsecs[histogramBucketCount - 1];
+    static const int _maxRecentStalls = 100;
+    static const int _defaultProbeIntervalMsecs = 100;
+    static const int _defaultStallThresholdMsecs = 200;
+    static const char* _logFileName;
+};
+
+#endif
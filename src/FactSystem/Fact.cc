@@ -25,17 +25,18 @@
 ///     @author Don Gagne <don@thegagnes.com>
 
 #include "Fact.h"
+#include "QGCTrace.h"
 
 #include <QtQml>
+#include <QMetaMethod>
 
 Fact::Fact(QObject* parent)
     : QObject(parent)
     , _componentId(-1)
-    , _value(0)
-    , _type(FactMetaData::valueTypeInt32)
+    , _value(FactMetaData::valueTypeInt32)
     , _metaData(NULL)
 {    
-    FactMetaData* metaData = new FactMetaData(_type, this);
+    FactMetaData* metaData = new FactMetaData(type(), this);
     setMetaData(metaData);
 }
 
@@ -43,11 +44,10 @@ Fact::Fact(int componentId, QString name, FactMetaData::ValueType_t type, QObjec
     : QObject(parent)
     , _name(name)
     , _componentId(componentId)
-    , _value(0)
-    , _type(type)
+    , _value(type)
     , _metaData(NULL)
 {
-    FactMetaData* metaData = new FactMetaData(_type, this);
+    FactMetaData* metaData = new FactMetaData(type, this);
     setMetaData(metaData);
 }
 
@@ -62,7 +62,6 @@ const Fact& Fact::operator=(const Fact& other)
     _name           = other._name;
     _componentId    = other._componentId;
     _value          = other._value;
-    _type           = other._type;
     
     if (_metaData && other._metaData) {
         *_metaData = *other._metaData;
@@ -75,14 +74,17 @@ const Fact& Fact::operator=(const Fact& other)
 
 void Fact::forceSetValue(const QVariant& value)
 {
+    QGC_TRACE_SCOPE("fact", "Fact::forceSetValue");
+    
     if (_metaData) {
-        QVariant    typedValue;
+        FactValue   typedValue;
         QString     errorString;
         
         if (_metaData->convertAndValidate(value, true /* convertOnly */, typedValue, errorString)) {
-            _value.setValue(typedValue);
-            emit valueChanged(_value);
-            emit _containerValueChanged(_value);
+            _value = typedValue;
+            QVariant variantValue = _value.toVariant();
+            emit valueChanged(variantValue);
+            emit _containerValueChanged(variantValue);
         }
     } else {
         qWarning() << "Meta data pointer missing";
@@ -91,15 +93,18 @@ void Fact::forceSetValue(const QVariant& value)
 
 void Fact::setValue(const QVariant& value)
 {
+    QGC_TRACE_SCOPE("fact", "Fact::setValue");
+    
     if (_metaData) {
-        QVariant    typedValue;
+        FactValue   typedValue;
         QString     errorString;
         
         if (_metaData->convertAndValidate(value, true /* convertOnly */, typedValue, errorString)) {
             if (typedValue != _value) {
-                _value.setValue(typedValue);
-                emit valueChanged(_value);
-                emit _containerValueChanged(_value);
+                _value = typedValue;
+                QVariant variantValue = _value.toVariant();
+                emit valueChanged(variantValue);
+                emit _containerValueChanged(variantValue);
             }
         }
     } else {
@@ -109,9 +114,46 @@ void Fact::setValue(const QVariant& value)
 
 void Fact::_containerSetValue(const QVariant& value)
 {
+    bool convertOk;
+    
+    FactValue typedValue = FactValue::fromVariant(type(), value, &convertOk);
+    if (convertOk) {
+        _containerSetRawValue(typedValue);
+    } else {
+        qWarning() << "Fact::_containerSetValue convert failed" << _name << value;
+    }
+}
+
+void Fact::_containerSetRawValue(const FactValue& value)
+{
+    QGC_TRACE_SCOPE("fact", "Fact::vehicleUpdate");
+    
+    Q_ASSERT(value.type() == type());
+    
     _value = value;
-    emit valueChanged(_value);
-    emit vehicleUpdated(_value);
+    _emitValueChanged(true /* vehicleUpdate */);
+}
+
+/// Value changes are signalled with a QVariant for QML. Most Facts are not shown while the full parameter set
+/// streams in, so the QVariant is only built when something is listening.
+void Fact::_emitValueChanged(bool vehicleUpdate)
+{
+    static const QMetaMethod valueChangedSignal = QMetaMethod::fromSignal(&Fact::valueChanged);
+    static const QMetaMethod vehicleUpdatedSignal = QMetaMethod::fromSignal(&Fact::vehicleUpdated);
+    
+    bool signalValueChanged = isSignalConnected(valueChangedSignal);
+    bool signalVehicleUpdated = vehicleUpdate && isSignalConnected(vehicleUpdatedSignal);
+    
+    if (signalValueChanged || signalVehicleUpdated) {
+        QVariant variantValue = _value.toVariant();
+        
+        if (signalValueChanged) {
+            emit valueChanged(variantValue);
+        }
+        if (signalVehicleUpdated) {
+            emit vehicleUpdated(variantValue);
+        }
+    }
 }
 
 QString Fact::name(void) const
@@ -126,7 +168,7 @@ int Fact::componentId(void) const
 
 QVariant Fact::value(void) const
 {
-    return _value;
+    return _value.toVariant();
 }
 
 QString Fact::valueString(void) const
@@ -149,7 +191,7 @@ QVariant Fact::defaultValue(void)
 
 FactMetaData::ValueType_t Fact::type(void)
 {
-    return _type;
+    return _value.type();
 }
 
 QString Fact::shortDescription(void)
@@ -234,6 +276,11 @@ QString Fact::group(void)
 
 void Fact::setMetaData(FactMetaData* metaData)
 {
+    if (_metaData && _metaData != metaData && _metaData->parent() == this) {
+        // Loaders replace the meta data created by the constructor with shared meta data, don't hold on to
+        // an unused object per Fact
+        delete _metaData;
+    }
     _metaData = metaData;
 }
 
@@ -241,7 +288,8 @@ bool Fact::valueEqualsDefault(void)
 {
     if (_metaData) {
         if (_metaData->defaultValueAvailable()) {
-            return _metaData->defaultValue() == value();
+            bool convertOk;
+            return FactValue::fromVariant(type(), _metaData->defaultValue(), &convertOk) == _value;
         } else {
             return false;
         }
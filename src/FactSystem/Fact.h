@@ -28,6 +28,7 @@
 #define Fact_H
 
 #include "FactMetaData.h"
+#include "FactValue.h"
 
 #include <QObject>
 #include <QString>
@@ -90,11 +91,17 @@ public:
     /// Sets and sends new value to vehicle even if value is the same
     void forceSetValue(const QVariant& value);
     
-    /// Sets the meta data associated with the Fact.
+    /// Typed value, for use from C++ where the QVariant based value accessor is not needed
+    FactValue rawValue(void) const { return _value; }
+    
+    /// Sets the meta data associated with the Fact. Meta data created by the Fact itself is deleted.
     void setMetaData(FactMetaData* metaData);
     
     void _containerSetValue(const QVariant& value);
     
+    /// Same as _containerSetValue without conversion. The value must be of the Fact type.
+    void _containerSetRawValue(const FactValue& value);
+    
     /// Generally you should not change the name of a fact. But if you know what you are doing, you can.
     void _setName(const QString& name) { _name = name; }
     
@@ -113,11 +120,12 @@ signals:
     void _containerValueChanged(const QVariant& value);
     
 private:
-    QString                     _name;
-    int                         _componentId;
-    QVariant                    _value;
-    FactMetaData::ValueType_t   _type;
-    FactMetaData*               _metaData;
+    void _emitValueChanged(bool vehicleUpdate);
+    
+    QString         _name;
+    int             _componentId;
+    FactValue       _value;         ///< Also holds the Fact type
+    FactMetaData*   _metaData;
 };
 
 #endif
\ No newline at end of file
@@ -27,6 +27,7 @@
 ///     @author Don Gagne <don@thegagnes.com>
 
 #include "FactMetaData.h"
+#include "FactValue.h"
 
 #include <QDebug>
 
@@ -173,56 +174,52 @@ QVariant FactMetaData::_maxForType(void)
 }
 
 bool FactMetaData::convertAndValidate(const QVariant& value, bool convertOnly, QVariant& typedValue, QString& errorString)
+{
+    FactValue factValue;
+    
+    bool ok = convertAndValidate(value, convertOnly, factValue, errorString);
+    typedValue = factValue.toVariant();
+    
+    return ok;
+}
+
+bool FactMetaData::convertAndValidate(const QVariant& value, bool convertOnly, FactValue& typedValue, QString& errorString)
 {
     bool convertOk;
     
     errorString.clear();
     
-    switch (type()) {
-        case FactMetaData::valueTypeInt8:
-        case FactMetaData::valueTypeInt16:
-        case FactMetaData::valueTypeInt32:
-            typedValue = QVariant(value.toInt(&convertOk));
-            if (!convertOnly && convertOk) {
-                if (min() > typedValue || typedValue > max()) {
+    typedValue = FactValue::fromVariant(type(), value, &convertOk);
+    if (!convertOk) {
+        errorString = "Invalid number";
+        return false;
+    }
+    
+    if (!convertOnly) {
+        // All value types are exactly representable as double
+        double typedDouble = typedValue.toDouble();
+        
+        if (typedDouble < _min.toDouble() || typedDouble > _max.toDouble()) {
+            switch (type()) {
+                case FactMetaData::valueTypeInt8:
+                case FactMetaData::valueTypeInt16:
+                case FactMetaData::valueTypeInt32:
                     errorString = QString("Value must be within %1 and %2").arg(min().toInt()).arg(max().toInt());
-                }
-            }
-            break;
-            
-        case FactMetaData::valueTypeUint8:
-        case FactMetaData::valueTypeUint16:
-        case FactMetaData::valueTypeUint32:
-            typedValue = QVariant(value.toUInt(&convertOk));
-            if (!convertOnly && convertOk) {
-                if (min() > typedValue || typedValue > max()) {
+                    break;
+                case FactMetaData::valueTypeUint8:
+                case FactMetaData::valueTypeUint16:
+                case FactMetaData::valueTypeUint32:
                     errorString = QString("Value must be within %1 and %2").arg(min().toUInt()).arg(max().toUInt());
-                }
-            }
-            break;
-            
-        case FactMetaData::valueTypeFloat:
-            typedValue = QVariant(value.toFloat(&convertOk));
-            if (!convertOnly && convertOk) {
-                if (min() > typedValue || typedValue > max()) {
+                    break;
+                case FactMetaData::valueTypeFloat:
                     errorString = QString("Value must be within %1 and %2").arg(min().toFloat()).arg(max().toFloat());
-                }
-            }
-            break;
-            
-        case FactMetaData::valueTypeDouble:
-            typedValue = QVariant(value.toDouble(&convertOk));
-            if (!convertOnly && convertOk) {
-                if (min() > typedValue || typedValue > max()) {
+                    break;
+                case FactMetaData::valueTypeDouble:
                     errorString = QString("Value must be within %1 and %2").arg(min().toDouble()).arg(max().toDouble());
-                }
+                    break;
             }
-            break;
-    }
-    
-    if (!convertOk) {
-        errorString = "Invalid number";
+        }
     }
     
-    return convertOk && errorString.isEmpty();
+    return errorString.isEmpty();
 }
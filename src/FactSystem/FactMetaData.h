@@ -31,6 +31,8 @@
 #include <QString>
 #include <QVariant>
 
+class FactValue;
+
 /// Holds the meta data associated with a Fact.
 ///
 /// Holds the meta data associated with a Fact. This is kept in a seperate object from the Fact itself
@@ -89,6 +91,9 @@ public:
     ///     @param errorString Error string if convert fails
     /// @returns false: Convert failed, errorString set
     bool convertAndValidate(const QVariant& value, bool convertOnly, QVariant& typedValue, QString& errorString);
+    
+    /// Same as above, converting to a FactValue without an intermediate QVariant
+    bool convertAndValidate(const QVariant& value, bool convertOnly, FactValue& typedValue, QString& errorString);
 
 private:
     QVariant _minForType(void);
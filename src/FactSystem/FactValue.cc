@@ -0,0 +1,326 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "FactValue.h"
+
+#include <string.h>
+
+/// Same layout as mavlink_param_union_t without the type field
+typedef union {
+    float   param_float;
+    qint32  param_int32;
+    quint32 param_uint32;
+    qint16  param_int16;
+    quint16 param_uint16;
+    qint8   param_int8;
+    quint8  param_uint8;
+} ParamUnion_t;
+
+FactValue::FactValue(void)
+    : _int(0)
+    , _type(FactMetaData::valueTypeInt32)
+{
+    _doubleBits[1] = 0;
+}
+
+FactValue::FactValue(FactMetaData::ValueType_t type)
+    : _int(0)
+    , _type(type)
+{
+    _doubleBits[1] = 0;
+    if (type == FactMetaData::valueTypeFloat) {
+        _float = 0;
+    } else if (type == FactMetaData::valueTypeDouble) {
+        _setDouble(0);
+    }
+}
+
+FactValue FactValue::fromInteger(FactMetaData::ValueType_t type, qint64 value)
+{
+    FactValue factValue(type);
+    
+    switch (type) {
+        case FactMetaData::valueTypeUint8:
+            factValue._uint = (quint8)value;
+            break;
+        case FactMetaData::valueTypeInt8:
+            factValue._int = (qint8)value;
+            break;
+        case FactMetaData::valueTypeUint16:
+            factValue._uint = (quint16)value;
+            break;
+        case FactMetaData::valueTypeInt16:
+            factValue._int = (qint16)value;
+            break;
+        case FactMetaData::valueTypeUint32:
+            factValue._uint = (quint32)value;
+            break;
+        case FactMetaData::valueTypeInt32:
+            factValue._int = (qint32)value;
+            break;
+        case FactMetaData::valueTypeFloat:
+            factValue._float = (float)value;
+            break;
+        case FactMetaData::valueTypeDouble:
+            factValue._setDouble((double)value);
+            break;
+    }
+    
+    return factValue;
+}
+
+FactValue FactValue::fromDouble(FactMetaData::ValueType_t type, double value)
+{
+    switch (type) {
+        case FactMetaData::valueTypeFloat:
+        {
+            FactValue factValue(type);
+            factValue._float = (float)value;
+            return factValue;
+        }
+        case FactMetaData::valueTypeDouble:
+        {
+            FactValue factValue(type);
+            factValue._setDouble(value);
+            return factValue;
+        }
+        default:
+            return fromInteger(type, (qint64)value);
+    }
+}
+
+FactValue FactValue::fromString(FactMetaData::ValueType_t type, const QString& string, bool* ok)
+{
+    FactValue factValue(type);
+    
+    switch (type) {
+        case FactMetaData::valueTypeInt8:
+        case FactMetaData::valueTypeInt16:
+        case FactMetaData::valueTypeInt32:
+            factValue._int = string.toInt(ok);
+            break;
+        case FactMetaData::valueTypeUint8:
+        case FactMetaData::valueTypeUint16:
+        case FactMetaData::valueTypeUint32:
+            factValue._uint = string.toUInt(ok);
+            break;
+        case FactMetaData::valueTypeFloat:
+            factValue._float = string.toFloat(ok);
+            break;
+        case FactMetaData::valueTypeDouble:
+            factValue._setDouble(string.toDouble(ok));
+            break;
+    }
+    
+    if (!*ok) {
+        factValue = FactValue(type);
+    }
+    
+    return factValue;
+}
+
+FactValue FactValue::fromVariant(FactMetaData::ValueType_t type, const QVariant& variant, bool* ok)
+{
+    if (variant.type() == QVariant::String) {
+        return fromString(type, variant.toString(), ok);
+    }
+    
+    FactValue factValue(type);
+    
+    switch (type) {
+        case FactMetaData::valueTypeInt8:
+        case FactMetaData::valueTypeInt16:
+        case FactMetaData::valueTypeInt32:
+            factValue._int = variant.toInt(ok);
+            break;
+        case FactMetaData::valueTypeUint8:
+        case FactMetaData::valueTypeUint16:
+        case FactMetaData::valueTypeUint32:
+            factValue._uint = variant.toUInt(ok);
+            break;
+        case FactMetaData::valueTypeFloat:
+            factValue._float = variant.toFloat(ok);
+            break;
+        case FactMetaData::valueTypeDouble:
+            factValue._setDouble(variant.toDouble(ok));
+            break;
+    }
+    
+    if (!*ok) {
+        factValue = FactValue(type);
+    }
+    
+    return factValue;
+}
+
+FactValue FactValue::fromParamBits(FactMetaData::ValueType_t type, quint32 bits)
+{
+    FactValue       factValue(type);
+    ParamUnion_t    paramUnion;
+    
+    paramUnion.param_uint32 = bits;
+    
+    switch (type) {
+        case FactMetaData::valueTypeUint8:
+            factValue._uint = paramUnion.param_uint8;
+            break;
+        case FactMetaData::valueTypeInt8:
+            factValue._int = paramUnion.param_int8;
+            break;
+        case FactMetaData::valueTypeUint16:
+            factValue._uint = paramUnion.param_uint16;
+            break;
+        case FactMetaData::valueTypeInt16:
+            factValue._int = paramUnion.param_int16;
+            break;
+        case FactMetaData::valueTypeUint32:
+            factValue._uint = paramUnion.param_uint32;
+            break;
+        case FactMetaData::valueTypeInt32:
+            factValue._int = paramUnion.param_int32;
+            break;
+        case FactMetaData::valueTypeFloat:
+            factValue._float = paramUnion.param_float;
+            break;
+        case FactMetaData::valueTypeDouble:
+            factValue._setDouble(paramUnion.param_float);
+            break;
+    }
+    
+    return factValue;
+}
+
+quint32 FactValue::paramBits(void) const
+{
+    ParamUnion_t paramUnion;
+    
+    // Unused bytes of the smaller types go out as 0
+    paramUnion.param_uint32 = 0;
+    
+    switch (type()) {
+        case FactMetaData::valueTypeUint8:
+            paramUnion.param_uint8 = (quint8)_uint;
+            break;
+        case FactMetaData::valueTypeInt8:
+            paramUnion.param_int8 = (qint8)_int;
+            break;
+        case FactMetaData::valueTypeUint16:
+            paramUnion.param_uint16 = (quint16)_uint;
+            break;
+        case FactMetaData::valueTypeInt16:
+            paramUnion.param_int16 = (qint16)_int;
+            break;
+        case FactMetaData::valueTypeUint32:
+            paramUnion.param_uint32 = _uint;
+            break;
+        case FactMetaData::valueTypeInt32:
+            paramUnion.param_int32 = _int;
+            break;
+        case FactMetaData::valueTypeFloat:
+            paramUnion.param_float = _float;
+            break;
+        case FactMetaData::valueTypeDouble:
+            paramUnion.param_float = (float)_double();
+            break;
+    }
+    
+    return paramUnion.param_uint32;
+}
+
+double FactValue::toDouble(void) const
+{
+    switch (type()) {
+        case FactMetaData::valueTypeInt8:
+        case FactMetaData::valueTypeInt16:
+        case FactMetaData::valueTypeInt32:
+            return _int;
+        case FactMetaData::valueTypeUint8:
+        case FactMetaData::valueTypeUint16:
+        case FactMetaData::valueTypeUint32:
+            return _uint;
+        case FactMetaData::valueTypeFloat:
+            return _float;
+        case FactMetaData::valueTypeDouble:
+            return _double();
+    }
+    
+    // Make windows compiler happy, even switch is full cased
+    return 0;
+}
+
+QVariant FactValue::toVariant(void) const
+{
+    switch (type()) {
+        case FactMetaData::valueTypeInt8:
+        case FactMetaData::valueTypeInt16:
+        case FactMetaData::valueTypeInt32:
+            return QVariant(_int);
+        case FactMetaData::valueTypeUint8:
+        case FactMetaData::valueTypeUint16:
+        case FactMetaData::valueTypeUint32:
+            return QVariant(_uint);
+        case FactMetaData::valueTypeFloat:
+            return QVariant(_float);
+        case FactMetaData::valueTypeDouble:
+            return QVariant(_double());
+    }
+    
+    // Make windows compiler happy, even switch is full cased
+    return QVariant();
+}
+
+/// Formatting is left to QVariant so strings match what QML shows and what parameter files have always held
+QString FactValue::toString(void) const
+{
+    return toVariant().toString();
+}
+
+bool FactValue::operator==(const FactValue& other) const
+{
+    if (_type != other._type) {
+        return false;
+    }
+    
+    switch (type()) {
+        case FactMetaData::valueTypeFloat:
+            return _float == other._float;
+        case FactMetaData::valueTypeDouble:
+            return _double() == other._double();
+        default:
+            return _uint == other._uint;
+    }
+}
+
+double FactValue::_double(void) const
+{
+    double value;
+    
+    memcpy(&value, _doubleBits, sizeof(value));
+    
+    return value;
+}
+
+void FactValue::_setDouble(double value)
+{
+    memcpy(_doubleBits, &value, sizeof(value));
+}
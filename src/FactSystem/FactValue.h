@@ -0,0 +1,90 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef FactValue_H
+#define FactValue_H
+
+#include "FactMetaData.h"
+
+#include <QString>
+#include <QVariant>
+
+/// @file
+///     @brief Typed value of a Fact. A tagged union over the parameter value types which needs no allocation
+///             and no QVariant type switching to store, compare or put on the wire. Conversion to QVariant
+///             only happens at the QML property boundary.
+
+class FactValue
+{
+public:
+    /// Constructs a Int32 value of 0
+    FactValue(void);
+    
+    /// Constructs a value of 0 of the specified type
+    explicit FactValue(FactMetaData::ValueType_t type);
+    
+    /// @return Integer value converted to the specified type the same way a C cast would
+    static FactValue fromInteger(FactMetaData::ValueType_t type, qint64 value);
+    
+    /// @return Floating point value converted to the specified type the same way a C cast would
+    static FactValue fromDouble(FactMetaData::ValueType_t type, double value);
+    
+    /// Converts a string without going through QVariant
+    ///     @param ok Returned: false: string is not a valid value of the type, value is 0
+    static FactValue fromString(FactMetaData::ValueType_t type, const QString& string, bool* ok);
+    
+    /// Converts a QVariant from QML or other callers of the QVariant based Fact api
+    ///     @param ok Returned: false: variant can not be converted to the type, value is 0
+    static FactValue fromVariant(FactMetaData::ValueType_t type, const QVariant& variant, bool* ok);
+    
+    /// Decodes the param_value field of PARAM_VALUE, laid out as mavlink_param_union_t
+    static FactValue fromParamBits(FactMetaData::ValueType_t type, quint32 bits);
+    
+    FactMetaData::ValueType_t type(void) const { return (FactMetaData::ValueType_t)_type; }
+    
+    /// @return Value encoded for the param_value field of PARAM_SET, laid out as mavlink_param_union_t. Double
+    ///         values do not fit and are sent as float.
+    quint32 paramBits(void) const;
+    
+    double  toDouble(void) const;
+    QVariant toVariant(void) const;
+    QString toString(void) const;
+    
+    /// Values are only equal if their types are equal as well
+    bool operator==(const FactValue& other) const;
+    bool operator!=(const FactValue& other) const { return !(*this == other); }
+    
+private:
+    double _double(void) const;
+    void _setDouble(double value);
+    
+    union {
+        qint32  _int;           ///< Int8, Int16, Int32
+        quint32 _uint;          ///< Uint8, Uint16, Uint32
+        float   _float;
+        quint32 _doubleBits[2]; ///< Double, kept as two words so the value stays 4 byte aligned
+    };
+    quint8 _type;               ///< FactMetaData::ValueType_t
+};
+
+#endif
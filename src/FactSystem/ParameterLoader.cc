@@ -48,7 +48,9 @@ ParameterLoader::ParameterLoader(AutoPilotPlugin* autopilot, Vehicle* vehicle, Q
     _parametersReady(false),
     _initialLoadComplete(false),
     _defaultComponentId(FactSystem::defaultComponentId),
-    _totalParamCount(0)
+    _totalParamCount(0),
+    _bulkWriteSentCount(0),
+    _bulkWriteDoneCount(0)
 {
     Q_ASSERT(_autopilot);
     Q_ASSERT(_vehicle);
@@ -61,11 +63,15 @@ ParameterLoader::ParameterLoader(AutoPilotPlugin* autopilot, Vehicle* vehicle, Q
     _waitingParamTimeoutTimer.setInterval(1000);
     connect(&_waitingParamTimeoutTimer, &QTimer::timeout, this, &ParameterLoader::_waitingParamTimeout);
     
+    _bulkWriteTimer.setSingleShot(true);
+    _bulkWriteTimer.setInterval(_bulkWriteAckTimeoutMsecs);
+    connect(&_bulkWriteTimer, &QTimer::timeout, this, &ParameterLoader::_bulkWriteTimeout);
+    
     // FIXME: Why not direct connect?
-    connect(_vehicle->uas(), SIGNAL(parameterUpdate(int, int, QString, int, int, int, QVariant)), this, SLOT(_parameterUpdate(int, int, QString, int, int, int, QVariant)));
+    connect(_vehicle->uas(), SIGNAL(parameterUpdate(int, int, QString, int, int, int, quint32)), this, SLOT(_parameterUpdate(int, int, QString, int, int, int, quint32)));
     
-    // Request full param list
-    refreshAllParameters();
+    // The full param list is requested by Vehicle::startInitialSync once the VehicleSyncScheduler gives the
+    // vehicle a slot
 }
 
 ParameterLoader::~ParameterLoader()
@@ -74,7 +80,7 @@ ParameterLoader::~ParameterLoader()
 }
 
 /// Called whenever a parameter is updated or first seen.
-void ParameterLoader::_parameterUpdate(int uasId, int componentId, QString parameterName, int parameterCount, int parameterId, int mavType, QVariant value)
+void ParameterLoader::_parameterUpdate(int uasId, int componentId, QString parameterName, int parameterCount, int parameterId, int mavType, quint32 paramBits)
 {
     bool setMetaData = false;
     
@@ -89,7 +95,6 @@ void ParameterLoader::_parameterUpdate(int uasId, int componentId, QString param
                                     "count:" << parameterCount <<
                                     "index:" << parameterId <<
                                     "mavType:" << mavType <<
-                                    "value:" << value <<
                                     ")";
     
 #if 0
@@ -171,11 +176,13 @@ void ParameterLoader::_parameterUpdate(int uasId, int componentId, QString param
         _waitingParamTimeoutTimer.stop();
     }
 
-    // Update progress bar
-    if (waitingParamCount == 0) {
-        emit parameterListProgress(0);
-    } else {
-        emit parameterListProgress((float)(_totalParamCount - waitingParamCount) / (float)_totalParamCount);
+    // Update progress bar, a bulk write reports its own progress
+    if (!bulkWriteInProgress()) {
+        if (waitingParamCount == 0) {
+            emit parameterListProgress(0);
+        } else {
+            emit parameterListProgress((float)(_totalParamCount - waitingParamCount) / (float)_totalParamCount);
+        }
     }
     
     // Attempt to determine default component id
@@ -186,7 +193,7 @@ void ParameterLoader::_parameterUpdate(int uasId, int componentId, QString param
         _defaultComponentId = componentId;
     }
     
-    if (!_mapParameterName2Variant.contains(componentId) || !_mapParameterName2Variant[componentId].contains(parameterName)) {
+    if (!_mapParameterName2Fact.contains(componentId) || !_mapParameterName2Fact[componentId].contains(parameterName)) {
         qCDebug(ParameterLoaderLog) << "Adding new fact";
         
         FactMetaData::ValueType_t factType;
@@ -224,17 +231,19 @@ void ParameterLoader::_parameterUpdate(int uasId, int componentId, QString param
         Fact* fact = new Fact(componentId, parameterName, factType, this);
         setMetaData = true;
         
-        _mapParameterName2Variant[componentId][parameterName] = QVariant::fromValue(fact);
+        _mapParameterName2Fact[componentId][parameterName] = fact;
         
         // We need to know when the fact changes from QML so that we can send the new value to the parameter manager
         connect(fact, &Fact::_containerValueChanged, this, &ParameterLoader::_valueUpdated);
     }
     
-    Q_ASSERT(_mapParameterName2Variant[componentId].contains(parameterName));
+    Q_ASSERT(_mapParameterName2Fact[componentId].contains(parameterName));
     
-    Fact* fact = _mapParameterName2Variant[componentId][parameterName].value<Fact*>();
+    Fact* fact = _mapParameterName2Fact[componentId][parameterName];
     Q_ASSERT(fact);
-    fact->_containerSetValue(value);
+    FactValue value = FactValue::fromParamBits(fact->type(), paramBits);
+    fact->_containerSetRawValue(value);
+    qCDebug(ParameterLoaderVerboseLog) << "_parameterUpdate value" << parameterName << value.toString();
     
     if (setMetaData) {
         _addMetaDataToFact(fact);
@@ -242,25 +251,37 @@ void ParameterLoader::_parameterUpdate(int uasId, int componentId, QString param
     
     _dataMutex.unlock();
     
-    if (waitingParamCount == 0) {
-        // Now that we know vehicle is up to date persist
+    if (waitingParamCount == 0 && !bulkWriteInProgress()) {
+        // Now that we know vehicle is up to date persist. A bulk write persists once when it completes.
         _saveToEEPROM();
     }
     
+    _bulkWriteAck(componentId, parameterName, value);
+    
     _checkInitialLoadComplete();
 }
 
 /// Connected to Fact::valueUpdated
 ///
 /// Writes the parameter to mavlink, sets up for write wait
-void ParameterLoader::_valueUpdated(const QVariant& value)
+void ParameterLoader::_valueUpdated(const QVariant& variantValue)
 {
+    Q_UNUSED(variantValue);
+    
     Fact* fact = qobject_cast<Fact*>(sender());
     Q_ASSERT(fact);
     
+    FactValue value = fact->rawValue();
+    
     int componentId = fact->componentId();
     QString name = fact->name();
     
+    if (bulkWriteInProgress()) {
+        // Keep the vehicle link to a single write window
+        bulkWrite(fact, value);
+        return;
+    }
+    
     _dataMutex.lock();
     
     Q_ASSERT(_waitingWriteParamNameMap.contains(componentId));
@@ -271,7 +292,7 @@ void ParameterLoader::_valueUpdated(const QVariant& value)
     _dataMutex.unlock();
     
     _writeParameterRaw(componentId, fact->name(), value);
-    qCDebug(ParameterLoaderLog) << "Set parameter (componentId:" << componentId << "name:" << name << value << ")";
+    qCDebug(ParameterLoaderLog) << "Set parameter (componentId:" << componentId << "name:" << name << value.toString() << ")";
 }
 
 void ParameterLoader::_addMetaDataToFact(Fact* fact)
@@ -313,8 +334,8 @@ void ParameterLoader::_determineDefaultComponentId(void)
         // the set of parameters. Better than nothing!
         
         _defaultComponentId = -1;
-        foreach(int componentId, _mapParameterName2Variant.keys()) {
-            if (_mapParameterName2Variant[componentId].count() > _defaultComponentId) {
+        foreach(int componentId, _mapParameterName2Fact.keys()) {
+            if (_mapParameterName2Fact[componentId].count() > _defaultComponentId) {
                 _defaultComponentId = componentId;
             }
         }
@@ -358,7 +379,7 @@ void ParameterLoader::refreshParametersPrefix(int componentId, const QString& na
     componentId = _actualComponentId(componentId);
     qCDebug(ParameterLoaderLog) << "refreshParametersPrefix (component id:" << componentId << "name:" << namePrefix << ")";
 
-    foreach(QString name, _mapParameterName2Variant[componentId].keys()) {
+    foreach(QString name, _mapParameterName2Fact[componentId].keys()) {
         if (name.startsWith(namePrefix)) {
             refreshParameter(componentId, name);
         }
@@ -370,8 +391,8 @@ bool ParameterLoader::parameterExists(int componentId, const QString&  name)
     bool ret = false;
     
     componentId = _actualComponentId(componentId);
-    if (_mapParameterName2Variant.contains(componentId)) {
-        ret = _mapParameterName2Variant[componentId].contains(name);
+    if (_mapParameterName2Fact.contains(componentId)) {
+        ret = _mapParameterName2Fact[componentId].contains(name);
     }
 
     return ret;
@@ -381,19 +402,19 @@ Fact* ParameterLoader::getFact(int componentId, const QString& name)
 {
     componentId = _actualComponentId(componentId);
     
-    if (!_mapParameterName2Variant.contains(componentId) || !_mapParameterName2Variant[componentId].contains(name)) {
+    if (!_mapParameterName2Fact.contains(componentId) || !_mapParameterName2Fact[componentId].contains(name)) {
         qgcApp()->reportMissingParameter(componentId, name);
         return &_defaultFact;
     }
     
-    return _mapParameterName2Variant[componentId][name].value<Fact*>();
+    return _mapParameterName2Fact[componentId][name];
 }
 
 QStringList ParameterLoader::parameterNames(int componentId)
 {
 	QStringList names;
 	
-	foreach(QString paramName, _mapParameterName2Variant[_actualComponentId(componentId)].keys()) {
+	foreach(QString paramName, _mapParameterName2Fact[_actualComponentId(componentId)].keys()) {
 		names << paramName;
 	}
 	
@@ -402,9 +423,9 @@ QStringList ParameterLoader::parameterNames(int componentId)
 
 void ParameterLoader::_setupGroupMap(void)
 {
-    foreach (int componentId, _mapParameterName2Variant.keys()) {
-        foreach (QString name, _mapParameterName2Variant[componentId].keys()) {
-            Fact* fact = _mapParameterName2Variant[componentId][name].value<Fact*>();
+    foreach (int componentId, _mapParameterName2Fact.keys()) {
+        foreach (QString name, _mapParameterName2Fact[componentId].keys()) {
+            Fact* fact = _mapParameterName2Fact[componentId][name];
             _mapGroup2ParameterName[componentId][fact->group()] += name;
         }
     }
@@ -452,7 +473,7 @@ void ParameterLoader::_waitingParamTimeout(void)
             foreach(QString paramName, _waitingWriteParamNameMap[componentId].keys()) {
                 paramsRequested = true;
                 _waitingWriteParamNameMap[componentId][paramName]++;   // Bump retry count
-                _writeParameterRaw(componentId, paramName, _autopilot->getFact(FactSystem::ParameterProvider, componentId, paramName)->value());
+                _writeParameterRaw(componentId, paramName, _autopilot->getFact(FactSystem::ParameterProvider, componentId, paramName)->rawValue());
                 qCDebug(ParameterLoaderLog) << "Write resend for (componentId:" << componentId << "paramName:" << paramName << "retryCount:" << _waitingWriteParamNameMap[componentId][paramName] << ")";
                 
                 if (++batchCount > maxBatchSize) {
@@ -499,47 +520,13 @@ void ParameterLoader::_readParameterRaw(int componentId, const QString& paramNam
     _vehicle->sendMessage(msg);
 }
 
-void ParameterLoader::_writeParameterRaw(int componentId, const QString& paramName, const QVariant& value)
+void ParameterLoader::_writeParameterRaw(int componentId, const QString& paramName, const FactValue& value)
 {
     mavlink_param_set_t     p;
     mavlink_param_union_t   union_value;
     
-    FactMetaData::ValueType_t factType = _autopilot->getFact(FactSystem::ParameterProvider, componentId, paramName)->type();
-    p.param_type = _factTypeToMavType(factType);
-    
-    switch (factType) {
-        case FactMetaData::valueTypeUint8:
-            union_value.param_uint8 = (uint8_t)value.toUInt();
-            break;
-            
-        case FactMetaData::valueTypeInt8:
-            union_value.param_int8 = (int8_t)value.toInt();
-            break;
-            
-        case FactMetaData::valueTypeUint16:
-            union_value.param_uint16 = (uint16_t)value.toUInt();
-            break;
-            
-        case FactMetaData::valueTypeInt16:
-            union_value.param_int16 = (int16_t)value.toInt();
-            break;
-            
-        case FactMetaData::valueTypeUint32:
-            union_value.param_uint32 = (uint32_t)value.toUInt();
-            break;
-            
-        case FactMetaData::valueTypeFloat:
-            union_value.param_float = value.toFloat();
-            break;
-            
-        default:
-            qCritical() << "Unsupported fact type" << factType;
-            // fall through
-            
-        case FactMetaData::valueTypeInt32:
-            union_value.param_int32 = (int32_t)value.toInt();
-            break;
-    }
+    p.param_type = _factTypeToMavType(value.type());
+    union_value.param_uint32 = value.paramBits();
     
     p.param_value = union_value.param_float;
     p.target_system = (uint8_t)_vehicle->id();
@@ -609,8 +596,24 @@ QString ParameterLoader::readParametersFromStream(QTextStream& stream)
                     continue;
                 }
                 
+                bool        convertOk;
+                FactValue   typedValue = FactValue::fromString(fact->type(), valStr, &convertOk);
+                
+                if (!convertOk) {
+                    QString error;
+                    error = QString("Skipped parameter %1:%2 - invalid value %3\n").arg(componentId).arg(paramName).arg(valStr);
+                    errors += error;
+                    qCDebug(ParameterLoaderLog) << error;
+                    continue;
+                }
+                
+                if (typedValue == fact->rawValue()) {
+                    // Vehicle already has this value
+                    continue;
+                }
+                
                 qCDebug(ParameterLoaderLog) << "Updating parameter" << componentId << paramName << valStr;
-                fact->setValue(valStr);
+                bulkWrite(fact, typedValue);
             }
         }
     }
@@ -618,15 +621,178 @@ QString ParameterLoader::readParametersFromStream(QTextStream& stream)
     return errors;
 }
 
+void ParameterLoader::bulkWrite(Fact* fact, const FactValue& value)
+{
+    int componentId = fact->componentId();
+    QString name = fact->name();
+    
+    if (!bulkWriteInProgress()) {
+        qCDebug(ParameterLoaderLog) << "Starting bulk write";
+        _bulkWriteSentCount = 0;
+        _bulkWriteDoneCount = 0;
+    }
+    
+    if (_bulkWriteIndexMap[componentId].contains(name)) {
+        // Coalesce with the earlier write, only the latest value is sent
+        BulkWrite_t& write = _bulkWrites[_bulkWriteIndexMap[componentId][name]];
+        
+        switch (write.state) {
+            case bulkWriteQueued:
+                break;
+            case bulkWriteSent:
+                // The ack for the previous value will not match so the write is resent with the new value
+                _bulkWriteSentCount--;
+                _bulkWriteQueue.append(_bulkWriteIndexMap[componentId][name]);
+                break;
+            case bulkWriteAccepted:
+            case bulkWriteRejected:
+                _bulkWriteDoneCount--;
+                _bulkWriteQueue.append(_bulkWriteIndexMap[componentId][name]);
+                break;
+        }
+        
+        write.value = value;
+        write.vehicleValueValid = false;
+        write.retryCount = 0;
+        write.state = bulkWriteQueued;
+    } else {
+        BulkWrite_t write;
+        
+        write.componentId = componentId;
+        write.name = name;
+        write.value = value;
+        write.retryCount = 0;
+        write.state = bulkWriteQueued;
+        
+        _bulkWriteIndexMap[componentId][name] = _bulkWrites.count();
+        _bulkWriteQueue.append(_bulkWrites.count());
+        _bulkWrites.append(write);
+    }
+    
+    _fillBulkWriteWindow();
+}
+
+/// Sends queued writes until the window is full
+void ParameterLoader::_fillBulkWriteWindow(void)
+{
+    while (_bulkWriteSentCount < _bulkWriteWindowSize && !_bulkWriteQueue.isEmpty()) {
+        BulkWrite_t& write = _bulkWrites[_bulkWriteQueue.takeFirst()];
+        
+        write.state = bulkWriteSent;
+        write.vehicleValueValid = false;
+        _bulkWriteSentCount++;
+        
+        _writeParameterRaw(write.componentId, write.name, write.value);
+        qCDebug(ParameterLoaderVerboseLog) << "Bulk write sent (componentId:" << write.componentId << "name:" << write.name << write.value.toString() << ")";
+        
+        if (!_bulkWriteTimer.isActive()) {
+            _bulkWriteTimer.start();
+        }
+    }
+}
+
+/// Called for every PARAM_VALUE. An echo of the written value acks the write. Other values may be stale
+/// updates sent before the write arrived, those are left to the ack timeout.
+void ParameterLoader::_bulkWriteAck(int componentId, const QString& name, const FactValue& value)
+{
+    if (!_bulkWriteIndexMap.contains(componentId) || !_bulkWriteIndexMap[componentId].contains(name)) {
+        return;
+    }
+    
+    BulkWrite_t& write = _bulkWrites[_bulkWriteIndexMap[componentId][name]];
+    if (write.state != bulkWriteSent) {
+        return;
+    }
+    
+    write.vehicleValue = value;
+    write.vehicleValueValid = true;
+    if (value == write.value) {
+        _bulkWriteDone(write, bulkWriteAccepted);
+        
+        // Progress is being made, give the remaining outstanding writes a full timeout
+        _bulkWriteTimer.start();
+        _fillBulkWriteWindow();
+    }
+}
+
+void ParameterLoader::_bulkWriteTimeout(void)
+{
+    for (int i=0; i<_bulkWrites.count(); i++) {
+        BulkWrite_t& write = _bulkWrites[i];
+        
+        if (write.state == bulkWriteSent) {
+            if (++write.retryCount > _maxBulkWriteRetries) {
+                qCDebug(ParameterLoaderLog) << "Giving up on bulk write (componentId:" << write.componentId << "name:" << write.name << ")";
+                _bulkWriteDone(write, bulkWriteRejected);
+                if (!bulkWriteInProgress()) {
+                    return;
+                }
+            } else {
+                qCDebug(ParameterLoaderLog) << "Bulk write resend (componentId:" << write.componentId << "name:" << write.name << "retryCount:" << write.retryCount << ")";
+                _writeParameterRaw(write.componentId, write.name, write.value);
+            }
+        }
+    }
+    
+    _fillBulkWriteWindow();
+    if (_bulkWriteSentCount) {
+        _bulkWriteTimer.start();
+    }
+}
+
+/// Marks the write as finished and completes the bulk write once all writes are finished
+void ParameterLoader::_bulkWriteDone(BulkWrite_t& write, BulkWriteState_t state)
+{
+    write.state = state;
+    _bulkWriteSentCount--;
+    _bulkWriteDoneCount++;
+    
+    if (_bulkWriteDoneCount < _bulkWrites.count()) {
+        emit bulkWriteProgress((float)_bulkWriteDoneCount / (float)_bulkWrites.count());
+        return;
+    }
+    
+    QStringList accepted;
+    QStringList rejected;
+    
+    foreach (const BulkWrite_t& doneWrite, _bulkWrites) {
+        QString paramId = QString("%1:%2").arg(doneWrite.componentId).arg(doneWrite.name);
+        
+        if (doneWrite.state == bulkWriteAccepted) {
+            accepted += paramId;
+        } else if (doneWrite.vehicleValueValid) {
+            rejected += QString("%1 - vehicle kept %2 instead of %3").arg(paramId).arg(doneWrite.vehicleValue.toString()).arg(doneWrite.value.toString());
+        } else {
+            rejected += QString("%1 - no response from vehicle").arg(paramId);
+        }
+    }
+    
+    qCDebug(ParameterLoaderLog) << "Bulk write complete accepted:rejected" << accepted.count() << rejected.count();
+    
+    _bulkWriteTimer.stop();
+    _bulkWrites.clear();
+    _bulkWriteIndexMap.clear();
+    _bulkWriteQueue.clear();
+    _bulkWriteSentCount = 0;
+    _bulkWriteDoneCount = 0;
+    
+    if (accepted.count()) {
+        _saveToEEPROM();
+    }
+    
+    emit bulkWriteProgress(0);
+    emit bulkWriteComplete(accepted, rejected);
+}
+
 void ParameterLoader::writeParametersToStream(QTextStream &stream, const QString& name)
 {
     stream << "# Onboard parameters for system " << name << "\n";
     stream << "#\n";
     stream << "# MAV ID  COMPONENT ID  PARAM NAME  VALUE (FLOAT)\n";
 
-    foreach (int componentId, _mapParameterName2Variant.keys()) {
-        foreach (QString paramName, _mapParameterName2Variant[componentId].keys()) {
-            Fact* fact = _mapParameterName2Variant[componentId][paramName].value<Fact*>();
+    foreach (int componentId, _mapParameterName2Fact.keys()) {
+        foreach (QString paramName, _mapParameterName2Fact[componentId].keys()) {
+            Fact* fact = _mapParameterName2Fact[componentId][paramName];
             Q_ASSERT(fact);
             
             stream << _vehicle->id() << "\t" << componentId << "\t" << paramName << "\t" << fact->valueString() << "\t" << QString("%1").arg(_factTypeToMavType(fact->type())) << "\n";
@@ -741,8 +907,8 @@ void ParameterLoader::_checkInitialLoadComplete(void)
         bool firstError = true;
         bool errorsFound = false;
         
-        msgHandler->lockAccess();
-        foreach (UASMessage* msg, msgHandler->messages()) {
+        for (int i=0; i<msgHandler->messageCount(); i++) {
+            UASMessage* msg = msgHandler->message(i);
             if (msg->severityIsError()) {
                 if (!firstError) {
                     errors += "\n";
@@ -754,7 +920,6 @@ void ParameterLoader::_checkInitialLoadComplete(void)
             }
         }
         msgHandler->showErrorsInToolbar();
-        msgHandler->unlockAccess();
         
         if (errorsFound) {
             QString errorMsg = QString("Errors were detected during vehicle startup. You should resolve these prior to flight.\n%1").arg(errors);
@@ -31,6 +31,7 @@
 #include <QMutex>
 
 #include "FactSystem.h"
+#include "FactValue.h"
 #include "MAVLinkProtocol.h"
 #include "AutoPilotPlugin.h"
 #include "QGCMAVLink.h"
@@ -59,6 +60,9 @@ public:
     /// Re-request the full set of parameters from the autopilot
     void refreshAllParameters(void);
     
+    /// Returns the number of parameters across all components
+    int parameterCount(void) { return _totalParamCount; }
+    
     /// Request a refresh on the specific parameter
     void refreshParameter(int componentId, const QString& name);
     
@@ -80,9 +84,19 @@ public:
     
     const QMap<int, QMap<QString, QStringList> >& getGroupMap(void);
     
-    /// Returns error messages from loading
+    /// Reads the parameters from the stream and writes them to the vehicle as a single bulk write. The outcome
+    /// of the writes is reported by bulkWriteComplete.
+    /// @return Errors for parameters which were skipped, empty string for none
     QString readParametersFromStream(QTextStream& stream);
     
+    /// Adds a parameter write to the bulk write, starting a new bulk write if none is in progress. At most
+    /// _bulkWriteWindowSize writes are outstanding at a time, each is acked by the vehicle echoing the
+    /// written value. Writing a parameter which is already part of the bulk write replaces the value.
+    void bulkWrite(Fact* fact, const FactValue& value);
+    
+    /// @return true: A bulk write is in progress. Changes to Fact values are added to it.
+    bool bulkWriteInProgress(void) { return !_bulkWrites.isEmpty(); }
+    
     void writeParametersToStream(QTextStream &stream, const QString& name);
 
     /// Return the parameter for which the default component id is derived from. Return an empty
@@ -99,36 +113,64 @@ signals:
     /// Signalled to ourselves in order to get call on our own thread
     void restartWaitingParamTimer(void);
     
+    /// Signalled to update progress of a bulk write, 0 when the bulk write is complete
+    void bulkWriteProgress(float value);
+    
+    /// Signalled when all parameters of a bulk write have been acked or have failed
+    ///     @param accepted Parameters the vehicle now holds at the written value, "componentId:name"
+    ///     @param rejected Parameters the vehicle did not take, one message each
+    void bulkWriteComplete(const QStringList& accepted, const QStringList& rejected);
+    
 protected:
     /// Base implementation adds generic meta data based on variant type. Derived class can override to provide
     /// more details meta data.
     virtual void _addMetaDataToFact(Fact* fact);
     
 private slots:
-    void _parameterUpdate(int uasId, int componentId, QString parameterName, int parameterCount, int parameterId, int mavType, QVariant value);
+    void _parameterUpdate(int uasId, int componentId, QString parameterName, int parameterCount, int parameterId, int mavType, quint32 paramBits);
     void _valueUpdated(const QVariant& value);
     void _restartWaitingParamTimer(void);
     void _waitingParamTimeout(void);
+    void _bulkWriteTimeout(void);
     
 private:
-    static QVariant _stringToTypedVariant(const QString& string, FactMetaData::ValueType_t type, bool failOk = false);
+    typedef enum {
+        bulkWriteQueued,
+        bulkWriteSent,
+        bulkWriteAccepted,
+        bulkWriteRejected,
+    } BulkWriteState_t;
+    
+    typedef struct {
+        int                 componentId;
+        QString             name;
+        FactValue           value;              ///< Value to write
+        FactValue           vehicleValue;       ///< Last value echoed by the vehicle since the write was sent
+        bool                vehicleValueValid;  ///< false: Nothing echoed since the write was sent
+        int                 retryCount;
+        BulkWriteState_t    state;
+    } BulkWrite_t;
+    
     int _actualComponentId(int componentId);
     void _determineDefaultComponentId(void);
     void _setupGroupMap(void);
     void _readParameterRaw(int componentId, const QString& paramName, int paramIndex);
-    void _writeParameterRaw(int componentId, const QString& paramName, const QVariant& value);
+    void _writeParameterRaw(int componentId, const QString& paramName, const FactValue& value);
     MAV_PARAM_TYPE _factTypeToMavType(FactMetaData::ValueType_t factType);
     FactMetaData::ValueType_t _mavTypeToFactType(MAV_PARAM_TYPE mavType);
     void _saveToEEPROM(void);
     void _checkInitialLoadComplete(void);
+    void _bulkWriteAck(int componentId, const QString& name, const FactValue& value);
+    void _fillBulkWriteWindow(void);
+    void _bulkWriteDone(BulkWrite_t& write, BulkWriteState_t state);
     
     AutoPilotPlugin*    _autopilot;
     Vehicle*            _vehicle;
     MAVLinkProtocol*    _mavlink;
     
     /// First mapping is by component id
-    /// Second mapping is parameter name, to Fact* in QVariant
-    QMap<int, QVariantMap> _mapParameterName2Variant;
+    /// Second mapping is parameter name, to Fact
+    QMap<int, QMap<QString, Fact*> > _mapParameterName2Fact;
     
     /// First mapping is by component id
     /// Second mapping is group name, to Fact
@@ -151,9 +193,22 @@ private:
     
     QTimer _waitingParamTimeoutTimer;
     
+    QList<BulkWrite_t>              _bulkWrites;            ///< All writes of the bulk write in progress
+    QMap<int, QMap<QString, int> >  _bulkWriteIndexMap;     ///< Key: Component id, Value: Map { Key: parameter name, Value: index in _bulkWrites }
+    QList<int>                      _bulkWriteQueue;        ///< Indices of writes waiting to be sent
+    int                             _bulkWriteSentCount;    ///< Number of writes waiting for ack
+    int                             _bulkWriteDoneCount;    ///< Number of writes accepted or rejected
+    QTimer                          _bulkWriteTimer;
+    
+    static const int _bulkWriteWindowSize = 8;      ///< Maximum number of outstanding writes
+    static const int _maxBulkWriteRetries = 3;      ///< Resends of a write before it is rejected
+    static const int _bulkWriteAckTimeoutMsecs = 1000;
+    
     QMutex _dataMutex;
     
     static Fact _defaultFact;   ///< Used to return default fact, when parameter not found
+    
+    friend class ParameterLoaderTest;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "ParameterLoaderTest.h"
+#include "ParameterLoader.h"
+#include "LinkManager.h"
+#include "MultiVehicleManager.h"
+
+#include <QElapsedTimer>
+#include <QTextStream>
+
+UT_REGISTER_TEST(ParameterLoaderTest)
+
+ParameterLoaderTest::ParameterLoaderTest(void)
+    : _mockLink(NULL)
+    , _plugin(NULL)
+{
+    
+}
+
+void ParameterLoaderTest::init(void)
+{
+    UnitTest::init();
+    
+    _mockLink = new MockLink();
+    LinkManager::instance()->_addLink(_mockLink);
+    LinkManager::instance()->connectLink(_mockLink);
+    
+    // Wait for the Vehicle to get created and its parameters loaded
+    QSignalSpy spyVehicle(MultiVehicleManager::instance(), SIGNAL(parameterReadyVehicleAvailableChanged(bool)));
+    QCOMPARE(spyVehicle.wait(5000), true);
+    QVERIFY(MultiVehicleManager::instance()->parameterReadyVehicleAvailable());
+    
+    _plugin = MultiVehicleManager::instance()->activeVehicle()->autopilotPlugin();
+    QVERIFY(_plugin != NULL);
+}
+
+void ParameterLoaderTest::cleanup(void)
+{
+    _mockLink = NULL;
+    _plugin = NULL;
+    
+    UnitTest::cleanup();
+}
+
+/// Loads a parameter file which is larger than the write window. The first echo is dropped so that write has to be
+/// resent, one parameter is held by the vehicle and a queued write is replaced before it is sent.
+void ParameterLoaderTest::_bulkWrite_test(void)
+{
+    ParameterLoader* paramLoader = _plugin->findChild<ParameterLoader*>();
+    QVERIFY(paramLoader != NULL);
+    
+    QStringList names;
+    names << "CBRK_AIRSPD_CHK" << "CBRK_ENGINEFAIL" << "CBRK_FLIGHTTERM" << "CBRK_IO_SAFETY" << "CBRK_NO_VISION" << "CBRK_RATE_CTRL"
+          << "CBRK_SUPPLY_CHK" << "NAV_DLL_CHSK" << "NAV_DLL_CH_LAT" << "NAV_DLL_CH_LON" << "NAV_DLL_N" << "NAV_DLL_OBC";
+    QVERIFY(names.count() > ParameterLoader::_bulkWriteWindowSize);
+    
+    const QString droppedName = names.first();
+    const QString readOnlyName = names[1];
+    const QString replacedName = names.last();
+    
+    int vehicleId = MultiVehicleManager::instance()->activeVehicle()->id();
+    QMap<QString, qint64> originalValues;
+    QString fileText;
+    QTextStream fileStream(&fileText);
+    
+    foreach (const QString& name, names) {
+        Fact* fact = _plugin->getParameterFact(FactSystem::defaultComponentId, name);
+        QCOMPARE(fact->type(), FactMetaData::valueTypeInt32);
+        
+        originalValues[name] = (qint64)fact->rawValue().toDouble();
+        fileStream << vehicleId << "\t" << fact->componentId() << "\t" << name << "\t" << originalValues[name] + 1 << "\t" << MAV_PARAM_TYPE_INT32 << "\n";
+    }
+    fileStream.flush();
+    
+    int componentId = _plugin->getParameterFact(FactSystem::defaultComponentId, droppedName)->componentId();
+    
+    _mockLink->setParamSetAckDropCount(1);
+    _mockLink->setParamReadOnly(readOnlyName);
+    
+    QSignalSpy spyComplete(paramLoader, SIGNAL(bulkWriteComplete(const QStringList&, const QStringList&)));
+    
+    QTextStream readStream(&fileText);
+    QCOMPARE(_plugin->readParametersFromStream(readStream), QString());
+    
+    // Only a window full of writes went out, the rest are queued
+    QCOMPARE(paramLoader->_bulkWriteSentCount, (int)ParameterLoader::_bulkWriteWindowSize);
+    QCOMPARE(paramLoader->_bulkWriteQueue.count(), names.count() - ParameterLoader::_bulkWriteWindowSize);
+    
+    // Writing a queued parameter again replaces the value instead of adding a write
+    Fact* replacedFact = _plugin->getParameterFact(FactSystem::defaultComponentId, replacedName);
+    FactValue replacedValue = FactValue::fromInteger(FactMetaData::valueTypeInt32, originalValues[replacedName] + 10);
+    paramLoader->bulkWrite(replacedFact, replacedValue);
+    QCOMPARE(paramLoader->_bulkWrites.count(), names.count());
+    QCOMPARE(paramLoader->_bulkWriteQueue.count(), names.count() - ParameterLoader::_bulkWriteWindowSize);
+    
+    // The read only parameter takes all retries before it is rejected
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (spyComplete.count() == 0 && elapsed.elapsed() < 20000) {
+        QVERIFY(paramLoader->_bulkWriteSentCount <= ParameterLoader::_bulkWriteWindowSize);
+        QTest::qWait(20);
+    }
+    QCOMPARE(spyComplete.count(), 1);
+    
+    QStringList accepted = spyComplete[0][0].toStringList();
+    QStringList rejected = spyComplete[0][1].toStringList();
+    
+    // The dropped echo can only have been accepted through a resend
+    QCOMPARE(_mockLink->paramSetAckDropCount(), 0);
+    QVERIFY(accepted.contains(QString("%1:%2").arg(componentId).arg(droppedName)));
+    
+    QCOMPARE(rejected.count(), 1);
+    QVERIFY(rejected[0].startsWith(QString("%1:%2 - vehicle kept %3").arg(componentId).arg(readOnlyName).arg(originalValues[readOnlyName])));
+    
+    QCOMPARE(accepted.count(), names.count() - 1);
+    QCOMPARE(accepted.count(QString("%1:%2").arg(componentId).arg(replacedName)), 1);
+    
+    // The Facts hold what the vehicle echoed
+    foreach (const QString& name, names) {
+        Fact* fact = _plugin->getParameterFact(FactSystem::defaultComponentId, name);
+        
+        qint64 expectedValue = originalValues[name] + 1;
+        if (name == readOnlyName) {
+            expectedValue = originalValues[name];
+        } else if (name == replacedName) {
+            expectedValue = originalValues[name] + 10;
+        }
+        QCOMPARE((qint64)fact->rawValue().toDouble(), expectedValue);
+    }
+    
+    QVERIFY(!paramLoader->bulkWriteInProgress());
+}
@@ -120,20 +120,58 @@ Item {
             visible:        _activeVehicle ? _activeVehicle.homePositionAvailable : false
         }
 
-        // Add trajectory points to the map
-        MapItemView {
-            model: multiVehicleManager.activeVehicle ? multiVehicleManager.activeVehicle.trajectoryPoints : 0
-            
-            delegate:
-                MapPolyline {
-                    line.width: 3
-                    line.color: "orange"
-
-                    path: [
-                        { latitude: object.coordinate1.latitude, longitude: object.coordinate1.longitude },
-                        { latitude: object.coordinate2.latitude, longitude: object.coordinate2.longitude },
-                    ]
+        // Add the trajectory to the map. The fixed points are a polyline which only ever has points added, the
+        // moving end of the trajectory is drawn as a separate two point polyline so it can be updated cheaply.
+        MapPolyline {
+            id:         trajectoryPolyline
+            line.width: 3
+            line.color: "orange"
+
+            property var trajectory: _activeVehicle ? _activeVehicle.trajectory : null
+
+            function reload() {
+                var points = trajectory ? trajectory.path : []
+                if (points.length >= 2) {
+                    trajectoryTail.path = [ points[points.length - 2], points[points.length - 1] ]
+                } else {
+                    trajectoryTail.path = points
                 }
+                points.pop()
+                path = points
+            }
+
+            // Updates the moving end to run from the last fixed point to coordinate
+            function updateTail(coordinate) {
+                if (trajectory.count >= 2) {
+                    trajectoryTail.path = [ trajectory.coordinate(trajectory.count - 2), coordinate ]
+                } else {
+                    trajectoryTail.path = [ coordinate ]
+                }
+            }
+
+            onTrajectoryChanged: reload()
+
+            Connections {
+                target: trajectoryPolyline.trajectory
+
+                onPathChanged: trajectoryPolyline.reload()
+
+                // The previous end point is now fixed
+                onPointAppended: {
+                    if (trajectoryPolyline.trajectory.count >= 2) {
+                        trajectoryPolyline.addCoordinate(trajectoryPolyline.trajectory.coordinate(trajectoryPolyline.trajectory.count - 2))
+                    }
+                    trajectoryPolyline.updateTail(coordinate)
+                }
+
+                onLastPointMoved: trajectoryPolyline.updateTail(coordinate)
+            }
+        }
+
+        MapPolyline {
+            id:         trajectoryTail
+            line.width: trajectoryPolyline.line.width
+            line.color: trajectoryPolyline.line.color
         }
 
         // Add the vehicles to the map
@@ -36,7 +36,6 @@ const char* MissionEditor::_settingsGroup = "MissionEditor";
 
 MissionEditor::MissionEditor(QWidget *parent)
     : QGCQmlWidgetHolder(parent)
-    , _missionItems(NULL)
     , _canEdit(true)
 {
     // Get rid of layout default margins
@@ -45,14 +44,17 @@ MissionEditor::MissionEditor(QWidget *parent)
         pl->setContentsMargins(0,0,0,0);
     }
     
+    // Waypoint lines are updated incrementally as items change, only a reset of the whole list rebuilds them
+    connect(&_missionItems, &MissionItemStore::rowsInserted,        this, &MissionEditor::_missionItemsInserted);
+    connect(&_missionItems, &MissionItemStore::rowsRemoved,         this, &MissionEditor::_missionItemsRemoved);
+    connect(&_missionItems, &MissionItemStore::coordinateChanged,   this, &MissionEditor::_missionItemCoordinateChanged);
+    connect(&_missionItems, &MissionItemStore::modelReset,          this, &MissionEditor::_rebuildWaypointLines);
+    
     Vehicle* activeVehicle = MultiVehicleManager::instance()->activeVehicle();
     if (activeVehicle) {
         MissionManager* missionManager = activeVehicle->missionManager();
         connect(missionManager, &MissionManager::newMissionItemsAvailable, this, &MissionEditor::_newMissionItemsAvailable);
         _newMissionItemsAvailable();
-    } else {
-        _missionItems = new QmlObjectListModel(this);
-        connect(_missionItems, &QmlObjectListModel::dirtyChanged, this, &MissionEditor::_missionListDirtyChanged);
     }
     
     setContextPropertyObject("controller", this);
@@ -66,21 +68,12 @@ MissionEditor::~MissionEditor()
 
 void MissionEditor::_newMissionItemsAvailable(void)
 {
-    if (_missionItems) {
-        _missionItems->deleteLater();
-    }
-    
     MissionManager* missionManager = MultiVehicleManager::instance()->activeVehicle()->missionManager();
     
     _canEdit = missionManager->canEdit();
-    _missionItems = missionManager->copyMissionItems();
-    _reSequence();
-    _missionItems->setDirty(false);
-    
-    connect(_missionItems, &QmlObjectListModel::dirtyChanged, this, &MissionEditor::_missionListDirtyChanged);
-    _rebuildWaypointLines();
+    _missionItems.setItems(*missionManager->missionItems());
+    _missionItems.setDirty(false);
     
-    emit missionItemsChanged();
     emit canEditChanged(_canEdit);
 }
 
@@ -90,7 +83,7 @@ void MissionEditor::getMissionItems(void)
     
     if (activeVehicle) {
         MissionManager* missionManager = activeVehicle->missionManager();
-        connect(missionManager, &MissionManager::newMissionItemsAvailable, this, &MissionEditor::_newMissionItemsAvailable);
+        connect(missionManager, &MissionManager::newMissionItemsAvailable, this, &MissionEditor::_newMissionItemsAvailable, Qt::UniqueConnection);
         activeVehicle->missionManager()->requestMissionItems();
     }
 }
@@ -100,8 +93,12 @@ void MissionEditor::setMissionItems(void)
     Vehicle* activeVehicle = MultiVehicleManager::instance()->activeVehicle();
     
     if (activeVehicle) {
-        activeVehicle->missionManager()->writeMissionItems(*_missionItems);
-        _missionItems->setDirty(false);
+        // MissionManager copies the items, so the objects are only needed for the duration of the call
+        QmlObjectListModel* list = _missionItems.createObjectList();
+        activeVehicle->missionManager()->writeMissionItems(*list);
+        delete list;
+        
+        _missionItems.setDirty(false);
     }
 }
 
@@ -111,22 +108,15 @@ int MissionEditor::addMissionItem(QGeoCoordinate coordinate)
         qWarning() << "addMissionItem called with _canEdit == false";
     }
     
-    MissionItem * newItem = new MissionItem(this, _missionItems->count(), coordinate, MAV_CMD_NAV_WAYPOINT);
-    newItem->setAltitude(30);
-    if (_missionItems->count() == 0) {
-        newItem->setCommand(MavlinkQmlSingleton::MAV_CMD_NAV_TAKEOFF);
+    MissionItem newItem(NULL, _missionItems.count(), coordinate, MAV_CMD_NAV_WAYPOINT);
+    newItem.setAltitude(30);
+    if (_missionItems.count() == 0) {
+        newItem.setCommand(MavlinkQmlSingleton::MAV_CMD_NAV_TAKEOFF);
     }
-    qDebug() << "MissionItem" << newItem->coordinate();
-    _missionItems->append(newItem);
+    qDebug() << "MissionItem" << newItem.coordinate();
+    _missionItems.append(newItem);
     
-    return _missionItems->count() - 1;
-}
-
-void MissionEditor::_reSequence(void)
-{
-    for (int i=0; i<_missionItems->count(); i++) {
-        qobject_cast<MissionItem*>(_missionItems->get(i))->setSequenceNumber(i);
-    }
+    return _missionItems.count() - 1;
 }
 
 void MissionEditor::removeMissionItem(int index)
@@ -136,8 +126,7 @@ void MissionEditor::removeMissionItem(int index)
         return;
     }
     
-    _missionItems->removeAt(index);
-    _reSequence();
+    _missionItems.removeAt(index);
 }
 
 void MissionEditor::moveUp(int index)
@@ -147,20 +136,11 @@ void MissionEditor::moveUp(int index)
         return;
     }
     
-    if (_missionItems->count() < 2 || index <= 0 || index >= _missionItems->count()) {
+    if (_missionItems.count() < 2 || index <= 0 || index >= _missionItems.count()) {
         return;
     }
     
-    MissionItem item1 = *qobject_cast<MissionItem*>(_missionItems->get(index - 1));
-    MissionItem item2 = *qobject_cast<MissionItem*>(_missionItems->get(index));
-    
-    _missionItems->removeAt(index - 1);
-    _missionItems->removeAt(index - 1);
-    
-    _missionItems->insert(index - 1, new MissionItem(item2, _missionItems));
-    _missionItems->insert(index, new MissionItem(item1, _missionItems));
-    
-    _reSequence();
+    _missionItems.swap(index - 1, index);
 }
 
 void MissionEditor::moveDown(int index)
@@ -170,20 +150,11 @@ void MissionEditor::moveDown(int index)
         return;
     }
     
-    if (_missionItems->count() < 2 || index >= _missionItems->count() - 1) {
+    if (_missionItems.count() < 2 || index >= _missionItems.count() - 1) {
         return;
     }
     
-    MissionItem item1 = *qobject_cast<MissionItem*>(_missionItems->get(index));
-    MissionItem item2 = *qobject_cast<MissionItem*>(_missionItems->get(index + 1));
-    
-    _missionItems->removeAt(index);
-    _missionItems->removeAt(index);
-    
-    _missionItems->insert(index, new MissionItem(item2, _missionItems));
-    _missionItems->insert(index + 1, new MissionItem(item1, _missionItems));
-    
-    _reSequence();
+    _missionItems.swap(index, index + 1);
 }
 
 void MissionEditor::loadMissionFromFile(void)
@@ -195,11 +166,6 @@ void MissionEditor::loadMissionFromFile(void)
         return;
     }
     
-    if (_missionItems) {
-        _missionItems->deleteLater();
-    }
-    _missionItems = new QmlObjectListModel(this);
-
     _canEdit = true;
     
     QFile file(filename);
@@ -213,34 +179,19 @@ void MissionEditor::loadMissionFromFile(void)
         
         if (!(version.size() == 3 && version[0] == "QGC" && version[1] == "WPL" && version[2] == "120")) {
             errorString = "The mission file is not compatible with the current version of QGroundControl.";
+        } else if (!_missionItems.load(in)) {
+            errorString = "The mission file is corrupted.";
         } else {
-            while (!in.atEnd()) {
-                MissionItem* item = new MissionItem();
-                
-                if (item->load(in)) {
-                    _missionItems->append(item);
-                    
-                    if (!item->canEdit()) {
-                        _canEdit = false;
-                    }
-                } else {
-                    errorString = "The mission file is corrupted.";
-                    break;
-                }
-            }
+            _canEdit = _missionItems.canEdit();
         }
-        
     }
     
     if (!errorString.isEmpty()) {
-        _missionItems->clear();
+        _missionItems.clear();
     }
     
-    _missionItems->setDirty(false);
+    _missionItems.setDirty(false);
     emit canEditChanged(_canEdit);
-    
-    connect(_missionItems, &QmlObjectListModel::dirtyChanged, this, &MissionEditor::_missionListDirtyChanged);
-    _rebuildWaypointLines();
 }
 
 void MissionEditor::saveMissionToFile(void)
@@ -261,28 +212,76 @@ void MissionEditor::saveMissionToFile(void)
         
         out << "QGC WPL 120\r\n";   // Version string
         
-        for (int i=0; i<_missionItems->count(); i++) {
-            qobject_cast<MissionItem*>(_missionItems->get(i))->save(out);
-        }
+        _missionItems.save(out);
     }
     
-    _missionItems->setDirty(false);
+    _missionItems.setDirty(false);
 }
 
 void MissionEditor::_rebuildWaypointLines(void)
 {
-    _waypointLines.clear();
-    for (int i=1; i<_missionItems->count(); i++) {
-        MissionItem* item1 = qobject_cast<MissionItem*>(_missionItems->get(i-1));
-        MissionItem* item2 = qobject_cast<MissionItem*>(_missionItems->get(i));
-        
-        _waypointLines.append(new CoordinateVector(item1->coordinate(), item2->coordinate()));
+    while (_waypointLines.count()) {
+        QObject* line = _waypointLines[0];
+        _waypointLines.removeAt(0);
+        line->deleteLater();
+    }
+    
+    for (int i=1; i<_missionItems.count(); i++) {
+        _waypointLines.append(new CoordinateVector(_missionItems.coordinate(i-1), _missionItems.coordinate(i), this));
     }
     emit waypointLinesChanged();
 }
 
-void MissionEditor::_missionListDirtyChanged(bool dirty)
+/// Sets the end points of the specified line from the mission items it connects
+void MissionEditor::_updateWaypointLine(int lineIndex)
 {
-    Q_UNUSED(dirty);
-    _rebuildWaypointLines();
+    if (lineIndex >= 0 && lineIndex < _waypointLines.count()) {
+        qobject_cast<CoordinateVector*>(_waypointLines[lineIndex])->setCoordinates(_missionItems.coordinate(lineIndex), _missionItems.coordinate(lineIndex + 1));
+    }
+}
+
+void MissionEditor::_missionItemsInserted(const QModelIndex& parent, int first, int last)
+{
+    Q_UNUSED(parent);
+    Q_UNUSED(last);
+    Q_ASSERT(first == last);    // MissionItemStore only inserts single items
+    
+    // The new item adds one line. The lines on either side of it are then set to connect to the new item.
+    if (_missionItems.count() > 1) {
+        int lineIndex = qMin(first, _missionItems.count() - 2);
+        _waypointLines.insert(lineIndex, new CoordinateVector(_missionItems.coordinate(lineIndex), _missionItems.coordinate(lineIndex + 1), this));
+    }
+    _updateWaypointLine(first - 1);
+    _updateWaypointLine(first);
+    
+    emit waypointLinesChanged();
+}
+
+void MissionEditor::_missionItemsRemoved(const QModelIndex& parent, int first, int last)
+{
+    Q_UNUSED(parent);
+    Q_UNUSED(last);
+    Q_ASSERT(first == last);    // MissionItemStore only removes single items
+    
+    // The removed item takes one line with it, the line before it then connects to the next item
+    if (_waypointLines.count()) {
+        int lineIndex = qMin(first, _waypointLines.count() - 1);
+        QObject* line = _waypointLines[lineIndex];
+        _waypointLines.removeAt(lineIndex);
+        line->deleteLater();
+    }
+    _updateWaypointLine(first - 1);
+    
+    emit waypointLinesChanged();
+}
+
+void MissionEditor::_missionItemCoordinateChanged(int index)
+{
+    _updateWaypointLine(index - 1);
+    _updateWaypointLine(index);
+    
+    if (index == 0) {
+        // Home position line
+        emit waypointLinesChanged();
+    }
 }
@@ -26,6 +26,7 @@ This file is part of the QGROUNDCONTROL project
 
 #include "QGCQmlWidgetHolder.h"
 #include "QmlObjectListModel.h"
+#include "MissionItemStore.h"
 
 class MissionEditor : public QGCQmlWidgetHolder
 {
@@ -35,7 +36,7 @@ public:
     MissionEditor(QWidget* parent = NULL);
     ~MissionEditor();
 
-    Q_PROPERTY(QmlObjectListModel*  missionItems    READ missionItems       NOTIFY missionItemsChanged)
+    Q_PROPERTY(MissionItemStore*    missionItems    READ missionItems       CONSTANT)
     Q_PROPERTY(QmlObjectListModel*  waypointLines   READ waypointLines      NOTIFY waypointLinesChanged)
     Q_PROPERTY(bool                 canEdit         READ canEdit            NOTIFY canEditChanged)
     
@@ -50,26 +51,27 @@ public:
 
     // Property accessors
     
-    QmlObjectListModel* missionItems(void) { return _missionItems; }
+    MissionItemStore* missionItems(void) { return &_missionItems; }
     QmlObjectListModel* waypointLines(void) { return &_waypointLines; }
     bool canEdit(void) { return _canEdit; }
     
 signals:
-    void missionItemsChanged(void);
     void canEditChanged(bool canEdit);
     void waypointLinesChanged(void);
     
 private slots:
     void _newMissionItemsAvailable();
-    void _missionListDirtyChanged(bool dirty);
+    void _missionItemsInserted(const QModelIndex& parent, int first, int last);
+    void _missionItemsRemoved(const QModelIndex& parent, int first, int last);
+    void _missionItemCoordinateChanged(int index);
+    void _rebuildWaypointLines(void);
     
 private:
-    void _reSequence(void);
-    void _rebuildWaypointLines(void);
+    void _updateWaypointLine(int lineIndex);
    
 private:
-    QmlObjectListModel* _missionItems;
-    QmlObjectListModel  _waypointLines;
+    MissionItemStore    _missionItems;
+    QmlObjectListModel  _waypointLines;     ///< Line lineIndex connects mission items lineIndex and lineIndex + 1
     bool                _canEdit;           ///< true: UI can edit these items, false: can't edit, can only send to vehicle or save
     
     static const char* _settingsGroup;
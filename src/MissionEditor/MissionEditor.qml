@@ -63,9 +63,7 @@ QGCView {
     }
 
     function setCurrentItem(index) {
-        for (var i=0; i<_missionItems.count; i++) {
-            _missionItems.get(i).isCurrentItem = (i == index)
-        }
+        _missionItems.currentIndex = index
     }
 
     QGCViewPanel {
@@ -267,7 +265,7 @@ This code will need to wait for Qml 5.5 support since Map.visibleRegion is only
 
                                     // Now expand the region to include all mission items
                                     for (var i=0; i<_missionItems.count; i++) {
-                                        var missionItem = _missionItems.get(i)
+                                        var missionItem = { coordinate: _missionItems.coordinate(i) }
 
                                         region.topLeft.latitude = Math.max(missionItem.coordinate.latitude, region.topLeft.latitude)
                                         region.topLeft.longitude = Math.min(missionItem.coordinate.longitude, region.topLeft.longitude)
@@ -394,14 +392,14 @@ This code will need to wait for Qml 5.5 support since Map.visibleRegion is only
                     
                     delegate:
                         MissionItemIndicator {
-                            label:          object.sequenceNumber
-                            isCurrentItem:  !_showHomePositionManager && object.isCurrentItem
-                            coordinate:     object.coordinate
+                            label:          model.sequenceNumber
+                            isCurrentItem:  !_showHomePositionManager && model.isCurrentItem
+                            coordinate:     model.coordinate
                             z:              2
 
                             onClicked: {
                                 _showHomePositionManager = false
-                                setCurrentItem(object.sequenceNumber)
+                                setCurrentItem(model.sequenceNumber)
                             }
                         }
                 }
@@ -420,7 +418,7 @@ This code will need to wait for Qml 5.5 support since Map.visibleRegion is only
                         }
                         if (_missionItems && _missionItems.count != 0) {
                             homePositionLine.addCoordinate(homePositionCoordinate)
-                            homePositionLine.addCoordinate(_missionItems.get(0).coordinate)
+                            homePositionLine.addCoordinate(_missionItems.coordinate(0))
                         }
                     }
 
@@ -494,25 +492,76 @@ This code will need to wait for Qml 5.5 support since Map.visibleRegion is only
 
                             property real _maxItemHeight: 0
 
+                            // Only the current item has a full editor, which is bound to the single editing object
+                            // the store keeps for it. All other items show a summary from the model roles.
                             delegate:
+                                Item {
+                                    width:  missionItemSummaryList.width
+                                    height: _isCurrentItem ? editorLoader.height : itemSummary.height
+
+                                    property bool _isCurrentItem: model.isCurrentItem && _missionItems.currentItem
+
+                                    Rectangle {
+                                        id:         itemSummary
+                                        width:      parent.width
+                                        height:     summaryLabel.height + (_margin * 2)
+                                        color:      _qgcPal.windowShade
+                                        visible:    !_isCurrentItem
+
+                                        readonly property real _margin: ScreenTools.defaultFontPixelWidth / 3
+
+                                        MissionItemIndexLabel {
+                                            id:                     summaryLabel
+                                            anchors.margins:        itemSummary._margin
+                                            anchors.left:           parent.left
+                                            anchors.verticalCenter: parent.verticalCenter
+                                            isCurrentItem:          false
+                                            label:                  model.sequenceNumber
+                                        }
+
+                                        QGCLabel {
+                                            anchors.leftMargin:     ScreenTools.defaultFontPixelWidth * 10
+                                            anchors.left:           summaryLabel.right
+                                            anchors.verticalCenter: parent.verticalCenter
+                                            text:                   model.commandName
+                                        }
+
+                                        MouseArea {
+                                            anchors.fill:   parent
+                                            onClicked:      setCurrentItem(model.sequenceNumber)
+                                        }
+                                    }
+
+                                    Loader {
+                                        id:                 editorLoader
+                                        width:              parent.width
+                                        active:             _isCurrentItem
+                                        sourceComponent:    currentItemEditor
+                                    }
+                                }
+
+                            Component {
+                                id: currentItemEditor
+
                                 MissionItemEditor {
-                                    missionItem:    object
-                                    width:          parent.width
+                                    missionItem:    _missionItems.currentItem
+                                    width:          missionItemSummaryList.width
 
-                                    onClicked:  setCurrentItem(object.sequenceNumber)
+                                    onClicked:  setCurrentItem(missionItem.sequenceNumber)
 
                                     onRemove: {
-                                        var newCurrentItem = object.sequenceNumber - 1
-                                        controller.removeMissionItem(object.sequenceNumber)
+                                        var newCurrentItem = missionItem.sequenceNumber - 1
+                                        controller.removeMissionItem(missionItem.sequenceNumber)
                                         if (_missionItems.count) {
-                                            newCurrentItem = Math.min(_missionItems.count - 1, newCurrentItem)
+                                            newCurrentItem = Math.min(_missionItems.count - 1, Math.max(newCurrentItem, 0))
                                             setCurrentItem(newCurrentItem)
                                         }
                                     }
 
-                                    onMoveUp:   controller.moveUp(object.sequenceNumber)
-                                    onMoveDown: controller.moveDown(object.sequenceNumber)
+                                    onMoveUp:   controller.moveUp(missionItem.sequenceNumber)
+                                    onMoveDown: controller.moveDown(missionItem.sequenceNumber)
                                 }
+                            }
                         } // ListView
 
                         QGCLabel {
@@ -0,0 +1,441 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "MissionItemStore.h"
+
+#include <QQmlEngine>
+
+MissionItemStore::MissionItemStore(QObject* parent)
+    : QAbstractListModel(parent)
+    , _dirty(false)
+    , _currentIndex(-1)
+    , _currentItem(NULL)
+{
+
+}
+
+MissionItemStore::~MissionItemStore()
+{
+
+}
+
+QGeoCoordinate MissionItemStore::coordinate(int index) const
+{
+    if (index < 0 || index >= count()) {
+        qWarning() << "MissionItemStore::coordinate invalid index:count" << index << count();
+        return QGeoCoordinate();
+    }
+    
+    return QGeoCoordinate(_latitude[index], _longitude[index], _altitude[index]);
+}
+
+void MissionItemStore::setDirty(bool dirty)
+{
+    if (_dirty != dirty) {
+        _dirty = dirty;
+        emit dirtyChanged(_dirty);
+    }
+}
+
+void MissionItemStore::setCurrentIndex(int index)
+{
+    if (index < 0 || index >= count()) {
+        index = -1;
+    }
+    
+    if (index == _currentIndex) {
+        return;
+    }
+    
+    int previousIndex = _currentIndex;
+    
+    _currentIndex = index;
+    _rowChanged(previousIndex);
+    _rowChanged(_currentIndex);
+    _updateCurrentItem();
+    
+    emit currentIndexChanged(_currentIndex);
+}
+
+void MissionItemStore::setItems(const QmlObjectListModel& missionItems)
+{
+    beginResetModel();
+    
+    int itemCount = missionItems.count();
+    
+    _latitude.resize(itemCount);
+    _longitude.resize(itemCount);
+    _altitude.resize(itemCount);
+    _param1.resize(itemCount);
+    _param2.resize(itemCount);
+    _param3.resize(itemCount);
+    _param4.resize(itemCount);
+    _command.resize(itemCount);
+    _frame.resize(itemCount);
+    _autoContinue.resize(itemCount);
+    
+    for (int i=0; i<itemCount; i++) {
+        _setValues(i, *qobject_cast<const MissionItem*>(missionItems[i]));
+    }
+    
+    _currentIndex = -1;
+    endResetModel();
+    
+    _updateCurrentItem();
+    emit currentIndexChanged(_currentIndex);
+    emit countChanged(count());
+}
+
+void MissionItemStore::clear(void)
+{
+    setItems(QmlObjectListModel());
+}
+
+void MissionItemStore::insert(int index, const MissionItem& missionItem)
+{
+    if (index < 0 || index > count()) {
+        qWarning() << "MissionItemStore::insert invalid index:count" << index << count();
+        return;
+    }
+    
+    beginInsertRows(QModelIndex(), index, index);
+    _latitude.insert(index, 0);
+    _longitude.insert(index, 0);
+    _altitude.insert(index, 0);
+    _param1.insert(index, 0);
+    _param2.insert(index, 0);
+    _param3.insert(index, 0);
+    _param4.insert(index, 0);
+    _command.insert(index, 0);
+    _frame.insert(index, 0);
+    _autoContinue.insert(index, true);
+    _setValues(index, missionItem);
+    endInsertRows();
+    
+    // Items after the new one have moved down a sequence number
+    if (index + 1 < count()) {
+        emit dataChanged(this->index(index + 1), this->index(count() - 1), QVector<int>() << SequenceNumberRole);
+    }
+    
+    if (_currentIndex >= index) {
+        _currentIndex++;
+        _currentItem->setSequenceNumber(_currentIndex);
+        emit currentIndexChanged(_currentIndex);
+    }
+    
+    emit countChanged(count());
+    setDirty(true);
+}
+
+void MissionItemStore::removeAt(int index)
+{
+    if (index < 0 || index >= count()) {
+        qWarning() << "MissionItemStore::removeAt invalid index:count" << index << count();
+        return;
+    }
+    
+    beginRemoveRows(QModelIndex(), index, index);
+    _latitude.remove(index);
+    _longitude.remove(index);
+    _altitude.remove(index);
+    _param1.remove(index);
+    _param2.remove(index);
+    _param3.remove(index);
+    _param4.remove(index);
+    _command.remove(index);
+    _frame.remove(index);
+    _autoContinue.remove(index);
+    endRemoveRows();
+    
+    if (index < count()) {
+        emit dataChanged(this->index(index), this->index(count() - 1), QVector<int>() << SequenceNumberRole);
+    }
+    
+    if (_currentIndex == index) {
+        _currentIndex = -1;
+        _updateCurrentItem();
+        emit currentIndexChanged(_currentIndex);
+    } else if (_currentIndex > index) {
+        _currentIndex--;
+        _currentItem->setSequenceNumber(_currentIndex);
+        emit currentIndexChanged(_currentIndex);
+    }
+    
+    emit countChanged(count());
+    setDirty(true);
+}
+
+void MissionItemStore::swap(int index1, int index2)
+{
+    if (index1 < 0 || index1 >= count() || index2 < 0 || index2 >= count() || index1 == index2) {
+        qWarning() << "MissionItemStore::swap invalid index1:index2:count" << index1 << index2 << count();
+        return;
+    }
+    
+    qSwap(_latitude[index1],        _latitude[index2]);
+    qSwap(_longitude[index1],       _longitude[index2]);
+    qSwap(_altitude[index1],        _altitude[index2]);
+    qSwap(_param1[index1],          _param1[index2]);
+    qSwap(_param2[index1],          _param2[index2]);
+    qSwap(_param3[index1],          _param3[index2]);
+    qSwap(_param4[index1],          _param4[index2]);
+    qSwap(_command[index1],         _command[index2]);
+    qSwap(_frame[index1],           _frame[index2]);
+    qSwap(_autoContinue[index1],    _autoContinue[index2]);
+    
+    if (_currentIndex == index1 || _currentIndex == index2) {
+        _currentIndex = _currentIndex == index1 ? index2 : index1;
+        _currentItem->setSequenceNumber(_currentIndex);
+        emit currentIndexChanged(_currentIndex);
+    }
+    
+    _rowChanged(index1);
+    _rowChanged(index2);
+    emit coordinateChanged(index1);
+    emit coordinateChanged(index2);
+    
+    setDirty(true);
+}
+
+MissionItem* MissionItemStore::createMissionItem(int index, QObject* parent) const
+{
+    return new MissionItem(parent,
+                           index,
+                           QGeoCoordinate(_latitude[index], _longitude[index], _altitude[index]),
+                           _command[index],
+                           _param1[index],
+                           _param2[index],
+                           _param3[index],
+                           _param4[index],
+                           _autoContinue[index],
+                           index == _currentIndex,
+                           _frame[index]);
+}
+
+QmlObjectListModel* MissionItemStore::createObjectList(QObject* parent) const
+{
+    QmlObjectListModel* list = new QmlObjectListModel(parent);
+    
+    for (int i=0; i<count(); i++) {
+        list->append(createMissionItem(i, list));
+    }
+    
+    return list;
+}
+
+bool MissionItemStore::canEdit(void) const
+{
+    for (int i=0; i<count(); i++) {
+        if (!MissionItem::canEditValues(_command[i], _frame[i], _autoContinue[i])) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool MissionItemStore::load(QTextStream& stream)
+{
+    bool        success = true;
+    
+    // A single MissionItem is used to parse each line
+    MissionItem item;
+    
+    beginResetModel();
+    
+    _latitude.clear();
+    _longitude.clear();
+    _altitude.clear();
+    _param1.clear();
+    _param2.clear();
+    _param3.clear();
+    _param4.clear();
+    _command.clear();
+    _frame.clear();
+    _autoContinue.clear();
+    
+    while (!stream.atEnd()) {
+        if (!item.load(stream)) {
+            success = false;
+            break;
+        }
+        
+        int index = count();
+        
+        _latitude.append(0);
+        _longitude.append(0);
+        _altitude.append(0);
+        _param1.append(0);
+        _param2.append(0);
+        _param3.append(0);
+        _param4.append(0);
+        _command.append(0);
+        _frame.append(0);
+        _autoContinue.append(true);
+        _setValues(index, item);
+    }
+    
+    if (!success) {
+        _latitude.clear();
+        _longitude.clear();
+        _altitude.clear();
+        _param1.clear();
+        _param2.clear();
+        _param3.clear();
+        _param4.clear();
+        _command.clear();
+        _frame.clear();
+        _autoContinue.clear();
+    }
+    
+    _currentIndex = -1;
+    endResetModel();
+    
+    _updateCurrentItem();
+    emit currentIndexChanged(_currentIndex);
+    emit countChanged(count());
+    
+    return success;
+}
+
+void MissionItemStore::save(QTextStream& stream) const
+{
+    for (int i=0; i<count(); i++) {
+        // Same format as MissionItem::save
+        QString position("%1\t%2\t%3");
+        position = position.arg(_latitude[i], 0, 'g', 18);
+        position = position.arg(_longitude[i], 0, 'g', 18);
+        position = position.arg(_altitude[i], 0, 'g', 18);
+        QString parameters("%1\t%2\t%3\t%4");
+        parameters = parameters.arg(_param1[i], 0, 'g', 18).arg(_param2[i], 0, 'g', 18).arg(_param3[i], 0, 'g', 18).arg(_param4[i], 0, 'g', 18);
+        stream << i << "\t" << (i == _currentIndex) << "\t" << _frame[i] << "\t" << _command[i] << "\t"  << parameters << "\t" << position  << "\t" << _autoContinue[i] << "\r\n";
+    }
+}
+
+int MissionItemStore::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    
+    return count();
+}
+
+QVariant MissionItemStore::data(const QModelIndex& index, int role) const
+{
+    int row = index.row();
+    
+    if (row < 0 || row >= count()) {
+        return QVariant();
+    }
+    
+    switch (role) {
+        case SequenceNumberRole:
+            return row;
+        case CoordinateRole:
+            return QVariant::fromValue(QGeoCoordinate(_latitude[row], _longitude[row], _altitude[row]));
+        case CommandRole:
+            return _command[row];
+        case CommandNameRole:
+            return MissionItem::commandNameForCommand(_command[row]);
+        case SpecifiesCoordinateRole:
+            return MissionItem::commandSpecifiesCoordinate(_command[row]);
+        case IsCurrentItemRole:
+            return row == _currentIndex;
+        default:
+            return QVariant();
+    }
+}
+
+QHash<int, QByteArray> MissionItemStore::roleNames(void) const
+{
+    QHash<int, QByteArray> hash;
+    
+    hash[SequenceNumberRole] =      "sequenceNumber";
+    hash[CoordinateRole] =          "coordinate";
+    hash[CommandRole] =             "command";
+    hash[CommandNameRole] =         "commandName";
+    hash[SpecifiesCoordinateRole] = "specifiesCoordinate";
+    hash[IsCurrentItemRole] =       "isCurrentItem";
+    
+    return hash;
+}
+
+void MissionItemStore::_setValues(int index, const MissionItem& missionItem)
+{
+    _latitude[index] =      missionItem.latitude();
+    _longitude[index] =     missionItem.longitude();
+    _altitude[index] =      missionItem.altitude();
+    _param1[index] =        missionItem.param1();
+    _param2[index] =        missionItem.param2();
+    _param3[index] =        missionItem.param3();
+    _param4[index] =        missionItem.param4();
+    _command[index] =       missionItem.command();
+    _frame[index] =         missionItem.frame();
+    _autoContinue[index] =  missionItem.autoContinue();
+}
+
+void MissionItemStore::_rowChanged(int index)
+{
+    if (index >= 0 && index < count()) {
+        emit dataChanged(this->index(index), this->index(index));
+    }
+}
+
+/// Replaces the editing object to match the current index
+void MissionItemStore::_updateCurrentItem(void)
+{
+    if (_currentItem) {
+        // Qml may still be bound to the previous item
+        _currentItem->deleteLater();
+        _currentItem = NULL;
+    }
+    
+    if (_currentIndex != -1) {
+        _currentItem = createMissionItem(_currentIndex, this);
+        QQmlEngine::setObjectOwnership(_currentItem, QQmlEngine::CppOwnership);
+        
+        connect(_currentItem, &MissionItem::dirtyChanged, this, &MissionItemStore::_currentItemValueChanged);
+        connect(_currentItem, &MissionItem::commandChanged, this, &MissionItemStore::_currentItemValueChanged);
+        connect(_currentItem, &MissionItem::changed, this, &MissionItemStore::_currentItemValueChanged);
+    }
+    
+    emit currentItemChanged(_currentItem);
+}
+
+/// Writes edits made through the current item back to the store
+void MissionItemStore::_currentItemValueChanged(void)
+{
+    if (!_currentItem || _currentIndex == -1) {
+        return;
+    }
+    
+    QGeoCoordinate previousCoordinate = coordinate(_currentIndex);
+    
+    _setValues(_currentIndex, *_currentItem);
+    _rowChanged(_currentIndex);
+    
+    if (coordinate(_currentIndex) != previousCoordinate) {
+        emit coordinateChanged(_currentIndex);
+    }
+    
+    setDirty(true);
+}
@@ -0,0 +1,154 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef MissionItemStore_H
+#define MissionItemStore_H
+
+#include <QAbstractListModel>
+#include <QGeoCoordinate>
+#include <QTextStream>
+#include <QVector>
+
+#include "MissionItem.h"
+#include "QmlObjectListModel.h"
+
+/// @file
+///     @brief Mission item storage for the Mission Editor. The item values are packed into one array per
+///             value instead of one MissionItem object per item, so large missions stay cheap to hold and to
+///             show in QML views. A MissionItem with its Facts is only created for the current item, which
+///             is the one being edited. Changes to it are written back to the store.
+///
+///             Sequence numbers are not stored, an item's sequence number is always its row.
+
+class MissionItemStore : public QAbstractListModel
+{
+    Q_OBJECT
+    
+public:
+    MissionItemStore(QObject* parent = NULL);
+    ~MissionItemStore();
+    
+    Q_PROPERTY(int          count           READ count                                  NOTIFY countChanged)
+    Q_PROPERTY(bool         dirty           READ dirty          WRITE setDirty          NOTIFY dirtyChanged)
+    Q_PROPERTY(int          currentIndex    READ currentIndex   WRITE setCurrentIndex   NOTIFY currentIndexChanged)
+    Q_PROPERTY(MissionItem* currentItem     READ currentItem                            NOTIFY currentItemChanged)
+    
+    Q_INVOKABLE QGeoCoordinate coordinate(int index) const;
+    
+    enum {
+        SequenceNumberRole = Qt::UserRole + 1,
+        CoordinateRole,
+        CommandRole,
+        CommandNameRole,
+        SpecifiesCoordinateRole,
+        IsCurrentItemRole,
+    };
+    
+    // Property accessors
+    
+    int count(void) const { return _command.count(); }
+    
+    bool dirty(void) const { return _dirty; }
+    void setDirty(bool dirty);
+    
+    /// Index of the item being edited, -1 for none
+    int currentIndex(void) const { return _currentIndex; }
+    void setCurrentIndex(int index);
+    
+    /// Editing object for the current item, NULL if there is no current item. Owned by the store and replaced
+    /// whenever the current item changes.
+    MissionItem* currentItem(void) { return _currentItem; }
+    
+    // C++ only methods
+    
+    int command(int index) const { return _command[index]; }
+    
+    /// Replaces all items with copies of the specified MissionItems
+    void setItems(const QmlObjectListModel& missionItems);
+    
+    void clear(void);
+    
+    /// Inserts a copy of missionItem at the specified index
+    void insert(int index, const MissionItem& missionItem);
+    void append(const MissionItem& missionItem) { insert(count(), missionItem); }
+    
+    void removeAt(int index);
+    
+    /// Exchanges two items. The current item stays current at its new position.
+    void swap(int index1, int index2);
+    
+    /// @return New MissionItem with the values of the specified item
+    MissionItem* createMissionItem(int index, QObject* parent = NULL) const;
+    
+    /// @return New list with a MissionItem for each item, caller takes ownership
+    QmlObjectListModel* createObjectList(QObject* parent = NULL) const;
+    
+    /// @return true: All items can be edited in the ui
+    bool canEdit(void) const;
+    
+    /// Replaces all items with the items from a mission file stream, the version line must already have been read
+    ///     @return false: stream is corrupt, store is empty
+    bool load(QTextStream& stream);
+    
+    void save(QTextStream& stream) const;
+    
+signals:
+    void countChanged(int count);
+    void dirtyChanged(bool dirty);
+    void currentIndexChanged(int currentIndex);
+    void currentItemChanged(MissionItem* currentItem);
+    
+    /// Signalled when the coordinate of an existing item changed. Insertions and removals are only signalled
+    /// through the model row signals.
+    void coordinateChanged(int index);
+    
+private slots:
+    void _currentItemValueChanged(void);
+    
+private:
+    // Overrides from QAbstractListModel
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+    virtual QHash<int, QByteArray> roleNames(void) const;
+    
+    void _setValues(int index, const MissionItem& missionItem);
+    void _rowChanged(int index);
+    void _updateCurrentItem(void);
+    
+    QVector<double>     _latitude;
+    QVector<double>     _longitude;
+    QVector<double>     _altitude;
+    QVector<double>     _param1;
+    QVector<double>     _param2;
+    QVector<double>     _param3;
+    QVector<double>     _param4;
+    QVector<quint16>    _command;
+    QVector<quint8>     _frame;
+    QVector<bool>       _autoContinue;
+    
+    bool            _dirty;
+    int             _currentIndex;
+    MissionItem*    _currentItem;
+};
+
+#endif
@@ -475,7 +475,12 @@ void MissionItem::setHoldTime(double holdTime)
 
 bool MissionItem::specifiesCoordinate(void) const
 {
-    switch (_command) {
+    return commandSpecifiesCoordinate(_command);
+}
+
+bool MissionItem::commandSpecifiesCoordinate(int command)
+{
+    switch (command) {
         case MAV_CMD_NAV_WAYPOINT:
         case MAV_CMD_NAV_LOITER_UNLIM:
         case MAV_CMD_NAV_LOITER_TURNS:
@@ -489,10 +494,15 @@ bool MissionItem::specifiesCoordinate(void) const
 }
 
 QString MissionItem::commandName(void)
+{
+    return commandNameForCommand(_command);
+}
+
+QString MissionItem::commandNameForCommand(int command)
 {
     QString type;
     
-    switch (_command) {
+    switch (command) {
         case MAV_CMD_NAV_WAYPOINT:
             type = "Waypoint";
             break;
@@ -517,7 +527,7 @@ QString MissionItem::commandName(void)
             type = "Jump To Command";
             break;
         default:
-            type = QString("Unknown (%1)").arg(_command);
+            type = QString("Unknown (%1)").arg(command);
             break;
     }
     
@@ -801,30 +811,35 @@ void MissionItem::setCoordinate(const QGeoCoordinate& coordinate)
 }
 
 bool MissionItem::canEdit(void)
+{
+    return canEditValues(_command, _frame, _autocontinue);
+}
+
+bool MissionItem::canEditValues(int command, int frame, bool autoContinue)
 {
     bool found = false;
     
     for (int i=0; i<_cMavCmd2Name; i++) {
-        if (_rgMavCmd2Name[i].command == (MAV_CMD)_command) {
+        if (_rgMavCmd2Name[i].command == (MAV_CMD)command) {
             found = true;
             break;
         }
     }
     
     if (found) {
-        if (!_autocontinue) {
+        if (!autoContinue) {
             qCDebug(MissionItemLog) << "canEdit false due to _autocontinue != true";
             return false;
         }
         
-        if (_frame != MAV_FRAME_GLOBAL && _frame != MAV_FRAME_GLOBAL_RELATIVE_ALT && _frame != MAV_FRAME_MISSION) {
-            qCDebug(MissionItemLog) << "canEdit false due unsupported frame type:" << _frame;
+        if (frame != MAV_FRAME_GLOBAL && frame != MAV_FRAME_GLOBAL_RELATIVE_ALT && frame != MAV_FRAME_MISSION) {
+            qCDebug(MissionItemLog) << "canEdit false due unsupported frame type:" << frame;
             return false;
         }
         
         return true;
     } else {
-        qCDebug(MissionItemLog) << "canEdit false due unsupported command:" << _command;
+        qCDebug(MissionItemLog) << "canEdit false due unsupported command:" << command;
         return false;
     }
 }
@@ -115,6 +115,15 @@ public:
     
     /// Returns true if this item can be edited in the ui
     bool canEdit(void);
+    
+    /// Returns true if an item with the specified values can be edited in the ui
+    static bool canEditValues(int command, int frame, bool autoContinue);
+    
+    /// Returns the name shown in the ui for the specified MAV_CMD
+    static QString commandNameForCommand(int command);
+    
+    /// Returns true if the specified MAV_CMD uses the item coordinate
+    static bool commandSpecifiesCoordinate(int command);
 
     double latitude(void)  const { return _latitudeFact->value().toDouble(); }
     double longitude(void) const { return _longitudeFact->value().toDouble(); }
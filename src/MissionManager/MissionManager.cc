@@ -27,15 +27,34 @@
 #include "MissionManager.h"
 #include "Vehicle.h"
 #include "MAVLinkProtocol.h"
+#include "QGCApplication.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QCryptographicHash>
 
 QGC_LOGGING_CATEGORY(MissionManagerLog, "MissionManagerLog")
 
+QString MissionManager::_cacheDirectory;
+
+static const quint32 _cacheMagic = 0x4D495353;   // "MISS"
+static const quint32 _cacheVersion = 1;
+
 MissionManager::MissionManager(Vehicle* vehicle)
     : _vehicle(vehicle)
     , _cMissionItems(0)
     , _canEdit(true)
     , _ackTimeoutTimer(NULL)
     , _retryAck(AckNone)
+    , _ackSentMsecs(0)
+    , _rtoMsecs(_ackTimeoutMilliseconds)
+    , _srttMsecs(-1)
+    , _rttVarMsecs(0)
+    , _readErrorCode(AckTimeoutError)
+    , _validatingCache(false)
 {
     connect(_vehicle, &Vehicle::mavlinkMessageReceived, this, &MissionManager::_mavlinkMessageReceived);
     
@@ -45,7 +64,9 @@ MissionManager::MissionManager(Vehicle* vehicle)
     
     connect(_ackTimeoutTimer, &QTimer::timeout, this, &MissionManager::_ackTimeout);
     
-    requestMissionItems();
+    _transferClock.start();
+    
+    // The initial mission items are requested by Vehicle::startInitialSync
 }
 
 MissionManager::~MissionManager()
@@ -123,14 +144,47 @@ void MissionManager::requestMissionItems(void)
     emit inProgressChanged(true);
 }
 
+void MissionManager::syncMissionItems(void)
+{
+    if (inProgress()) {
+        qCDebug(MissionManagerLog) << "syncMissionItems called while transaction in progress";
+        return;
+    }
+    
+    if (!_loadCache()) {
+        requestMissionItems();
+        return;
+    }
+    
+    qCDebug(MissionManagerLog) << "syncMissionItems showing cached items:" << _cacheItems.count();
+    
+    requestMissionItems();
+    _validatingCache = true;
+    
+    // Show the cached mission while it is being validated
+    for (int i=0; i<_cacheItems.count(); i++) {
+        MissionItem* item = _missionItemFromMavlink(_cacheItems[i]);
+        _missionItems.append(item);
+        
+        if (!item->canEdit() && _canEdit) {
+            _canEdit = false;
+            emit canEditChanged(false);
+        }
+    }
+    emit newMissionItemsAvailable();
+}
+
 void MissionManager::_retryRead(void)
 {
-    qCDebug(MissionManagerLog) << "_retryRead";
+    qCDebug(MissionManagerLog) << "_retryRead items already received:" << _readItems.count();
     
     mavlink_message_t               message;
     mavlink_mission_request_list_t  request;
     
-    _clearMissionItems();
+    // Items which have already been received are kept, once MISSION_COUNT arrives only the missing items
+    // are requested again
+    _readRequests.clear();
+    _readQueue.clear();
     
     request.target_system = _vehicle->id();
     request.target_component = MAV_COMP_ID_MISSIONPLANNER;
@@ -143,6 +197,12 @@ void MissionManager::_retryRead(void)
 
 void MissionManager::_ackTimeout(void)
 {
+    if (_retryAck == AckMissionItem) {
+        // Read requests are pipelined and time out individually
+        _readTimeout();
+        return;
+    }
+    
     AckType_t timedOutAck = _retryAck;
     
     _retryAck = AckNone;
@@ -162,7 +222,8 @@ void MissionManager::_ackTimeout(void)
 void MissionManager::_startAckTimeout(AckType_t ack)
 {
     _retryAck = ack;
-    _ackTimeoutTimer->start();
+    _ackSentMsecs = _transferClock.elapsed();
+    _ackTimeoutTimer->start(_retransmitTimeoutMsecs(_retryCount));
 }
 
 bool MissionManager::_stopAckTimeout(AckType_t expectedAck)
@@ -182,12 +243,39 @@ bool MissionManager::_stopAckTimeout(AckType_t expectedAck)
         }
         success = false;
     } else {
+        // Round trips are only measured before any retry, a response to a retried message is ambiguous. Pipelined
+        // item reads are measured per request.
+        if (_retryCount == 0 && savedRetryAck != AckMissionItem) {
+            _updateRtt(_transferClock.elapsed() - _ackSentMsecs);
+        }
         success = true;
     }
     
     return success;
 }
 
+/// Smoothed round trip estimate (RFC 6298) which the response timeouts are derived from
+void MissionManager::_updateRtt(qint64 rttMsecs)
+{
+    int rtt = (int)rttMsecs;
+    
+    if (_srttMsecs == -1) {
+        _srttMsecs = rtt;
+        _rttVarMsecs = rtt / 2;
+    } else {
+        _rttVarMsecs = (3 * _rttVarMsecs + qAbs(_srttMsecs - rtt)) / 4;
+        _srttMsecs = (7 * _srttMsecs + rtt) / 8;
+    }
+    
+    _rtoMsecs = qBound((int)_minAckTimeoutMsecs, _srttMsecs + 4 * _rttVarMsecs, (int)_ackTimeoutMilliseconds);
+}
+
+/// @return Timeout for a message which has been retried retryCount times, doubling with each retry
+int MissionManager::_retransmitTimeoutMsecs(int retryCount)
+{
+    return qMin(_rtoMsecs << qMin(retryCount, 4), (int)_ackTimeoutMilliseconds);
+}
+
 void MissionManager::_sendTransactionComplete(void)
 {
     qCDebug(MissionManagerLog) << "_sendTransactionComplete read sequence complete";
@@ -217,23 +305,62 @@ void MissionManager::_handleMissionCount(const mavlink_message_t& message)
     
     mavlink_msg_mission_count_decode(&message, &missionCount);
     
+    if (missionCount.count != _cMissionItems) {
+        // Only items from the same mission can be kept across a retry
+        _readItems.clear();
+    }
     _cMissionItems = missionCount.count;
     qCDebug(MissionManagerLog) << "_handleMissionCount count:" << _cMissionItems;
     
+    if (_validatingCache && _cMissionItems != _cacheItems.count()) {
+        qCDebug(MissionManagerLog) << "_handleMissionCount cache count mismatch, full download";
+        _validatingCache = false;
+    }
+    
     if (_cMissionItems == 0) {
+        _missionItems.clear();
+        _saveCache(QList<mavlink_mission_item_t>());
         emit newMissionItemsAvailable();
         emit inProgressChanged(false);
     } else {
-        _requestNextMissionItem(0);
+        _readQueue.clear();
+        for (int i=0; i<_cMissionItems; i++) {
+            if (!_readItems.contains(i)) {
+                _readQueue.append(i);
+            }
+        }
+        
+        _retryAck = AckMissionItem;
+        _sendReadRequests();
+        if (_readRequests.isEmpty()) {
+            // Everything was already received before the retry
+            _readComplete();
+        } else {
+            _startReadTimeout();
+        }
     }
 }
 
-void MissionManager::_requestNextMissionItem(int sequenceNumber)
+/// Fills the read window with requests from the queue
+void MissionManager::_sendReadRequests(void)
 {
-    qCDebug(MissionManagerLog) << "_requestNextMissionItem sequenceNumber:" << sequenceNumber;
+    while (_readRequests.count() < _readWindowSize && !_readQueue.isEmpty()) {
+        int sequenceNumber = _readQueue.takeFirst();
+        
+        ReadRequest_t request;
+        request.retryCount = 0;
+        _readRequests[sequenceNumber] = request;
+        
+        _requestMissionItem(sequenceNumber);
+    }
+}
+
+void MissionManager::_requestMissionItem(int sequenceNumber)
+{
+    qCDebug(MissionManagerLog) << "_requestMissionItem sequenceNumber:" << sequenceNumber;
     
     if (sequenceNumber >= _cMissionItems) {
-        qCWarning(MissionManagerLog) << "_requestNextMissionItem requested seqeuence number > item count sequenceNumber::_cMissionItems" << sequenceNumber << _cMissionItems;
+        qCWarning(MissionManagerLog) << "_requestMissionItem requested seqeuence number > item count sequenceNumber::_cMissionItems" << sequenceNumber << _cMissionItems;
         _sendError(InternalError, QString("QGroundControl requested mission item outside of range (internal error): %1:%2").arg(sequenceNumber).arg(_cMissionItems));
         return;
     }
@@ -244,64 +371,214 @@ void MissionManager::_requestNextMissionItem(int sequenceNumber)
     missionRequest.target_system =      _vehicle->id();
     missionRequest.target_component =   MAV_COMP_ID_MISSIONPLANNER;
     missionRequest.seq =                sequenceNumber;
-    _expectedSequenceNumber =           sequenceNumber;
     
     mavlink_msg_mission_request_encode(MAVLinkProtocol::instance()->getSystemId(), MAVLinkProtocol::instance()->getComponentId(), &message, &missionRequest);
     
+    ReadRequest_t& request = _readRequests[sequenceNumber];
+    request.sentMsecs = _transferClock.elapsed();
+    request.deadlineMsecs = request.sentMsecs + _retransmitTimeoutMsecs(request.retryCount);
+    
     _vehicle->sendMessage(message);
-    _startAckTimeout(AckMissionItem);
+}
+
+/// Runs the timer until the earliest read request deadline
+void MissionManager::_startReadTimeout(void)
+{
+    qint64 earliestDeadlineMsecs = -1;
+    
+    foreach (const ReadRequest_t& request, _readRequests) {
+        if (earliestDeadlineMsecs == -1 || request.deadlineMsecs < earliestDeadlineMsecs) {
+            earliestDeadlineMsecs = request.deadlineMsecs;
+        }
+    }
+    
+    _retryAck = AckMissionItem;
+    _ackTimeoutTimer->start(qMax((qint64)0, earliestDeadlineMsecs - _transferClock.elapsed()));
+}
+
+void MissionManager::_readTimeout(void)
+{
+    qint64 nowMsecs = _transferClock.elapsed();
+    
+    foreach (int sequenceNumber, _readRequests.keys()) {
+        ReadRequest_t& request = _readRequests[sequenceNumber];
+        
+        if (request.deadlineMsecs > nowMsecs) {
+            continue;
+        }
+        
+        if (request.retryCount >= _maxRetryCount) {
+            qCDebug(MissionManagerLog) << "_readTimeout failed after max retries sequenceNumber" << sequenceNumber;
+            if (_readErrorCode == AckTimeoutError) {
+                _readErrorMsg = QString("Vehicle did not respond to mission item communication: %1").arg(_ackTypeToString(AckMissionItem));
+            }
+            _readFailed(_readErrorCode, _readErrorMsg);
+            return;
+        }
+        
+        qCDebug(MissionManagerLog) << "_readTimeout retrying sequenceNumber:retryCount" << sequenceNumber << request.retryCount;
+        request.retryCount++;
+        _requestMissionItem(sequenceNumber);
+    }
+    
+    _startReadTimeout();
 }
 
 void MissionManager::_handleMissionItem(const mavlink_message_t& message)
 {
     mavlink_mission_item_t missionItem;
     
-    if (!_stopAckTimeout(AckMissionItem)) {
+    mavlink_msg_mission_item_decode(&message, &missionItem);
+    
+    qCDebug(MissionManagerLog) << "_handleMissionItem sequenceNumber:" << missionItem.seq;
+    
+    if (_retryAck == AckMissionCount && _cMissionItems != 0) {
+        // Responses to pipelined requests which were still in flight when the read was restarted
+        qCDebug(MissionManagerLog) << "_handleMissionItem ignoring item from before read retry";
         return;
     }
     
-    mavlink_msg_mission_item_decode(&message, &missionItem);
+    if (_retryAck != AckMissionItem) {
+        _stopAckTimeout(AckMissionItem);
+        return;
+    }
     
-    qCDebug(MissionManagerLog) << "_handleMissionItem sequenceNumber:" << missionItem.seq;
+    if (!_readRequests.contains(missionItem.seq)) {
+        // Either a duplicate, or the vehicle answered a request with the wrong item. The request stays
+        // outstanding and is retried if the correct item never arrives.
+        qCDebug(MissionManagerLog) << "_handleMissionItem mission item not outstanding:" << missionItem.seq;
+        _readErrorCode = ItemMismatchError;
+        _readErrorMsg = QString("Vehicle returned incorrect mission item: %1").arg(missionItem.seq);
+        return;
+    }
+    
+    ReadRequest_t request = _readRequests.take(missionItem.seq);
+    if (request.retryCount == 0) {
+        _updateRtt(_transferClock.elapsed() - request.sentMsecs);
+    }
+    _readItems[missionItem.seq] = missionItem;
+    
+    _sendReadRequests();
+    if (_readRequests.isEmpty()) {
+        _readComplete();
+    } else {
+        _startReadTimeout();
+    }
+}
+
+/// Called when all queued read requests have been answered
+void MissionManager::_readComplete(void)
+{
+    _retryAck = AckNone;
+    _ackTimeoutTimer->stop();
     
-    if (missionItem.seq != _expectedSequenceNumber) {
-        qCDebug(MissionManagerLog) << "_handleMissionItem mission item received out of sequence expected:actual" << _expectedSequenceNumber << missionItem.seq;
-        if (!_retrySequence(AckMissionItem)) {
-            _sendError(ItemMismatchError, QString("Vehicle returned incorrect mission item: %1:%2").arg(_expectedSequenceNumber).arg(missionItem.seq));
+    if (_validatingCache) {
+        _validatingCache = false;
+        
+        bool cacheValid = true;
+        for (int i=0; i<_cMissionItems; i++) {
+            if (!_itemsMatch(_readItems[i], _cacheItems[i])) {
+                cacheValid = false;
+                break;
+            }
         }
-        return;
+        
+        if (cacheValid) {
+            // The cached items are already shown
+            qCDebug(MissionManagerLog) << "_readComplete cache matches vehicle";
+            _sendTransactionComplete();
+            return;
+        }
+        
+        qCDebug(MissionManagerLog) << "_readComplete cache does not match vehicle, replacing cached items";
     }
+    
+    _setMissionItemsFromRead(false);
+    _saveCache(_readItems.values());
+    _sendTransactionComplete();
+}
+
+/// Ends a read which ran out of retries, the items received in sequence up to the failure are kept
+void MissionManager::_readFailed(ErrorCode_t errorCode, const QString& errorMsg)
+{
+    _retryAck = AckNone;
+    _ackTimeoutTimer->stop();
+    _readRequests.clear();
+    _readQueue.clear();
+    _validatingCache = false;
+    
+    _setMissionItemsFromRead(true);
+    emit newMissionItemsAvailable();
+    _sendError(errorCode, errorMsg);
+}
+
+/// Replaces the mission items with the items received by the read
+///     @param prefixOnly true: Only use the items up to the first missing one
+void MissionManager::_setMissionItemsFromRead(bool prefixOnly)
+{
+    _missionItems.clear();
+    
+    for (int i=0; i<_cMissionItems; i++) {
+        if (!_readItems.contains(i)) {
+            Q_ASSERT(prefixOnly);
+            break;
+        }
         
-    MissionItem* item = new MissionItem(this,
-                                        missionItem.seq,
-                                        QGeoCoordinate(missionItem.x, missionItem.y, missionItem.z),
-                                        missionItem.command,
-                                        missionItem.param1,
-                                        missionItem.param2,
-                                        missionItem.param3,
-                                        missionItem.param4,
-                                        missionItem.autocontinue,
-                                        missionItem.current,
-                                        missionItem.frame);
-    _missionItems.append(item);
-    
-    if (!item->canEdit()) {
-        _canEdit = false;
-        emit canEditChanged(false);
-    }
-    
-    int nextSequenceNumber = missionItem.seq + 1;
-    if (nextSequenceNumber == _cMissionItems) {
-        _sendTransactionComplete();
-    } else {
-        _requestNextMissionItem(nextSequenceNumber);
+        MissionItem* item = _missionItemFromMavlink(_readItems[i]);
+        _missionItems.append(item);
+        
+        if (!item->canEdit() && _canEdit) {
+            _canEdit = false;
+            emit canEditChanged(false);
+        }
     }
 }
 
+MissionItem* MissionManager::_missionItemFromMavlink(const mavlink_mission_item_t& missionItem)
+{
+    return new MissionItem(this,
+                           missionItem.seq,
+                           QGeoCoordinate(missionItem.x, missionItem.y, missionItem.z),
+                           missionItem.command,
+                           missionItem.param1,
+                           missionItem.param2,
+                           missionItem.param3,
+                           missionItem.param4,
+                           missionItem.autocontinue,
+                           missionItem.current,
+                           missionItem.frame);
+}
+
+void MissionManager::_mavlinkFromMissionItem(int sequenceNumber, mavlink_mission_item_t* missionItem)
+{
+    MissionItem* item = (MissionItem*)_missionItems[sequenceNumber];
+    
+    missionItem->target_system =     _vehicle->id();
+    missionItem->target_component =  MAV_COMP_ID_MISSIONPLANNER;
+    missionItem->seq =               sequenceNumber;
+    missionItem->command =           item->command();
+    missionItem->x =                 item->coordinate().latitude();
+    missionItem->y =                 item->coordinate().longitude();
+    missionItem->z =                 item->coordinate().altitude();
+    missionItem->param1 =            item->param1();
+    missionItem->param2 =            item->param2();
+    missionItem->param3 =            item->param3();
+    missionItem->param4 =            item->param4();
+    missionItem->frame =             item->frame();
+    missionItem->current =           sequenceNumber == 0;
+    missionItem->autocontinue =      item->autoContinue();
+}
+
 void MissionManager::_clearMissionItems(void)
 {
     _cMissionItems = 0;
     _missionItems.clear();
+    _readItems.clear();
+    _readRequests.clear();
+    _readQueue.clear();
+    _readErrorCode = AckTimeoutError;
+    _readErrorMsg.clear();
+    _validatingCache = false;
 }
 
 void MissionManager::_handleMissionRequest(const mavlink_message_t& message)
@@ -330,22 +607,7 @@ void MissionManager::_handleMissionRequest(const mavlink_message_t& message)
     mavlink_message_t       messageOut;
     mavlink_mission_item_t  missionItem;
     
-    MissionItem* item = (MissionItem*)_missionItems[missionRequest.seq];
-    
-    missionItem.target_system =     _vehicle->id();
-    missionItem.target_component =  MAV_COMP_ID_MISSIONPLANNER;
-    missionItem.seq =               missionRequest.seq;
-    missionItem.command =           item->command();
-    missionItem.x =                 item->coordinate().latitude();
-    missionItem.y =                 item->coordinate().longitude();
-    missionItem.z =                 item->coordinate().altitude();
-    missionItem.param1 =            item->param1();
-    missionItem.param2 =            item->param2();
-    missionItem.param3 =            item->param3();
-    missionItem.param4 =            item->param4();
-    missionItem.frame =             item->frame();
-    missionItem.current =           missionRequest.seq == 0;
-    missionItem.autocontinue =      item->autoContinue();
+    _mavlinkFromMissionItem(missionRequest.seq, &missionItem);
     
     mavlink_msg_mission_item_encode(MAVLinkProtocol::instance()->getSystemId(), MAVLinkProtocol::instance()->getComponentId(), &messageOut, &missionItem);
     
@@ -386,10 +648,13 @@ void MissionManager::_handleMissionAck(const mavlink_message_t& message)
             }
             break;
         case AckMissionItem:
-            // MISSION_ITEM expected
+            // MISSION_ITEM expected. The vehicle may have dropped out of the read sequence, so it is restarted
+            // keeping the items received so far.
             qCDebug(MissionManagerLog) << "_handleMissionAck vehicle sent ack when MISSION_ITEM expected: error:" << missionAck.type;
+            _readErrorCode = VehicleError;
+            _readErrorMsg = QString("Vehicle returned error: %1. Partial list of mission items may have been returned.").arg(_missionResultToString((MAV_MISSION_RESULT)missionAck.type));
             if (!_retrySequence(AckMissionItem)) {
-                _sendError(VehicleError, QString("Vehicle returned error: %1. Partial list of mission items may have been returned.").arg(_missionResultToString((MAV_MISSION_RESULT)missionAck.type)));
+                _sendError(VehicleError, _readErrorMsg);
             }
             break;
         case AckMissionRequest:
@@ -397,6 +662,15 @@ void MissionManager::_handleMissionAck(const mavlink_message_t& message)
             if (missionAck.type == MAV_MISSION_ACCEPTED) {
                 if (_expectedSequenceNumber == _missionItems.count()) {
                     qCDebug(MissionManagerLog) << "_handleMissionAck write sequence complete";
+                    
+                    QList<mavlink_mission_item_t> items;
+                    for (int i=0; i<_missionItems.count(); i++) {
+                        mavlink_mission_item_t missionItem;
+                        _mavlinkFromMissionItem(i, &missionItem);
+                        items.append(missionItem);
+                    }
+                    _saveCache(items);
+                    
                     emit inProgressChanged(false);
                 } else {
                     qCDebug(MissionManagerLog) << "_handleMissionAck vehicle did not reqeust all items: _expectedSequenceNumber:_missionItems.count" << _expectedSequenceNumber << _missionItems.count();
@@ -471,11 +745,15 @@ bool MissionManager::_retrySequence(AckType_t ackType)
         case AckMissionCount:
         case AckMissionItem:
             if (++_retryCount <= _maxRetryCount) {
-                // We are in the middle of a read sequence, start over
+                // We are in the middle of a read sequence, start over keeping what we have
                 _retryRead();
                 return true;
             } else {
                 // Read sequence failed, signal for what we have up to this point
+                _readRequests.clear();
+                _readQueue.clear();
+                _validatingCache = false;
+                _setMissionItemsFromRead(true);
                 emit newMissionItemsAvailable();
                 return false;
             }
@@ -496,6 +774,130 @@ bool MissionManager::_retrySequence(AckType_t ackType)
     }
 }
 
+QString MissionManager::cacheDirectory(void)
+{
+    if (!_cacheDirectory.isEmpty()) {
+        return _cacheDirectory;
+    }
+    
+    // Unit tests must not pick up a cache left behind by a previous run
+    if (qgcApp()->runningUnitTests()) {
+        return QString();
+    }
+    
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).absoluteFilePath("MissionCache");
+}
+
+QString MissionManager::_cacheFilename(void)
+{
+    QString directory = cacheDirectory();
+    
+    if (directory.isEmpty()) {
+        return QString();
+    }
+    
+    return QDir(directory).absoluteFilePath(QString("Vehicle%1.mission").arg(_vehicle->id()));
+}
+
+/// Loads the cache for this vehicle into _cacheItems
+///     @return false: No usable cache
+bool MissionManager::_loadCache(void)
+{
+    _cacheItems.clear();
+    
+    QString filename = _cacheFilename();
+    if (filename.isEmpty()) {
+        return false;
+    }
+    
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    QDataStream stream(&file);
+    quint32     magic, version, count;
+    QByteArray  hash;
+    
+    stream >> magic >> version >> count >> hash;
+    if (stream.status() != QDataStream::Ok || magic != _cacheMagic || version != _cacheVersion || count == 0) {
+        qCDebug(MissionManagerLog) << "_loadCache ignoring invalid cache" << filename;
+        return false;
+    }
+    
+    QByteArray itemBytes = file.readAll();
+    if (QCryptographicHash::hash(itemBytes, QCryptographicHash::Sha1) != hash) {
+        qCWarning(MissionManagerLog) << "_loadCache content hash mismatch" << filename;
+        return false;
+    }
+    
+    QDataStream itemStream(itemBytes);
+    for (quint32 i=0; i<count; i++) {
+        mavlink_mission_item_t item;
+        
+        memset(&item, 0, sizeof(item));
+        itemStream >> item.seq >> item.frame >> item.command >> item.current >> item.autocontinue
+                   >> item.param1 >> item.param2 >> item.param3 >> item.param4 >> item.x >> item.y >> item.z;
+        _cacheItems.append(item);
+    }
+    if (itemStream.status() != QDataStream::Ok) {
+        _cacheItems.clear();
+        return false;
+    }
+    
+    return true;
+}
+
+/// Saves the mission currently on the vehicle to the cache
+void MissionManager::_saveCache(const QList<mavlink_mission_item_t>& items)
+{
+    QString filename = _cacheFilename();
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    if (items.isEmpty()) {
+        QFile::remove(filename);
+        return;
+    }
+    
+    QByteArray itemBytes;
+    QDataStream itemStream(&itemBytes, QIODevice::WriteOnly);
+    foreach (const mavlink_mission_item_t& item, items) {
+        itemStream << item.seq << item.frame << item.command << item.current << item.autocontinue
+                   << item.param1 << item.param2 << item.param3 << item.param4 << item.x << item.y << item.z;
+    }
+    
+    QDir().mkpath(QFileInfo(filename).absolutePath());
+    
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(MissionManagerLog) << "_saveCache unable to open" << filename << file.errorString();
+        return;
+    }
+    
+    QDataStream stream(&file);
+    stream << _cacheMagic << _cacheVersion << (quint32)items.count() << QCryptographicHash::hash(itemBytes, QCryptographicHash::Sha1);
+    file.write(itemBytes);
+}
+
+/// @return true: The items describe the same mission item. The current flag is ignored since it changes as the
+/// mission runs.
+bool MissionManager::_itemsMatch(const mavlink_mission_item_t& item1, const mavlink_mission_item_t& item2)
+{
+    return item1.seq == item2.seq &&
+            item1.frame == item2.frame &&
+            item1.command == item2.command &&
+            item1.autocontinue == item2.autocontinue &&
+            item1.param1 == item2.param1 &&
+            item1.param2 == item2.param2 &&
+            item1.param3 == item2.param3 &&
+            item1.param4 == item2.param4 &&
+            item1.x == item2.x &&
+            item1.y == item2.y &&
+            item1.z == item2.z;
+}
+
 QString MissionManager::_ackTypeToString(AckType_t ackType)
 {
     switch (ackType) {
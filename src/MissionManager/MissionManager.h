@@ -29,6 +29,9 @@
 #include <QThread>
 #include <QMutex>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QList>
 
 #include "QmlObjectListModel.h"
 #include "QGCMAVLink.h"
@@ -61,6 +64,19 @@ public:
     
     void requestMissionItems(void);
     
+    /// Shows the cached mission for this vehicle right away while the full mission is downloaded. Every item is
+    /// compared against the cache once the download completes and the shown items are only replaced if the
+    /// vehicle's mission differs. Falls back to requestMissionItems if there is no cache.
+    void syncMissionItems(void);
+    
+    /// Directory the per vehicle mission cache is kept in. Defaults to MissionCache in the cache location. The
+    /// cache is disabled when running unit tests unless a test sets a directory.
+    static QString cacheDirectory(void);
+    static void setCacheDirectory(const QString& directory) { _cacheDirectory = directory; }
+    
+    /// Current timeout for a response from the vehicle, derived from measured round trips
+    int ackTimeoutMsecs(void) { return _rtoMsecs; }
+    
     /// Writes the specified set of mission items to the vehicle
     void writeMissionItems(const QmlObjectListModel& missionItems);
     
@@ -80,8 +96,10 @@ public:
     } ErrorCode_t;
 
     // These values are public so the unit test can set appropriate signal wait times
-    static const int _ackTimeoutMilliseconds= 2000;
+    static const int _ackTimeoutMilliseconds= 2000;     ///< Upper bound for the adaptive timeout, also used until a round trip is measured
     static const int _maxRetryCount = 5;
+    static const int _minAckTimeoutMsecs = 300;
+    static const int _readWindowSize = 4;               ///< Number of MISSION_REQUESTs in flight during a read
     
 signals:
     // Public signals
@@ -109,8 +127,22 @@ private:
     void _handleMissionItem(const mavlink_message_t& message);
     void _handleMissionRequest(const mavlink_message_t& message);
     void _handleMissionAck(const mavlink_message_t& message);
-    void _requestNextMissionItem(int sequenceNumber);
+    void _requestMissionItem(int sequenceNumber);
+    void _sendReadRequests(void);
+    void _startReadTimeout(void);
+    void _readTimeout(void);
+    void _readComplete(void);
+    void _readFailed(ErrorCode_t errorCode, const QString& errorMsg);
+    void _setMissionItemsFromRead(bool prefixOnly);
     void _clearMissionItems(void);
+    void _updateRtt(qint64 rttMsecs);
+    int _retransmitTimeoutMsecs(int retryCount);
+    MissionItem* _missionItemFromMavlink(const mavlink_mission_item_t& missionItem);
+    void _mavlinkFromMissionItem(int sequenceNumber, mavlink_mission_item_t* missionItem);
+    QString _cacheFilename(void);
+    bool _loadCache(void);
+    void _saveCache(const QList<mavlink_mission_item_t>& items);
+    static bool _itemsMatch(const mavlink_mission_item_t& item1, const mavlink_mission_item_t& item2);
     void _sendError(ErrorCode_t errorCode, const QString& errorMsg);
     void _retryWrite(void);
     void _retryRead(void);
@@ -130,6 +162,30 @@ private:
     
     int                 _expectedSequenceNumber;
     
+    QElapsedTimer       _transferClock;         ///< Time base for round trip measurements
+    qint64              _ackSentMsecs;          ///< Time the message which _retryAck responds to was sent
+    int                 _rtoMsecs;
+    int                 _srttMsecs;             ///< -1 until a round trip has been measured
+    int                 _rttVarMsecs;
+    
+    /// A MISSION_REQUEST in flight during a read
+    typedef struct {
+        qint64  sentMsecs;
+        qint64  deadlineMsecs;
+        int     retryCount;
+    } ReadRequest_t;
+    
+    QMap<int, ReadRequest_t>                _readRequests;      ///< Keyed by sequence number
+    QList<int>                              _readQueue;         ///< Sequence numbers still to be requested
+    QMap<int, mavlink_mission_item_t>       _readItems;         ///< Items received so far, kept across retries
+    ErrorCode_t                             _readErrorCode;     ///< Reason reported if the read runs out of retries
+    QString                                 _readErrorMsg;
+    
+    bool                                    _validatingCache;   ///< true: Cached items are shown, compare them when the read completes
+    QList<mavlink_mission_item_t>           _cacheItems;
+    
+    static QString _cacheDirectory;
+    
     QMutex _dataMutex;
     
     QmlObjectListModel  _missionItems;
@@ -25,6 +25,8 @@
 #include "LinkManager.h"
 #include "MultiVehicleManager.h"
 
+#include <QDir>
+
 UT_REGISTER_TEST(MissionManagerTest)
 
 const MissionManagerTest::TestCase_t MissionManagerTest::_rgTestCases[] = {
@@ -62,9 +64,15 @@ void MissionManagerTest::init(void)
     QSignalSpy spyVehicle(MultiVehicleManager::instance(), SIGNAL(activeVehicleChanged(Vehicle*)));
     QCOMPARE(spyVehicle.wait(5000), true);
     
-    // Wait for the Mission Manager to finish it's initial load
+    // Wait for the initial parameter and mission load to complete
+    
+    Vehicle* vehicle = MultiVehicleManager::instance()->activeVehicle();
+    if (!vehicle->initialSyncComplete()) {
+        QSignalSpy spyInitialSync(vehicle, SIGNAL(initialSyncCompleteChanged(bool)));
+        QCOMPARE(spyInitialSync.wait(_initialSyncWaitTime), true);
+    }
     
-    _missionManager = MultiVehicleManager::instance()->activeVehicle()->missionManager();
+    _missionManager = vehicle->missionManager();
     QVERIFY(_missionManager);
     
     _rgSignals[canEditChangedSignalIndex] =             SIGNAL(canEditChanged(bool));
@@ -97,6 +105,8 @@ void MissionManagerTest::cleanup(void)
     _mockLink = NULL;
     QTest::qWait(1000); // Need to allow signals to move between threads
     
+    MissionManager::setCacheDirectory(QString());
+    
     UnitTest::cleanup();
 }
 
@@ -397,3 +407,74 @@ void MissionManagerTest::_testReadFailureHandling(void)
         _mockLink->resetMissionItemHandler();
     }
 }
+
+void MissionManagerTest::_testMissionCache(void)
+{
+    QDir cacheDir(QDir::temp().absoluteFilePath("MissionManagerTestCache"));
+    cacheDir.removeRecursively();
+    MissionManager::setCacheDirectory(cacheDir.absolutePath());
+    
+    int cMissionItems = (int)(sizeof(_rgTestCases)/sizeof(_rgTestCases[0]));
+    
+    // A successful write caches the mission
+    _writeItems(MockLinkMissionItemHandler::FailNone, MissionManager::InternalError, false);
+    
+    _missionManager->syncMissionItems();
+    
+    // The cached items are available before the vehicle has responded
+    QVERIFY(_missionManager->inProgress());
+    QCOMPARE(_multiSpy->checkOnlySignalByMask(inProgressChangedSignalMask | newMissionItemsAvailableSignalMask), true);
+    _checkInProgressValues(true);
+    QCOMPARE(_missionManager->missionItems()->count(), cMissionItems);
+    _multiSpy->clearAllSignals();
+    
+    _multiSpy->waitForSignalByIndex(inProgressChangedSignalIndex, _signalWaitTime);
+    QCOMPARE(_multiSpy->checkSignalByMask(newMissionItemsAvailableSignalMask | inProgressChangedSignalMask), true);
+    QCOMPARE(_multiSpy->checkNoSignalByMask(errorSignalMask), true);
+    _checkInProgressValues(false);
+    QCOMPARE(_missionManager->missionItems()->count(), cMissionItems);
+    _multiSpy->clearAllSignals();
+    
+    // An item in the middle of the mission changes on the vehicle. Every item is compared, so the cached
+    // mission must be replaced by the vehicle's.
+    const double changedParam1 = 99.0;
+    _mockLink->setMissionItemParam1(1, changedParam1);
+    
+    _missionManager->syncMissionItems();
+    QVERIFY(_missionManager->inProgress());
+    MissionItem* item = qobject_cast<MissionItem*>(_missionManager->missionItems()->get(1));
+    QCOMPARE(item->param1(), _rgTestCases[1].expectedItem.param1);
+    _multiSpy->clearAllSignals();
+    
+    _multiSpy->waitForSignalByIndex(inProgressChangedSignalIndex, _signalWaitTime);
+    QCOMPARE(_multiSpy->checkNoSignalByMask(errorSignalMask), true);
+    _checkInProgressValues(false);
+    QCOMPARE(_missionManager->missionItems()->count(), cMissionItems);
+    item = qobject_cast<MissionItem*>(_missionManager->missionItems()->get(1));
+    QCOMPARE(item->param1(), changedParam1);
+    _multiSpy->clearAllSignals();
+    
+    // The cache now holds the changed mission
+    _missionManager->syncMissionItems();
+    item = qobject_cast<MissionItem*>(_missionManager->missionItems()->get(1));
+    QCOMPARE(item->param1(), changedParam1);
+    _multiSpy->clearAllSignals();
+    _multiSpy->waitForSignalByIndex(inProgressChangedSignalIndex, _signalWaitTime);
+    QCOMPARE(_multiSpy->checkNoSignalByMask(errorSignalMask), true);
+    _multiSpy->clearAllSignals();
+    
+    // Vehicle no longer has the mission, the cached items must be replaced
+    _mockLink->resetMissionItemHandler();
+    
+    _missionManager->syncMissionItems();
+    QVERIFY(_missionManager->inProgress());
+    _multiSpy->clearAllSignals();
+    
+    _multiSpy->waitForSignalByIndex(inProgressChangedSignalIndex, _signalWaitTime);
+    QCOMPARE(_multiSpy->checkNoSignalByMask(errorSignalMask), true);
+    _checkInProgressValues(false);
+    QCOMPARE(_missionManager->missionItems()->count(), 0);
+    QVERIFY(!QFile::exists(cacheDir.absoluteFilePath(QString("Vehicle%1.mission").arg(_mockLink->vehicleId()))));
+    
+    cacheDir.removeRecursively();
+}
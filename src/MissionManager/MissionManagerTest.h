@@ -44,6 +44,7 @@ private slots:
     
     void _testWriteFailureHandling(void);
     void _testReadFailureHandling(void);
+    void _testMissionCache(void);
     
 private:
     void _checkInProgressValues(bool inProgress);
@@ -94,6 +95,7 @@ private:
 
     static const TestCase_t _rgTestCases[];
     static const int        _signalWaitTime = MissionManager::_ackTimeoutMilliseconds * MissionManager::_maxRetryCount * 2;
+    static const int        _initialSyncWaitTime = 30000;
 };
 
 #endif
@@ -56,6 +56,7 @@
 #include "UASMessageHandler.h"
 #include "AutoPilotPluginManager.h"
 #include "QGCTemporaryFile.h"
+#include "EventLoopMonitor.h"
 #include "QGCFileDialog.h"
 #include "QGCPalette.h"
 #include "QGCLoggingCategory.h"
@@ -85,6 +86,8 @@
 #include "FlightMapSettings.h"
 #include "QGCQGeoCoordinate.h"
 #include "CoordinateVector.h"
+#include "MissionItemStore.h"
+#include "ParameterListModel.h"
 
 #ifndef __ios__
     #include "SerialLink.h"
@@ -331,11 +334,14 @@ void QGCApplication::_initCommon(void)
     qmlRegisterUncreatableType<Vehicle>             ("QGroundControl.Vehicle",          1, 0, "Vehicle",                "Reference only");
     qmlRegisterUncreatableType<MissionItem>         ("QGroundControl.Vehicle",          1, 0, "MissionItem",            "Reference only");
     qmlRegisterUncreatableType<MissionManager>      ("QGroundControl.Vehicle",          1, 0, "MissionManager",         "Reference only");
+    qmlRegisterUncreatableType<TrajectoryStore>     ("QGroundControl.Vehicle",          1, 0, "TrajectoryStore",        "Reference only");
     qmlRegisterUncreatableType<JoystickManager>     ("QGroundControl.JoystickManager",  1, 0, "JoystickManager",        "Reference only");
     qmlRegisterUncreatableType<Joystick>            ("QGroundControl.JoystickManager",  1, 0, "Joystick",               "Reference only");
     qmlRegisterUncreatableType<QmlObjectListModel>  ("QGroundControl",                  1, 0, "QmlObjectListModel",     "Reference only");
     qmlRegisterUncreatableType<QGCQGeoCoordinate>   ("QGroundControl",                  1, 0, "QGCQGeoCoordinate",      "Reference only");
     qmlRegisterUncreatableType<CoordinateVector>    ("QGroundControl",                  1, 0, "CoordinateVector",       "Reference only");
+    qmlRegisterUncreatableType<MissionItemStore>    ("QGroundControl",                  1, 0, "MissionItemStore",       "Reference only");
+    qmlRegisterUncreatableType<ParameterListModel>  ("QGroundControl.Controllers",      1, 0, "ParameterListModel",     "Reference only");
     
     qmlRegisterType<ViewWidgetController>           ("QGroundControl.Controllers", 1, 0, "ViewWidgetController");
     qmlRegisterType<ParameterEditorController>      ("QGroundControl.Controllers", 1, 0, "ParameterEditorController");
@@ -416,6 +422,8 @@ bool QGCApplication::_initForNormalAppBoot(void)
     QSettings settings;
 
     _createSingletons();
+    
+    EventLoopMonitor::instance()->start();
 
     _styleIsDark = settings.value(_styleKey, _styleIsDark).toBool();
     _loadCurrentStyle();
@@ -577,6 +585,11 @@ void QGCApplication::_createSingletons(void)
 {
     // The order here is important since the singletons reference each other
 
+    // No dependencies
+    EventLoopMonitor* eventLoopMonitor = EventLoopMonitor::_createSingleton();
+    Q_UNUSED(eventLoopMonitor);
+    Q_ASSERT(eventLoopMonitor);
+    
     // No dependencies
     FlightMapSettings* flightMapSettings = FlightMapSettings::_createSingleton();
     Q_UNUSED(flightMapSettings);
@@ -673,6 +686,23 @@ void QGCApplication::_destroySingletons(void)
     ArduCopterFirmwarePlugin::_deleteSingleton();
     HomePositionManager::_deleteSingleton();
     FlightMapSettings::_deleteSingleton();
+    EventLoopMonitor::_deleteSingleton();
+}
+
+bool QGCApplication::notify(QObject* receiver, QEvent* event)
+{
+    if (EventLoopMonitor::_trackingActivity() && QThread::currentThread() == thread()) {
+        const char* previousClassName;
+        int         previousEventType;
+        
+        EventLoopMonitor::_enterActivity(receiver->metaObject()->className(), event->type(), &previousClassName, &previousEventType);
+        bool handled = QApplication::notify(receiver, event);
+        EventLoopMonitor::_exitActivity(previousClassName, previousEventType);
+        
+        return handled;
+    }
+    
+    return QApplication::notify(receiver, event);
 }
 
 void QGCApplication::informationMessageBoxOnMainThread(const QString& title, const QString& msg)
@@ -110,6 +110,9 @@ public:
     bool testHighDPI(void) { return _testHighDPI; }
 #endif
     
+    // Override from QApplication. Tracks the event being dispatched on the main thread for EventLoopMonitor.
+    virtual bool notify(QObject* receiver, QEvent* event);
+    
 public slots:
     /// You can connect to this slot to show an information message box from a different thread.
     void informationMessageBoxOnMainThread(const QString& title, const QString& msg);
@@ -0,0 +1,332 @@
+/*=====================================================================
+ 
+ QGroundControl Open Source Ground Control Station
+ 
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ 
+ This file is part of the QGROUNDCONTROL project
+ 
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+ 
+ ======================================================================*/
+
+#include "QGCTrace.h"
+
+#include <QElapsedTimer>
+#include <QThreadStorage>
+#include <QThread>
+#include <QMutex>
+#include <QList>
+#include <QFile>
+#include <QTextStream>
+#include <QCoreApplication>
+
+/// Events recorded by a single thread. The buffer is a ring, once full the oldest events are overwritten.
+class QGCTraceBuffer
+{
+public:
+    typedef struct {
+        const char* category;
+        const char* name;
+        qint64      timestampNsecs;
+        qint64      durationOrValue;    ///< Duration in nsecs for spans, value for counters
+        bool        counter;
+    } Event_t;
+    
+    QGCTraceBuffer(int threadId, QThread* thread)
+        : threadId(threadId)
+        , thread(thread)
+        , retired(false)
+        , _writeCount(0)
+        , _wrapped(0)
+    {
+    }
+    
+    /// Only called from the owning thread
+    void add(const char* category, const char* name, qint64 timestampNsecs, qint64 durationOrValue, bool counter)
+    {
+        int     writeCount =    _writeCount.load();
+        Event_t& event =        _events[writeCount & _eventMask];
+        
+        event.category =        category;
+        event.name =            name;
+        event.timestampNsecs =  timestampNsecs;
+        event.durationOrValue = durationOrValue;
+        event.counter =         counter;
+        
+        if (writeCount == _eventMask) {
+            // Published to readers by the release store of the write count below
+            _wrapped.store(1);
+        }
+        
+        // Publish the event to readers
+        _writeCount.storeRelease((writeCount + 1) & _writeCountMask);
+    }
+    
+    /// Copies the events out of the buffer. Can be called from any thread. The oldest events may be in the
+    /// process of being overwritten while the copy is made, so a safety margin of them is skipped.
+    QList<Event_t> snapshot(void) const
+    {
+        QList<Event_t> events;
+        
+        int writeCount = _writeCount.loadAcquire();
+        int available = _wrapped.load() ? _eventCount - _overwriteMargin : writeCount;
+        
+        for (int i=available; i>0; i--) {
+            events.append(_events[(writeCount - i) & _eventMask]);
+        }
+        
+        return events;
+    }
+    
+    /// Reuses the buffer for a new thread
+    void reset(int newThreadId, QThread* newThread)
+    {
+        threadId = newThreadId;
+        thread = newThread;
+        activeSpan.store(NULL);
+        retired = false;
+        _wrapped.store(0);
+        _writeCount.store(0);
+    }
+    
+    int                         threadId;
+    QThread*                    thread;
+    QString                     threadName;
+    QAtomicPointer<const char>  activeSpan;     ///< Innermost open span, may be read from any thread
+    bool                        retired;        ///< true: owning thread has finished, protected by _traceBufferMutex
+    
+private:
+    static const int _eventCount =      16384;          ///< Must be a power of two
+    static const int _eventMask =       _eventCount - 1;
+    static const int _writeCountMask =  0x3FFFFFFF;     ///< Keeps the write count positive, must be a multiple of _eventCount minus one
+    static const int _overwriteMargin = 256;
+    
+    Event_t     _events[_eventCount];
+    QAtomicInt  _writeCount;    ///< Number of events written, wraps
+    QAtomicInt  _wrapped;       ///< 1: buffer has filled up at least once, read from other threads
+};
+
+/// Per thread pointer to the thread's buffer. Marks the buffer as retired when the thread exits so it can
+/// be reused, while leaving the events in place for the next trace dump.
+class QGCTraceThreadData
+{
+public:
+    QGCTraceThreadData(QGCTraceBuffer* buffer) : buffer(buffer) { }
+    ~QGCTraceThreadData();
+    
+    QGCTraceBuffer* buffer;
+};
+
+/// Copy of a thread's buffer for writing out a trace
+typedef struct {
+    int                             threadId;
+    QString                         threadName;
+    QList<QGCTraceBuffer::Event_t>  events;
+} ThreadSnapshot_t;
+
+static const int            _maxTraceBuffers = 64;
+static QMutex               _traceBufferMutex;      ///< Protects _traceBuffers, _nextThreadId and the QGCTraceBuffer fields other than the events
+static QList<QGCTraceBuffer*> _traceBuffers;
+static int                  _nextThreadId = 1;
+static QThreadStorage<QGCTraceThreadData*> _traceThreadData;
+
+QGCTraceThreadData::~QGCTraceThreadData()
+{
+    if (buffer) {
+        QMutexLocker locker(&_traceBufferMutex);
+        buffer->retired = true;
+    }
+}
+
+/// Starts the trace time base when the application is loaded
+class QGCTraceClock
+{
+public:
+    QGCTraceClock(void) { timer.start(); }
+    QElapsedTimer timer;
+};
+static QGCTraceClock _traceClock;
+
+QAtomicInt QGCTrace::_enabled(1);
+
+qint64 QGCTrace::nsecsNow(void)
+{
+    return _traceClock.timer.nsecsElapsed();
+}
+
+/// @return Buffer for the current thread, NULL if no buffer is available
+static QGCTraceBuffer* _currentThreadBuffer(void)
+{
+    if (_traceThreadData.hasLocalData()) {
+        return _traceThreadData.localData()->buffer;
+    }
+    
+    QGCTraceBuffer* buffer = NULL;
+    QThread* thread = QThread::currentThread();
+    QString threadName = thread->objectName();
+    if (threadName.isEmpty()) {
+        threadName = (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) ? QString("Main") : QString(thread->metaObject()->className());
+    }
+    
+    _traceBufferMutex.lock();
+    if (_traceBuffers.count() < _maxTraceBuffers) {
+        buffer = new QGCTraceBuffer(_nextThreadId++, thread);
+        _traceBuffers.append(buffer);
+    } else {
+        // Reuse the buffer of a thread which has finished
+        foreach (QGCTraceBuffer* retiredBuffer, _traceBuffers) {
+            if (retiredBuffer->retired) {
+                buffer = retiredBuffer;
+                buffer->reset(_nextThreadId++, thread);
+                break;
+            }
+        }
+    }
+    if (buffer) {
+        buffer->threadName = threadName;
+    }
+    _traceBufferMutex.unlock();
+    
+    // A NULL buffer means we are out of buffers, which stops tracing on this thread
+    _traceThreadData.setLocalData(new QGCTraceThreadData(buffer));
+    return buffer;
+}
+
+void QGCTrace::addCompleteEvent(const char* category, const char* name, qint64 startNsecs, qint64 durationNsecs)
+{
+    QGCTraceBuffer* buffer = _currentThreadBuffer();
+    
+    if (buffer) {
+        buffer->add(category, name, startNsecs, durationNsecs, false /* counter */);
+    }
+}
+
+void QGCTrace::addCounter(const char* category, const char* name, qint64 value)
+{
+    if (!enabled()) {
+        return;
+    }
+    
+    QGCTraceBuffer* buffer = _currentThreadBuffer();
+    
+    if (buffer) {
+        buffer->add(category, name, nsecsNow(), value, true /* counter */);
+    }
+}
+
+const char* QGCTrace::_enterSpan(const char* name)
+{
+    QGCTraceBuffer* buffer = _currentThreadBuffer();
+    
+    if (buffer) {
+        return buffer->activeSpan.fetchAndStoreRelaxed(name);
+    }
+    return NULL;
+}
+
+void QGCTrace::_exitSpan(const char* previousName)
+{
+    QGCTraceBuffer* buffer = _currentThreadBuffer();
+    
+    if (buffer) {
+        buffer->activeSpan.storeRelease(previousName);
+    }
+}
+
+const char* QGCTrace::activeSpan(QThread* thread)
+{
+    const char* span = NULL;
+    
+    _traceBufferMutex.lock();
+    foreach (QGCTraceBuffer* buffer, _traceBuffers) {
+        if (buffer->thread == thread && !buffer->retired) {
+            span = buffer->activeSpan.loadAcquire();
+            break;
+        }
+    }
+    _traceBufferMutex.unlock();
+    
+    return span;
+}
+
+/// Escapes a string for use within a json string
+static QString _jsonEscape(const QString& string)
+{
+    QString escaped(string);
+    
+    escaped.replace("\\", "\\\\");
+    escaped.replace("\"", "\\\"");
+    return escaped;
+}
+
+bool QGCTrace::writeChromeTrace(const QString& filename, QString& errorString)
+{
+    QFile file(filename);
+    
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        errorString = file.errorString();
+        return false;
+    }
+    
+    // A buffer can be reset for a new thread at any time, so the thread info and events are copied together
+    // while the buffer can't be reset
+    QList<ThreadSnapshot_t> snapshots;
+    _traceBufferMutex.lock();
+    foreach (QGCTraceBuffer* buffer, _traceBuffers) {
+        ThreadSnapshot_t snapshot;
+        
+        snapshot.threadId = buffer->threadId;
+        snapshot.threadName = buffer->threadName;
+        snapshot.events = buffer->snapshot();
+        snapshots.append(snapshot);
+    }
+    _traceBufferMutex.unlock();
+    
+    QTextStream stream(&file);
+    bool firstEvent = true;
+    
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    
+    foreach (const ThreadSnapshot_t& snapshot, snapshots) {
+        int threadId = snapshot.threadId;
+        
+        stream << (firstEvent ? "" : ",\n");
+        stream << QString("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}}").arg(threadId).arg(_jsonEscape(snapshot.threadName));
+        firstEvent = false;
+        
+        foreach (const QGCTraceBuffer::Event_t& event, snapshot.events) {
+            // Chrome trace timestamps are in microseconds
+            QString timestamp = QString::number(event.timestampNsecs / 1000.0, 'f', 3);
+            
+            if (event.counter) {
+                stream << QString(",\n{\"ph\":\"C\",\"cat\":\"%1\",\"name\":\"%2\",\"pid\":1,\"tid\":%3,\"ts\":%4,\"args\":{\"value\":%5}}")
+                            .arg(event.category).arg(event.name).arg(threadId).arg(timestamp).arg(event.durationOrValue);
+            } else {
+                stream << QString(",\n{\"ph\":\"X\",\"cat\":\"%1\",\"name\":\"%2\",\"pid\":1,\"tid\":%3,\"ts\":%4,\"dur\":%5}")
+                            .arg(event.category).arg(event.name).arg(threadId).arg(timestamp).arg(QString::number(event.durationOrValue / 1000.0, 'f', 3));
+            }
+        }
+    }
+    
+    stream << "\n]}\n";
+    stream.flush();
+    
+    if (file.error() != QFile::NoError) {
+        errorString = file.errorString();
+        return false;
+    }
+    
+    return true;
+}
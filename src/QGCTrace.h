@@ -0,0 +1,122 @@
+/*=====================================================================
+ 
+ QGroundControl Open Source Ground Control Station
+ 
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ 
+ This file is part of the QGROUNDCONTROL project
+ 
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+ 
+ ======================================================================*/
+
+/// @file
+///     @brief Low overhead tracing of hot code paths. Scoped timers and counters are recorded into per thread
+///             ring buffers which are only ever written by the owning thread, so recording needs no locks. The
+///             most recent events from all threads can be written on demand in the Chrome trace event format,
+///             which can be loaded into about:tracing or Perfetto.
+///
+///             Tracing is compiled in when QGC_TRACING_ENABLED is defined. Otherwise the QGC_TRACE_* macros
+///             compile to nothing.
+
+#ifndef QGCTrace_H
+#define QGCTrace_H
+
+#include <QString>
+#include <QAtomicInt>
+
+class QThread;
+
+/// @def QGC_TRACE_SCOPE
+/// Records the time spent from here to the end of the enclosing scope. category and name must be string
+/// literals (or otherwise live for the lifetime of the application) since only the pointers are recorded.
+///
+/// @def QGC_TRACE_COUNTER
+/// Records the current value of a counter. Same rules as QGC_TRACE_SCOPE for category and name.
+
+#ifdef QGC_TRACING_ENABLED
+#define QGC_TRACE_CONCAT_INNER(a, b) a ## b
+#define QGC_TRACE_CONCAT(a, b) QGC_TRACE_CONCAT_INNER(a, b)
+#define QGC_TRACE_SCOPE(category, name) QGCTraceScope QGC_TRACE_CONCAT(_qgcTraceScope, __LINE__)(category, name)
+#define QGC_TRACE_COUNTER(category, name, value) QGCTrace::addCounter(category, name, value)
+#else
+#define QGC_TRACE_SCOPE(category, name)
+#define QGC_TRACE_COUNTER(category, name, value)
+#endif
+
+class QGCTrace
+{
+public:
+    /// Turns recording on or off at runtime. Recording is on by default.
+    static void setEnabled(bool enabled) { _enabled.store(enabled ? 1 : 0); }
+    static bool enabled(void) { return _enabled.load() != 0; }
+    
+    /// @return Current time in nanoseconds on the trace time base
+    static qint64 nsecsNow(void);
+    
+    /// Records a span on the current thread
+    static void addCompleteEvent(const char* category, const char* name, qint64 startNsecs, qint64 durationNsecs);
+    
+    /// Records a counter value on the current thread
+    static void addCounter(const char* category, const char* name, qint64 value);
+    
+    /// @return Name of the innermost span currently open on the specified thread, NULL for none. Used to
+    ///         find out what a stalled thread is doing.
+    static const char* activeSpan(QThread* thread);
+    
+    // Used by QGCTraceScope to track the innermost open span of the current thread
+    static const char* _enterSpan(const char* name);
+    static void _exitSpan(const char* previousName);
+    
+    /// Writes the events currently held in all thread buffers as a Chrome trace event json file
+    ///     @param[out] errorString Error if the file could not be written
+    /// @return false: failed to write file
+    static bool writeChromeTrace(const QString& filename, QString& errorString);
+    
+private:
+    static QAtomicInt _enabled;
+};
+
+/// Records the lifetime of the object as a span. Use through QGC_TRACE_SCOPE.
+class QGCTraceScope
+{
+public:
+    QGCTraceScope(const char* category, const char* name)
+        : _category(category)
+        , _name(name)
+        , _previousName(NULL)
+        , _startNsecs(-1)
+    {
+        if (QGCTrace::enabled()) {
+            _previousName = QGCTrace::_enterSpan(name);
+            _startNsecs = QGCTrace::nsecsNow();
+        }
+    }
+    
+    ~QGCTraceScope()
+    {
+        if (_startNsecs >= 0) {
+            QGCTrace::addCompleteEvent(_category, _name, _startNsecs, QGCTrace::nsecsNow() - _startNsecs);
+            QGCTrace::_exitSpan(_previousName);
+        }
+    }
+    
+private:
+    const char* _category;
+    const char* _name;
+    const char* _previousName;  ///< Span which was active when this one was entered
+    qint64      _startNsecs;
+};
+
+#endif
@@ -46,8 +46,7 @@ QGCView {
     readonly property real __rightMargin: 20
     readonly property int __maxParamChars: 16
 
-    property bool _searchFilter: false  ///< true: showing results of search
-    property var _searchResults         ///< List of parameter names from search results
+    property bool _searchFilter: false  ///< true: showing search results
 
     ParameterEditorController {
         id: controller;
@@ -64,68 +63,6 @@ QGCView {
         ParameterEditorDialog { fact: __editorDialogFact }
     } // Component - Editor Dialog
 
-    Component {
-        id: searchDialogComponent
-
-        QGCViewDialog {
-
-            function accept() {
-                _searchResults = controller.searchParametersForComponent(-1, searchFor.text, true /*searchInName.checked*/, true /*searchInDescriptions.checked*/)
-                _searchFilter = true
-                hideDialog()
-            }
-
-            function reject() {
-                _searchFilter = false
-                hideDialog()
-            }
-
-            QGCLabel {
-                id:     searchForLabel
-                text:   "Search for:"
-            }
-
-            QGCTextField {
-                id:                 searchFor
-                anchors.topMargin:  defaultTextHeight / 3
-                anchors.top:        searchForLabel.bottom
-                width:              defaultTextWidth * 20
-            }
-
-/*
-            // Leaving in for possible future use. We'll see if needed from user comments.
-            QGCLabel {
-                id:                 searchInLabel
-                anchors.topMargin:  defaultTextHeight
-                anchors.top:        searchFor.bottom
-                text:               "Search in:"
-            }
-
-            QGCCheckBox {
-                id:                 searchInName
-                anchors.topMargin:  defaultTextHeight / 3
-                anchors.top:        searchInLabel.bottom
-                text:               "Name"
-            }
-
-            QGCCheckBox {
-                id:                 searchInDescriptions
-                anchors.topMargin:  defaultTextHeight / 3
-                anchors.top:        searchInName.bottom
-                text:               "Descriptions"
-            }
-*/
-
-            QGCLabel {
-                anchors.topMargin:  defaultTextHeight
-                anchors.top:        searchFor.bottom
-                width:              parent.width
-                wrapMode:           Text.WordWrap
-                text:               "Hint: Leave 'Search For' blank and click Apply to list all parameters sorted by name."
-            }
-        }
-    }
-
     Component {
         id: factRowsComponent
 
@@ -146,10 +83,10 @@ QGCView {
             }
 
             Repeater {
-                model: parameterNames
+                model: parameterModel
 
                 Column {
-                    property Fact modelFact: controller.getParameterFact(componentId, modelData)
+                    property Fact modelFact: model.fact
 
                     Item {
                         x:			__leftMargin
@@ -238,10 +175,8 @@ QGCView {
                                         text:	modelData
 
                                         onClicked: {
-                                            factRowsLoader.sourceComponent = null
-                                            factRowsLoader.componentId = componentId
-                                            factRowsLoader.group = modelData
-                                            factRowsLoader.sourceComponent = factRowsComponent
+                                            controller.groupParameters.componentId = componentId
+                                            controller.groupParameters.group = modelData
                                         }
                                     }
 
@@ -272,9 +207,8 @@ QGCView {
                     width:              factScrollView.width
                     sourceComponent:    factRowsComponent
 
-                    property int componentId:       controller.componentIds[0]
-                    property string group:          controller.getGroupsForComponent(controller.componentIds[0])[0]
-                    property var parameterNames:    controller.getParametersForGroup(componentId, group)
+                    property string group:          controller.groupParameters.group
+                    property var parameterModel:    controller.groupParameters
                 }
             } // ScrollView - Facts
         } // Item
@@ -284,24 +218,61 @@ QGCView {
         id: searchResultsViewComponent
 
         Item {
+            QGCLabel {
+                id:                 searchForLabel
+                anchors.left:       parent.left
+                anchors.leftMargin: __leftMargin
+                height:             searchFor.height
+                verticalAlignment:  Text.AlignVCenter
+                text:               "Search for:"
+            }
+
+            QGCTextField {
+                id:                 searchFor
+                anchors.leftMargin: defaultTextWidth
+                anchors.left:       searchForLabel.right
+                width:              defaultTextWidth * 20
+                text:               controller.searchParameters.searchText
+                focus:              true
+
+                // Results are filtered as you type
+                onTextChanged: controller.searchParameters.searchText = text
+            }
+
+            QGCButton {
+                anchors.leftMargin: defaultTextWidth
+                anchors.left:       searchFor.right
+                text:               "Close"
+                onClicked:          _searchFilter = false
+            }
+
+            QGCLabel {
+                id:                 searchHint
+                anchors.topMargin:  defaultTextHeight / 3
+                anchors.top:        searchFor.bottom
+                anchors.left:       searchForLabel.left
+                text:               controller.searchParameters.count + " parameters. Leave 'Search for' blank to list all parameters sorted by name."
+            }
+
             ScrollView {
                 id:             factScrollView
+                anchors.topMargin: defaultTextHeight
+                anchors.top:    searchHint.bottom
+                anchors.bottom: parent.bottom
                 anchors.left:   parent.left
                 anchors.right:  parent.right
-                height:         parent.height
 
                 Loader {
                     id:                 factRowsLoader
                     width:              factScrollView.width
                     sourceComponent:    factRowsComponent
 
-                    property int componentId:       -1
                     property string group:          "Search results"
-                    property var parameterNames:    _searchResults
+                    property var parameterModel:    controller.searchParameters
                 }
             } // ScrollView - Facts
         } // Item
-    } // Component - sortedViewComponent
+    } // Component - searchResultsViewComponent
 
     QGCViewPanel {
         id:             panel
@@ -337,7 +308,7 @@ QGCView {
                         }
                         MenuItem {
                             text:           "Search..."
-                            onTriggered:    showDialog(searchDialogComponent, "Parameter Search", 50, StandardButton.Reset | StandardButton.Apply)
+                            onTriggered:    _searchFilter = true
                         }
                         MenuSeparator { }
                         MenuItem {
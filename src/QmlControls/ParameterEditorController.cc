@@ -35,10 +35,29 @@
 ParameterEditorController::ParameterEditorController(void)
 {
     const QMap<int, QMap<QString, QStringList> >& groupMap = _autopilot->getGroupMap();
+    QList<Fact*> facts;
     
     foreach (int componentId, groupMap.keys()) {
 		_componentIds += QString("%1").arg(componentId);
+        
+        foreach (const QString& paramName, _autopilot->parameterNames(componentId)) {
+            facts += _autopilot->getParameterFact(componentId, paramName);
+        }
 	}
+    
+    // The parameter set does not change once loaded, so the index is built once for the life of the editor
+    _searchIndex.build(facts);
+    
+    _groupParameters = new ParameterListModel(&_searchIndex, this);
+    if (_searchIndex.count()) {
+        int componentId = _searchIndex.componentId(0);
+        _groupParameters->setComponentId(componentId);
+        _groupParameters->setGroup(_searchIndex.groups(componentId).value(0));
+    }
+    
+    _searchParameters = new ParameterListModel(&_searchIndex, this);
+    
+    connect(_autopilot, &AutoPilotPlugin::parameterWriteComplete, this, &ParameterEditorController::_parameterWriteComplete);
 }
 
 ParameterEditorController::~ParameterEditorController()
@@ -64,24 +83,30 @@ QStringList ParameterEditorController::searchParametersForComponent(int componen
 {
     QStringList list;
     
-    foreach(QString paramName, _autopilot->parameterNames(componentId)) {
-        if (searchText.isEmpty()) {
-            list += paramName;
-        } else {
-            Fact* fact = _autopilot->getParameterFact(componentId, paramName);
-            
-            if (searchInName && fact->name().contains(searchText, Qt::CaseInsensitive)) {
-                list += paramName;
-            } else if (searchInDescriptions && (fact->shortDescription().contains(searchText, Qt::CaseInsensitive) || fact->longDescription().contains(searchText, Qt::CaseInsensitive))) {
-                list += paramName;
-            }
-        }
+    if (componentId == FactSystem::defaultComponentId) {
+        componentId = _defaultComponentId();
+    }
+    
+    // Index results are already sorted by name within a component
+    foreach (int entry, _searchIndex.search(componentId, searchText, searchInName, searchInDescriptions)) {
+        list += _searchIndex.name(entry);
     }
-    list.sort();
     
     return list;
 }
 
+/// @return Actual component id for the default component
+int ParameterEditorController::_defaultComponentId(void)
+{
+    QStringList paramNames = _autopilot->parameterNames(FactSystem::defaultComponentId);
+    
+    if (paramNames.isEmpty()) {
+        return FactSystem::defaultComponentId;
+    }
+    
+    return _autopilot->getParameterFact(FactSystem::defaultComponentId, paramNames[0])->componentId();
+}
+
 void ParameterEditorController::clearRCToParam(void)
 {
 	Q_ASSERT(_uas);
@@ -138,12 +163,30 @@ void ParameterEditorController::loadFromFile(void)
         errors = _autopilot->readParametersFromStream(stream);
         file.close();
         
-        if (!errors.isEmpty()) {
+        if (_autopilot->parameterWriteInProgress()) {
+            // Errors are reported together with the outcome of the writes
+            _loadErrors = errors;
+        } else if (!errors.isEmpty()) {
             emit showErrorMessage(errors);
         }
     }
 }
 
+void ParameterEditorController::_parameterWriteComplete(const QStringList& accepted, const QStringList& rejected)
+{
+    QString errors = _loadErrors;
+    _loadErrors.clear();
+    
+    if (rejected.count()) {
+        errors += QString("%1 parameters written, %2 not accepted by the vehicle:\n").arg(accepted.count()).arg(rejected.count());
+        errors += rejected.join("\n");
+    }
+    
+    if (!errors.isEmpty()) {
+        emit showErrorMessage(errors);
+    }
+}
+
 void ParameterEditorController::refresh(void)
 {
 	_autopilot->refreshAllParameters();
@@ -33,6 +33,8 @@
 #include "AutoPilotPlugin.h"
 #include "UASInterface.h"
 #include "FactPanelController.h"
+#include "ParameterSearchIndex.h"
+#include "ParameterListModel.h"
 
 class ParameterEditorController : public FactPanelController
 {
@@ -43,6 +45,12 @@ public:
     ~ParameterEditorController();
 
     Q_PROPERTY(QStringList componentIds MEMBER _componentIds CONSTANT)
+    
+    /// Parameters of the group selected in the grouped view
+    Q_PROPERTY(ParameterListModel* groupParameters READ groupParameters CONSTANT)
+    
+    /// Parameters matching the search text, across all components
+    Q_PROPERTY(ParameterListModel* searchParameters READ searchParameters CONSTANT)
 	
 	Q_INVOKABLE QStringList getGroupsForComponent(int componentId);
 	Q_INVOKABLE QStringList getParametersForGroup(int componentId, QString group);
@@ -55,13 +63,23 @@ public:
     Q_INVOKABLE void resetAllToDefaults(void);
 	Q_INVOKABLE void setRCToParam(const QString& paramName);
 	
-	QList<QObject*> model(void);
+    ParameterListModel* groupParameters(void) { return _groupParameters; }
+    ParameterListModel* searchParameters(void) { return _searchParameters; }
     
 signals:
     void showErrorMessage(const QString& errorMsg);
 	
+private slots:
+    void _parameterWriteComplete(const QStringList& accepted, const QStringList& rejected);
+    
 private:
+    int _defaultComponentId(void);
+    
 	QStringList			_componentIds;
+    ParameterSearchIndex _searchIndex;
+    ParameterListModel*  _groupParameters;
+    ParameterListModel*  _searchParameters;
+    QString              _loadErrors;   ///< Errors from the last file load, reported once the parameter writes complete
 };
 
 #endif
@@ -0,0 +1,193 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "ParameterListModel.h"
+
+ParameterListModel::ParameterListModel(const ParameterSearchIndex* index, QObject* parent)
+    : QAbstractListModel(parent)
+    , _index(index)
+    , _componentId(-1)
+    , _searchInName(true)
+    , _searchInDescriptions(true)
+{
+    Q_ASSERT(_index);
+    
+    refilter();
+}
+
+void ParameterListModel::setComponentId(int componentId)
+{
+    if (componentId != _componentId) {
+        _componentId = componentId;
+        emit componentIdChanged(_componentId);
+        refilter();
+    }
+}
+
+void ParameterListModel::setGroup(const QString& group)
+{
+    if (group != _group) {
+        _group = group;
+        emit groupChanged(_group);
+        refilter();
+    }
+}
+
+void ParameterListModel::setSearchText(const QString& searchText)
+{
+    if (searchText != _searchText) {
+        _searchText = searchText;
+        emit searchTextChanged(_searchText);
+        refilter();
+    }
+}
+
+void ParameterListModel::setSearchInName(bool searchInName)
+{
+    if (searchInName != _searchInName) {
+        _searchInName = searchInName;
+        emit searchInNameChanged(_searchInName);
+        refilter();
+    }
+}
+
+void ParameterListModel::setSearchInDescriptions(bool searchInDescriptions)
+{
+    if (searchInDescriptions != _searchInDescriptions) {
+        _searchInDescriptions = searchInDescriptions;
+        emit searchInDescriptionsChanged(_searchInDescriptions);
+        refilter();
+    }
+}
+
+void ParameterListModel::refilter(void)
+{
+    if (!_searchText.trimmed().isEmpty()) {
+        _setRows(_index->search(_componentId, _searchText, _searchInName, _searchInDescriptions));
+    } else if (!_group.isEmpty()) {
+        _setRows(_index->groupEntries(_componentId, _group));
+    } else {
+        _setRows(_index->entries(_componentId));
+    }
+}
+
+/// Moves the model to the new rows with the smallest set of row removals and insertions. Both the current and the
+/// new rows are sorted by entry, so a single merge pass finds the runs which differ.
+void ParameterListModel::_setRows(const QVector<int>& rows)
+{
+    int oldCount = _rows.count();
+    
+    if (_rows.isEmpty() || rows.isEmpty()) {
+        // Nothing to keep
+        if (!_rows.isEmpty()) {
+            beginRemoveRows(QModelIndex(), 0, _rows.count() - 1);
+            _rows.clear();
+            endRemoveRows();
+        }
+        if (!rows.isEmpty()) {
+            beginInsertRows(QModelIndex(), 0, rows.count() - 1);
+            _rows = rows;
+            endInsertRows();
+        }
+    } else {
+        int row = 0;
+        int newRow = 0;
+        
+        while (row < _rows.count() || newRow < rows.count()) {
+            if (row < _rows.count() && newRow < rows.count() && _rows[row] == rows[newRow]) {
+                row++;
+                newRow++;
+            } else if (newRow >= rows.count() || (row < _rows.count() && _rows[row] < rows[newRow])) {
+                // Run of rows which are no longer shown
+                int last = row;
+                while (last + 1 < _rows.count() && (newRow >= rows.count() || _rows[last + 1] < rows[newRow])) {
+                    last++;
+                }
+                beginRemoveRows(QModelIndex(), row, last);
+                _rows.remove(row, last - row + 1);
+                endRemoveRows();
+            } else {
+                // Run of rows which are newly shown
+                int insertCount = 1;
+                while (newRow + insertCount < rows.count() && (row >= _rows.count() || rows[newRow + insertCount] < _rows[row])) {
+                    insertCount++;
+                }
+                beginInsertRows(QModelIndex(), row, row + insertCount - 1);
+                _rows.insert(row, insertCount, 0);
+                for (int i=0; i<insertCount; i++) {
+                    _rows[row + i] = rows[newRow + i];
+                }
+                endInsertRows();
+                row += insertCount;
+                newRow += insertCount;
+            }
+        }
+    }
+    
+    if (_rows.count() != oldCount) {
+        emit countChanged(_rows.count());
+    }
+}
+
+int ParameterListModel::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    
+    return count();
+}
+
+QVariant ParameterListModel::data(const QModelIndex& index, int role) const
+{
+    int row = index.row();
+    
+    if (row < 0 || row >= count()) {
+        return QVariant();
+    }
+    
+    int entry = _rows[row];
+    
+    switch (role) {
+        case FactRole:
+            return QVariant::fromValue(static_cast<QObject*>(_index->fact(entry)));
+        case NameRole:
+            return _index->name(entry);
+        case ComponentIdRole:
+            return _index->componentId(entry);
+        case GroupRole:
+            return _index->group(entry);
+        default:
+            return QVariant();
+    }
+}
+
+QHash<int, QByteArray> ParameterListModel::roleNames(void) const
+{
+    QHash<int, QByteArray> hash;
+    
+    hash[FactRole] =        "fact";
+    hash[NameRole] =        "name";
+    hash[ComponentIdRole] = "componentId";
+    hash[GroupRole] =       "group";
+    
+    return hash;
+}
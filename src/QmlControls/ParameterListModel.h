@@ -0,0 +1,116 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef ParameterListModel_H
+#define ParameterListModel_H
+
+#include <QAbstractListModel>
+#include <QVector>
+
+#include "ParameterSearchIndex.h"
+
+/// @file
+///     @brief List of parameter Facts for the Parameter Editor, filtered from a ParameterSearchIndex. When the
+///             filter changes only the rows which differ are removed or inserted, so views keep the delegates
+///             for rows which stay and typing into a search field does not rebuild the whole list.
+///
+///             A non empty searchText filters by search, otherwise a non empty group shows the group, otherwise
+///             all parameters of the component are shown.
+
+class ParameterListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    
+public:
+    /// @param index Index to filter, must outlive the model
+    ParameterListModel(const ParameterSearchIndex* index, QObject* parent = NULL);
+    
+    Q_PROPERTY(int      count                   READ count                                                  NOTIFY countChanged)
+    Q_PROPERTY(int      componentId             READ componentId            WRITE setComponentId            NOTIFY componentIdChanged)
+    Q_PROPERTY(QString  group                   READ group                  WRITE setGroup                  NOTIFY groupChanged)
+    Q_PROPERTY(QString  searchText              READ searchText             WRITE setSearchText             NOTIFY searchTextChanged)
+    Q_PROPERTY(bool     searchInName            READ searchInName           WRITE setSearchInName           NOTIFY searchInNameChanged)
+    Q_PROPERTY(bool     searchInDescriptions    READ searchInDescriptions   WRITE setSearchInDescriptions   NOTIFY searchInDescriptionsChanged)
+    
+    enum {
+        FactRole = Qt::UserRole + 1,
+        NameRole,
+        ComponentIdRole,
+        GroupRole,
+    };
+    
+    // Property accessors
+    
+    int count(void) const { return _rows.count(); }
+    
+    /// Component to show, -1 for all components
+    int componentId(void) const { return _componentId; }
+    void setComponentId(int componentId);
+    
+    QString group(void) const { return _group; }
+    void setGroup(const QString& group);
+    
+    QString searchText(void) const { return _searchText; }
+    void setSearchText(const QString& searchText);
+    
+    bool searchInName(void) const { return _searchInName; }
+    void setSearchInName(bool searchInName);
+    
+    bool searchInDescriptions(void) const { return _searchInDescriptions; }
+    void setSearchInDescriptions(bool searchInDescriptions);
+    
+    // C++ only methods
+    
+    /// @return Index entry shown in the specified row
+    int entry(int row) const { return _rows[row]; }
+    
+    /// Re-applies the filter, used after the index has been rebuilt
+    void refilter(void);
+    
+signals:
+    void countChanged(int count);
+    void componentIdChanged(int componentId);
+    void groupChanged(const QString& group);
+    void searchTextChanged(const QString& searchText);
+    void searchInNameChanged(bool searchInName);
+    void searchInDescriptionsChanged(bool searchInDescriptions);
+    
+private:
+    // Overrides from QAbstractListModel
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+    virtual QHash<int, QByteArray> roleNames(void) const;
+    
+    void _setRows(const QVector<int>& rows);
+    
+    const ParameterSearchIndex* _index;
+    QVector<int>                _rows;      ///< Index entries in display order
+    
+    int     _componentId;
+    QString _group;
+    QString _searchText;
+    bool    _searchInName;
+    bool    _searchInDescriptions;
+};
+
+#endif
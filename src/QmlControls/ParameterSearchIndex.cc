@@ -0,0 +1,273 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "ParameterSearchIndex.h"
+
+#include <algorithm>
+#include <iterator>
+
+ParameterSearchIndex::ParameterSearchIndex(void)
+{
+    clear();
+}
+
+void ParameterSearchIndex::clear(void)
+{
+    _entries.clear();
+    _componentFirstEntry.clear();
+    _groupEntries.clear();
+    _clearTrie(_nameTrie);
+    _clearTrie(_wordTrie);
+}
+
+static bool _entryLessThan(Fact* fact1, Fact* fact2)
+{
+    if (fact1->componentId() != fact2->componentId()) {
+        return fact1->componentId() < fact2->componentId();
+    }
+    return fact1->name() < fact2->name();
+}
+
+void ParameterSearchIndex::build(const QList<Fact*>& facts)
+{
+    clear();
+    
+    QList<Fact*> sortedFacts = facts;
+    std::sort(sortedFacts.begin(), sortedFacts.end(), _entryLessThan);
+    
+    _entries.reserve(sortedFacts.count());
+    foreach (Fact* fact, sortedFacts) {
+        Entry_t entry;
+        
+        entry.componentId = fact->componentId();
+        entry.name = fact->name();
+        entry.group = fact->group();
+        entry.fact = fact;
+        
+        int index = _entries.count();
+        _entries.append(entry);
+        
+        if (!_componentFirstEntry.contains(entry.componentId)) {
+            _componentFirstEntry[entry.componentId] = index;
+        }
+        _groupEntries[entry.componentId][entry.group].append(index);
+        
+        // Entries are added in ascending order, which keeps every posting list sorted without further work
+        QString lowerName = entry.name.toLower();
+        for (int i=0; i<lowerName.length(); i++) {
+            _addToken(_nameTrie, lowerName.mid(i), index);
+        }
+        
+        QStringList entryWords = words(entry.group) + words(fact->shortDescription()) + words(fact->longDescription());
+        foreach (const QString& word, entryWords) {
+            _addToken(_wordTrie, word, index);
+        }
+    }
+}
+
+QStringList ParameterSearchIndex::groups(int componentId) const
+{
+    return _groupEntries.value(componentId).keys();
+}
+
+QVector<int> ParameterSearchIndex::entries(int componentId) const
+{
+    QVector<int> result;
+    
+    if (componentId == -1) {
+        result.reserve(_entries.count());
+        for (int i=0; i<_entries.count(); i++) {
+            result.append(i);
+        }
+    } else if (_componentFirstEntry.contains(componentId)) {
+        int first = _componentFirstEntry[componentId];
+        int last = first;
+        while (last < _entries.count() && _entries[last].componentId == componentId) {
+            result.append(last++);
+        }
+    }
+    
+    return result;
+}
+
+QVector<int> ParameterSearchIndex::groupEntries(int componentId, const QString& group) const
+{
+    return _groupEntries.value(componentId).value(group);
+}
+
+QVector<int> ParameterSearchIndex::search(int componentId, const QString& searchText, bool searchInName, bool searchInDescriptions) const
+{
+    QString text = searchText.trimmed().toLower();
+    
+    if (text.isEmpty()) {
+        return entries(componentId);
+    }
+    
+    QVector<int> nameMatches;
+    if (searchInName) {
+        const QVector<int>* postings = _lookup(_nameTrie, text);
+        if (postings) {
+            nameMatches = *postings;
+        }
+    }
+    
+    QVector<int> wordMatches;
+    if (searchInDescriptions) {
+        QStringList searchWords = words(text);
+        
+        for (int i=0; i<searchWords.count(); i++) {
+            const QVector<int>* postings = _lookup(_wordTrie, searchWords[i]);
+            if (!postings) {
+                wordMatches.clear();
+                break;
+            }
+            wordMatches = i == 0 ? *postings : _intersect(wordMatches, *postings);
+            if (wordMatches.isEmpty()) {
+                break;
+            }
+        }
+    }
+    
+    return _restrictToComponent(_unite(nameMatches, wordMatches), componentId);
+}
+
+QStringList ParameterSearchIndex::words(const QString& text)
+{
+    QStringList result;
+    QString word;
+    
+    for (int i=0; i<text.length(); i++) {
+        QChar c = text[i];
+        
+        if (c.isLetterOrNumber()) {
+            word += c.toLower();
+        } else if (!word.isEmpty()) {
+            result += word;
+            word.clear();
+        }
+    }
+    if (!word.isEmpty()) {
+        result += word;
+    }
+    
+    return result;
+}
+
+void ParameterSearchIndex::_clearTrie(Trie_t& trie)
+{
+    trie.children.clear();
+    trie.postings.clear();
+    
+    // Root node
+    trie.postings.append(QVector<int>());
+}
+
+void ParameterSearchIndex::_addToken(Trie_t& trie, const QString& token, int entry)
+{
+    int node = 0;
+    
+    for (int i=0; i<token.length(); i++) {
+        quint64 key = ((quint64)node << 16) | token[i].unicode();
+        
+        QHash<quint64, int>::const_iterator child = trie.children.constFind(key);
+        if (child == trie.children.constEnd()) {
+            int newNode = trie.postings.count();
+            trie.postings.append(QVector<int>());
+            trie.children.insert(key, newNode);
+            node = newNode;
+        } else {
+            node = child.value();
+        }
+        
+        QVector<int>& postings = trie.postings[node];
+        if (postings.isEmpty() || postings.last() != entry) {
+            postings.append(entry);
+        }
+    }
+}
+
+const QVector<int>* ParameterSearchIndex::_lookup(const Trie_t& trie, const QString& prefix) const
+{
+    int node = 0;
+    
+    for (int i=0; i<prefix.length(); i++) {
+        quint64 key = ((quint64)node << 16) | prefix[i].unicode();
+        
+        QHash<quint64, int>::const_iterator child = trie.children.constFind(key);
+        if (child == trie.children.constEnd()) {
+            return NULL;
+        }
+        node = child.value();
+    }
+    
+    return &trie.postings[node];
+}
+
+QVector<int> ParameterSearchIndex::_restrictToComponent(const QVector<int>& entries, int componentId) const
+{
+    if (componentId == -1) {
+        return entries;
+    }
+    if (!_componentFirstEntry.contains(componentId)) {
+        return QVector<int>();
+    }
+    
+    // Component entries are contiguous so the result is a single slice of the sorted entries
+    QMap<int, int>::const_iterator component = _componentFirstEntry.constFind(componentId);
+    int first = component.value();
+    ++component;
+    int end = component == _componentFirstEntry.constEnd() ? _entries.count() : component.value();
+    
+    QVector<int>::const_iterator begin = std::lower_bound(entries.constBegin(), entries.constEnd(), first);
+    QVector<int>::const_iterator stop = std::lower_bound(begin, entries.constEnd(), end);
+    
+    QVector<int> result;
+    result.reserve(stop - begin);
+    std::copy(begin, stop, std::back_inserter(result));
+    
+    return result;
+}
+
+QVector<int> ParameterSearchIndex::_unite(const QVector<int>& entries1, const QVector<int>& entries2)
+{
+    if (entries1.isEmpty()) {
+        return entries2;
+    } else if (entries2.isEmpty()) {
+        return entries1;
+    }
+    
+    QVector<int> result;
+    result.reserve(entries1.count() + entries2.count());
+    std::set_union(entries1.constBegin(), entries1.constEnd(), entries2.constBegin(), entries2.constEnd(), std::back_inserter(result));
+    
+    return result;
+}
+
+QVector<int> ParameterSearchIndex::_intersect(const QVector<int>& entries1, const QVector<int>& entries2)
+{
+    QVector<int> result;
+    
+    std::set_intersection(entries1.constBegin(), entries1.constEnd(), entries2.constBegin(), entries2.constEnd(), std::back_inserter(result));
+    
+    return result;
+}
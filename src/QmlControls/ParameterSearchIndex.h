@@ -0,0 +1,113 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef ParameterSearchIndex_H
+#define ParameterSearchIndex_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+
+#include "Fact.h"
+
+/// @file
+///     @brief Search index over the parameter Facts of a vehicle. Built once when the parameters are ready
+///             so the Parameter Editor can filter the full parameter set on every key stroke.
+///
+///             Entries are ordered by component id and then by name. All lookups return sorted entry
+///             indices, so results are in display order and can be merged or intersected without sorting.
+
+class ParameterSearchIndex
+{
+public:
+    ParameterSearchIndex(void);
+    
+    /// Replaces the index contents with the specified facts
+    void build(const QList<Fact*>& facts);
+    
+    void clear(void);
+    
+    /// @return Number of entries in the index
+    int count(void) const { return _entries.count(); }
+    
+    Fact*   fact(int entry) const           { return _entries[entry].fact; }
+    QString name(int entry) const           { return _entries[entry].name; }
+    int     componentId(int entry) const    { return _entries[entry].componentId; }
+    QString group(int entry) const          { return _entries[entry].group; }
+    
+    /// @return Component ids in the index in ascending order
+    QList<int> componentIds(void) const { return _componentFirstEntry.keys(); }
+    
+    /// @return Group names for the specified component in ascending order
+    QStringList groups(int componentId) const;
+    
+    /// @return All entries for the specified component, -1 for all components
+    QVector<int> entries(int componentId) const;
+    
+    /// @return Entries in the specified group
+    QVector<int> groupEntries(int componentId, const QString& group) const;
+    
+    /// Searches the index. The name is matched against the whole search text as a case insensitive substring.
+    /// Group and descriptions are matched by words: every word in the search text must be the start of a
+    /// word in the group, short or long description. An empty search text matches all entries.
+    ///     @param componentId Component to search, -1 for all components
+    ///     @return Matching entries
+    QVector<int> search(int componentId, const QString& searchText, bool searchInName, bool searchInDescriptions) const;
+    
+    /// @return Words from the specified text, lower case
+    static QStringList words(const QString& text);
+    
+private:
+    typedef struct {
+        int     componentId;
+        QString name;
+        QString group;
+        Fact*   fact;
+    } Entry_t;
+    
+    /// Prefix trie. Each node holds the sorted entries of all tokens which pass through it, so a prefix
+    /// lookup is a walk down the trie with no further work.
+    typedef struct {
+        QHash<quint64, int>     children;   ///< (node << 16) | character to child node
+        QVector<QVector<int> >  postings;   ///< Entries below each node
+    } Trie_t;
+    
+    void _clearTrie(Trie_t& trie);
+    void _addToken(Trie_t& trie, const QString& token, int entry);
+    const QVector<int>* _lookup(const Trie_t& trie, const QString& prefix) const;
+    QVector<int> _restrictToComponent(const QVector<int>& entries, int componentId) const;
+    
+    static QVector<int> _unite(const QVector<int>& entries1, const QVector<int>& entries2);
+    static QVector<int> _intersect(const QVector<int>& entries1, const QVector<int>& entries2);
+    
+    QVector<Entry_t>    _entries;
+    QMap<int, int>      _componentFirstEntry;   ///< Component id to index of first entry for the component
+    QMap<int, QMap<QString, QVector<int> > > _groupEntries;
+    
+    Trie_t  _nameTrie;  ///< Every suffix of every name, which turns a prefix lookup into a substring match
+    Trie_t  _wordTrie;  ///< Words from group, short and long description
+};
+
+#endif
@@ -0,0 +1,257 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "QGCDecodedTileCache.h"
+
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QImage>
+#include <QBuffer>
+#include <QThread>
+#include <QDebug>
+
+const char* QGCDecodedTileCache::decodedFormat = "bmp";
+
+/// Decodes a single tile on the thread pool and passes the result back to the cache thread
+class QGCTileDecodeTask : public QRunnable
+{
+public:
+    QGCTileDecodeTask(QGCDecodedTileCache* cache, quint64 key, const QByteArray& data, const QString& format)
+        : _cache(cache)
+        , _key(key)
+        , _data(data)
+        , _format(format)
+    {
+        
+    }
+    
+    void run(void)
+    {
+        QByteArray decodedData;
+        bool success = QGCDecodedTileCache::decodeTile(_data, _format, decodedData);
+        
+        // The cache waits for all tasks before it is destroyed, so it is still around here
+        QMetaObject::invokeMethod(_cache, "_decodeFinished", Qt::QueuedConnection, Q_ARG(quint64, _key), Q_ARG(bool, success), Q_ARG(QByteArray, decodedData));
+    }
+    
+private:
+    QGCDecodedTileCache*    _cache;
+    quint64                 _key;
+    QByteArray              _data;
+    QString                 _format;
+};
+
+QGCDecodedTileCache::QGCDecodedTileCache(qint64 maxBytes, QObject* parent)
+    : QObject(parent)
+    , _maxBytes(maxBytes)
+    , _totalBytes(0)
+    , _useCounter(0)
+    , _decodeCount(0)
+{
+    // Leave a core for the GUI thread
+    _threadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+QGCDecodedTileCache::~QGCDecodedTileCache()
+{
+    _threadPool.waitForDone();
+}
+
+QGCDecodedTileCache* QGCDecodedTileCache::instance(void)
+{
+    static QGCDecodedTileCache* cache = NULL;
+    
+    // This is the only in memory copy of the decoded tiles, so it gets the memory the stock QtLocation memory
+    // cache used to have
+    if (!cache) {
+#ifdef __mobile__
+        cache = new QGCDecodedTileCache(32 * 1024 * 1024, QCoreApplication::instance());
+#else
+        cache = new QGCDecodedTileCache(128 * 1024 * 1024, QCoreApplication::instance());
+#endif
+    }
+    
+    return cache;
+}
+
+void QGCDecodedTileCache::setMaxBytes(qint64 maxBytes)
+{
+    _maxBytes = maxBytes;
+    _evict();
+}
+
+bool QGCDecodedTileCache::find(const QGCTileStore::TileCoord_t& coord, QByteArray& data)
+{
+    QHash<quint64, Entry_t>::iterator entry = _entries.find(QGCTileStore::tileKey(coord));
+    if (entry == _entries.end()) {
+        return false;
+    }
+    
+    _lruMap.remove(entry->lastUsed);
+    entry->lastUsed = ++_useCounter;
+    _lruMap[entry->lastUsed] = entry.key();
+    
+    data = entry->data;
+    return true;
+}
+
+void QGCDecodedTileCache::insert(const QGCTileStore::TileCoord_t& coord, const QByteArray& data)
+{
+    quint64 key = QGCTileStore::tileKey(coord);
+    
+    QHash<quint64, Entry_t>::iterator entry = _entries.find(key);
+    if (entry != _entries.end()) {
+        _lruMap.remove(entry->lastUsed);
+        _totalBytes -= entry->data.size();
+    } else {
+        entry = _entries.insert(key, Entry_t());
+        entry->coord = coord;
+    }
+    
+    entry->data = data;
+    entry->lastUsed = ++_useCounter;
+    _lruMap[entry->lastUsed] = key;
+    _totalBytes += data.size();
+    
+    _evict();
+}
+
+void QGCDecodedTileCache::decode(const QGCTileStore::TileCoord_t& coord, const QByteArray& data, const QString& format, QGCTileDecodeRequester* requester)
+{
+    quint64 key = QGCTileStore::tileKey(coord);
+    
+    QHash<quint64, PendingDecode_t>::iterator pending = _pendingDecodes.find(key);
+    if (pending != _pendingDecodes.end()) {
+        if (!pending->requesters.contains(requester)) {
+            pending->requesters.append(requester);
+        }
+        return;
+    }
+    
+    pending = _pendingDecodes.insert(key, PendingDecode_t());
+    pending->coord = coord;
+    pending->data = data;
+    pending->format = format;
+    pending->requesters.append(requester);
+    
+    _decodeCount++;
+    _threadPool.start(new QGCTileDecodeTask(this, key, data, format));
+}
+
+void QGCDecodedTileCache::cancelDecode(const QGCTileStore::TileCoord_t& coord, QGCTileDecodeRequester* requester)
+{
+    // The decode keeps running so the result still ends up in the cache
+    QHash<quint64, PendingDecode_t>::iterator pending = _pendingDecodes.find(QGCTileStore::tileKey(coord));
+    if (pending != _pendingDecodes.end()) {
+        pending->requesters.removeAll(requester);
+    }
+}
+
+void QGCDecodedTileCache::_decodeFinished(quint64 key, bool success, QByteArray decodedData)
+{
+    if (!_pendingDecodes.contains(key)) {
+        return;
+    }
+    PendingDecode_t pending = _pendingDecodes.take(key);
+    
+    if (success) {
+        insert(pending.coord, decodedData);
+    } else {
+        qWarning() << "QGCDecodedTileCache unable to decode tile" << pending.coord.zoom << pending.coord.x << pending.coord.y << pending.format;
+    }
+    
+    QString format = success ? QString(decodedFormat) : pending.format;
+    foreach (QGCTileDecodeRequester* requester, pending.requesters) {
+        requester->tileDecoded(success ? decodedData : pending.data, format);
+    }
+}
+
+void QGCDecodedTileCache::setViewZoom(QObject* view, int zoom)
+{
+    if (!_viewZooms.contains(view)) {
+        connect(view, &QObject::destroyed, this, &QGCDecodedTileCache::_viewDestroyed);
+    }
+    _viewZooms[view] = zoom;
+}
+
+void QGCDecodedTileCache::_viewDestroyed(QObject* view)
+{
+    _viewZooms.remove(view);
+}
+
+/// @return Distance of the zoom level from the nearest zoom level a view is showing, 0 if there are no views
+int QGCDecodedTileCache::_zoomDistance(int zoom)
+{
+    int distance = -1;
+    
+    foreach (int viewZoom, _viewZooms) {
+        int viewDistance = qAbs(zoom - viewZoom);
+        if (distance == -1 || viewDistance < distance) {
+            distance = viewDistance;
+        }
+    }
+    
+    return qMax(distance, 0);
+}
+
+/// Evicts tiles until the cache is within its size limit. Of the least recently used tiles the one farthest
+/// from the viewed zoom levels goes first.
+void QGCDecodedTileCache::_evict(void)
+{
+    while (_totalBytes > _maxBytes && !_lruMap.isEmpty()) {
+        QMap<qint64, quint64>::iterator victim = _lruMap.begin();
+        int victimDistance = -1;
+        int scanCount = 0;
+        
+        for (QMap<qint64, quint64>::iterator lru = _lruMap.begin(); lru != _lruMap.end() && scanCount < _evictScanCount; ++lru, ++scanCount) {
+            int distance = _zoomDistance(_entries[lru.value()].coord.zoom);
+            if (distance > victimDistance) {
+                victim = lru;
+                victimDistance = distance;
+            }
+        }
+        
+        _totalBytes -= _entries[victim.value()].data.size();
+        _entries.remove(victim.value());
+        _lruMap.erase(victim);
+    }
+}
+
+bool QGCDecodedTileCache::decodeTile(const QByteArray& data, const QString& format, QByteArray& decodedData)
+{
+    QImage image;
+    QByteArray formatBytes = format.toLatin1();
+    
+    if (!image.loadFromData(data, formatBytes.isEmpty() ? NULL : formatBytes.constData())) {
+        return false;
+    }
+    
+    // Map tiles are opaque
+    if (image.format() != QImage::Format_RGB32) {
+        image = image.convertToFormat(QImage::Format_RGB32);
+    }
+    
+    QBuffer buffer(&decodedData);
+    buffer.open(QIODevice::WriteOnly);
+    return image.save(&buffer, decodedFormat);
+}
@@ -0,0 +1,133 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef QGCDecodedTileCache_H
+#define QGCDecodedTileCache_H
+
+#include "QGCTileStore.h"
+
+#include <QObject>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QThreadPool>
+
+/// @file
+///     @brief In memory cache of decoded map tiles, shared by all map views, with decoding on a thread pool.
+///
+///             QtLocation decodes the tile data handed back by the tile fetcher on the GUI thread. Png and jpeg
+///             decoding is expensive, so tiles are decoded in the background and handed to QtLocation as
+///             uncompressed bmp, which QtLocation loads with little more than a copy. Decoded tiles are kept
+///             in a byte bounded cache. When the cache is full the least recently used tiles are evicted,
+///             preferring tiles far from the zoom levels the map views are showing.
+
+/// Receives the result of a background decode
+class QGCTileDecodeRequester
+{
+public:
+    virtual ~QGCTileDecodeRequester() { }
+    
+    /// Called on the cache thread once the tile is decoded. If decoding failed the original data and format
+    /// are passed back.
+    virtual void tileDecoded(const QByteArray& data, const QString& format) = 0;
+};
+
+class QGCDecodedTileCache : public QObject
+{
+    Q_OBJECT
+    
+public:
+    QGCDecodedTileCache(qint64 maxBytes, QObject* parent = NULL);
+    ~QGCDecodedTileCache();
+    
+    /// Cache shared by all map views
+    static QGCDecodedTileCache* instance(void);
+    
+    /// Image format of decoded tiles
+    static const char* decodedFormat;
+    
+    qint64 maxBytes(void) { return _maxBytes; }
+    void setMaxBytes(qint64 maxBytes);
+    
+    qint64 totalBytes(void) { return _totalBytes; }
+    int count(void) { return _entries.count(); }
+    
+    /// Looks up a decoded tile and marks it as the most recently used one
+    /// @return false: Tile is not in the cache
+    bool find(const QGCTileStore::TileCoord_t& coord, QByteArray& data);
+    
+    /// Adds a decoded tile to the cache
+    void insert(const QGCTileStore::TileCoord_t& coord, const QByteArray& data);
+    
+    /// Decodes the tile on the thread pool and adds it to the cache. Requests for a tile which is being decoded
+    /// share the decode.
+    void decode(const QGCTileStore::TileCoord_t& coord, const QByteArray& data, const QString& format, QGCTileDecodeRequester* requester);
+    
+    /// Withdraws a decode request, the requester will not be called back
+    void cancelDecode(const QGCTileStore::TileCoord_t& coord, QGCTileDecodeRequester* requester);
+    
+    /// Sets the zoom level a map view is showing. Tiles at these zoom levels are evicted last.
+    void setViewZoom(QObject* view, int zoom);
+    
+    /// Number of decodes run on the thread pool
+    quint32 decodeCount(void) { return _decodeCount; }
+    
+    /// Decodes png or jpeg tile data to bmp
+    ///     @return false: Data could not be decoded
+    static bool decodeTile(const QByteArray& data, const QString& format, QByteArray& decodedData);
+    
+private slots:
+    void _decodeFinished(quint64 key, bool success, QByteArray decodedData);
+    void _viewDestroyed(QObject* view);
+    
+private:
+    typedef struct {
+        QGCTileStore::TileCoord_t   coord;
+        QByteArray                  data;
+        qint64                      lastUsed;
+    } Entry_t;
+    
+    typedef struct {
+        QGCTileStore::TileCoord_t       coord;
+        QByteArray                      data;       ///< Encoded data, passed back if decoding fails
+        QString                         format;
+        QList<QGCTileDecodeRequester*>  requesters;
+    } PendingDecode_t;
+    
+    int _zoomDistance(int zoom);
+    void _evict(void);
+    
+    QThreadPool                     _threadPool;
+    qint64                          _maxBytes;
+    qint64                          _totalBytes;
+    qint64                          _useCounter;
+    QHash<quint64, Entry_t>         _entries;
+    QMap<qint64, quint64>           _lruMap;            ///< Last used stamp to key, oldest first
+    QHash<quint64, PendingDecode_t> _pendingDecodes;
+    QHash<QObject*, int>            _viewZooms;
+    quint32                         _decodeCount;
+    
+    static const int _evictScanCount = 32;  ///< Oldest tiles considered for each eviction
+};
+
+#endif
@@ -0,0 +1,287 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "QGCTileScheduler.h"
+
+#include <QNetworkAccessManager>
+#include <QDebug>
+
+#include <math.h>
+
+Q_LOGGING_CATEGORY(QGCTileSchedulerLog, "QGCTileSchedulerLog")
+
+QGCTileScheduler::QGCTileScheduler(QNetworkAccessManager* networkManager, QObject* parent)
+    : QObject(parent)
+    , _networkManager(networkManager)
+    , _maxActivePerProvider(_defaultMaxActivePerProvider)
+    , _nextSequence(0)
+    , _lastTimeToVisibleMsecs(-1)
+    , _coalescedCount(0)
+    , _cancelledCount(0)
+{
+    Q_ASSERT(_networkManager);
+    
+    _startTimer.setSingleShot(true);
+    _startTimer.setInterval(0);
+    connect(&_startTimer, &QTimer::timeout, this, &QGCTileScheduler::_startJobs);
+}
+
+QGCTileScheduler::~QGCTileScheduler()
+{
+    foreach (Job_t* job, _jobs) {
+        if (job->reply) {
+            disconnect(job->reply, 0, this, 0);
+            job->reply->abort();
+            job->reply->deleteLater();
+        }
+        delete job;
+    }
+}
+
+void QGCTileScheduler::requestTile(const QGCTileStore::TileCoord_t& coord, const QNetworkRequest& request, QGCTileRequester* requester)
+{
+    quint64 key = QGCTileStore::tileKey(coord);
+    
+    Job_t* job = _jobs.value(key, NULL);
+    if (job) {
+        if (!job->requesters.contains(requester)) {
+            job->requesters.append(requester);
+            _coalescedCount++;
+        }
+        return;
+    }
+    
+    job = new Job_t;
+    job->coord = coord;
+    job->request = request;
+    job->provider = request.url().host();
+    job->requesters.append(requester);
+    job->reply = NULL;
+    job->sequence = _nextSequence++;
+    
+    _jobs[key] = job;
+    _pendingJobs.append(job);
+    
+    // Jobs are started from the event loop so a whole batch of requests is prioritized together
+    if (!_startTimer.isActive()) {
+        _startTimer.start();
+    }
+}
+
+void QGCTileScheduler::cancelTile(const QGCTileStore::TileCoord_t& coord, QGCTileRequester* requester)
+{
+    Job_t* job = _jobs.value(QGCTileStore::tileKey(coord), NULL);
+    if (!job) {
+        return;
+    }
+    
+    job->requesters.removeAll(requester);
+    if (!job->requesters.isEmpty()) {
+        return;
+    }
+    
+    qCDebug(QGCTileSchedulerLog) << "Cancel" << coord.zoom << coord.x << coord.y << (job->reply ? "active" : "queued");
+    
+    _cancelledCount++;
+    _removeJob(job);
+    _startJobs();
+}
+
+void QGCTileScheduler::setViewport(QObject* view, double centerLatitude, double centerLongitude, int zoom)
+{
+    if (!_viewports.contains(view)) {
+        connect(view, &QObject::destroyed, this, &QGCTileScheduler::_viewDestroyed);
+    }
+    
+    Viewport_t& viewport = _viewports[view];
+    viewport.zoom = zoom;
+    viewport.centerX = QGCTileStore::longitudeToTileX(centerLongitude, zoom);
+    viewport.centerY = QGCTileStore::latitudeToTileY(centerLatitude, zoom);
+    viewport.visibleTimer.start();
+    viewport.visiblePending = true;
+}
+
+void QGCTileScheduler::_viewDestroyed(QObject* view)
+{
+    _viewports.remove(view);
+}
+
+/// @return Priority of a queued job, lower values are started first. A job is as urgent as it is for the view
+///         it is nearest to.
+double QGCTileScheduler::_priority(const Job_t* job)
+{
+    double priority = 0;
+    bool first = true;
+    
+    foreach (const Viewport_t& viewport, _viewports) {
+        double viewPriority = _viewportPriority(job, viewport);
+        if (first || viewPriority < priority) {
+            priority = viewPriority;
+            first = false;
+        }
+    }
+    
+    return priority;
+}
+
+double QGCTileScheduler::_viewportPriority(const Job_t* job, const Viewport_t& viewport)
+{
+    // Distance from the viewport center in tiles at the viewport zoom. Other zooms only come after all tiles
+    // at the viewport zoom.
+    double scale = ldexp(1.0, job->coord.zoom - viewport.zoom);
+    double dx = (job->coord.x + 0.5) / scale - viewport.centerX;
+    double dy = (job->coord.y + 0.5) / scale - viewport.centerY;
+    
+    return qAbs(job->coord.zoom - viewport.zoom) * 1.0e6 + sqrt(dx * dx + dy * dy);
+}
+
+bool QGCTileScheduler::_higherPriority(const Job_t* job1, const Job_t* job2)
+{
+    double priority1 = _priority(job1);
+    double priority2 = _priority(job2);
+    
+    if (priority1 == priority2) {
+        return job1->sequence < job2->sequence;
+    }
+    return priority1 < priority2;
+}
+
+/// Starts the highest priority queued jobs for each provider which has free request slots
+void QGCTileScheduler::_startJobs(void)
+{
+    while (true) {
+        Job_t* bestJob = NULL;
+        
+        foreach (Job_t* job, _pendingJobs) {
+            if (_activePerProvider.value(job->provider, 0) >= _maxActivePerProvider) {
+                continue;
+            }
+            if (!bestJob || _higherPriority(job, bestJob)) {
+                bestJob = job;
+            }
+        }
+        
+        if (!bestJob) {
+            break;
+        }
+        
+        _pendingJobs.removeOne(bestJob);
+        _activePerProvider[bestJob->provider]++;
+        
+        bestJob->reply = _networkManager->get(bestJob->request);
+        _replyJobs[bestJob->reply] = bestJob;
+        connect(bestJob->reply, &QNetworkReply::finished, this, &QGCTileScheduler::_replyFinished);
+    }
+}
+
+void QGCTileScheduler::_replyFinished(void)
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    Job_t* job = _replyJobs.value(reply, NULL);
+    if (!job) {
+        return;
+    }
+    
+    QList<QGCTileRequester*> requesters = job->requesters;
+    int zoom = job->coord.zoom;
+    QNetworkReply::NetworkError error = reply->error();
+    QString errorString = reply->errorString();
+    QByteArray data;
+    if (error == QNetworkReply::NoError) {
+        data = reply->readAll();
+    }
+    
+    // The job is gone before the requesters hear about it, so they are free to request the tile again
+    _removeJob(job);
+    
+    foreach (QGCTileRequester* requester, requesters) {
+        if (error == QNetworkReply::NoError) {
+            requester->tileDownloaded(data);
+        } else {
+            requester->tileDownloadFailed(error, errorString);
+        }
+    }
+    
+    _startJobs();
+    _checkVisibleComplete(zoom);
+}
+
+/// Removes the job, aborting its download if it is running
+void QGCTileScheduler::_removeJob(Job_t* job)
+{
+    if (job->reply) {
+        QNetworkReply* reply = job->reply;
+        
+        _replyJobs.remove(reply);
+        _activePerProvider[job->provider]--;
+        
+        disconnect(reply, 0, this, 0);
+        if (reply->isRunning()) {
+            reply->abort();
+        }
+        reply->deleteLater();
+    } else {
+        _pendingJobs.removeOne(job);
+    }
+    
+    _jobs.remove(QGCTileStore::tileKey(job->coord));
+    delete job;
+}
+
+/// Records the time to visible tiles for each view at the zoom once its last tile is done
+void QGCTileScheduler::_checkVisibleComplete(int zoom)
+{
+    bool pending = false;
+    foreach (const Viewport_t& viewport, _viewports) {
+        if (viewport.visiblePending && viewport.zoom == zoom) {
+            pending = true;
+        }
+    }
+    if (!pending) {
+        return;
+    }
+    
+    foreach (const Job_t* job, _jobs) {
+        if (job->coord.zoom == zoom) {
+            return;
+        }
+    }
+    
+    // Collected first, a slot connected to the signal may change the viewports
+    QList<int> completedMsecs;
+    QHash<QObject*, Viewport_t>::iterator iter;
+    for (iter = _viewports.begin(); iter != _viewports.end(); ++iter) {
+        Viewport_t& viewport = iter.value();
+        if (viewport.visiblePending && viewport.zoom == zoom) {
+            viewport.visiblePending = false;
+            completedMsecs.append(viewport.visibleTimer.elapsed());
+        }
+    }
+    
+    foreach (int msecs, completedMsecs) {
+        _lastTimeToVisibleMsecs = msecs;
+        
+        qCDebug(QGCTileSchedulerLog) << "Time to visible tiles" << msecs << "msecs, zoom" << zoom;
+        emit visibleTilesComplete(msecs);
+    }
+}
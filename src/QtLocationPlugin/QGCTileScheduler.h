@@ -0,0 +1,149 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef QGCTileScheduler_H
+#define QGCTileScheduler_H
+
+#include "QGCTileStore.h"
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+Q_DECLARE_LOGGING_CATEGORY(QGCTileSchedulerLog)
+
+class QNetworkAccessManager;
+
+/// @file
+///     @brief Schedules tile downloads for the map. Each provider only gets a limited number of requests at a time.
+///             Queued requests are started nearest to the viewport of any map view first, at the viewport zoom
+///             before other zooms.
+///             Requests for a tile which is already queued or downloading share the download, and a download is
+///             aborted as soon as nobody wants the tile anymore.
+
+/// Receives the result of a tile download
+class QGCTileRequester
+{
+public:
+    virtual ~QGCTileRequester() { }
+    
+    virtual void tileDownloaded(const QByteArray& data) = 0;
+    virtual void tileDownloadFailed(QNetworkReply::NetworkError error, const QString& errorString) = 0;
+};
+
+class QGCTileScheduler : public QObject
+{
+    Q_OBJECT
+    
+public:
+    QGCTileScheduler(QNetworkAccessManager* networkManager, QObject* parent = NULL);
+    ~QGCTileScheduler();
+    
+    /// Maximum number of downloads running at the same time for a single provider (url host)
+    int maxActivePerProvider(void) { return _maxActivePerProvider; }
+    void setMaxActivePerProvider(int maxActive) { _maxActivePerProvider = maxActive; }
+    
+    /// Queues a tile download. The requester is called back once the tile is downloaded, unless it cancels first.
+    void requestTile(const QGCTileStore::TileCoord_t& coord, const QNetworkRequest& request, QGCTileRequester* requester);
+    
+    /// Withdraws a request. Once no requester is left the queued request is dropped or the download aborted.
+    void cancelTile(const QGCTileStore::TileCoord_t& coord, QGCTileRequester* requester);
+    
+    /// Sets the viewport of a map view. Queued requests are prioritized by the nearest viewport of all views. Also
+    /// starts the time to visible tiles measurement for the view, the measurements of other views carry on.
+    ///     @param view Map view, its viewport is dropped when it is destroyed
+    void setViewport(QObject* view, double centerLatitude, double centerLongitude, int zoom);
+    
+    int viewportCount(void) { return _viewports.count(); }
+    
+    int pendingCount(void) { return _pendingJobs.count(); }
+    int activeCount(void) { return _jobs.count() - _pendingJobs.count(); }
+    
+    /// Requests which shared a download with an earlier request for the same tile
+    quint32 coalescedCount(void) { return _coalescedCount; }
+    
+    /// Queued requests dropped and downloads aborted because nobody wanted the tile anymore
+    quint32 cancelledCount(void) { return _cancelledCount; }
+    
+    /// @return Msecs from a view's viewport change until no tiles at its zoom were left to download, for the view
+    ///         which completed last. -1 if not measured yet.
+    int lastTimeToVisibleMsecs(void) { return _lastTimeToVisibleMsecs; }
+    
+signals:
+    /// Signalled when all tiles at a view's zoom have been downloaded after its viewport changed
+    void visibleTilesComplete(int msecs);
+    
+private slots:
+    void _startJobs(void);
+    void _replyFinished(void);
+    void _viewDestroyed(QObject* view);
+    
+private:
+    typedef struct {
+        QGCTileStore::TileCoord_t   coord;
+        QNetworkRequest             request;
+        QString                     provider;
+        QList<QGCTileRequester*>    requesters;
+        QNetworkReply*              reply;      ///< NULL while queued
+        quint64                     sequence;   ///< Orders jobs of equal priority by request time
+    } Job_t;
+    
+    typedef struct {
+        int             zoom;
+        double          centerX;            ///< Viewport center tile column at zoom, not rounded
+        double          centerY;            ///< Viewport center tile row at zoom, not rounded
+        QElapsedTimer   visibleTimer;       ///< Time since the viewport changed
+        bool            visiblePending;     ///< true: Time to visible tiles not recorded yet for the viewport
+    } Viewport_t;
+    
+    double _priority(const Job_t* job);
+    static double _viewportPriority(const Job_t* job, const Viewport_t& viewport);
+    bool _higherPriority(const Job_t* job1, const Job_t* job2);
+    void _removeJob(Job_t* job);
+    void _checkVisibleComplete(int zoom);
+    
+    QNetworkAccessManager*  _networkManager;
+    int                     _maxActivePerProvider;
+    
+    QHash<quint64, Job_t*>  _jobs;                  ///< All queued and active jobs, keyed by QGCTileStore::tileKey
+    QList<Job_t*>           _pendingJobs;           ///< Jobs which are queued
+    QHash<QString, int>     _activePerProvider;
+    QHash<QNetworkReply*, Job_t*> _replyJobs;
+    quint64                 _nextSequence;
+    QTimer                  _startTimer;            ///< Starts queued jobs once the current batch of requests is in
+    
+    QHash<QObject*, Viewport_t> _viewports;         ///< Viewport of each map view
+    int                         _lastTimeToVisibleMsecs;
+    
+    quint32 _coalescedCount;
+    quint32 _cancelledCount;
+    
+    static const int _defaultMaxActivePerProvider = 6;
+};
+
+#endif
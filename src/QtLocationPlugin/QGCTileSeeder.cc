@@ -0,0 +1,256 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "QGCTileSeeder.h"
+#include "qgeotilefetcherqgc.h"
+#include "OpenPilotMaps.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QLocale>
+#include <QPointF>
+#include <QDebug>
+
+#include <math.h>
+
+QGCTileSeeder::QGCTileSeeder(QGCTileStore* store, QObject* parent)
+    : QObject(parent)
+    , _store(store)
+    , _networkManager(new QNetworkAccessManager(this))
+    , _urlFactory(NULL)
+    , _userAgent("Mozilla/5.0 (Windows; U; Windows NT 6.0; en-US; rv:1.9.1.7) Gecko/20091221 Firefox/3.5.7")
+    , _totalCount(0)
+    , _doneCount(0)
+    , _downloadedCount(0)
+    , _skippedCount(0)
+    , _failedCount(0)
+{
+    Q_ASSERT(_store);
+    
+    QStringList langs = QLocale::system().uiLanguages();
+    if (langs.length() > 0) {
+        _language = langs[0];
+    }
+}
+
+QGCTileSeeder::~QGCTileSeeder()
+{
+    cancel();
+    delete _urlFactory;
+}
+
+QList<QGCTileStore::TileCoord_t> QGCTileSeeder::tilesInPolygon(int mapType, const QList<QGeoCoordinate>& polygon, int minZoom, int maxZoom)
+{
+    QList<QGCTileStore::TileCoord_t> tiles;
+    
+    if (polygon.isEmpty()) {
+        return tiles;
+    }
+    
+    for (int zoom=minZoom; zoom<=maxZoom; zoom++) {
+        int tileCount = 1 << zoom;
+        
+        QList<QPointF> points;
+        double minY = tileCount;
+        double maxY = 0;
+        foreach (const QGeoCoordinate& coord, polygon) {
+            QPointF point(QGCTileStore::longitudeToTileX(coord.longitude(), zoom), QGCTileStore::latitudeToTileY(coord.latitude(), zoom));
+            
+            points.append(point);
+            minY = qMin(minY, point.y());
+            maxY = qMax(maxY, point.y());
+        }
+        
+        int firstRow = qBound(0, (int)floor(minY), tileCount - 1);
+        int lastRow = qBound(0, (int)floor(maxY), tileCount - 1);
+        
+        for (int row=firstRow; row<=lastRow; row++) {
+            // The polygon's extent within the row band lies on its edges, so clipping each edge to the band
+            // gives the westernmost and easternmost tile of the row
+            double minX = tileCount;
+            double maxX = -1;
+            
+            for (int i=0; i<points.count(); i++) {
+                const QPointF& p1 = points[i];
+                const QPointF& p2 = points[(i + 1) % points.count()];
+                
+                double edgeMinY = qMin(p1.y(), p2.y());
+                double edgeMaxY = qMax(p1.y(), p2.y());
+                if (edgeMaxY < row || edgeMinY > row + 1) {
+                    continue;
+                }
+                
+                if (p1.y() == p2.y()) {
+                    minX = qMin(minX, qMin(p1.x(), p2.x()));
+                    maxX = qMax(maxX, qMax(p1.x(), p2.x()));
+                } else {
+                    double slope = (p2.x() - p1.x()) / (p2.y() - p1.y());
+                    double x1 = p1.x() + (qMax(edgeMinY, (double)row) - p1.y()) * slope;
+                    double x2 = p1.x() + (qMin(edgeMaxY, (double)(row + 1)) - p1.y()) * slope;
+                    
+                    minX = qMin(minX, qMin(x1, x2));
+                    maxX = qMax(maxX, qMax(x1, x2));
+                }
+            }
+            
+            if (minX > maxX) {
+                continue;
+            }
+            
+            int firstColumn = qBound(0, (int)floor(minX), tileCount - 1);
+            int lastColumn = qBound(0, (int)floor(maxX), tileCount - 1);
+            for (int column=firstColumn; column<=lastColumn; column++) {
+                QGCTileStore::TileCoord_t tile;
+                
+                tile.mapType = mapType;
+                tile.zoom = zoom;
+                tile.x = column;
+                tile.y = row;
+                tiles.append(tile);
+            }
+        }
+    }
+    
+    return tiles;
+}
+
+bool QGCTileSeeder::seedRegion(int mapType, const QList<QGeoCoordinate>& polygon, int minZoom, int maxZoom)
+{
+    if (running()) {
+        qWarning() << "QGCTileSeeder seed already running";
+        return false;
+    }
+    
+    QList<QGCTileStore::TileCoord_t> tiles = tilesInPolygon(mapType, polygon, minZoom, maxZoom);
+    if (tiles.count() > maxSeedTiles) {
+        qWarning() << "QGCTileSeeder region too large, tiles:" << tiles.count();
+        return false;
+    }
+    if (tiles.isEmpty()) {
+        emit seedComplete(0, 0, 0);
+        return true;
+    }
+    
+    _pendingTiles = tiles;
+    _totalCount = tiles.count();
+    _doneCount = 0;
+    _downloadedCount = 0;
+    _skippedCount = 0;
+    _failedCount = 0;
+    
+    _requestTiles();
+    
+    return true;
+}
+
+void QGCTileSeeder::cancel(void)
+{
+    if (!running()) {
+        return;
+    }
+    
+    _pendingTiles.clear();
+    
+    // Aborting signals finished, which completes the seed once the last reply is gone
+    foreach (QNetworkReply* reply, _activeReplies.keys()) {
+        reply->abort();
+    }
+}
+
+/// Keeps up to _maxActiveRequests downloads running
+void QGCTileSeeder::_requestTiles(void)
+{
+    while (_activeReplies.count() < _maxActiveRequests && !_pendingTiles.isEmpty()) {
+        QGCTileStore::TileCoord_t coord = _pendingTiles.takeFirst();
+        
+        // A tile the map already downloaded is pinned in place rather than downloaded again
+        if (_store->pinTile(coord)) {
+            _skippedCount++;
+            _tileDone();
+            continue;
+        }
+        
+        QNetworkRequest request = QGeoTileFetcherQGC::makeTileRequest(_tileUrl(coord), coord.mapType, _userAgent);
+        QNetworkReply* reply = _networkManager->get(request);
+        
+        _activeReplies[reply] = coord;
+        connect(reply, &QNetworkReply::finished, this, &QGCTileSeeder::_replyFinished);
+    }
+    
+    if (_totalCount != 0 && _pendingTiles.isEmpty() && _activeReplies.isEmpty()) {
+        int downloadedCount = _downloadedCount;
+        int skippedCount = _skippedCount;
+        int failedCount = _failedCount;
+        
+        _totalCount = 0;
+        emit seedComplete(downloadedCount, skippedCount, failedCount);
+    }
+}
+
+void QGCTileSeeder::_replyFinished(void)
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply || !_activeReplies.contains(reply)) {
+        return;
+    }
+    
+    QGCTileStore::TileCoord_t coord = _activeReplies.take(reply);
+    reply->deleteLater();
+    
+    if (reply->error() == QNetworkReply::NoError) {
+        QByteArray data = reply->readAll();
+        QString format = QGCTileStore::imageFormat(data, coord.mapType);
+        
+        if (!format.isEmpty() && _store->storeTile(coord, data, format, true /* pinned */)) {
+            _downloadedCount++;
+        } else {
+            _failedCount++;
+        }
+    } else {
+        if (reply->error() != QNetworkReply::OperationCanceledError) {
+            qWarning() << "QGCTileSeeder tile download failed" << coord.zoom << coord.x << coord.y << reply->errorString();
+        }
+        _failedCount++;
+    }
+    
+    _tileDone();
+    _requestTiles();
+}
+
+void QGCTileSeeder::_tileDone(void)
+{
+    _doneCount++;
+    emit seedProgress(_doneCount, _totalCount);
+}
+
+QString QGCTileSeeder::_tileUrl(const QGCTileStore::TileCoord_t& coord)
+{
+    if (!_urlTemplate.isEmpty()) {
+        return QGeoTileFetcherQGC::expandUrlTemplate(_urlTemplate, coord.x, coord.y, coord.zoom);
+    }
+    
+    if (!_urlFactory) {
+        _urlFactory = new OpenPilot::UrlFactory(_networkManager);
+    }
+    return _urlFactory->makeImageUrl((OpenPilot::MapType)coord.mapType, QPoint(coord.x, coord.y), coord.zoom, _language);
+}
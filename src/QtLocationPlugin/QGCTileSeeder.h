@@ -0,0 +1,114 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef QGCTileSeeder_H
+#define QGCTileSeeder_H
+
+#include "QGCTileStore.h"
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QGeoCoordinate>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+namespace OpenPilot {
+    class UrlFactory;
+}
+
+/// @file
+///     @brief Pre-seeds a QGCTileStore with all tiles covering a region over a range of zoom levels, so the
+///             region can be flown without connectivity. Seeded tiles are pinned so browsing other areas does not
+///             evict them. Tiles already in the store are pinned in place instead of downloaded again.
+
+class QGCTileSeeder : public QObject
+{
+    Q_OBJECT
+    
+public:
+    /// @param store Store to seed, must outlive the seeder
+    QGCTileSeeder(QGCTileStore* store, QObject* parent = NULL);
+    ~QGCTileSeeder();
+    
+    void setUserAgent(const QByteArray& userAgent) { _userAgent = userAgent; }
+    
+    /// Url used to download tiles, with {x}, {y} and {z} replaced by the tile location. When empty (the default)
+    /// the map provider url for the map type is used.
+    void setUrlTemplate(const QString& urlTemplate) { _urlTemplate = urlTemplate; }
+    
+    /// @return All tiles which cover the polygon. Within each tile row all tiles between the westernmost and
+    ///         easternmost polygon edge are returned, so concave polygons may get a few extra tiles.
+    ///         Polygons must not cross the antimeridian.
+    static QList<QGCTileStore::TileCoord_t> tilesInPolygon(int mapType, const QList<QGeoCoordinate>& polygon, int minZoom, int maxZoom);
+    
+    /// Starts downloading all tiles covering the polygon which are not in the store yet
+    ///     @param mapType OpenPilot::MapType of the tiles
+    /// @return false: A seed is already running, or the region has more than maxSeedTiles tiles
+    bool seedRegion(int mapType, const QList<QGeoCoordinate>& polygon, int minZoom, int maxZoom);
+    
+    /// Stops the running seed. Tiles downloaded so far stay in the store.
+    void cancel(void);
+    
+    bool running(void) { return _totalCount != 0; }
+    
+    static const int maxSeedTiles = 100000;    ///< Upper limit on tiles in a single seed
+    
+signals:
+    void seedProgress(int doneCount, int totalCount);
+    
+    /// Signalled when all tiles of the seed have been handled, or the seed was cancelled
+    ///     @param downloadedCount Tiles downloaded and stored
+    ///     @param skippedCount Tiles which were in the store already, these are pinned now
+    ///     @param failedCount Tiles which failed to download
+    void seedComplete(int downloadedCount, int skippedCount, int failedCount);
+    
+private slots:
+    void _replyFinished(void);
+    
+private:
+    void _requestTiles(void);
+    void _tileDone(void);
+    QString _tileUrl(const QGCTileStore::TileCoord_t& coord);
+    
+    QGCTileStore*           _store;
+    QNetworkAccessManager*  _networkManager;
+    OpenPilot::UrlFactory*  _urlFactory;        ///< Created when the first provider url is needed
+    QByteArray              _userAgent;
+    QString                 _urlTemplate;
+    QString                 _language;
+    
+    QList<QGCTileStore::TileCoord_t>                    _pendingTiles;
+    QHash<QNetworkReply*, QGCTileStore::TileCoord_t>    _activeReplies;
+    
+    int     _totalCount;
+    int     _doneCount;
+    int     _downloadedCount;
+    int     _skippedCount;
+    int     _failedCount;
+    
+    static const int _maxActiveRequests = 4;
+};
+
+#endif
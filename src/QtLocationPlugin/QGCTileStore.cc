@@ -0,0 +1,592 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "QGCTileStore.h"
+#include "OpenPilotMaps.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QList>
+#include <QDebug>
+
+#include <math.h>
+
+QGCTileStore* QGCTileStore::_mapStore = NULL;
+
+QGCTileStore::QGCTileStore(const QString& databaseFile, qint64 maxBytes, QObject* parent)
+    : QObject(parent)
+    , _databaseFile(databaseFile)
+    , _connectionName(QString("QGCTileStore_%1").arg((quintptr)this, 0, 16))
+    , _open(false)
+    , _maxBytes(maxBytes)
+    , _totalBytes(0)
+    , _pinnedBytes(0)
+    , _useCounter(0)
+    , _hitCount(0)
+    , _missCount(0)
+{
+    _flushTimer.setSingleShot(true);
+    _flushTimer.setInterval(_flushMsecs);
+    connect(&_flushTimer, &QTimer::timeout, this, &QGCTileStore::_flushTimeout);
+    
+    _open = _openDatabase();
+    if (_open) {
+        _enforceMaxBytes();
+    }
+}
+
+QGCTileStore::~QGCTileStore()
+{
+    if (_mapStore == this) {
+        _mapStore = NULL;
+    }
+    
+    {
+        QSqlDatabase db = QSqlDatabase::database(_connectionName, false);
+        if (db.isOpen()) {
+            flush();
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(_connectionName);
+}
+
+bool QGCTileStore::_openDatabase(void)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", _connectionName);
+    db.setDatabaseName(_databaseFile);
+    if (!db.open()) {
+        qWarning() << "QGCTileStore unable to open tile database" << _databaseFile << db.lastError().text();
+        return false;
+    }
+    
+    QSqlQuery query(db);
+    
+    // Rollback journal rather than WAL so the store stays a single file
+    query.exec("PRAGMA synchronous = NORMAL");
+    
+    if (!query.exec("CREATE TABLE IF NOT EXISTS Tiles ("
+                        "mapType INTEGER NOT NULL, "
+                        "zoom INTEGER NOT NULL, "
+                        "x INTEGER NOT NULL, "
+                        "y INTEGER NOT NULL, "
+                        "format TEXT NOT NULL, "
+                        "size INTEGER NOT NULL, "
+                        "lastUsed INTEGER NOT NULL, "
+                        "pinned INTEGER NOT NULL DEFAULT 0, "
+                        "data BLOB NOT NULL, "
+                        "PRIMARY KEY (mapType, zoom, x, y))") ||
+            !query.exec("CREATE INDEX IF NOT EXISTS TilesEviction ON Tiles (pinned, lastUsed)")) {
+        qWarning() << "QGCTileStore unable to create tile table" << _databaseFile << query.lastError().text();
+        db.close();
+        return false;
+    }
+    
+    _loadTotals();
+    
+    return true;
+}
+
+void QGCTileStore::_loadTotals(void)
+{
+    QSqlQuery query(QSqlDatabase::database(_connectionName));
+    
+    if (query.exec("SELECT COALESCE(SUM(size), 0), COALESCE(SUM(CASE WHEN pinned THEN size ELSE 0 END), 0), COALESCE(MAX(lastUsed), 0) FROM Tiles") && query.next()) {
+        _totalBytes = query.value(0).toLongLong();
+        _pinnedBytes = query.value(1).toLongLong();
+        _useCounter = qMax(_useCounter, query.value(2).toLongLong());
+    }
+}
+
+void QGCTileStore::setMaxBytes(qint64 maxBytes)
+{
+    _maxBytes = maxBytes;
+    if (_open) {
+        _enforceMaxBytes();
+    }
+}
+
+void QGCTileStore::_enforceMaxBytes(void)
+{
+    QSqlDatabase db = QSqlDatabase::database(_connectionName);
+    
+    db.transaction();
+    if (_flushUses() && _flushTiles() && _evict()) {
+        db.commit();
+    } else {
+        db.rollback();
+        _loadTotals();
+    }
+}
+
+int QGCTileStore::tileCount(void)
+{
+    if (!_open) {
+        return 0;
+    }
+    
+    QSqlQuery query(QSqlDatabase::database(_connectionName));
+    if (query.exec("SELECT COUNT(*) FROM Tiles") && query.next()) {
+        return query.value(0).toInt();
+    }
+    return 0;
+}
+
+bool QGCTileStore::contains(const TileCoord_t& coord)
+{
+    if (!_open) {
+        return false;
+    }
+    if (_queuedTiles.contains(tileKey(coord))) {
+        return true;
+    }
+    
+    QSqlQuery query(QSqlDatabase::database(_connectionName));
+    query.prepare("SELECT 1 FROM Tiles WHERE mapType = ? AND zoom = ? AND x = ? AND y = ?");
+    query.addBindValue(coord.mapType);
+    query.addBindValue(coord.zoom);
+    query.addBindValue(coord.x);
+    query.addBindValue(coord.y);
+    
+    return query.exec() && query.next();
+}
+
+bool QGCTileStore::fetchTile(const TileCoord_t& coord, QByteArray& data, QString& format)
+{
+    if (!_open) {
+        _missCount++;
+        return false;
+    }
+    
+    QHash<quint64, QueuedTile_t>::iterator queued = _queuedTiles.find(tileKey(coord));
+    if (queued != _queuedTiles.end()) {
+        data = queued->data;
+        format = queued->format;
+        queued->lastUsed = ++_useCounter;
+        _hitCount++;
+        return true;
+    }
+    
+    QSqlQuery query(QSqlDatabase::database(_connectionName));
+    query.prepare("SELECT data, format FROM Tiles WHERE mapType = ? AND zoom = ? AND x = ? AND y = ?");
+    query.addBindValue(coord.mapType);
+    query.addBindValue(coord.zoom);
+    query.addBindValue(coord.x);
+    query.addBindValue(coord.y);
+    
+    if (!query.exec() || !query.next()) {
+        _missCount++;
+        return false;
+    }
+    
+    data = query.value(0).toByteArray();
+    format = query.value(1).toString();
+    
+    // A map view fetches many tiles at once, writing each use stamp in its own transaction would make every
+    // hit a disk sync
+    TileUse_t use;
+    use.coord = coord;
+    use.lastUsed = ++_useCounter;
+    _pendingUses.append(use);
+    _startFlushTimer();
+    
+    _hitCount++;
+    return true;
+}
+
+bool QGCTileStore::storeTile(const TileCoord_t& coord, const QByteArray& data, const QString& format, bool pinned)
+{
+    if (!_open || data.isEmpty()) {
+        return false;
+    }
+    
+    // The tile written here supersedes a queued one
+    _queuedTiles.remove(tileKey(coord));
+    
+    QSqlDatabase db = QSqlDatabase::database(_connectionName);
+    
+    db.transaction();
+    
+    // Pending use stamps and tiles go first so they can't overwrite the new tile later
+    if (!_flushUses() || !_flushTiles() || !_writeTile(coord, data, format, ++_useCounter, pinned) || !_evict()) {
+        db.rollback();
+        _loadTotals();
+        return false;
+    }
+    
+    if (!db.commit()) {
+        qWarning() << "QGCTileStore unable to commit tile" << db.lastError().text();
+        _loadTotals();
+        return false;
+    }
+    
+    return true;
+}
+
+void QGCTileStore::queueTile(const TileCoord_t& coord, const QByteArray& data, const QString& format)
+{
+    if (!_open || data.isEmpty()) {
+        return;
+    }
+    
+    // Downloads arrive a tile at a time while the map is panned, each in its own transaction would mean a disk sync
+    // and an eviction pass per tile
+    QueuedTile_t tile;
+    tile.coord = coord;
+    tile.data = data;
+    tile.format = format;
+    tile.lastUsed = ++_useCounter;
+    _queuedTiles[tileKey(coord)] = tile;
+    
+    if (_queuedTiles.count() >= _maxQueuedTiles) {
+        flush();
+    } else {
+        _startFlushTimer();
+    }
+}
+
+bool QGCTileStore::pinTile(const TileCoord_t& coord)
+{
+    if (!_open) {
+        return false;
+    }
+    
+    QSqlDatabase db = QSqlDatabase::database(_connectionName);
+    QSqlQuery query(db);
+    
+    db.transaction();
+    
+    // A queued tile must be in the table before it can be pinned
+    if (!_flushUses() || !_flushTiles()) {
+        db.rollback();
+        _loadTotals();
+        return false;
+    }
+    
+    bool found = false;
+    query.prepare("SELECT size, pinned FROM Tiles WHERE mapType = ? AND zoom = ? AND x = ? AND y = ?");
+    query.addBindValue(coord.mapType);
+    query.addBindValue(coord.zoom);
+    query.addBindValue(coord.x);
+    query.addBindValue(coord.y);
+    if (query.exec() && query.next()) {
+        found = true;
+        
+        qint64 size = query.value(0).toLongLong();
+        bool pinned = query.value(1).toBool();
+        query.finish();
+        
+        if (!pinned) {
+            query.prepare("UPDATE Tiles SET pinned = 1 WHERE mapType = ? AND zoom = ? AND x = ? AND y = ?");
+            query.addBindValue(coord.mapType);
+            query.addBindValue(coord.zoom);
+            query.addBindValue(coord.x);
+            query.addBindValue(coord.y);
+            if (!query.exec()) {
+                qWarning() << "QGCTileStore unable to pin tile" << query.lastError().text();
+                db.rollback();
+                _loadTotals();
+                return false;
+            }
+            _pinnedBytes += size;
+        }
+    }
+    query.finish();
+    
+    if (!_evict()) {
+        db.rollback();
+        _loadTotals();
+        return false;
+    }
+    
+    if (!db.commit()) {
+        qWarning() << "QGCTileStore unable to commit tile pin" << db.lastError().text();
+        _loadTotals();
+        return false;
+    }
+    
+    return found;
+}
+
+/// Writes a single tile. Must be called within a transaction.
+///     @param pinned true: Tile is never evicted. A pinned tile stays pinned when it is replaced.
+///     @return false: Database error
+bool QGCTileStore::_writeTile(const TileCoord_t& coord, const QByteArray& data, const QString& format, qint64 lastUsed, bool pinned)
+{
+    QSqlQuery query(QSqlDatabase::database(_connectionName));
+    
+    // Size of the tile being replaced, if any, so the byte count stays exact
+    qint64  replacedSize = 0;
+    bool    replacedPinned = false;
+    query.prepare("SELECT size, pinned FROM Tiles WHERE mapType = ? AND zoom = ? AND x = ? AND y = ?");
+    query.addBindValue(coord.mapType);
+    query.addBindValue(coord.zoom);
+    query.addBindValue(coord.x);
+    query.addBindValue(coord.y);
+    if (query.exec() && query.next()) {
+        replacedSize = query.value(0).toLongLong();
+        replacedPinned = query.value(1).toBool();
+    }
+    query.finish();
+    
+    pinned = pinned || replacedPinned;
+    
+    query.prepare("INSERT OR REPLACE INTO Tiles (mapType, zoom, x, y, format, size, lastUsed, pinned, data) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    query.addBindValue(coord.mapType);
+    query.addBindValue(coord.zoom);
+    query.addBindValue(coord.x);
+    query.addBindValue(coord.y);
+    query.addBindValue(format);
+    query.addBindValue((qint64)data.size());
+    query.addBindValue(lastUsed);
+    query.addBindValue(pinned ? 1 : 0);
+    query.addBindValue(data);
+    if (!query.exec()) {
+        qWarning() << "QGCTileStore unable to store tile" << query.lastError().text();
+        return false;
+    }
+    
+    _totalBytes += data.size() - replacedSize;
+    if (replacedPinned) {
+        _pinnedBytes -= replacedSize;
+    }
+    if (pinned) {
+        _pinnedBytes += data.size();
+    }
+    
+    return true;
+}
+
+/// Deletes least recently used unpinned tiles until the store is within its size limit
+///     @return false: Database error
+bool QGCTileStore::_evict(void)
+{
+    QSqlDatabase db = QSqlDatabase::database(_connectionName);
+    
+    while (_totalBytes - _pinnedBytes > _maxBytes) {
+        typedef struct {
+            TileCoord_t coord;
+            qint64      size;
+        } Victim_t;
+        
+        QList<Victim_t> victims;
+        
+        QSqlQuery selectQuery(db);
+        selectQuery.prepare("SELECT mapType, zoom, x, y, size FROM Tiles WHERE pinned = 0 ORDER BY lastUsed ASC LIMIT ?");
+        selectQuery.addBindValue(_evictBatchCount);
+        if (!selectQuery.exec()) {
+            qWarning() << "QGCTileStore unable to select tiles for eviction" << selectQuery.lastError().text();
+            return false;
+        }
+        while (selectQuery.next()) {
+            Victim_t victim;
+            
+            victim.coord.mapType = selectQuery.value(0).toInt();
+            victim.coord.zoom = selectQuery.value(1).toInt();
+            victim.coord.x = selectQuery.value(2).toInt();
+            victim.coord.y = selectQuery.value(3).toInt();
+            victim.size = selectQuery.value(4).toLongLong();
+            victims.append(victim);
+        }
+        selectQuery.finish();
+        
+        if (victims.isEmpty()) {
+            // Byte count is out of sync with the table
+            _totalBytes = _pinnedBytes;
+            break;
+        }
+        
+        QSqlQuery deleteQuery(db);
+        deleteQuery.prepare("DELETE FROM Tiles WHERE mapType = ? AND zoom = ? AND x = ? AND y = ?");
+        foreach (const Victim_t& victim, victims) {
+            if (_totalBytes - _pinnedBytes <= _maxBytes) {
+                break;
+            }
+            
+            deleteQuery.addBindValue(victim.coord.mapType);
+            deleteQuery.addBindValue(victim.coord.zoom);
+            deleteQuery.addBindValue(victim.coord.x);
+            deleteQuery.addBindValue(victim.coord.y);
+            if (!deleteQuery.exec()) {
+                qWarning() << "QGCTileStore unable to evict tile" << deleteQuery.lastError().text();
+                return false;
+            }
+            _totalBytes -= victim.size;
+        }
+    }
+    
+    return true;
+}
+
+/// Writes the pending use stamps. Must be called within a transaction. Stamps which fail to write are dropped,
+/// they only order eviction.
+///     @return false: Database error
+bool QGCTileStore::_flushUses(void)
+{
+    if (_pendingUses.isEmpty()) {
+        return true;
+    }
+    
+    QList<TileUse_t> uses = _pendingUses;
+    _pendingUses.clear();
+    
+    QSqlQuery query(QSqlDatabase::database(_connectionName));
+    query.prepare("UPDATE Tiles SET lastUsed = ? WHERE mapType = ? AND zoom = ? AND x = ? AND y = ?");
+    foreach (const TileUse_t& use, uses) {
+        query.addBindValue(use.lastUsed);
+        query.addBindValue(use.coord.mapType);
+        query.addBindValue(use.coord.zoom);
+        query.addBindValue(use.coord.x);
+        query.addBindValue(use.coord.y);
+        if (!query.exec()) {
+            qWarning() << "QGCTileStore unable to update tile use" << query.lastError().text();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/// Writes the queued tiles. Must be called within a transaction. Tiles which fail to write are dropped, the map
+/// downloads them again.
+///     @return false: Database error
+bool QGCTileStore::_flushTiles(void)
+{
+    if (_queuedTiles.isEmpty()) {
+        return true;
+    }
+    
+    QHash<quint64, QueuedTile_t> tiles = _queuedTiles;
+    _queuedTiles.clear();
+    
+    foreach (const QueuedTile_t& tile, tiles) {
+        if (!_writeTile(tile.coord, tile.data, tile.format, tile.lastUsed, false /* pinned */)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+void QGCTileStore::flush(void)
+{
+    if (!_open || (_pendingUses.isEmpty() && _queuedTiles.isEmpty())) {
+        return;
+    }
+    
+    _flushTimer.stop();
+    
+    QSqlDatabase db = QSqlDatabase::database(_connectionName);
+    
+    // One transaction and one eviction pass for the whole batch
+    db.transaction();
+    if (_flushUses() && _flushTiles() && _evict()) {
+        if (!db.commit()) {
+            qWarning() << "QGCTileStore unable to commit tiles" << db.lastError().text();
+            _loadTotals();
+        }
+    } else {
+        db.rollback();
+        _loadTotals();
+    }
+}
+
+void QGCTileStore::_flushTimeout(void)
+{
+    flush();
+}
+
+void QGCTileStore::_startFlushTimer(void)
+{
+    if (!_flushTimer.isActive()) {
+        _flushTimer.start();
+    }
+}
+
+void QGCTileStore::clear(void)
+{
+    if (!_open) {
+        return;
+    }
+    
+    _pendingUses.clear();
+    _queuedTiles.clear();
+    _flushTimer.stop();
+    
+    QSqlQuery query(QSqlDatabase::database(_connectionName));
+    if (query.exec("DELETE FROM Tiles")) {
+        _totalBytes = 0;
+        _pinnedBytes = 0;
+    } else {
+        qWarning() << "QGCTileStore unable to clear tiles" << query.lastError().text();
+    }
+}
+
+quint64 QGCTileStore::tileKey(const TileCoord_t& coord)
+{
+    // x and y are below 2^21 up to zoom 21, zoom below 2^5
+    return ((quint64)coord.mapType << 47) | ((quint64)coord.zoom << 42) | ((quint64)coord.x << 21) | (quint64)coord.y;
+}
+
+double QGCTileStore::longitudeToTileX(double longitude, int zoom)
+{
+    return (longitude + 180.0) / 360.0 * (double)(1 << zoom);
+}
+
+double QGCTileStore::latitudeToTileY(double latitude, int zoom)
+{
+    // Mercator does not reach the poles
+    latitude = qBound(-85.05112878, latitude, 85.05112878);
+    
+    double latitudeRadians = latitude * M_PI / 180.0;
+    return (1.0 - log(tan(latitudeRadians) + 1.0 / cos(latitudeRadians)) / M_PI) / 2.0 * (double)(1 << zoom);
+}
+
+QString QGCTileStore::imageFormat(const QByteArray& data, int mapType)
+{
+    if (data.size() > 2) {
+        if ((char)data[0] == (char)0xff && (char)data[1] == (char)0xd8) {
+            return QString("jpg");
+        } else if ((char)data[0] == (char)0x89 && (char)data[1] == (char)0x50) {
+            return QString("png");
+        }
+    }
+    
+    switch ((OpenPilot::MapType)mapType) {
+        case OpenPilot::GoogleMap:
+        case OpenPilot::GoogleLabels:
+        case OpenPilot::GoogleTerrain:
+        case OpenPilot::GoogleHybrid:
+        case OpenPilot::BingMap:
+        case OpenPilot::OpenStreetMap:
+            return QString("png");
+        case OpenPilot::GoogleSatellite:
+        case OpenPilot::BingSatellite:
+        case OpenPilot::BingHybrid:
+            return QString("jpg");
+        default:
+            return QString();
+    }
+}
@@ -0,0 +1,173 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef QGCTileStore_H
+#define QGCTileStore_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+
+/// @file
+///     @brief Persistent map tile store. Tiles are kept in a single SQLite database file keyed by map type,
+///             zoom, x and y. When the tiles exceed the size limit the least recently used tiles are evicted.
+///             Pinned tiles, such as the ones stored by region seeding, are never evicted and do not count
+///             against the size limit.
+///             The tile fetcher looks tiles up here before going to the network so maps keep working without
+///             connectivity for any area which was viewed or seeded before.
+///
+///             A store must only be used from the thread it was created on.
+
+class QGCTileStore : public QObject
+{
+    Q_OBJECT
+    
+public:
+    /// Location of a single tile
+    typedef struct {
+        int mapType;    ///< OpenPilot::MapType
+        int zoom;
+        int x;
+        int y;
+    } TileCoord_t;
+    
+    /// @param databaseFile Database file to open, created if it does not exist
+    /// @param maxBytes Unpinned tile bytes above which least recently used tiles are evicted
+    QGCTileStore(const QString& databaseFile, qint64 maxBytes, QObject* parent = NULL);
+    ~QGCTileStore();
+    
+    /// @return false: Database could not be opened, all lookups miss and stores are ignored
+    bool isOpen(void) { return _open; }
+    
+    QString databaseFile(void) { return _databaseFile; }
+    
+    qint64 maxBytes(void) { return _maxBytes; }
+    
+    /// Sets the size limit, evicting tiles immediately if the store is over the new limit
+    void setMaxBytes(qint64 maxBytes);
+    
+    /// @return Total bytes of all tiles in the store
+    qint64 totalBytes(void) { return _totalBytes; }
+    
+    /// @return Bytes of the pinned tiles in the store
+    qint64 pinnedBytes(void) { return _pinnedBytes; }
+    
+    int tileCount(void);
+    
+    bool contains(const TileCoord_t& coord);
+    
+    /// Looks up a tile and marks it as the most recently used one. Use stamps are written in batches.
+    ///     @param data Returned: Tile image data
+    ///     @param format Returned: Tile image format, "png" or "jpg"
+    /// @return false: Tile is not in the store
+    bool fetchTile(const TileCoord_t& coord, QByteArray& data, QString& format);
+    
+    /// Adds a tile to the store, replacing the previous tile at the same location
+    ///     @param pinned true: Tile is never evicted. A pinned tile stays pinned when it is replaced.
+    /// @return false: Tile could not be written
+    bool storeTile(const TileCoord_t& coord, const QByteArray& data, const QString& format, bool pinned = false);
+    
+    /// Adds an unpinned tile to the store with the next batch write, which also writes the use stamps and runs a
+    /// single eviction pass. Queued tiles are returned by fetchTile and contains right away, totalBytes and tileCount
+    /// include them once written.
+    void queueTile(const TileCoord_t& coord, const QByteArray& data, const QString& format);
+    
+    /// Writes the queued tiles and use stamps now
+    void flush(void);
+    
+    /// Pins a tile which is already in the store so it is never evicted
+    /// @return false: Tile is not in the store
+    bool pinTile(const TileCoord_t& coord);
+    
+    /// Removes all tiles from the store
+    void clear(void);
+    
+    quint32 hitCount(void) { return _hitCount; }
+    quint32 missCount(void) { return _missCount; }
+    
+    /// @return Image format of the tile data, from the data signature or the map type if the signature is unknown.
+    ///         Empty if neither is known.
+    static QString imageFormat(const QByteArray& data, int mapType);
+    
+    /// @return Value which packs the map type, zoom, x and y of the tile, for hashing tiles
+    static quint64 tileKey(const TileCoord_t& coord);
+    
+    /// @return Web mercator tile column containing the longitude at the zoom level, not rounded
+    static double longitudeToTileX(double longitude, int zoom);
+    
+    /// @return Web mercator tile row containing the latitude at the zoom level, not rounded
+    static double latitudeToTileY(double latitude, int zoom);
+    
+    /// Store used by the map tile fetcher, NULL if none. Region seeding for the map should go through this store.
+    static QGCTileStore* mapStore(void) { return _mapStore; }
+    static void setMapStore(QGCTileStore* store) { _mapStore = store; }
+    
+private slots:
+    void _flushTimeout(void);
+    
+private:
+    typedef struct {
+        TileCoord_t coord;
+        qint64      lastUsed;
+    } TileUse_t;
+    
+    typedef struct {
+        TileCoord_t coord;
+        QByteArray  data;
+        QString     format;
+        qint64      lastUsed;
+    } QueuedTile_t;
+    
+    bool _openDatabase(void);
+    void _loadTotals(void);
+    void _enforceMaxBytes(void);
+    bool _evict(void);
+    bool _flushUses(void);
+    bool _flushTiles(void);
+    bool _writeTile(const TileCoord_t& coord, const QByteArray& data, const QString& format, qint64 lastUsed, bool pinned);
+    void _startFlushTimer(void);
+    
+    QString     _databaseFile;
+    QString     _connectionName;
+    bool        _open;
+    qint64      _maxBytes;
+    qint64      _totalBytes;
+    qint64      _pinnedBytes;
+    qint64      _useCounter;    ///< Last used stamp given to the most recently used tile
+    quint32     _hitCount;
+    quint32     _missCount;
+    
+    QList<TileUse_t>                _pendingUses;   ///< Use stamps not written to the database yet
+    QHash<quint64, QueuedTile_t>    _queuedTiles;   ///< Tiles not written to the database yet, keyed by tileKey
+    QTimer                          _flushTimer;
+    
+    static QGCTileStore*    _mapStore;
+    static const int        _evictBatchCount = 64;  ///< Tiles selected for eviction per query
+    static const int        _flushMsecs = 1000;     ///< Delay before pending use stamps and queued tiles are written
+    static const int        _maxQueuedTiles = 64;   ///< Queued tiles which are written without waiting for the timer
+};
+
+#endif
@@ -47,112 +47,121 @@
 #include <QtLocation/private/qgeotilespec_p.h>
 
 #include "qgeomapreplyqgc.h"
-#include "OpenPilotMaps.h"
+#include "QGCTileStore.h"
 
-QGeoMapReplyQGC::QGeoMapReplyQGC(QNetworkReply *reply, const QGeoTileSpec &spec, QObject *parent)
+QGeoMapReplyQGC::QGeoMapReplyQGC(QGCTileScheduler *scheduler, const QNetworkRequest &request, const QGeoTileSpec &spec, QGCTileStore *tileStore, QObject *parent)
     : QGeoTiledMapReply(spec, parent)
-    , m_reply(reply)
+    , m_scheduler(scheduler)
+    , m_requested(false)
+    , m_decoding(false)
+    , m_tileStore(tileStore)
 {
-    if(!reply)
+    if(!scheduler)
     {
         setError(QGeoTiledMapReply::UnknownError, "Invalid tile request");
         setFinished(true);
     }
     else
     {
-        connect(m_reply, SIGNAL(finished()),                         this, SLOT(networkReplyFinished()));
-        connect(m_reply, SIGNAL(error(QNetworkReply::NetworkError)), this, SLOT(networkReplyError(QNetworkReply::NetworkError)));
-        connect(m_reply, SIGNAL(destroyed()),                        this, SLOT(replyDestroyed()));
+        m_requested = true;
+        m_scheduler->requestTile(tileCoord(), request, this);
     }
 }
 
-QGeoMapReplyQGC::~QGeoMapReplyQGC()
+QGeoMapReplyQGC::QGeoMapReplyQGC(const QByteArray &data, const QString &format, const QGeoTileSpec &spec, QObject *parent)
+    : QGeoTiledMapReply(spec, parent)
+    , m_requested(false)
+    , m_decoding(false)
 {
-    if (m_reply) {
-        m_reply->deleteLater();
-        m_reply = 0;
+    if (format == QGCDecodedTileCache::decodedFormat)
+    {
+        setMapImageData(data);
+        setMapImageFormat(format);
+        setFinished(true);
+    }
+    else
+    {
+        m_decoding = true;
+        QGCDecodedTileCache::instance()->decode(tileCoord(), data, format, this);
     }
 }
 
+QGeoMapReplyQGC::~QGeoMapReplyQGC()
+{
+    //-- The scheduler and decoder must not call back into a deleted reply
+    cancel();
+}
+
 void QGeoMapReplyQGC::abort()
 {
-    if (!m_reply)
+    if (!m_requested && !m_decoding)
         return;
-    m_reply->abort();
+    cancel();
+    setFinished(true);
 }
 
-QNetworkReply *QGeoMapReplyQGC::networkReply() const
+void QGeoMapReplyQGC::cancel()
 {
-    return m_reply;
+    if (m_requested && m_scheduler)
+        m_scheduler->cancelTile(tileCoord(), this);
+    if (m_decoding)
+        QGCDecodedTileCache::instance()->cancelDecode(tileCoord(), this);
+    m_requested = false;
+    m_decoding = false;
 }
 
-void QGeoMapReplyQGC::replyDestroyed()
+QGCTileStore::TileCoord_t QGeoMapReplyQGC::tileCoord() const
 {
-    m_reply = 0;
+    QGCTileStore::TileCoord_t coord;
+    coord.mapType = tileSpec().mapId();
+    coord.zoom = tileSpec().zoom();
+    coord.x = tileSpec().x();
+    coord.y = tileSpec().y();
+    return coord;
 }
 
-void QGeoMapReplyQGC::networkReplyFinished()
+void QGeoMapReplyQGC::tileDownloaded(const QByteArray &data)
 {
-    if (!m_reply)
-    {
-        return;
-    }
+    m_requested = false;
 
-    if (m_reply->error() != QNetworkReply::NoError)
+    if(data.size() > 2)
     {
-        return;
-    }
-
-    QByteArray a = m_reply->readAll();
-    setMapImageData(a);
-
-    if(a.size() > 2)
-    {
-        if((char)a[0] == (char)0xff && (char)a[1] == (char)0xd8)
-            setMapImageFormat("jpg");
-        else if((char)a[0] == (char)0x89 && (char)a[1] == (char)0x50)
-            setMapImageFormat("png");
+        QString format = QGCTileStore::imageFormat(data, tileSpec().mapId());
+        if(format.isEmpty())
+            qWarning("Unknown map id %d", tileSpec().mapId());
         else
         {
-            switch ((OpenPilot::MapType)tileSpec().mapId()) {
-                case OpenPilot::GoogleMap:
-                case OpenPilot::GoogleLabels:
-                case OpenPilot::GoogleTerrain:
-                case OpenPilot::GoogleHybrid:
-                case OpenPilot::BingMap:
-                case OpenPilot::OpenStreetMap:
-                    setMapImageFormat("png");
-                    break;
-                case OpenPilot::GoogleSatellite:
-                case OpenPilot::BingSatellite:
-                case OpenPilot::BingHybrid:
-                    setMapImageFormat("jpg");
-                    break;
-                default:
-                    qWarning("Unknown map id %d", tileSpec().mapId());
-                    break;
-            }
+            //-- The store keeps the compressed tile, the decoded one goes to QtLocation.
+            //   Downloads are written in batches, the store serves queued tiles right away.
+            if(m_tileStore)
+                m_tileStore->queueTile(tileCoord(), data, format);
+            m_decoding = true;
+            QGCDecodedTileCache::instance()->decode(tileCoord(), data, format, this);
+            return;
         }
     }
 
+    setMapImageData(data);
     setFinished(true);
-    m_reply->deleteLater();
-    m_reply = 0;
 }
 
-void QGeoMapReplyQGC::networkReplyError(QNetworkReply::NetworkError error)
+void QGeoMapReplyQGC::tileDecoded(const QByteArray &data, const QString &format)
 {
-    if (!m_reply)
-    {
-        return;
-    }
+    m_decoding = false;
+
+    setMapImageData(data);
+    setMapImageFormat(format);
+    setFinished(true);
+}
+
+void QGeoMapReplyQGC::tileDownloadFailed(QNetworkReply::NetworkError error, const QString &errorString)
+{
+    m_requested = false;
 
     if (error != QNetworkReply::OperationCanceledError)
     {
-        setError(QGeoTiledMapReply::CommunicationError, m_reply->errorString());
+        setError(QGeoTiledMapReply::CommunicationError, errorString);
     }
 
     setFinished(true);
-    m_reply->deleteLater();
-    m_reply = 0;
 }
@@ -48,27 +48,41 @@
 #define QGEOMAPREPLYGOOGLE_H
 
 #include <QtNetwork/QNetworkReply>
+#include <QtCore/QPointer>
 #include <QtLocation/private/qgeotiledmapreply_p.h>
 
-class QGeoMapReplyQGC : public QGeoTiledMapReply
+#include "QGCTileScheduler.h"
+#include "QGCDecodedTileCache.h"
+
+class QGeoMapReplyQGC : public QGeoTiledMapReply, public QGCTileRequester, public QGCTileDecodeRequester
 {
     Q_OBJECT
 
 public:
-    explicit QGeoMapReplyQGC(QNetworkReply *reply, const QGeoTileSpec &spec, QObject *parent = 0);
+    /// Reply for a tile download through the scheduler. The tile is added to the tile store when it arrives.
+    explicit QGeoMapReplyQGC(QGCTileScheduler *scheduler, const QNetworkRequest &request, const QGeoTileSpec &spec, QGCTileStore *tileStore = 0, QObject *parent = 0);
+    /// Reply for a tile found in the tile store or decoded tile cache. Decoded tiles finish on construction,
+    /// others are decoded in the background first.
+    explicit QGeoMapReplyQGC(const QByteArray &data, const QString &format, const QGeoTileSpec &spec, QObject *parent = 0);
     ~QGeoMapReplyQGC();
 
     void abort();
 
-    QNetworkReply *networkReply() const;
+    // From QGCTileRequester
+    void tileDownloaded         (const QByteArray &data);
+    void tileDownloadFailed     (QNetworkReply::NetworkError error, const QString &errorString);
 
-private Q_SLOTS:
-    void replyDestroyed         ();
-    void networkReplyFinished   ();
-    void networkReplyError      (QNetworkReply::NetworkError error);
+    // From QGCTileDecodeRequester
+    void tileDecoded            (const QByteArray &data, const QString &format);
 
 private:
-    QNetworkReply*  m_reply;
+    QGCTileStore::TileCoord_t tileCoord() const;
+    void cancel();
+
+    QPointer<QGCTileScheduler>  m_scheduler;
+    bool                        m_requested;    ///< true: Waiting for the scheduler
+    bool                        m_decoding;     ///< true: Waiting for the background decode
+    QPointer<QGCTileStore>      m_tileStore;
 };
 
 #endif // QGEOMAPREPLYGOOGLE_H
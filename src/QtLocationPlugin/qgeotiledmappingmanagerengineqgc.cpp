@@ -56,6 +56,8 @@
 
 #include "qgeotiledmappingmanagerengineqgc.h"
 #include "qgeotilefetcherqgc.h"
+#include "QGCTileStore.h"
+#include "QGCDecodedTileCache.h"
 #include "OpenPilotMaps.h"
 
 #if QT_VERSION >= 0x050500
@@ -99,6 +101,10 @@ QGeoTiledMappingManagerEngineQGC::QGeoTiledMappingManagerEngineQGC(const QVarian
         // QGC Default
         tileFetcher->setUserAgent("Mozilla/5.0 (Windows; U; Windows NT 6.0; en-US; rv:1.9.1.7) Gecko/20091221 Firefox/3.5.7");
 
+    //-- Single tile server in place of the map providers, used for private tile servers and testing
+    if (parameters.contains(QStringLiteral("mapping.tileserver.url")))
+        tileFetcher->setUrlTemplate(parameters.value(QStringLiteral("mapping.tileserver.url")).toString());
+
     setTileFetcher(tileFetcher);
 
     QString cacheDir;
@@ -140,24 +146,37 @@ QGeoTiledMappingManagerEngineQGC::QGeoTiledMappingManagerEngineQGC(const QVarian
             cacheLimit = 1024 * 1024 * 1024;
 #endif
         }
-        pTileCache->setMaxDiskUsage(cacheLimit);
-        //-- Memory Cache
-        cacheLimit = 0;
-        if (parameters.contains(QStringLiteral("mapping.cache.memory.size"))) {
-          bool ok = false;
-          cacheLimit = parameters.value(QStringLiteral("mapping.cache.memory.size")).toString().toInt(&ok);
-          if (!ok)
-              cacheLimit = 0;
-        }
-        if(!cacheLimit)
+        //-- Persistent tiles live in the offline tile store. The stock disk cache would only hold a second copy of
+        //   them, as decoded bitmaps which are several times the size of the originals, so it is turned off.
+        if(!cacheDir.isEmpty())
         {
-#ifdef __mobile__
-            cacheLimit = 16 * 1024 * 1024;
-#else
-            cacheLimit = 128 * 1024 * 1024;
-#endif
+            QGCTileStore* tileStore = new QGCTileStore(cacheDir + QLatin1String("/QGCTiles.db"), cacheLimit, this);
+            if(tileStore->isOpen())
+            {
+                tileFetcher->setTileStore(tileStore);
+                QGCTileStore::setMapStore(tileStore);
+                setCacheHint(QGeoTiledMappingManagerEngine::MemoryCache);
+                //-- Also removes the tiles left in the disk cache by earlier versions
+                cacheLimit = 0;
+            }
+            else
+            {
+                delete tileStore;
+            }
         }
-        pTileCache->setMaxMemoryUsage(cacheLimit);
+        pTileCache->setMaxDiskUsage(cacheLimit);
+        //-- Memory Cache
+        //   Tiles are stored decoded (bmp), about ten times the size of the downloaded image. QGCDecodedTileCache
+        //   keeps the only long lived copy, the stock cache only holds fetched tiles until they become textures.
+        pTileCache->setMaxMemoryUsage(4 * 1024 * 1024);
+    }
+
+    //-- Decoded tiles are shared by all map views, the default size is set by QGCDecodedTileCache
+    if (parameters.contains(QStringLiteral("mapping.cache.memory.size"))) {
+        bool ok = false;
+        int memoryLimit = parameters.value(QStringLiteral("mapping.cache.memory.size")).toString().toInt(&ok);
+        if (ok && memoryLimit > 0)
+            QGCDecodedTileCache::instance()->setMaxBytes(memoryLimit);
     }
 
     *error = QGeoServiceProvider::NoError;
@@ -177,14 +196,18 @@ QGeoTiledMappingManagerEngineQGC::~QGeoTiledMappingManagerEngineQGC()
 
 QGeoMapData *QGeoTiledMappingManagerEngineQGC::createMapData()
 {
-    return new QGeoTiledMapData(this, 0);
+    QGeoTiledMapData* map = new QGeoTiledMapData(this, 0);
+    connect(map, SIGNAL(cameraDataChanged(QGeoCameraData)), tileFetcher(), SLOT(cameraDataChanged(QGeoCameraData)));
+    return map;
 }
 
 #else
 
 QGeoMap *QGeoTiledMappingManagerEngineQGC::createMap()
 {
-    return new QGeoTiledMapQGC(this);
+    QGeoTiledMapQGC* map = new QGeoTiledMapQGC(this);
+    connect(map, SIGNAL(cameraDataChanged(QGeoCameraData)), tileFetcher(), SLOT(cameraDataChanged(QGeoCameraData)));
+    return map;
 }
 
 QString QGeoTiledMappingManagerEngineQGC::customCopyright() const
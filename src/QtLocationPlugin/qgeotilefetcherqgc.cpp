@@ -51,6 +51,8 @@
 
 #include "qgeotilefetcherqgc.h"
 #include "qgeomapreplyqgc.h"
+#include "QGCTileStore.h"
+#include "QGCDecodedTileCache.h"
 
 QGeoTileFetcherQGC::QGeoTileFetcherQGC(QGeoTiledMappingManagerEngine *parent)
     : QGeoTileFetcher(parent)
@@ -63,12 +65,15 @@ QGeoTileFetcherQGC::QGeoTileFetcherQGC(QGeoTiledMappingManagerEngine *parent)
     , m_userAgent("Mozilla/5.0 (X11; Ubuntu; Linux x86_64; rv:21.0) Gecko/20130331 Firefox/21.0")
 #endif
     , m_UrlFactory(NULL)
+    , m_tileStore(NULL)
+    , m_scheduler(NULL)
 {
     QStringList langs = QLocale::system().uiLanguages();
     if (langs.length() > 0) {
         m_Language = langs[0];
     }
     m_UrlFactory = new OpenPilot::UrlFactory(m_networkManager);
+    m_scheduler = new QGCTileScheduler(m_networkManager, this);
 }
 
 QGeoTileFetcherQGC::~QGeoTileFetcherQGC()
@@ -82,15 +87,76 @@ void QGeoTileFetcherQGC::setUserAgent(const QByteArray &userAgent)
     m_userAgent = userAgent;
 }
 
+void QGeoTileFetcherQGC::setTileStore(QGCTileStore *tileStore)
+{
+    m_tileStore = tileStore;
+}
+
+void QGeoTileFetcherQGC::setUrlTemplate(const QString &urlTemplate)
+{
+    m_urlTemplate = urlTemplate;
+}
+
+QString QGeoTileFetcherQGC::expandUrlTemplate(const QString &urlTemplate, int x, int y, int zoom)
+{
+    QString url = urlTemplate;
+    url.replace(QStringLiteral("{x}"), QString::number(x));
+    url.replace(QStringLiteral("{y}"), QString::number(y));
+    url.replace(QStringLiteral("{z}"), QString::number(zoom));
+    return url;
+}
+
 QGeoTiledMapReply *QGeoTileFetcherQGC::getTileImage(const QGeoTileSpec &spec)
+{
+    QGCTileStore::TileCoord_t coord;
+    coord.mapType = spec.mapId();
+    coord.zoom = spec.zoom();
+    coord.x = spec.x();
+    coord.y = spec.y();
+
+    //-- Recently decoded tiles need no decoding
+    QByteArray data;
+    if (QGCDecodedTileCache::instance()->find(coord, data)) {
+        return new QGeoMapReplyQGC(data, QGCDecodedTileCache::decodedFormat, spec);
+    }
+
+    //-- Offline first: Tiles in the store never go to the network
+    if (m_tileStore) {
+        QString format;
+        if (m_tileStore->fetchTile(coord, data, format)) {
+            return new QGeoMapReplyQGC(data, format, spec);
+        }
+    }
+
+    QString url;
+    if (m_urlTemplate.isEmpty()) {
+        url = m_UrlFactory->makeImageUrl((OpenPilot::MapType)spec.mapId(), QPoint(spec.x(), spec.y()), spec.zoom(), m_Language);
+    } else {
+        url = expandUrlTemplate(m_urlTemplate, spec.x(), spec.y(), spec.zoom());
+    }
+
+    QNetworkRequest request = makeTileRequest(url, spec.mapId(), m_userAgent);
+    return new QGeoMapReplyQGC(m_scheduler, request, spec, m_tileStore);
+}
+
+void QGeoTileFetcherQGC::cameraDataChanged(const QGeoCameraData &cameraData)
+{
+    //-- Same rounding the tiled map uses to pick the tile zoom level
+    int zoom = qRound(cameraData.zoomLevel());
+    //-- Each map view has its own viewport for download priority and keeps the decoded tiles near its own zoom level
+    QObject *view = sender() ? sender() : this;
+    m_scheduler->setViewport(view, cameraData.center().latitude(), cameraData.center().longitude(), zoom);
+    QGCDecodedTileCache::instance()->setViewZoom(view, zoom);
+}
+
+QNetworkRequest QGeoTileFetcherQGC::makeTileRequest(const QString &url, int mapType, const QByteArray &userAgent)
 {
     QNetworkRequest request;
-    QString url = m_UrlFactory->makeImageUrl((OpenPilot::MapType)spec.mapId(), QPoint(spec.x(), spec.y()), spec.zoom(), m_Language);
 
     request.setUrl(QUrl(url));
-    request.setRawHeader("User-Agent", m_userAgent);
+    request.setRawHeader("User-Agent", userAgent);
     request.setRawHeader("Accept", "*/*");
-    switch ((OpenPilot::MapType)spec.mapId()) {
+    switch ((OpenPilot::MapType)mapType) {
     case OpenPilot::GoogleMap:
     case OpenPilot::GoogleSatellite:
     case OpenPilot::GoogleLabels:
@@ -153,8 +219,5 @@ QGeoTiledMapReply *QGeoTileFetcherQGC::getTileImage(const QGeoTileSpec &spec)
         break;
     }
 
-    QNetworkReply *reply = m_networkManager->get(request);
-    reply->setParent(0);
-    return new QGeoMapReplyQGC(reply, spec);
-
+    return request;
 }
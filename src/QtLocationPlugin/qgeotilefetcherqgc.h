@@ -49,10 +49,14 @@
 
 #include <QtLocation/private/qgeotilefetcher_p.h>
 #include <QtLocation/private/qgeotilecache_p.h>
+#include <QtLocation/private/qgeocameradata_p.h>
+#include <QtNetwork/QNetworkRequest>
 #include "OpenPilotMaps.h"
+#include "QGCTileScheduler.h"
 
 class QGeoTiledMappingManagerEngine;
 class QNetworkAccessManager;
+class QGCTileStore;
 
 class QGeoTileFetcherQGC : public QGeoTileFetcher
 {
@@ -64,12 +68,34 @@ public:
 
     void setUserAgent(const QByteArray &userAgent);
 
+    /// Store which is checked before the network and which receives all downloaded tiles
+    void setTileStore(QGCTileStore *tileStore);
+
+    /// Overrides the map provider urls with a single tile server. {x}, {y} and {z} are replaced by the tile location.
+    void setUrlTemplate(const QString &urlTemplate);
+
+    static QString expandUrlTemplate(const QString &urlTemplate, int x, int y, int zoom);
+
+    /// Builds the request for a tile with the headers the map provider expects
+    static QNetworkRequest makeTileRequest(const QString &url, int mapType, const QByteArray &userAgent);
+
+    QGCTileScheduler* scheduler() { return m_scheduler; }
+
+public slots:
+    /// Tracks the map camera so tile downloads near the center of the view are started first
+    void cameraDataChanged(const QGeoCameraData &cameraData);
+
 private:
+    friend class QGCTileStoreTest;
+
     QGeoTiledMapReply* getTileImage(const QGeoTileSpec &spec);
     QNetworkAccessManager*  m_networkManager;
     QByteArray              m_userAgent;
     OpenPilot::UrlFactory*  m_UrlFactory;
     QString                 m_Language;
+    QGCTileStore*           m_tileStore;
+    QString                 m_urlTemplate;
+    QGCTileScheduler*       m_scheduler;
 };
 
 #endif // QGEOTILEFETCHERGOOGLE_H
@@ -29,6 +29,8 @@
 #include "MAVLinkProtocol.h"
 #include "UAS.h"
 
+QGC_LOGGING_CATEGORY(MultiVehicleManagerLog, "MultiVehicleManagerLog")
+
 IMPLEMENT_QGC_SINGLETON(MultiVehicleManager, MultiVehicleManager)
 
 MultiVehicleManager::MultiVehicleManager(QObject* parent) :
@@ -39,6 +41,8 @@ MultiVehicleManager::MultiVehicleManager(QObject* parent) :
 {
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
     qmlRegisterUncreatableType<MultiVehicleManager>("QGroundControl.MultiVehicleManager", 1, 0, "MultiVehicleManager", "Reference only");
+    
+    connect(&_syncScheduler, &VehicleSyncScheduler::syncFinished, this, &MultiVehicleManager::_vehicleSyncFinished);
 }
 
 MultiVehicleManager::~MultiVehicleManager()
@@ -78,6 +82,9 @@ bool MultiVehicleManager::notifyHeartbeatInfo(LinkInterface* link, int vehicleId
         emit vehicleAdded(vehicle);
         
         setActiveVehicle(vehicle);
+        
+        // The vehicle is usable for telemetry now, parameters and mission are loaded when the scheduler has a free slot
+        _syncScheduler.addVehicle(vehicle);
     }
     
     return true;
@@ -104,6 +111,7 @@ void MultiVehicleManager::_deleteVehiclePhase1(Vehicle* vehicle)
     
     vehicle->setActive(false);
     vehicle->uas()->clearVehicle();
+    _syncScheduler.removeVehicle(vehicle);
     
     // First we must signal that a vehicle is no longer available.
     _activeVehicleAvailable = false;
@@ -132,6 +140,7 @@ void MultiVehicleManager::_deleteVehiclePhase2  (void)
     }
     
     _activeVehicle = newActiveVehicle;
+    _syncScheduler.setActiveVehicle(newActiveVehicle);
     emit activeVehicleChanged(newActiveVehicle);
     
     if (_activeVehicle) {
@@ -162,6 +171,9 @@ void MultiVehicleManager::setActiveVehicle(Vehicle* vehicle)
             emit parameterReadyVehicleAvailableChanged(false);
         }
         
+        // The new active vehicle is the next to sync
+        _syncScheduler.setActiveVehicle(vehicle);
+        
         // See explanation in _deleteVehiclePhase1
         _vehicleBeingSetActive = vehicle;
         QTimer::singleShot(20, this, &MultiVehicleManager::_setActiveVehiclePhase2);
@@ -202,6 +214,49 @@ void MultiVehicleManager::_autopilotParametersReadyChanged(bool parametersReady)
     }
 }
 
+void MultiVehicleManager::prioritizeVehicleSync(Vehicle* vehicle)
+{
+    if (vehicle) {
+        _syncScheduler.prioritizeVehicle(vehicle);
+    }
+}
+
+void MultiVehicleManager::_vehicleSyncFinished(Vehicle* vehicle, bool timedOut)
+{
+    if (timedOut) {
+        qCWarning(MultiVehicleManagerLog) << "Initial sync timed out for vehicle" << vehicle->id();
+    }
+    
+    if (MultiVehicleManagerLog().isDebugEnabled()) {
+        foreach (const QString& line, diagnostics()) {
+            qCDebug(MultiVehicleManagerLog) << line;
+        }
+    }
+}
+
+QStringList MultiVehicleManager::diagnostics(void)
+{
+    QStringList lines;
+    
+    foreach (Vehicle* vehicle, vehicles()) {
+        QString syncState;
+        
+        if (vehicle->initialSyncComplete()) {
+            syncState = "synced";
+        } else if (_syncScheduler.isRunning(vehicle)) {
+            syncState = "syncing";
+        } else if (_syncScheduler.isPending(vehicle)) {
+            syncState = "waiting";
+        } else {
+            syncState = "not synced";
+        }
+        
+        lines += QString("Vehicle %1: %2, estimated ~%3 KB").arg(vehicle->id()).arg(syncState).arg(vehicle->estimatedMemoryFootprint() / 1024);
+    }
+    
+    return lines;
+}
+
 void MultiVehicleManager::setHomePositionForAllVehicles(double lat, double lon, double alt)
 {
     for (int i=0; i< _vehicles.count(); i++) {
@@ -31,6 +31,10 @@
 #include "Vehicle.h"
 #include "QGCMAVLink.h"
 #include "QmlObjectListModel.h"
+#include "VehicleSyncScheduler.h"
+#include "QGCLoggingCategory.h"
+
+Q_DECLARE_LOGGING_CATEGORY(MultiVehicleManagerLog)
 
 class MultiVehicleManager : public QGCSingleton
 {
@@ -61,6 +65,15 @@ public:
     
     void setHomePositionForAllVehicles(double lat, double lon, double alt);
     
+    /// Moves the initial parameter and mission sync for the specified vehicle ahead of other waiting vehicles.
+    /// Used when the user focuses on a vehicle which is not the active vehicle.
+    Q_INVOKABLE void prioritizeVehicleSync(Vehicle* vehicle);
+    
+    /// @return One line per vehicle with its sync state and estimated memory footprint
+    QStringList diagnostics(void);
+    
+    VehicleSyncScheduler* syncScheduler(void) { return &_syncScheduler; }
+    
     UAS* activeUas(void) { return _activeVehicle ? _activeVehicle->uas() : NULL; }
     
     QList<Vehicle*> vehicles(void);
@@ -90,6 +103,7 @@ private slots:
     void _deleteVehiclePhase2(void);
     void _setActiveVehiclePhase2(void);
     void _autopilotParametersReadyChanged(bool parametersReady);
+    void _vehicleSyncFinished(Vehicle* vehicle, bool timedOut);
     
 private:
     /// All access to singleton is through MultiVehicleManager::instance
@@ -107,7 +121,8 @@ private:
     
     QList<int>  _ignoreVehicleIds;          ///< List of vehicle id for which we ignore further communication
     
-    QmlObjectListModel  _vehicles;
+    QmlObjectListModel      _vehicles;
+    VehicleSyncScheduler    _syncScheduler;     ///< Staggers the initial parameter and mission sync of new vehicles
 };
 
 #endif
@@ -0,0 +1,212 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "TrajectoryStore.h"
+
+#include <QtMath>
+#include <QPair>
+
+const double TrajectoryStore::defaultToleranceMeters = 1.5;
+
+/// Approximate meters per degree * 1E7 of latitude
+static const double _metersPerE7 = 0.011131949;
+
+TrajectoryStore::TrajectoryStore(QObject* parent)
+    : QObject(parent)
+    , _toleranceMeters(defaultToleranceMeters)
+    , _maxPoints(defaultMaxPoints)
+{
+    _clock.start();
+}
+
+void TrajectoryStore::setMaxPoints(int maxPoints)
+{
+    _maxPoints = qMax(maxPoints, 2);
+    if (_points.count() > _maxPoints) {
+        _decimate();
+    }
+}
+
+QGeoCoordinate TrajectoryStore::_coordinate(const Sample_t& sample)
+{
+    return QGeoCoordinate(sample.latitudeE7 / 1E7, sample.longitudeE7 / 1E7, sample.altitude);
+}
+
+QGeoCoordinate TrajectoryStore::coordinate(int index) const
+{
+    if (index < 0 || index >= _points.count()) {
+        return QGeoCoordinate();
+    }
+    return _coordinate(_points[index]);
+}
+
+QVariantList TrajectoryStore::path(void) const
+{
+    QVariantList list;
+    
+    list.reserve(_points.count());
+    foreach (const Sample_t& sample, _points) {
+        list.append(QVariant::fromValue(_coordinate(sample)));
+    }
+    
+    return list;
+}
+
+void TrajectoryStore::clear(void)
+{
+    _points.clear();
+    _skipped.clear();
+    _clock.restart();
+    
+    emit pathChanged();
+    emit countChanged(0);
+}
+
+void TrajectoryStore::append(const QGeoCoordinate& coordinate, double altitude)
+{
+    if (!coordinate.isValid()) {
+        return;
+    }
+    
+    Sample_t sample;
+    
+    sample.latitudeE7 = qRound(coordinate.latitude() * 1E7);
+    sample.longitudeE7 = qRound(coordinate.longitude() * 1E7);
+    sample.altitude = altitude;
+    sample.timeMsecs = _clock.elapsed();
+    
+    int count = _points.count();
+    
+    if (count >= 2 && _skipped.count() < _maxSkipped && _withinTolerance(_points[count - 2], sample)) {
+        // The previous end point along with all the samples it already replaced are close enough to the
+        // new segment, move the end point to the new sample.
+        QGeoCoordinate previousCoordinate = _coordinate(_points[count - 1]);
+        
+        _skipped.append(_points[count - 1]);
+        _points[count - 1] = sample;
+        emit lastPointMoved(previousCoordinate, _coordinate(sample));
+        return;
+    }
+    
+    _skipped.clear();
+    _appendPoint(sample);
+}
+
+void TrajectoryStore::_appendPoint(const Sample_t& sample)
+{
+    _points.append(sample);
+    
+    if (_points.count() > _maxPoints) {
+        _decimate();
+    } else {
+        emit pointAppended(_coordinate(sample));
+        emit countChanged(_points.count());
+    }
+}
+
+bool TrajectoryStore::_withinTolerance(const Sample_t& anchor, const Sample_t& end) const
+{
+    if (_segmentDistance(_points.last(), anchor, end) > _toleranceMeters) {
+        return false;
+    }
+    foreach (const Sample_t& skipped, _skipped) {
+        if (_segmentDistance(skipped, anchor, end) > _toleranceMeters) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @return Distance in meters from point to the segment start-end, using a local flat earth projection
+double TrajectoryStore::_segmentDistance(const Sample_t& point, const Sample_t& start, const Sample_t& end)
+{
+    double lonScale = _metersPerE7 * qCos(qDegreesToRadians(start.latitudeE7 / 1E7));
+    
+    double px = (double)(point.longitudeE7 - start.longitudeE7) * lonScale;
+    double py = (double)(point.latitudeE7 - start.latitudeE7) * _metersPerE7;
+    double ex = (double)(end.longitudeE7 - start.longitudeE7) * lonScale;
+    double ey = (double)(end.latitudeE7 - start.latitudeE7) * _metersPerE7;
+    
+    double lengthSquared = (ex * ex) + (ey * ey);
+    double t = 0;
+    if (lengthSquared > 0) {
+        t = qBound(0.0, ((px * ex) + (py * ey)) / lengthSquared, 1.0);
+    }
+    
+    double dx = px - (t * ex);
+    double dy = py - (t * ey);
+    
+    return qSqrt((dx * dx) + (dy * dy));
+}
+
+/// Re-simplifies the whole path with Douglas-Peucker, doubling the tolerance until the path fits in three
+/// quarters of the cap. This leaves room for new points so decimation happens rarely.
+void TrajectoryStore::_decimate(void)
+{
+    int targetCount = qMax((_maxPoints * 3) / 4, 2);
+    double tolerance = _toleranceMeters;
+    
+    while (_points.count() > targetCount) {
+        tolerance *= 2;
+        
+        QVector<bool> keep(_points.count(), false);
+        keep[0] = true;
+        keep[_points.count() - 1] = true;
+        
+        // Explicit stack of index ranges instead of recursion
+        QVector<QPair<int, int> > ranges;
+        ranges.append(qMakePair(0, _points.count() - 1));
+        while (!ranges.isEmpty()) {
+            QPair<int, int> range = ranges.takeLast();
+            
+            double maxDistance = 0;
+            int maxIndex = -1;
+            for (int i=range.first + 1; i<range.second; i++) {
+                double distance = _segmentDistance(_points[i], _points[range.first], _points[range.second]);
+                if (distance > maxDistance) {
+                    maxDistance = distance;
+                    maxIndex = i;
+                }
+            }
+            if (maxIndex != -1 && maxDistance > tolerance) {
+                keep[maxIndex] = true;
+                ranges.append(qMakePair(range.first, maxIndex));
+                ranges.append(qMakePair(maxIndex, range.second));
+            }
+        }
+        
+        QVector<Sample_t> simplified;
+        for (int i=0; i<_points.count(); i++) {
+            if (keep[i]) {
+                simplified.append(_points[i]);
+            }
+        }
+        _points = simplified;
+    }
+    
+    // The last point is now fixed
+    _skipped.clear();
+    
+    emit pathChanged();
+    emit countChanged(_points.count());
+}
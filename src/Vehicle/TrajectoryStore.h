@@ -0,0 +1,115 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef TrajectoryStore_H
+#define TrajectoryStore_H
+
+#include <QObject>
+#include <QGeoCoordinate>
+#include <QVector>
+#include <QVariantList>
+#include <QElapsedTimer>
+
+/// @file
+///     @brief Compact store for the flight trajectory shown on the map. Samples are packed into 16 bytes and
+///             simplified as they arrive: while new samples stay within the tolerance of the segment from the
+///             last fixed point, the end of that segment is moved instead of adding a new point. If the point
+///             count still exceeds the cap the whole path is re-simplified with a larger tolerance.
+///
+///             QML shows the fixed points as one polyline, which only has points added through pointAppended, and
+///             the moving last segment as a separate two point polyline updated through lastPointMoved. Both are
+///             rebuilt from path when pathChanged is signalled.
+
+class TrajectoryStore : public QObject
+{
+    Q_OBJECT
+    
+public:
+    TrajectoryStore(QObject* parent = NULL);
+    
+    Q_PROPERTY(int          count   READ count  NOTIFY countChanged)
+    Q_PROPERTY(QVariantList path    READ path   NOTIFY pathChanged)
+    
+    /// Packed trajectory sample
+    typedef struct {
+        qint32  latitudeE7;     ///< Latitude in degrees * 1E7
+        qint32  longitudeE7;    ///< Longitude in degrees * 1E7
+        float   altitude;       ///< Altitude in meters
+        quint32 timeMsecs;      ///< Time since the trajectory was cleared
+    } Sample_t;
+    
+    int count(void) const { return _points.count(); }
+    
+    /// @return All retained points as a list of QGeoCoordinate
+    QVariantList path(void) const;
+    
+    Q_INVOKABLE QGeoCoordinate coordinate(int index) const;
+    
+    const Sample_t& sample(int index) const { return _points[index]; }
+    
+    /// Adds a new sample to the end of the trajectory
+    void append(const QGeoCoordinate& coordinate, double altitude);
+    
+    /// Removes all points and restarts the trajectory clock
+    void clear(void);
+    
+    /// Maximum distance in meters a dropped sample may be from the simplified path
+    double toleranceMeters(void) const { return _toleranceMeters; }
+    void setToleranceMeters(double meters) { _toleranceMeters = meters; }
+    
+    /// Maximum number of retained points
+    int maxPoints(void) const { return _maxPoints; }
+    void setMaxPoints(int maxPoints);
+    
+    static const double defaultToleranceMeters;
+    static const int    defaultMaxPoints = 2000;
+    
+signals:
+    void countChanged(int count);
+    
+    /// Signalled when the path has been rebuilt and must be reloaded
+    void pathChanged(void);
+    
+    /// Signalled when a new point has been added to the end of the path
+    void pointAppended(const QGeoCoordinate& coordinate);
+    
+    /// Signalled when the last point of the path has been moved
+    void lastPointMoved(const QGeoCoordinate& previousCoordinate, const QGeoCoordinate& coordinate);
+    
+private:
+    void _appendPoint(const Sample_t& sample);
+    bool _withinTolerance(const Sample_t& anchor, const Sample_t& end) const;
+    void _decimate(void);
+    static QGeoCoordinate _coordinate(const Sample_t& sample);
+    static double _segmentDistance(const Sample_t& point, const Sample_t& start, const Sample_t& end);
+    
+    QVector<Sample_t>   _points;        ///< Retained points, the last point moves while samples stay within tolerance
+    QVector<Sample_t>   _skipped;       ///< Samples represented by the segment ending at the last point
+    QElapsedTimer       _clock;
+    double              _toleranceMeters;
+    int                 _maxPoints;
+    
+    static const int    _maxSkipped = 64;   ///< Bounds the cost of checking a moved segment
+};
+
+#endif
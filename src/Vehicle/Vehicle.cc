@@ -31,11 +31,12 @@
 #include "UAS.h"
 #include "JoystickManager.h"
 #include "MissionManager.h"
-#include "CoordinateVector.h"
+#include "VehicleCommandManager.h"
+#include "VehicleTimeSync.h"
+#include "QGCTrace.h"
 
 QGC_LOGGING_CATEGORY(VehicleLog, "VehicleLog")
 
-#define UPDATE_TIMER 50
 #define DEFAULT_LAT  38.965767f
 #define DEFAULT_LON -120.083923f
 
@@ -76,7 +77,7 @@ Vehicle::Vehicle(LinkInterface* link, int vehicleId, MAV_AUTOPILOT firmwareType,
     , _navigationTargetBearing(0.0f)
     , _latitude(DEFAULT_LAT)
     , _longitude(DEFAULT_LON)
-    , _refreshTimer(new QTimer(this))
+    , _dirtyProperties(0)
     , _batteryVoltage(-1.0f)
     , _batteryPercent(0.0)
     , _batteryConsumed(-1.0)
@@ -85,12 +86,14 @@ Vehicle::Vehicle(LinkInterface* link, int vehicleId, MAV_AUTOPILOT firmwareType,
     , _currentWaypoint(0)
     , _satelliteCount(-1)
     , _satelliteLock(0)
-    , _updateCount(0)
     , _missionManager(NULL)
+    , _commandManager(NULL)
+    , _timeSync(NULL)
     , _armed(false)
     , _base_mode(0)
     , _custom_mode(0)
     , _nextSendMessageMultipleIndex(0)
+    , _initialSyncState(InitialSyncNotStarted)
 {
     _addLink(link);
     
@@ -99,6 +102,15 @@ Vehicle::Vehicle(LinkInterface* link, int vehicleId, MAV_AUTOPILOT firmwareType,
     connect(_mavlink, &MAVLinkProtocol::messageReceived, this, &Vehicle::_mavlinkMessageReceived);
     connect(this, &Vehicle::_sendMessageOnThread, this, &Vehicle::_sendMessage, Qt::QueuedConnection);
     
+    _commandManager = new VehicleCommandManager(this);
+    _timeSync = new VehicleTimeSync(this);
+    
+    // Property changes are coalesced and flushed at most once per interval. The timer only runs while
+    // there are dirty properties so idle vehicles cause no wakeups.
+    _propertyFlushTimer.setSingleShot(true);
+    _propertyFlushTimer.setInterval(_defaultPropertyFlushIntervalMsecs);
+    connect(&_propertyFlushTimer, &QTimer::timeout, this, &Vehicle::flushPropertyChanges);
+    
     _uas = new UAS(_mavlink, this);
     
     setLatitude(_uas->getLatitude());
@@ -111,11 +123,8 @@ Vehicle::Vehicle(LinkInterface* link, int vehicleId, MAV_AUTOPILOT firmwareType,
     _autopilotPlugin = AutoPilotPluginManager::instance()->newAutopilotPluginForVehicle(this);
     
     connect(_autopilotPlugin, &AutoPilotPlugin::missingParametersChanged, this, &Vehicle::missingParametersChanged);
+    connect(_autopilotPlugin, &AutoPilotPlugin::parametersReadyChanged, this, &Vehicle::_initialSyncParametersReady);
 
-    // Refresh timer
-    connect(_refreshTimer, SIGNAL(timeout()), this, SLOT(_checkUpdate()));
-    _refreshTimer->setInterval(UPDATE_TIMER);
-    _refreshTimer->start(UPDATE_TIMER);
     emit heartbeatTimeoutChanged();
     
     _mav = uas();
@@ -152,6 +161,8 @@ Vehicle::Vehicle(LinkInterface* link, int vehicleId, MAV_AUTOPILOT firmwareType,
     
         _missionManager = new MissionManager(this);
         connect(_missionManager, &MissionManager::error, this, &Vehicle::_missionManagerError);
+        connect(_missionManager, &MissionManager::error, this, &Vehicle::_initialSyncMissionError);
+        connect(_missionManager, &MissionManager::inProgressChanged, this, &Vehicle::_initialSyncMissionInProgressChanged);
     
     _firmwarePlugin->initializeVehicle(this);
     
@@ -209,6 +220,12 @@ void Vehicle::_mavlinkMessageReceived(LinkInterface* link, mavlink_message_t mes
         case MAVLINK_MSG_ID_HEARTBEAT:
             _handleHeartbeat(message);
             break;
+        case MAVLINK_MSG_ID_COMMAND_ACK:
+            _commandManager->commandAckReceived(message);
+            break;
+        case MAVLINK_MSG_ID_TIMESYNC:
+            _timeSync->timesyncReceived(message);
+            break;
     }
     
     emit mavlinkMessageReceived(message);
@@ -338,45 +355,48 @@ QList<LinkInterface*> Vehicle::links(void)
 
 void Vehicle::setLatitude(double latitude)
 {
-    _geoCoordinate.setLatitude(latitude);
-    emit coordinateChanged(_geoCoordinate);
+    if (_geoCoordinate.latitude() != latitude) {
+        _geoCoordinate.setLatitude(latitude);
+        _setDirty(COORDINATE_CHANGED);
+    }
+    if (_latitude != (float)latitude) {
+        _latitude = latitude;
+        _setDirty(LATITUDE_CHANGED);
+    }
 }
 
-void Vehicle::setLongitude(double longitude){
-    _geoCoordinate.setLongitude(longitude);
-    emit coordinateChanged(_geoCoordinate);
+void Vehicle::setLongitude(double longitude)
+{
+    if (_geoCoordinate.longitude() != longitude) {
+        _geoCoordinate.setLongitude(longitude);
+        _setDirty(COORDINATE_CHANGED);
+    }
+    if (_longitude != (float)longitude) {
+        _longitude = longitude;
+        _setDirty(LONGITUDE_CHANGED);
+    }
 }
 
 void Vehicle::_updateAttitude(UASInterface*, double roll, double pitch, double yaw, quint64)
 {
+    QGC_TRACE_SCOPE("vehicle", "Vehicle::_updateAttitude");
+    
     if (isinf(roll)) {
         _roll = std::numeric_limits<double>::quiet_NaN();
     } else {
         float rolldeg = _oneDecimal(roll * (180.0 / M_PI));
-        if (fabs(roll - rolldeg) > 0.25) {
-            _roll = rolldeg;
-            if(_refreshTimer->isActive()) {
-                emit rollChanged();
-            }
-        }
         if(_roll != rolldeg) {
             _roll = rolldeg;
-            _addChange(ROLL_CHANGED);
+            _setDirty(ROLL_CHANGED);
         }
     }
     if (isinf(pitch)) {
         _pitch = std::numeric_limits<double>::quiet_NaN();
     } else {
         float pitchdeg = _oneDecimal(pitch * (180.0 / M_PI));
-        if (fabs(pitch - pitchdeg) > 0.25) {
-            _pitch = pitchdeg;
-            if(_refreshTimer->isActive()) {
-                emit pitchChanged();
-            }
-        }
         if(_pitch != pitchdeg) {
             _pitch = pitchdeg;
-            _addChange(PITCH_CHANGED);
+            _setDirty(PITCH_CHANGED);
         }
     }
     if (isinf(yaw)) {
@@ -384,15 +404,9 @@ void Vehicle::_updateAttitude(UASInterface*, double roll, double pitch, double y
     } else {
         yaw = _oneDecimal(yaw * (180.0 / M_PI));
         if (yaw < 0) yaw += 360;
-        if (fabs(_heading - yaw) > 0.25) {
+        if(_heading != (float)yaw) {
             _heading = yaw;
-            if(_refreshTimer->isActive()) {
-                emit headingChanged();
-            }
-        }
-        if(_heading != yaw) {
-            _heading = yaw;
-            _addChange(HEADING_CHANGED);
+            _setDirty(HEADING_CHANGED);
         }
     }
 }
@@ -404,74 +418,42 @@ void Vehicle::_updateAttitude(UASInterface* uas, int, double roll, double pitch,
 
 void Vehicle::_updateSpeed(UASInterface*, double groundSpeed, double airSpeed, quint64)
 {
+    QGC_TRACE_SCOPE("vehicle", "Vehicle::_updateSpeed");
+    
     groundSpeed = _oneDecimal(groundSpeed);
-    if (fabs(_groundSpeed - groundSpeed) > 0.5) {
+    if(_groundSpeed != (float)groundSpeed) {
         _groundSpeed = groundSpeed;
-        if(_refreshTimer->isActive()) {
-            emit groundSpeedChanged();
-        }
+        _setDirty(GROUNDSPEED_CHANGED);
     }
     airSpeed = _oneDecimal(airSpeed);
-    if (fabs(_airSpeed - airSpeed) > 0.5) {
-        _airSpeed = airSpeed;
-        if(_refreshTimer->isActive()) {
-            emit airSpeedChanged();
-        }
-    }
-    if(_groundSpeed != groundSpeed) {
-        _groundSpeed = groundSpeed;
-        _addChange(GROUNDSPEED_CHANGED);
-    }
-    if(_airSpeed != airSpeed) {
+    if(_airSpeed != (float)airSpeed) {
         _airSpeed = airSpeed;
-        _addChange(AIRSPEED_CHANGED);
+        _setDirty(AIRSPEED_CHANGED);
     }
 }
 
 void Vehicle::_updateAltitude(UASInterface*, double altitudeAMSL, double altitudeWGS84, double altitudeRelative, double climbRate, quint64) {
+    QGC_TRACE_SCOPE("vehicle", "Vehicle::_updateAltitude");
+    
     altitudeAMSL = _oneDecimal(altitudeAMSL);
-    if (fabs(_altitudeAMSL - altitudeAMSL) > 0.5) {
+    if(_altitudeAMSL != (float)altitudeAMSL) {
         _altitudeAMSL = altitudeAMSL;
-        if(_refreshTimer->isActive()) {
-            emit altitudeAMSLChanged();
-        }
+        _setDirty(ALTITUDEAMSL_CHANGED);
     }
     altitudeWGS84 = _oneDecimal(altitudeWGS84);
-    if (fabs(_altitudeWGS84 - altitudeWGS84) > 0.5) {
+    if(_altitudeWGS84 != (float)altitudeWGS84) {
         _altitudeWGS84 = altitudeWGS84;
-        if(_refreshTimer->isActive()) {
-            emit altitudeWGS84Changed();
-        }
+        _setDirty(ALTITUDEWGS84_CHANGED);
     }
     altitudeRelative = _oneDecimal(altitudeRelative);
-    if (fabs(_altitudeRelative - altitudeRelative) > 0.5) {
+    if(_altitudeRelative != (float)altitudeRelative) {
         _altitudeRelative = altitudeRelative;
-        if(_refreshTimer->isActive()) {
-            emit altitudeRelativeChanged();
-        }
+        _setDirty(ALTITUDERELATIVE_CHANGED);
     }
     climbRate = _oneDecimal(climbRate);
-    if (fabs(_climbRate - climbRate) > 0.5) {
+    if(_climbRate != (float)climbRate) {
         _climbRate = climbRate;
-        if(_refreshTimer->isActive()) {
-            emit climbRateChanged();
-        }
-    }
-    if(_altitudeAMSL != altitudeAMSL) {
-        _altitudeAMSL = altitudeAMSL;
-        _addChange(ALTITUDEAMSL_CHANGED);
-    }
-    if(_altitudeWGS84 != altitudeWGS84) {
-        _altitudeWGS84 = altitudeWGS84;
-        _addChange(ALTITUDEWGS84_CHANGED);
-    }
-    if(_altitudeRelative != altitudeRelative) {
-        _altitudeRelative = altitudeRelative;
-        _addChange(ALTITUDERELATIVE_CHANGED);
-    }
-    if(_climbRate != climbRate) {
-        _climbRate = climbRate;
-        _addChange(CLIMBRATE_CHANGED);
+        _setDirty(CLIMBRATE_CHANGED);
     }
 }
 
@@ -497,11 +479,13 @@ bool Vehicle::_isAirplane() {
     return false;
 }
 
-void Vehicle::_addChange(int id)
+void Vehicle::_setDirty(quint32 properties)
 {
-    if(!_changes.contains(id)) {
-        _changes.append(id);
+    // Only the first change after a flush starts the timer, further changes are picked up by the same flush
+    if (!_dirtyProperties) {
+        _propertyFlushTimer.start();
     }
+    _dirtyProperties |= properties;
 }
 
 float Vehicle::_oneDecimal(float value)
@@ -510,61 +494,51 @@ float Vehicle::_oneDecimal(float value)
     return (float)i / 10.0;
 }
 
-void Vehicle::_checkUpdate()
+void Vehicle::flushPropertyChanges(void)
 {
-    // Update current location
-    if(_mav) {
-        if(_latitude != _mav->getLatitude()) {
-            _latitude = _mav->getLatitude();
-            emit latitudeChanged();
-        }
-        if(_longitude != _mav->getLongitude()) {
-            _longitude = _mav->getLongitude();
-            emit longitudeChanged();
-        }
+    QGC_TRACE_SCOPE("vehicle", "Vehicle::flushPropertyChanges");
+    
+    _propertyFlushTimer.stop();
+    
+    // Clear before emitting so that property changes made by connected slots schedule a new flush
+    quint32 dirty = _dirtyProperties;
+    _dirtyProperties = 0;
+    
+    if (dirty & ROLL_CHANGED) {
+        emit rollChanged();
     }
-    // The timer rate is 20Hz for the coordinates above. These below we only check
-    // twice a second.
-    if(++_updateCount > 9) {
-        _updateCount = 0;
-        // Check for changes
-        // Significant changes, that is, whole number changes, are updated immediatelly.
-        // For every message however, we set a flag for what changed and this timer updates
-        // them to bring everything up-to-date. This prevents an avalanche of UI updates.
-        foreach(int i, _changes) {
-            switch (i) {
-                case ROLL_CHANGED:
-                    emit rollChanged();
-                    break;
-                case PITCH_CHANGED:
-                    emit pitchChanged();
-                    break;
-                case HEADING_CHANGED:
-                    emit headingChanged();
-                    break;
-                case GROUNDSPEED_CHANGED:
-                    emit groundSpeedChanged();
-                    break;
-                case AIRSPEED_CHANGED:
-                    emit airSpeedChanged();
-                    break;
-                case CLIMBRATE_CHANGED:
-                    emit climbRateChanged();
-                    break;
-                case ALTITUDERELATIVE_CHANGED:
-                    emit altitudeRelativeChanged();
-                    break;
-                case ALTITUDEWGS84_CHANGED:
-                    emit altitudeWGS84Changed();
-                    break;
-                case ALTITUDEAMSL_CHANGED:
-                    emit altitudeAMSLChanged();
-                    break;
-                default:
-                    break;
-            }
-        }
-        _changes.clear();
+    if (dirty & PITCH_CHANGED) {
+        emit pitchChanged();
+    }
+    if (dirty & HEADING_CHANGED) {
+        emit headingChanged();
+    }
+    if (dirty & GROUNDSPEED_CHANGED) {
+        emit groundSpeedChanged();
+    }
+    if (dirty & AIRSPEED_CHANGED) {
+        emit airSpeedChanged();
+    }
+    if (dirty & CLIMBRATE_CHANGED) {
+        emit climbRateChanged();
+    }
+    if (dirty & ALTITUDERELATIVE_CHANGED) {
+        emit altitudeRelativeChanged();
+    }
+    if (dirty & ALTITUDEWGS84_CHANGED) {
+        emit altitudeWGS84Changed();
+    }
+    if (dirty & ALTITUDEAMSL_CHANGED) {
+        emit altitudeAMSLChanged();
+    }
+    if (dirty & LATITUDE_CHANGED) {
+        emit latitudeChanged();
+    }
+    if (dirty & LONGITUDE_CHANGED) {
+        emit longitudeChanged();
+    }
+    if (dirty & COORDINATE_CHANGED) {
+        emit coordinateChanged(_geoCoordinate);
     }
 }
 
@@ -974,24 +948,11 @@ void Vehicle::setArmed(bool armed)
 {
     // We specifically use COMMAND_LONG:MAV_CMD_COMPONENT_ARM_DISARM since it is supported by more flight stacks.
     
-    mavlink_message_t msg;
-    mavlink_command_long_t cmd;
-    
-    cmd.command = (uint16_t)MAV_CMD_COMPONENT_ARM_DISARM;
-    cmd.confirmation = 0;
-    cmd.param1 = armed ? 1.0f : 0.0f;
-    cmd.param2 = 0.0f;
-    cmd.param3 = 0.0f;
-    cmd.param4 = 0.0f;
-    cmd.param5 = 0.0f;
-    cmd.param6 = 0.0f;
-    cmd.param7 = 0.0f;
-    cmd.target_system = id();
-    cmd.target_component = 0;
-    
-    mavlink_msg_command_long_encode(_mavlink->getSystemId(), _mavlink->getComponentId(), &msg, &cmd);
-    
-    sendMessage(msg);
+    if (!_commandManager->sendCommand(MAV_COMP_ID_ALL, MAV_CMD_COMPONENT_ARM_DISARM, armed ? 1.0f : 0.0f)) {
+        // A previous arm/disarm is still waiting for its ack, replace it with the latest request
+        _commandManager->cancelCommand(MAV_COMP_ID_ALL, MAV_CMD_COMPONENT_ARM_DISARM);
+        _commandManager->sendCommand(MAV_COMP_ID_ALL, MAV_CMD_COMPONENT_ARM_DISARM, armed ? 1.0f : 0.0f);
+    }
 }
 
 bool Vehicle::flightModeSetAvailable(void)
@@ -1051,6 +1012,64 @@ bool Vehicle::missingParameters(void)
     return _autopilotPlugin->missingParameters();
 }
 
+void Vehicle::startInitialSync(void)
+{
+    if (_initialSyncState != InitialSyncNotStarted) {
+        return;
+    }
+    
+    qCDebug(VehicleLog) << "startInitialSync" << _id;
+    
+    _initialSyncState = InitialSyncParameters;
+    _autopilotPlugin->refreshAllParameters();
+}
+
+void Vehicle::_initialSyncParametersReady(bool parametersReady)
+{
+    // parametersReady is also signalled when some parameters failed to load. We move on to the mission either
+    // way, the failure has already been reported.
+    if (parametersReady && _initialSyncState == InitialSyncParameters) {
+        _initialSyncState = InitialSyncMission;
+        _missionManager->syncMissionItems();
+    }
+}
+
+void Vehicle::_initialSyncMissionInProgressChanged(bool inProgress)
+{
+    if (!inProgress && _initialSyncState == InitialSyncMission) {
+        _setInitialSyncComplete();
+    }
+}
+
+void Vehicle::_initialSyncMissionError(int errorCode, const QString& errorMsg)
+{
+    Q_UNUSED(errorCode);
+    Q_UNUSED(errorMsg);
+    
+    if (_initialSyncState == InitialSyncMission) {
+        _setInitialSyncComplete();
+    }
+}
+
+void Vehicle::_setInitialSyncComplete(void)
+{
+    qCDebug(VehicleLog) << "Initial sync complete" << _id;
+    
+    _initialSyncState = InitialSyncComplete;
+    emit initialSyncCompleteChanged(true);
+}
+
+int Vehicle::estimatedMemoryFootprint(void)
+{
+    int bytes = sizeof(Vehicle) + sizeof(UAS);
+    
+    bytes += _autopilotPlugin->parameterCount() * _estimatedBytesPerParameter;
+    bytes += _missionManager->missionItems()->count() * _estimatedBytesPerMissionItem;
+    bytes += _mapTrajectory.count() * sizeof(TrajectoryStore::Sample_t);
+    
+    return bytes;
+}
+
 void Vehicle::requestDataStream(MAV_DATA_STREAM stream, uint16_t rate)
 {
     mavlink_message_t               msg;
@@ -1105,17 +1124,12 @@ void Vehicle::_missionManagerError(int errorCode, const QString& errorMsg)
 
 void Vehicle::_addNewMapTrajectoryPoint(void)
 {
-    if (_mapTrajectoryHaveFirstCoordinate) {
-        _mapTrajectoryList.append(new CoordinateVector(_mapTrajectoryLastCoordinate, _geoCoordinate, this));
-    }
-    _mapTrajectoryHaveFirstCoordinate = true;
-    _mapTrajectoryLastCoordinate = _geoCoordinate;
+    _mapTrajectory.append(_geoCoordinate, _altitudeAMSL);
 }
 
 void Vehicle::_mapTrajectoryStart(void)
 {
-    _mapTrajectoryHaveFirstCoordinate = false;
-    _mapTrajectoryList.clear();
+    _mapTrajectory.clear();
     _mapTrajectoryTimer.start();
 }
 
@@ -36,12 +36,15 @@
 #include "MissionItem.h"
 #include "QmlObjectListModel.h"
 #include "MAVLinkProtocol.h"
+#include "TrajectoryStore.h"
 
 class UAS;
 class UASInterface;
 class FirmwarePlugin;
 class AutoPilotPlugin;
 class MissionManager;
+class VehicleCommandManager;
+class VehicleTimeSync;
 
 Q_DECLARE_LOGGING_CATEGORY(VehicleLog)
 
@@ -72,7 +75,7 @@ public:
     
     Q_PROPERTY(bool missingParameters READ missingParameters NOTIFY missingParametersChanged)
     
-    Q_PROPERTY(QmlObjectListModel* trajectoryPoints READ trajectoryPoints CONSTANT)
+    Q_PROPERTY(TrajectoryStore* trajectory READ trajectory CONSTANT)
     
     Q_INVOKABLE QString     getMavIconColor();
     
@@ -172,6 +175,12 @@ public:
     
     MissionManager* missionManager(void) { return _missionManager; }
     
+    /// COMMAND_LONG messages should be sent through the command manager so they are retransmitted until acked
+    VehicleCommandManager* commandManager(void) { return _commandManager; }
+    
+    /// Onboard to GCS clock mapping maintained through TIMESYNC
+    VehicleTimeSync* timeSync(void) { return _timeSync; }
+    
     bool homePositionAvailable(void);
     QGeoCoordinate homePosition(void);
     
@@ -186,7 +195,7 @@ public:
     bool hilMode(void);
     void setHilMode(bool hilMode);
     
-    QmlObjectListModel* trajectoryPoints(void) { return &_mapTrajectoryList; }
+    TrajectoryStore* trajectory(void) { return &_mapTrajectory; }
     
     /// Requests the specified data stream from the vehicle
     ///     @param stream Stream which is being requested
@@ -195,6 +204,17 @@ public:
     
     bool missingParameters(void);
     
+    /// true: Initial parameter and mission load has finished, whether successfully or not
+    Q_PROPERTY(bool initialSyncComplete READ initialSyncComplete NOTIFY initialSyncCompleteChanged)
+    bool initialSyncComplete(void) { return _initialSyncState == InitialSyncComplete; }
+    
+    /// Starts the initial parameter load, followed by the mission load. New vehicles only stream telemetry
+    /// until the VehicleSyncScheduler calls this.
+    void startInitialSync(void);
+    
+    /// @return Rough estimate of the memory used by this vehicle in bytes, for diagnostics. Not a measurement.
+    Q_INVOKABLE int estimatedMemoryFootprint(void);
+    
     typedef enum {
         MessageNone,
         MessageNormal,
@@ -202,18 +222,34 @@ public:
         MessageError
     } MessageType_t;
     
+    /// Bits in the dirty property set. Telemetry updates only set a bit, the NOTIFY signals for all dirty
+    /// properties are emitted together by the next property flush.
     enum {
-        ROLL_CHANGED,
-        PITCH_CHANGED,
-        HEADING_CHANGED,
-        GROUNDSPEED_CHANGED,
-        AIRSPEED_CHANGED,
-        CLIMBRATE_CHANGED,
-        ALTITUDERELATIVE_CHANGED,
-        ALTITUDEWGS84_CHANGED,
-        ALTITUDEAMSL_CHANGED
+        ROLL_CHANGED                = 1 << 0,
+        PITCH_CHANGED               = 1 << 1,
+        HEADING_CHANGED             = 1 << 2,
+        GROUNDSPEED_CHANGED         = 1 << 3,
+        AIRSPEED_CHANGED            = 1 << 4,
+        CLIMBRATE_CHANGED           = 1 << 5,
+        ALTITUDERELATIVE_CHANGED    = 1 << 6,
+        ALTITUDEWGS84_CHANGED       = 1 << 7,
+        ALTITUDEAMSL_CHANGED        = 1 << 8,
+        LATITUDE_CHANGED            = 1 << 9,
+        LONGITUDE_CHANGED           = 1 << 10,
+        COORDINATE_CHANGED          = 1 << 11
     };
     
+    /// Maximum rate at which dirty property NOTIFY signals are emitted, expressed as the interval in msecs
+    /// between flushes. Defaults to one display frame.
+    int propertyFlushIntervalMsecs(void) { return _propertyFlushTimer.interval(); }
+    void setPropertyFlushIntervalMsecs(int msecs) { _propertyFlushTimer.setInterval(msecs); }
+    
+    /// @return Set of properties which have changed since the last flush
+    quint32 dirtyProperties(void) { return _dirtyProperties; }
+    
+    /// Emits the NOTIFY signals for all dirty properties immediately
+    void flushPropertyChanges(void);
+    
     // Called when the message drop-down is invoked to clear current count
     void resetMessages();
     
@@ -266,6 +302,7 @@ signals:
     void flightModeChanged(const QString& flightMode);
     void hilModeChanged(bool hilMode);
     void missingParametersChanged(bool missingParameters);
+    void initialSyncCompleteChanged(bool initialSyncComplete);
     
     /// Used internally to move sendMessage call to main thread
     void _sendMessageOnThread(mavlink_message_t message);
@@ -316,7 +353,6 @@ private slots:
     void _updateAltitude                    (UASInterface* uas, double _altitudeAMSL, double _altitudeWGS84, double _altitudeRelative, double _climbRate, quint64 timestamp);
     void _updateNavigationControllerErrors  (UASInterface* uas, double altitudeError, double speedError, double xtrackError);
     void _updateNavigationControllerData    (UASInterface *uas, float navRoll, float navPitch, float navBearing, float targetBearing, float targetDistance);
-    void _checkUpdate                       ();
     void _updateBatteryRemaining            (UASInterface*, double voltage, double, double percent, int);
     void _updateBatteryConsumedChanged      (UASInterface*, double current_consumed);
     void _updateState                       (UASInterface* system, QString name, QString description);
@@ -340,9 +376,13 @@ private:
     void _missionManagerError(int errorCode, const QString& errorMsg);
     void _mapTrajectoryStart(void);
     void _mapTrajectoryStop(void);
+    void _initialSyncParametersReady(bool parametersReady);
+    void _initialSyncMissionInProgressChanged(bool inProgress);
+    void _initialSyncMissionError(int errorCode, const QString& errorMsg);
+    void _setInitialSyncComplete(void);
 
     bool    _isAirplane                     ();
-    void    _addChange                      (int id);
+    void    _setDirty                       (quint32 properties);
     float   _oneDecimal                     (float value);
 
 private:
@@ -393,8 +433,8 @@ private:
     float           _navigationTargetBearing;
     float           _latitude;
     float           _longitude;
-    QTimer*         _refreshTimer;
-    QList<int>      _changes;
+    quint32         _dirtyProperties;       ///< Properties whose NOTIFY signal is pending, xxx_CHANGED bits
+    QTimer          _propertyFlushTimer;    ///< Single shot, only running while properties are dirty
     double          _batteryVoltage;
     double          _batteryPercent;
     double          _batteryConsumed;
@@ -406,9 +446,10 @@ private:
     quint16         _currentWaypoint;
     int             _satelliteCount;
     int             _satelliteLock;
-    int             _updateCount;
     
     MissionManager*     _missionManager;
+    VehicleCommandManager* _commandManager;
+    VehicleTimeSync*    _timeSync;
     QmlObjectListModel  _missionItems;
     
     bool    _armed;         ///< true: vehicle is armed
@@ -430,10 +471,25 @@ private:
     int     _nextSendMessageMultipleIndex;
     
     QTimer              _mapTrajectoryTimer;
-    QmlObjectListModel  _mapTrajectoryList;
-    QGeoCoordinate      _mapTrajectoryLastCoordinate;
-    bool                _mapTrajectoryHaveFirstCoordinate;
-    static const int    _mapTrajectoryMsecsBetweenPoints = 1000;
+    TrajectoryStore     _mapTrajectory;
+    static const int    _mapTrajectoryMsecsBetweenPoints = 250;
+    
+    typedef enum {
+        InitialSyncNotStarted,  ///< Waiting for a slot from VehicleSyncScheduler
+        InitialSyncParameters,  ///< Loading parameters
+        InitialSyncMission,     ///< Loading mission items
+        InitialSyncComplete
+    } InitialSyncState_t;
+    
+    InitialSyncState_t  _initialSyncState;
+    
+    // Per item costs used by estimatedMemoryFootprint. These are estimates, not measurements: a parameter is a Fact
+    // QObject with its private data, name and value plus its ParameterLoader map entries, its meta data is shared.
+    // A mission item is a MissionItem QObject which owns several Facts of its own.
+    static const int    _estimatedBytesPerParameter = 512;
+    static const int    _estimatedBytesPerMissionItem = 2048;
+    
+    static const int    _defaultPropertyFlushIntervalMsecs = 16;    ///< ~60Hz, one display frame
     
     // Settings keys
     static const char* _settingsGroup;
@@ -0,0 +1,201 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "VehicleCommandManager.h"
+#include "Vehicle.h"
+#include "MAVLinkProtocol.h"
+
+QGC_LOGGING_CATEGORY(VehicleCommandManagerLog, "VehicleCommandManagerLog")
+
+VehicleCommandManager::VehicleCommandManager(Vehicle* vehicle)
+    : QObject(vehicle)
+    , _vehicle(vehicle)
+    , _maxRetries(defaultMaxRetries)
+    , _rtoMsecs(initialRtoMsecs)
+    , _srttMsecs(-1)
+    , _rttVarMsecs(0)
+{
+    _retransmitTimer.setInterval(_retransmitCheckMsecs);
+    connect(&_retransmitTimer, &QTimer::timeout, this, &VehicleCommandManager::_checkRetransmits);
+}
+
+bool VehicleCommandManager::sendCommand(int component, MAV_CMD command, float param1, float param2, float param3, float param4, float param5, float param6, float param7)
+{
+    return _startCommand(component, command, false /* sendOnce */, param1, param2, param3, param4, param5, param6, param7);
+}
+
+bool VehicleCommandManager::sendCommandOnce(int component, MAV_CMD command, float param1, float param2, float param3, float param4, float param5, float param6, float param7)
+{
+    return _startCommand(component, command, true /* sendOnce */, param1, param2, param3, param4, param5, param6, param7);
+}
+
+bool VehicleCommandManager::isSendOnceCommand(MAV_CMD command)
+{
+    switch (command) {
+        case MAV_CMD_PREFLIGHT_REBOOT_SHUTDOWN:
+        case MAV_CMD_PREFLIGHT_CALIBRATION:
+        case MAV_CMD_PREFLIGHT_UAVCAN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool VehicleCommandManager::_startCommand(int component, MAV_CMD command, bool sendOnce, float param1, float param2, float param3, float param4, float param5, float param6, float param7)
+{
+    quint32 key = _key(component, command);
+    
+    if (_outstanding.contains(key)) {
+        qCDebug(VehicleCommandManagerLog) << "sendCommand: command already outstanding vehicle:component:command" << _vehicle->id() << component << command;
+        return false;
+    }
+    
+    OutstandingCommand_t outstanding;
+    
+    outstanding.command.command =           (uint16_t)command;
+    outstanding.command.confirmation =      0;
+    outstanding.command.param1 =            param1;
+    outstanding.command.param2 =            param2;
+    outstanding.command.param3 =            param3;
+    outstanding.command.param4 =            param4;
+    outstanding.command.param5 =            param5;
+    outstanding.command.param6 =            param6;
+    outstanding.command.param7 =            param7;
+    outstanding.command.target_system =     _vehicle->id();
+    outstanding.command.target_component =  component;
+    outstanding.retryCount =                0;
+    outstanding.sendOnce =                  sendOnce;
+    outstanding.retransmitted =             false;
+    outstanding.sendTime.start();
+    // Without retransmits the ack gets the longest timeout we would wait for
+    outstanding.deadlineMsecs =             sendOnce ? (int)maxRtoMsecs : _rtoMsecs;
+    
+    _outstanding[key] = outstanding;
+    _sendCommand(_outstanding[key]);
+    
+    if (!_retransmitTimer.isActive()) {
+        _retransmitTimer.start();
+    }
+    
+    return true;
+}
+
+void VehicleCommandManager::cancelCommand(int component, MAV_CMD command)
+{
+    _outstanding.remove(_key(component, command));
+    if (_outstanding.isEmpty()) {
+        _retransmitTimer.stop();
+    }
+}
+
+void VehicleCommandManager::commandAckReceived(const mavlink_message_t& message)
+{
+    mavlink_command_ack_t ack;
+    mavlink_msg_command_ack_decode(&message, &ack);
+    
+    // An ack from a specific component also completes a command which was sent to all components
+    quint32 key = _key(message.compid, ack.command);
+    if (!_outstanding.contains(key)) {
+        key = _key(MAV_COMP_ID_ALL, ack.command);
+        if (!_outstanding.contains(key)) {
+            qCDebug(VehicleCommandManagerLog) << "Ack for command which is not outstanding component:command:result" << message.compid << ack.command << ack.result;
+            return;
+        }
+    }
+    
+    OutstandingCommand_t outstanding = _outstanding.take(key);
+    if (_outstanding.isEmpty()) {
+        _retransmitTimer.stop();
+    }
+    
+    // Karn's algorithm: only sample round trips for commands which were sent once
+    if (!outstanding.retransmitted) {
+        _updateRto(outstanding.sendTime.elapsed());
+    }
+    
+    qCDebug(VehicleCommandManagerLog) << "Ack component:command:result:retries:rto" << message.compid << ack.command << ack.result << outstanding.retryCount << _rtoMsecs;
+    
+    emit commandResult(message.compid, ack.command, ack.result, false);
+}
+
+void VehicleCommandManager::_checkRetransmits(void)
+{
+    QList<quint32> timedOutKeys;
+    
+    for (QMap<quint32, OutstandingCommand_t>::iterator iter = _outstanding.begin(); iter != _outstanding.end(); ++iter) {
+        OutstandingCommand_t& outstanding = iter.value();
+        
+        if (outstanding.sendTime.elapsed() < outstanding.deadlineMsecs) {
+            continue;
+        }
+        
+        if (outstanding.sendOnce || outstanding.retryCount >= _maxRetries) {
+            timedOutKeys.append(iter.key());
+            continue;
+        }
+        
+        // Exponential backoff from the current estimate, the rto itself is only changed by measured round trips
+        outstanding.retryCount++;
+        outstanding.retransmitted = true;
+        outstanding.command.confirmation = outstanding.retryCount;
+        outstanding.deadlineMsecs = outstanding.sendTime.elapsed() + qMin(_rtoMsecs << outstanding.retryCount, (int)maxRtoMsecs);
+        
+        qCDebug(VehicleCommandManagerLog) << "Retransmit component:command:retry" << outstanding.command.target_component << outstanding.command.command << outstanding.retryCount;
+        _sendCommand(outstanding);
+    }
+    
+    foreach (quint32 key, timedOutKeys) {
+        OutstandingCommand_t outstanding = _outstanding.take(key);
+        
+        qCDebug(VehicleCommandManagerLog) << "Timeout component:command" << outstanding.command.target_component << outstanding.command.command;
+        emit commandResult(outstanding.command.target_component, outstanding.command.command, MAV_RESULT_FAILED, true);
+    }
+    
+    if (_outstanding.isEmpty()) {
+        _retransmitTimer.stop();
+    }
+}
+
+void VehicleCommandManager::_sendCommand(OutstandingCommand_t& outstanding)
+{
+    mavlink_message_t msg;
+    
+    mavlink_msg_command_long_encode(MAVLinkProtocol::instance()->getSystemId(), MAVLinkProtocol::instance()->getComponentId(), &msg, &outstanding.command);
+    _vehicle->sendMessage(msg);
+}
+
+/// Standard smoothed round trip estimator (RFC 6298): rto = srtt + 4 * rttvar
+void VehicleCommandManager::_updateRto(qint64 rttMsecs)
+{
+    int rtt = (int)rttMsecs;
+    
+    if (_srttMsecs == -1) {
+        _srttMsecs = rtt;
+        _rttVarMsecs = rtt / 2;
+    } else {
+        _rttVarMsecs = (3 * _rttVarMsecs + qAbs(_srttMsecs - rtt)) / 4;
+        _srttMsecs = (7 * _srttMsecs + rtt) / 8;
+    }
+    
+    _rtoMsecs = qBound((int)minRtoMsecs, _srttMsecs + 4 * _rttVarMsecs, (int)maxRtoMsecs);
+}
@@ -0,0 +1,130 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef VehicleCommandManager_H
+#define VehicleCommandManager_H
+
+#include <QObject>
+#include <QMap>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "QGCMAVLink.h"
+#include "QGCLoggingCategory.h"
+
+class Vehicle;
+
+Q_DECLARE_LOGGING_CATEGORY(VehicleCommandManagerLog)
+
+/// @file
+///     @brief Sends COMMAND_LONG messages to a vehicle and matches the COMMAND_ACK responses back to them.
+///             Each (component, command) pair can have one command outstanding, different commands are in
+///             flight at the same time. Commands which are not acked are retransmitted using a retransmit
+///             timeout which is adapted to the round trip times measured from previous acks. Commands which must
+///             not run twice, such as reboot, are sent once and only tracked for their ack.
+
+class VehicleCommandManager : public QObject
+{
+    Q_OBJECT
+    
+public:
+    VehicleCommandManager(Vehicle* vehicle);
+    
+    /// Sends the command and tracks it until it is acked or runs out of retries. Completion is signalled
+    /// through commandResult.
+    ///     @param component Target component, MAV_COMP_ID_ALL (0) matches an ack from any component
+    ///     @return false: The same command is already outstanding for the component, nothing was sent
+    bool sendCommand(int component, MAV_CMD command, float param1 = 0.0f, float param2 = 0.0f, float param3 = 0.0f, float param4 = 0.0f, float param5 = 0.0f, float param6 = 0.0f, float param7 = 0.0f);
+    
+    /// Sends the command a single time. The ack is still matched and signalled through commandResult, if no ack
+    /// arrives within maxRtoMsecs the command times out.
+    ///     @return false: The same command is already outstanding for the component, nothing was sent
+    bool sendCommandOnce(int component, MAV_CMD command, float param1 = 0.0f, float param2 = 0.0f, float param3 = 0.0f, float param4 = 0.0f, float param5 = 0.0f, float param6 = 0.0f, float param7 = 0.0f);
+    
+    /// @return true: Command must be sent with sendCommandOnce since running it twice has side effects. Reboot
+    ///                 would happen again, calibration and bus configuration would restart.
+    static bool isSendOnceCommand(MAV_CMD command);
+    
+    /// Stops retransmitting the command. No commandResult is signalled for it.
+    void cancelCommand(int component, MAV_CMD command);
+    
+    /// Called by Vehicle for each COMMAND_ACK message received from the vehicle
+    void commandAckReceived(const mavlink_message_t& message);
+    
+    bool isOutstanding(int component, MAV_CMD command) { return _outstanding.contains(_key(component, command)); }
+    int outstandingCount(void) { return _outstanding.count(); }
+    
+    /// Current retransmit timeout in msecs
+    int rtoMsecs(void) { return _rtoMsecs; }
+    
+    /// Smoothed ack round trip time in msecs, -1 if no round trip has been measured yet
+    int srttMsecs(void) { return _srttMsecs; }
+    
+    /// Number of times a command is retransmitted before giving up
+    int maxRetries(void) { return _maxRetries; }
+    void setMaxRetries(int maxRetries) { _maxRetries = maxRetries; }
+    
+    static const int defaultMaxRetries = 3;
+    static const int initialRtoMsecs = 1000;
+    static const int minRtoMsecs = 100;
+    static const int maxRtoMsecs = 4000;
+    
+signals:
+    /// Signalled once for each command sent with sendCommand
+    ///     @param component Component which acked the command, or the target component on timeout
+    ///     @param command MAV_CMD which completed
+    ///     @param result MAV_RESULT from the ack, MAV_RESULT_FAILED on timeout
+    ///     @param timedOut true: No ack was received after all retries
+    void commandResult(int component, int command, int result, bool timedOut);
+    
+private slots:
+    void _checkRetransmits(void);
+    
+private:
+    typedef struct {
+        mavlink_command_long_t  command;
+        int                     retryCount;
+        bool                    sendOnce;       ///< true: Never retransmitted
+        bool                    retransmitted;  ///< true: Round trip can't be measured since the ack may be for an earlier send
+        QElapsedTimer           sendTime;       ///< Time since the first transmission
+        qint64                  deadlineMsecs;  ///< Time since first transmission at which the next retransmit is due
+    } OutstandingCommand_t;
+    
+    static quint32 _key(int component, int command) { return ((quint32)(component & 0xFF) << 16) | (command & 0xFFFF); }
+    
+    bool _startCommand(int component, MAV_CMD command, bool sendOnce, float param1, float param2, float param3, float param4, float param5, float param6, float param7);
+    void _sendCommand(OutstandingCommand_t& outstanding);
+    void _updateRto(qint64 rttMsecs);
+    
+    Vehicle*                                _vehicle;
+    QMap<quint32, OutstandingCommand_t>     _outstanding;   ///< Keyed by _key(component, command)
+    QTimer                                  _retransmitTimer;   ///< Only runs while commands are outstanding
+    int                                     _maxRetries;
+    int                                     _rtoMsecs;
+    int                                     _srttMsecs;
+    int                                     _rttVarMsecs;
+    
+    static const int _retransmitCheckMsecs = 50;
+};
+
+#endif
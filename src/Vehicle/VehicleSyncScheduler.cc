@@ -0,0 +1,152 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "VehicleSyncScheduler.h"
+#include "Vehicle.h"
+
+QGC_LOGGING_CATEGORY(VehicleSyncSchedulerLog, "VehicleSyncSchedulerLog")
+
+VehicleSyncScheduler::VehicleSyncScheduler(QObject* parent)
+    : QObject(parent)
+    , _activeVehicle(NULL)
+    , _maxConcurrent(defaultMaxConcurrent)
+    , _syncTimeoutMsecs(defaultSyncTimeoutMsecs)
+{
+    _timeoutTimer.setInterval(1000);
+    connect(&_timeoutTimer, &QTimer::timeout, this, &VehicleSyncScheduler::_checkTimeouts);
+}
+
+void VehicleSyncScheduler::setMaxConcurrent(int maxConcurrent)
+{
+    _maxConcurrent = qMax(maxConcurrent, 1);
+    _startNext();
+}
+
+void VehicleSyncScheduler::addVehicle(Vehicle* vehicle)
+{
+    if (_pending.contains(vehicle) || _running.contains(vehicle) || vehicle->initialSyncComplete()) {
+        return;
+    }
+    
+    qCDebug(VehicleSyncSchedulerLog) << "addVehicle" << vehicle->id();
+    
+    connect(vehicle, &Vehicle::initialSyncCompleteChanged, this, &VehicleSyncScheduler::_initialSyncCompleteChanged);
+    _pending.append(vehicle);
+    _startNext();
+}
+
+void VehicleSyncScheduler::removeVehicle(Vehicle* vehicle)
+{
+    disconnect(vehicle, &Vehicle::initialSyncCompleteChanged, this, &VehicleSyncScheduler::_initialSyncCompleteChanged);
+    
+    if (_activeVehicle == vehicle) {
+        _activeVehicle = NULL;
+    }
+    _pending.removeOne(vehicle);
+    _timedOut.removeOne(vehicle);
+    if (_running.removeOne(vehicle)) {
+        _runTime.remove(vehicle);
+        if (_running.count() == 0) {
+            _timeoutTimer.stop();
+        }
+        _startNext();
+    }
+}
+
+void VehicleSyncScheduler::setActiveVehicle(Vehicle* vehicle)
+{
+    _activeVehicle = vehicle;
+}
+
+void VehicleSyncScheduler::prioritizeVehicle(Vehicle* vehicle)
+{
+    if (_pending.removeOne(vehicle)) {
+        qCDebug(VehicleSyncSchedulerLog) << "prioritizeVehicle" << vehicle->id();
+        _pending.prepend(vehicle);
+    }
+}
+
+void VehicleSyncScheduler::_startNext(void)
+{
+    while (_running.count() < _maxConcurrent && _pending.count()) {
+        Vehicle* vehicle;
+        
+        if (_activeVehicle && _pending.removeOne(_activeVehicle)) {
+            vehicle = _activeVehicle;
+        } else {
+            vehicle = _pending.takeFirst();
+        }
+        
+        qCDebug(VehicleSyncSchedulerLog) << "Starting sync" << vehicle->id() << "running:pending" << _running.count() + 1 << _pending.count();
+        
+        _running.append(vehicle);
+        _runTime[vehicle].start();
+        if (!_timeoutTimer.isActive()) {
+            _timeoutTimer.start();
+        }
+        
+        emit syncStarted(vehicle);
+        vehicle->startInitialSync();
+    }
+}
+
+/// Frees the slot of a vehicle whose sync has completed
+void VehicleSyncScheduler::_finish(Vehicle* vehicle)
+{
+    bool timedOut = _timedOut.removeOne(vehicle);
+    
+    qCDebug(VehicleSyncSchedulerLog) << "Sync finished" << vehicle->id() << "msecs" << _runTime[vehicle].elapsed() << "timedOut" << timedOut;
+    
+    _running.removeOne(vehicle);
+    _runTime.remove(vehicle);
+    if (_running.count() == 0) {
+        _timeoutTimer.stop();
+    }
+    
+    // A timed out sync has already been signalled
+    if (!timedOut) {
+        emit syncFinished(vehicle, false);
+    }
+    _startNext();
+}
+
+void VehicleSyncScheduler::_initialSyncCompleteChanged(bool initialSyncComplete)
+{
+    Vehicle* vehicle = qobject_cast<Vehicle*>(sender());
+    
+    if (vehicle && initialSyncComplete && _running.contains(vehicle)) {
+        _finish(vehicle);
+    }
+}
+
+void VehicleSyncScheduler::_checkTimeouts(void)
+{
+    foreach (Vehicle* vehicle, _running) {
+        if (!_timedOut.contains(vehicle) && _runTime[vehicle].elapsed() > _syncTimeoutMsecs) {
+            // The loads can't be cancelled, the slot stays taken until they give up or complete on their own
+            qCWarning(VehicleSyncSchedulerLog) << "Sync timed out" << vehicle->id();
+            _timedOut.append(vehicle);
+            emit syncFinished(vehicle, true);
+        }
+    }
+}
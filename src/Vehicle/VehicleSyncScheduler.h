@@ -0,0 +1,107 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef VehicleSyncScheduler_H
+#define VehicleSyncScheduler_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "QGCLoggingCategory.h"
+
+class Vehicle;
+
+Q_DECLARE_LOGGING_CATEGORY(VehicleSyncSchedulerLog)
+
+/// @file
+///     @brief Limits how many vehicles run their initial parameter and mission sync at the same time. New
+///             vehicles are usable for telemetry right away, their sync is queued and started as slots free
+///             up. The active vehicle goes first, followed by vehicles the user has focused, then the rest in
+///             the order they arrived.
+
+class VehicleSyncScheduler : public QObject
+{
+    Q_OBJECT
+    
+public:
+    VehicleSyncScheduler(QObject* parent = NULL);
+    
+    /// Queues the initial sync for a new vehicle, it starts immediately if a slot is free
+    void addVehicle(Vehicle* vehicle);
+    
+    /// Removes a vehicle which is going away, freeing its slot if it was syncing
+    void removeVehicle(Vehicle* vehicle);
+    
+    /// The active vehicle is always the next to start
+    void setActiveVehicle(Vehicle* vehicle);
+    
+    /// Moves a queued vehicle ahead of all other queued vehicles except the active one
+    void prioritizeVehicle(Vehicle* vehicle);
+    
+    /// Maximum number of vehicles syncing at the same time
+    int maxConcurrent(void) { return _maxConcurrent; }
+    void setMaxConcurrent(int maxConcurrent);
+    
+    /// Msecs after which a sync which has not completed is reported as timed out. Its parameter and mission loads
+    /// keep running and hold on to the slot until they finish, so no more than maxConcurrent loads ever run at once.
+    int syncTimeoutMsecs(void) { return _syncTimeoutMsecs; }
+    void setSyncTimeoutMsecs(int msecs) { _syncTimeoutMsecs = msecs; }
+    
+    int runningCount(void) { return _running.count(); }
+    int pendingCount(void) { return _pending.count(); }
+    bool isRunning(Vehicle* vehicle) { return _running.contains(vehicle); }
+    bool isPending(Vehicle* vehicle) { return _pending.contains(vehicle); }
+    
+    static const int defaultMaxConcurrent = 2;
+    static const int defaultSyncTimeoutMsecs = 60000;
+    
+signals:
+    void syncStarted(Vehicle* vehicle);
+    
+    /// Signalled when a sync completes, or when it has not completed in time. A timed out sync is not signalled
+    /// again when it completes later.
+    ///     @param timedOut true: Sync did not complete in time
+    void syncFinished(Vehicle* vehicle, bool timedOut);
+    
+private slots:
+    void _initialSyncCompleteChanged(bool initialSyncComplete);
+    void _checkTimeouts(void);
+    
+private:
+    void _startNext(void);
+    void _finish(Vehicle* vehicle);
+    
+    QList<Vehicle*>                 _pending;       ///< Queued vehicles, in the order they will start
+    QList<Vehicle*>                 _running;       ///< Vehicles holding a slot, including timed out ones
+    QList<Vehicle*>                 _timedOut;      ///< Running vehicles which have been reported as timed out
+    QHash<Vehicle*, QElapsedTimer>  _runTime;       ///< Time since each running vehicle started
+    Vehicle*                        _activeVehicle;
+    int                             _maxConcurrent;
+    int                             _syncTimeoutMsecs;
+    QTimer                          _timeoutTimer;  ///< Only runs while vehicles are syncing
+};
+
+#endif
@@ -0,0 +1,278 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "VehicleTimeSync.h"
+#include "Vehicle.h"
+#include "MAVLinkProtocol.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QReadLocker>
+#include <QWriteLocker>
+
+QGC_LOGGING_CATEGORY(VehicleTimeSyncLog, "VehicleTimeSyncLog")
+
+QReadWriteLock                  VehicleTimeSync::_publishedLock;
+QHash<int, TimeSyncEstimator>   VehicleTimeSync::_published;
+
+TimeSyncEstimator::TimeSyncEstimator(void)
+    : _resetCount(0)
+{
+    reset();
+}
+
+void TimeSyncEstimator::reset(void)
+{
+    _samples.clear();
+    _valid = false;
+    _refGcsNsecs = 0;
+    _refOffsetNsecs = 0;
+    _drift = 0.0;
+    _minRttNsecs = 0;
+}
+
+void TimeSyncEstimator::addSample(qint64 gcsSendNsecs, qint64 onboardNsecs, qint64 gcsReceiveNsecs)
+{
+    qint64 rttNsecs = gcsReceiveNsecs - gcsSendNsecs;
+    if (rttNsecs < 0) {
+        return;
+    }
+    
+    // Assume a symmetric link, the vehicle read its clock half way through the round trip
+    Sample_t sample;
+    sample.gcsNsecs = gcsSendNsecs + rttNsecs / 2;
+    sample.offsetNsecs = sample.gcsNsecs - onboardNsecs;
+    sample.rttNsecs = rttNsecs;
+    
+    // The offset error of a sample is at most half its round trip, anything beyond that means the vehicle
+    // clock has restarted
+    if (_valid && qAbs(sample.offsetNsecs - offsetNsecs(sample.gcsNsecs)) > jumpThresholdNsecs + rttNsecs / 2) {
+        reset();
+        _resetCount++;
+    }
+    
+    _samples.append(sample);
+    if (_samples.count() > windowSize) {
+        _samples.removeFirst();
+    }
+    
+    _fit();
+}
+
+qint64 TimeSyncEstimator::offsetNsecs(qint64 gcsNsecs) const
+{
+    return _refOffsetNsecs + (qint64)(_drift * (double)(gcsNsecs - _refGcsNsecs));
+}
+
+qint64 TimeSyncEstimator::onboardToGcsNsecs(qint64 onboardNsecs) const
+{
+    // The drift term only needs an approximate GCS time, the reference offset is close enough
+    return onboardNsecs + offsetNsecs(onboardNsecs + _refOffsetNsecs);
+}
+
+void TimeSyncEstimator::_fit(void)
+{
+    // Only the samples with the smallest round trips are used, queueing delays only ever make a round trip
+    // longer so those samples are the closest to the true offset
+    QList<qint64> rtts;
+    foreach (const Sample_t& sample, _samples) {
+        rtts.append(sample.rttNsecs);
+    }
+    qSort(rtts);
+    
+    int fitCount = qMin(qMax((int)minFitSamples, _samples.count() / 4), _samples.count());
+    qint64 rttLimit = rtts[fitCount - 1];
+    _minRttNsecs = rtts[0];
+    
+    // Work relative to the first sample, nsec Unix times do not fit in a double without losing precision
+    qint64 baseGcsNsecs = _samples[0].gcsNsecs;
+    qint64 baseOffsetNsecs = _samples[0].offsetNsecs;
+    
+    QList<Sample_t> fitSamples;
+    double sumTime = 0.0;
+    double sumOffset = 0.0;
+    foreach (const Sample_t& sample, _samples) {
+        if (sample.rttNsecs <= rttLimit) {
+            fitSamples.append(sample);
+            sumTime += sample.gcsNsecs - baseGcsNsecs;
+            sumOffset += sample.offsetNsecs - baseOffsetNsecs;
+        }
+    }
+    double meanTime = sumTime / fitSamples.count();
+    double meanOffset = sumOffset / fitSamples.count();
+    
+    // Least squares line through the selected samples, only once they cover enough time for the slope to be
+    // more than noise
+    double drift = 0.0;
+    if (fitSamples.last().gcsNsecs - fitSamples.first().gcsNsecs >= minFitSpanNsecs) {
+        double sumTimeTime = 0.0;
+        double sumTimeOffset = 0.0;
+        
+        foreach (const Sample_t& sample, fitSamples) {
+            double time = (sample.gcsNsecs - baseGcsNsecs) - meanTime;
+            double offset = (sample.offsetNsecs - baseOffsetNsecs) - meanOffset;
+            sumTimeTime += time * time;
+            sumTimeOffset += time * offset;
+        }
+        if (sumTimeTime > 0.0) {
+            double maxDrift = maxDriftPpm / 1e6;
+            drift = qBound(-maxDrift, sumTimeOffset / sumTimeTime, maxDrift);
+        }
+    }
+    
+    _refGcsNsecs = baseGcsNsecs + (qint64)meanTime;
+    _refOffsetNsecs = baseOffsetNsecs + (qint64)meanOffset;
+    _drift = drift;
+    _valid = true;
+}
+
+VehicleTimeSync::VehicleTimeSync(Vehicle* vehicle)
+    : QObject(vehicle)
+    , _vehicle(vehicle)
+    , _systemId(vehicle->id())
+    , _unansweredCount(0)
+{
+    _requestTimer.setInterval(fastIntervalMsecs);
+    connect(&_requestTimer, &QTimer::timeout, this, &VehicleTimeSync::_sendRequest);
+    _requestTimer.start();
+}
+
+VehicleTimeSync::~VehicleTimeSync()
+{
+    QWriteLocker locker(&_publishedLock);
+    _published.remove(_systemId);
+}
+
+qint64 VehicleTimeSync::gcsTimeNsecs(void)
+{
+    // The wall clock only has msec resolution. It is sampled once and then advanced with the monotonic timer,
+    // which also keeps the time base steady across system clock adjustments.
+    static QElapsedTimer    elapsedTimer;
+    static qint64           baseNsecs = 0;
+    
+    if (!elapsedTimer.isValid()) {
+        baseNsecs = QDateTime::currentMSecsSinceEpoch() * 1000000LL;
+        elapsedTimer.start();
+    }
+    
+    return baseNsecs + elapsedTimer.nsecsElapsed();
+}
+
+void VehicleTimeSync::_sendRequest(void)
+{
+    qint64 ts1 = gcsTimeNsecs();
+    
+    _outstandingRequests.append(ts1);
+    if (_outstandingRequests.count() > _maxOutstandingRequests) {
+        _outstandingRequests.removeFirst();
+    }
+    
+    _sendTimesync(0, ts1);
+    
+    // Not every vehicle implements TIMESYNC, don't keep polling one which never answers at the fast rate
+    if (++_unansweredCount > maxUnansweredRequests) {
+        int interval = qMin(_requestTimer.interval() * 2, (int)backoffIntervalMsecs);
+        if (_requestTimer.interval() != interval) {
+            qCDebug(VehicleTimeSyncLog) << "No response, backing off vehicle:interval" << _vehicle->id() << interval;
+            _requestTimer.setInterval(interval);
+        }
+    }
+}
+
+void VehicleTimeSync::_sendTimesync(qint64 tc1, qint64 ts1)
+{
+    mavlink_message_t   msg;
+    mavlink_timesync_t  timesync;
+    
+    timesync.tc1 = tc1;
+    timesync.ts1 = ts1;
+    mavlink_msg_timesync_encode(MAVLinkProtocol::instance()->getSystemId(), MAVLinkProtocol::instance()->getComponentId(), &msg, &timesync);
+    _vehicle->sendMessage(msg);
+}
+
+void VehicleTimeSync::timesyncReceived(const mavlink_message_t& message)
+{
+    qint64 nowNsecs = gcsTimeNsecs();
+    
+    mavlink_timesync_t timesync;
+    mavlink_msg_timesync_decode(&message, &timesync);
+    
+    // Vehicle only filters on system id when it is non-zero, a response must come from this vehicle
+    if (message.sysid != _systemId) {
+        qCDebug(VehicleTimeSyncLog) << "Ignoring TIMESYNC from other system vehicle:sysid" << _systemId << message.sysid;
+        return;
+    }
+    
+    if (timesync.tc1 == 0) {
+        // Request from the vehicle, answer it so the vehicle can sync to us as well
+        _sendTimesync(nowNsecs, timesync.ts1);
+        return;
+    }
+    
+    int index = _outstandingRequests.indexOf(timesync.ts1);
+    if (index == -1) {
+        // Response to another GCS, or a request which we have given up on
+        qCDebug(VehicleTimeSyncLog) << "Ignoring unknown response vehicle:ts1" << _vehicle->id() << timesync.ts1;
+        return;
+    }
+    
+    // Earlier requests still outstanding have been lost
+    _outstandingRequests = _outstandingRequests.mid(index + 1);
+    _unansweredCount = 0;
+    
+    int resetCount = _estimator.resetCount();
+    _estimator.addSample(timesync.ts1, timesync.tc1, nowNsecs);
+    if (_estimator.resetCount() != resetCount) {
+        qCDebug(VehicleTimeSyncLog) << "Vehicle clock jumped, resetting time sync vehicle:" << _vehicle->id();
+    }
+    
+    int interval = _estimator.sampleCount() < 2 * TimeSyncEstimator::minFitSamples ? fastIntervalMsecs : slowIntervalMsecs;
+    if (_requestTimer.interval() != interval) {
+        _requestTimer.setInterval(interval);
+    }
+    
+    qCDebug(VehicleTimeSyncLog) << "vehicle:rtt:offset:drift" << _vehicle->id() << (nowNsecs - timesync.ts1) / 1000 << "usecs"
+                                << _estimator.offsetNsecs(nowNsecs) / 1000000 << "msecs" << _estimator.driftPpm() << "ppm";
+    
+    _publish();
+    emit timeSyncUpdated();
+}
+
+void VehicleTimeSync::_publish(void)
+{
+    QWriteLocker locker(&_publishedLock);
+    _published[_systemId] = _estimator;
+}
+
+bool VehicleTimeSync::onboardToGcsMsecs(int systemId, quint64 onboardMsecs, quint64* gcsMsecs)
+{
+    QReadLocker locker(&_publishedLock);
+    
+    QHash<int, TimeSyncEstimator>::const_iterator iter = _published.constFind(systemId);
+    if (iter == _published.constEnd() || !iter.value().valid()) {
+        return false;
+    }
+    
+    *gcsMsecs = (iter.value().onboardToGcsNsecs((qint64)onboardMsecs * 1000000LL) + 500000LL) / 1000000LL;
+    return true;
+}
@@ -0,0 +1,162 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef VehicleTimeSync_H
+#define VehicleTimeSync_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+#include <QReadWriteLock>
+
+#include "QGCMAVLink.h"
+#include "QGCLoggingCategory.h"
+
+class Vehicle;
+
+Q_DECLARE_LOGGING_CATEGORY(VehicleTimeSyncLog)
+
+/// @file
+///     @brief Estimates the offset between a vehicle's boot clock and the GCS clock from TIMESYNC round trips.
+///             Only the samples with the smallest round trip are trusted since their offset carries the least
+///             link delay, a line is fitted through those to follow the drift between the two clocks.
+
+/// Filters TIMESYNC samples into a stable onboard to GCS time mapping. All times are in nsecs.
+class TimeSyncEstimator
+{
+public:
+    TimeSyncEstimator(void);
+    
+    void reset(void);
+    
+    /// Adds the result of one TIMESYNC round trip
+    ///     @param gcsSendNsecs GCS time the request was sent
+    ///     @param onboardNsecs Vehicle boot time from the response
+    ///     @param gcsReceiveNsecs GCS time the response arrived
+    void addSample(qint64 gcsSendNsecs, qint64 onboardNsecs, qint64 gcsReceiveNsecs);
+    
+    /// @return true: At least one sample is available for the mapping
+    bool valid(void) const { return _valid; }
+    
+    /// @return Vehicle boot time converted to GCS time
+    qint64 onboardToGcsNsecs(qint64 onboardNsecs) const;
+    
+    /// @return Offset to add to vehicle boot time to get GCS time at the specified GCS time
+    qint64 offsetNsecs(qint64 gcsNsecs) const;
+    
+    /// Smallest round trip in the current window
+    qint64 minRttNsecs(void) const { return _minRttNsecs; }
+    
+    /// Rate at which the vehicle clock runs fast (positive) or slow relative to the GCS clock
+    double driftPpm(void) const { return -_drift * 1e6; }
+    
+    int sampleCount(void) const { return _samples.count(); }
+    
+    /// Number of times the mapping was thrown away because the vehicle clock jumped, usually a reboot
+    int resetCount(void) const { return _resetCount; }
+    
+    static const int windowSize = 32;           ///< Number of most recent samples kept
+    static const int minFitSamples = 4;         ///< Minimum number of low round trip samples used for the fit
+    static const qint64 maxDriftPpm = 500;      ///< Larger fitted drifts are not believable for a crystal clock
+    static const qint64 minFitSpanNsecs = 2000000000LL; ///< Samples must span this much time before drift is fitted
+    static const qint64 jumpThresholdNsecs = 1000000000LL;  ///< Unexplained offset change which resets the mapping
+    
+private:
+    typedef struct {
+        qint64  gcsNsecs;       ///< Midpoint of the round trip
+        qint64  offsetNsecs;
+        qint64  rttNsecs;
+    } Sample_t;
+    
+    void _fit(void);
+    
+    QList<Sample_t> _samples;       ///< Oldest first
+    bool            _valid;
+    qint64          _refGcsNsecs;   ///< Reference point of the fitted line
+    qint64          _refOffsetNsecs;
+    double          _drift;         ///< Change in offset per nsec of GCS time
+    qint64          _minRttNsecs;
+    int             _resetCount;
+};
+
+/// Exchanges TIMESYNC messages with a single vehicle and publishes the resulting time mapping for use by
+/// other threads (MAVLinkDecoder) through onboardToGcsMsecs.
+class VehicleTimeSync : public QObject
+{
+    Q_OBJECT
+    
+public:
+    VehicleTimeSync(Vehicle* vehicle);
+    ~VehicleTimeSync();
+    
+    /// Called by Vehicle for each TIMESYNC message received from the vehicle
+    void timesyncReceived(const mavlink_message_t& message);
+    
+    const TimeSyncEstimator& estimator(void) { return _estimator; }
+    
+    /// Converts a vehicle time since boot to GCS Unix time in msecs. Thread safe.
+    ///     @return false: No time mapping is available for the vehicle yet
+    static bool onboardToGcsMsecs(int systemId, quint64 onboardMsecs, quint64* gcsMsecs);
+    
+    /// GCS Unix time with sub-millisecond resolution, which is the time base for TIMESYNC
+    static qint64 gcsTimeNsecs(void);
+    
+    /// Current msecs between requests
+    int requestIntervalMsecs(void) const { return _requestTimer.interval(); }
+    
+    /// Msecs between requests until the estimator has enough samples for a fit, after that slowIntervalMsecs
+    static const int fastIntervalMsecs = 200;
+    static const int slowIntervalMsecs = 1000;
+    
+    /// Vehicles which do not answer TIMESYNC are polled less and less often, down to one request per backoffIntervalMsecs
+    static const int maxUnansweredRequests = 10;
+    static const int backoffIntervalMsecs = 30000;
+    
+signals:
+    /// Signalled when a round trip has updated the time mapping
+    void timeSyncUpdated(void);
+    
+private slots:
+    void _sendRequest(void);
+    
+private:
+    void _sendTimesync(qint64 tc1, qint64 ts1);
+    void _publish(void);
+    
+    Vehicle*            _vehicle;
+    int                 _systemId;              ///< Cached for the destructor, which runs after the Vehicle destructor
+    QTimer              _requestTimer;
+    TimeSyncEstimator   _estimator;
+    QList<qint64>       _outstandingRequests;   ///< ts1 of requests not answered yet, used to ignore other GCS requests
+    int                 _unansweredCount;       ///< Requests sent since the last response
+    
+    static QReadWriteLock                   _publishedLock;
+    static QHash<int, TimeSyncEstimator>    _published;     ///< Keyed by system id
+    
+    static const int _maxOutstandingRequests = 10;
+    
+    friend class VehicleTimeSyncTest;
+};
+
+#endif
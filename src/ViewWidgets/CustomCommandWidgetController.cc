@@ -23,6 +23,7 @@
 
 #include "CustomCommandWidgetController.h"
 #include "MultiVehicleManager.h"
+#include "QGCApplication.h"
 #include "QGCMAVLink.h"
 #include "QGCFileDialog.h"
 #include "UAS.h"
@@ -42,7 +43,7 @@ CustomCommandWidgetController::CustomCommandWidgetController(void) :
     _customQmlFile = settings.value(_settingsKey).toString();
 }
 
-void CustomCommandWidgetController::sendCommand(int commandId, QVariant componentId, QVariant confirm, QVariant param1, QVariant param2, QVariant param3, QVariant param4, QVariant param5, QVariant param6, QVariant param7)
+bool CustomCommandWidgetController::sendCommand(int commandId, QVariant componentId, QVariant confirm, QVariant param1, QVariant param2, QVariant param3, QVariant param4, QVariant param5, QVariant param6, QVariant param7)
 {
     Q_UNUSED(commandId);
     Q_UNUSED(componentId);
@@ -54,7 +55,11 @@ void CustomCommandWidgetController::sendCommand(int commandId, QVariant componen
     Q_UNUSED(param5);
     Q_UNUSED(param6);
     Q_UNUSED(param7);
-    _uas->executeCommand((MAV_CMD)commandId, confirm.toInt(), param1.toFloat(), param2.toFloat(), param3.toFloat(), param4.toFloat(), param5.toFloat(), param6.toFloat(), param7.toFloat(), componentId.toInt());
+    if (!_uas->executeCommand((MAV_CMD)commandId, confirm.toInt(), param1.toFloat(), param2.toFloat(), param3.toFloat(), param4.toFloat(), param5.toFloat(), param6.toFloat(), param7.toFloat(), componentId.toInt())) {
+        qgcApp()->showToolBarMessage(QString("Command %1 not sent, vehicle has not responded to the previous one yet.").arg(commandId));
+        return false;
+    }
+    return true;
 }
 
 void CustomCommandWidgetController::selectQmlFile(void)
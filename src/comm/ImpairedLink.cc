@@ -0,0 +1,441 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "ImpairedLink.h"
+
+#include <QDebug>
+
+#include <string.h>
+
+QGC_LOGGING_CATEGORY(ImpairedLinkLog, "ImpairedLinkLog")
+
+const char* ImpairedLinkConfiguration::_innerTypeKey =          "innerType";
+const char* ImpairedLinkConfiguration::_innerGroupKey =         "inner";
+const char* ImpairedLinkConfiguration::_latencyKey =            "latencyMsecs";
+const char* ImpairedLinkConfiguration::_jitterKey =             "jitterMsecs";
+const char* ImpairedLinkConfiguration::_bandwidthKey =          "bandwidthBitsPerSecond";
+const char* ImpairedLinkConfiguration::_lossKey =               "lossPercent";
+const char* ImpairedLinkConfiguration::_burstLossStartKey =     "burstLossStartPercent";
+const char* ImpairedLinkConfiguration::_burstLossLengthKey =    "burstLossLength";
+const char* ImpairedLinkConfiguration::_duplicateKey =          "duplicatePercent";
+const char* ImpairedLinkConfiguration::_reorderKey =            "reorderPercent";
+const char* ImpairedLinkConfiguration::_seedKey =               "seed";
+
+ImpairedLinkConfiguration::ImpairedLinkConfiguration(const QString& name)
+    : LinkConfiguration(name)
+    , _innerConfig(NULL)
+    , _latencyMsecs(0)
+    , _jitterMsecs(0)
+    , _bandwidthBitsPerSecond(0)
+    , _lossPercent(0.0)
+    , _burstLossStartPercent(0.0)
+    , _burstLossLength(1)
+    , _duplicatePercent(0.0)
+    , _reorderPercent(0.0)
+    , _seed(1)
+{
+    _innerConfig = LinkConfiguration::createSettings(LinkConfiguration::TypeMock, name);
+}
+
+ImpairedLinkConfiguration::ImpairedLinkConfiguration(ImpairedLinkConfiguration* copy)
+    : LinkConfiguration(copy)
+    , _innerConfig(NULL)
+{
+    _copyValues(copy);
+}
+
+ImpairedLinkConfiguration::~ImpairedLinkConfiguration()
+{
+    delete _innerConfig;
+}
+
+void ImpairedLinkConfiguration::setInnerConfiguration(LinkConfiguration* config)
+{
+    Q_ASSERT(!config || config->type() != LinkConfiguration::TypeImpaired);
+
+    delete _innerConfig;
+    _innerConfig = config;
+}
+
+void ImpairedLinkConfiguration::_copyValues(ImpairedLinkConfiguration* source)
+{
+    Q_ASSERT(source != NULL);
+
+    _latencyMsecs =             source->latencyMsecs();
+    _jitterMsecs =              source->jitterMsecs();
+    _bandwidthBitsPerSecond =   source->bandwidthBitsPerSecond();
+    _lossPercent =              source->lossPercent();
+    _burstLossStartPercent =    source->burstLossStartPercent();
+    _burstLossLength =          source->burstLossLength();
+    _duplicatePercent =         source->duplicatePercent();
+    _reorderPercent =           source->reorderPercent();
+    _seed =                     source->seed();
+
+    setInnerConfiguration(source->innerConfiguration() ? LinkConfiguration::duplicateSettings(source->innerConfiguration()) : NULL);
+}
+
+void ImpairedLinkConfiguration::copyFrom(LinkConfiguration* source)
+{
+    LinkConfiguration::copyFrom(source);
+    _copyValues(dynamic_cast<ImpairedLinkConfiguration*>(source));
+}
+
+void ImpairedLinkConfiguration::saveSettings(QSettings& settings, const QString& root)
+{
+    settings.beginGroup(root);
+    settings.setValue(_innerTypeKey,        _innerConfig ? _innerConfig->type() : (int)LinkConfiguration::TypeLast);
+    settings.setValue(_latencyKey,          _latencyMsecs);
+    settings.setValue(_jitterKey,           _jitterMsecs);
+    settings.setValue(_bandwidthKey,        _bandwidthBitsPerSecond);
+    settings.setValue(_lossKey,             _lossPercent);
+    settings.setValue(_burstLossStartKey,   _burstLossStartPercent);
+    settings.setValue(_burstLossLengthKey,  _burstLossLength);
+    settings.setValue(_duplicateKey,        _duplicatePercent);
+    settings.setValue(_reorderKey,          _reorderPercent);
+    settings.setValue(_seedKey,             _seed);
+    settings.endGroup();
+
+    if (_innerConfig) {
+        _innerConfig->saveSettings(settings, root + "/" + _innerGroupKey);
+    }
+}
+
+void ImpairedLinkConfiguration::loadSettings(QSettings& settings, const QString& root)
+{
+    settings.beginGroup(root);
+    int innerType =             settings.value(_innerTypeKey, (int)LinkConfiguration::TypeMock).toInt();
+    _latencyMsecs =             settings.value(_latencyKey, 0).toInt();
+    _jitterMsecs =              settings.value(_jitterKey, 0).toInt();
+    _bandwidthBitsPerSecond =   settings.value(_bandwidthKey, 0).toInt();
+    _lossPercent =              settings.value(_lossKey, 0.0).toDouble();
+    _burstLossStartPercent =    settings.value(_burstLossStartKey, 0.0).toDouble();
+    _burstLossLength =          settings.value(_burstLossLengthKey, 1).toInt();
+    _duplicatePercent =         settings.value(_duplicateKey, 0.0).toDouble();
+    _reorderPercent =           settings.value(_reorderKey, 0.0).toDouble();
+    _seed =                     settings.value(_seedKey, 1).toUInt();
+    settings.endGroup();
+
+    if (innerType == LinkConfiguration::TypeImpaired) {
+        qWarning() << "ImpairedLinkConfiguration: nested impaired links are not supported" << name();
+        innerType = LinkConfiguration::TypeMock;
+    }
+    setInnerConfiguration(LinkConfiguration::createSettings(innerType, name()));
+    if (_innerConfig) {
+        _innerConfig->loadSettings(settings, root + "/" + _innerGroupKey);
+    }
+}
+
+void ImpairedLinkConfiguration::updateSettings(void)
+{
+    // Impairment profile is read when the link is created, changes take effect on the next connect
+}
+
+ImpairedLink::ImpairedLink(ImpairedLinkConfiguration* config, LinkInterface* innerLink)
+    : _config(config)
+    , _innerLink(innerLink)
+    , _connected(false)
+    , _rngState(1)
+{
+    Q_ASSERT(_config);
+    Q_ASSERT(_innerLink);
+
+    memset(&_uplink, 0, sizeof(_uplink));
+    memset(&_downlink, 0, sizeof(_downlink));
+
+    // xorshift has a single fixed point at zero
+    if (_config->seed() != 0) {
+        _rngState = _config->seed();
+    }
+
+    _deliveryTimer.setSingleShot(true);
+    _deliveryTimer.moveToThread(this);
+    _clock.start();
+
+    QObject::connect(&_deliveryTimer, &QTimer::timeout, this, &ImpairedLink::_deliverPackets);
+    QObject::connect(this, &ImpairedLink::_writeBytesOnThread, this, &ImpairedLink::_uplinkBytes);
+    QObject::connect(_innerLink, &LinkInterface::bytesReceived, this, &ImpairedLink::_downlinkBytes);
+    QObject::connect(_innerLink, &LinkInterface::communicationError, this, &LinkInterface::communicationError);
+
+    moveToThread(this);
+}
+
+ImpairedLink::~ImpairedLink()
+{
+    _disconnect();
+    delete _innerLink;
+}
+
+qint64 ImpairedLink::getConnectionSpeed(void) const
+{
+    if (_config->bandwidthBitsPerSecond() > 0) {
+        return _config->bandwidthBitsPerSecond();
+    }
+    return _innerLink->getConnectionSpeed();
+}
+
+bool ImpairedLink::_connect(void)
+{
+    if (!_connected) {
+        // The inner link parses on the same channel as we do since it is never added to LinkManager
+        if (!_innerLink->_mavlinkChannelSet) {
+            _innerLink->_setMavlinkChannel(getMavlinkChannel());
+        }
+        if (!_innerLink->_connect()) {
+            return false;
+        }
+
+        _connected = true;
+        start();
+        emit connected();
+    }
+
+    return true;
+}
+
+bool ImpairedLink::_disconnect(void)
+{
+    if (_connected) {
+        _connected = false;
+        _innerLink->_disconnect();
+        quit();
+        wait();
+
+        _logStatistics("uplink", _uplink.stats);
+        _logStatistics("downlink", _downlink.stats);
+
+        emit disconnected();
+    }
+
+    return true;
+}
+
+void ImpairedLink::run(void)
+{
+    exec();
+
+    // Anything still in flight is lost with the link
+    _deliveryTimer.stop();
+    _packetQueue.clear();
+}
+
+/// @brief Called when QGC wants to write bytes to the vehicle
+void ImpairedLink::writeBytes(const char* bytes, qint64 cBytes)
+{
+    _logOutputDataRate(cBytes, QDateTime::currentMSecsSinceEpoch());
+
+    // Package up the data so we can signal it over to the right thread
+    emit _writeBytesOnThread(QByteArray(bytes, cBytes));
+}
+
+void ImpairedLink::_uplinkBytes(const QByteArray bytes)
+{
+    _impairPacket(true, bytes);
+}
+
+void ImpairedLink::_downlinkBytes(LinkInterface* link, QByteArray bytes)
+{
+    Q_UNUSED(link);
+    _impairPacket(false, bytes);
+}
+
+/// Decides the fate of a single packet and queues it for delivery accordingly
+void ImpairedLink::_impairPacket(bool uplink, const QByteArray& bytes)
+{
+    Direction_t& direction = uplink ? _uplink : _downlink;
+
+    // Only mavlink packets are impaired. Anything else (such as the nsh start sequence sent on connect) must arrive
+    // intact and in order, so it still sees latency and bandwidth but is never lost, duplicated or re-ordered.
+    bool impair = bytes.count() > 0 && (uint8_t)bytes[0] == MAVLINK_STX;
+
+    Fate_t fate = _packetFate(direction, _clock.elapsed(), bytes.count(), impair);
+
+    _statsMutex.lock();
+    direction.stats.packets++;
+    if (fate.lost) {
+        direction.stats.dropped++;
+    }
+    if (fate.reordered) {
+        direction.stats.reordered++;
+    }
+    if (fate.duplicated) {
+        direction.stats.duplicated++;
+    }
+    _statsMutex.unlock();
+
+    if (fate.lost) {
+        return;
+    }
+
+    _queuePacket(fate.deliveryMsecs, uplink, bytes);
+    if (fate.duplicated) {
+        _queuePacket(fate.deliveryMsecs, uplink, bytes);
+    }
+}
+
+/// Runs a single packet through the link profile. All random decisions are made here, so a given seed and
+/// sequence of packets always produce the same fates.
+///     @param direction Direction the packet travels in, updated with the new link state
+///     @param nowMsecs Time the packet was handed to the link
+///     @param byteCount Size of the packet
+///     @param impair false: Packet only sees latency and bandwidth
+ImpairedLink::Fate_t ImpairedLink::_packetFate(Direction_t& direction, qint64 nowMsecs, int byteCount, bool impair)
+{
+    Fate_t fate;
+
+    fate.lost = false;
+    fate.duplicated = false;
+    fate.reordered = false;
+    fate.deliveryMsecs = 0;
+
+    if (impair && _packetLost(direction)) {
+        fate.lost = true;
+        return fate;
+    }
+
+    // The radio sends a single packet at a time, so a packet can't start until the previous one is out
+    qint64 transmitStart = qMax(nowMsecs, direction.linkFreeMsecs);
+    qint64 transmitMsecs = 0;
+    if (_config->bandwidthBitsPerSecond() > 0) {
+        transmitMsecs = ((qint64)byteCount * 8 * 1000) / _config->bandwidthBitsPerSecond();
+    }
+    direction.linkFreeMsecs = transmitStart + transmitMsecs;
+
+    fate.deliveryMsecs = direction.linkFreeMsecs + _config->latencyMsecs();
+    if (_config->jitterMsecs() > 0) {
+        fate.deliveryMsecs += _random() % (_config->jitterMsecs() + 1);
+    }
+
+    if (impair && _config->reorderPercent() > 0.0 && _randomPercent() < _config->reorderPercent()) {
+        // Hold the packet back long enough for packets sent after it to overtake it
+        fate.deliveryMsecs += _config->latencyMsecs() + _config->jitterMsecs() + 1;
+        fate.reordered = true;
+    } else {
+        // Jitter alone does not re-order packets
+        fate.deliveryMsecs = qMax(fate.deliveryMsecs, direction.lastDeliveryMsecs);
+        direction.lastDeliveryMsecs = fate.deliveryMsecs;
+    }
+
+    fate.duplicated = impair && _config->duplicatePercent() > 0.0 && _randomPercent() < _config->duplicatePercent();
+
+    return fate;
+}
+
+/// Gilbert-Elliott style loss model: independent random loss plus bursts which start with a fixed probability and
+/// end with probability 1 / burstLossLength per packet.
+bool ImpairedLink::_packetLost(Direction_t& direction)
+{
+    if (direction.inBurstLoss) {
+        int burstLength = qMax(_config->burstLossLength(), 1);
+        if (_randomPercent() < 100.0 / burstLength) {
+            direction.inBurstLoss = false;
+        } else {
+            return true;
+        }
+    } else if (_config->burstLossStartPercent() > 0.0 && _randomPercent() < _config->burstLossStartPercent()) {
+        direction.inBurstLoss = true;
+        return true;
+    }
+
+    return _config->lossPercent() > 0.0 && _randomPercent() < _config->lossPercent();
+}
+
+void ImpairedLink::_queuePacket(qint64 deliveryMsecs, bool uplink, const QByteArray& bytes)
+{
+    Packet_t packet;
+
+    packet.deliveryMsecs = deliveryMsecs;
+    packet.uplink = uplink;
+    packet.bytes = bytes;
+
+    // Insert after all packets due at the same time to keep ordering stable
+    int index = _packetQueue.count();
+    while (index > 0 && _packetQueue[index - 1].deliveryMsecs > deliveryMsecs) {
+        index--;
+    }
+    _packetQueue.insert(index, packet);
+
+    if (index == 0) {
+        _deliveryTimer.start(qMax(deliveryMsecs - _clock.elapsed(), (qint64)0));
+    }
+}
+
+void ImpairedLink::_deliverPackets(void)
+{
+    qint64 now = _clock.elapsed();
+
+    while (_packetQueue.count() && _packetQueue[0].deliveryMsecs <= now) {
+        Packet_t packet = _packetQueue.takeFirst();
+
+        _statsMutex.lock();
+        (packet.uplink ? _uplink : _downlink).stats.bytes += packet.bytes.count();
+        _statsMutex.unlock();
+
+        if (packet.uplink) {
+            _innerLink->writeBytes(packet.bytes.constData(), packet.bytes.count());
+        } else {
+            _logInputDataRate(packet.bytes.count(), QDateTime::currentMSecsSinceEpoch());
+            emit bytesReceived(this, packet.bytes);
+        }
+    }
+
+    if (_packetQueue.count()) {
+        _deliveryTimer.start(qMax(_packetQueue[0].deliveryMsecs - now, (qint64)0));
+    }
+}
+
+/// xorshift32 generator, gives the same sequence for a given seed on all platforms
+quint32 ImpairedLink::_random(void)
+{
+    _rngState ^= _rngState << 13;
+    _rngState ^= _rngState >> 17;
+    _rngState ^= _rngState << 5;
+    return _rngState;
+}
+
+/// @return Random value in the range [0, 100)
+double ImpairedLink::_randomPercent(void)
+{
+    return (_random() / 4294967296.0) * 100.0;
+}
+
+ImpairedLink::Statistics_t ImpairedLink::uplinkStatistics(void)
+{
+    QMutexLocker locker(&_statsMutex);
+    return _uplink.stats;
+}
+
+ImpairedLink::Statistics_t ImpairedLink::downlinkStatistics(void)
+{
+    QMutexLocker locker(&_statsMutex);
+    return _downlink.stats;
+}
+
+void ImpairedLink::_logStatistics(const char* directionName, const Statistics_t& stats)
+{
+    qCDebug(ImpairedLinkLog) << getName() << directionName
+                             << "packets:" << stats.packets
+                             << "dropped:" << stats.dropped
+                             << "duplicated:" << stats.duplicated
+                             << "reordered:" << stats.reordered
+                             << "bytes:" << stats.bytes;
+}
@@ -0,0 +1,236 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef ImpairedLink_H
+#define ImpairedLink_H
+
+#include "LinkInterface.h"
+#include "LinkConfiguration.h"
+#include "QGCLoggingCategory.h"
+
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+
+Q_DECLARE_LOGGING_CATEGORY(ImpairedLinkLog)
+
+/// @file
+///     @brief Link which wraps an inner link and emulates a bad radio: latency, jitter, limited bandwidth,
+///             random and burst loss, duplication and re-ordering. Used for benchmarking the protocol
+///             implementations (parameters, missions, ftp) against reproducible link profiles.
+
+class ImpairedLinkConfiguration : public LinkConfiguration
+{
+public:
+    ImpairedLinkConfiguration(const QString& name);
+    ImpairedLinkConfiguration(ImpairedLinkConfiguration* copy);
+    ~ImpairedLinkConfiguration();
+
+    /// Configuration for the link which is wrapped. Defaults to a MockLink configuration.
+    LinkConfiguration* innerConfiguration(void) { return _innerConfig; }
+
+    /// Sets the configuration for the wrapped link. Takes ownership of config.
+    void setInnerConfiguration(LinkConfiguration* config);
+
+    /// Fixed one way delay in msecs applied to each packet
+    int latencyMsecs(void) { return _latencyMsecs; }
+    void setLatencyMsecs(int latencyMsecs) { _latencyMsecs = latencyMsecs; }
+
+    /// Random additional delay in msecs, uniformly distributed between 0 and jitterMsecs
+    int jitterMsecs(void) { return _jitterMsecs; }
+    void setJitterMsecs(int jitterMsecs) { _jitterMsecs = jitterMsecs; }
+
+    /// Bandwidth cap for each direction in bits per second, 0 for unlimited
+    int bandwidthBitsPerSecond(void) { return _bandwidthBitsPerSecond; }
+    void setBandwidthBitsPerSecond(int bitsPerSecond) { _bandwidthBitsPerSecond = bitsPerSecond; }
+
+    /// Percent chance of an individual packet being lost
+    double lossPercent(void) { return _lossPercent; }
+    void setLossPercent(double percent) { _lossPercent = percent; }
+
+    /// Percent chance for each packet to start a burst loss
+    double burstLossStartPercent(void) { return _burstLossStartPercent; }
+    void setBurstLossStartPercent(double percent) { _burstLossStartPercent = percent; }
+
+    /// Mean number of packets lost in a burst
+    int burstLossLength(void) { return _burstLossLength; }
+    void setBurstLossLength(int length) { _burstLossLength = length; }
+
+    /// Percent chance of a packet being delivered twice
+    double duplicatePercent(void) { return _duplicatePercent; }
+    void setDuplicatePercent(double percent) { _duplicatePercent = percent; }
+
+    /// Percent chance of a packet being delivered after packets which were sent after it
+    double reorderPercent(void) { return _reorderPercent; }
+    void setReorderPercent(double percent) { _reorderPercent = percent; }
+
+    /// Seed for the random number generator. The same seed and traffic produce the same impairments.
+    quint32 seed(void) { return _seed; }
+    void setSeed(quint32 seed) { _seed = seed; }
+
+    // Virtuals from LinkConfiguration
+    virtual int  type() { return LinkConfiguration::TypeImpaired; }
+    virtual void copyFrom(LinkConfiguration* source);
+    virtual void loadSettings(QSettings& settings, const QString& root);
+    virtual void saveSettings(QSettings& settings, const QString& root);
+    virtual void updateSettings();
+
+private:
+    void _copyValues(ImpairedLinkConfiguration* source);
+
+    LinkConfiguration*  _innerConfig;
+    int                 _latencyMsecs;
+    int                 _jitterMsecs;
+    int                 _bandwidthBitsPerSecond;
+    double              _lossPercent;
+    double              _burstLossStartPercent;
+    int                 _burstLossLength;
+    double              _duplicatePercent;
+    double              _reorderPercent;
+    quint32             _seed;
+
+    static const char* _innerTypeKey;
+    static const char* _innerGroupKey;
+    static const char* _latencyKey;
+    static const char* _jitterKey;
+    static const char* _bandwidthKey;
+    static const char* _lossKey;
+    static const char* _burstLossStartKey;
+    static const char* _burstLossLengthKey;
+    static const char* _duplicateKey;
+    static const char* _reorderKey;
+    static const char* _seedKey;
+};
+
+class ImpairedLink : public LinkInterface
+{
+    Q_OBJECT
+
+    friend class LinkManager;
+    friend class ImpairedLinkTest; ///< Drives the link profile directly
+
+public:
+    /// Statistics for a single direction of the link
+    typedef struct {
+        quint32 packets;        ///< Packets handed to the link
+        quint32 dropped;        ///< Packets lost to random or burst loss
+        quint32 duplicated;     ///< Packets delivered twice
+        quint32 reordered;      ///< Packets delivered out of order
+        quint64 bytes;          ///< Bytes delivered
+    } Statistics_t;
+
+    /// @param config Impairment profile to apply
+    /// @param innerLink Link to wrap, ImpairedLink takes ownership
+    ImpairedLink(ImpairedLinkConfiguration* config, LinkInterface* innerLink);
+    ~ImpairedLink();
+
+    LinkInterface* innerLink(void) { return _innerLink; }
+
+    /// Statistics for packets travelling from QGC to the vehicle
+    Statistics_t uplinkStatistics(void);
+
+    /// Statistics for packets travelling from the vehicle to QGC
+    Statistics_t downlinkStatistics(void);
+
+    // Virtuals from LinkInterface
+    virtual QString getName(void) const { return _config->name(); }
+    virtual void requestReset(void) { }
+    virtual bool isConnected(void) const { return _connected; }
+    virtual qint64 getConnectionSpeed(void) const;
+    virtual LinkConfiguration* getLinkConfiguration(void) { return _config; }
+
+    // These are left unimplemented in order to cause linker errors which indicate incorrect usage of
+    // connect/disconnect on link directly. All connect/disconnect calls should be made through LinkManager.
+    bool connect(void);
+    bool disconnect(void);
+
+public slots:
+    virtual void writeBytes(const char *bytes, qint64 cBytes);
+
+signals:
+    /// @brief Used internally to move data to the thread.
+    void _writeBytesOnThread(const QByteArray bytes);
+
+protected slots:
+    // FIXME: This should not be part of LinkInterface. It is an internal link implementation detail.
+    virtual void readBytes(void) { }
+
+private slots:
+    void _uplinkBytes(const QByteArray bytes);
+    void _downlinkBytes(LinkInterface* link, QByteArray bytes);
+    void _deliverPackets(void);
+
+private:
+    /// State for a single direction of the link
+    typedef struct {
+        qint64          linkFreeMsecs;      ///< Time at which the emulated radio has finished sending the previous packet
+        qint64          lastDeliveryMsecs;  ///< Delivery time of the last in order packet
+        bool            inBurstLoss;        ///< true: currently within a burst loss
+        Statistics_t    stats;
+    } Direction_t;
+
+    typedef struct {
+        qint64      deliveryMsecs;
+        bool        uplink;
+        QByteArray  bytes;
+    } Packet_t;
+
+    /// What the link profile does to a single packet
+    typedef struct {
+        bool    lost;
+        bool    duplicated;
+        bool    reordered;
+        qint64  deliveryMsecs;      ///< Only valid if the packet is not lost
+    } Fate_t;
+
+    // From LinkInterface
+    virtual bool _connect(void);
+    virtual bool _disconnect(void);
+
+    // QThread override
+    virtual void run(void);
+
+    void _impairPacket(bool uplink, const QByteArray& bytes);
+    Fate_t _packetFate(Direction_t& direction, qint64 nowMsecs, int byteCount, bool impair);
+    bool _packetLost(Direction_t& direction);
+    void _queuePacket(qint64 deliveryMsecs, bool uplink, const QByteArray& bytes);
+    quint32 _random(void);
+    double _randomPercent(void);
+    void _logStatistics(const char* directionName, const Statistics_t& stats);
+
+    ImpairedLinkConfiguration*  _config;
+    LinkInterface*              _innerLink;
+    bool                        _connected;
+
+    QTimer          _deliveryTimer;     ///< Signals when the next queued packet is due
+    QElapsedTimer   _clock;             ///< Time base for all delivery times
+    QList<Packet_t> _packetQueue;       ///< Packets waiting for delivery sorted by delivery time
+    quint32         _rngState;
+
+    QMutex          _statsMutex;        ///< Protects the stats in _uplink/_downlink for access from other threads
+    Direction_t     _uplink;
+    Direction_t     _downlink;
+};
+
+#endif
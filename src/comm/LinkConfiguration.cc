@@ -37,6 +37,7 @@ This file is part of the QGROUNDCONTROL project
 
 #ifdef QT_DEBUG
 #include "MockLink.h"
+#include "ImpairedLink.h"
 #endif
 
 #define LINK_SETTING_ROOT "LinkConfigurations"
@@ -103,6 +104,9 @@ LinkConfiguration* LinkConfiguration::createSettings(int type, const QString& na
         case LinkConfiguration::TypeMock:
             config = new MockConfiguration(name);
             break;
+        case LinkConfiguration::TypeImpaired:
+            config = new ImpairedLinkConfiguration(name);
+            break;
 #endif
     }
     return config;
@@ -134,6 +138,9 @@ LinkConfiguration* LinkConfiguration::duplicateSettings(LinkConfiguration* sourc
         case TypeMock:
             dupe = new MockConfiguration(dynamic_cast<MockConfiguration*>(source));
             break;
+        case TypeImpaired:
+            dupe = new ImpairedLinkConfiguration(dynamic_cast<ImpairedLinkConfiguration*>(source));
+            break;
 #endif
     }
     return dupe;
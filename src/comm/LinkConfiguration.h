@@ -52,6 +52,7 @@ public:
 #endif
         TypeMock,       ///< Mock Link for Unitesting
         TypeLogReplay,
+        TypeImpaired,   ///< Network impairment emulator wrapping another link
         TypeLast        // Last type value (type >= TypeLast == invalid)
     };
 
@@ -56,6 +56,9 @@ class LinkInterface : public QThread
     // Only LinkManager is allowed to create/delete or _connect/_disconnect a link
     friend class LinkManager;
 
+    // ImpairedLink manages the lifetime of the link it wraps
+    friend class ImpairedLink;
+
 public:
     /**
      * @brief Get link configuration (if used)
@@ -81,6 +81,17 @@ LinkManager::~LinkManager()
 }
 
 LinkInterface* LinkManager::createConnectedLink(LinkConfiguration* config)
+{
+    LinkInterface* pLink = _createLink(config);
+    if(pLink) {
+        _addLink(pLink);
+        connectLink(pLink);
+    }
+    return pLink;
+}
+
+/// Creates the link for the specified configuration without adding it to the link list
+LinkInterface* LinkManager::_createLink(LinkConfiguration* config)
 {
     Q_ASSERT(config);
     LinkInterface* pLink = NULL;
@@ -103,12 +114,16 @@ LinkInterface* LinkManager::createConnectedLink(LinkConfiguration* config)
         case LinkConfiguration::TypeMock:
             pLink = new MockLink(dynamic_cast<MockConfiguration*>(config));
             break;
+        case LinkConfiguration::TypeImpaired: {
+            ImpairedLinkConfiguration* impairedConfig = dynamic_cast<ImpairedLinkConfiguration*>(config);
+            LinkInterface* innerLink = impairedConfig->innerConfiguration() ? _createLink(impairedConfig->innerConfiguration()) : NULL;
+            if (innerLink) {
+                pLink = new ImpairedLink(impairedConfig, innerLink);
+            }
+        }
+            break;
 #endif
     }
-    if(pLink) {
-        _addLink(pLink);
-        connectLink(pLink);
-    }
     return pLink;
 }
 
@@ -406,6 +421,10 @@ void LinkManager::loadLinkConfigurationList()
                                     pLink = (LinkConfiguration*)new MockConfiguration(name);
                                     pLink->setPreferred(false);
                                     break;
+                                case LinkConfiguration::TypeImpaired:
+                                    pLink = (LinkConfiguration*)new ImpairedLinkConfiguration(name);
+                                    pLink->setPreferred(false);
+                                    break;
 #endif
                             }
                             if(pLink) {
@@ -441,6 +460,18 @@ void LinkManager::loadLinkConfigurationList()
     MockConfiguration* pMock = new MockConfiguration("Mock Link");
     pMock->setDynamic(true);
     addLinkConfiguration(pMock);
+
+    // Swarm of vehicles for load testing the receive path and the ui with many vehicles
+    MockConfiguration* pSwarm = new MockConfiguration("Mock Swarm");
+    pSwarm->setVehicleCount(100);
+    pSwarm->setFirstVehicleId(1);
+    pSwarm->setStreamRate(MAVLINK_MSG_ID_ATTITUDE, 10);
+    pSwarm->setStreamRate(MAVLINK_MSG_ID_GLOBAL_POSITION_INT, 5);
+    pSwarm->setStreamRate(MAVLINK_MSG_ID_GPS_RAW_INT, 2);
+    pSwarm->setStreamRate(MAVLINK_MSG_ID_VFR_HUD, 4);
+    pSwarm->setStreamRate(MAVLINK_MSG_ID_SYS_STATUS, 1);
+    pSwarm->setDynamic(true);
+    addLinkConfiguration(pSwarm);
     linksChanged = true;
 #endif
 
@@ -45,6 +45,7 @@ This file is part of the PIXHAWK project
 
 #ifdef QT_DEBUG
 #include "MockLink.h"
+#include "ImpairedLink.h"
 #endif
 
 #include "ProtocolInterface.h"
@@ -163,6 +164,7 @@ private:
     virtual void _shutdown(void);
 
     bool _connectionsSuspendedMsg(void);
+    LinkInterface* _createLink(LinkConfiguration* config);
     void _updateConfigurationList(void);
 #ifndef __ios__
     SerialConfiguration* _findSerialConfiguration(const QString& portName);
@@ -27,6 +27,7 @@
 #include "QGC.h"
 #include "QGCApplication.h"
 #include "QGCLoggingCategory.h"
+#include "QGCTrace.h"
 #include "MultiVehicleManager.h"
 
 Q_DECLARE_METATYPE(mavlink_message_t)
@@ -229,6 +230,9 @@ void MAVLinkProtocol::receiveBytes(LinkInterface* link, QByteArray b)
         return;
     }
     
+    QGC_TRACE_SCOPE("mavlink", "receiveBytes");
+    QGC_TRACE_COUNTER("mavlink", "receiveBytes.count", b.size());
+    
 //    receiveMutex.lock();
     mavlink_message_t message;
     mavlink_status_t status;
@@ -394,7 +398,10 @@ void MAVLinkProtocol::receiveBytes(LinkInterface* link, QByteArray b)
             // The packet is emitted as a whole, as it is only 255 - 261 bytes short
             // kind of inefficient, but no issue for a groundstation pc.
             // It buys as reentrancy for the whole code over all threads
-            emit messageReceived(link, message);
+            {
+                QGC_TRACE_SCOPE("mavlink", "messageReceived");
+                emit messageReceived(link, message);
+            }
 
             // Multiplex message if enabled
             if (m_multiplexingEnabled)
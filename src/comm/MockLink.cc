@@ -27,8 +27,10 @@
 #include <QTimer>
 #include <QDebug>
 #include <QFile>
+#include <QStringList>
 
 #include <string.h>
+#include <math.h>
 
 QGC_LOGGING_CATEGORY(MockLinkLog, "MockLinkLog")
 QGC_LOGGING_CATEGORY(MockLinkVerboseLog, "MockLinkVerboseLog")
@@ -67,6 +69,84 @@ union px4_custom_mode {
     float data_float;
 };
 
+// Simulated vehicles fly around the PX4 SITL default home position
+const double MockLink::_homeLatitude =  47.3977419;
+const double MockLink::_homeLongitude = 8.5455938;
+const double MockLink::_homeAltitude =  488.0;
+
+const char* MockConfiguration::_vehicleCountKey =   "vehicleCount";
+const char* MockConfiguration::_firstVehicleIdKey = "firstVehicleId";
+const char* MockConfiguration::_streamRatesKey =    "streamRates";
+
+MockConfiguration::MockConfiguration(const QString& name)
+    : LinkConfiguration(name)
+    , _vehicleCount(1)
+    , _firstVehicleId(128)
+{
+
+}
+
+MockConfiguration::MockConfiguration(MockConfiguration* source)
+    : LinkConfiguration(source)
+{
+    _vehicleCount =     source->vehicleCount();
+    _firstVehicleId =   source->firstVehicleId();
+    _streamRates =      source->streamRates();
+}
+
+void MockConfiguration::setStreamRate(int msgId, int rateHz)
+{
+    if (rateHz > 0) {
+        _streamRates[msgId] = rateHz;
+    } else {
+        _streamRates.remove(msgId);
+    }
+}
+
+void MockConfiguration::copyFrom(LinkConfiguration* source)
+{
+    LinkConfiguration::copyFrom(source);
+    MockConfiguration* mockSource = dynamic_cast<MockConfiguration*>(source);
+    Q_ASSERT(mockSource != NULL);
+    _vehicleCount =     mockSource->vehicleCount();
+    _firstVehicleId =   mockSource->firstVehicleId();
+    _streamRates =      mockSource->streamRates();
+}
+
+/// Stream rates are saved as a comma separated list of msgId:rateHz pairs
+void MockConfiguration::saveSettings(QSettings& settings, const QString& root)
+{
+    QStringList streamRates;
+    foreach (int msgId, _streamRates.keys()) {
+        streamRates << QString("%1:%2").arg(msgId).arg(_streamRates[msgId]);
+    }
+
+    settings.beginGroup(root);
+    settings.setValue(_vehicleCountKey, _vehicleCount);
+    settings.setValue(_firstVehicleIdKey, _firstVehicleId);
+    settings.setValue(_streamRatesKey, streamRates.join(","));
+    settings.endGroup();
+}
+
+void MockConfiguration::loadSettings(QSettings& settings, const QString& root)
+{
+    settings.beginGroup(root);
+    _vehicleCount = settings.value(_vehicleCountKey, 1).toInt();
+    _firstVehicleId = settings.value(_firstVehicleIdKey, 128).toInt();
+    QString streamRates = settings.value(_streamRatesKey, "").toString();
+    settings.endGroup();
+
+    _streamRates.clear();
+    foreach (const QString& streamRate, streamRates.split(",", QString::SkipEmptyParts)) {
+        QStringList pair = streamRate.split(":");
+        if (pair.count() == 2) {
+            setStreamRate(pair[0].toInt(), pair[1].toInt());
+        } else {
+            qWarning() << "MockConfiguration: invalid stream rate" << streamRate;
+        }
+    }
+}
+
 MockLink::MockLink(MockConfiguration* config)
     : _missionItemHandler(this)
     , _name("MockLink")
@@ -75,17 +155,32 @@ MockLink::MockLink(MockConfiguration* config)
     , _vehicleComponentId(200)  // FIXME: magic number?
     , _inNSH(false)
     , _mavlinkStarted(false)
-    , _mavBaseMode(MAV_MODE_FLAG_MANUAL_INPUT_ENABLED | MAV_MODE_FLAG_CUSTOM_MODE_ENABLED)
-    , _mavState(MAV_STATE_STANDBY)
     , _autopilotType(MAV_AUTOPILOT_PX4)
     , _fileServer(NULL)
+    , _commandAckDropCount(0)
+    , _commandAckResult(MAV_RESULT_ACCEPTED)
+    , _paramSetAckDropCount(0)
 {
     _config = config;
-    union px4_custom_mode   px4_cm;
 
-    px4_cm.data = 0;
-    px4_cm.main_mode = PX4_CUSTOM_MAIN_MODE_MANUAL;
-    _mavCustomMode = px4_cm.data;
+    int vehicleCount = 1;
+    if (_config) {
+        Q_ASSERT(_config->firstVehicleId() > 0 && _config->firstVehicleId() + _config->vehicleCount() - 1 < 256);
+        _vehicleSystemId = _config->firstVehicleId();
+        vehicleCount = qMax(_config->vehicleCount(), 1);
+
+        foreach (int msgId, _config->streamRates().keys()) {
+            TelemetryStream_t stream;
+
+            stream.msgId = msgId;
+            stream.rateHz = _config->streamRates()[msgId];
+            stream.sentCount = 0;
+            _streams.append(stream);
+        }
+    }
+    for (int i=0; i<vehicleCount; i++) {
+        _addSimulatedVehicle(_vehicleSystemId + i, i);
+    }
 
     _fileServer = new MockLinkFileServer(_vehicleSystemId, _vehicleComponentId, this);
     Q_CHECK_PTR(_fileServer);
@@ -96,6 +191,42 @@ MockLink::MockLink(MockConfiguration* config)
     QObject::connect(this, &MockLink::_incomingBytes, this, &MockLink::_handleIncomingBytes);
 }
 
+/// Adds a vehicle to the simulation. Each vehicle flies its own circle, spread out on a grid around home.
+void MockLink::_addSimulatedVehicle(uint8_t systemId, int index)
+{
+    SimulatedVehicle_t      vehicle;
+    union px4_custom_mode   px4_cm;
+
+    px4_cm.data = 0;
+    px4_cm.main_mode = PX4_CUSTOM_MAIN_MODE_MANUAL;
+
+    const double metersPerDegree = 111320.0;
+    const double gridSpacing = 300.0;
+
+    vehicle.systemId =          systemId;
+    vehicle.baseMode =          MAV_MODE_FLAG_MANUAL_INPUT_ENABLED | MAV_MODE_FLAG_CUSTOM_MODE_ENABLED;
+    vehicle.customMode =        px4_cm.data;
+    vehicle.state =             MAV_STATE_STANDBY;
+    vehicle.trackCenterLat =    _homeLatitude + ((index / 10) * gridSpacing) / metersPerDegree;
+    vehicle.trackCenterLon =    _homeLongitude + ((index % 10) * gridSpacing) / (metersPerDegree * cos(_homeLatitude * M_PI / 180.0));
+    vehicle.trackRadius =       50.0 + (index % 5) * 20.0;
+    vehicle.trackSpeed =        5.0 + (index % 7);
+    vehicle.trackPhase =        index * 0.7;
+    vehicle.trackAltitude =     20.0 + (index % 10) * 5.0;
+
+    _vehicles.append(vehicle);
+}
+
+MockLink::SimulatedVehicle_t* MockLink::_vehicleForId(int systemId)
+{
+    int index = systemId - _vehicleSystemId;
+
+    if (index >= 0 && index < _vehicles.count()) {
+        return &_vehicles[index];
+    }
+    return NULL;
+}
+
 MockLink::~MockLink(void)
 {
     qDebug() << "MockLink destructor";
@@ -135,20 +266,29 @@ void MockLink::run(void)
     QTimer  _timer1HzTasks;
     QTimer  _timer10HzTasks;
     QTimer  _timer50HzTasks;
+    QTimer  _timerStreamTasks;
 
     QObject::connect(&_timer1HzTasks, &QTimer::timeout, this, &MockLink::_run1HzTasks);
     QObject::connect(&_timer10HzTasks, &QTimer::timeout, this, &MockLink::_run10HzTasks);
     QObject::connect(&_timer50HzTasks, &QTimer::timeout, this, &MockLink::_run50HzTasks);
+    QObject::connect(&_timerStreamTasks, &QTimer::timeout, this, &MockLink::_runStreamTasks);
 
     _timer1HzTasks.start(1000);
     _timer10HzTasks.start(100);
     _timer50HzTasks.start(20);
 
+    _streamClock.start();
+    if (_streams.count()) {
+        _timerStreamTasks.setTimerType(Qt::PreciseTimer);
+        _timerStreamTasks.start(_streamTickMsecs);
+    }
+
     exec();
 
     QObject::disconnect(&_timer1HzTasks, &QTimer::timeout, this, &MockLink::_run1HzTasks);
     QObject::disconnect(&_timer10HzTasks, &QTimer::timeout, this, &MockLink::_run10HzTasks);
     QObject::disconnect(&_timer50HzTasks, &QTimer::timeout, this, &MockLink::_run50HzTasks);
+    QObject::disconnect(&_timerStreamTasks, &QTimer::timeout, this, &MockLink::_runStreamTasks);
     
     _missionItemHandler.shutdown();
 }
@@ -172,6 +312,164 @@ void MockLink::_run50HzTasks(void)
     }
 }
 
+/// Sends all telemetry stream messages which have come due since the last tick. All messages for the tick are
+/// sent as a single block of bytes, much like a real link read would return them.
+void MockLink::_runStreamTasks(void)
+{
+    if (!_mavlinkStarted || !_connected) {
+        return;
+    }
+
+    qint64 msecs = _streamClock.elapsed();
+    QByteArray bytes;
+
+    for (int i=0; i<_streams.count(); i++) {
+        TelemetryStream_t& stream = _streams[i];
+        quint64 dueCount = ((quint64)msecs * stream.rateHz) / 1000;
+
+        // Don't try to catch up on more than a second worth of messages, for example after mavlink starts
+        if (dueCount > stream.sentCount + stream.rateHz) {
+            stream.sentCount = dueCount - stream.rateHz;
+        }
+
+        while (stream.sentCount < dueCount) {
+            for (int j=0; j<_vehicles.count(); j++) {
+                mavlink_message_t   msg;
+                uint8_t             buffer[MAVLINK_MAX_PACKET_LEN];
+
+                if (_packStreamMessage(stream.msgId, _vehicles[j], msecs, &msg)) {
+                    int cBuffer = mavlink_msg_to_send_buffer(buffer, &msg);
+                    bytes.append((char*)buffer, cBuffer);
+                }
+            }
+            stream.sentCount++;
+        }
+    }
+
+    if (bytes.count()) {
+        emit bytesReceived(this, bytes);
+    }
+}
+
+/// Packs a telemetry message for the vehicle's position along its track at the specified time
+///     @return false: message id not supported as a telemetry stream
+bool MockLink::_packStreamMessage(int msgId, const SimulatedVehicle_t& vehicle, qint64 msecs, mavlink_message_t* msg)
+{
+    const double metersPerDegree = 111320.0;
+    const double bankAngle = 0.2;
+
+    double seconds =    msecs / 1000.0;
+    double angle =      vehicle.trackPhase + (vehicle.trackSpeed * seconds) / vehicle.trackRadius;
+    double northMeters = vehicle.trackRadius * cos(angle);
+    double eastMeters = vehicle.trackRadius * sin(angle);
+    double lat =        vehicle.trackCenterLat + northMeters / metersPerDegree;
+    double lon =        vehicle.trackCenterLon + eastMeters / (metersPerDegree * cos(vehicle.trackCenterLat * M_PI / 180.0));
+    double altRel =     vehicle.trackAltitude;
+    double altAMSL =    _homeAltitude + altRel;
+    double heading =    fmod(angle + M_PI_2, 2.0 * M_PI);   // Flying counter-clockwise when viewed from above
+    double vNorth =     -vehicle.trackSpeed * sin(angle);
+    double vEast =      vehicle.trackSpeed * cos(angle);
+    double yawRate =    vehicle.trackSpeed / vehicle.trackRadius;
+    double headingDeg = heading * 180.0 / M_PI;
+
+    switch (msgId) {
+        case MAVLINK_MSG_ID_ATTITUDE:
+            mavlink_msg_attitude_pack(vehicle.systemId,
+                                      _vehicleComponentId,
+                                      msg,
+                                      (uint32_t)msecs,      // time since boot
+                                      bankAngle,            // roll
+                                      0.0f,                 // pitch
+                                      heading > M_PI ? heading - 2.0 * M_PI : heading, // yaw
+                                      0.0f,                 // roll speed
+                                      0.0f,                 // pitch speed
+                                      yawRate);             // yaw speed
+            return true;
+
+        case MAVLINK_MSG_ID_HIGHRES_IMU:
+            mavlink_msg_highres_imu_pack(vehicle.systemId,
+                                         _vehicleComponentId,
+                                         msg,
+                                         (uint64_t)msecs * 1000,                // time usec
+                                         0.0f,                                  // x acc
+                                         vehicle.trackSpeed * yawRate,          // y acc, centripetal
+                                         -9.81f,                                // z acc
+                                         0.0f,                                  // x gyro
+                                         0.0f,                                  // y gyro
+                                         yawRate,                               // z gyro
+                                         0.21f, 0.0f, 0.42f,                    // mag
+                                         1013.25f - altRel / 8.3,               // absolute pressure
+                                         0.0f,                                  // differential pressure
+                                         altAMSL,                               // pressure altitude
+                                         25.0f,                                 // temperature
+                                         0x1FFF);                               // fields updated
+            return true;
+
+        case MAVLINK_MSG_ID_GPS_RAW_INT:
+            mavlink_msg_gps_raw_int_pack(vehicle.systemId,
+                                         _vehicleComponentId,
+                                         msg,
+                                         (uint64_t)msecs * 1000,                // time usec
+                                         3,                                     // 3D fix
+                                         (int32_t)(lat * 1E7),
+                                         (int32_t)(lon * 1E7),
+                                         (int32_t)(altAMSL * 1000),
+                                         100,                                   // eph
+                                         150,                                   // epv
+                                         (uint16_t)(vehicle.trackSpeed * 100),  // velocity cm/s
+                                         (uint16_t)(headingDeg * 100),          // course over ground
+                                         12);                                   // satellites visible
+            return true;
+
+        case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+            mavlink_msg_global_position_int_pack(vehicle.systemId,
+                                                 _vehicleComponentId,
+                                                 msg,
+                                                 (uint32_t)msecs,               // time since boot
+                                                 (int32_t)(lat * 1E7),
+                                                 (int32_t)(lon * 1E7),
+                                                 (int32_t)(altAMSL * 1000),
+                                                 (int32_t)(altRel * 1000),
+                                                 (int16_t)(vNorth * 100),
+                                                 (int16_t)(vEast * 100),
+                                                 0,                             // vz
+                                                 (uint16_t)(headingDeg * 100));
+            return true;
+
+        case MAVLINK_MSG_ID_VFR_HUD:
+            mavlink_msg_vfr_hud_pack(vehicle.systemId,
+                                     _vehicleComponentId,
+                                     msg,
+                                     vehicle.trackSpeed,    // airspeed
+                                     vehicle.trackSpeed,    // groundspeed
+                                     (int16_t)headingDeg,
+                                     50,                    // throttle
+                                     altAMSL,
+                                     0.0f);                 // climb
+            return true;
+
+        case MAVLINK_MSG_ID_SYS_STATUS:
+            mavlink_msg_sys_status_pack(vehicle.systemId,
+                                        _vehicleComponentId,
+                                        msg,
+                                        0,              // sensors present
+                                        0,              // sensors enabled
+                                        0,              // sensors health
+                                        250,            // load
+                                        12400,          // battery voltage mV
+                                        1000,           // battery current cA
+                                        (int8_t)(100 - (int)(seconds / 36) % 100),  // battery remaining
+                                        0,              // comm drop rate
+                                        0,              // comm errors
+                                        0, 0, 0, 0);    // autopilot errors
+            return true;
+
+        default:
+            qCWarning(MockLinkLog) << "Unsupported telemetry stream" << msgId;
+            return false;
+    }
+}
+
 void MockLink::_loadParams(void)
 {
     QFile paramFile(":/unittest/MockLink.params");
@@ -225,18 +523,21 @@ void MockLink::_loadParams(void)
 
 void MockLink::_sendHeartBeat(void)
 {
-    mavlink_message_t   msg;
-
-    mavlink_msg_heartbeat_pack(_vehicleSystemId,
-                               _vehicleComponentId,
-                               &msg,
-                               MAV_TYPE_QUADROTOR,  // MAV_TYPE
-                               _autopilotType,      // MAV_AUTOPILOT
-                               _mavBaseMode,        // MAV_MODE
-                               _mavCustomMode,      // custom mode
-                               _mavState);          // MAV_STATE
-    
-    respondWithMavlinkMessage(msg);
+    for (int i=0; i<_vehicles.count(); i++) {
+        mavlink_message_t   msg;
+        const SimulatedVehicle_t& vehicle = _vehicles[i];
+
+        mavlink_msg_heartbeat_pack(vehicle.systemId,
+                                   _vehicleComponentId,
+                                   &msg,
+                                   MAV_TYPE_QUADROTOR,  // MAV_TYPE
+                                   _autopilotType,      // MAV_AUTOPILOT
+                                   vehicle.baseMode,    // MAV_MODE
+                                   vehicle.customMode,  // custom mode
+                                   vehicle.state);      // MAV_STATE
+
+        respondWithMavlinkMessage(msg);
+    }
 }
 
 void MockLink::respondWithMavlinkMessage(const mavlink_message_t& msg)
@@ -305,6 +606,10 @@ void MockLink::_handleIncomingMavlinkBytes(const uint8_t* bytes, int cBytes)
             continue;
         }
         
+        if (_handleSecondaryVehicleMissionMessage(msg)) {
+            continue;
+        }
+
         if (_missionItemHandler.handleMessage(msg)) {
             continue;
         }
@@ -337,6 +642,10 @@ void MockLink::_handleIncomingMavlinkBytes(const uint8_t* bytes, int cBytes)
             case MAVLINK_MSG_ID_COMMAND_LONG:
                 _handleCommandLong(msg);
                 break;
+                
+            case MAVLINK_MSG_ID_TIMESYNC:
+                _handleTimesync(msg);
+                break;
 
             default:
                 break;
@@ -358,10 +667,72 @@ void MockLink::_handleSetMode(const mavlink_message_t& msg)
     mavlink_set_mode_t request;
     mavlink_msg_set_mode_decode(&msg, &request);
 
-    Q_ASSERT(request.target_system == _vehicleSystemId);
+    SimulatedVehicle_t* vehicle = _vehicleForId(request.target_system);
+    Q_ASSERT(vehicle);
+    if (vehicle) {
+        vehicle->baseMode = request.base_mode;
+        vehicle->customMode = request.custom_mode;
+    }
+}
+
+/// Mission protocol support for vehicles other than the primary vehicle. These vehicles always have an empty
+/// mission and do not accept new missions.
+///     @return true: message was handled
+bool MockLink::_handleSecondaryVehicleMissionMessage(const mavlink_message_t& msg)
+{
+    int targetSystem;
+
+    switch (msg.msgid) {
+        case MAVLINK_MSG_ID_MISSION_REQUEST_LIST:
+            targetSystem = mavlink_msg_mission_request_list_get_target_system(&msg);
+            break;
+        case MAVLINK_MSG_ID_MISSION_REQUEST:
+            targetSystem = mavlink_msg_mission_request_get_target_system(&msg);
+            break;
+        case MAVLINK_MSG_ID_MISSION_ITEM:
+            targetSystem = mavlink_msg_mission_item_get_target_system(&msg);
+            break;
+        case MAVLINK_MSG_ID_MISSION_COUNT:
+            targetSystem = mavlink_msg_mission_count_get_target_system(&msg);
+            break;
+        case MAVLINK_MSG_ID_MISSION_ACK:
+            targetSystem = mavlink_msg_mission_ack_get_target_system(&msg);
+            break;
+        case MAVLINK_MSG_ID_MISSION_SET_CURRENT:
+            targetSystem = mavlink_msg_mission_set_current_get_target_system(&msg);
+            break;
+        case MAVLINK_MSG_ID_MISSION_CLEAR_ALL:
+            targetSystem = mavlink_msg_mission_clear_all_get_target_system(&msg);
+            break;
+        default:
+            return false;
+    }
+
+    if (targetSystem == _vehicleSystemId || !_vehicleForId(targetSystem)) {
+        return false;
+    }
+
+    mavlink_message_t responseMsg;
+
+    if (msg.msgid == MAVLINK_MSG_ID_MISSION_REQUEST_LIST) {
+        mavlink_msg_mission_count_pack(targetSystem,
+                                       MAV_COMP_ID_MISSIONPLANNER,
+                                       &responseMsg,    // Outgoing message
+                                       msg.sysid,       // Target is original sender
+                                       msg.compid,      // Target is original sender
+                                       0);              // Number of mission items
+        respondWithMavlinkMessage(responseMsg);
+    } else if (msg.msgid == MAVLINK_MSG_ID_MISSION_COUNT) {
+        mavlink_msg_mission_ack_pack(targetSystem,
+                                     MAV_COMP_ID_MISSIONPLANNER,
+                                     &responseMsg,          // Outgoing message
+                                     msg.sysid,             // Target is original sender
+                                     msg.compid,            // Target is original sender
+                                     MAV_MISSION_UNSUPPORTED);
+        respondWithMavlinkMessage(responseMsg);
+    }
 
-    _mavBaseMode = request.base_mode;
-    _mavCustomMode = request.custom_mode;
+    return true;
 }
 
 void MockLink::_setParamFloatUnionIntoMap(int componentId, const QString& paramName, float paramFloat)
@@ -457,7 +828,7 @@ void MockLink::_handleParamRequestList(const mavlink_message_t& msg)
 
     mavlink_msg_param_request_list_decode(&msg, &request);
 
-    Q_ASSERT(request.target_system == _vehicleSystemId);
+    Q_ASSERT(_vehicleForId(request.target_system));
     Q_ASSERT(request.target_component == MAV_COMP_ID_ALL);
     
     // We must send the first parameter for each component first. Otherwise system won't correctly know
@@ -481,7 +852,7 @@ void MockLink::_handleParamRequestList(const mavlink_message_t& msg)
 
             qCDebug(MockLinkLog) << "Sending msg_param_value" << componentId << paramId << paramType << _mapParamName2Value[componentId][paramId];
 
-            mavlink_msg_param_value_pack(_vehicleSystemId,
+            mavlink_msg_param_value_pack(request.target_system,
                                          componentId,                       // component id
                                          &responseMsg,                      // Outgoing message
                                          paramId,                           // Parameter name
@@ -520,7 +891,7 @@ void MockLink::_handleParamRequestList(const mavlink_message_t& msg)
                 
                 qCDebug(MockLinkLog) << "Sending msg_param_value" << componentId << paramId << paramType << _mapParamName2Value[componentId][paramId];
                 
-                mavlink_msg_param_value_pack(_vehicleSystemId,
+                mavlink_msg_param_value_pack(request.target_system,
                                              componentId,                       // component id
                                              &responseMsg,                      // Outgoing message
                                              paramId,                           // Parameter name
@@ -539,7 +910,7 @@ void MockLink::_handleParamSet(const mavlink_message_t& msg)
     mavlink_param_set_t request;
     mavlink_msg_param_set_decode(&msg, &request);
 
-    Q_ASSERT(request.target_system == _vehicleSystemId);
+    Q_ASSERT(_vehicleForId(request.target_system));
     int componentId = request.target_component;
     
     // Param may not be null terminated if exactly fits
@@ -554,15 +925,22 @@ void MockLink::_handleParamSet(const mavlink_message_t& msg)
     Q_ASSERT(request.param_type == _mapParamName2MavParamType[paramId]);
 
     // Save the new value
-    _setParamFloatUnionIntoMap(componentId, paramId, request.param_value);
+    if (!_readOnlyParams.contains(paramId)) {
+        _setParamFloatUnionIntoMap(componentId, paramId, request.param_value);
+    }
+    
+    if (_paramSetAckDropCount > 0) {
+        _paramSetAckDropCount--;
+        return;
+    }
 
     // Respond with a param_value to ack
     mavlink_message_t responseMsg;
-    mavlink_msg_param_value_pack(_vehicleSystemId,
+    mavlink_msg_param_value_pack(request.target_system,
                                  componentId,                                               // component id
                                  &responseMsg,                                              // Outgoing message
                                  paramId,                                                   // Parameter name
-                                 request.param_value,                                       // Send same value back
+                                 _readOnlyParams.contains(paramId) ? _floatUnionForParam(componentId, paramId) : request.param_value, // Echo the value held
                                  request.param_type,                                        // Send same type back
                                  _mapParamName2Value[componentId].count(),                  // Total number of parameters
                                  _mapParamName2Value[componentId].keys().indexOf(paramId)); // Index of this parameter
@@ -580,7 +958,7 @@ void MockLink::_handleParamRequestRead(const mavlink_message_t& msg)
     char paramId[MAVLINK_MSG_PARAM_REQUEST_READ_FIELD_PARAM_ID_LEN + 1];
     paramId[0] = 0;
 
-    Q_ASSERT(request.target_system == _vehicleSystemId);
+    Q_ASSERT(_vehicleForId(request.target_system));
 
     if (request.param_index == -1) {
         // Request is by param name. Param may not be null terminated if exactly fits
@@ -600,7 +978,7 @@ void MockLink::_handleParamRequestRead(const mavlink_message_t& msg)
 
     mavlink_message_t   responseMsg;
 
-    mavlink_msg_param_value_pack(_vehicleSystemId,
+    mavlink_msg_param_value_pack(request.target_system,
                                  componentId,                                               // component id
                                  &responseMsg,                                              // Outgoing message
                                  paramId,                                                   // Parameter name
@@ -660,13 +1038,52 @@ void MockLink::_handleCommandLong(const mavlink_message_t& msg)
     
     mavlink_msg_command_long_decode(&msg, &request);
 
-    if (request.command == MAV_CMD_COMPONENT_ARM_DISARM) {
+    SimulatedVehicle_t* vehicle = _vehicleForId(request.target_system);
+    if (!vehicle) {
+        return;
+    }
+
+    if (request.command == MAV_CMD_COMPONENT_ARM_DISARM && _commandAckResult == MAV_RESULT_ACCEPTED) {
         if (request.param1 == 0.0f) {
-            _mavBaseMode &= ~MAV_MODE_FLAG_SAFETY_ARMED;
+            vehicle->baseMode &= ~MAV_MODE_FLAG_SAFETY_ARMED;
         } else {
-            _mavBaseMode |= MAV_MODE_FLAG_SAFETY_ARMED;
+            vehicle->baseMode |= MAV_MODE_FLAG_SAFETY_ARMED;
         }
     }
+    
+    if (_commandAckDropCount > 0) {
+        _commandAckDropCount--;
+        return;
+    }
+    
+    mavlink_message_t ackMsg;
+    mavlink_msg_command_ack_pack(vehicle->systemId,
+                                 _vehicleComponentId,
+                                 &ackMsg,
+                                 request.command,
+                                 _commandAckResult);
+    respondWithMavlinkMessage(ackMsg);
+}
+
+void MockLink::_handleTimesync(const mavlink_message_t& msg)
+{
+    mavlink_timesync_t request;
+    
+    mavlink_msg_timesync_decode(&msg, &request);
+    
+    // Only requests are answered, tc1 is filled in on responses
+    if (request.tc1 != 0) {
+        return;
+    }
+    
+    // The stream clock is the time since boot for all simulated vehicles, only the primary vehicle answers
+    mavlink_message_t responseMsg;
+    mavlink_msg_timesync_pack(_vehicleSystemId,
+                              _vehicleComponentId,
+                              &responseMsg,
+                              _streamClock.nsecsElapsed(),   // tc1
+                              request.ts1);
+    respondWithMavlinkMessage(responseMsg);
 }
 
 void MockLink::setMissionItemFailureMode(MockLinkMissionItemHandler::FailureMode_t failureMode, bool firstTimeOnly)
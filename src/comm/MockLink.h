@@ -25,6 +25,8 @@
 #define MOCKLINK_H
 
 #include <QMap>
+#include <QList>
+#include <QElapsedTimer>
 #include <QLoggingCategory>
 
 #include "MockLinkMissionItemHandler.h"
@@ -44,13 +46,37 @@ class MockConfiguration : public LinkConfiguration
 {
 public:
 
-    MockConfiguration(const QString& name) : LinkConfiguration(name) {}
-    MockConfiguration(MockConfiguration* source) : LinkConfiguration(source) {}
+    MockConfiguration(const QString& name);
+    MockConfiguration(MockConfiguration* source);
+
+    /// Number of vehicles simulated on the link. Vehicles use consecutive system ids starting at firstVehicleId.
+    /// The first vehicle supports the full set of protocols, additional vehicles support heartbeat, telemetry
+    /// streams, parameters and an always empty mission. Use multiple configurations with distinct first vehicle
+    /// ids to spread a swarm across multiple links.
+    int vehicleCount(void) { return _vehicleCount; }
+    void setVehicleCount(int vehicleCount) { _vehicleCount = vehicleCount; }
+
+    int firstVehicleId(void) { return _firstVehicleId; }
+    void setFirstVehicleId(int firstVehicleId) { _firstVehicleId = firstVehicleId; }
+
+    /// Telemetry streams sent by each vehicle: mavlink message id to rate in Hz
+    const QMap<int, int>& streamRates(void) { return _streamRates; }
+    void setStreamRate(int msgId, int rateHz);
+
     int  type() { return LinkConfiguration::TypeMock; }
-    void copyFrom(LinkConfiguration* source) { LinkConfiguration::copyFrom(source); }
-    void loadSettings(QSettings& settings, const QString& root) { Q_UNUSED(settings); Q_UNUSED(root); }
-    void saveSettings(QSettings& settings, const QString& root) { Q_UNUSED(settings); Q_UNUSED(root); }
+    void copyFrom(LinkConfiguration* source);
+    void loadSettings(QSettings& settings, const QString& root);
+    void saveSettings(QSettings& settings, const QString& root);
     void updateSettings() {}
+
+private:
+    int             _vehicleCount;
+    int             _firstVehicleId;
+    QMap<int, int>  _streamRates;
+
+    static const char* _vehicleCountKey;
+    static const char* _firstVehicleIdKey;
+    static const char* _streamRatesKey;
 };
 
 class MockLink : public LinkInterface
@@ -64,6 +90,7 @@ public:
 
     // MockLink methods
     int vehicleId(void) { return _vehicleSystemId; }
+    int vehicleCount(void) { return _vehicles.count(); }
     MAV_AUTOPILOT getAutopilotType(void) { return _autopilotType; }
     void setAutopilotType(MAV_AUTOPILOT autopilot) { _autopilotType = autopilot; }
     void emitRemoteControlChannelRawChanged(int channel, uint16_t raw);
@@ -103,6 +130,24 @@ public:
     
     /// Reset the state of the MissionItemHandler to no items, no transactions in progress.
     void resetMissionItemHandler(void) { _missionItemHandler.reset(); }
+    
+    /// Changes param1 of an item in the vehicle's mission, used to test mission caching
+    void setMissionItemParam1(int sequenceNumber, float param1) { _missionItemHandler.setMissionItemParam1(sequenceNumber, param1); }
+    
+    /// Sets the number of COMMAND_LONG messages which are not acked, used to test command retransmission
+    void setCommandAckDropCount(int count) { _commandAckDropCount = count; }
+    int commandAckDropCount(void) { return _commandAckDropCount; }
+    
+    /// Result sent in the COMMAND_ACK for all commands
+    void setCommandAckResult(MAV_RESULT result) { _commandAckResult = result; }
+    
+    /// Sets the number of PARAM_SET messages which are not echoed back, used to test parameter write retries.
+    /// The value is still set.
+    void setParamSetAckDropCount(int count) { _paramSetAckDropCount = count; }
+    int paramSetAckDropCount(void) { return _paramSetAckDropCount; }
+    
+    /// PARAM_SET leaves this parameter unchanged, the echo carries the value which was kept
+    void setParamReadOnly(const QString& paramName) { _readOnlyParams += paramName; }
 
 signals:
     /// @brief Used internally to move data to the thread.
@@ -119,6 +164,7 @@ private slots:
     void _run1HzTasks(void);
     void _run10HzTasks(void);
     void _run50HzTasks(void);
+    void _runStreamTasks(void);
 
 private:
     // From LinkInterface
@@ -141,6 +187,8 @@ private:
     void _handleParamRequestRead(const mavlink_message_t& msg);
     void _handleFTP(const mavlink_message_t& msg);
     void _handleCommandLong(const mavlink_message_t& msg);
+    void _handleTimesync(const mavlink_message_t& msg);
+    bool _handleSecondaryVehicleMissionMessage(const mavlink_message_t& msg);
     float _floatUnionForParam(int componentId, const QString& paramName);
     void _setParamFloatUnionIntoMap(int componentId, const QString& paramName, float paramFloat);
 
@@ -158,14 +206,49 @@ private:
     QMap<int, QMap<QString, QVariant> > _mapParamName2Value;
     QMap<QString, MAV_PARAM_TYPE>       _mapParamName2MavParamType;
 
-    uint8_t     _mavBaseMode;
-    uint32_t    _mavCustomMode;
-    uint8_t     _mavState;
+    /// State for each simulated vehicle
+    typedef struct {
+        uint8_t     systemId;
+        uint8_t     baseMode;
+        uint32_t    customMode;
+        uint8_t     state;
+        double      trackCenterLat;     ///< Center of the circular track the vehicle flies
+        double      trackCenterLon;
+        double      trackRadius;        ///< Track radius in meters
+        double      trackSpeed;         ///< Ground speed along the track in meters/second
+        double      trackPhase;         ///< Starting angle along the track in radians
+        double      trackAltitude;      ///< Altitude above home in meters
+    } SimulatedVehicle_t;
+
+    /// A telemetry stream which each vehicle sends at a fixed rate
+    typedef struct {
+        int     msgId;
+        int     rateHz;
+        quint64 sentCount;  ///< Number of messages sent since _streamClock was started
+    } TelemetryStream_t;
+
+    void _addSimulatedVehicle(uint8_t systemId, int index);
+    SimulatedVehicle_t* _vehicleForId(int systemId);
+    bool _packStreamMessage(int msgId, const SimulatedVehicle_t& vehicle, qint64 msecs, mavlink_message_t* msg);
+
+    QList<SimulatedVehicle_t>   _vehicles;      ///< All simulated vehicles, first entry is the primary vehicle (_vehicleSystemId)
+    QList<TelemetryStream_t>    _streams;
+    QElapsedTimer               _streamClock;   ///< Time base for telemetry streams and vehicle tracks
+
+    static const int    _streamTickMsecs = 4;   ///< Stream timer interval, fast enough to support 250 Hz streams
+    static const double _homeLatitude;
+    static const double _homeLongitude;
+    static const double _homeAltitude;
 
     MockConfiguration* _config;
     MAV_AUTOPILOT _autopilotType;
     
     MockLinkFileServer* _fileServer;
+    
+    int         _commandAckDropCount;
+    MAV_RESULT  _commandAckResult;
+    int         _paramSetAckDropCount;
+    QStringList _readOnlyParams;
 };
 
 #endif
@@ -23,6 +23,7 @@
 
 #include "MockLinkFileServer.h"
 #include "MockLink.h"
+#include "FileSync.h"
 
 const MockLinkFileServer::ErrorMode_t MockLinkFileServer::rgFailureModes[] = {
     MockLinkFileServer::errModeNoResponse,
@@ -42,16 +43,136 @@ const MockLinkFileServer::FileTestCase MockLinkFileServer::rgFileTestCases[MockL
     { "multi.qgc",      sizeof(((FileManager::Request*)0)->data) + 1,     2,    false },
 };
 
-// We only support a single fixed session
-const uint8_t MockLinkFileServer::_sessionId = 1;
-
 MockLinkFileServer::MockLinkFileServer(uint8_t systemIdServer, uint8_t componentIdServer, MockLink* mockLink) :
     _errMode(errModeNone),
+    _burstLossPercent(0.0),
+    _burstReorderPercent(0.0),
+    _writeAckLossPercent(0.0),
+    _rngState(1),
+    _readByteCount(0),
+    _writeRequestCount(0),
+    _lostWriteAckCount(0),
+    _maxOpenSessionCount(0),
+    _crc32RequestCount(0),
     _systemIdServer(systemIdServer),
     _componentIdServer(componentIdServer),
     _mockLink(mockLink)
 {
+    for (int i=0; i<maxSessions; i++) {
+        _sessions[i].open = false;
+    }
+    
+    clearFiles();
+}
+
+void MockLinkFileServer::addSyntheticFile(const QString& path, uint32_t length)
+{
+    File_t file;
+    
+    file.length = length;
+    file.synthetic = true;
+    _files[path] = file;
+}
+
+void MockLinkFileServer::addFile(const QString& path, const QByteArray& data)
+{
+    File_t file;
+    
+    file.length = data.size();
+    file.synthetic = false;
+    file.data = data;
+    _files[path] = file;
+}
+
+void MockLinkFileServer::clearFiles(void)
+{
+    _files.clear();
+    
+    for (size_t i=0; i<cFileTestCases; i++) {
+        addSyntheticFile(rgFileTestCases[i].filename, rgFileTestCases[i].length);
+    }
+}
+
+QByteArray MockLinkFileServer::uploadedFile(const QString& path)
+{
+    if (_files.contains(path) && !_files[path].synthetic) {
+        return _files[path].data;
+    }
+    return QByteArray();
+}
+
+quint32 MockLinkFileServer::syntheticFileCRC32(uint32_t length)
+{
+    quint32 crc32 = 0;
+    char buffer[4096];
+    
+    for (uint32_t offset=0; offset<length; ) {
+        uint32_t cBytes = qMin(length - offset, (uint32_t)sizeof(buffer));
+        for (uint32_t i=0; i<cBytes; i++) {
+            buffer[i] = fileByte(offset + i);
+        }
+        crc32 = FileSync::crc32(buffer, cBytes, crc32);
+        offset += cBytes;
+    }
+    
+    return crc32;
+}
+
+/// @brief Opens a session on the specified file
+/// @return Session id, 0 if no sessions are available
+int MockLinkFileServer::_openSession(const QString& path, bool write)
+{
+    int session = 0;
+    int openCount = 0;
+    
+    for (int i=0; i<maxSessions; i++) {
+        if (!_sessions[i].open && session == 0) {
+            _sessions[i].open = true;
+            _sessions[i].write = write;
+            _sessions[i].path = path;
+            session = i + 1;
+        }
+        if (_sessions[i].open) {
+            openCount++;
+        }
+    }
+    _maxOpenSessionCount = qMax(_maxOpenSessionCount, openCount);
+    
+    return session;
+}
+
+bool MockLinkFileServer::_validSession(uint8_t session, bool write)
+{
+    return session >= 1 && session <= maxSessions && _sessions[session - 1].open && _sessions[session - 1].write == write;
+}
+
+/// @brief Copies file data at the specified offset
+/// @return Number of bytes copied, 0 for offset at or past the end of the file
+uint8_t MockLinkFileServer::_readFileData(const QString& path, uint32_t offset, uint8_t* data, uint8_t maxBytes)
+{
+    const File_t& file = _files[path];
+    
+    uint8_t cBytes = 0;
+    for (; cBytes < maxBytes && offset < file.length; offset++, cBytes++) {
+        data[cBytes] = file.synthetic ? fileByte(offset) : (uint8_t)file.data[offset];
+    }
+    _readByteCount += cBytes;
+    
+    return cBytes;
+}
+
+quint32 MockLinkFileServer::_random(void)
+{
+    _rngState ^= _rngState << 13;
+    _rngState ^= _rngState >> 17;
+    _rngState ^= _rngState << 5;
+    return _rngState;
+}
 
+/// @return Random value in the range [0, 100)
+double MockLinkFileServer::_randomPercent(void)
+{
+    return (_random() / 4294967296.0) * 100.0;
 }
 
 /// @brief Handles List command requests. Only supports root folder paths.
@@ -121,28 +242,24 @@ void MockLinkFileServer::_openCommand(uint8_t senderSystemId, uint8_t senderComp
     Q_UNUSED(cchPath); // Fix initialized-but-not-referenced warning on release builds
     path = (char *)request->data;
     
-    // Check path against one of our known test cases
-
-    bool found = false;
-    for (size_t i=0; i<cFileTestCases; i++) {
-        if (path == rgFileTestCases[i].filename) {
-            found = true;
-            _readFileLength = rgFileTestCases[i].length;
-            break;
-        }
-    }
-    if (!found) {
+    if (!_files.contains(path)) {
         _sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdOpenFileRO);
         return;
     }
     
+    int session = _openSession(path, false /* write */);
+    if (session == 0) {
+        _sendNak(senderSystemId, senderComponentId, FileManager::kErrNoSessionsAvailable, outgoingSeqNumber, FileManager::kCmdOpenFileRO);
+        return;
+    }
+    
     response.hdr.opcode = FileManager::kRspAck;
 	response.hdr.req_opcode = FileManager::kCmdOpenFileRO;
-    response.hdr.session = _sessionId;
+    response.hdr.session = session;
     
     // Data contains file length
     response.hdr.size = sizeof(uint32_t);
-    response.openFileLength = _readFileLength;
+    response.openFileLength = _files[path].length;
     
     _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
 }
@@ -152,19 +269,18 @@ void MockLinkFileServer::_readCommand(uint8_t senderSystemId, uint8_t senderComp
     FileManager::Request	response;
     uint16_t				outgoingSeqNumber = _nextSeqNumber(seqNumber);
 
-    if (request->hdr.session != _sessionId) {
-		_sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdReadFile);
+    if (!_validSession(request->hdr.session, false /* write */)) {
+		_sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdReadFile, request->hdr.session);
         return;
     }
     
     uint32_t readOffset = request->hdr.offset;  // offset into file for reading
-    uint8_t cDataBytes = 0;                     // current number of data bytes used
     
     if (readOffset != 0) {
         // If we get here it means the client is requesting additional data past the first request
         if (_errMode == errModeNakSecondResponse) {
             // Nak error all subsequent requests
-            _sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdReadFile);
+            _sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdReadFile, request->hdr.session);
             return;
         } else if (_errMode == errModeNoSecondResponse) {
             // No rsponse for all subsequent requests
@@ -172,20 +288,13 @@ void MockLinkFileServer::_readCommand(uint8_t senderSystemId, uint8_t senderComp
         }
     }
     
-    if (readOffset >= _readFileLength) {
-        _sendNak(senderSystemId, senderComponentId, FileManager::kErrEOF, outgoingSeqNumber, FileManager::kCmdReadFile);
+    uint8_t cDataBytes = _readFileData(_sessions[request->hdr.session - 1].path, readOffset, response.data, sizeof(response.data));
+    if (cDataBytes == 0) {
+        _sendNak(senderSystemId, senderComponentId, FileManager::kErrEOF, outgoingSeqNumber, FileManager::kCmdReadFile, request->hdr.session);
         return;
     }
     
-    // Write file bytes. Data is a repeating sequence of 0x00, 0x01, .. 0xFF.
-    for (; cDataBytes < sizeof(response.data) && readOffset < _readFileLength; readOffset++, cDataBytes++) {
-        response.data[cDataBytes] = readOffset & 0xFF;
-    }
-    
-    // We should always have written something, otherwise there is something wrong with the code above
-    Q_ASSERT(cDataBytes);
-    
-    response.hdr.session = _sessionId;
+    response.hdr.session = request->hdr.session;
     response.hdr.size = cDataBytes;
     response.hdr.offset = request->hdr.offset;
     response.hdr.opcode = FileManager::kRspAck;
@@ -194,67 +303,192 @@ void MockLinkFileServer::_readCommand(uint8_t senderSystemId, uint8_t senderComp
     _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
 }
 
+/// @brief Handles Burst command requests. The burst runs from the requested offset to the end of the file. Burst
+/// packets are subject to the loss and re-ordering set with setBurstLossPercent and setBurstReorderPercent.
 void MockLinkFileServer::_streamCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
 {
     uint16_t                outgoingSeqNumber = _nextSeqNumber(seqNumber);
     FileManager::Request    response;
 
-    if (request->hdr.session != _sessionId) {
-		_sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdBurstReadFile);
+    if (!_validSession(request->hdr.session, false /* write */)) {
+		_sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdBurstReadFile, request->hdr.session);
         return;
     }
     
-    uint32_t readOffset = 0;	// offset into file for reading
-    uint32_t ackOffset = 0;     // offset for ack
-    uint8_t cDataAck;           // number of bytes in ack
+    QString path = _sessions[request->hdr.session - 1].path;
+    uint32_t readOffset = request->hdr.offset;	// offset into file for reading
+    bool firstPacket = true;
+    bool heldBack = false;                      // true: heldResponse is waiting to be sent after the next packet
+    FileManager::Request heldResponse;
+    uint16_t heldSeqNumber = 0;
     
-    while (readOffset < _readFileLength) {
-        cDataAck = 0;
+    while (true) {
+        uint8_t cDataAck = _readFileData(path, readOffset, response.data, sizeof(response.data));
+        if (cDataAck == 0) {
+            break;
+        }
         
-        if (readOffset != 0) {
+        if (!firstPacket) {
             // If we get here it means the client is requesting additional data past the first request
             if (_errMode == errModeNakSecondResponse) {
                 // Nak error all subsequent requests
-                _sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdBurstReadFile);
+                _sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdBurstReadFile, request->hdr.session);
                 return;
             } else if (_errMode == errModeNoSecondResponse) {
                 // No response for all subsequent requests
                 return;
             }
         }
+        firstPacket = false;
         
-        // Write file bytes. Data is a repeating sequence of 0x00, 0x01, .. 0xFF.
-        for (; cDataAck < sizeof(response.data) && readOffset < _readFileLength; readOffset++, cDataAck++) {
-            response.data[cDataAck] = readOffset & 0xFF;
-        }
-        
-        // We should always have written something, otherwise there is something wrong with the code above
-        Q_ASSERT(cDataAck);
-        
-        response.hdr.session = _sessionId;
+        response.hdr.session = request->hdr.session;
         response.hdr.size = cDataAck;
-        response.hdr.offset = ackOffset;
+        response.hdr.offset = readOffset;
         response.hdr.opcode = FileManager::kRspAck;
         response.hdr.req_opcode = FileManager::kCmdBurstReadFile;
+        response.hdr.burstComplete = 0;
         
-        _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+        if (_burstLossPercent > 0.0 && _randomPercent() < _burstLossPercent) {
+            // Lost packet, the sequence number is still used up
+        } else if (!heldBack && _burstReorderPercent > 0.0 && _randomPercent() < _burstReorderPercent) {
+            heldResponse = response;
+            heldSeqNumber = outgoingSeqNumber;
+            heldBack = true;
+        } else {
+            _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+            if (heldBack) {
+                _sendResponse(senderSystemId, senderComponentId, &heldResponse, heldSeqNumber);
+                heldBack = false;
+            }
+        }
         
         outgoingSeqNumber = _nextSeqNumber(outgoingSeqNumber);
-        ackOffset += cDataAck;
+        readOffset += cDataAck;
+    }
+    
+    if (heldBack) {
+        _sendResponse(senderSystemId, senderComponentId, &heldResponse, heldSeqNumber);
     }
 	
-    _sendNak(senderSystemId, senderComponentId, FileManager::kErrEOF, outgoingSeqNumber, FileManager::kCmdBurstReadFile);
+    _sendNak(senderSystemId, senderComponentId, FileManager::kErrEOF, outgoingSeqNumber, FileManager::kCmdBurstReadFile, request->hdr.session);
+}
+
+/// @brief Handles Create command requests. The file must not already exist.
+void MockLinkFileServer::_createCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
+{
+    FileManager::Request    response;
+    uint16_t                outgoingSeqNumber = _nextSeqNumber(seqNumber);
+    
+    QString path = QString::fromLocal8Bit((char *)request->data, strnlen((char *)request->data, sizeof(request->data)));
+    
+    if (_files.contains(path)) {
+        _sendNak(senderSystemId, senderComponentId, FileManager::kErrFailFileExists, outgoingSeqNumber, FileManager::kCmdCreateFile);
+        return;
+    }
+    
+    int session = _openSession(path, true /* write */);
+    if (session == 0) {
+        _sendNak(senderSystemId, senderComponentId, FileManager::kErrNoSessionsAvailable, outgoingSeqNumber, FileManager::kCmdCreateFile);
+        return;
+    }
+    
+    File_t file;
+    file.length = 0;
+    file.synthetic = false;
+    _files[path] = file;
+    
+    response.hdr.opcode = FileManager::kRspAck;
+    response.hdr.req_opcode = FileManager::kCmdCreateFile;
+    response.hdr.session = session;
+    response.hdr.size = 0;
+    
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+}
+
+/// @brief Handles Write command requests. Writes may arrive in any order.
+void MockLinkFileServer::_writeCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
+{
+    FileManager::Request    response;
+    uint16_t                outgoingSeqNumber = _nextSeqNumber(seqNumber);
+    
+    _writeRequestCount++;
+    
+    if (!_validSession(request->hdr.session, true /* write */)) {
+        _sendNak(senderSystemId, senderComponentId, FileManager::kErrInvalidSession, outgoingSeqNumber, FileManager::kCmdWriteFile, request->hdr.session);
+        return;
+    }
+    
+    if (request->hdr.offset != 0) {
+        // If we get here it means the client is sending additional data past the first request
+        if (_errMode == errModeNakSecondResponse) {
+            _sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdWriteFile, request->hdr.session);
+            return;
+        } else if (_errMode == errModeNoSecondResponse) {
+            return;
+        }
+    }
+    
+    File_t& file = _files[_sessions[request->hdr.session - 1].path];
+    uint32_t end = request->hdr.offset + request->hdr.size;
+    if (end > (uint32_t)file.data.size()) {
+        file.data.resize(end);
+        file.length = end;
+    }
+    memcpy(file.data.data() + request->hdr.offset, request->data, request->hdr.size);
+    
+    response.hdr.opcode = FileManager::kRspAck;
+    response.hdr.req_opcode = FileManager::kCmdWriteFile;
+    response.hdr.session = request->hdr.session;
+    response.hdr.offset = request->hdr.offset;
+    response.hdr.size = sizeof(uint32_t);
+    response.writeFileLength = request->hdr.size;
+    
+    if (_writeAckLossPercent > 0.0 && _randomPercent() < _writeAckLossPercent) {
+        // Lost ack, the client has to resend the write
+        _lostWriteAckCount++;
+        return;
+    }
+    
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+}
+
+/// @brief Handles CalcFileCRC32 command requests.
+void MockLinkFileServer::_calcCRC32Command(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
+{
+    FileManager::Request    response;
+    uint16_t                outgoingSeqNumber = _nextSeqNumber(seqNumber);
+    
+    _crc32RequestCount++;
+    
+    QString path = QString::fromLocal8Bit((char *)request->data, strnlen((char *)request->data, sizeof(request->data)));
+    
+    if (!_files.contains(path)) {
+        _sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdCalcFileCRC32);
+        return;
+    }
+    
+    const File_t& file = _files[path];
+    
+    response.hdr.opcode = FileManager::kRspAck;
+    response.hdr.req_opcode = FileManager::kCmdCalcFileCRC32;
+    response.hdr.session = 0;
+    response.hdr.size = sizeof(uint32_t);
+    response.crc32 = file.synthetic ? syntheticFileCRC32(file.length) : FileSync::crc32(file.data.constData(), file.data.size());
+    
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
 }
 
 void MockLinkFileServer::_terminateCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
 {
     uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
 
-    if (request->hdr.session != _sessionId) {
+    if (request->hdr.session < 1 || request->hdr.session > maxSessions || !_sessions[request->hdr.session - 1].open) {
 		_sendNak(senderSystemId, senderComponentId, FileManager::kErrInvalidSession, outgoingSeqNumber, FileManager::kCmdTerminateSession);
         return;
     }
     
+    _sessions[request->hdr.session - 1].open = false;
+    
 	_sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, FileManager::kCmdTerminateSession);
 	
     emit terminateCommandReceived();
@@ -264,6 +498,10 @@ void MockLinkFileServer::_resetCommand(uint8_t senderSystemId, uint8_t senderCom
 {
     uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
     
+    for (int i=0; i<maxSessions; i++) {
+        _sessions[i].open = false;
+    }
+    
     _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, FileManager::kCmdResetSessions);
     
     emit resetCommandReceived();
@@ -308,6 +546,7 @@ void MockLinkFileServer::handleFTPMessage(const mavlink_message_t& message)
         case FileManager::kCmdNone:
             // ignored, always acked
             ackResponse.hdr.opcode = FileManager::kRspAck;
+            ackResponse.hdr.req_opcode = FileManager::kCmdNone;
             ackResponse.hdr.session = 0;
             ackResponse.hdr.size = 0;
             _sendResponse(message.sysid, message.compid, &ackResponse, outgoingSeqNumber);
@@ -329,6 +568,18 @@ void MockLinkFileServer::handleFTPMessage(const mavlink_message_t& message)
             _streamCommand(message.sysid, message.compid, request, incomingSeqNumber);
             break;
 
+        case FileManager::kCmdCreateFile:
+            _createCommand(message.sysid, message.compid, request, incomingSeqNumber);
+            break;
+
+        case FileManager::kCmdWriteFile:
+            _writeCommand(message.sysid, message.compid, request, incomingSeqNumber);
+            break;
+
+        case FileManager::kCmdCalcFileCRC32:
+            _calcCRC32Command(message.sysid, message.compid, request, incomingSeqNumber);
+            break;
+
         case FileManager::kCmdTerminateSession:
             _terminateCommand(message.sysid, message.compid, request, incomingSeqNumber);
             break;
@@ -357,14 +608,14 @@ void MockLinkFileServer::_sendAck(uint8_t targetSystemId, uint8_t targetComponen
     _sendResponse(targetSystemId, targetComponentId, &ackResponse, seqNumber);
 }
 
-/// @brief Sends a Nak with the specified error code.
-void MockLinkFileServer::_sendNak(uint8_t targetSystemId, uint8_t targetComponentId, FileManager::ErrorCode error, uint16_t seqNumber, FileManager::Opcode reqOpcode)
+/// @brief Sends a Nak with the specified error code. Naks to session commands carry the session of the request, as they do on PX4.
+void MockLinkFileServer::_sendNak(uint8_t targetSystemId, uint8_t targetComponentId, FileManager::ErrorCode error, uint16_t seqNumber, FileManager::Opcode reqOpcode, uint8_t session)
 {
     FileManager::Request nakResponse;
 
     nakResponse.hdr.opcode = FileManager::kRspNak;
 	nakResponse.hdr.req_opcode = reqOpcode;
-    nakResponse.hdr.session = 0;
+    nakResponse.hdr.session = session;
     nakResponse.hdr.size = 1;
     nakResponse.data[0] = error;
     
@@ -30,10 +30,13 @@
 #include "FileManager.h"
 
 #include <QStringList>
+#include <QMap>
 
 class MockLink;
 
-/// Mock implementation of Mavlink FTP server.
+/// Mock implementation of Mavlink FTP server. Serves synthetic files of any size whose contents are generated
+/// from the offset, accepts uploads and supports several concurrent sessions. Burst downloads can be impaired
+/// with packet loss and re-ordering for testing the robustness and throughput of FileManager.
 class MockLinkFileServer : public QObject
 {
     Q_OBJECT
@@ -83,6 +86,62 @@ public:
     /// @brief The set of files supported by the mock server for testing purposes. Each one represents a different edge case for testing.
     static const FileTestCase rgFileTestCases[cFileTestCases];
     
+    /// @brief Adds a file which can be downloaded. Contents are generated on the fly, see fileByte.
+    ///     @param path Path to the file as sent by the client
+    ///     @param length Length of file in bytes
+    void addSyntheticFile(const QString& path, uint32_t length);
+    
+    /// @brief Adds a file with the specified contents which can be downloaded, replacing any file at the same path
+    void addFile(const QString& path, const QByteArray& data);
+    
+    /// @brief Removes the synthetic and uploaded files, the files from rgFileTestCases stay in place.
+    void clearFiles(void);
+    
+    /// @return Contents of a file which was uploaded, empty if none
+    QByteArray uploadedFile(const QString& path);
+    
+    /// @return Byte at the specified offset of a synthetic file. Data placed at the wrong offset shows up even when
+    /// it is off by a multiple of 256.
+    static uint8_t fileByte(uint32_t offset) { return (offset + (offset >> 8)) & 0xFF; }
+    
+    /// @return CRC32 of a synthetic file of the specified length, as returned by kCmdCalcFileCRC32
+    static quint32 syntheticFileCRC32(uint32_t length);
+    
+    /// @brief Percent chance of each burst packet being lost
+    void setBurstLossPercent(double percent) { _burstLossPercent = percent; }
+    
+    /// @brief Percent chance of a burst packet being held back and sent after the packet which follows it
+    void setBurstReorderPercent(double percent) { _burstReorderPercent = percent; }
+    
+    /// @brief Percent chance of each Write ack being lost. The data is still written.
+    void setWriteAckLossPercent(double percent) { _writeAckLossPercent = percent; }
+    
+    /// @brief Seed for the loss and re-ordering random number generator
+    void setRandomSeed(quint32 seed) { _rngState = seed ? seed : 1; }
+    
+    /// @brief Number of file data bytes read by Read and Burst commands since the last clearReadByteCount
+    uint32_t readByteCount(void) { return _readByteCount; }
+    void clearReadByteCount(void) { _readByteCount = 0; }
+    
+    /// @brief Number of Write commands received and Write acks lost since the last clearWriteCounts
+    int writeRequestCount(void) { return _writeRequestCount; }
+    int lostWriteAckCount(void) { return _lostWriteAckCount; }
+    void clearWriteCounts(void) { _writeRequestCount = 0; _lostWriteAckCount = 0; }
+    
+    /// @brief Highest number of sessions open at the same time since the last clearMaxOpenSessionCount
+    int maxOpenSessionCount(void) { return _maxOpenSessionCount; }
+    void clearMaxOpenSessionCount(void) { _maxOpenSessionCount = 0; }
+    
+    /// @brief Number of CalcFileCRC32 commands received since the last clearCRC32RequestCount
+    int crc32RequestCount(void) { return _crc32RequestCount; }
+    void clearCRC32RequestCount(void) { _crc32RequestCount = 0; }
+    
+    /// @brief Number of file data bytes carried by each Read, Burst or Write packet
+    static const uint32_t packetDataSize = sizeof(((FileManager::Request*)0)->data);
+    
+    /// @brief Number of sessions which can be open at the same time
+    static const int maxSessions = 3;
+    
 signals:
     /// You can connect to this signal to be notified when the server receives a Terminate command.
     void terminateCommandReceived(void);
@@ -92,21 +151,52 @@ signals:
     
 private:
 	void _sendAck(uint8_t targetSystemId, uint8_t targetComponentId, uint16_t seqNumber, FileManager::Opcode reqOpcode);
-    void _sendNak(uint8_t targetSystemId, uint8_t targetComponentId, FileManager::ErrorCode error, uint16_t seqNumber, FileManager::Opcode reqOpcode);
+    void _sendNak(uint8_t targetSystemId, uint8_t targetComponentId, FileManager::ErrorCode error, uint16_t seqNumber, FileManager::Opcode reqOpcode, uint8_t session = 0);
     void _sendResponse(uint8_t targetSystemId, uint8_t targetComponentId, FileManager::Request* request, uint16_t seqNumber);
     void _listCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
     void _openCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
     void _readCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
 	void _streamCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
+    void _createCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
+    void _writeCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
+    void _calcCRC32Command(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
     void _terminateCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
     void _resetCommand(uint8_t senderSystemId, uint8_t senderComponentId, uint16_t seqNumber);
     uint16_t _nextSeqNumber(uint16_t seqNumber);
+    int _openSession(const QString& path, bool write);
+    bool _validSession(uint8_t session, bool write);
+    uint8_t _readFileData(const QString& path, uint32_t offset, uint8_t* data, uint8_t maxBytes);
+    quint32 _random(void);
+    double _randomPercent(void);
+    
+    /// A file on the mock server
+    typedef struct {
+        uint32_t    length;
+        bool        synthetic;  ///< true: contents generated by fileByte, false: contents in data
+        QByteArray  data;       ///< Contents of an uploaded file
+    } File_t;
+    
+    /// An open session, session ids sent to the client are index + 1
+    typedef struct {
+        bool        open;
+        bool        write;      ///< true: opened by Create for writing
+        QString     path;
+    } Session_t;
     
     QStringList _fileList;  ///< List of files returned by List command
     
-    static const uint8_t    _sessionId;
-    uint8_t                 _readFileLength;    ///< Length of active file being read
+    QMap<QString, File_t>   _files;             ///< Files which can be opened, keyed by path
+    Session_t               _sessions[maxSessions];
     ErrorMode_t             _errMode;           ///< Currently set error mode, as specified by setErrorMode
+    double                  _burstLossPercent;
+    double                  _burstReorderPercent;
+    double                  _writeAckLossPercent;
+    quint32                 _rngState;
+    uint32_t                _readByteCount;
+    int                     _writeRequestCount;
+    int                     _lostWriteAckCount;
+    int                     _maxOpenSessionCount;
+    int                     _crc32RequestCount;
     const uint8_t           _systemIdServer;    ///< System ID for server
     const uint8_t           _componentIdServer; ///< Component ID for server
     MockLink*               _mockLink;          ///< MockLink to communicate through
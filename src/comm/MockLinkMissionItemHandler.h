@@ -87,6 +87,9 @@ public:
     
     /// Reset the state of the MissionItemHandler to no items, no transactions in progress.
     void reset(void) { _missionItems.clear(); }
+    
+    /// Changes param1 of an item in the vehicle's mission without a write from QGC
+    void setMissionItemParam1(int sequenceNumber, float param1) { _missionItems[sequenceNumber].param1 = param1; }
 
 private slots:
     void _missionItemResponseTimeout(void);
@@ -25,6 +25,7 @@
 #include "QGC.h"
 #include "MG.h"
 #include "QGCLoggingCategory.h"
+#include "QGCTrace.h"
 
 QGC_LOGGING_CATEGORY(SerialLinkLog, "SerialLinkLog")
 
@@ -99,6 +100,7 @@ void SerialLink::writeBytes(const char* data, qint64 size)
  **/
 void SerialLink::readBytes()
 {
+    QGC_TRACE_SCOPE("link", "SerialLink::readBytes");
     if(_port && _port->isOpen()) {
         const qint64 maxLength = 2048;
         char data[maxLength];
@@ -262,6 +264,7 @@ bool SerialLink::_hardwareConnect(QString &type)
 
 void SerialLink::_readBytes(void)
 {
+    QGC_TRACE_SCOPE("link", "SerialLink::readBytes");
     qint64 byteCount = _port->bytesAvailable();
     if (byteCount)
     {
@@ -29,6 +29,7 @@
 #include "TCPLink.h"
 #include "LinkManager.h"
 #include "QGC.h"
+#include "QGCTrace.h"
 #include <QHostInfo>
 #include <QSignalSpy>
 
@@ -105,6 +106,7 @@ void TCPLink::writeBytes(const char* data, qint64 size)
  **/
 void TCPLink::readBytes()
 {
+    QGC_TRACE_SCOPE("link", "TCPLink::readBytes");
     qint64 byteCount = _socket->bytesAvailable();
     if (byteCount)
     {
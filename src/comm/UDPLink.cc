@@ -44,6 +44,7 @@ This file is part of the QGROUNDCONTROL project
 
 #include "UDPLink.h"
 #include "QGC.h"
+#include "QGCTrace.h"
 #include <QHostInfo>
 
 #define REMOVE_GONE_HOSTS 0
@@ -241,6 +242,7 @@ void UDPLink::_sendBytes(const char* data, qint64 size)
  **/
 void UDPLink::readBytes()
 {
+    QGC_TRACE_SCOPE("link", "UDPLink::readBytes");
     while (_socket->hasPendingDatagrams())
     {
         QByteArray datagram;
@@ -136,8 +136,11 @@ int main(int argc, char *argv[])
     bool quietWindowsAsserts = false;   // Don't let asserts pop dialog boxes
 
     QString unitTestOptions;
+    bool unitTestOutput = false;
+    QString unitTestOutputDirectory;
     CmdLineOpt_t rgCmdLineOptions[] = {
         { "--unittest",             &runUnitTests,          &unitTestOptions },
+        { "--unittest-output",      &unitTestOutput,        &unitTestOutputDirectory },
         { "--no-windows-assert-ui", &quietWindowsAsserts,   NULL },
         // Add additional command line option flags here
     };
@@ -182,7 +185,7 @@ int main(int argc, char *argv[])
         }
 
         // Run the test
-        int failures = UnitTest::run(unitTestOptions);
+        int failures = UnitTest::run(unitTestOptions, unitTestOutputDirectory);
         if (failures == 0) {
             qDebug() << "ALL TESTS PASSED";
         } else {
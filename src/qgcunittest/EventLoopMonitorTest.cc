@@ -0,0 +1,113 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "EventLoopMonitorTest.h"
+#include "EventLoopMonitor.h"
+#include "QGCTrace.h"
+#include "QGCTemporaryFile.h"
+
+#include <QSignalSpy>
+#include <QThread>
+
+UT_REGISTER_TEST(EventLoopMonitorTest)
+
+EventLoopMonitorTest::EventLoopMonitorTest(void)
+{
+    
+}
+
+void EventLoopMonitorTest::_startMonitor(const QString& logFilename)
+{
+    EventLoopMonitor* monitor = EventLoopMonitor::instance();
+    
+    monitor->setProbeIntervalMsecs(_probeIntervalMsecs);
+    monitor->setStallThresholdMsecs(_stallThresholdMsecs);
+    monitor->setLogFilename(logFilename);
+    monitor->resetStatistics();
+    monitor->start();
+    QVERIFY(monitor->running());
+}
+
+/// An idle event loop should answer all probes quickly
+void EventLoopMonitorTest::_noStall_test(void)
+{
+    EventLoopMonitor* monitor = EventLoopMonitor::instance();
+    
+    _startMonitor(QString());
+    QTest::qWait(500);
+    monitor->stop();
+    QVERIFY(!monitor->running());
+    
+    QVERIFY(monitor->probeCount() > 5);
+    QCOMPARE(monitor->stallCount(), (quint32)0);
+    QVERIFY(monitor->maxLatencyMsecs() <= _stallThresholdMsecs);
+    
+    int histogramTotal = 0;
+    for (int bucket=0; bucket<EventLoopMonitor::histogramBucketCount; bucket++) {
+        histogramTotal += monitor->histogramCount(bucket);
+    }
+    QCOMPARE((quint32)histogramTotal, monitor->probeCount());
+}
+
+/// Blocking the main thread must be recorded as a stall along with the span which was executing
+void EventLoopMonitorTest::_stall_test(void)
+{
+    EventLoopMonitor* monitor = EventLoopMonitor::instance();
+    QSignalSpy stallSpy(monitor, SIGNAL(stallDetected(int, QString)));
+    
+    // Only the file name is needed, the monitor opens the file itself
+    QGCTemporaryFile logFile("EventLoopMonitorTestXXXXXX.log");
+    logFile.open();
+    logFile.close();
+    
+    _startMonitor(logFile.fileName());
+    QTest::qWait(100);
+    
+    {
+        QGCTraceScope scope("test", "EventLoopMonitorTest::block");
+        QThread::msleep(_stallThresholdMsecs * 3);
+    }
+    
+    QVERIFY(stallSpy.wait(1000));
+    monitor->stop();
+    
+    QCOMPARE(monitor->stallCount(), (quint32)1);
+    QList<EventLoopMonitor::Stall_t> stalls = monitor->recentStalls();
+    QCOMPARE(stalls.count(), 1);
+    QVERIFY(stalls[0].durationMsecs > _stallThresholdMsecs);
+    QVERIFY(stalls[0].activity.contains("EventLoopMonitorTest::block"));
+    
+    // The stall must land in the histogram bucket which covers its duration
+    int bucket = 0;
+    while (EventLoopMonitor::histogramBucketUpperMsecs(bucket) != -1 && stalls[0].durationMsecs >= EventLoopMonitor::histogramBucketUpperMsecs(bucket)) {
+        bucket++;
+    }
+    QCOMPARE(monitor->histogramCount(bucket), 1);
+    
+    // Log should hold the stall and the summary written on stop
+    QVERIFY(logFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    QString log = QString::fromUtf8(logFile.readAll());
+    logFile.remove();
+    QVERIFY(log.contains("EventLoopMonitorTest::block"));
+    QVERIFY(log.contains("Summary"));
+}
@@ -0,0 +1,194 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "FactValueBenchmark.h"
+#include "QGCMAVLink.h"
+
+UT_REGISTER_TEST(FactValueBenchmark)
+
+void VariantFact::containerSetValue(const QVariant& value)
+{
+    _value = value;
+    emit valueChanged(_value);
+    emit vehicleUpdated(_value);
+}
+
+FactValueBenchmark::FactValueBenchmark(void)
+{
+    
+}
+
+void FactValueBenchmark::init(void)
+{
+    UnitTest::init();
+    
+    // Parameter set with the type mix of a typical vehicle: mostly float and int32 with a few of the smaller types
+    for (int i=0; i<_parameterCount; i++) {
+        ParamValue_t                param;
+        mavlink_param_union_t       paramUnion;
+        FactMetaData::ValueType_t   factType;
+        
+        paramUnion.param_uint32 = 0;
+        switch (i % 8) {
+            case 0:
+                factType = FactMetaData::valueTypeInt32;
+                param.mavType = MAV_PARAM_TYPE_INT32;
+                paramUnion.param_int32 = -i;
+                break;
+            case 1:
+                factType = FactMetaData::valueTypeUint8;
+                param.mavType = MAV_PARAM_TYPE_UINT8;
+                paramUnion.param_uint8 = i % 256;
+                break;
+            case 2:
+                factType = FactMetaData::valueTypeInt16;
+                param.mavType = MAV_PARAM_TYPE_INT16;
+                paramUnion.param_int16 = -i;
+                break;
+            default:
+                factType = FactMetaData::valueTypeFloat;
+                param.mavType = MAV_PARAM_TYPE_REAL32;
+                paramUnion.param_float = i * 0.5f;
+                break;
+        }
+        param.paramBits = paramUnion.param_uint32;
+        param.fact = new Fact(MAV_COMP_ID_ALL, QString("PARAM_%1").arg(i), factType, this);
+        param.variantFact = new VariantFact(this);
+        _params.append(param);
+    }
+}
+
+void FactValueBenchmark::cleanup(void)
+{
+    foreach (const ParamValue_t& param, _params) {
+        delete param.fact;
+        delete param.variantFact;
+    }
+    _params.clear();
+    
+    UnitTest::cleanup();
+}
+
+/// Builds the QVariant the same way PARAM_VALUE handling did before values were kept typed
+QVariant FactValueBenchmark::_paramBitsToVariant(int mavType, quint32 paramBits)
+{
+    mavlink_param_union_t paramUnion;
+    
+    paramUnion.param_uint32 = paramBits;
+    switch (mavType) {
+        case MAV_PARAM_TYPE_REAL32:
+            return QVariant(paramUnion.param_float);
+        case MAV_PARAM_TYPE_UINT8:
+            return QVariant(paramUnion.param_uint8);
+        case MAV_PARAM_TYPE_INT8:
+            return QVariant(paramUnion.param_int8);
+        case MAV_PARAM_TYPE_INT16:
+            return QVariant(paramUnion.param_int16);
+        case MAV_PARAM_TYPE_UINT32:
+            return QVariant(paramUnion.param_uint32);
+        default:
+            return QVariant(paramUnion.param_int32);
+    }
+}
+
+void FactValueBenchmark::_paramBits_test(void)
+{
+    foreach (const ParamValue_t& param, _params) {
+        FactValue value = FactValue::fromParamBits(param.fact->type(), param.paramBits);
+        
+        QCOMPARE(value.type(), param.fact->type());
+        QCOMPARE(value.paramBits(), param.paramBits);
+        QCOMPARE(value.toDouble(), _paramBitsToVariant(param.mavType, param.paramBits).toDouble());
+    }
+    
+    // Negative values of the smaller signed types must be sign extended on the way in and truncated on the way out
+    FactValue value = FactValue::fromInteger(FactMetaData::valueTypeInt8, -2);
+    QCOMPARE(value.paramBits() & 0xFF, (quint32)0xFE);
+    QCOMPARE(FactValue::fromParamBits(FactMetaData::valueTypeInt8, value.paramBits()).toDouble(), -2.0);
+    
+    // Types must match for values to be equal
+    QVERIFY(FactValue::fromInteger(FactMetaData::valueTypeInt32, 1) != FactValue::fromInteger(FactMetaData::valueTypeUint32, 1));
+    QVERIFY(FactValue::fromInteger(FactMetaData::valueTypeInt32, 1) == FactValue::fromDouble(FactMetaData::valueTypeInt32, 1.0));
+}
+
+void FactValueBenchmark::_fromString_test(void)
+{
+    bool convertOk;
+    
+    QCOMPARE(FactValue::fromString(FactMetaData::valueTypeUint16, "65535", &convertOk).toDouble(), 65535.0);
+    QVERIFY(convertOk);
+    QCOMPARE(FactValue::fromString(FactMetaData::valueTypeFloat, "1.5", &convertOk).toDouble(), 1.5);
+    QVERIFY(convertOk);
+    
+    FactValue::fromString(FactMetaData::valueTypeInt32, "1.5", &convertOk);
+    QVERIFY(!convertOk);
+    FactValue::fromString(FactMetaData::valueTypeUint8, "abc", &convertOk);
+    QVERIFY(!convertOk);
+}
+
+void FactValueBenchmark::_perFactMemory_test(void)
+{
+    QVERIFY(sizeof(FactValue) < sizeof(QVariant));
+    
+    // Meta data created by the Fact constructor must not outlive its replacement by shared meta data
+    FactMetaData* sharedMetaData = new FactMetaData(FactMetaData::valueTypeFloat, this);
+    Fact* fact = new Fact(MAV_COMP_ID_ALL, "SHARED", FactMetaData::valueTypeFloat, this);
+    
+    fact->setMetaData(sharedMetaData);
+    QCOMPARE(fact->findChildren<FactMetaData*>().count(), 0);
+    
+    delete fact;
+    delete sharedMetaData;
+}
+
+/// Baseline: parameter set ingestion as it was before values were kept typed. A QVariant is built for each PARAM_VALUE
+/// and stored as is.
+void FactValueBenchmark::_ingestBaseline_benchmark(void)
+{
+    QBENCHMARK {
+        foreach (const ParamValue_t& param, _params) {
+            param.variantFact->containerSetValue(_paramBitsToVariant(param.mavType, param.paramBits));
+        }
+    }
+}
+
+/// Parameter set ingestion through the QVariant based api: a QVariant is built for each PARAM_VALUE and converted
+/// to the Fact type
+void FactValueBenchmark::_ingestVariant_benchmark(void)
+{
+    QBENCHMARK {
+        foreach (const ParamValue_t& param, _params) {
+            param.fact->_containerSetValue(_paramBitsToVariant(param.mavType, param.paramBits));
+        }
+    }
+}
+
+/// Parameter set ingestion as done by ParameterLoader: the raw bits are decoded straight into the Fact type
+void FactValueBenchmark::_ingestRaw_benchmark(void)
+{
+    QBENCHMARK {
+        foreach (const ParamValue_t& param, _params) {
+            param.fact->_containerSetRawValue(FactValue::fromParamBits(param.fact->type(), param.paramBits));
+        }
+    }
+}
@@ -0,0 +1,86 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef FactValueBenchmark_H
+#define FactValueBenchmark_H
+
+#include "UnitTest.h"
+#include "FactSystem.h"
+
+/// @file
+///     @brief Checks FactValue conversions and measures ingestion of a full parameter set into Facts, comparing
+///             the QVariant based path against the typed FactValue path.
+
+/// Copy of the QVariant storage Fact used before values were kept typed. Only used as the benchmark baseline.
+class VariantFact : public QObject
+{
+    Q_OBJECT
+    
+public:
+    VariantFact(QObject* parent = NULL) : QObject(parent) { }
+    
+    /// Same as Fact::_containerSetValue before FactValue
+    void containerSetValue(const QVariant& value);
+    
+signals:
+    void valueChanged(QVariant value);
+    void vehicleUpdated(QVariant value);
+    
+private:
+    QVariant _value;
+};
+
+class FactValueBenchmark : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    FactValueBenchmark(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _paramBits_test(void);
+    void _fromString_test(void);
+    void _perFactMemory_test(void);
+    void _ingestBaseline_benchmark(void);
+    void _ingestVariant_benchmark(void);
+    void _ingestRaw_benchmark(void);
+    
+private:
+    typedef struct {
+        Fact*           fact;
+        VariantFact*    variantFact;
+        int             mavType;
+        quint32         paramBits;
+    } ParamValue_t;
+    
+    static QVariant _paramBitsToVariant(int mavType, quint32 paramBits);
+    
+    static const int _parameterCount = 1000;    ///< Roughly the size of a full PX4 parameter set
+    
+    QList<ParamValue_t> _params;
+};
+
+#endif
@@ -27,8 +27,11 @@
 #include "FileManagerTest.h"
 #include "MultiVehicleManager.h"
 #include "UAS.h"
+#include "FileSync.h"
 
-//UT_REGISTER_TEST(FileManagerTest)
+#include <QElapsedTimer>
+
+UT_REGISTER_TEST(FileManagerTest)
 
 FileManagerTest::FileManagerTest(void) :
     _mockLink(NULL),
@@ -116,22 +119,22 @@ void FileManagerTest::_ackTest(void)
     Q_ASSERT(_multiSpy->checkNoSignals() == true);
     
     // If the file manager doesn't receive an ack it will timeout and emit an error. So make sure
-    // we don't get any error signals.
+    // we don't get any error signals, even well after the ack timer would have fired.
     QVERIFY(_fileManager->_sendCmdTestAck());
-    QTest::qWait(_ackTimerTimeoutMsecs); // Let the file manager timeout
+    QTest::qWait(_ackTimerTimeoutMsecs);
     QVERIFY(_multiSpy->checkNoSignals());
     
     // Setup for no response from ack. This should cause a timeout error
     _fileServer->setErrorMode(MockLinkFileServer::errModeNoResponse);
     QVERIFY(_fileManager->_sendCmdTestAck());
-    _multiSpy->waitForSignalByIndex(commandErrorSignalIndex, _ackTimerTimeoutMsecs);
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandErrorSignalIndex, _ackTimerTimeoutMsecs));
     QCOMPARE(_multiSpy->checkOnlySignalByMask(commandErrorSignalMask), true);
     _multiSpy->clearAllSignals();
 
     // Setup for a bad sequence number in the ack. This should cause an error;
     _fileServer->setErrorMode(MockLinkFileServer::errModeBadSequence);
     QVERIFY(_fileManager->_sendCmdTestAck());
-    _multiSpy->waitForSignalByIndex(commandErrorSignalIndex, _ackTimerTimeoutMsecs);
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandErrorSignalIndex, _ackTimerTimeoutMsecs));
     QCOMPARE(_multiSpy->checkOnlySignalByMask(commandErrorSignalMask), true);
     _multiSpy->clearAllSignals();
 }
@@ -144,7 +147,7 @@ void FileManagerTest::_noAckTest(void)
     
     // This should not get the ack back and timeout.
     QVERIFY(_fileManager->_sendCmdTestNoAck());
-    QTest::qWait(_ackTimerTimeoutMsecs); // Let the file manager timeout
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandErrorSignalIndex, _ackTimerTimeoutMsecs));
     QCOMPARE(_multiSpy->checkOnlySignalByMask(commandErrorSignalMask), true);
 }
 
@@ -168,7 +171,7 @@ void FileManagerTest::_listTest(void)
     // Send a bogus path
     //  We should get a single commandError signal
     _fileManager->listDirectory("/bogus");
-    _multiSpy->waitForSignalByIndex(commandErrorSignalIndex, _ackTimerTimeoutMsecs);
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandErrorSignalIndex, _ackTimerTimeoutMsecs));
     QCOMPARE(_multiSpy->checkOnlySignalByMask(commandErrorSignalMask), true);
     _multiSpy->clearAllSignals();
 
@@ -179,7 +182,7 @@ void FileManagerTest::_listTest(void)
     
     // Send a list command at the root of the directory tree which should succeed
     _fileManager->listDirectory("/");
-    QTest::qWait(_ackTimerTimeoutMsecs); // Let the file manager timeout
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandCompleteSignalIndex, _ackTimerTimeoutMsecs));
     QCOMPARE(_multiSpy->checkSignalByMask(commandCompleteSignalMask), true);
     QCOMPARE(_multiSpy->checkNoSignalByMask(commandErrorSignalMask), true);
     QCOMPARE(_multiSpy->getSpyByIndex(listEntrySignalIndex)->count(), fileList.count());
@@ -196,7 +199,9 @@ void FileManagerTest::_listTest(void)
         _fileServer->setErrorMode(errMode);
         
         _fileManager->listDirectory("/");
-        QTest::qWait(_ackTimerTimeoutMsecs); // Let the file manager timeout
+        
+        // Every failure mode ends in an error, at the latest once the ack timer fires
+        QVERIFY(_multiSpy->waitForSignalByIndex(commandErrorSignalIndex, _ackTimerTimeoutMsecs));
         
         if (errMode == MockLinkFileServer::errModeNoSecondResponse || errMode == MockLinkFileServer::errModeNakSecondResponse) {
             // For simulated server errors on subsequent Acks, the first Ack will go through. This means we should have gotten some
@@ -220,6 +225,263 @@ void FileManagerTest::_listTest(void)
     }
 }
 
+void FileManagerTest::_burstLossDownloadTest(void)
+{
+    Q_ASSERT(_fileManager);
+    Q_ASSERT(_multiSpy);
+    Q_ASSERT(_multiSpy->checkNoSignals() == true);
+    
+    const char*     filename = "burst.bin";
+    const uint32_t  length = 256 * 1024;
+    
+    QDir downloadDir = QDir::temp();
+    QString filePath = downloadDir.absoluteFilePath(filename);
+    QFile::remove(filePath);
+    QFile::remove(filePath + ".partial");
+    QFile::remove(filePath + ".partial.state");
+    
+    // Lost and re-ordered burst packets must be filled in with reads
+    _fileServer->addSyntheticFile(filename, length);
+    _fileServer->setRandomSeed(1234);
+    _fileServer->setBurstLossPercent(5.0);
+    _fileServer->setBurstReorderPercent(5.0);
+    
+    _fileServer->clearReadByteCount();
+    _fileManager->streamPath(filename, downloadDir);
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandCompleteSignalIndex, 60000));
+    QCOMPARE(_multiSpy->checkNoSignalByMask(commandErrorSignalMask), true);
+    
+    _validateSyntheticFile(filePath, length);
+    QCOMPARE(QFile::exists(filePath + ".partial"), false);
+    
+    // Only the lost and re-ordered packets are read again, not the rest of the file after the first gap
+    QVERIFY(_fileServer->readByteCount() >= length);
+    QVERIFY(_fileServer->readByteCount() < length + length / 4);
+    
+    _fileServer->setBurstLossPercent(0.0);
+    _fileServer->setBurstReorderPercent(0.0);
+    _fileServer->clearFiles();
+}
+
+/// Starts a paced download and cancels it part way through, leaving the partial file and its state behind
+void FileManagerTest::_cancelPartialDownload(const QString& filename, const QDir& downloadDir)
+{
+    QString filePath = downloadDir.absoluteFilePath(filename);
+    QFile::remove(filePath);
+    QFile::remove(filePath + ".partial");
+    QFile::remove(filePath + ".partial.state");
+    
+    QSignalSpy progressSpy(_fileManager, SIGNAL(commandProgress(int)));
+    _fileManager->setDownloadRateLimit(8 * 1024);
+    _fileManager->downloadPath(filename, downloadDir);
+    
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while ((progressSpy.isEmpty() || progressSpy.last()[0].toInt() < 25) && elapsed.elapsed() < 10000) {
+        progressSpy.wait(1000);
+    }
+    QVERIFY(!progressSpy.isEmpty());
+    QVERIFY(progressSpy.last()[0].toInt() >= 25);
+    QVERIFY(progressSpy.last()[0].toInt() < 100);
+    
+    _fileManager->cancel();
+    _fileManager->setDownloadRateLimit(0);
+    
+    QCOMPARE(_multiSpy->checkNoSignalByMask(commandCompleteSignalMask | commandErrorSignalMask), true);
+    QCOMPARE(QFile::exists(filePath + ".partial"), true);
+    QCOMPARE(QFile::exists(filePath + ".partial.state"), true);
+    
+    // Let responses to the cancelled requests drain
+    QTest::qWait(500);
+    _multiSpy->clearAllSignals();
+}
+
+/// A cancelled download only reads the missing part of the file when it is started again
+void FileManagerTest::_resumeDownloadTest(void)
+{
+    Q_ASSERT(_fileManager);
+    Q_ASSERT(_multiSpy);
+    Q_ASSERT(_multiSpy->checkNoSignals() == true);
+    
+    const char*     filename = "resume.bin";
+    const uint32_t  length = 32 * 1024;
+    QDir            downloadDir = QDir::temp();
+    QString         filePath = downloadDir.absoluteFilePath(filename);
+    
+    _fileServer->addSyntheticFile(filename, length);
+    _cancelPartialDownload(filename, downloadDir);
+    
+    _fileServer->clearReadByteCount();
+    _fileManager->downloadPath(filename, downloadDir);
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandCompleteSignalIndex, 60000));
+    QCOMPARE(_multiSpy->checkNoSignalByMask(commandErrorSignalMask), true);
+    
+    _validateSyntheticFile(filePath, length);
+    QCOMPARE(QFile::exists(filePath + ".partial"), false);
+    QCOMPARE(QFile::exists(filePath + ".partial.state"), false);
+    
+    // At least a quarter of the file came from the first attempt
+    QVERIFY(_fileServer->readByteCount() > 0);
+    QVERIFY(_fileServer->readByteCount() <= (length * 3) / 4);
+    
+    _fileServer->clearFiles();
+}
+
+/// A file which was rewritten on the vehicle with the same size must not be resumed, the CRC32 differs
+void FileManagerTest::_resumeChangedFileTest(void)
+{
+    Q_ASSERT(_fileManager);
+    Q_ASSERT(_multiSpy);
+    Q_ASSERT(_multiSpy->checkNoSignals() == true);
+    
+    const char*     filename = "changed.bin";
+    const uint32_t  length = 32 * 1024;
+    QDir            downloadDir = QDir::temp();
+    QString         filePath = downloadDir.absoluteFilePath(filename);
+    
+    _fileServer->addSyntheticFile(filename, length);
+    _cancelPartialDownload(filename, downloadDir);
+    
+    QByteArray changedBytes;
+    for (uint32_t i=0; i<length; i++) {
+        changedBytes.append((char)MockLinkFileServer::fileByte(i * 3));
+    }
+    _fileServer->addFile(filename, changedBytes);
+    
+    _fileServer->clearReadByteCount();
+    _fileManager->downloadPath(filename, downloadDir);
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandCompleteSignalIndex, 60000));
+    QCOMPARE(_multiSpy->checkNoSignalByMask(commandErrorSignalMask), true);
+    
+    // The partial data from the old file was thrown away and the whole file was read again
+    QVERIFY(_fileServer->readByteCount() >= length);
+    
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll() == changedBytes);
+    file.close();
+    
+    _fileServer->clearFiles();
+}
+
+void FileManagerTest::_uploadTest(void)
+{
+    Q_ASSERT(_fileManager);
+    Q_ASSERT(_multiSpy);
+    Q_ASSERT(_multiSpy->checkNoSignals() == true);
+    
+    const uint32_t length = 64 * 1024 + 17;
+    
+    QByteArray bytes;
+    for (uint32_t i=0; i<length; i++) {
+        bytes.append((char)MockLinkFileServer::fileByte(i * 7));
+    }
+    
+    QString filePath = QDir::temp().absoluteFilePath("upload.bin");
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(bytes), (qint64)bytes.size());
+    file.close();
+    
+    _fileServer->clearWriteCounts();
+    _fileManager->uploadPath("/fs", QFileInfo(filePath));
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandCompleteSignalIndex, 60000));
+    QCOMPARE(_multiSpy->checkNoSignalByMask(commandErrorSignalMask), true);
+    
+    QVERIFY(_fileServer->uploadedFile("/fs/upload.bin") == bytes);
+    
+    // Nothing is lost, so every block is written exactly once
+    int packetCount = (length + MockLinkFileServer::packetDataSize - 1) / MockLinkFileServer::packetDataSize;
+    QCOMPARE(_fileServer->writeRequestCount(), packetCount);
+    
+    _fileServer->clearFiles();
+    QFile::remove(filePath);
+}
+
+/// Writes whose ack is lost are resent on their own, the rest of the window carries on
+void FileManagerTest::_uploadAckLossTest(void)
+{
+    Q_ASSERT(_fileManager);
+    Q_ASSERT(_multiSpy);
+    Q_ASSERT(_multiSpy->checkNoSignals() == true);
+    
+    const uint32_t length = 16 * 1024 + 5;
+    
+    QByteArray bytes;
+    for (uint32_t i=0; i<length; i++) {
+        bytes.append((char)MockLinkFileServer::fileByte(i * 5));
+    }
+    
+    QString filePath = QDir::temp().absoluteFilePath("uploadloss.bin");
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(bytes), (qint64)bytes.size());
+    file.close();
+    
+    _fileServer->setRandomSeed(4321);
+    _fileServer->setWriteAckLossPercent(5.0);
+    _fileServer->clearWriteCounts();
+    
+    _fileManager->uploadPath("/fs", QFileInfo(filePath));
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandCompleteSignalIndex, 60000));
+    QCOMPARE(_multiSpy->checkNoSignalByMask(commandErrorSignalMask), true);
+    
+    QVERIFY(_fileServer->uploadedFile("/fs/uploadloss.bin") == bytes);
+    
+    int packetCount = (length + MockLinkFileServer::packetDataSize - 1) / MockLinkFileServer::packetDataSize;
+    int resentCount = _fileServer->writeRequestCount() - packetCount;
+    QVERIFY(_fileServer->lostWriteAckCount() > 0);
+    QVERIFY(resentCount >= _fileServer->lostWriteAckCount());
+    QVERIFY(resentCount <= 2 * _fileServer->lostWriteAckCount());
+    
+    _fileServer->setWriteAckLossPercent(0.0);
+    _fileServer->clearFiles();
+    QFile::remove(filePath);
+}
+
+void FileManagerTest::_crc32Test(void)
+{
+    Q_ASSERT(_fileManager);
+    Q_ASSERT(_multiSpy);
+    Q_ASSERT(_multiSpy->checkNoSignals() == true);
+    
+    const uint32_t length = 100000;
+    
+    _fileServer->addSyntheticFile("/fs/crc.bin", length);
+    
+    QSignalSpy crcSpy(_fileManager, SIGNAL(fileCRC32(quint32)));
+    _fileManager->calcFileCRC32("/fs/crc.bin");
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandCompleteSignalIndex, _ackTimerTimeoutMsecs));
+    QCOMPARE(crcSpy.count(), 1);
+    QCOMPARE(crcSpy[0][0].toUInt(), MockLinkFileServer::syntheticFileCRC32(length));
+    
+    // The vehicle side CRC32 must match what FileSync calculates locally
+    QByteArray bytes;
+    for (uint32_t i=0; i<length; i++) {
+        bytes.append((char)MockLinkFileServer::fileByte(i));
+    }
+    QCOMPARE(FileSync::crc32(bytes.constData(), bytes.size()), MockLinkFileServer::syntheticFileCRC32(length));
+    
+    _fileServer->clearFiles();
+}
+
+void FileManagerTest::_validateSyntheticFile(const QString& filePath, uint32_t length)
+{
+    QFile file(filePath);
+    
+    QCOMPARE(file.size(), (qint64)length);
+    
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray bytes = file.readAll();
+    file.close();
+    
+    for (uint32_t i=0; i<length; i++) {
+        if ((uint8_t)bytes[i] != MockLinkFileServer::fileByte(i)) {
+            QFAIL(qPrintable(QString("Incorrect data at offset %1").arg(i)));
+        }
+    }
+}
+
 #if 0
 // Trying to write test code for read and burst mode download as well as implement support in MockLineFileServer reached a point
 // of diminishing returns where the test code and mock server were generating more bugs in themselves than finding problems.
@@ -53,12 +53,20 @@ private slots:
     void _ackTest(void);
     void _noAckTest(void);
     void _listTest(void);
+    void _burstLossDownloadTest(void);
+    void _resumeDownloadTest(void);
+    void _resumeChangedFileTest(void);
+    void _uploadTest(void);
+    void _uploadAckLossTest(void);
+    void _crc32Test(void);
 	
     // Connected to FileManager listEntry signal
     void listEntry(const QString& entry);
     
 private:
     void _validateFileContents(const QString& filePath, uint8_t length);
+    void _validateSyntheticFile(const QString& filePath, uint32_t length);
+    void _cancelPartialDownload(const QString& filename, const QDir& downloadDir);
 
     enum {
         listEntrySignalIndex = 0,
@@ -85,7 +93,8 @@ private:
     const char*         _rgSignals[_cSignals];
     
     /// @brief This is the amount of time to wait to allow the FileManager enough time to timeout waiting for an Ack.
-    /// As such it must be larger than the Ack Timeout used by the FileManager.
+    /// As such it must be larger than the Ack Timeout used by the FileManager. Tests wait on the expected signal with
+    /// this as the limit, so the margin only matters on a loaded machine.
     static const int _ackTimerTimeoutMsecs = FileManager::ackTimerTimeoutMsecs * 2;
     
     QStringList _fileListReceived;
@@ -0,0 +1,156 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "FileSyncTest.h"
+#include "FileSync.h"
+#include "MultiVehicleManager.h"
+#include "UAS.h"
+
+#include <QSignalSpy>
+
+UT_REGISTER_TEST(FileSyncTest)
+
+FileSyncTest::FileSyncTest(void)
+    : _mockLink(NULL)
+    , _fileServer(NULL)
+    , _fileManager(NULL)
+{
+    
+}
+
+void FileSyncTest::init(void)
+{
+    UnitTest::init();
+    
+    _mockLink = new MockLink();
+    Q_CHECK_PTR(_mockLink);
+    LinkManager::instance()->_addLink(_mockLink);
+    LinkManager::instance()->connectLink(_mockLink);
+    
+    _fileServer = _mockLink->getFileServer();
+    QVERIFY(_fileServer != NULL);
+    
+    MultiVehicleManager* vehicleManager = MultiVehicleManager::instance();
+    QSignalSpy spyVehicleCreate(vehicleManager, SIGNAL(activeVehicleChanged(Vehicle*)));
+    if (!vehicleManager->activeVehicle()) {
+        QCOMPARE(spyVehicleCreate.wait(10000), true);
+    }
+    
+    _fileManager = vehicleManager->activeVehicle()->uas()->getFileManager();
+    QVERIFY(_fileManager != NULL);
+}
+
+void FileSyncTest::cleanup(void)
+{
+    // Disconnecting the link will prompt for log file save
+    setExpectedFileDialog(getSaveFileName, QStringList());
+    LinkManager::instance()->disconnectLink(_mockLink);
+    _fileServer = NULL;
+    _mockLink = NULL;
+    _fileManager = NULL;
+    
+    UnitTest::cleanup();
+}
+
+/// Contents which differ for each seed, so a changed file has the same length but different bytes
+QByteArray FileSyncTest::_fileData(int length, int seed)
+{
+    QByteArray data;
+    
+    for (int i=0; i<length; i++) {
+        data.append((char)((i * 7 + seed) & 0xFF));
+    }
+    
+    return data;
+}
+
+void FileSyncTest::_writeLocalFile(const QString& path, const QByteArray& data)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(data), (qint64)data.size());
+}
+
+/// An unchanged file is skipped by its CRC32, a changed file and a missing file are downloaded over concurrent sessions
+void FileSyncTest::_sync_test(void)
+{
+    QByteArray unchangedData = _fileData(1000, 1);
+    QByteArray changedData = _fileData(1500, 2);
+    QByteArray missingData = _fileData(2000, 3);
+    
+    _fileServer->addFile("/unchanged.bin", unchangedData);
+    _fileServer->addFile("/changed.bin", changedData);
+    _fileServer->addFile("/missing.bin", missingData);
+    
+    QStringList fileList;
+    fileList << QString("Funchanged.bin\t%1").arg(unchangedData.size());
+    fileList << QString("Fchanged.bin\t%1").arg(changedData.size());
+    fileList << QString("Fmissing.bin\t%1").arg(missingData.size());
+    _fileServer->setFileList(fileList);
+    
+    QDir localDir(QDir::temp().absoluteFilePath("FileSyncTest"));
+    localDir.removeRecursively();
+    QVERIFY(QDir().mkpath(localDir.absolutePath()));
+    
+    // The local copy of changed.bin has the right size, so only the CRC32 shows the difference
+    _writeLocalFile(localDir.absoluteFilePath("unchanged.bin"), unchangedData);
+    _writeLocalFile(localDir.absoluteFilePath("changed.bin"), _fileData(changedData.size(), 4));
+    
+    FileSync fileSync(_fileManager);
+    QSignalSpy spyComplete(&fileSync, SIGNAL(complete(int, int)));
+    QSignalSpy spyError(&fileSync, SIGNAL(error(const QString&)));
+    QSignalSpy spySkipped(&fileSync, SIGNAL(fileSkipped(const QString&)));
+    QSignalSpy spyDownloaded(&fileSync, SIGNAL(fileDownloaded(const QString&)));
+    
+    _fileServer->clearReadByteCount();
+    _fileServer->clearMaxOpenSessionCount();
+    _fileServer->clearCRC32RequestCount();
+    
+    fileSync.sync("/", localDir);
+    QCOMPARE(spyComplete.wait(10000), true);
+    QCOMPARE(spyError.count(), 0);
+    
+    QCOMPARE(spyComplete[0][0].toInt(), 2);
+    QCOMPARE(spyComplete[0][1].toInt(), 1);
+    QCOMPARE(spySkipped.count(), 1);
+    QCOMPARE(spySkipped[0][0].toString(), QString("/unchanged.bin"));
+    QCOMPARE(spyDownloaded.count(), 2);
+    
+    // Nothing was read for the unchanged file and both downloads were running at the same time
+    QCOMPARE(_fileServer->readByteCount(), (uint32_t)(changedData.size() + missingData.size()));
+    QCOMPARE(_fileServer->maxOpenSessionCount(), FileSync::maxDownloadSessions);
+    
+    // One CRC32 for each file checked, the download of the changed file reuses it. Only the missing file needs
+    // one calculated when its download starts.
+    QCOMPARE(_fileServer->crc32RequestCount(), 3);
+    
+    QFile changedFile(localDir.absoluteFilePath("changed.bin"));
+    QVERIFY(changedFile.open(QIODevice::ReadOnly));
+    QVERIFY(changedFile.readAll() == changedData);
+    
+    QFile missingFile(localDir.absoluteFilePath("missing.bin"));
+    QVERIFY(missingFile.open(QIODevice::ReadOnly));
+    QVERIFY(missingFile.readAll() == missingData);
+    
+    localDir.removeRecursively();
+}
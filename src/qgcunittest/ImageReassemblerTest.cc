@@ -0,0 +1,229 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "ImageReassemblerTest.h"
+
+#include <QBuffer>
+#include <QSignalSpy>
+
+UT_REGISTER_TEST(ImageReassemblerTest)
+
+ImageReassemblerTest::ImageReassemblerTest(void)
+    : _reassembler(NULL)
+{
+    
+}
+
+void ImageReassemblerTest::init(void)
+{
+    UnitTest::init();
+    
+    _createImage();
+    _requests.clear();
+    _reassembler = new ImageReassembler(this);
+    connect(_reassembler, &ImageReassembler::requestPackets, this, &ImageReassemblerTest::_requestPackets);
+}
+
+void ImageReassemblerTest::cleanup(void)
+{
+    delete _reassembler;
+    _reassembler = NULL;
+    
+    UnitTest::cleanup();
+}
+
+void ImageReassemblerTest::_requestPackets(int sysid, int compid, const mavlink_data_transmission_handshake_t& request)
+{
+    Request_t entry;
+    
+    entry.sysid = sysid;
+    entry.compid = compid;
+    entry.request = request;
+    _requests.append(entry);
+}
+
+/// Creates a test pattern large enough to need a few dozen packets
+void ImageReassemblerTest::_createImage(void)
+{
+    _image = QImage(64, 48, QImage::Format_RGB32);
+    for (int y=0; y<_image.height(); y++) {
+        for (int x=0; x<_image.width(); x++) {
+            _image.setPixel(x, y, qRgb(x * 4, y * 5, (x * y) & 0xFF));
+        }
+    }
+    
+    QBuffer buffer(&_imageBytes);
+    buffer.open(QIODevice::WriteOnly);
+    _image.save(&buffer, "PNG");
+}
+
+int ImageReassemblerTest::_packetCount(void)
+{
+    return (_imageBytes.size() + _payload - 1) / _payload;
+}
+
+mavlink_data_transmission_handshake_t ImageReassemblerTest::_handshake(void)
+{
+    mavlink_data_transmission_handshake_t handshake;
+    
+    memset(&handshake, 0, sizeof(handshake));
+    handshake.type = MAVLINK_DATA_STREAM_IMG_PNG;
+    handshake.size = _imageBytes.size();
+    handshake.width = _image.width();
+    handshake.height = _image.height();
+    handshake.packets = _packetCount();
+    handshake.payload = _payload;
+    handshake.jpg_quality = 100;
+    
+    return handshake;
+}
+
+void ImageReassemblerTest::_sendPacket(int sysid, int compid, int seq)
+{
+    mavlink_encapsulated_data_t data;
+    
+    memset(&data, 0, sizeof(data));
+    data.seqnr = seq;
+    QByteArray chunk = _imageBytes.mid(seq * _payload, _payload);
+    memcpy(data.data, chunk.constData(), chunk.size());
+    
+    _reassembler->dataReceived(sysid, compid, data);
+}
+
+void ImageReassemblerTest::_verifyDecoded(int sysid, int compid)
+{
+    QSignalSpy spyDecoded(_reassembler, SIGNAL(imageDecoded(int, int, QImage)));
+    
+    QVERIFY(spyDecoded.wait(5000));
+    QCOMPARE(spyDecoded.count(), 1);
+    
+    QList<QVariant> arguments = spyDecoded.takeFirst();
+    QCOMPARE(arguments[0].toInt(), sysid);
+    QCOMPARE(arguments[1].toInt(), compid);
+    
+    QImage decoded = arguments[2].value<QImage>();
+    QCOMPARE(decoded.size(), _image.size());
+    QCOMPARE(decoded.convertToFormat(QImage::Format_RGB32), _image);
+}
+
+/// Packets in reverse order must produce the same image
+void ImageReassemblerTest::_outOfOrder_test(void)
+{
+    QVERIFY(_packetCount() > 10);
+    
+    _reassembler->handshakeReceived(1, 100, _handshake());
+    for (int seq=_packetCount() - 1; seq>=0; seq--) {
+        _sendPacket(1, 100, seq);
+        // Duplicates must be ignored
+        _sendPacket(1, 100, seq);
+    }
+    QCOMPARE(_reassembler->activeTransferCount(), 0);
+    
+    _verifyDecoded(1, 100);
+}
+
+/// Lost packets must be re-requested as runs once the transfer stalls
+void ImageReassemblerTest::_rerequestGaps_test(void)
+{
+    int lastSeq = _packetCount() - 1;
+    
+    _reassembler->handshakeReceived(1, 100, _handshake());
+    for (int seq=0; seq<=lastSeq; seq++) {
+        if (seq != 2 && seq != 3 && seq != 7 && seq != lastSeq) {
+            _sendPacket(1, 100, seq);
+        }
+    }
+    QCOMPARE(_reassembler->packetsReceived(1, 100), lastSeq - 3);
+    
+    QTest::qWait(ImageReassembler::gapTimeoutMsecs * 2);
+    
+    QVERIFY(_requests.count() >= 3);
+    QCOMPARE(_requests[0].sysid, 1);
+    QCOMPARE(_requests[0].compid, 100);
+    QCOMPARE((int)_requests[0].request.size, 2);
+    QCOMPARE((int)_requests[0].request.packets, 2);
+    QCOMPARE((int)_requests[1].request.size, 7);
+    QCOMPARE((int)_requests[1].request.packets, 1);
+    QCOMPARE((int)_requests[2].request.size, lastSeq);
+    QCOMPARE((int)_requests[2].request.packets, 1);
+    QCOMPARE((int)_requests[0].request.type, (int)MAVLINK_DATA_STREAM_IMG_PNG);
+    
+    // Answer the re-requests
+    for (int i=0; i<3; i++) {
+        for (int seq=_requests[i].request.size; seq<(int)(_requests[i].request.size + _requests[i].request.packets); seq++) {
+            _sendPacket(1, 100, seq);
+        }
+    }
+    
+    _verifyDecoded(1, 100);
+}
+
+/// A repeated handshake for the same image must keep the packets which already arrived
+void ImageReassemblerTest::_resume_test(void)
+{
+    int half = _packetCount() / 2;
+    
+    _reassembler->handshakeReceived(1, 100, _handshake());
+    for (int seq=0; seq<half; seq++) {
+        _sendPacket(1, 100, seq);
+    }
+    
+    _reassembler->handshakeReceived(1, 100, _handshake());
+    QCOMPARE(_reassembler->packetsReceived(1, 100), half);
+    
+    // A different image restarts the transfer
+    mavlink_data_transmission_handshake_t otherImage = _handshake();
+    otherImage.width++;
+    _reassembler->handshakeReceived(1, 100, otherImage);
+    QCOMPARE(_reassembler->packetsReceived(1, 100), 0);
+    
+    _reassembler->handshakeReceived(1, 100, _handshake());
+    for (int seq=0; seq<_packetCount(); seq++) {
+        _sendPacket(1, 100, seq);
+    }
+    
+    _verifyDecoded(1, 100);
+}
+
+/// Transfers from different components must not interfere
+void ImageReassemblerTest::_concurrentTransfers_test(void)
+{
+    _reassembler->handshakeReceived(1, 100, _handshake());
+    _reassembler->handshakeReceived(1, 101, _handshake());
+    QCOMPARE(_reassembler->activeTransferCount(), 2);
+    
+    // Interleave the two transfers
+    for (int seq=0; seq<_packetCount() - 1; seq++) {
+        _sendPacket(1, 100, seq);
+        _sendPacket(1, 101, seq);
+    }
+    QCOMPARE(_reassembler->activeTransferCount(), 2);
+    
+    _sendPacket(1, 101, _packetCount() - 1);
+    QCOMPARE(_reassembler->activeTransferCount(), 1);
+    _verifyDecoded(1, 101);
+    
+    QCOMPARE(_reassembler->packetsReceived(1, 100), _packetCount() - 1);
+    _sendPacket(1, 100, _packetCount() - 1);
+    _verifyDecoded(1, 100);
+}
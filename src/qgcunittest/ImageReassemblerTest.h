@@ -0,0 +1,73 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef ImageReassemblerTest_H
+#define ImageReassemblerTest_H
+
+#include "UnitTest.h"
+#include "ImageReassembler.h"
+
+/// @file
+///     @brief ImageReassembler unit test
+
+class ImageReassemblerTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    ImageReassemblerTest(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _outOfOrder_test(void);
+    void _rerequestGaps_test(void);
+    void _resume_test(void);
+    void _concurrentTransfers_test(void);
+    
+    // Connected to ImageReassembler::requestPackets
+    void _requestPackets(int sysid, int compid, const mavlink_data_transmission_handshake_t& request);
+    
+private:
+    void _createImage(void);
+    mavlink_data_transmission_handshake_t _handshake(void);
+    void _sendPacket(int sysid, int compid, int seq);
+    int _packetCount(void);
+    void _verifyDecoded(int sysid, int compid);
+    
+    typedef struct {
+        int                                     sysid;
+        int                                     compid;
+        mavlink_data_transmission_handshake_t   request;
+    } Request_t;
+    
+    static const int _payload = 100;
+    
+    ImageReassembler*   _reassembler;
+    QImage              _image;
+    QByteArray          _imageBytes;    ///< _image encoded as png
+    QList<Request_t>    _requests;
+};
+
+#endif
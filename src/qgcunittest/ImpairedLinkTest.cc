@@ -0,0 +1,465 @@
+/*=====================================================================
+ 
+ QGroundControl Open Source Ground Control Station
+ 
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ 
+ This file is part of the QGROUNDCONTROL project
+ 
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+ 
+ ======================================================================*/
+
+#include "ImpairedLinkTest.h"
+#include "LinkManager.h"
+#include "MockLink.h"
+#include "MultiVehicleManager.h"
+#include "MissionManager.h"
+#include "MissionItem.h"
+#include "QmlObjectListModel.h"
+#include "FileManager.h"
+#include "UAS.h"
+
+#include <QElapsedTimer>
+#include <QDir>
+
+#include <string.h>
+
+UT_REGISTER_TEST(ImpairedLinkTest)
+
+//                                                              name                latency jitter  bandwidth   loss    burst   burstLen    dup     reorder
+const ImpairedLinkTest::Profile_t ImpairedLinkTest::_perfectLinkProfile =       { "Perfect link",       0,      0,      0,          0.0,    0.0,    1,          0.0,    0.0 };
+const ImpairedLinkTest::Profile_t ImpairedLinkTest::_telemetryRadioProfile =    { "Telemetry radio",    50,     20,     57600,      0.0,    0.0,    1,          0.0,    0.0 };
+const ImpairedLinkTest::Profile_t ImpairedLinkTest::_lossyRadioProfile =        { "Lossy radio",        50,     20,     57600,      2.0,    0.5,    5,          1.0,    1.0 };
+const ImpairedLinkTest::Profile_t ImpairedLinkTest::_lossProfile =              { "Loss",               0,      0,      0,          10.0,   0.0,    1,          0.0,    0.0 };
+const ImpairedLinkTest::Profile_t ImpairedLinkTest::_burstLossProfile =         { "Burst loss",         0,      0,      0,          0.0,    1.0,    5,          0.0,    0.0 };
+const ImpairedLinkTest::Profile_t ImpairedLinkTest::_duplicateProfile =         { "Duplicate",          0,      0,      0,          0.0,    0.0,    1,          5.0,    0.0 };
+const ImpairedLinkTest::Profile_t ImpairedLinkTest::_reorderProfile =           { "Reorder",            50,     20,     0,          0.0,    0.0,    1,          0.0,    5.0 };
+
+/// Profiles the protocol benchmarks are run through
+const ImpairedLinkTest::Profile_t* ImpairedLinkTest::_rgBenchmarkProfiles[] = {
+    &ImpairedLinkTest::_perfectLinkProfile,
+    &ImpairedLinkTest::_telemetryRadioProfile,
+    &ImpairedLinkTest::_lossyRadioProfile,
+};
+
+ImpairedLinkTest::ImpairedLinkTest(void)
+    : _config(NULL)
+    , _link(NULL)
+    , _vehicle(NULL)
+{
+    
+}
+
+void ImpairedLinkTest::init(void)
+{
+    UnitTest::init();
+}
+
+void ImpairedLinkTest::cleanup(void)
+{
+    if (_link) {
+        LinkManager::instance()->disconnectLink(_link);
+        _link = NULL;
+        _vehicle = NULL;
+        QTest::qWait(1000); // Need to allow signals to move between threads
+    }
+    
+    delete _config;
+    _config = NULL;
+    
+    UnitTest::cleanup();
+}
+
+ImpairedLinkConfiguration* ImpairedLinkTest::_createConfig(const Profile_t& profile)
+{
+    ImpairedLinkConfiguration* config = new ImpairedLinkConfiguration(profile.name);
+    
+    config->setLatencyMsecs(profile.latencyMsecs);
+    config->setJitterMsecs(profile.jitterMsecs);
+    config->setBandwidthBitsPerSecond(profile.bandwidthBitsPerSecond);
+    config->setLossPercent(profile.lossPercent);
+    config->setBurstLossStartPercent(profile.burstLossStartPercent);
+    config->setBurstLossLength(profile.burstLossLength);
+    config->setDuplicatePercent(profile.duplicatePercent);
+    config->setReorderPercent(profile.reorderPercent);
+    
+    return config;
+}
+
+/// Runs _profilePacketCount back to back mavlink packets, 10 msecs apart, through the link profile without
+/// connecting the link
+void ImpairedLinkTest::_runProfile(const Profile_t& profile, quint32 seed, QList<ImpairedLink::Fate_t>& fates)
+{
+    _config = _createConfig(profile);
+    _config->setSeed(seed);
+    
+    ImpairedLink* link = new ImpairedLink(_config, new MockLink());
+    ImpairedLink::Direction_t direction;
+    memset(&direction, 0, sizeof(direction));
+    
+    fates.clear();
+    for (int i=0; i<_profilePacketCount; i++) {
+        fates.append(link->_packetFate(direction, i * 10, _profilePacketBytes, true));
+    }
+    
+    delete link;
+    delete _config;
+    _config = NULL;
+}
+
+/// The same seed gives the same fate to every packet, a different seed does not
+void ImpairedLinkTest::_determinism_test(void)
+{
+    QList<ImpairedLink::Fate_t> fates1;
+    QList<ImpairedLink::Fate_t> fates2;
+    QList<ImpairedLink::Fate_t> fates3;
+    
+    _runProfile(_lossyRadioProfile, 1234, fates1);
+    _runProfile(_lossyRadioProfile, 1234, fates2);
+    _runProfile(_lossyRadioProfile, 4321, fates3);
+    
+    bool seedDiffers = false;
+    for (int i=0; i<_profilePacketCount; i++) {
+        QCOMPARE(fates1[i].lost, fates2[i].lost);
+        QCOMPARE(fates1[i].duplicated, fates2[i].duplicated);
+        QCOMPARE(fates1[i].reordered, fates2[i].reordered);
+        if (!fates1[i].lost) {
+            QCOMPARE(fates1[i].deliveryMsecs, fates2[i].deliveryMsecs);
+        }
+        
+        if (fates1[i].lost != fates3[i].lost || fates1[i].duplicated != fates3[i].duplicated || fates1[i].reordered != fates3[i].reordered) {
+            seedDiffers = true;
+        }
+    }
+    QVERIFY(seedDiffers);
+}
+
+/// Random loss drops the profile percentage of packets and nothing else happens to them
+void ImpairedLinkTest::_loss_test(void)
+{
+    QList<ImpairedLink::Fate_t> fates;
+    int lost = 0;
+    
+    _runProfile(_lossProfile, 1, fates);
+    foreach (const ImpairedLink::Fate_t& fate, fates) {
+        QCOMPARE(fate.duplicated, false);
+        QCOMPARE(fate.reordered, false);
+        if (fate.lost) {
+            lost++;
+        }
+    }
+    
+    QVERIFY(_percentOf(lost) >= 9 && _percentOf(lost) <= 11);
+}
+
+/// Burst loss drops runs of packets with the profile mean length
+void ImpairedLinkTest::_burstLoss_test(void)
+{
+    QList<ImpairedLink::Fate_t> fates;
+    int lost = 0;
+    int bursts = 0;
+    
+    _runProfile(_burstLossProfile, 1, fates);
+    for (int i=0; i<fates.count(); i++) {
+        if (fates[i].lost) {
+            lost++;
+            if (i == 0 || !fates[i - 1].lost) {
+                bursts++;
+            }
+        }
+    }
+    
+    // A burst starts on 1% of packets and lasts 5 packets on average
+    QVERIFY(bursts > 100);
+    double meanBurstLength = (double)lost / bursts;
+    QVERIFY(meanBurstLength > 3.5 && meanBurstLength < 6.5);
+}
+
+/// Duplication doubles the profile percentage of packets
+void ImpairedLinkTest::_duplicate_test(void)
+{
+    QList<ImpairedLink::Fate_t> fates;
+    int duplicated = 0;
+    
+    _runProfile(_duplicateProfile, 1, fates);
+    foreach (const ImpairedLink::Fate_t& fate, fates) {
+        QCOMPARE(fate.lost, false);
+        QCOMPARE(fate.reordered, false);
+        if (fate.duplicated) {
+            duplicated++;
+        }
+    }
+    
+    QVERIFY(_percentOf(duplicated) >= 4 && _percentOf(duplicated) <= 6);
+}
+
+/// Re-ordering holds back the profile percentage of packets, jitter alone never re-orders
+void ImpairedLinkTest::_reorder_test(void)
+{
+    QList<ImpairedLink::Fate_t> fates;
+    int reordered = 0;
+    qint64 lastDeliveryMsecs = 0;
+    
+    _runProfile(_reorderProfile, 1, fates);
+    for (int i=0; i<fates.count(); i++) {
+        const ImpairedLink::Fate_t& fate = fates[i];
+        
+        QCOMPARE(fate.lost, false);
+        QVERIFY(fate.deliveryMsecs >= i * 10 + _reorderProfile.latencyMsecs);
+        if (fate.reordered) {
+            reordered++;
+            // Held back beyond any in order packet sent at the same time
+            QVERIFY(fate.deliveryMsecs > i * 10 + _reorderProfile.latencyMsecs + _reorderProfile.jitterMsecs);
+        } else {
+            QVERIFY(fate.deliveryMsecs >= lastDeliveryMsecs);
+            lastDeliveryMsecs = fate.deliveryMsecs;
+        }
+    }
+    
+    QVERIFY(_percentOf(reordered) >= 4 && _percentOf(reordered) <= 6);
+}
+
+/// Adds a row for each benchmark profile
+void ImpairedLinkTest::_profileData(void)
+{
+    QTest::addColumn<int>("profileIndex");
+    
+    for (size_t i=0; i<sizeof(_rgBenchmarkProfiles)/sizeof(_rgBenchmarkProfiles[0]); i++) {
+        QTest::newRow(_rgBenchmarkProfiles[i]->name) << (int)i;
+    }
+}
+
+/// Connects to a MockLink through the link profile of the current data row and waits for the full parameter set
+/// and the initial mission load
+///     @param parameterLoadMsecs Returned: Time from connect until the parameters were ready
+void ImpairedLinkTest::_connectVehicle(qint64* parameterLoadMsecs)
+{
+    QFETCH(int, profileIndex);
+    const Profile_t& profile = *_rgBenchmarkProfiles[profileIndex];
+    
+    _config = _createConfig(profile);
+    
+    _link = new ImpairedLink(_config, new MockLink());
+    Q_CHECK_PTR(_link);
+    LinkManager::instance()->_addLink(_link);
+    
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+    
+    LinkManager::instance()->connectLink(_link);
+    
+    MultiVehicleManager* vehicleMgr = MultiVehicleManager::instance();
+    QSignalSpy spyParameterReady(vehicleMgr, SIGNAL(parameterReadyVehicleAvailableChanged(bool)));
+    while (!vehicleMgr->parameterReadyVehicleAvailable() && loadTimer.elapsed() < _parameterLoadTimeoutMsecs) {
+        spyParameterReady.wait(_parameterLoadTimeoutMsecs - loadTimer.elapsed());
+    }
+    QVERIFY(vehicleMgr->parameterReadyVehicleAvailable());
+    if (parameterLoadMsecs) {
+        *parameterLoadMsecs = loadTimer.elapsed();
+    }
+    
+    _vehicle = vehicleMgr->activeVehicle();
+    QVERIFY(_vehicle);
+    _waitForMissionManager();
+}
+
+/// Waits for the running mission transaction, if any, to finish
+void ImpairedLinkTest::_waitForMissionManager(void)
+{
+    MissionManager* missionManager = _vehicle->missionManager();
+    
+    if (missionManager->inProgress()) {
+        QSignalSpy spyInProgress(missionManager, SIGNAL(inProgressChanged(bool)));
+        QVERIFY(spyInProgress.wait(_missionTimeoutMsecs));
+    }
+    QVERIFY(!missionManager->inProgress());
+}
+
+/// Checks the link statistics against the impairments of the current data row's profile
+void ImpairedLinkTest::_checkImpairments(const Profile_t& profile)
+{
+    ImpairedLink::Statistics_t uplink = _link->uplinkStatistics();
+    ImpairedLink::Statistics_t downlink = _link->downlinkStatistics();
+    
+    QVERIFY(uplink.packets > 0);
+    QVERIFY(downlink.packets > 0);
+    QVERIFY(downlink.bytes > 0);
+    
+    if (profile.lossPercent == 0.0 && profile.burstLossStartPercent == 0.0) {
+        QCOMPARE(uplink.dropped, (quint32)0);
+        QCOMPARE(downlink.dropped, (quint32)0);
+    } else {
+        // The parameter stream is hundreds of packets, enough for every impairment to show up
+        QVERIFY(downlink.dropped > 0);
+    }
+    if (profile.duplicatePercent == 0.0) {
+        QCOMPARE(uplink.duplicated, (quint32)0);
+        QCOMPARE(downlink.duplicated, (quint32)0);
+    } else {
+        QVERIFY(downlink.duplicated > 0);
+    }
+    if (profile.reorderPercent == 0.0) {
+        QCOMPARE(uplink.reordered, (quint32)0);
+        QCOMPARE(downlink.reordered, (quint32)0);
+    } else {
+        QVERIFY(downlink.reordered > 0);
+    }
+    QVERIFY(downlink.dropped < downlink.packets);
+}
+
+/// Writes _missionItemCount waypoints to the vehicle and waits for the write to complete
+void ImpairedLinkTest::_writeMission(void)
+{
+    MissionManager* missionManager = _vehicle->missionManager();
+    QmlObjectListModel* list = new QmlObjectListModel(this);
+    
+    for (int i=0; i<_missionItemCount; i++) {
+        MissionItem* item = new MissionItem(list);
+        
+        QString itemString = QString("%1\t0\t3\t16\t0\t0\t0\t0\t%2\t8.545\t50\t1\r\n").arg(i).arg(47.397 + i * 0.001, 0, 'f', 6);
+        QTextStream loadStream(&itemString, QIODevice::ReadOnly);
+        QVERIFY(item->load(loadStream));
+        list->append(item);
+    }
+    
+    QSignalSpy spyError(missionManager, SIGNAL(error(int, const QString&)));
+    QSignalSpy spyInProgress(missionManager, SIGNAL(inProgressChanged(bool)));
+    
+    missionManager->writeMissionItems(*list);
+    while (missionManager->inProgress()) {
+        QVERIFY(spyInProgress.wait(_missionTimeoutMsecs));
+    }
+    QCOMPARE(spyError.count(), 0);
+    
+    delete list;
+}
+
+void ImpairedLinkTest::_parameterLoad_benchmark_data(void)
+{
+    _profileData();
+}
+
+/// Time from connect until the full parameter set is loaded
+void ImpairedLinkTest::_parameterLoad_benchmark(void)
+{
+    QFETCH(int, profileIndex);
+    qint64 parameterLoadMsecs = 0;
+    
+    _connectVehicle(&parameterLoadMsecs);
+    QVERIFY(_vehicle);
+    _checkImpairments(*_rgBenchmarkProfiles[profileIndex]);
+    
+    QTest::setBenchmarkResult(parameterLoadMsecs, QTest::WalltimeMilliseconds);
+}
+
+void ImpairedLinkTest::_missionUpload_benchmark_data(void)
+{
+    _profileData();
+}
+
+/// Time to write _missionItemCount waypoints to the vehicle
+void ImpairedLinkTest::_missionUpload_benchmark(void)
+{
+    _connectVehicle(NULL);
+    QVERIFY(_vehicle);
+    
+    QElapsedTimer timer;
+    timer.start();
+    _writeMission();
+    qint64 elapsedMsecs = timer.elapsed();
+    
+    QCOMPARE(_vehicle->missionManager()->missionItems()->count(), (int)_missionItemCount);
+    
+    QTest::setBenchmarkResult(elapsedMsecs, QTest::WalltimeMilliseconds);
+}
+
+void ImpairedLinkTest::_missionDownload_benchmark_data(void)
+{
+    _profileData();
+}
+
+/// Time to read _missionItemCount waypoints back from the vehicle
+void ImpairedLinkTest::_missionDownload_benchmark(void)
+{
+    _connectVehicle(NULL);
+    QVERIFY(_vehicle);
+    _writeMission();
+    
+    MissionManager* missionManager = _vehicle->missionManager();
+    QSignalSpy spyError(missionManager, SIGNAL(error(int, const QString&)));
+    QSignalSpy spyInProgress(missionManager, SIGNAL(inProgressChanged(bool)));
+    
+    QElapsedTimer timer;
+    timer.start();
+    missionManager->requestMissionItems();
+    while (missionManager->inProgress()) {
+        QVERIFY(spyInProgress.wait(_missionTimeoutMsecs));
+    }
+    qint64 elapsedMsecs = timer.elapsed();
+    
+    QCOMPARE(spyError.count(), 0);
+    QCOMPARE(missionManager->missionItems()->count(), (int)_missionItemCount);
+    
+    QTest::setBenchmarkResult(elapsedMsecs, QTest::WalltimeMilliseconds);
+}
+
+void ImpairedLinkTest::_ftpDownload_benchmark_data(void)
+{
+    _profileData();
+}
+
+/// Time to download a _ftpFileBytes file from the vehicle over FTP
+void ImpairedLinkTest::_ftpDownload_benchmark(void)
+{
+    _connectVehicle(NULL);
+    QVERIFY(_vehicle);
+    
+    MockLink* mockLink = qobject_cast<MockLink*>(_link->innerLink());
+    QVERIFY(mockLink);
+    
+    QByteArray fileData;
+    for (int i=0; i<_ftpFileBytes; i++) {
+        fileData.append((char)((i * 7) & 0xFF));
+    }
+    mockLink->getFileServer()->addFile("/benchmark.bin", fileData);
+    
+    QDir downloadDir(QDir::temp().absoluteFilePath("ImpairedLinkTest"));
+    downloadDir.removeRecursively();
+    QVERIFY(QDir().mkpath(downloadDir.absolutePath()));
+    
+    FileManager* fileManager = _vehicle->uas()->getFileManager();
+    QVERIFY(fileManager);
+    QSignalSpy spyComplete(fileManager, SIGNAL(commandComplete()));
+    QSignalSpy spyError(fileManager, SIGNAL(commandError(const QString&)));
+    
+    QElapsedTimer timer;
+    timer.start();
+    fileManager->downloadPath("/benchmark.bin", downloadDir);
+    while (spyComplete.count() == 0 && spyError.count() == 0 && timer.elapsed() < _ftpTimeoutMsecs) {
+        spyComplete.wait(_ftpTimeoutMsecs - timer.elapsed());
+    }
+    qint64 elapsedMsecs = timer.elapsed();
+    
+    QCOMPARE(spyError.count(), 0);
+    QCOMPARE(spyComplete.count(), 1);
+    
+    QFile downloadFile(downloadDir.absoluteFilePath("benchmark.bin"));
+    QVERIFY(downloadFile.open(QIODevice::ReadOnly));
+    QVERIFY(downloadFile.readAll() == fileData);
+    downloadFile.close();
+    downloadDir.removeRecursively();
+    
+    QTest::setBenchmarkResult(elapsedMsecs, QTest::WalltimeMilliseconds);
+}
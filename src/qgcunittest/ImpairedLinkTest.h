@@ -0,0 +1,105 @@
+/*=====================================================================
+ 
+ QGroundControl Open Source Ground Control Station
+ 
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ 
+ This file is part of the QGROUNDCONTROL project
+ 
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+ 
+ ======================================================================*/
+
+#ifndef ImpairedLinkTest_H
+#define ImpairedLinkTest_H
+
+#include "UnitTest.h"
+#include "ImpairedLink.h"
+
+class Vehicle;
+
+/// @file
+///     @brief ImpairedLink Unit Test. Checks the link profile statistics, then measures parameter load, mission
+///             upload and download, and FTP download through a set of link profiles.
+
+class ImpairedLinkTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    ImpairedLinkTest(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _determinism_test(void);
+    void _loss_test(void);
+    void _burstLoss_test(void);
+    void _duplicate_test(void);
+    void _reorder_test(void);
+    void _parameterLoad_benchmark_data(void);
+    void _parameterLoad_benchmark(void);
+    void _missionUpload_benchmark_data(void);
+    void _missionUpload_benchmark(void);
+    void _missionDownload_benchmark_data(void);
+    void _missionDownload_benchmark(void);
+    void _ftpDownload_benchmark_data(void);
+    void _ftpDownload_benchmark(void);
+    
+private:
+    typedef struct {
+        const char* name;
+        int         latencyMsecs;
+        int         jitterMsecs;
+        int         bandwidthBitsPerSecond;
+        double      lossPercent;
+        double      burstLossStartPercent;
+        int         burstLossLength;
+        double      duplicatePercent;
+        double      reorderPercent;
+    } Profile_t;
+    
+    ImpairedLinkConfiguration* _createConfig(const Profile_t& profile);
+    void _runProfile(const Profile_t& profile, quint32 seed, QList<ImpairedLink::Fate_t>& fates);
+    int _percentOf(int count) { return (count * 100 + _profilePacketCount / 2) / _profilePacketCount; }
+    void _profileData(void);
+    void _connectVehicle(qint64* parameterLoadMsecs);
+    void _checkImpairments(const Profile_t& profile);
+    void _writeMission(void);
+    void _waitForMissionManager(void);
+    
+    static const Profile_t _perfectLinkProfile;
+    static const Profile_t _telemetryRadioProfile;
+    static const Profile_t _lossyRadioProfile;
+    static const Profile_t _lossProfile;
+    static const Profile_t _burstLossProfile;
+    static const Profile_t _duplicateProfile;
+    static const Profile_t _reorderProfile;
+    static const Profile_t* _rgBenchmarkProfiles[];
+    
+    static const int _parameterLoadTimeoutMsecs = 60000;
+    static const int _missionTimeoutMsecs = 30000;
+    static const int _ftpTimeoutMsecs = 60000;
+    static const int _missionItemCount = 20;
+    static const int _ftpFileBytes = 16 * 1024;
+    static const int _profilePacketCount = 20000;   ///< Packets run through a profile for the statistics tests
+    static const int _profilePacketBytes = 40;
+    
+    ImpairedLinkConfiguration*  _config;
+    ImpairedLink*               _link;
+    Vehicle*                    _vehicle;
+};
+
+#endif
@@ -0,0 +1,179 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "MissionItemStoreTest.h"
+
+#include <QSignalSpy>
+
+UT_REGISTER_TEST(MissionItemStoreTest)
+
+MissionItemStoreTest::MissionItemStoreTest(void)
+    : _store(NULL)
+{
+    
+}
+
+void MissionItemStoreTest::init(void)
+{
+    UnitTest::init();
+    
+    _store = new MissionItemStore(this);
+    Q_CHECK_PTR(_store);
+}
+
+void MissionItemStoreTest::cleanup(void)
+{
+    delete _store;
+    _store = NULL;
+    
+    UnitTest::cleanup();
+}
+
+/// Appends waypoints whose latitude is their sequence number
+void MissionItemStoreTest::_appendItems(int count)
+{
+    for (int i=0; i<count; i++) {
+        MissionItem item(NULL, i, QGeoCoordinate(i, 0, 10), MAV_CMD_NAV_WAYPOINT, 1.0, 2.0, 3.0, 4.0);
+        _store->append(item);
+    }
+}
+
+/// Sequence numbers follow the row and the current item follows its row as items are inserted and removed
+void MissionItemStoreTest::_insertRemove_test(void)
+{
+    QSignalSpy countSpy(_store, SIGNAL(countChanged(int)));
+    
+    _appendItems(3);
+    QCOMPARE(_store->count(), 3);
+    QCOMPARE(countSpy.count(), 3);
+    QVERIFY(_store->dirty());
+    QVERIFY(_store->currentItem() == NULL);
+    
+    _store->setCurrentIndex(1);
+    QVERIFY(_store->currentItem() != NULL);
+    QCOMPARE(_store->currentItem()->sequenceNumber(), 1);
+    QCOMPARE(_store->currentItem()->isCurrentItem(), true);
+    QCOMPARE(_store->currentItem()->latitude(), 1.0);
+    
+    MissionItem item(NULL, 0, QGeoCoordinate(-1, 0, 10));
+    _store->insert(0, item);
+    QCOMPARE(_store->count(), 4);
+    QCOMPARE(_store->coordinate(0).latitude(), -1.0);
+    QCOMPARE(_store->coordinate(1).latitude(), 0.0);
+    QCOMPARE(_store->currentIndex(), 2);
+    QCOMPARE(_store->currentItem()->sequenceNumber(), 2);
+    QCOMPARE(_store->data(_store->index(3), MissionItemStore::SequenceNumberRole).toInt(), 3);
+    QCOMPARE(_store->data(_store->index(2), MissionItemStore::IsCurrentItemRole).toBool(), true);
+    
+    _store->removeAt(0);
+    QCOMPARE(_store->count(), 3);
+    QCOMPARE(_store->currentIndex(), 1);
+    QCOMPARE(_store->currentItem()->latitude(), 1.0);
+    
+    _store->removeAt(1);
+    QCOMPARE(_store->count(), 2);
+    QCOMPARE(_store->currentIndex(), -1);
+    QVERIFY(_store->currentItem() == NULL);
+    QCOMPARE(_store->coordinate(1).latitude(), 2.0);
+}
+
+/// The current item moves with its values
+void MissionItemStoreTest::_swap_test(void)
+{
+    _appendItems(3);
+    _store->setCurrentIndex(1);
+    
+    QSignalSpy coordinateSpy(_store, SIGNAL(coordinateChanged(int)));
+    
+    _store->swap(1, 2);
+    QCOMPARE(_store->coordinate(1).latitude(), 2.0);
+    QCOMPARE(_store->coordinate(2).latitude(), 1.0);
+    QCOMPARE(_store->currentIndex(), 2);
+    QCOMPARE(_store->currentItem()->sequenceNumber(), 2);
+    QCOMPARE(_store->currentItem()->latitude(), 1.0);
+    QCOMPARE(coordinateSpy.count(), 2);
+}
+
+/// Edits through the current item are written back to the store
+void MissionItemStoreTest::_currentItemEdit_test(void)
+{
+    _appendItems(3);
+    _store->setDirty(false);
+    _store->setCurrentIndex(2);
+    
+    QSignalSpy coordinateSpy(_store, SIGNAL(coordinateChanged(int)));
+    QSignalSpy dataSpy(_store, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+    
+    _store->currentItem()->setLatitude(20.0);
+    QCOMPARE(_store->coordinate(2).latitude(), 20.0);
+    QVERIFY(coordinateSpy.count() >= 1);
+    QCOMPARE(coordinateSpy.takeFirst()[0].toInt(), 2);
+    QVERIFY(dataSpy.count() >= 1);
+    QVERIFY(_store->dirty());
+    
+    _store->currentItem()->setCommand(MavlinkQmlSingleton::MAV_CMD_NAV_LAND);
+    QCOMPARE(_store->command(2), (int)MAV_CMD_NAV_LAND);
+    QCOMPARE(_store->data(_store->index(2), MissionItemStore::CommandNameRole).toString(), QString("Land"));
+    
+    // Untouched items stay as they were
+    QCOMPARE(_store->command(1), (int)MAV_CMD_NAV_WAYPOINT);
+    QCOMPARE(_store->coordinate(1).latitude(), 1.0);
+}
+
+/// Items saved to a mission file load back with the same values
+void MissionItemStoreTest::_loadSave_test(void)
+{
+    _appendItems(5);
+    
+    QString missionText;
+    QTextStream saveStream(&missionText, QIODevice::WriteOnly);
+    _store->save(saveStream);
+    saveStream.flush();
+    
+    MissionItemStore loadedStore;
+    QTextStream loadStream(&missionText, QIODevice::ReadOnly);
+    QVERIFY(loadedStore.load(loadStream));
+    QCOMPARE(loadedStore.count(), 5);
+    QVERIFY(loadedStore.canEdit());
+    
+    QmlObjectListModel* list = loadedStore.createObjectList();
+    QCOMPARE(list->count(), 5);
+    for (int i=0; i<5; i++) {
+        MissionItem* item = qobject_cast<MissionItem*>(list->get(i));
+        QCOMPARE(item->sequenceNumber(), i);
+        QCOMPARE(item->latitude(), (double)i);
+        QCOMPARE(item->altitude(), 10.0);
+        QCOMPARE(item->param1(), 1.0);
+        QCOMPARE(item->param2(), 2.0);
+        QCOMPARE(item->param3(), 3.0);
+        QCOMPARE(item->param4(), 4.0);
+        QCOMPARE(item->command(), (int)MAV_CMD_NAV_WAYPOINT);
+    }
+    delete list;
+    
+    // A corrupt line leaves the store empty
+    QString corruptText("1\t0\t3\n");
+    QTextStream corruptStream(&corruptText, QIODevice::ReadOnly);
+    QVERIFY(!loadedStore.load(corruptStream));
+    QCOMPARE(loadedStore.count(), 0);
+}
@@ -0,0 +1,55 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef MissionItemStoreTest_H
+#define MissionItemStoreTest_H
+
+#include "UnitTest.h"
+#include "MissionItemStore.h"
+
+/// @file
+///     @brief MissionItemStore unit test
+
+class MissionItemStoreTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    MissionItemStoreTest(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _insertRemove_test(void);
+    void _swap_test(void);
+    void _currentItemEdit_test(void);
+    void _loadSave_test(void);
+    
+private:
+    void _appendItems(int count);
+    
+    MissionItemStore* _store;
+};
+
+#endif
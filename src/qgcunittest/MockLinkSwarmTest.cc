@@ -0,0 +1,265 @@
+/*=====================================================================
+ 
+ QGroundControl Open Source Ground Control Station
+ 
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ 
+ This file is part of the QGROUNDCONTROL project
+ 
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+ 
+ ======================================================================*/
+
+#include "MockLinkSwarmTest.h"
+#include "LinkManager.h"
+#include "MultiVehicleManager.h"
+#include "QmlObjectListModel.h"
+#include "AutoPilotPlugin.h"
+#include "MissionManager.h"
+#include "MAVLinkProtocol.h"
+
+#include <QElapsedTimer>
+
+UT_REGISTER_TEST(MockLinkSwarmTest)
+
+MockLinkSwarmTest::MockLinkSwarmTest(void)
+    : _maxRunningSyncs(0)
+{
+    
+}
+
+void MockLinkSwarmTest::cleanup(void)
+{
+    foreach (MockLink* link, _links) {
+        LinkManager::instance()->disconnectLink(link);
+    }
+    if (_links.count()) {
+        QTest::qWait(1000); // Need to allow signals to move between threads
+    }
+    _links.clear();
+    
+    qDeleteAll(_configs);
+    _configs.clear();
+    
+    UnitTest::cleanup();
+}
+
+/// Connects a MockLink which simulates vehicleCount vehicles with telemetry streams
+void MockLinkSwarmTest::_connectSwarm(int firstVehicleId, int vehicleCount)
+{
+    MockConfiguration* config = new MockConfiguration(QString("Mock Swarm %1").arg(firstVehicleId));
+    config->setVehicleCount(vehicleCount);
+    config->setFirstVehicleId(firstVehicleId);
+    config->setStreamRate(MAVLINK_MSG_ID_ATTITUDE, _attitudeRateHz);
+    config->setStreamRate(MAVLINK_MSG_ID_GLOBAL_POSITION_INT, _positionRateHz);
+    _configs.append(config);
+    
+    MockLink* link = new MockLink(config);
+    Q_CHECK_PTR(link);
+    QCOMPARE(link->vehicleId(), firstVehicleId);
+    QCOMPARE(link->vehicleCount(), vehicleCount);
+    _links.append(link);
+    
+    LinkManager::instance()->_addLink(link);
+    LinkManager::instance()->connectLink(link);
+}
+
+/// Waits for MultiVehicleManager to create the specified number of vehicles
+void MockLinkSwarmTest::_waitForVehicles(int vehicleCount)
+{
+    MultiVehicleManager* vehicleMgr = MultiVehicleManager::instance();
+    QSignalSpy spyVehicleAdded(vehicleMgr, SIGNAL(vehicleAdded(Vehicle*)));
+    
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    while (vehicleMgr->vehiclesModel()->count() < vehicleCount && waitTimer.elapsed() < _vehicleWaitMsecs) {
+        spyVehicleAdded.wait(_vehicleWaitMsecs - waitTimer.elapsed());
+    }
+    QCOMPARE(vehicleMgr->vehiclesModel()->count(), vehicleCount);
+}
+
+/// Waits for every vehicle to finish loading its parameters and mission
+///     @param spySyncFinished Spy on VehicleSyncScheduler::syncFinished, created before the links were connected
+void MockLinkSwarmTest::_waitForInitialSync(QSignalSpy& spySyncFinished, int vehicleCount)
+{
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    while (spySyncFinished.count() < vehicleCount && waitTimer.elapsed() < _syncWaitMsecs) {
+        spySyncFinished.wait(_syncWaitMsecs - waitTimer.elapsed());
+    }
+    QCOMPARE(spySyncFinished.count(), vehicleCount);
+    
+    for (int i=0; i<spySyncFinished.count(); i++) {
+        // Second argument is timedOut
+        QCOMPARE(spySyncFinished[i][1].toBool(), false);
+    }
+    
+    for (int i=1; i<=vehicleCount; i++) {
+        Vehicle* vehicle = MultiVehicleManager::instance()->getVehicleById(i);
+        QVERIFY(vehicle);
+        QVERIFY(vehicle->initialSyncComplete());
+        QVERIFY(vehicle->autopilotPlugin()->parametersReady());
+        QVERIFY(!vehicle->autopilotPlugin()->missingParameters());
+        QVERIFY(!vehicle->missionManager()->inProgress());
+        // MockLink vehicles start out with an empty mission
+        QCOMPARE(vehicle->missionManager()->missionItems()->count(), 0);
+    }
+}
+
+void MockLinkSwarmTest::_singleLink_test(void)
+{
+    QSignalSpy spySyncFinished(MultiVehicleManager::instance()->syncScheduler(), SIGNAL(syncFinished(Vehicle*,bool)));
+    
+    _connectSwarm(1, _vehiclesPerLink);
+    _waitForVehicles(_vehiclesPerLink);
+    _waitForInitialSync(spySyncFinished, _vehiclesPerLink);
+}
+
+void MockLinkSwarmTest::_multipleLinks_test(void)
+{
+    QSignalSpy spySyncFinished(MultiVehicleManager::instance()->syncScheduler(), SIGNAL(syncFinished(Vehicle*,bool)));
+    
+    _connectSwarm(1, _vehiclesPerLink);
+    _connectSwarm(1 + _vehiclesPerLink, _vehiclesPerLink);
+    _waitForVehicles(_vehiclesPerLink * 2);
+    _waitForInitialSync(spySyncFinished, _vehiclesPerLink * 2);
+}
+
+void MockLinkSwarmTest::_syncStarted(Vehicle* vehicle)
+{
+    Q_UNUSED(vehicle);
+    
+    _maxRunningSyncs = qMax(_maxRunningSyncs, MultiVehicleManager::instance()->syncScheduler()->runningCount());
+}
+
+/// Vehicles are usable immediately but their parameter and mission sync is staggered
+void MockLinkSwarmTest::_stagedSync_test(void)
+{
+    VehicleSyncScheduler* scheduler = MultiVehicleManager::instance()->syncScheduler();
+    scheduler->setMaxConcurrent(1);
+    
+    _maxRunningSyncs = 0;
+    connect(scheduler, &VehicleSyncScheduler::syncStarted, this, &MockLinkSwarmTest::_syncStarted);
+    QSignalSpy spySyncFinished(scheduler, SIGNAL(syncFinished(Vehicle*,bool)));
+    
+    _connectSwarm(1, _vehiclesPerLink);
+    _waitForVehicles(_vehiclesPerLink);
+    
+    // All vehicles exist, but only one can be syncing
+    QCOMPARE(scheduler->runningCount() + scheduler->pendingCount() + spySyncFinished.count(), _vehiclesPerLink);
+    QVERIFY(scheduler->runningCount() <= 1);
+    
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    while (spySyncFinished.count() < _vehiclesPerLink && waitTimer.elapsed() < _syncWaitMsecs) {
+        spySyncFinished.wait(_syncWaitMsecs - waitTimer.elapsed());
+    }
+    QCOMPARE(spySyncFinished.count(), _vehiclesPerLink);
+    QCOMPARE(_maxRunningSyncs, 1);
+    
+    for (int i=1; i<=_vehiclesPerLink; i++) {
+        Vehicle* vehicle = MultiVehicleManager::instance()->getVehicleById(i);
+        QVERIFY(vehicle);
+        QVERIFY(vehicle->initialSyncComplete());
+    }
+    QCOMPARE(MultiVehicleManager::instance()->diagnostics().count(), _vehiclesPerLink);
+}
+
+/// A sync which times out keeps its slot until its loads finish, and is only signalled once
+void MockLinkSwarmTest::_timedOutSync_test(void)
+{
+    VehicleSyncScheduler* scheduler = MultiVehicleManager::instance()->syncScheduler();
+    scheduler->setMaxConcurrent(1);
+    scheduler->setSyncTimeoutMsecs(1);
+    
+    _maxRunningSyncs = 0;
+    connect(scheduler, &VehicleSyncScheduler::syncStarted, this, &MockLinkSwarmTest::_syncStarted);
+    QSignalSpy spySyncFinished(scheduler, SIGNAL(syncFinished(Vehicle*,bool)));
+    
+    _connectSwarm(1, _vehiclesPerLink);
+    _waitForVehicles(_vehiclesPerLink);
+    
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    int syncedCount = 0;
+    while (syncedCount < _vehiclesPerLink && waitTimer.elapsed() < _syncWaitMsecs) {
+        QTest::qWait(100);
+        QVERIFY(scheduler->runningCount() <= 1);
+        
+        syncedCount = 0;
+        for (int i=1; i<=_vehiclesPerLink; i++) {
+            if (MultiVehicleManager::instance()->getVehicleById(i)->initialSyncComplete()) {
+                syncedCount++;
+            }
+        }
+    }
+    QCOMPARE(syncedCount, _vehiclesPerLink);
+    QCOMPARE(_maxRunningSyncs, 1);
+    QCOMPARE(scheduler->runningCount(), 0);
+    QCOMPARE(spySyncFinished.count(), _vehiclesPerLink);
+}
+
+void MockLinkSwarmTest::_messageReceived(LinkInterface* link, mavlink_message_t message)
+{
+    Q_UNUSED(link);
+    
+    _messageCounts[message.sysid][message.msgid]++;
+    
+    if (message.msgid == MAVLINK_MSG_ID_GLOBAL_POSITION_INT) {
+        mavlink_global_position_int_t position;
+        
+        mavlink_msg_global_position_int_decode(&message, &position);
+        QGeoCoordinate coord(position.lat / 1.0e7, position.lon / 1.0e7);
+        if (!_firstPositions.contains(message.sysid)) {
+            _firstPositions[message.sysid] = coord;
+        }
+        _lastPositions[message.sysid] = coord;
+    }
+}
+
+/// Every vehicle sends its streams at the configured rates and moves along its own track
+void MockLinkSwarmTest::_streams_test(void)
+{
+    _connectSwarm(1, _vehiclesPerLink);
+    _waitForVehicles(_vehiclesPerLink);
+    
+    _messageCounts.clear();
+    _firstPositions.clear();
+    _lastPositions.clear();
+    
+    QElapsedTimer measureTimer;
+    measureTimer.start();
+    connect(MAVLinkProtocol::instance(), SIGNAL(messageReceived(LinkInterface*, mavlink_message_t)), this, SLOT(_messageReceived(LinkInterface*, mavlink_message_t)));
+    QTest::qWait(_streamMeasureMsecs);
+    disconnect(MAVLinkProtocol::instance(), SIGNAL(messageReceived(LinkInterface*, mavlink_message_t)), this, SLOT(_messageReceived(LinkInterface*, mavlink_message_t)));
+    double seconds = measureTimer.elapsed() / 1000.0;
+    
+    for (int i=1; i<=_vehiclesPerLink; i++) {
+        double attitudeRate = _messageCounts[i][MAVLINK_MSG_ID_ATTITUDE] / seconds;
+        double positionRate = _messageCounts[i][MAVLINK_MSG_ID_GLOBAL_POSITION_INT] / seconds;
+        
+        qDebug() << "Vehicle" << i << "ATTITUDE Hz:" << attitudeRate << "GLOBAL_POSITION_INT Hz:" << positionRate;
+        QVERIFY(attitudeRate > _attitudeRateHz * 0.7 && attitudeRate < _attitudeRateHz * 1.3);
+        QVERIFY(positionRate > _positionRateHz * 0.7 && positionRate < _positionRateHz * 1.3);
+        
+        // Simulated vehicles fly at 5 m/s or more
+        QVERIFY(_firstPositions.contains(i));
+        QVERIFY(_firstPositions[i].distanceTo(_lastPositions[i]) > 5.0);
+        
+        // Each vehicle has its own track
+        for (int j=1; j<i; j++) {
+            QVERIFY(_lastPositions[i].distanceTo(_lastPositions[j]) > 10.0);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/*=====================================================================
+ 
+ QGroundControl Open Source Ground Control Station
+ 
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ 
+ This file is part of the QGROUNDCONTROL project
+ 
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+ 
+ ======================================================================*/
+
+#ifndef MockLinkSwarmTest_H
+#define MockLinkSwarmTest_H
+
+#include "UnitTest.h"
+#include "MockLink.h"
+
+#include <QMap>
+#include <QGeoCoordinate>
+
+class Vehicle;
+
+/// @file
+///     @brief Unit test for MockLink simulating multiple vehicles, on one or more links.
+
+class MockLinkSwarmTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    MockLinkSwarmTest(void);
+    
+private slots:
+    void cleanup(void);
+    
+    void _singleLink_test(void);
+    void _multipleLinks_test(void);
+    void _stagedSync_test(void);
+    void _timedOutSync_test(void);
+    void _streams_test(void);
+    
+    // Connected to VehicleSyncScheduler::syncStarted
+    void _syncStarted(Vehicle* vehicle);
+    
+    // Connected to MAVLinkProtocol::messageReceived
+    void _messageReceived(LinkInterface* link, mavlink_message_t message);
+    
+private:
+    void _connectSwarm(int firstVehicleId, int vehicleCount);
+    void _waitForVehicles(int vehicleCount);
+    void _waitForInitialSync(QSignalSpy& spySyncFinished, int vehicleCount);
+    
+    static const int _vehiclesPerLink = 4;
+    static const int _vehicleWaitMsecs = 10000;
+    static const int _syncWaitMsecs = 60000;
+    static const int _attitudeRateHz = 50;
+    static const int _positionRateHz = 10;
+    static const int _streamMeasureMsecs = 3000;
+    
+    int _maxRunningSyncs;   ///< Highest number of vehicles syncing at the same time
+    
+    QMap<int, QMap<int, int> >      _messageCounts;     ///< Received message counts, by system id then message id
+    QMap<int, QGeoCoordinate>       _firstPositions;    ///< First GLOBAL_POSITION_INT received, by system id
+    QMap<int, QGeoCoordinate>       _lastPositions;     ///< Last GLOBAL_POSITION_INT received, by system id
+    
+    QList<MockConfiguration*>   _configs;
+    QList<MockLink*>            _links;
+};
+
+#endif
@@ -0,0 +1,123 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "MockTileServer.h"
+
+MockTileServer::MockTileServer(QObject* parent)
+    : QTcpServer(parent)
+    , _requestCount(0)
+    , _offline(false)
+    , _connectionCount(0)
+    , _peakConnectionCount(0)
+{
+    connect(this, &QTcpServer::newConnection, this, &MockTileServer::_newConnection);
+}
+
+bool MockTileServer::start(void)
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+QString MockTileServer::urlTemplate(void)
+{
+    return QString("http://127.0.0.1:%1/{z}/{x}/{y}.png").arg(serverPort());
+}
+
+QByteArray MockTileServer::tileData(int zoom, int x, int y)
+{
+    // Png signature followed by the tile location, enough for the format detection and for telling tiles apart
+    QByteArray data("\x89PNG\r\n\x1a\n", 8);
+    data.append(QString("%1/%2/%3").arg(zoom).arg(x).arg(y).toLatin1());
+    return data;
+}
+
+void MockTileServer::_newConnection(void)
+{
+    while (hasPendingConnections()) {
+        QTcpSocket* socket = nextPendingConnection();
+        
+        connect(socket, &QTcpSocket::readyRead, this, &MockTileServer::_readRequest);
+        connect(socket, &QTcpSocket::disconnected, this, &MockTileServer::_disconnected);
+        
+        _connectionCount++;
+        _peakConnectionCount = qMax(_peakConnectionCount, _connectionCount);
+    }
+}
+
+void MockTileServer::_disconnected(void)
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    Q_ASSERT(socket);
+    
+    _connectionCount--;
+    socket->deleteLater();
+}
+
+void MockTileServer::_readRequest(void)
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    Q_ASSERT(socket);
+    
+    // Requests are small, wait for the complete header
+    if (!socket->canReadLine()) {
+        return;
+    }
+    QByteArray requestLine = socket->readLine().trimmed();
+    socket->readAll();
+    
+    _requestCount++;
+    
+    if (_offline) {
+        _sendResponse(socket, "503 Service Unavailable", QByteArray());
+        return;
+    }
+    
+    // GET /{z}/{x}/{y}.png HTTP/1.1
+    QList<QByteArray> requestParts = requestLine.split(' ');
+    QStringList pathParts = requestParts.count() == 3 ? QString(requestParts[1]).split('/', QString::SkipEmptyParts) : QStringList();
+    
+    if (requestParts[0] != "GET" || pathParts.count() != 3 || !pathParts[2].endsWith(".png")) {
+        _sendResponse(socket, "404 Not Found", QByteArray());
+        return;
+    }
+    
+    int zoom = pathParts[0].toInt();
+    int x = pathParts[1].toInt();
+    int y = pathParts[2].left(pathParts[2].length() - 4).toInt();
+    _requestedTiles.append(QString("%1/%2/%3").arg(zoom).arg(x).arg(y));
+    _sendResponse(socket, "200 OK", tileData(zoom, x, y));
+}
+
+void MockTileServer::_sendResponse(QTcpSocket* socket, const QByteArray& status, const QByteArray& body)
+{
+    QByteArray response;
+    
+    response.append("HTTP/1.1 " + status + "\r\n");
+    response.append("Content-Type: image/png\r\n");
+    response.append("Content-Length: " + QByteArray::number(body.size()) + "\r\n");
+    response.append("Connection: close\r\n\r\n");
+    response.append(body);
+    
+    socket->write(response);
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,80 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef MockTileServer_H
+#define MockTileServer_H
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QByteArray>
+#include <QStringList>
+
+/// @file
+///     @brief Local stand-in for a map tile server. Answers GET /{z}/{x}/{y}.png over HTTP with a small png
+///             tile whose contents identify the tile.
+
+class MockTileServer : public QTcpServer
+{
+    Q_OBJECT
+    
+public:
+    MockTileServer(QObject* parent = NULL);
+    
+    /// Starts listening on a free local port
+    ///     @return false: listen failed
+    bool start(void);
+    
+    /// Url template for the tile fetcher and seeder, with {x}, {y} and {z} placeholders
+    QString urlTemplate(void);
+    
+    /// Requests answered so far
+    int requestCount(void) { return _requestCount; }
+    
+    /// Tiles requested so far as "z/x/y", in request order
+    QStringList requestedTiles(void) { return _requestedTiles; }
+    
+    /// Most connections which were open at the same time
+    int peakConnectionCount(void) { return _peakConnectionCount; }
+    
+    /// Emulates loss of connectivity: requests are answered with 503 Service Unavailable
+    void setOffline(bool offline) { _offline = offline; }
+    
+    /// @return Tile data served for the specified tile
+    static QByteArray tileData(int zoom, int x, int y);
+    
+private slots:
+    void _newConnection(void);
+    void _readRequest(void);
+    void _disconnected(void);
+    
+private:
+    void _sendResponse(QTcpSocket* socket, const QByteArray& status, const QByteArray& body);
+    
+    int         _requestCount;
+    bool        _offline;
+    QStringList _requestedTiles;
+    int         _connectionCount;
+    int         _peakConnectionCount;
+};
+
+#endif
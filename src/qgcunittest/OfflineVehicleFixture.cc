@@ -0,0 +1,60 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "OfflineVehicleFixture.h"
+#include "LinkManager.h"
+#include "MockLink.h"
+#include "Vehicle.h"
+#include "UAS.h"
+
+OfflineVehicleFixture::OfflineVehicleFixture(void)
+    : _link(NULL)
+    , _vehicle(NULL)
+{
+    _link = new MockLink();
+    Q_CHECK_PTR(_link);
+    LinkManager::instance()->_addLink(_link);
+}
+
+OfflineVehicleFixture::~OfflineVehicleFixture()
+{
+    if (_vehicle) {
+        _vehicle->uas()->clearVehicle();
+        delete _vehicle;
+        _vehicle = NULL;
+    }
+    
+    // The link was never connected, so it can be removed immediately
+    LinkManager::instance()->_deleteLink(_link);
+    _link = NULL;
+}
+
+Vehicle* OfflineVehicleFixture::createVehicle(int vehicleId)
+{
+    Q_ASSERT(!_vehicle);
+    
+    _vehicle = new Vehicle(_link, vehicleId, MAV_AUTOPILOT_PX4, MAV_TYPE_QUADROTOR);
+    Q_CHECK_PTR(_vehicle);
+    
+    return _vehicle;
+}
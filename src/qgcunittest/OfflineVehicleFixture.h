@@ -0,0 +1,57 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef OfflineVehicleFixture_H
+#define OfflineVehicleFixture_H
+
+class MockLink;
+class Vehicle;
+
+/// @file
+///     @brief Vehicle on a MockLink which is added to LinkManager but never connected. Used by tests and
+///             benchmarks which drive the Vehicle and its UAS directly instead of through the mavlink protocol.
+///             Create it in init and delete it in cleanup.
+
+class OfflineVehicleFixture
+{
+public:
+    /// Adds the link to LinkManager, the vehicle is created separately
+    OfflineVehicleFixture(void);
+    
+    /// Deletes the vehicle and removes the link from LinkManager
+    ~OfflineVehicleFixture();
+    
+    MockLink* link(void) { return _link; }
+    
+    /// Creates the vehicle on the link
+    Vehicle* createVehicle(int vehicleId);
+    
+    /// @return Vehicle, NULL if not created yet
+    Vehicle* vehicle(void) { return _vehicle; }
+    
+private:
+    MockLink*   _link;
+    Vehicle*    _vehicle;
+};
+
+#endif
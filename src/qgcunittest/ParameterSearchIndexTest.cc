@@ -0,0 +1,186 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "ParameterSearchIndexTest.h"
+#include "ParameterListModel.h"
+
+#include <QSignalSpy>
+
+UT_REGISTER_TEST(ParameterSearchIndexTest)
+
+ParameterSearchIndexTest::ParameterSearchIndexTest(void)
+{
+    
+}
+
+void ParameterSearchIndexTest::init(void)
+{
+    UnitTest::init();
+    
+    // Added out of order to check the index sorts by component and name
+    _addFact(1, "MC_ROLL_P",    "Multicopter Attitude Control", "Roll P gain",              "Roll proportional gain, i.e. desired angular speed in rad/s for error 1 rad.");
+    _addFact(1, "MC_PITCH_P",   "Multicopter Attitude Control", "Pitch P gain",             "Pitch proportional gain.");
+    _addFact(1, "BAT_N_CELLS",  "Battery Calibration",          "Number of cells",          "Defines the number of cells the attached battery consists of.");
+    _addFact(1, "MC_ROLLRATE_P","Multicopter Attitude Control", "Roll rate P gain",         "Roll rate proportional gain.");
+    _addFact(1, "BAT_V_EMPTY",  "Battery Calibration",          "Empty cell voltage",       "Defines the voltage where a single cell of the battery is considered empty.");
+    _addFact(2, "CAM_ROLL",     "Gimbal",                       "Camera roll",              "Roll angle of the camera mount.");
+    
+    _index.build(_facts);
+}
+
+void ParameterSearchIndexTest::cleanup(void)
+{
+    _index.clear();
+    qDeleteAll(_facts);
+    _facts.clear();
+    
+    UnitTest::cleanup();
+}
+
+void ParameterSearchIndexTest::_addFact(int componentId, const QString& name, const QString& group, const QString& shortDescription, const QString& longDescription)
+{
+    Fact* fact = new Fact(componentId, name, FactMetaData::valueTypeFloat);
+    FactMetaData* metaData = new FactMetaData(FactMetaData::valueTypeFloat, fact);
+    
+    metaData->setGroup(group);
+    metaData->setShortDescription(shortDescription);
+    metaData->setLongDescription(longDescription);
+    fact->setMetaData(metaData);
+    
+    _facts += fact;
+}
+
+QStringList ParameterSearchIndexTest::_names(const QVector<int>& entries)
+{
+    QStringList names;
+    
+    foreach (int entry, entries) {
+        names += _index.name(entry);
+    }
+    
+    return names;
+}
+
+void ParameterSearchIndexTest::_groups_test(void)
+{
+    QCOMPARE(_index.count(), 6);
+    QCOMPARE(_index.componentIds(), QList<int>() << 1 << 2);
+    QCOMPARE(_index.groups(1), QStringList() << "Battery Calibration" << "Multicopter Attitude Control");
+    
+    QCOMPARE(_names(_index.groupEntries(1, "Multicopter Attitude Control")), QStringList() << "MC_PITCH_P" << "MC_ROLLRATE_P" << "MC_ROLL_P");
+    QCOMPARE(_names(_index.entries(2)), QStringList() << "CAM_ROLL");
+    QCOMPARE(_names(_index.entries(-1)), QStringList() << "BAT_N_CELLS" << "BAT_V_EMPTY" << "MC_PITCH_P" << "MC_ROLLRATE_P" << "MC_ROLL_P" << "CAM_ROLL");
+    QVERIFY(_index.groupEntries(3, "Gimbal").isEmpty());
+}
+
+/// Names are matched as case insensitive substrings, the same as the previous linear search
+void ParameterSearchIndexTest::_nameSearch_test(void)
+{
+    QCOMPARE(_names(_index.search(-1, "roll", true, false)), QStringList() << "MC_ROLLRATE_P" << "MC_ROLL_P" << "CAM_ROLL");
+    QCOMPARE(_names(_index.search(1, "roll", true, false)), QStringList() << "MC_ROLLRATE_P" << "MC_ROLL_P");
+    QCOMPARE(_names(_index.search(2, "roll", true, false)), QStringList() << "CAM_ROLL");
+    QCOMPARE(_names(_index.search(1, "LL_P", true, false)), QStringList() << "MC_ROLL_P");
+    QCOMPARE(_names(_index.search(1, " _p ", true, false)), QStringList() << "MC_PITCH_P" << "MC_ROLLRATE_P" << "MC_ROLL_P");
+    QVERIFY(_index.search(-1, "yaw", true, false).isEmpty());
+    
+    // Empty search lists all
+    QCOMPARE(_index.search(1, "", true, true).count(), 5);
+    
+    // Name only matches do not show up in a description search
+    QVERIFY(_index.search(-1, "MC_", false, true).isEmpty());
+}
+
+/// Group and descriptions are matched by word prefix, all words must match
+void ParameterSearchIndexTest::_descriptionSearch_test(void)
+{
+    QCOMPARE(_names(_index.search(-1, "volt", false, true)), QStringList() << "BAT_V_EMPTY");
+    QCOMPARE(_names(_index.search(-1, "Cell", false, true)), QStringList() << "BAT_N_CELLS" << "BAT_V_EMPTY");
+    QCOMPARE(_names(_index.search(-1, "cell empty", false, true)), QStringList() << "BAT_V_EMPTY");
+    QCOMPARE(_names(_index.search(-1, "roll gain", false, true)), QStringList() << "MC_ROLLRATE_P" << "MC_ROLL_P");
+    QCOMPARE(_names(_index.search(-1, "gimbal", false, true)), QStringList() << "CAM_ROLL");
+    QVERIFY(_index.search(-1, "cell gimbal", false, true).isEmpty());
+    
+    // Words only match from their start
+    QVERIFY(_index.search(-1, "oltage", false, true).isEmpty());
+    
+    // Union of name and description matches
+    QCOMPARE(_names(_index.search(-1, "cam", true, true)), QStringList() << "CAM_ROLL");
+    QCOMPARE(_names(_index.search(1, "pitch", true, true)), QStringList() << "MC_PITCH_P");
+}
+
+/// Narrowing and widening the filter only removes and inserts the rows which change
+void ParameterSearchIndexTest::_listModelFilter_test(void)
+{
+    ParameterListModel model(&_index);
+    
+    QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+    QSignalSpy insertSpy(&model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+    QSignalSpy removeSpy(&model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+    QSignalSpy countSpy(&model, SIGNAL(countChanged(int)));
+    
+    QCOMPARE(model.count(), 6);
+    
+    // "ro" keeps MC_ROLLRATE_P, MC_ROLL_P and CAM_ROLL, which removes one run of three rows in front of them
+    model.setSearchText("ro");
+    QCOMPARE(model.count(), 3);
+    QCOMPARE(removeSpy.count(), 1);
+    QCOMPARE(removeSpy.at(0).at(1).toInt(), 0);
+    QCOMPARE(removeSpy.at(0).at(2).toInt(), 2);
+    QCOMPARE(insertSpy.count(), 0);
+    QCOMPARE(countSpy.count(), 1);
+    
+    // "rollr" removes the two rows after MC_ROLLRATE_P
+    removeSpy.clear();
+    model.setSearchText("rollr");
+    QCOMPARE(model.count(), 1);
+    QCOMPARE(_index.name(model.entry(0)), QString("MC_ROLLRATE_P"));
+    QCOMPARE(removeSpy.count(), 1);
+    QCOMPARE(removeSpy.at(0).at(1).toInt(), 1);
+    QCOMPARE(removeSpy.at(0).at(2).toInt(), 2);
+    QCOMPARE(insertSpy.count(), 0);
+    
+    // Back to "roll" inserts the rows again
+    removeSpy.clear();
+    model.setSearchText("roll");
+    QCOMPARE(model.count(), 3);
+    QCOMPARE(removeSpy.count(), 0);
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(insertSpy.at(0).at(1).toInt(), 1);
+    QCOMPARE(insertSpy.at(0).at(2).toInt(), 2);
+    
+    // Component and group filter once the search text is cleared
+    model.setComponentId(1);
+    QCOMPARE(model.count(), 2);
+    model.setGroup("Battery Calibration");
+    QCOMPARE(model.count(), 2);
+    model.setSearchText("");
+    QCOMPARE(model.count(), 2);
+    QCOMPARE(_index.name(model.entry(0)), QString("BAT_N_CELLS"));
+    QCOMPARE(_index.name(model.entry(1)), QString("BAT_V_EMPTY"));
+    
+    model.setGroup("Multicopter Attitude Control");
+    QCOMPARE(model.count(), 3);
+    QCOMPARE(_index.name(model.entry(0)), QString("MC_PITCH_P"));
+    
+    QCOMPARE(resetSpy.count(), 0);
+}
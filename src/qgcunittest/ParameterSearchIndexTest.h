@@ -0,0 +1,57 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef ParameterSearchIndexTest_H
+#define ParameterSearchIndexTest_H
+
+#include "UnitTest.h"
+#include "ParameterSearchIndex.h"
+
+/// @file
+///     @brief ParameterSearchIndex and ParameterListModel unit test
+
+class ParameterSearchIndexTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    ParameterSearchIndexTest(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _groups_test(void);
+    void _nameSearch_test(void);
+    void _descriptionSearch_test(void);
+    void _listModelFilter_test(void);
+    
+private:
+    void _addFact(int componentId, const QString& name, const QString& group, const QString& shortDescription, const QString& longDescription);
+    QStringList _names(const QVector<int>& entries);
+    
+    QList<Fact*>            _facts;
+    ParameterSearchIndex    _index;
+};
+
+#endif
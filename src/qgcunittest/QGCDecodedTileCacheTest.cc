@@ -0,0 +1,183 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "QGCDecodedTileCacheTest.h"
+
+#include <QImage>
+#include <QBuffer>
+#include <QSignalSpy>
+
+UT_REGISTER_TEST(QGCDecodedTileCacheTest)
+
+QGCDecodedTileCacheTest::QGCDecodedTileCacheTest(void)
+    : _cache(NULL)
+{
+    
+}
+
+void QGCDecodedTileCacheTest::init(void)
+{
+    UnitTest::init();
+    
+    _cache = new QGCDecodedTileCache(64 * 1024 * 1024, this);
+}
+
+void QGCDecodedTileCacheTest::cleanup(void)
+{
+    delete _cache;
+    _cache = NULL;
+    
+    UnitTest::cleanup();
+}
+
+QGCTileStore::TileCoord_t QGCDecodedTileCacheTest::_coord(int zoom, int x, int y)
+{
+    QGCTileStore::TileCoord_t coord;
+    
+    coord.mapType = _mapType;
+    coord.zoom = zoom;
+    coord.x = x;
+    coord.y = y;
+    
+    return coord;
+}
+
+/// @return Png encoded tile filled with the specified color
+QByteArray QGCDecodedTileCacheTest::_pngTile(QRgb color)
+{
+    QImage image(256, 256, QImage::Format_RGB32);
+    image.fill(color);
+    
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "png");
+    
+    return data;
+}
+
+/// Png tiles are decoded to bmp with the same pixels and added to the cache
+void QGCDecodedTileCacheTest::_decode_test(void)
+{
+    TestDecodeRequester requester;
+    QSignalSpy doneSpy(&requester, SIGNAL(done()));
+    
+    _cache->decode(_coord(12, 5, 6), _pngTile(qRgb(10, 20, 30)), "png", &requester);
+    QVERIFY(doneSpy.wait(5000));
+    
+    QCOMPARE(requester.decodedCount, 1);
+    QCOMPARE(requester.lastFormat, QString(QGCDecodedTileCache::decodedFormat));
+    
+    QImage image;
+    QVERIFY(image.loadFromData(requester.lastData, QGCDecodedTileCache::decodedFormat));
+    QCOMPARE(image.size(), QSize(256, 256));
+    QCOMPARE(image.pixel(128, 128), qRgb(10, 20, 30));
+    
+    QByteArray data;
+    QVERIFY(_cache->find(_coord(12, 5, 6), data));
+    QCOMPARE(data, requester.lastData);
+    QCOMPARE(_cache->totalBytes(), (qint64)data.size());
+    QVERIFY(!_cache->find(_coord(12, 5, 7), data));
+}
+
+/// Requests for a tile which is being decoded share the decode
+void QGCDecodedTileCacheTest::_coalesce_test(void)
+{
+    TestDecodeRequester requester1;
+    TestDecodeRequester requester2;
+    QSignalSpy doneSpy(&requester2, SIGNAL(done()));
+    QByteArray tile = _pngTile(qRgb(40, 50, 60));
+    
+    _cache->decode(_coord(12, 5, 6), tile, "png", &requester1);
+    _cache->decode(_coord(12, 5, 6), tile, "png", &requester2);
+    QVERIFY(doneSpy.wait(5000));
+    
+    QCOMPARE(_cache->decodeCount(), (quint32)1);
+    QCOMPARE(requester1.decodedCount, 1);
+    QCOMPARE(requester2.decodedCount, 1);
+    QCOMPARE(requester1.lastData, requester2.lastData);
+    QCOMPARE(_cache->count(), 1);
+}
+
+/// Cancelled requesters are not called back but the decoded tile is still cached
+void QGCDecodedTileCacheTest::_cancel_test(void)
+{
+    TestDecodeRequester requester1;
+    TestDecodeRequester requester2;
+    QSignalSpy doneSpy(&requester2, SIGNAL(done()));
+    QByteArray tile = _pngTile(qRgb(70, 80, 90));
+    
+    _cache->decode(_coord(12, 5, 6), tile, "png", &requester1);
+    _cache->decode(_coord(12, 5, 6), tile, "png", &requester2);
+    _cache->cancelDecode(_coord(12, 5, 6), &requester1);
+    QVERIFY(doneSpy.wait(5000));
+    
+    QCOMPARE(requester1.decodedCount, 0);
+    QCOMPARE(requester2.decodedCount, 1);
+    
+    QByteArray data;
+    QVERIFY(_cache->find(_coord(12, 5, 6), data));
+}
+
+/// Data which can not be decoded is passed back as is and not cached
+void QGCDecodedTileCacheTest::_invalidData_test(void)
+{
+    TestDecodeRequester requester;
+    QSignalSpy doneSpy(&requester, SIGNAL(done()));
+    QByteArray tile("not a png tile");
+    
+    _cache->decode(_coord(12, 5, 6), tile, "png", &requester);
+    QVERIFY(doneSpy.wait(5000));
+    
+    QCOMPARE(requester.lastData, tile);
+    QCOMPARE(requester.lastFormat, QString("png"));
+    QCOMPARE(_cache->count(), 0);
+}
+
+/// When the cache is full tiles far from the viewed zoom level are evicted before older tiles at the viewed zoom
+void QGCDecodedTileCacheTest::_zoomAwareEviction_test(void)
+{
+    QByteArray tile(1000, 'x');
+    QByteArray data;
+    QObject* view = new QObject;
+    
+    _cache->setViewZoom(view, 15);
+    _cache->setMaxBytes(3 * tile.size());
+    
+    _cache->insert(_coord(15, 1, 1), tile);
+    _cache->insert(_coord(10, 1, 1), tile);
+    _cache->insert(_coord(15, 1, 2), tile);
+    _cache->insert(_coord(15, 1, 3), tile);
+    
+    QCOMPARE(_cache->count(), 3);
+    QCOMPARE(_cache->totalBytes(), (qint64)(3 * tile.size()));
+    QVERIFY(!_cache->find(_coord(10, 1, 1), data));
+    QVERIFY(_cache->find(_coord(15, 1, 1), data));
+    
+    // Without views plain least recently used order applies, 15/1/2 is now the oldest
+    delete view;
+    _cache->insert(_coord(10, 1, 1), tile);
+    QCOMPARE(_cache->count(), 3);
+    QVERIFY(!_cache->find(_coord(15, 1, 2), data));
+    QVERIFY(_cache->find(_coord(15, 1, 3), data));
+}
@@ -0,0 +1,78 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef QGCDecodedTileCacheTest_H
+#define QGCDecodedTileCacheTest_H
+
+#include "UnitTest.h"
+#include "QtLocationPlugin/QGCDecodedTileCache.h"
+
+/// @file
+///     @brief Unit test for the decoded map tile cache
+
+/// Records the decode results handed back by the cache
+class TestDecodeRequester : public QObject, public QGCTileDecodeRequester
+{
+    Q_OBJECT
+    
+public:
+    TestDecodeRequester(void) : decodedCount(0) { }
+    
+    // From QGCTileDecodeRequester
+    void tileDecoded(const QByteArray& data, const QString& format) { lastData = data; lastFormat = format; decodedCount++; emit done(); }
+    
+    int         decodedCount;
+    QByteArray  lastData;
+    QString     lastFormat;
+    
+signals:
+    void done(void);
+};
+
+class QGCDecodedTileCacheTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    QGCDecodedTileCacheTest(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _decode_test(void);
+    void _coalesce_test(void);
+    void _cancel_test(void);
+    void _invalidData_test(void);
+    void _zoomAwareEviction_test(void);
+    
+private:
+    QGCTileStore::TileCoord_t _coord(int zoom, int x, int y);
+    QByteArray _pngTile(QRgb color);
+    
+    static const int _mapType = 32;     ///< OpenPilot::OpenStreetMap
+    
+    QGCDecodedTileCache*    _cache;
+};
+
+#endif
@@ -0,0 +1,267 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "QGCTileSchedulerTest.h"
+#include "MockTileServer.h"
+
+#include <QNetworkAccessManager>
+#include <QSignalSpy>
+
+#include <math.h>
+
+UT_REGISTER_TEST(QGCTileSchedulerTest)
+
+QGCTileSchedulerTest::QGCTileSchedulerTest(void)
+    : _server(NULL)
+    , _networkManager(NULL)
+    , _scheduler(NULL)
+{
+    
+}
+
+void QGCTileSchedulerTest::init(void)
+{
+    UnitTest::init();
+    
+    _server = new MockTileServer(this);
+    QVERIFY(_server->start());
+    
+    _networkManager = new QNetworkAccessManager(this);
+    _scheduler = new QGCTileScheduler(_networkManager, this);
+}
+
+void QGCTileSchedulerTest::cleanup(void)
+{
+    delete _scheduler;
+    delete _networkManager;
+    delete _server;
+    _scheduler = NULL;
+    _networkManager = NULL;
+    _server = NULL;
+    
+    UnitTest::cleanup();
+}
+
+QGCTileStore::TileCoord_t QGCTileSchedulerTest::_coord(int zoom, int x, int y)
+{
+    QGCTileStore::TileCoord_t coord;
+    
+    coord.mapType = _mapType;
+    coord.zoom = zoom;
+    coord.x = x;
+    coord.y = y;
+    
+    return coord;
+}
+
+void QGCTileSchedulerTest::_requestTile(int zoom, int x, int y, TestTileRequester* requester)
+{
+    QString url = _server->urlTemplate().replace("{z}", QString::number(zoom)).replace("{x}", QString::number(x)).replace("{y}", QString::number(y));
+    
+    _scheduler->requestTile(_coord(zoom, x, y), QNetworkRequest(QUrl(url)), requester);
+}
+
+/// Waits until the requester has had count results
+bool QGCTileSchedulerTest::_waitForDone(TestTileRequester* requester, int count)
+{
+    QSignalSpy doneSpy(requester, SIGNAL(done()));
+    
+    while (requester->downloadedCount + requester->failedCount < count) {
+        if (!doneSpy.wait(5000)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Requests for the same tile share a single download
+void QGCTileSchedulerTest::_coalesce_test(void)
+{
+    TestTileRequester requester1;
+    TestTileRequester requester2;
+    TestTileRequester requester3;
+    
+    _requestTile(12, 5, 6, &requester1);
+    _requestTile(12, 5, 6, &requester2);
+    _requestTile(12, 5, 7, &requester3);
+    
+    QVERIFY(_waitForDone(&requester1, 1));
+    QVERIFY(_waitForDone(&requester2, 1));
+    QVERIFY(_waitForDone(&requester3, 1));
+    
+    QCOMPARE(_server->requestCount(), 2);
+    QCOMPARE(_scheduler->coalescedCount(), (quint32)1);
+    QCOMPARE(requester1.lastData, MockTileServer::tileData(12, 5, 6));
+    QCOMPARE(requester2.lastData, MockTileServer::tileData(12, 5, 6));
+    QCOMPARE(requester3.lastData, MockTileServer::tileData(12, 5, 7));
+}
+
+/// No more than the maximum number of requests are in flight for a provider
+void QGCTileSchedulerTest::_concurrency_test(void)
+{
+    const int tileCount = 12;
+    
+    TestTileRequester requester;
+    
+    _scheduler->setMaxActivePerProvider(2);
+    for (int i=0; i<tileCount; i++) {
+        _requestTile(14, i, 0, &requester);
+    }
+    QCOMPARE(_scheduler->pendingCount(), tileCount);
+    
+    QVERIFY(_waitForDone(&requester, tileCount));
+    QCOMPARE(requester.downloadedCount, tileCount);
+    QCOMPARE(_server->requestCount(), tileCount);
+    QVERIFY(_server->peakConnectionCount() <= 2);
+    QCOMPARE(_scheduler->pendingCount(), 0);
+    QCOMPARE(_scheduler->activeCount(), 0);
+}
+
+/// Queued tiles are started nearest to the viewport center first, other zooms last
+void QGCTileSchedulerTest::_priority_test(void)
+{
+    const int       zoom = 15;
+    const double    latitude = 47.397;
+    const double    longitude = 8.545;
+    
+    int centerX = (int)floor(QGCTileStore::longitudeToTileX(longitude, zoom));
+    int centerY = (int)floor(QGCTileStore::latitudeToTileY(latitude, zoom));
+    
+    TestTileRequester requester;
+    
+    _scheduler->setMaxActivePerProvider(1);
+    _scheduler->setViewport(this, latitude, longitude, zoom);
+    
+    _requestTile(zoom, centerX + 5, centerY, &requester);
+    _requestTile(zoom - 1, centerX / 2, centerY / 2, &requester);
+    _requestTile(zoom, centerX + 1, centerY + 1, &requester);
+    _requestTile(zoom, centerX, centerY, &requester);
+    
+    QVERIFY(_waitForDone(&requester, 4));
+    
+    QStringList expectedOrder;
+    expectedOrder << QString("%1/%2/%3").arg(zoom).arg(centerX).arg(centerY)
+                  << QString("%1/%2/%3").arg(zoom).arg(centerX + 1).arg(centerY + 1)
+                  << QString("%1/%2/%3").arg(zoom).arg(centerX + 5).arg(centerY)
+                  << QString("%1/%2/%3").arg(zoom - 1).arg(centerX / 2).arg(centerY / 2);
+    QCOMPARE(_server->requestedTiles(), expectedOrder);
+}
+
+/// Tiles nobody wants anymore are dropped from the queue or aborted
+void QGCTileSchedulerTest::_cancel_test(void)
+{
+    TestTileRequester requester1;
+    TestTileRequester requester2;
+    TestTileRequester requester3;
+    TestTileRequester requester4;
+    
+    _scheduler->setMaxActivePerProvider(1);
+    _requestTile(10, 1, 1, &requester1);
+    _requestTile(10, 2, 2, &requester2);
+    _requestTile(10, 3, 3, &requester3);
+    _requestTile(10, 3, 3, &requester4);
+    
+    // Queued tile with a second requester left stays queued
+    _scheduler->cancelTile(_coord(10, 3, 3), &requester3);
+    QCOMPARE(_scheduler->cancelledCount(), (quint32)0);
+    
+    // Queued tile with no requester left is dropped
+    _scheduler->cancelTile(_coord(10, 2, 2), &requester2);
+    QCOMPARE(_scheduler->cancelledCount(), (quint32)1);
+    QCOMPARE(_scheduler->pendingCount(), 2);
+    
+    // Running download is aborted
+    QTRY_VERIFY_WITH_TIMEOUT(_scheduler->activeCount() != 0, 5000);
+    _scheduler->cancelTile(_coord(10, 1, 1), &requester1);
+    QCOMPARE(_scheduler->cancelledCount(), (quint32)2);
+    
+    QVERIFY(_waitForDone(&requester4, 1));
+    QCOMPARE(requester4.lastData, MockTileServer::tileData(10, 3, 3));
+    QCOMPARE(requester1.downloadedCount + requester1.failedCount, 0);
+    QCOMPARE(requester2.downloadedCount + requester2.failedCount, 0);
+    QCOMPARE(requester3.downloadedCount + requester3.failedCount, 0);
+    QVERIFY(!_server->requestedTiles().contains("10/2/2"));
+}
+
+void QGCTileSchedulerTest::_timeToVisible_test(void)
+{
+    TestTileRequester requester;
+    
+    QCOMPARE(_scheduler->lastTimeToVisibleMsecs(), -1);
+    
+    QSignalSpy visibleSpy(_scheduler, SIGNAL(visibleTilesComplete(int)));
+    _scheduler->setViewport(this, 47.397, 8.545, 16);
+    for (int i=0; i<3; i++) {
+        _requestTile(16, i, 0, &requester);
+    }
+    
+    // Another view moving does not restart the measurement of this one
+    QObject otherView;
+    _scheduler->setViewport(&otherView, -33.86, 151.20, 10);
+    
+    QVERIFY(visibleSpy.wait(5000));
+    QCOMPARE(visibleSpy.count(), 1);
+    QCOMPARE(requester.downloadedCount, 3);
+    QVERIFY(_scheduler->lastTimeToVisibleMsecs() >= 0);
+}
+
+/// Each map view has its own viewport, queued tiles go nearest to any of them first
+void QGCTileSchedulerTest::_multipleViews_test(void)
+{
+    const int zoom = 15;
+    
+    int x1 = (int)floor(QGCTileStore::longitudeToTileX(8.545, zoom));
+    int y1 = (int)floor(QGCTileStore::latitudeToTileY(47.397, zoom));
+    int x2 = (int)floor(QGCTileStore::longitudeToTileX(151.20, zoom));
+    int y2 = (int)floor(QGCTileStore::latitudeToTileY(-33.86, zoom));
+    
+    TestTileRequester requester;
+    QObject* view1 = new QObject(this);
+    QObject view2;
+    
+    _scheduler->setMaxActivePerProvider(1);
+    _scheduler->setViewport(view1, 47.397, 8.545, zoom);
+    _scheduler->setViewport(&view2, -33.86, 151.20, zoom);
+    QCOMPARE(_scheduler->viewportCount(), 2);
+    
+    QSignalSpy visibleSpy(_scheduler, SIGNAL(visibleTilesComplete(int)));
+    _requestTile(zoom, x1 + 6, y1, &requester);
+    _requestTile(zoom, x2 + 4, y2, &requester);
+    _requestTile(zoom, x1 + 2, y1, &requester);
+    _requestTile(zoom, x2, y2, &requester);
+    
+    QVERIFY(_waitForDone(&requester, 4));
+    
+    QStringList expectedOrder;
+    expectedOrder << QString("%1/%2/%3").arg(zoom).arg(x2).arg(y2)
+                  << QString("%1/%2/%3").arg(zoom).arg(x1 + 2).arg(y1)
+                  << QString("%1/%2/%3").arg(zoom).arg(x2 + 4).arg(y2)
+                  << QString("%1/%2/%3").arg(zoom).arg(x1 + 6).arg(y1);
+    QCOMPARE(_server->requestedTiles(), expectedOrder);
+    
+    // Both views measured their own time to visible tiles
+    QCOMPARE(visibleSpy.count(), 2);
+    
+    delete view1;
+    QCOMPARE(_scheduler->viewportCount(), 1);
+}
@@ -0,0 +1,85 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef QGCTileSchedulerTest_H
+#define QGCTileSchedulerTest_H
+
+#include "UnitTest.h"
+#include "QtLocationPlugin/QGCTileScheduler.h"
+
+class MockTileServer;
+
+/// @file
+///     @brief Unit test for the map tile download scheduler, against a local tile server stand-in
+
+/// Counts the results the scheduler hands back
+class TestTileRequester : public QObject, public QGCTileRequester
+{
+    Q_OBJECT
+    
+public:
+    TestTileRequester(void) : downloadedCount(0), failedCount(0) { }
+    
+    // From QGCTileRequester
+    void tileDownloaded(const QByteArray& data) { lastData = data; downloadedCount++; emit done(); }
+    void tileDownloadFailed(QNetworkReply::NetworkError error, const QString& errorString) { Q_UNUSED(error); Q_UNUSED(errorString); failedCount++; emit done(); }
+    
+    int         downloadedCount;
+    int         failedCount;
+    QByteArray  lastData;
+    
+signals:
+    void done(void);
+};
+
+class QGCTileSchedulerTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    QGCTileSchedulerTest(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _coalesce_test(void);
+    void _concurrency_test(void);
+    void _priority_test(void);
+    void _cancel_test(void);
+    void _timeToVisible_test(void);
+    void _multipleViews_test(void);
+    
+private:
+    QGCTileStore::TileCoord_t _coord(int zoom, int x, int y);
+    void _requestTile(int zoom, int x, int y, TestTileRequester* requester);
+    bool _waitForDone(TestTileRequester* requester, int count);
+    
+    static const int _mapType = 32;     ///< OpenPilot::OpenStreetMap
+    
+    MockTileServer*         _server;
+    QNetworkAccessManager*  _networkManager;
+    QGCTileScheduler*       _scheduler;
+};
+
+#endif
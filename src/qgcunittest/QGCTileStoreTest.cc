@@ -0,0 +1,379 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "QGCTileStoreTest.h"
+#include "QtLocationPlugin/QGCTileSeeder.h"
+#include "QtLocationPlugin/qgeotilefetcherqgc.h"
+#include "MockTileServer.h"
+#include "QGCTemporaryFile.h"
+
+#include <QSignalSpy>
+#include <QtLocation/private/qgeotiledmapreply_p.h>
+#include <QtLocation/private/qgeotilespec_p.h>
+
+#include <math.h>
+
+UT_REGISTER_TEST(QGCTileStoreTest)
+
+QGCTileStoreTest::QGCTileStoreTest(void)
+    : _store(NULL)
+{
+    
+}
+
+void QGCTileStoreTest::init(void)
+{
+    UnitTest::init();
+    
+    QGCTemporaryFile tempFile("QGCTileStoreTest.XXXXXX.db");
+    QVERIFY(tempFile.open());
+    _databaseFile = tempFile.fileName();
+    tempFile.close();
+    
+    _store = new QGCTileStore(_databaseFile, 1024 * 1024, this);
+    QVERIFY(_store->isOpen());
+}
+
+void QGCTileStoreTest::cleanup(void)
+{
+    delete _store;
+    _store = NULL;
+    QFile::remove(_databaseFile);
+    
+    UnitTest::cleanup();
+}
+
+QGCTileStore::TileCoord_t QGCTileStoreTest::_coord(int zoom, int x, int y)
+{
+    QGCTileStore::TileCoord_t coord;
+    
+    coord.mapType = _mapType;
+    coord.zoom = zoom;
+    coord.x = x;
+    coord.y = y;
+    
+    return coord;
+}
+
+/// Waits until the reply has finished
+bool QGCTileStoreTest::_waitForReply(QGeoTiledMapReply* reply)
+{
+    QSignalSpy finishedSpy(reply, SIGNAL(finished()));
+    
+    return reply->isFinished() || finishedSpy.wait(5000);
+}
+
+/// Tiles come back as stored, also after the database is reopened
+void QGCTileStoreTest::_storeFetch_test(void)
+{
+    QByteArray  data;
+    QString     format;
+    
+    QVERIFY(!_store->fetchTile(_coord(10, 1, 2), data, format));
+    QCOMPARE(_store->missCount(), (quint32)1);
+    
+    QVERIFY(_store->storeTile(_coord(10, 1, 2), MockTileServer::tileData(10, 1, 2), "png"));
+    QVERIFY(_store->storeTile(_coord(11, 1, 2), MockTileServer::tileData(11, 1, 2), "png"));
+    QCOMPARE(_store->tileCount(), 2);
+    QCOMPARE(_store->totalBytes(), (qint64)(MockTileServer::tileData(10, 1, 2).size() + MockTileServer::tileData(11, 1, 2).size()));
+    
+    QVERIFY(_store->fetchTile(_coord(10, 1, 2), data, format));
+    QCOMPARE(data, MockTileServer::tileData(10, 1, 2));
+    QCOMPARE(format, QString("png"));
+    QCOMPARE(_store->hitCount(), (quint32)1);
+    
+    // Replacing a tile keeps the byte count exact
+    qint64 totalBytes = _store->totalBytes();
+    QVERIFY(_store->storeTile(_coord(10, 1, 2), QByteArray(100, 'x'), "jpg"));
+    QCOMPARE(_store->tileCount(), 2);
+    QCOMPARE(_store->totalBytes(), totalBytes - MockTileServer::tileData(10, 1, 2).size() + 100);
+    
+    totalBytes = _store->totalBytes();
+    delete _store;
+    _store = new QGCTileStore(_databaseFile, 1024 * 1024, this);
+    QVERIFY(_store->isOpen());
+    QCOMPARE(_store->tileCount(), 2);
+    QCOMPARE(_store->totalBytes(), totalBytes);
+    QVERIFY(_store->fetchTile(_coord(11, 1, 2), data, format));
+    QCOMPARE(data, MockTileServer::tileData(11, 1, 2));
+    
+    _store->clear();
+    QCOMPARE(_store->tileCount(), 0);
+    QCOMPARE(_store->totalBytes(), (qint64)0);
+}
+
+/// Least recently used tiles are evicted first once the size limit is reached
+void QGCTileStoreTest::_lruEviction_test(void)
+{
+    const int   tileSize = 1000;
+    QByteArray  data;
+    QString     format;
+    
+    _store->setMaxBytes(3 * tileSize);
+    
+    for (int x=0; x<3; x++) {
+        QVERIFY(_store->storeTile(_coord(15, x, 0), QByteArray(tileSize, 'x'), "png"));
+    }
+    QCOMPARE(_store->tileCount(), 3);
+    
+    // Using tile 0 makes tile 1 the least recently used
+    QVERIFY(_store->fetchTile(_coord(15, 0, 0), data, format));
+    QVERIFY(_store->storeTile(_coord(15, 3, 0), QByteArray(tileSize, 'x'), "png"));
+    
+    QCOMPARE(_store->tileCount(), 3);
+    QVERIFY(_store->totalBytes() <= 3 * tileSize);
+    QVERIFY(_store->contains(_coord(15, 0, 0)));
+    QVERIFY(!_store->contains(_coord(15, 1, 0)));
+    QVERIFY(_store->contains(_coord(15, 2, 0)));
+    QVERIFY(_store->contains(_coord(15, 3, 0)));
+    
+    // Lowering the limit evicts immediately
+    _store->setMaxBytes(tileSize);
+    QCOMPARE(_store->tileCount(), 1);
+    QVERIFY(_store->contains(_coord(15, 3, 0)));
+}
+
+/// Pinned tiles are never evicted and do not count against the size limit
+void QGCTileStoreTest::_pinned_test(void)
+{
+    const int tileSize = 1000;
+    
+    _store->setMaxBytes(2 * tileSize);
+    
+    for (int x=0; x<3; x++) {
+        QVERIFY(_store->storeTile(_coord(15, x, 0), QByteArray(tileSize, 'x'), "png", true /* pinned */));
+    }
+    for (int x=3; x<6; x++) {
+        QVERIFY(_store->storeTile(_coord(15, x, 0), QByteArray(tileSize, 'x'), "png"));
+    }
+    
+    QCOMPARE(_store->tileCount(), 5);
+    QCOMPARE(_store->pinnedBytes(), (qint64)(3 * tileSize));
+    QCOMPARE(_store->totalBytes(), (qint64)(5 * tileSize));
+    for (int x=0; x<3; x++) {
+        QVERIFY(_store->contains(_coord(15, x, 0)));
+    }
+    QVERIFY(!_store->contains(_coord(15, 3, 0)));
+    
+    // Replacing a pinned tile keeps it pinned
+    QVERIFY(_store->storeTile(_coord(15, 0, 0), QByteArray(tileSize / 2, 'x'), "png"));
+    QCOMPARE(_store->pinnedBytes(), (qint64)(2 * tileSize + tileSize / 2));
+    
+    // A tile which is already in the store can be pinned in place
+    QVERIFY(_store->pinTile(_coord(15, 4, 0)));
+    QVERIFY(_store->pinTile(_coord(15, 4, 0)));
+    QVERIFY(!_store->pinTile(_coord(15, 3, 0)));
+    QCOMPARE(_store->pinnedBytes(), (qint64)(3 * tileSize + tileSize / 2));
+    
+    // Pinned bytes survive reopening the database
+    qint64 pinnedBytes = _store->pinnedBytes();
+    delete _store;
+    _store = new QGCTileStore(_databaseFile, 0, this);
+    QVERIFY(_store->isOpen());
+    QCOMPARE(_store->pinnedBytes(), pinnedBytes);
+    QCOMPARE(_store->totalBytes(), pinnedBytes);
+    QCOMPARE(_store->tileCount(), 4);
+    
+    _store->clear();
+    QCOMPARE(_store->pinnedBytes(), (qint64)0);
+}
+
+/// Queued tiles are served right away and written in a single batch
+void QGCTileStoreTest::_queueTile_test(void)
+{
+    const int   tileSize = 1000;
+    QByteArray  data;
+    QString     format;
+    
+    _store->setMaxBytes(3 * tileSize);
+    
+    for (int x=0; x<5; x++) {
+        _store->queueTile(_coord(15, x, 0), QByteArray(tileSize, (char)('a' + x)), "png");
+    }
+    QCOMPARE(_store->tileCount(), 0);
+    QVERIFY(_store->contains(_coord(15, 4, 0)));
+    QVERIFY(_store->fetchTile(_coord(15, 0, 0), data, format));
+    QCOMPARE(data, QByteArray(tileSize, 'a'));
+    
+    // The batch is written by the flush timer with one eviction pass. Using tile 0 kept it.
+    QTRY_COMPARE_WITH_TIMEOUT(_store->tileCount(), 3, 5000);
+    QCOMPARE(_store->totalBytes(), (qint64)(3 * tileSize));
+    QVERIFY(_store->contains(_coord(15, 0, 0)));
+    QVERIFY(!_store->contains(_coord(15, 1, 0)));
+    QVERIFY(!_store->contains(_coord(15, 2, 0)));
+    
+    // A stored tile supersedes a queued one
+    _store->queueTile(_coord(15, 5, 0), QByteArray(tileSize, 'q'), "png");
+    QVERIFY(_store->storeTile(_coord(15, 5, 0), QByteArray(tileSize, 's'), "png"));
+    _store->flush();
+    QVERIFY(_store->fetchTile(_coord(15, 5, 0), data, format));
+    QCOMPARE(data, QByteArray(tileSize, 's'));
+    
+    // Queued tiles are written when the store goes away
+    _store->queueTile(_coord(16, 0, 0), QByteArray(tileSize, 'x'), "png");
+    delete _store;
+    _store = new QGCTileStore(_databaseFile, 3 * tileSize, this);
+    QVERIFY(_store->isOpen());
+    QVERIFY(_store->contains(_coord(16, 0, 0)));
+}
+
+/// The store's tile math is shared by the seeder and the download scheduler
+void QGCTileStoreTest::_tileMath_test(void)
+{
+    QCOMPARE(QGCTileStore::longitudeToTileX(-180.0, 0), 0.0);
+    QCOMPARE(QGCTileStore::longitudeToTileX(0.0, 1), 1.0);
+    QCOMPARE(QGCTileStore::latitudeToTileY(0.0, 1), 1.0);
+    
+    // Latitudes beyond the mercator limit clamp to the edge rows
+    QVERIFY(fabs(QGCTileStore::latitudeToTileY(90.0, 0)) < 1e-6);
+    QVERIFY(fabs(QGCTileStore::latitudeToTileY(-90.0, 0) - 1.0) < 1e-6);
+    
+    // Zurich at zoom 15 is tile 17161/11472 in every slippy map provider
+    QCOMPARE((int)floor(QGCTileStore::longitudeToTileX(8.545, 15)), 17161);
+    QCOMPARE((int)floor(QGCTileStore::latitudeToTileY(47.397, 15)), 11472);
+}
+
+void QGCTileStoreTest::_tilesInPolygon_test(void)
+{
+    // The whole world is a single tile at zoom 0 and four at zoom 1
+    QList<QGeoCoordinate> world;
+    world << QGeoCoordinate(80, -170) << QGeoCoordinate(80, 170) << QGeoCoordinate(-80, 170) << QGeoCoordinate(-80, -170);
+    QCOMPARE(QGCTileSeeder::tilesInPolygon(_mapType, world, 0, 1).count(), 1 + 4);
+    
+    // A small area within a single tile at every zoom covers just that tile
+    QList<QGeoCoordinate> small;
+    small << QGeoCoordinate(47.3970, 8.5450) << QGeoCoordinate(47.3971, 8.5451) << QGeoCoordinate(47.3970, 8.5451);
+    QList<QGCTileStore::TileCoord_t> tiles = QGCTileSeeder::tilesInPolygon(_mapType, small, 10, 12);
+    QCOMPARE(tiles.count(), 3);
+    for (int i=0; i<tiles.count(); i++) {
+        QCOMPARE(tiles[i].zoom, 10 + i);
+        QCOMPARE(tiles[i].mapType, (int)_mapType);
+    }
+    
+    // A thin diagonal triangle only covers the tiles along its edges, not its bounding box
+    QList<QGeoCoordinate> diagonal;
+    diagonal << QGeoCoordinate(40, 0) << QGeoCoordinate(40, 0.01) << QGeoCoordinate(39, 1);
+    int boxTiles = QGCTileSeeder::tilesInPolygon(_mapType, QList<QGeoCoordinate>() << QGeoCoordinate(40, 0) << QGeoCoordinate(40, 1) << QGeoCoordinate(39, 1) << QGeoCoordinate(39, 0), 14, 14).count();
+    int diagonalTiles = QGCTileSeeder::tilesInPolygon(_mapType, diagonal, 14, 14).count();
+    QVERIFY(diagonalTiles < boxTiles / 2);
+}
+
+/// Seeding downloads each tile of the region once, after which the region is available without the server
+void QGCTileStoreTest::_seedRegion_test(void)
+{
+    MockTileServer server;
+    QVERIFY(server.start());
+    
+    QGCTileSeeder seeder(_store);
+    seeder.setUrlTemplate(server.urlTemplate());
+    
+    QList<QGeoCoordinate> region;
+    region << QGeoCoordinate(47.39, 8.54) << QGeoCoordinate(47.40, 8.54) << QGeoCoordinate(47.40, 8.56) << QGeoCoordinate(47.39, 8.56);
+    QList<QGCTileStore::TileCoord_t> tiles = QGCTileSeeder::tilesInPolygon(_mapType, region, 10, 15);
+    
+    // A tile the map viewed before seeding is pinned without downloading it again
+    const QGCTileStore::TileCoord_t& viewedTile = tiles.last();
+    QVERIFY(_store->storeTile(viewedTile, MockTileServer::tileData(viewedTile.zoom, viewedTile.x, viewedTile.y), "png"));
+    QCOMPARE(_store->pinnedBytes(), (qint64)0);
+    
+    QSignalSpy completeSpy(&seeder, SIGNAL(seedComplete(int, int, int)));
+    QVERIFY(seeder.seedRegion(_mapType, region, 10, 15));
+    QVERIFY(!seeder.seedRegion(_mapType, region, 10, 15));
+    QVERIFY(completeSpy.wait(10000));
+    
+    QList<QVariant> arguments = completeSpy.takeFirst();
+    QCOMPARE(arguments[0].toInt(), tiles.count() - 1);
+    QCOMPARE(arguments[1].toInt(), 1);
+    QCOMPARE(arguments[2].toInt(), 0);
+    QCOMPARE(server.requestCount(), tiles.count() - 1);
+    QCOMPARE(_store->tileCount(), tiles.count());
+    QCOMPARE(_store->pinnedBytes(), _store->totalBytes());
+    
+    // Seeding again finds everything in the store
+    QVERIFY(seeder.seedRegion(_mapType, region, 10, 15));
+    QVERIFY(completeSpy.count() == 1 || completeSpy.wait(10000));
+    arguments = completeSpy.takeFirst();
+    QCOMPARE(arguments[0].toInt(), 0);
+    QCOMPARE(arguments[1].toInt(), tiles.count());
+    QCOMPARE(server.requestCount(), tiles.count() - 1);
+    
+    // Offline the seeded tiles are still served and new tiles fail without being stored
+    server.setOffline(true);
+    foreach (const QGCTileStore::TileCoord_t& tile, tiles) {
+        QByteArray  data;
+        QString     format;
+        
+        QVERIFY(_store->fetchTile(tile, data, format));
+        QCOMPARE(data, MockTileServer::tileData(tile.zoom, tile.x, tile.y));
+    }
+    
+    QList<QGeoCoordinate> newRegion;
+    newRegion << QGeoCoordinate(-33.86, 151.20);
+    QVERIFY(seeder.seedRegion(_mapType, newRegion, 16, 16));
+    QVERIFY(completeSpy.wait(10000));
+    arguments = completeSpy.takeFirst();
+    QCOMPARE(arguments[0].toInt(), 0);
+    QCOMPARE(arguments[2].toInt(), 1);
+    QCOMPARE(_store->tileCount(), tiles.count());
+}
+
+/// The fetcher serves tiles from the store without going to the network, and stores the tiles it downloads
+void QGCTileStoreTest::_fetcherOfflineFirst_test(void)
+{
+    MockTileServer server;
+    QVERIFY(server.start());
+    
+    QGeoTileFetcherQGC fetcher;
+    fetcher.setTileStore(_store);
+    fetcher.setUrlTemplate(server.urlTemplate());
+    
+    QVERIFY(_store->storeTile(_coord(16, 10, 20), MockTileServer::tileData(16, 10, 20), "png"));
+    
+    QGeoTiledMapReply* reply = fetcher.getTileImage(QGeoTileSpec("QGroundControl", _mapType, 16, 10, 20));
+    QVERIFY(_waitForReply(reply));
+    QCOMPARE(reply->error(), QGeoTiledMapReply::NoError);
+    QCOMPARE(server.requestCount(), 0);
+    QCOMPARE(_store->hitCount(), (quint32)1);
+    delete reply;
+    
+    reply = fetcher.getTileImage(QGeoTileSpec("QGroundControl", _mapType, 16, 11, 20));
+    QVERIFY(_waitForReply(reply));
+    QCOMPARE(reply->error(), QGeoTiledMapReply::NoError);
+    QCOMPARE(server.requestCount(), 1);
+    delete reply;
+    
+    QByteArray  data;
+    QString     format;
+    QVERIFY(_store->fetchTile(_coord(16, 11, 20), data, format));
+    QCOMPARE(data, MockTileServer::tileData(16, 11, 20));
+    _store->flush();
+    QCOMPARE(_store->tileCount(), 2);
+    
+    // Offline the downloaded tile is still served
+    server.setOffline(true);
+    reply = fetcher.getTileImage(QGeoTileSpec("QGroundControl", _mapType, 16, 11, 20));
+    QVERIFY(_waitForReply(reply));
+    QCOMPARE(reply->error(), QGeoTiledMapReply::NoError);
+    QCOMPARE(server.requestCount(), 1);
+    delete reply;
+}
@@ -0,0 +1,67 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef QGCTileStoreTest_H
+#define QGCTileStoreTest_H
+
+#include "UnitTest.h"
+#include "QtLocationPlugin/QGCTileStore.h"
+
+class MockTileServer;
+class QGeoTiledMapReply;
+
+/// @file
+///     @brief Unit test for the offline tile store, region seeding and the map tile fetcher's use of the store,
+///             against a local tile server stand-in
+
+class QGCTileStoreTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    QGCTileStoreTest(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _storeFetch_test(void);
+    void _lruEviction_test(void);
+    void _pinned_test(void);
+    void _queueTile_test(void);
+    void _tileMath_test(void);
+    void _tilesInPolygon_test(void);
+    void _seedRegion_test(void);
+    void _fetcherOfflineFirst_test(void);
+    
+private:
+    QGCTileStore::TileCoord_t _coord(int zoom, int x, int y);
+    bool _waitForReply(QGeoTiledMapReply* reply);
+    
+    static const int _mapType = 32;     ///< OpenPilot::OpenStreetMap
+    
+    QString         _databaseFile;
+    QGCTileStore*   _store;
+};
+
+#endif
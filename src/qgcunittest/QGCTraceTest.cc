@@ -0,0 +1,134 @@
+/*=====================================================================
+ 
+ QGroundControl Open Source Ground Control Station
+ 
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ 
+ This file is part of the QGROUNDCONTROL project
+ 
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+ 
+ ======================================================================*/
+
+#include "QGCTraceTest.h"
+#include "QGCTrace.h"
+#include "QGCTemporaryFile.h"
+
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QtConcurrent>
+
+UT_REGISTER_TEST(QGCTraceTest)
+
+QGCTraceTest::QGCTraceTest(void)
+{
+    
+}
+
+/// Writes the current trace to a temporary file and returns the trace events from it
+QJsonArray QGCTraceTest::_writeAndLoadTrace(void)
+{
+    QGCTemporaryFile traceFile("QGCTraceTestXXXXXX.json");
+    QString errorString;
+    
+    // Only the file name is needed, QGCTrace opens the file itself
+    traceFile.open();
+    traceFile.close();
+    
+    bool success = QGCTrace::writeChromeTrace(traceFile.fileName(), errorString);
+    if (!success) {
+        qWarning() << errorString;
+        traceFile.remove();
+        return QJsonArray();
+    }
+    
+    traceFile.open(QIODevice::ReadOnly);
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(traceFile.readAll(), &parseError);
+    traceFile.remove();
+    
+    if (parseError.error != QJsonParseError::NoError) {
+        qWarning() << "Trace is not valid json" << parseError.errorString();
+        return QJsonArray();
+    }
+    
+    return doc.object().value("traceEvents").toArray();
+}
+
+int QGCTraceTest::_eventCount(const QJsonArray& events, const QString& name)
+{
+    int count = 0;
+    
+    foreach (const QJsonValue& event, events) {
+        if (event.toObject().value("name").toString() == name) {
+            count++;
+        }
+    }
+    
+    return count;
+}
+
+static void _traceWorker(void)
+{
+    qint64 start = QGCTrace::nsecsNow();
+    QGCTrace::addCompleteEvent("test", "QGCTraceTest::worker", start, 1000);
+}
+
+void QGCTraceTest::_chromeTrace_test(void)
+{
+    QGCTrace::setEnabled(true);
+    
+    for (int i=0; i<10; i++) {
+        qint64 start = QGCTrace::nsecsNow();
+        QGCTrace::addCompleteEvent("test", "QGCTraceTest::main", start, 2000);
+    }
+    QGCTrace::addCounter("test", "QGCTraceTest::counter", 42);
+    QtConcurrent::run(_traceWorker).waitForFinished();
+    
+    QJsonArray events = _writeAndLoadTrace();
+    QVERIFY(events.count() != 0);
+    QVERIFY(_eventCount(events, "QGCTraceTest::main") >= 10);
+    QVERIFY(_eventCount(events, "QGCTraceTest::counter") >= 1);
+    QVERIFY(_eventCount(events, "QGCTraceTest::worker") >= 1);
+    
+    // Worker events must be on a different thread than the main thread events
+    int mainThreadId = -1;
+    int workerThreadId = -1;
+    foreach (const QJsonValue& value, events) {
+        QJsonObject event = value.toObject();
+        if (event.value("name").toString() == "QGCTraceTest::main") {
+            mainThreadId = event.value("tid").toInt();
+            QCOMPARE(event.value("ph").toString(), QString("X"));
+            QCOMPARE(event.value("dur").toDouble(), 2.0);
+        } else if (event.value("name").toString() == "QGCTraceTest::worker") {
+            workerThreadId = event.value("tid").toInt();
+        }
+    }
+    QVERIFY(mainThreadId != workerThreadId);
+}
+
+void QGCTraceTest::_disabled_test(void)
+{
+    QGCTrace::setEnabled(false);
+    QGCTrace::addCounter("test", "QGCTraceTest::disabledCounter", 1);
+    {
+        QGCTraceScope scope("test", "QGCTraceTest::disabledScope");
+    }
+    QGCTrace::setEnabled(true);
+    
+    QJsonArray events = _writeAndLoadTrace();
+    QCOMPARE(_eventCount(events, "QGCTraceTest::disabledCounter"), 0);
+    QCOMPARE(_eventCount(events, "QGCTraceTest::disabledScope"), 0);
+}
@@ -0,0 +1,376 @@
+/*=====================================================================
+ 
+ QGroundControl Open Source Ground Control Station
+ 
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ 
+ This file is part of the QGROUNDCONTROL project
+ 
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+ 
+ ======================================================================*/
+
+#include "ReceivePipelineBenchmark.h"
+#include "OfflineVehicleFixture.h"
+#include "MAVLinkProtocol.h"
+#include "MAVLinkDecoder.h"
+#include "MockLink.h"
+#include "Vehicle.h"
+#include "UAS.h"
+#include "LinechartPlot.h"
+
+#include <QtEndian>
+#include <QMap>
+#include <math.h>
+
+UT_REGISTER_TEST(ReceivePipelineBenchmark)
+
+const char* ReceivePipelineBenchmark::_corpusEnvironmentVariable = "QGC_BENCHMARK_CORPUS";
+
+/// Exposes MAVLinkDecoder::emitFieldValue to the benchmark
+class BenchmarkMAVLinkDecoder : public MAVLinkDecoder
+{
+public:
+    BenchmarkMAVLinkDecoder(MAVLinkProtocol* protocol) : MAVLinkDecoder(protocol) { }
+    
+    /// Emits all fields of the message, in the same way as MAVLinkDecoder::receiveMessage
+    void emitFieldValues(const mavlink_message_t& message, quint64 time)
+    {
+        memcpy(receivedMessages + message.msgid, &message, sizeof(mavlink_message_t));
+        for (unsigned int i=0; i<messageInfo[message.msgid].num_fields; i++) {
+            emitFieldValue(&receivedMessages[message.msgid], i, time);
+        }
+    }
+};
+
+ReceivePipelineBenchmark::ReceivePipelineBenchmark(void)
+    : _corpusVehicleId(0)
+    , _fixture(NULL)
+    , _vehicle(NULL)
+{
+    
+}
+
+void ReceivePipelineBenchmark::initTestCase(void)
+{
+    QByteArray log;
+    QString corpusFilename = QString::fromLocal8Bit(qgetenv(_corpusEnvironmentVariable));
+    
+    if (corpusFilename.isEmpty()) {
+        log = _syntheticCorpus();
+    } else {
+        QFile corpusFile(corpusFilename);
+        QVERIFY2(corpusFile.open(QIODevice::ReadOnly), qPrintable(corpusFile.errorString()));
+        log = corpusFile.readAll();
+    }
+    
+    QVERIFY(_parseCorpus(log));
+    qDebug() << "Corpus" << (corpusFilename.isEmpty() ? QString("synthetic") : corpusFilename) << "messages:" << _corpus.count() << "bytes:" << _corpusBytes.count();
+}
+
+void ReceivePipelineBenchmark::init(void)
+{
+    UnitTest::init();
+    
+    _fixture = new OfflineVehicleFixture();
+}
+
+void ReceivePipelineBenchmark::cleanup(void)
+{
+    delete _fixture;
+    _fixture = NULL;
+    _vehicle = NULL;
+    
+    UnitTest::cleanup();
+}
+
+/// Generates a fixed telemetry log in .mavlink format: big endian usec timestamp followed by the packet
+QByteArray ReceivePipelineBenchmark::_syntheticCorpus(void)
+{
+    const uint8_t   systemId = 1;
+    const uint8_t   componentId = MAV_COMP_ID_IMU;
+    const int       tickMsecs = 20;
+    
+    QByteArray log;
+    
+    for (int msecs=0; msecs<_syntheticCorpusSecs * 1000; msecs+=tickMsecs) {
+        QList<mavlink_message_t> messages;
+        mavlink_message_t msg;
+        double seconds = msecs / 1000.0;
+        
+        if (msecs % 1000 == 0) {
+            mavlink_msg_heartbeat_pack_chan(systemId, componentId, _corpusChannel, &msg, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, MAV_MODE_FLAG_CUSTOM_MODE_ENABLED, 0, MAV_STATE_ACTIVE);
+            messages << msg;
+        }
+        if (msecs % 500 == 0) {
+            mavlink_msg_sys_status_pack_chan(systemId, componentId, _corpusChannel, &msg, 0, 0, 0, 250, 12400 - msecs / 100, 1000, 90, 0, 0, 0, 0, 0, 0);
+            messages << msg;
+        }
+        if (msecs % 200 == 0) {
+            mavlink_msg_gps_raw_int_pack_chan(systemId, componentId, _corpusChannel, &msg, msecs * 1000, 3, 473977419 + msecs, 85455938 + msecs, 488000, 100, 150, 500, 9000, 12);
+            messages << msg;
+        }
+        if (msecs % 100 == 0) {
+            mavlink_msg_global_position_int_pack_chan(systemId, componentId, _corpusChannel, &msg, msecs, 473977419 + msecs, 85455938 + msecs, 488000 + msecs / 10, msecs / 10, 500, 0, -10, 9000);
+            messages << msg;
+            mavlink_msg_vfr_hud_pack_chan(systemId, componentId, _corpusChannel, &msg, 5.0f, 5.0f, 90, 50, 488.0f + seconds, 1.0f);
+            messages << msg;
+        }
+        mavlink_msg_attitude_pack_chan(systemId, componentId, _corpusChannel, &msg, msecs, 0.2 * sin(seconds), 0.1 * cos(seconds), fmod(seconds, 2.0 * M_PI) - M_PI, 0.2 * cos(seconds), -0.1 * sin(seconds), 1.0);
+        messages << msg;
+        mavlink_msg_highres_imu_pack_chan(systemId, componentId, _corpusChannel, &msg, msecs * 1000, 0.1 * sin(seconds), 0.1 * cos(seconds), -9.81, 0.0, 0.0, 1.0, 0.21, 0.0, 0.42, 1013.25, 0.0, 488.0, 25.0, 0x1FFF);
+        messages << msg;
+        
+        foreach (const mavlink_message_t& message, messages) {
+            uint8_t buffer[MAVLINK_MAX_PACKET_LEN + sizeof(quint64)];
+            
+            qToBigEndian((quint64)msecs * 1000, buffer);
+            int len = mavlink_msg_to_send_buffer(buffer + sizeof(quint64), &message) + sizeof(quint64);
+            log.append((const char*)buffer, len);
+        }
+    }
+    
+    return log;
+}
+
+/// Parses a .mavlink log into _corpus and _corpusBytes
+bool ReceivePipelineBenchmark::_parseCorpus(const QByteArray& log)
+{
+    mavlink_message_t   message;
+    mavlink_status_t    status;
+    int                 position = 0;
+    
+    _corpus.clear();
+    _corpusBytes.clear();
+    _corpusVehicleId = 0;
+    
+    while (position + (int)sizeof(quint64) < log.count()) {
+        CorpusMessage_t corpusMessage;
+        
+        corpusMessage.timestampUsecs = qFromBigEndian<quint64>((const uchar*)log.constData() + position);
+        position += sizeof(quint64);
+        
+        if (position + 1 >= log.count() || (uint8_t)log[position] != MAVLINK_STX) {
+            qWarning() << "Corpus is not a valid .mavlink log, offset" << position;
+            return false;
+        }
+        
+        int packetLength = (uint8_t)log[position + 1] + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+        bool decoded = false;
+        for (int i=0; i<packetLength && position + i < log.count(); i++) {
+            if (mavlink_parse_char(_corpusChannel, (uint8_t)log[position + i], &message, &status) == 1) {
+                decoded = true;
+            }
+        }
+        
+        if (decoded) {
+            corpusMessage.message = message;
+            _corpus.append(corpusMessage);
+            
+            if (message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+                if (_corpusVehicleId == 0) {
+                    _corpusVehicleId = message.sysid;
+                }
+            } else {
+                // Heartbeats create vehicles, which is not part of the parsing cost
+                _corpusBytes.append(log.mid(position, packetLength));
+            }
+        }
+        
+        position += packetLength;
+    }
+    
+    if (_corpusVehicleId == 0 && _corpus.count()) {
+        _corpusVehicleId = _corpus[0].message.sysid;
+    }
+    
+    return _corpus.count() != 0;
+}
+
+void ReceivePipelineBenchmark::_createVehicle(void)
+{
+    _vehicle = _fixture->createVehicle(_corpusVehicleId);
+}
+
+/// Byte stream parsing and dispatch in MAVLinkProtocol::receiveBytes
+void ReceivePipelineBenchmark::_parseBytes_benchmark(void)
+{
+    MAVLinkProtocol* mavlink = MAVLinkProtocol::instance();
+    
+    QBENCHMARK {
+        mavlink->receiveBytes(_fixture->link(), _corpusBytes);
+    }
+}
+
+/// Message decoding in UAS::receiveMessage, without the Vehicle connected to the resulting signals
+void ReceivePipelineBenchmark::_uasReceiveMessage_benchmark(void)
+{
+    _createVehicle();
+    UAS* uas = _vehicle->uas();
+    QObject::disconnect(uas, 0, _vehicle, 0);
+    
+    QBENCHMARK {
+        foreach (const CorpusMessage_t& corpusMessage, _corpus) {
+            uas->receiveMessage(corpusMessage.message);
+        }
+    }
+}
+
+void ReceivePipelineBenchmark::_uasReceiveMessagePerMessage_benchmark_data(void)
+{
+    mavlink_message_info_t  rgMessageInfo[256] = MAVLINK_MESSAGE_INFO;
+    QMap<int, int>          msgidCounts;
+    
+    QTest::addColumn<int>("msgid");
+    
+    foreach (const CorpusMessage_t& corpusMessage, _corpus) {
+        msgidCounts[corpusMessage.message.msgid]++;
+    }
+    foreach (int msgid, msgidCounts.keys()) {
+        QTest::newRow(rgMessageInfo[msgid].name ? rgMessageInfo[msgid].name : qPrintable(QString::number(msgid))) << msgid;
+    }
+}
+
+/// Cost of UAS::receiveMessage for each message id in the corpus. Each iteration decodes a batch of
+/// _perMessageBatchCount messages of the same id, taken in order from the corpus.
+void ReceivePipelineBenchmark::_uasReceiveMessagePerMessage_benchmark(void)
+{
+    QFETCH(int, msgid);
+    
+    QList<mavlink_message_t> messages;
+    foreach (const CorpusMessage_t& corpusMessage, _corpus) {
+        if (corpusMessage.message.msgid == msgid) {
+            messages.append(corpusMessage.message);
+        }
+    }
+    QVERIFY(messages.count() != 0);
+    
+    _createVehicle();
+    UAS* uas = _vehicle->uas();
+    QObject::disconnect(uas, 0, _vehicle, 0);
+    
+    QBENCHMARK {
+        for (int i=0; i<_perMessageBatchCount; i++) {
+            uas->receiveMessage(messages[i % messages.count()]);
+        }
+    }
+}
+
+/// Field by field decoding in MAVLinkDecoder::emitFieldValue which feeds the analyze and plot views
+void ReceivePipelineBenchmark::_decoderEmitFieldValue_benchmark(void)
+{
+    BenchmarkMAVLinkDecoder* decoder = new BenchmarkMAVLinkDecoder(MAVLinkProtocol::instance());
+    
+    QBENCHMARK {
+        foreach (const CorpusMessage_t& corpusMessage, _corpus) {
+            decoder->emitFieldValues(corpusMessage.message, corpusMessage.timestampUsecs / 1000);
+        }
+    }
+    
+    decoder->quit();
+    decoder->wait();
+    delete decoder;
+}
+
+/// Appending the corpus attitude values to a fresh time series
+void ReceivePipelineBenchmark::_timeSeriesAppend_benchmark(void)
+{
+    QList<QPair<quint64, double> > values;
+    
+    foreach (const CorpusMessage_t& corpusMessage, _corpus) {
+        if (corpusMessage.message.msgid == MAVLINK_MSG_ID_ATTITUDE) {
+            values.append(qMakePair(corpusMessage.timestampUsecs / 1000, (double)mavlink_msg_attitude_get_roll(&corpusMessage.message)));
+        }
+    }
+    QVERIFY(values.count() != 0);
+    
+    QBENCHMARK {
+        TimeSeriesData timeSeries(NULL, "roll", LinechartPlot::DEFAULT_PLOT_INTERVAL);
+        for (int i=0; i<values.count(); i++) {
+            timeSeries.append(values[i].first, values[i].second);
+        }
+    }
+}
+
+/// Repainting a visible plot holding the corpus attitude and position curves
+void ReceivePipelineBenchmark::_linechartPaintRealtime_benchmark(void)
+{
+    LinechartPlot plot;
+    
+    plot.enforceGroundTime(false);
+    plot.setActive(true);
+    plot.setAutoScroll(true);
+    
+    foreach (const CorpusMessage_t& corpusMessage, _corpus) {
+        quint64 msecs = corpusMessage.timestampUsecs / 1000;
+        
+        if (corpusMessage.message.msgid == MAVLINK_MSG_ID_ATTITUDE) {
+            mavlink_attitude_t attitude;
+            mavlink_msg_attitude_decode(&corpusMessage.message, &attitude);
+            plot.appendData("ATTITUDE.roll", msecs, attitude.roll);
+            plot.appendData("ATTITUDE.pitch", msecs, attitude.pitch);
+            plot.appendData("ATTITUDE.yaw", msecs, attitude.yaw);
+        } else if (corpusMessage.message.msgid == MAVLINK_MSG_ID_GLOBAL_POSITION_INT) {
+            plot.appendData("GLOBAL_POSITION_INT.relative_alt", msecs, mavlink_msg_global_position_int_get_relative_alt(&corpusMessage.message) / 1000.0);
+        }
+    }
+    
+    plot.resize(800, 400);
+    plot.show();
+    bool exposed = QTest::qWaitForWindowExposed(&plot);
+    Q_UNUSED(exposed);  // Headless runs still measure the plot update, only without the paint
+    
+    QBENCHMARK {
+        plot.paintRealtime();
+    }
+}
+
+/// Vehicle property updates driven by the UAS signals for attitude, speed, altitude and position
+void ReceivePipelineBenchmark::_vehiclePropertyUpdate_benchmark(void)
+{
+    _createVehicle();
+    UAS* uas = _vehicle->uas();
+    
+    QBENCHMARK {
+        foreach (const CorpusMessage_t& corpusMessage, _corpus) {
+            const mavlink_message_t& message = corpusMessage.message;
+            quint64 usecs = corpusMessage.timestampUsecs;
+            
+            switch (message.msgid) {
+                case MAVLINK_MSG_ID_ATTITUDE:
+                    emit uas->attitudeChanged(uas,
+                                              mavlink_msg_attitude_get_roll(&message),
+                                              mavlink_msg_attitude_get_pitch(&message),
+                                              mavlink_msg_attitude_get_yaw(&message),
+                                              usecs);
+                    break;
+                case MAVLINK_MSG_ID_VFR_HUD:
+                    emit uas->speedChanged(uas, mavlink_msg_vfr_hud_get_groundspeed(&message), mavlink_msg_vfr_hud_get_airspeed(&message), usecs);
+                    break;
+                case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+                {
+                    double altitudeAMSL = mavlink_msg_global_position_int_get_alt(&message) / 1000.0;
+                    double altitudeRelative = mavlink_msg_global_position_int_get_relative_alt(&message) / 1000.0;
+                    
+                    emit uas->altitudeChanged(uas, altitudeAMSL, altitudeAMSL, altitudeRelative, -mavlink_msg_global_position_int_get_vz(&message) / 100.0, usecs);
+                    emit uas->latitudeChanged(mavlink_msg_global_position_int_get_lat(&message) / 1E7, "latitude");
+                    emit uas->longitudeChanged(mavlink_msg_global_position_int_get_lon(&message) / 1E7, "longitude");
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+}
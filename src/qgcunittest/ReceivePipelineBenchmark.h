@@ -0,0 +1,83 @@
+/*=====================================================================
+ 
+ QGroundControl Open Source Ground Control Station
+ 
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ 
+ This file is part of the QGROUNDCONTROL project
+ 
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+ 
+ ======================================================================*/
+
+#ifndef ReceivePipelineBenchmark_H
+#define ReceivePipelineBenchmark_H
+
+#include "UnitTest.h"
+#include "QGCMAVLink.h"
+
+class OfflineVehicleFixture;
+class Vehicle;
+
+/// @file
+///     @brief Micro-benchmarks for each stage of the mavlink receive pipeline. Each stage is measured separately
+///             against the same telemetry corpus. By default a fixed synthetic corpus is used. Set the
+///             QGC_BENCHMARK_CORPUS environment variable to the path of a recorded .mavlink log to use that instead.
+///             Use --unittest-output:<directory> to write machine readable results.
+
+class ReceivePipelineBenchmark : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    ReceivePipelineBenchmark(void);
+    
+private slots:
+    void initTestCase(void);
+    void init(void);
+    void cleanup(void);
+    
+    void _parseBytes_benchmark(void);
+    void _uasReceiveMessage_benchmark(void);
+    void _uasReceiveMessagePerMessage_benchmark_data(void);
+    void _uasReceiveMessagePerMessage_benchmark(void);
+    void _decoderEmitFieldValue_benchmark(void);
+    void _timeSeriesAppend_benchmark(void);
+    void _linechartPaintRealtime_benchmark(void);
+    void _vehiclePropertyUpdate_benchmark(void);
+    
+private:
+    typedef struct {
+        quint64             timestampUsecs;     ///< Timestamp from the log
+        mavlink_message_t   message;
+    } CorpusMessage_t;
+    
+    QByteArray _syntheticCorpus(void);
+    bool _parseCorpus(const QByteArray& log);
+    void _createVehicle(void);
+    
+    static const int _corpusChannel = MAVLINK_COMM_NUM_BUFFERS - 1;   ///< Mavlink channel used to parse the corpus
+    static const int _syntheticCorpusSecs = 20;
+    static const int _perMessageBatchCount = 1000;     ///< Messages decoded per iteration of the per message benchmark
+    static const char* _corpusEnvironmentVariable;
+    
+    QList<CorpusMessage_t>  _corpus;            ///< All messages from the corpus
+    QByteArray              _corpusBytes;       ///< Raw packets from the corpus, without heartbeats
+    int                     _corpusVehicleId;   ///< System id of the vehicle in the corpus
+    
+    OfflineVehicleFixture*  _fixture;
+    Vehicle*                _vehicle;
+};
+
+#endif
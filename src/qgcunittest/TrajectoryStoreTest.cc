@@ -0,0 +1,127 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "TrajectoryStoreTest.h"
+
+#include <QSignalSpy>
+
+UT_REGISTER_TEST(TrajectoryStoreTest)
+
+TrajectoryStoreTest::TrajectoryStoreTest(void)
+    : _store(NULL)
+{
+    
+}
+
+void TrajectoryStoreTest::init(void)
+{
+    UnitTest::init();
+    
+    _store = new TrajectoryStore(this);
+    Q_CHECK_PTR(_store);
+}
+
+void TrajectoryStoreTest::cleanup(void)
+{
+    delete _store;
+    _store = NULL;
+    
+    UnitTest::cleanup();
+}
+
+/// @return Coordinate offset in meters from a fixed origin
+QGeoCoordinate TrajectoryStoreTest::_offset(double northMeters, double eastMeters)
+{
+    QGeoCoordinate origin(47.3977419, 8.5455938);
+    
+    return origin.atDistanceAndAzimuth(northMeters, 0).atDistanceAndAzimuth(eastMeters, 90);
+}
+
+/// Samples along a straight line collapse to the two end points
+void TrajectoryStoreTest::_straightLine_test(void)
+{
+    QSignalSpy appendedSpy(_store, SIGNAL(pointAppended(QGeoCoordinate)));
+    QSignalSpy movedSpy(_store, SIGNAL(lastPointMoved(QGeoCoordinate,QGeoCoordinate)));
+    
+    for (int i=0; i<100; i++) {
+        _store->append(_offset(i * 5.0, 0), 10.0);
+    }
+    
+    QCOMPARE(_store->count(), 2);
+    QCOMPARE(appendedSpy.count(), 2);
+    QCOMPARE(movedSpy.count(), 98);
+    QVERIFY(_store->coordinate(1).distanceTo(_offset(99 * 5.0, 0)) < 0.1);
+}
+
+/// A turn leaves a point at the corner
+void TrajectoryStoreTest::_corner_test(void)
+{
+    for (int i=0; i<20; i++) {
+        _store->append(_offset(i * 5.0, 0), 10.0);
+    }
+    for (int i=1; i<20; i++) {
+        _store->append(_offset(19 * 5.0, i * 5.0), 10.0);
+    }
+    
+    QCOMPARE(_store->count(), 3);
+    QVERIFY(_store->coordinate(1).distanceTo(_offset(19 * 5.0, 0)) < 0.1);
+    QCOMPARE(_store->path().count(), 3);
+}
+
+/// The point count never exceeds the cap and the path is re-simplified in one go
+void TrajectoryStoreTest::_maxPoints_test(void)
+{
+    _store->setMaxPoints(100);
+    
+    QSignalSpy pathSpy(_store, SIGNAL(pathChanged()));
+    
+    // Zig-zag so that every sample is retained until the cap is hit
+    for (int i=0; i<1000; i++) {
+        _store->append(_offset(i * 5.0, (i % 2) * 20.0), 10.0);
+        QVERIFY(_store->count() <= 100);
+    }
+    
+    QVERIFY(pathSpy.count() > 0);
+    
+    // The first and latest points are always kept
+    QVERIFY(_store->coordinate(0).distanceTo(_offset(0, 0)) < 0.1);
+    QVERIFY(_store->coordinate(_store->count() - 1).distanceTo(_offset(999 * 5.0, 20.0)) < 0.1);
+}
+
+void TrajectoryStoreTest::_clear_test(void)
+{
+    for (int i=0; i<10; i++) {
+        _store->append(_offset(i * 5.0, (i % 2) * 20.0), 10.0);
+    }
+    QVERIFY(_store->count() != 0);
+    
+    QSignalSpy pathSpy(_store, SIGNAL(pathChanged()));
+    _store->clear();
+    
+    QCOMPARE(_store->count(), 0);
+    QCOMPARE(pathSpy.count(), 1);
+    
+    // Invalid coordinates are ignored
+    _store->append(QGeoCoordinate(), 0);
+    QCOMPARE(_store->count(), 0);
+}
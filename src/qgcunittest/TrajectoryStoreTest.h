@@ -0,0 +1,55 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef TrajectoryStoreTest_H
+#define TrajectoryStoreTest_H
+
+#include "UnitTest.h"
+#include "TrajectoryStore.h"
+
+/// @file
+///     @brief TrajectoryStore unit test
+
+class TrajectoryStoreTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    TrajectoryStoreTest(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _straightLine_test(void);
+    void _corner_test(void);
+    void _maxPoints_test(void);
+    void _clear_test(void);
+    
+private:
+    QGeoCoordinate _offset(double northMeters, double eastMeters);
+    
+    TrajectoryStore* _store;
+};
+
+#endif
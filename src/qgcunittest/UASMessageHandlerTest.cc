@@ -0,0 +1,143 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "UASMessageHandlerTest.h"
+#include "UASMessageHandler.h"
+
+#include <QSignalSpy>
+
+UT_REGISTER_TEST(UASMessageHandlerTest)
+
+UASMessageHandlerTest::UASMessageHandlerTest(void)
+{
+    
+}
+
+/// Once full, the oldest messages are dropped and memory stays at capacity
+void UASMessageHandlerTest::_ringWrap_test(void)
+{
+    UASMessageHandler* msgHandler = UASMessageHandler::instance();
+    msgHandler->setCapacity(10);
+    
+    QSignalSpy spyCount(msgHandler, SIGNAL(textMessageCountChanged(int)));
+    
+    for (int i=0; i<25; i++) {
+        msgHandler->handleTextMessage(1, 1, MAV_SEVERITY_INFO, QString("message %1").arg(i));
+    }
+    
+    QCOMPARE(msgHandler->capacity(), 10);
+    QCOMPARE(msgHandler->messageCount(), 10);
+    QCOMPARE(msgHandler->message(0)->getText(), QString("message 15"));
+    QCOMPARE(msgHandler->message(9)->getText(), QString("message 24"));
+    QVERIFY(msgHandler->message(10) == NULL);
+    
+    // The count signal reports all messages received, not just those kept
+    QCOMPARE(spyCount.count(), 25);
+    QCOMPARE(spyCount.last()[0].toInt(), 25);
+    
+    msgHandler->clearMessages();
+    QCOMPARE(msgHandler->messageCount(), 0);
+    QVERIFY(msgHandler->message(0) == NULL);
+}
+
+/// Severity and component indices track the kept messages as old ones are dropped
+void UASMessageHandlerTest::_indices_test(void)
+{
+    UASMessageHandler* msgHandler = UASMessageHandler::instance();
+    msgHandler->setCapacity(4);
+    
+    msgHandler->handleTextMessage(1, 1, MAV_SEVERITY_ERROR, "error");
+    msgHandler->handleTextMessage(1, 2, MAV_SEVERITY_WARNING, "warning");
+    msgHandler->handleTextMessage(1, 2, MAV_SEVERITY_INFO, "info 1");
+    msgHandler->handleTextMessage(1, 2, MAV_SEVERITY_INFO, "info 2");
+    
+    QCOMPARE(msgHandler->severityCount(MAV_SEVERITY_ERROR), 1);
+    QCOMPARE(msgHandler->severityCount(MAV_SEVERITY_WARNING), 1);
+    QCOMPARE(msgHandler->severityCount(MAV_SEVERITY_INFO), 2);
+    QCOMPARE(msgHandler->componentCount(1), 1);
+    QCOMPARE(msgHandler->componentCount(2), 3);
+    QCOMPARE(msgHandler->severityMessage(MAV_SEVERITY_INFO, 0)->getText(), QString("info 1"));
+    QCOMPARE(msgHandler->severityMessage(MAV_SEVERITY_INFO, 1)->getText(), QString("info 2"));
+    QVERIFY(msgHandler->severityMessage(MAV_SEVERITY_INFO, 2) == NULL);
+    QCOMPARE(msgHandler->componentMessage(2, 0)->getText(), QString("warning"));
+    
+    // Pushes out the error
+    msgHandler->handleTextMessage(1, 3, MAV_SEVERITY_INFO, "info 3");
+    
+    QCOMPARE(msgHandler->severityCount(MAV_SEVERITY_ERROR), 0);
+    QVERIFY(msgHandler->severityMessage(MAV_SEVERITY_ERROR, 0) == NULL);
+    QCOMPARE(msgHandler->severityCount(MAV_SEVERITY_INFO), 3);
+    QCOMPARE(msgHandler->severityMessage(MAV_SEVERITY_INFO, 2)->getText(), QString("info 3"));
+    QCOMPARE(msgHandler->componentCount(1), 0);
+    QCOMPARE(msgHandler->componentCount(3), 1);
+    QCOMPARE(msgHandler->componentMessage(3, 0)->getText(), QString("info 3"));
+    
+    // Pushes out the warning, the component index drops its oldest entry
+    msgHandler->handleTextMessage(1, 2, MAV_SEVERITY_INFO, "info 4");
+    QCOMPARE(msgHandler->componentCount(2), 3);
+    QCOMPARE(msgHandler->componentMessage(2, 0)->getText(), QString("info 1"));
+    QCOMPARE(msgHandler->componentMessage(2, 2)->getText(), QString("info 4"));
+    
+    // Out of range values are tolerated
+    msgHandler->handleTextMessage(1, 300, 42, "bogus");
+    QCOMPARE(msgHandler->severityCount(42), 1);
+    QCOMPARE(msgHandler->componentCount(300), 0);
+    QVERIFY(msgHandler->componentMessage(300, 0) == NULL);
+}
+
+/// Read and reset counts are independent of the ring
+void UASMessageHandlerTest::_counts_test(void)
+{
+    UASMessageHandler* msgHandler = UASMessageHandler::instance();
+    msgHandler->setCapacity(2);
+    
+    for (int i=0; i<5; i++) {
+        msgHandler->handleTextMessage(1, 1, MAV_SEVERITY_CRITICAL, "critical");
+    }
+    msgHandler->handleTextMessage(1, 1, MAV_SEVERITY_NOTICE, "notice");
+    msgHandler->handleTextMessage(1, 1, MAV_SEVERITY_DEBUG, "debug");
+    
+    QCOMPARE(msgHandler->getErrorCount(), 5);
+    QCOMPARE(msgHandler->getErrorCount(), 0);
+    QCOMPARE(msgHandler->getErrorCountTotal(), 5);
+    QCOMPARE(msgHandler->getWarningCount(), 1);
+    QCOMPARE(msgHandler->getNormalCount(), 1);
+    QVERIFY(msgHandler->getLatestError().contains("critical"));
+}
+
+/// Html is only built on request and is rebuilt when a slot is reused
+void UASMessageHandlerTest::_lazyFormat_test(void)
+{
+    UASMessageHandler* msgHandler = UASMessageHandler::instance();
+    msgHandler->setCapacity(1);
+    
+    msgHandler->handleTextMessage(1, 50, MAV_SEVERITY_WARNING, "first");
+    UASMessage* message = msgHandler->message(0);
+    QVERIFY(message->getFormatedText().contains("COMP:50"));
+    QVERIFY(message->getFormatedText().contains("Warning: first"));
+    
+    msgHandler->handleTextMessage(1, 51, MAV_SEVERITY_INFO, "second");
+    QVERIFY(msgHandler->message(0) == message);
+    QVERIFY(message->getFormatedText().contains("Info: second"));
+    QVERIFY(!message->getFormatedText().contains("first"));
+}
@@ -0,0 +1,46 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef UASMessageHandlerTest_H
+#define UASMessageHandlerTest_H
+
+#include "UnitTest.h"
+
+/// @file
+///     @brief UASMessageHandler unit test
+
+class UASMessageHandlerTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    UASMessageHandlerTest(void);
+    
+private slots:
+    void _ringWrap_test(void);
+    void _indices_test(void);
+    void _counts_test(void);
+    void _lazyFormat_test(void);
+};
+
+#endif
@@ -81,7 +81,7 @@ QList<QObject*>& UnitTest::_testList(void)
 	return tests;
 }
 
-int UnitTest::run(QString& singleTest)
+int UnitTest::run(QString& singleTest, const QString& outputDirectory)
 {
     int ret = 0;
     
@@ -89,6 +89,11 @@ int UnitTest::run(QString& singleTest)
         if (singleTest.isEmpty() || singleTest == test->objectName()) {
             QStringList args;
             args << "*" << "-maxwarnings" << "0";
+            if (!outputDirectory.isEmpty()) {
+                // Machine readable results (including benchmark results) in addition to the normal console output
+                args << "-o" << QString("%1,xml").arg(QDir(outputDirectory).filePath(test->objectName() + ".xml"));
+                args << "-o" << "-,txt";
+            }
             ret += QTest::qExec(test, args);
         }
     }
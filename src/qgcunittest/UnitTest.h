@@ -51,7 +51,8 @@ public:
     
     /// @brief Called to run all the registered unit tests
     ///     @param singleTest Name of test to just run a single test
-    static int run(QString& singleTest);
+    ///     @param outputDirectory If not empty, results for each test are also written to <outputDirectory>/<test name>.xml
+    static int run(QString& singleTest, const QString& outputDirectory = QString());
     
     /// @brief Sets up for an expected QGCMessageBox
     ///     @param response Response to take on message box
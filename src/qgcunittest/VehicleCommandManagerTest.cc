@@ -0,0 +1,224 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "VehicleCommandManagerTest.h"
+#include "VehicleCommandManager.h"
+#include "LinkManager.h"
+#include "MultiVehicleManager.h"
+#include "MockLink.h"
+#include "UAS.h"
+
+#include <QSignalSpy>
+#include <QElapsedTimer>
+
+UT_REGISTER_TEST(VehicleCommandManagerTest)
+
+VehicleCommandManagerTest::VehicleCommandManagerTest(void)
+    : _mockLink(NULL)
+    , _commandManager(NULL)
+{
+    
+}
+
+void VehicleCommandManagerTest::init(void)
+{
+    UnitTest::init();
+    
+    _mockLink = new MockLink();
+    Q_CHECK_PTR(_mockLink);
+    LinkManager::instance()->_addLink(_mockLink);
+    LinkManager::instance()->connectLink(_mockLink);
+    
+    // Wait for the Vehicle to work it's way through the various threads
+    QSignalSpy spyVehicle(MultiVehicleManager::instance(), SIGNAL(activeVehicleChanged(Vehicle*)));
+    QCOMPARE(spyVehicle.wait(5000), true);
+    
+    _commandManager = MultiVehicleManager::instance()->activeVehicle()->commandManager();
+    QVERIFY(_commandManager);
+}
+
+void VehicleCommandManagerTest::cleanup(void)
+{
+    _commandManager = NULL;
+    
+    LinkManager::instance()->disconnectLink(_mockLink);
+    _mockLink = NULL;
+    QTest::qWait(1000); // Need to allow signals to move between threads
+    
+    UnitTest::cleanup();
+}
+
+/// Waits until the spy has recorded the specified number of command results
+bool VehicleCommandManagerTest::_waitForResults(QSignalSpy& spy, int count)
+{
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    while (spy.count() < count && waitTimer.elapsed() < _resultWaitMsecs) {
+        spy.wait(_resultWaitMsecs - waitTimer.elapsed());
+    }
+    return spy.count() == count;
+}
+
+/// Different commands are in flight at the same time and each is completed by its own ack
+void VehicleCommandManagerTest::_pipelined_test(void)
+{
+    QSignalSpy spyResult(_commandManager, SIGNAL(commandResult(int, int, int, bool)));
+    
+    QCOMPARE(_commandManager->srttMsecs(), -1);
+    QCOMPARE(_commandManager->rtoMsecs(), (int)VehicleCommandManager::initialRtoMsecs);
+    
+    QVERIFY(_commandManager->sendCommand(0, MAV_CMD_PREFLIGHT_STORAGE));
+    QVERIFY(_commandManager->sendCommand(0, MAV_CMD_DO_SET_SERVO, 1.0f, 1500.0f));
+    QCOMPARE(_commandManager->outstandingCount(), 2);
+    
+    QVERIFY(_waitForResults(spyResult, 2));
+    QCOMPARE(_commandManager->outstandingCount(), 0);
+    
+    QList<int> completedCommands;
+    for (int i=0; i<spyResult.count(); i++) {
+        QList<QVariant> args = spyResult[i];
+        completedCommands << args[1].toInt();
+        QCOMPARE(args[2].toInt(), (int)MAV_RESULT_ACCEPTED);
+        QCOMPARE(args[3].toBool(), false);
+    }
+    QVERIFY(completedCommands.contains(MAV_CMD_PREFLIGHT_STORAGE));
+    QVERIFY(completedCommands.contains(MAV_CMD_DO_SET_SERVO));
+    
+    // The round trips from the acks have replaced the initial estimate
+    QVERIFY(_commandManager->srttMsecs() >= 0);
+    QVERIFY(_commandManager->rtoMsecs() >= VehicleCommandManager::minRtoMsecs);
+    QVERIFY(_commandManager->rtoMsecs() < VehicleCommandManager::initialRtoMsecs);
+}
+
+/// The same command can't be outstanding twice for a component
+void VehicleCommandManagerTest::_duplicate_test(void)
+{
+    QSignalSpy spyResult(_commandManager, SIGNAL(commandResult(int, int, int, bool)));
+    
+    QVERIFY(_commandManager->sendCommand(0, MAV_CMD_PREFLIGHT_STORAGE));
+    QVERIFY(!_commandManager->sendCommand(0, MAV_CMD_PREFLIGHT_STORAGE));
+    QVERIFY(_commandManager->isOutstanding(0, MAV_CMD_PREFLIGHT_STORAGE));
+    
+    QVERIFY(_waitForResults(spyResult, 1));
+    QVERIFY(!_commandManager->isOutstanding(0, MAV_CMD_PREFLIGHT_STORAGE));
+    
+    // Once acked the command can be sent again
+    QVERIFY(_commandManager->sendCommand(0, MAV_CMD_PREFLIGHT_STORAGE));
+    QVERIFY(_waitForResults(spyResult, 2));
+}
+
+/// A lost ack is recovered by retransmitting the command
+void VehicleCommandManagerTest::_retransmit_test(void)
+{
+    QSignalSpy spyResult(_commandManager, SIGNAL(commandResult(int, int, int, bool)));
+    
+    _mockLink->setCommandAckDropCount(1);
+    QVERIFY(_commandManager->sendCommand(0, MAV_CMD_PREFLIGHT_STORAGE));
+    
+    QVERIFY(_waitForResults(spyResult, 1));
+    QList<QVariant> args = spyResult.takeFirst();
+    QCOMPARE(args[2].toInt(), (int)MAV_RESULT_ACCEPTED);
+    QCOMPARE(args[3].toBool(), false);
+    
+    // Karn's algorithm: the retransmitted command must not have produced a round trip sample
+    QCOMPARE(_commandManager->srttMsecs(), -1);
+}
+
+/// A command which is never acked completes with a timeout after all retries
+void VehicleCommandManagerTest::_timeout_test(void)
+{
+    QSignalSpy spyResult(_commandManager, SIGNAL(commandResult(int, int, int, bool)));
+    
+    _commandManager->setMaxRetries(1);
+    _mockLink->setCommandAckDropCount(2);
+    QVERIFY(_commandManager->sendCommand(0, MAV_CMD_PREFLIGHT_STORAGE));
+    
+    QVERIFY(_waitForResults(spyResult, 1));
+    QList<QVariant> args = spyResult.takeFirst();
+    QCOMPARE(args[1].toInt(), (int)MAV_CMD_PREFLIGHT_STORAGE);
+    QCOMPARE(args[2].toInt(), (int)MAV_RESULT_FAILED);
+    QCOMPARE(args[3].toBool(), true);
+    QCOMPARE(_commandManager->outstandingCount(), 0);
+}
+
+/// A send once command is never retransmitted, a lost ack ends in a timeout
+void VehicleCommandManagerTest::_sendOnce_test(void)
+{
+    QSignalSpy spyResult(_commandManager, SIGNAL(commandResult(int, int, int, bool)));
+    
+    QVERIFY(VehicleCommandManager::isSendOnceCommand(MAV_CMD_PREFLIGHT_REBOOT_SHUTDOWN));
+    QVERIFY(!VehicleCommandManager::isSendOnceCommand(MAV_CMD_PREFLIGHT_STORAGE));
+    
+    _mockLink->setCommandAckDropCount(2);
+    QVERIFY(_commandManager->sendCommandOnce(0, MAV_CMD_PREFLIGHT_STORAGE));
+    
+    // Duplicates are rejected the same as for retransmitted commands
+    QCOMPARE(_commandManager->sendCommandOnce(0, MAV_CMD_PREFLIGHT_STORAGE), false);
+    
+    QVERIFY(_waitForResults(spyResult, 1));
+    QList<QVariant> args = spyResult.takeFirst();
+    QCOMPARE(args[2].toInt(), (int)MAV_RESULT_FAILED);
+    QCOMPARE(args[3].toBool(), true);
+    
+    // Only a single COMMAND_LONG reached the vehicle, so only one of the ack drops was used up
+    QCOMPARE(_mockLink->commandAckDropCount(), 1);
+    QCOMPARE(_commandManager->outstandingCount(), 0);
+}
+
+/// The result from the ack is passed through to the caller
+void VehicleCommandManagerTest::_result_test(void)
+{
+    QSignalSpy spyResult(_commandManager, SIGNAL(commandResult(int, int, int, bool)));
+    
+    _mockLink->setCommandAckResult(MAV_RESULT_DENIED);
+    QVERIFY(_commandManager->sendCommand(0, MAV_CMD_PREFLIGHT_STORAGE));
+    
+    QVERIFY(_waitForResults(spyResult, 1));
+    QList<QVariant> args = spyResult.takeFirst();
+    QCOMPARE(args[2].toInt(), (int)MAV_RESULT_DENIED);
+    QCOMPARE(args[3].toBool(), false);
+}
+
+/// Calibration goes through the command manager, a stop replaces a start which is still waiting for its ack
+void VehicleCommandManagerTest::_calibration_test(void)
+{
+    QSignalSpy spyResult(_commandManager, SIGNAL(commandResult(int, int, int, bool)));
+    UAS* uas = MultiVehicleManager::instance()->activeVehicle()->uas();
+    
+    uas->startCalibration(UASInterface::StartCalibrationGyro);
+    QVERIFY(_commandManager->isOutstanding(0, MAV_CMD_PREFLIGHT_CALIBRATION));
+    QVERIFY(_waitForResults(spyResult, 1));
+    QList<QVariant> args = spyResult.takeFirst();
+    QCOMPARE(args[1].toInt(), (int)MAV_CMD_PREFLIGHT_CALIBRATION);
+    QCOMPARE(args[2].toInt(), (int)MAV_RESULT_ACCEPTED);
+    
+    uas->startCalibration(UASInterface::StartCalibrationMag);
+    uas->stopCalibration();
+    QVERIFY(_commandManager->isOutstanding(0, MAV_CMD_PREFLIGHT_CALIBRATION));
+    
+    // Only the stop is tracked, whichever ack arrives first completes it and no result is signalled for the start
+    QVERIFY(_waitForResults(spyResult, 1));
+    QTest::qWait(500);
+    QCOMPARE(spyResult.count(), 1);
+    QCOMPARE(_commandManager->outstandingCount(), 0);
+}
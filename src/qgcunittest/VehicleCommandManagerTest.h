@@ -0,0 +1,63 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef VehicleCommandManagerTest_H
+#define VehicleCommandManagerTest_H
+
+#include "UnitTest.h"
+
+class MockLink;
+class VehicleCommandManager;
+
+/// @file
+///     @brief Unit test for COMMAND_LONG ack tracking and retransmission in VehicleCommandManager
+
+class VehicleCommandManagerTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    VehicleCommandManagerTest(void);
+    
+private slots:
+    void init(void);
+    void cleanup(void);
+    
+    void _pipelined_test(void);
+    void _duplicate_test(void);
+    void _retransmit_test(void);
+    void _timeout_test(void);
+    void _sendOnce_test(void);
+    void _result_test(void);
+    void _calibration_test(void);
+    
+private:
+    bool _waitForResults(QSignalSpy& spy, int count);
+    
+    MockLink*               _mockLink;
+    VehicleCommandManager*  _commandManager;
+    
+    static const int _resultWaitMsecs = 10000;
+};
+
+#endif
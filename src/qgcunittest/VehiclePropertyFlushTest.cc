@@ -0,0 +1,129 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "VehiclePropertyFlushTest.h"
+#include "OfflineVehicleFixture.h"
+#include "Vehicle.h"
+#include "UAS.h"
+
+#include <QSignalSpy>
+
+UT_REGISTER_TEST(VehiclePropertyFlushTest)
+
+VehiclePropertyFlushTest::VehiclePropertyFlushTest(void)
+    : _fixture(NULL)
+    , _vehicle(NULL)
+{
+    
+}
+
+void VehiclePropertyFlushTest::init(void)
+{
+    UnitTest::init();
+    
+    _fixture = new OfflineVehicleFixture();
+    _vehicle = _fixture->createVehicle(1);
+    
+    // Start each test from a clean dirty set
+    _vehicle->flushPropertyChanges();
+}
+
+void VehiclePropertyFlushTest::cleanup(void)
+{
+    delete _fixture;
+    _fixture = NULL;
+    _vehicle = NULL;
+    
+    UnitTest::cleanup();
+}
+
+/// Many telemetry updates between flushes must produce a single NOTIFY per changed property
+void VehiclePropertyFlushTest::_coalesce_test(void)
+{
+    UAS* uas = _vehicle->uas();
+    
+    QSignalSpy rollSpy(_vehicle, SIGNAL(rollChanged()));
+    QSignalSpy pitchSpy(_vehicle, SIGNAL(pitchChanged()));
+    QSignalSpy altitudeSpy(_vehicle, SIGNAL(altitudeRelativeChanged()));
+    QSignalSpy latitudeSpy(_vehicle, SIGNAL(latitudeChanged()));
+    QSignalSpy longitudeSpy(_vehicle, SIGNAL(longitudeChanged()));
+    
+    for (int i=1; i<=20; i++) {
+        emit uas->attitudeChanged(uas, i * 0.01, 0.0, 0.0, 0);
+        _vehicle->setLatitude(47.0 + (i * 0.0001));
+        _vehicle->setLongitude(8.0 + (i * 0.0001));
+    }
+    emit uas->altitudeChanged(uas, 500.0, 500.0, 10.0, 0.0, 0);
+    
+    // Nothing is signalled until the flush
+    QCOMPARE(rollSpy.count(), 0);
+    QCOMPARE(latitudeSpy.count(), 0);
+    QVERIFY(_vehicle->dirtyProperties() & Vehicle::ROLL_CHANGED);
+    QVERIFY(_vehicle->dirtyProperties() & Vehicle::COORDINATE_CHANGED);
+    
+    QVERIFY(rollSpy.wait(_vehicle->propertyFlushIntervalMsecs() * 10));
+    
+    QCOMPARE(rollSpy.count(), 1);
+    QCOMPARE(pitchSpy.count(), 0);
+    QCOMPARE(altitudeSpy.count(), 1);
+    QCOMPARE(latitudeSpy.count(), 1);
+    QCOMPARE(longitudeSpy.count(), 1);
+    QCOMPARE(_vehicle->dirtyProperties(), (quint32)0);
+    QCOMPARE(_vehicle->roll(), 11.4f);     // 0.2 radians truncated to one decimal
+    QCOMPARE(_vehicle->altitudeRelative(), 10.0f);
+}
+
+/// Updates which do not change the displayed value must not mark the property dirty
+void VehiclePropertyFlushTest::_unchanged_test(void)
+{
+    UAS* uas = _vehicle->uas();
+    
+    emit uas->speedChanged(uas, 5.0, 6.0, 0);
+    _vehicle->flushPropertyChanges();
+    
+    QSignalSpy groundSpeedSpy(_vehicle, SIGNAL(groundSpeedChanged()));
+    
+    emit uas->speedChanged(uas, 5.0, 6.0, 0);
+    emit uas->speedChanged(uas, 5.01, 6.01, 0);     // Below display resolution
+    QCOMPARE(_vehicle->dirtyProperties(), (quint32)0);
+    
+    QTest::qWait(_vehicle->propertyFlushIntervalMsecs() * 5);
+    QCOMPARE(groundSpeedSpy.count(), 0);
+}
+
+/// An idle vehicle must not have its flush timer running
+void VehiclePropertyFlushTest::_idle_test(void)
+{
+    UAS* uas = _vehicle->uas();
+    
+    QSignalSpy headingSpy(_vehicle, SIGNAL(headingChanged()));
+    
+    emit uas->attitudeChanged(uas, 0.0, 0.0, 1.0, 0);
+    QVERIFY(headingSpy.wait(_vehicle->propertyFlushIntervalMsecs() * 10));
+    QCOMPARE(headingSpy.count(), 1);
+    
+    // No further updates, so no further signals
+    QTest::qWait(_vehicle->propertyFlushIntervalMsecs() * 5);
+    QCOMPARE(headingSpy.count(), 1);
+    QCOMPARE(_vehicle->dirtyProperties(), (quint32)0);
+}
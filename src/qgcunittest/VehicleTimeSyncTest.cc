@@ -0,0 +1,196 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "VehicleTimeSyncTest.h"
+#include "VehicleTimeSync.h"
+#include "LinkManager.h"
+#include "MultiVehicleManager.h"
+#include "QmlObjectListModel.h"
+#include "MockLink.h"
+#include "QGC.h"
+
+#include <QSignalSpy>
+
+UT_REGISTER_TEST(VehicleTimeSyncTest)
+
+static const qint64 _msecsToNsecs = 1000000LL;
+
+VehicleTimeSyncTest::VehicleTimeSyncTest(void)
+    : _rngState(1)
+{
+    
+}
+
+/// Small deterministic generator so the jitter is the same on every run
+quint32 VehicleTimeSyncTest::_random(void)
+{
+    _rngState = _rngState * 1664525 + 1013904223;
+    return _rngState >> 8;
+}
+
+/// Asymmetric queueing delays must not leak into the offset, the low round trip samples win
+void VehicleTimeSyncTest::_minRtt_test(void)
+{
+    TimeSyncEstimator estimator;
+    const qint64 offsetNsecs = 1400000000000LL * _msecsToNsecs;
+    const qint64 oneWayNsecs = 5 * _msecsToNsecs;
+    
+    QVERIFY(!estimator.valid());
+    
+    qint64 gcsNsecs = offsetNsecs;
+    for (int i=0; i<TimeSyncEstimator::windowSize; i++) {
+        // Every other response is held up to 200 msecs on the way back only
+        qint64 returnDelayNsecs = oneWayNsecs + ((i & 1) ? (qint64)(_random() % 200) * _msecsToNsecs : 0);
+        
+        qint64 onboardNsecs = gcsNsecs + oneWayNsecs - offsetNsecs;
+        estimator.addSample(gcsNsecs, onboardNsecs, gcsNsecs + oneWayNsecs + returnDelayNsecs);
+        gcsNsecs += 100 * _msecsToNsecs;
+    }
+    
+    QVERIFY(estimator.valid());
+    QCOMPARE(estimator.sampleCount(), (int)TimeSyncEstimator::windowSize);
+    QCOMPARE(estimator.minRttNsecs(), 2 * oneWayNsecs);
+    QVERIFY(qAbs(estimator.offsetNsecs(gcsNsecs) - offsetNsecs) < _msecsToNsecs);
+    QVERIFY(qAbs(estimator.onboardToGcsNsecs(1000 * _msecsToNsecs) - (offsetNsecs + 1000 * _msecsToNsecs)) < _msecsToNsecs);
+}
+
+/// A vehicle clock which runs fast is followed by the fitted line
+void VehicleTimeSyncTest::_drift_test(void)
+{
+    TimeSyncEstimator estimator;
+    const qint64 offsetNsecs = 1400000000000LL * _msecsToNsecs;
+    const qint64 oneWayNsecs = 2 * _msecsToNsecs;
+    const double driftPpm = 100.0;
+    
+    qint64 startNsecs = offsetNsecs;
+    qint64 gcsNsecs = startNsecs;
+    for (int i=0; i<TimeSyncEstimator::windowSize; i++) {
+        qint64 vehicleReadNsecs = gcsNsecs + oneWayNsecs;
+        qint64 onboardNsecs = (vehicleReadNsecs - offsetNsecs) + (qint64)((vehicleReadNsecs - startNsecs) * driftPpm / 1e6);
+        estimator.addSample(gcsNsecs, onboardNsecs, gcsNsecs + 2 * oneWayNsecs);
+        gcsNsecs += 1000 * _msecsToNsecs;
+    }
+    
+    QVERIFY(qAbs(estimator.driftPpm() - driftPpm) < 1.0);
+    
+    // Without the drift term the mapping would be 3 msecs off at the end of the window
+    qint64 onboardNsecs = (gcsNsecs - offsetNsecs) + (qint64)((gcsNsecs - startNsecs) * driftPpm / 1e6);
+    QVERIFY(qAbs(estimator.onboardToGcsNsecs(onboardNsecs) - gcsNsecs) < _msecsToNsecs / 2);
+}
+
+/// A vehicle reboot restarts its clock, the old samples must be thrown away
+void VehicleTimeSyncTest::_clockJump_test(void)
+{
+    TimeSyncEstimator estimator;
+    const qint64 oneWayNsecs = 5 * _msecsToNsecs;
+    qint64 offsetNsecs = 1400000000000LL * _msecsToNsecs;
+    
+    qint64 gcsNsecs = offsetNsecs + 60000 * _msecsToNsecs;
+    for (int i=0; i<10; i++) {
+        estimator.addSample(gcsNsecs, gcsNsecs + oneWayNsecs - offsetNsecs, gcsNsecs + 2 * oneWayNsecs);
+        gcsNsecs += 100 * _msecsToNsecs;
+    }
+    QCOMPARE(estimator.resetCount(), 0);
+    QCOMPARE(estimator.sampleCount(), 10);
+    
+    // Vehicle rebooted, its boot clock now starts at the current GCS time
+    offsetNsecs = gcsNsecs;
+    estimator.addSample(gcsNsecs, gcsNsecs + oneWayNsecs - offsetNsecs, gcsNsecs + 2 * oneWayNsecs);
+    QCOMPARE(estimator.resetCount(), 1);
+    QCOMPARE(estimator.sampleCount(), 1);
+    QVERIFY(qAbs(estimator.offsetNsecs(gcsNsecs) - offsetNsecs) < _msecsToNsecs);
+}
+
+/// TIMESYNC round trips with MockLink produce a mapping which is published for the decoder
+void VehicleTimeSyncTest::_mockLink_test(void)
+{
+    MockLink* mockLink = new MockLink();
+    Q_CHECK_PTR(mockLink);
+    LinkManager::instance()->_addLink(mockLink);
+    LinkManager::instance()->connectLink(mockLink);
+    
+    QSignalSpy spyVehicle(MultiVehicleManager::instance(), SIGNAL(activeVehicleChanged(Vehicle*)));
+    QCOMPARE(spyVehicle.wait(5000), true);
+    Vehicle* vehicle = MultiVehicleManager::instance()->activeVehicle();
+    
+    QSignalSpy spyUpdated(vehicle->timeSync(), SIGNAL(timeSyncUpdated()));
+    QCOMPARE(spyUpdated.wait(5000), true);
+    
+    QVERIFY(vehicle->timeSync()->estimator().valid());
+    
+    // MockLink boot time started about when the link connected, so onboard time zero maps close to now
+    quint64 gcsMsecs = 0;
+    QVERIFY(VehicleTimeSync::onboardToGcsMsecs(vehicle->id(), 0, &gcsMsecs));
+    QVERIFY(qAbs((qint64)QGC::groundTimeMilliseconds() - (qint64)gcsMsecs) < 10000);
+    
+    // No mapping for vehicles which are not connected
+    QVERIFY(!VehicleTimeSync::onboardToGcsMsecs(vehicle->id() + 1, 0, &gcsMsecs));
+    
+    LinkManager::instance()->disconnectLink(mockLink);
+    QTest::qWait(1000); // Need to allow signals to move between threads
+}
+
+/// MockLink secondary vehicles never answer TIMESYNC, their requests must back off. Responses from other
+/// systems must not be taken as answers.
+void VehicleTimeSyncTest::_unanswered_test(void)
+{
+    MockConfiguration* config = new MockConfiguration("Mock TimeSync");
+    config->setVehicleCount(2);
+    config->setFirstVehicleId(1);
+    
+    MockLink* mockLink = new MockLink(config);
+    Q_CHECK_PTR(mockLink);
+    LinkManager::instance()->_addLink(mockLink);
+    LinkManager::instance()->connectLink(mockLink);
+    
+    QSignalSpy spyVehicle(MultiVehicleManager::instance(), SIGNAL(vehicleAdded(Vehicle*)));
+    while (MultiVehicleManager::instance()->vehiclesModel()->count() < 2 && spyVehicle.wait(5000)) {
+    }
+    Vehicle* primary = MultiVehicleManager::instance()->getVehicleById(1);
+    Vehicle* secondary = MultiVehicleManager::instance()->getVehicleById(2);
+    QVERIFY(primary);
+    QVERIFY(secondary);
+    VehicleTimeSync* timeSync = secondary->timeSync();
+    
+    // A response carrying a ts1 the secondary is waiting for, but sent by the broadcast system id
+    QVERIFY(timeSync->_outstandingRequests.count() > 0);
+    mavlink_message_t msg;
+    mavlink_msg_timesync_pack(0, MAV_COMP_ID_ALL, &msg, 1000000, timeSync->_outstandingRequests.last());
+    timeSync->timesyncReceived(msg);
+    QVERIFY(!timeSync->estimator().valid());
+    
+    // Enough time for maxUnansweredRequests at the fast rate and a few doublings after that
+    QTest::qWait((VehicleTimeSync::maxUnansweredRequests + 2) * VehicleTimeSync::fastIntervalMsecs + 2000);
+    
+    QVERIFY(!timeSync->estimator().valid());
+    QVERIFY(timeSync->requestIntervalMsecs() > VehicleTimeSync::slowIntervalMsecs);
+    QVERIFY(timeSync->requestIntervalMsecs() <= VehicleTimeSync::backoffIntervalMsecs);
+    
+    // The primary vehicle answers and stays at the normal rate
+    QVERIFY(primary->timeSync()->estimator().valid());
+    QVERIFY(primary->timeSync()->requestIntervalMsecs() <= VehicleTimeSync::slowIntervalMsecs);
+    
+    LinkManager::instance()->disconnectLink(mockLink);
+    QTest::qWait(1000); // Need to allow signals to move between threads
+    delete config;
+}
@@ -0,0 +1,52 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef VehicleTimeSyncTest_H
+#define VehicleTimeSyncTest_H
+
+#include "UnitTest.h"
+
+/// @file
+///     @brief Unit test for the TIMESYNC offset estimator and its use through MockLink
+
+class VehicleTimeSyncTest : public UnitTest
+{
+    Q_OBJECT
+    
+public:
+    VehicleTimeSyncTest(void);
+    
+private slots:
+    void _minRtt_test(void);
+    void _drift_test(void);
+    void _clockJump_test(void);
+    void _mockLink_test(void);
+    void _unanswered_test(void);
+    
+private:
+    quint32 _random(void);
+    
+    quint32 _rngState;
+};
+
+#endif
@@ -29,20 +29,33 @@
 
 #include <QFile>
 #include <QDir>
+#include <QDataStream>
 #include <string>
 
 QGC_LOGGING_CATEGORY(FileManagerLog, "FileManagerLog")
 
+static const quint32 _downloadStateMagic = 0x46545053;  // "FTPS"
+static const quint32 _downloadStateVersion = 2;
+
 FileManager::FileManager(QObject* parent, Vehicle* vehicle) :
     QObject(parent),
     _currentOperation(kCOIdle),
     _vehicle(vehicle),
     _lastOutgoingSeqNumber(0),
+    _outstandingOpcode(kCmdNone),
     _activeSession(0),
+    _downloadMissingBytes(0),
+    _downloadRateLimit(0),
+    _downloadStream(false),
+    _downloadCRC32Valid(false),
+    _downloadCRC32(0),
     _systemIdQGC(0)
 {
     connect(&_ackTimer, &QTimer::timeout, this, &FileManager::_ackTimeout);
     
+    _downloadPaceTimer.setSingleShot(true);
+    connect(&_downloadPaceTimer, &QTimer::timeout, this, &FileManager::_sendNextDownloadRead);
+    
     _systemIdServer = _vehicle->id();
     
     // Make sure we don't have bad structure packing
@@ -62,53 +75,244 @@ void FileManager::_openAckResponse(Request* openAck)
     Q_ASSERT(openAck->hdr.size == sizeof(uint32_t));
     _downloadFileSize = openAck->openFileLength;
     
-    // Start the sequence of read commands
+    _downloadOffset = 0;
+    _downloadRetryCount = 0;
+
+    bool resumed;
+    if (!_openDownloadFile(&resumed)) {
+        _currentOperation = kCOIdle;
+        _emitErrorMessage(tr("Unable to open local file for writing (%1)").arg(_downloadPartialFilePath()));
+        _sendTerminateCommand();
+        return;
+    }
 
-    _downloadOffset = 0;            // Start reading at beginning of file
-    _readFileAccumulator.clear();   // Start with an empty file
+    if (_currentOperation == kCORead || resumed || _downloadRateLimit > 0) {
+        // Read commands are sent for each missing range. For a resumed download this only covers what the
+        // previous attempt did not get. Bursts can't be paced so they are not used with a rate limit.
+        _currentOperation = kCORead;
+        _sendNextDownloadRead();
+        return;
+    }
 
+    // Start the burst at the beginning of the file
     Request request;
     request.hdr.session = _activeSession;
-	Q_ASSERT(_currentOperation == kCORead || _currentOperation == kCOBurst);
-	request.hdr.opcode = _currentOperation == kCORead ? kCmdReadFile : kCmdBurstReadFile;
+    request.hdr.opcode = kCmdBurstReadFile;
     request.hdr.offset = _downloadOffset;
     request.hdr.size = sizeof(request.data);
 
     _sendRequest(&request);
 }
 
-/// Closes out a download session by writing the file and doing cleanup.
+/// Opens the partial download file, resuming a previous download of the same file if one was saved.
+///     @param[out] resumed true: _downloadMissing was loaded from a previous download
+/// @return false: unable to open the local file
+bool FileManager::_openDownloadFile(bool* resumed)
+{
+    *resumed = QFile::exists(_downloadPartialFilePath()) && _loadDownloadState();
+
+    QIODevice::OpenMode mode = QIODevice::ReadWrite;
+    if (!*resumed) {
+        mode |= QIODevice::Truncate;
+
+        _downloadMissing.clear();
+        if (_downloadFileSize) {
+            _downloadMissing[0] = _downloadFileSize;
+        }
+        _downloadMissingBytes = _downloadFileSize;
+    }
+
+    _downloadFile.setFileName(_downloadPartialFilePath());
+    if (!_downloadFile.open(mode)) {
+        return false;
+    }
+
+    // Size the file up front so data can be written at any offset as it arrives
+    if (!_downloadFile.resize(_downloadFileSize)) {
+        _downloadFile.close();
+        return false;
+    }
+
+    qCDebug(FileManagerLog) << "_openDownloadFile resumed:missingBytes" << *resumed << _downloadMissingBytes;
+
+    return true;
+}
+
+/// Removes the specified range from the set of missing ranges
+void FileManager::_markDownloadReceived(uint32_t offset, uint32_t size)
+{
+    uint32_t end = offset + size;
+
+    while (true) {
+        // Find the first missing range which ends after offset
+        QMap<uint32_t, uint32_t>::iterator range = _downloadMissing.upperBound(offset);
+        if (range != _downloadMissing.begin()) {
+            --range;
+            if (range.value() <= offset) {
+                ++range;
+            }
+        }
+        if (range == _downloadMissing.end() || range.key() >= end) {
+            break;
+        }
+
+        uint32_t rangeStart = range.key();
+        uint32_t rangeEnd = range.value();
+        _downloadMissing.erase(range);
+        _downloadMissingBytes -= qMin(rangeEnd, end) - qMax(rangeStart, offset);
+
+        // Keep whatever part of the range was not covered
+        if (rangeStart < offset) {
+            _downloadMissing[rangeStart] = offset;
+        }
+        if (rangeEnd > end) {
+            _downloadMissing[end] = rangeEnd;
+        }
+    }
+}
+
+/// Sends a read request for the first missing range. Completes the download if nothing is missing.
+void FileManager::_sendNextDownloadRead(void)
+{
+    Q_ASSERT(_currentOperation == kCORead);
+
+    if (_downloadMissing.isEmpty()) {
+        _closeDownloadSession(true /* success */);
+        return;
+    }
+
+    QMap<uint32_t, uint32_t>::const_iterator range = _downloadMissing.constBegin();
+    _downloadRequestOffset = range.key();
+
+    Request request;
+    request.hdr.session = _activeSession;
+    request.hdr.opcode = kCmdReadFile;
+    request.hdr.offset = _downloadRequestOffset;
+    request.hdr.size = qMin(range.value() - range.key(), (uint32_t)sizeof(request.data));
+
+    _downloadRequestTime.start();
+    _sendRequest(&request);
+}
+
+/// Called when the burst has ended, either by EOF or by the burst stalling. Any ranges lost during
+/// the burst are then read individually.
+void FileManager::_downloadBurstComplete(void)
+{
+    qCDebug(FileManagerLog) << "_downloadBurstComplete missing ranges:bytes" << _downloadMissing.count() << _downloadMissingBytes;
+
+    _currentOperation = kCORead;
+    _downloadRetryCount = 0;
+    _sendNextDownloadRead();
+}
+
+QString FileManager::_downloadPartialFilePath(void)
+{
+    return _readFileDownloadDir.absoluteFilePath(_readFileDownloadFilename + ".partial");
+}
+
+QString FileManager::_downloadStateFilePath(void)
+{
+    return _downloadPartialFilePath() + ".state";
+}
+
+/// Loads the missing ranges saved by a previous failed download of the same file.
+/// @return false: no usable state, download must start from scratch
+bool FileManager::_loadDownloadState(void)
+{
+    QFile file(_downloadStateFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic, version, fileSize, crc32, count;
+    stream >> magic >> version >> fileSize >> crc32 >> count;
+    if (stream.status() != QDataStream::Ok || magic != _downloadStateMagic || version != _downloadStateVersion) {
+        qCDebug(FileManagerLog) << "_loadDownloadState ignoring state" << file.fileName();
+        return false;
+    }
+    // A file which was rewritten on the vehicle is a different file even if the size stayed the same
+    if (fileSize != _downloadFileSize || !_downloadCRC32Valid || crc32 != _downloadCRC32) {
+        qCDebug(FileManagerLog) << "_loadDownloadState file changed on vehicle, size:crc32" << fileSize << _downloadFileSize << crc32 << _downloadCRC32;
+        return false;
+    }
+
+    _downloadMissing.clear();
+    _downloadMissingBytes = 0;
+    for (quint32 i=0; i<count; i++) {
+        quint32 start, end;
+        stream >> start >> end;
+        if (stream.status() != QDataStream::Ok || start >= end || end > fileSize) {
+            qCDebug(FileManagerLog) << "_loadDownloadState corrupt state" << file.fileName();
+            return false;
+        }
+        _downloadMissing[start] = end;
+        _downloadMissingBytes += end - start;
+    }
+
+    return true;
+}
+
+/// Saves the missing ranges so that a later download of the same file can resume
+void FileManager::_saveDownloadState(void)
+{
+    if (!_downloadCRC32Valid) {
+        // Without the CRC32 a changed file on the vehicle can't be detected, so the download starts over next time
+        QFile::remove(_downloadStateFilePath());
+        return;
+    }
+    
+    QFile file(_downloadStateFilePath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "FileManager unable to save download state" << file.fileName() << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << _downloadStateMagic << _downloadStateVersion << (quint32)_downloadFileSize << _downloadCRC32 << (quint32)_downloadMissing.count();
+    for (QMap<uint32_t, uint32_t>::const_iterator range=_downloadMissing.constBegin(); range!=_downloadMissing.constEnd(); range++) {
+        stream << (quint32)range.key() << (quint32)range.value();
+    }
+}
+
+/// Closes out a download session. On success the partial file is moved to the download file, on failure the
+/// missing ranges are saved so the download can be resumed.
 ///     @param success true: successful download completion, false: error during download
 void FileManager::_closeDownloadSession(bool success)
 {
     qCDebug(FileManagerLog) << QString("_closeDownloadSession: success(%1)").arg(success);
     
     _currentOperation = kCOIdle;
+    _downloadPaceTimer.stop();
     
+    QString errorMsg;
     if (success) {
         QString downloadFilePath = _readFileDownloadDir.absoluteFilePath(_readFileDownloadFilename);
 
-        QFile file(downloadFilePath);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-            _emitErrorMessage(tr("Unable to open local file for writing (%1)").arg(downloadFilePath));
-            return;
-        }
+        _downloadFile.close();
+        QFile::remove(_downloadStateFilePath());
 
-        qint64 bytesWritten = file.write((const char *)_readFileAccumulator, _readFileAccumulator.length());
-        if (bytesWritten != _readFileAccumulator.length()) {
-            file.close();
-            _emitErrorMessage(tr("Unable to write data to local file (%1)").arg(downloadFilePath));
-            return;
+        if (QFile::exists(downloadFilePath) && !QFile::remove(downloadFilePath)) {
+            errorMsg = tr("Unable to replace local file (%1)").arg(downloadFilePath);
+        } else if (!QFile::rename(_downloadPartialFilePath(), downloadFilePath)) {
+            errorMsg = tr("Unable to write data to local file (%1)").arg(downloadFilePath);
         }
-        file.close();
-
-        emit commandComplete();
+    } else if (_downloadFile.isOpen()) {
+        _downloadFile.close();
+        _saveDownloadState();
     }
     
-    _readFileAccumulator.clear();
+    _downloadMissing.clear();
+    _downloadMissingBytes = 0;
+    
+    // Close the open session before signalling, the receiver may start the next command right away
+    _sendTerminateCommand();
     
-    // Close the open session
-    _sendResetCommand();
+    if (!errorMsg.isEmpty()) {
+        _emitErrorMessage(errorMsg);
+    } else if (success) {
+        emit commandComplete();
+    }
 }
 
 /// Closes out an upload session doing cleanup.
@@ -118,15 +322,17 @@ void FileManager::_closeUploadSession(bool success)
     qCDebug(FileManagerLog) << QString("_closeUploadSession: success(%1)").arg(success);
     
     _currentOperation = kCOIdle;
-    _writeFileAccumulator.clear();
+    _clearAckTimeout();
+    _writePending.clear();
+    _writeFile.close();
     _writeFileSize = 0;
     
+    // Close the open session before signalling, the receiver may start the next command right away
+    _sendTerminateCommand();
+    
     if (success) {
         emit commandComplete();
     }
-    
-    // Close the open session
-    _sendResetCommand();
 }
 
 /// Respond to the Ack associated with the Read or Stream commands.
@@ -139,34 +345,67 @@ void FileManager::_downloadAckResponse(Request* readAck, bool readFile)
         return;
     }
 
-    if (readAck->hdr.offset != _downloadOffset) {
+    if (readFile && readAck->hdr.offset != _downloadRequestOffset) {
         _closeDownloadSession(false /* failure */);
-        _emitErrorMessage(tr("Download: Offset returned (%1) differs from offset requested/expected (%2)").arg(readAck->hdr.offset).arg(_downloadOffset));
+        _emitErrorMessage(tr("Download: Offset returned (%1) differs from offset requested (%2)").arg(readAck->hdr.offset).arg(_downloadRequestOffset));
         return;
     }
     
     qCDebug(FileManagerLog) << QString("_downloadAckResponse: offset(%1) size(%2) burstComplete(%3)").arg(readAck->hdr.offset).arg(readAck->hdr.size).arg(readAck->hdr.burstComplete);
 
-	_downloadOffset += readAck->hdr.size;
-    _readFileAccumulator.append((const char*)readAck->data, readAck->hdr.size);
+    if (!readFile && readAck->hdr.offset != _downloadOffset) {
+        // Burst packets were lost. The range stays in _downloadMissing and is read once the burst completes.
+        qCDebug(FileManagerLog) << "_downloadAckResponse burst gap:" << _downloadOffset << readAck->hdr.offset;
+    }
+
+    // Anything past the file size reported by Open is ignored
+    uint32_t size = 0;
+    if (readAck->hdr.offset < _downloadFileSize) {
+        size = qMin((uint32_t)readAck->hdr.size, _downloadFileSize - readAck->hdr.offset);
+    }
+
+    if (size) {
+        if (!_downloadFile.seek(readAck->hdr.offset) || _downloadFile.write((const char*)readAck->data, size) != (qint64)size) {
+            QString errorString = _downloadFile.errorString();
+            _closeDownloadSession(false /* failure */);
+            _emitErrorMessage(tr("Unable to write data to local file (%1)").arg(errorString));
+            return;
+        }
+        _markDownloadReceived(readAck->hdr.offset, size);
+    }
     
     if (_downloadFileSize != 0) {
-        emit commandProgress(100 * ((float)_readFileAccumulator.length() / (float)_downloadFileSize));
+        emit commandProgress(100 * ((float)(_downloadFileSize - _downloadMissingBytes) / (float)_downloadFileSize));
     }
 
-    if (readFile || readAck->hdr.burstComplete) {
-        // Possibly still more data to read, send next read request
+    if (readFile) {
+        _downloadRetryCount = 0;
+        
+        if (_downloadRateLimit > 0) {
+            // Hold back the next request until this chunk has used up its share of the rate limit
+            qint64 paceMsecs = ((qint64)size * 1000) / _downloadRateLimit - _downloadRequestTime.elapsed();
+            if (paceMsecs > 0) {
+                _downloadPaceTimer.start(paceMsecs);
+                return;
+            }
+        }
+        _sendNextDownloadRead();
+    } else {
+        _downloadOffset = readAck->hdr.offset + readAck->hdr.size;
 
-        Request request;
-        request.hdr.session = _activeSession;
-        request.hdr.opcode = readFile ? kCmdReadFile : kCmdBurstReadFile;
-        request.hdr.offset = _downloadOffset;
-        request.hdr.size = 0;
+        if (readAck->hdr.burstComplete) {
+            // Possibly still more data, continue the burst from where this one stopped
+            Request request;
+            request.hdr.session = _activeSession;
+            request.hdr.opcode = kCmdBurstReadFile;
+            request.hdr.offset = _downloadOffset;
+            request.hdr.size = 0;
 
-        _sendRequest(&request);
-    } else if (!readFile) {
-        // Streaming, so next ack should come automatically
-        _setupAckTimeout();
+            _sendRequest(&request);
+        } else {
+            // Streaming, so next ack should come automatically
+            _setupAckTimeout();
+        }
     }
 }
 
@@ -229,6 +468,49 @@ void FileManager::_listAckResponse(Request* listAck)
     }
 }
 
+/// @brief Respond to the Ack associated with the CalcFileCRC32 command.
+void FileManager::_crc32AckResponse(Request* crc32Ack)
+{
+    _currentOperation = kCOIdle;
+    
+    if (crc32Ack->hdr.size != sizeof(uint32_t)) {
+        _emitErrorMessage(tr("CRC32: Returned invalid size of CRC32 data"));
+        return;
+    }
+    
+    qCDebug(FileManagerLog) << "_crc32AckResponse crc32:" << crc32Ack->crc32;
+    
+    emit fileCRC32(crc32Ack->crc32);
+    emit commandComplete();
+}
+
+/// @brief Respond to the CalcFileCRC32 Ack which starts a download, then opens the file.
+void FileManager::_downloadCRC32AckResponse(Request* crc32Ack)
+{
+    if (crc32Ack->hdr.size == sizeof(uint32_t)) {
+        _downloadCRC32 = crc32Ack->crc32;
+        _downloadCRC32Valid = true;
+    }
+    
+    qCDebug(FileManagerLog) << "_downloadCRC32AckResponse valid:crc32" << _downloadCRC32Valid << _downloadCRC32;
+    
+    _sendDownloadOpen();
+}
+
+/// @brief Sends the Open command for the download
+void FileManager::_sendDownloadOpen(void)
+{
+    _currentOperation = _downloadStream ? kCOOpenBurst : kCOOpenRead;
+    
+    Request request;
+    request.hdr.session = 0;
+    request.hdr.opcode = kCmdOpenFileRO;
+    request.hdr.offset = 0;
+    request.hdr.size = 0;
+    _fillRequestWithString(&request, _downloadRemotePath);
+    _sendRequest(&request);
+}
+
 /// @brief Respond to the Ack associated with the create command.
 void FileManager::_createAckResponse(Request* createAck)
 {
@@ -240,27 +522,30 @@ void FileManager::_createAckResponse(Request* createAck)
     // Start the sequence of write commands from the beginning of the file
 
     _writeOffset = 0;
-    _writeSize = 0;
+    _writePending.clear();
+    _writeSrttMsecs = -1;
+    _writeRttvarMsecs = 0;
+    _writeRtoMsecs = _initialWriteRtoMsecs;
+    _writeClock.start();
     
-    _writeFileDatablock();
+    _fillWriteWindow();
 }
 
-/// @brief Respond to the Ack associated with the write command.
+/// @brief Respond to the Ack associated with the write command. Acks may arrive in any order, they are matched
+/// to the outstanding write by offset.
 void FileManager::_writeAckResponse(Request* writeAck)
 {
-    if(_writeOffset + _writeSize >= _writeFileSize){
-        _closeUploadSession(true /* success */);
-    }
-
     if (writeAck->hdr.session != _activeSession) {
         _closeUploadSession(false /* failure */);
         _emitErrorMessage(tr("Write: Incorrect session returned"));
         return;
     }
 
-    if (writeAck->hdr.offset != _writeOffset) {
-        _closeUploadSession(false /* failure */);
-        _emitErrorMessage(tr("Write: Offset returned (%1) differs from offset requested (%2)").arg(writeAck->hdr.offset).arg(_writeOffset));
+    QMap<uint32_t, WriteRequest_t>::iterator writeRequest = _writePending.find(writeAck->hdr.offset);
+    if (writeRequest == _writePending.end()) {
+        // Duplicate ack for a write which was resent and has already been acked
+        qCDebug(FileManagerLog) << "_writeAckResponse ignoring ack for offset" << writeAck->hdr.offset;
+        _setupWriteTimeout();
         return;
     }
 
@@ -270,41 +555,135 @@ void FileManager::_writeAckResponse(Request* writeAck)
         return;
     }
 
-
-    if( writeAck->writeFileLength !=_writeSize) {
+    if (writeAck->writeFileLength != writeRequest->size) {
         _closeUploadSession(false /* failure */);
-        _emitErrorMessage(tr("Write: Size returned (%1) differs from size requested (%2)").arg(writeAck->writeFileLength).arg(_writeSize));
+        _emitErrorMessage(tr("Write: Size returned (%1) differs from size requested (%2)").arg(writeAck->writeFileLength).arg((int)writeRequest->size));
         return;
     }
 
-    _writeFileDatablock();
+    // Round trips of resent requests are ambiguous so they are not sampled
+    if (writeRequest->retryCount == 0) {
+        _updateWriteRto(_writeClock.elapsed() - writeRequest->sentMsecs);
+    }
+    _writePending.erase(writeRequest);
+    
+    if (_writeFileSize != 0) {
+        uint32_t pendingBytes = 0;
+        foreach (const WriteRequest_t& pending, _writePending) {
+            pendingBytes += pending.size;
+        }
+        emit commandProgress(100 * ((float)(_writeOffset - pendingBytes) / (float)_writeFileSize));
+    }
+
+    _fillWriteWindow();
 }
 
-/// @brief Send next write file data block.
-void FileManager::_writeFileDatablock(void)
+/// @brief Sends new write requests until the window is full. Completes the upload once everything has been acked.
+void FileManager::_fillWriteWindow(void)
 {
-    if (_writeOffset + _writeSize >= _writeFileSize){
+    while (_writePending.count() < _writeWindowSize && _writeOffset < _writeFileSize) {
+        WriteRequest_t writeRequest;
+        
+        writeRequest.size = qMin(_writeFileSize - _writeOffset, (uint32_t)sizeof(((Request*)0)->data));
+        writeRequest.retryCount = 0;
+        
+        uint32_t offset = _writeOffset;
+        if (!_sendWriteRequest(offset, writeRequest)) {
+            return;
+        }
+        _writeOffset += writeRequest.size;
+        _writePending[offset] = writeRequest;
+    }
+
+    if (_writePending.isEmpty()) {
         _closeUploadSession(true /* success */);
         return;
     }
+    
+    _setupWriteTimeout();
+}
 
-    _writeOffset += _writeSize;
-
+/// @brief Reads the data block at the specified offset from the local file and sends it.
+/// @return false: unable to read the local file, upload has been closed
+bool FileManager::_sendWriteRequest(uint32_t offset, WriteRequest_t& writeRequest)
+{
     Request request;
     request.hdr.session = _activeSession;
     request.hdr.opcode = kCmdWriteFile;
-    request.hdr.offset = _writeOffset;
+    request.hdr.offset = offset;
+    request.hdr.size = writeRequest.size;
 
-    if(_writeFileSize -_writeOffset > sizeof(request.data) )
-        _writeSize = sizeof(request.data);
-    else
-        _writeSize = _writeFileSize - _writeOffset;
+    if (!_writeFile.seek(offset) || _writeFile.read((char*)request.data, writeRequest.size) != writeRequest.size) {
+        QString filename = _writeFile.fileName();
+        _closeUploadSession(false /* failure */);
+        _emitErrorMessage(tr("Unable to read data from local file (%1)").arg(filename));
+        return false;
+    }
 
-    request.hdr.size = _writeSize;
+    writeRequest.sentMsecs = _writeClock.elapsed();
+    _sendRequestNoTimeout(&request);
+    
+    return true;
+}
 
-    memcpy(request.data, &_writeFileAccumulator.data()[_writeOffset], _writeSize);
+/// @brief Resends the write requests which have not been acked in time.
+void FileManager::_writeTimeout(void)
+{
+    qint64 now = _writeClock.elapsed();
+    
+    for (QMap<uint32_t, WriteRequest_t>::iterator writeRequest=_writePending.begin(); writeRequest!=_writePending.end(); writeRequest++) {
+        if (now - writeRequest->sentMsecs < _writeRtoMsecs) {
+            continue;
+        }
+        
+        if (++writeRequest->retryCount > _maxWriteRetries) {
+            _closeUploadSession(false /* failure */);
+            _emitErrorMessage(tr("Timeout waiting for ack: Upload failed"));
+            return;
+        }
+        
+        qCDebug(FileManagerLog) << "_writeTimeout resending write: offset:retry" << writeRequest.key() << writeRequest->retryCount;
+        if (!_sendWriteRequest(writeRequest.key(), writeRequest.value())) {
+            return;
+        }
+    }
+    
+    // Back off in case the link is slower than estimated
+    _writeRtoMsecs = qMin(_writeRtoMsecs * 2, (int)ackTimerTimeoutMsecs);
+    
+    _setupWriteTimeout();
+}
 
-    _sendRequest(&request);
+/// @brief Starts the ack timer for the oldest outstanding write request
+void FileManager::_setupWriteTimeout(void)
+{
+    _ackTimer.stop();
+    
+    if (_writePending.isEmpty()) {
+        return;
+    }
+    
+    qint64 oldestSentMsecs = _writeClock.elapsed();
+    foreach (const WriteRequest_t& writeRequest, _writePending) {
+        oldestSentMsecs = qMin(oldestSentMsecs, writeRequest.sentMsecs);
+    }
+    
+    _ackTimer.setSingleShot(true);
+    _ackTimer.start(qMax((qint64)0, oldestSentMsecs + _writeRtoMsecs - _writeClock.elapsed()));
+}
+
+/// @brief Updates the write retransmit timeout from a round trip sample (RFC 6298)
+void FileManager::_updateWriteRto(int rttMsecs)
+{
+    if (_writeSrttMsecs < 0) {
+        _writeSrttMsecs = rttMsecs;
+        _writeRttvarMsecs = rttMsecs / 2;
+    } else {
+        _writeRttvarMsecs = (3 * _writeRttvarMsecs + qAbs(_writeSrttMsecs - rttMsecs)) / 4;
+        _writeSrttMsecs = (7 * _writeSrttMsecs + rttMsecs) / 8;
+    }
+    
+    _writeRtoMsecs = qBound((int)_minWriteRtoMsecs, _writeSrttMsecs + 4 * _writeRttvarMsecs, (int)ackTimerTimeoutMsecs);
 }
 
 void FileManager::receiveMessage(LinkInterface* link, mavlink_message_t message)
@@ -319,6 +698,11 @@ void FileManager::receiveMessage(LinkInterface* link, mavlink_message_t message)
     mavlink_file_transfer_protocol_t data;
     mavlink_msg_file_transfer_protocol_decode(&message, &data);
 	
+    if (_currentOperation == kCOIdle || message.sysid != _systemIdServer) {
+        // Nothing outstanding, or the response is from another vehicle
+        return;
+    }
+    
     // Make sure we are the target system
     if (data.target_system != _systemIdQGC) {
         qDebug() << "Received MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL with incorrect target_system:" <<  data.target_system << "expected:" << _systemIdQGC;
@@ -327,15 +711,33 @@ void FileManager::receiveMessage(LinkInterface* link, mavlink_message_t message)
     
     Request* request = (Request*)&data.payload[0];
     
-    _clearAckTimeout();
-    
 	qCDebug(FileManagerLog) << "receiveMessage" << request->hdr.opcode;
 	
-    uint16_t incomingSeqNumber = request->hdr.seqNumber;
+    if (!_isOwnResponse(request)) {
+        // Response to another FileManager talking to the same vehicle
+        return;
+    }
     
-    // Make sure we have a good sequence number
+    uint16_t incomingSeqNumber = request->hdr.seqNumber;
     uint16_t expectedSeqNumber = _lastOutgoingSeqNumber + 1;
-    if (incomingSeqNumber != expectedSeqNumber) {
+    int16_t seqNumberDelta = (int16_t)(incomingSeqNumber - expectedSeqNumber);
+    
+    if (seqNumberDelta < 0 && _currentOperation != kCOWrite) {
+        // Late response to a request which has since been resent or the tail of a burst we have moved on from.
+        // The ack timeout keeps running for the request which is outstanding.
+        qCDebug(FileManagerLog) << "receiveMessage ignoring stale response: expected:received" << expectedSeqNumber << incomingSeqNumber;
+        return;
+    }
+    
+    _clearAckTimeout();
+    
+    if (_currentOperation == kCOWrite) {
+        // Several writes are in flight, _writeAckResponse matches the ack to its write by offset
+    } else if (seqNumberDelta > 0 && _currentOperation == kCOBurst) {
+        // Burst packets were lost in between. The missing data is read again once the burst completes.
+        qCDebug(FileManagerLog) << "receiveMessage burst packets lost:" << seqNumberDelta;
+    } else if (incomingSeqNumber != expectedSeqNumber) {
+        // Make sure we have a good sequence number
         switch (_currentOperation) {
             case kCOBurst:
             case kCORead:
@@ -365,7 +767,9 @@ void FileManager::receiveMessage(LinkInterface* link, mavlink_message_t message)
     }
     
     // Move past the incoming sequence number for next request
-    _lastOutgoingSeqNumber = incomingSeqNumber;
+    if (_currentOperation != kCOWrite) {
+        _lastOutgoingSeqNumber = incomingSeqNumber;
+    }
 
     if (request->hdr.opcode == kRspAck) {
         switch (request->hdr.req_opcode) {
@@ -390,6 +794,14 @@ void FileManager::receiveMessage(LinkInterface* link, mavlink_message_t message)
                 _createAckResponse(request);
                 break;
                 
+            case kCmdCalcFileCRC32:
+                if (_currentOperation == kCODownloadCRC32) {
+                    _downloadCRC32AckResponse(request);
+                } else {
+                    _crc32AckResponse(request);
+                }
+                break;
+                
             case kCmdWriteFile:
                 _writeAckResponse(request);
                 break;
@@ -405,16 +817,30 @@ void FileManager::receiveMessage(LinkInterface* link, mavlink_message_t message)
         // Nak's normally have 1 byte of data for error code, except for kErrFailErrno which has additional byte for errno
         Q_ASSERT((errorCode == kErrFailErrno && request->hdr.size == 2) || request->hdr.size == 1);
         
+        if (errorCode == kErrEOF && request->hdr.req_opcode == kCmdBurstReadFile && _currentOperation == kCOBurst) {
+            // End of the burst, fill in whatever was lost along the way
+            _downloadBurstComplete();
+            return;
+        } else if (errorCode == kErrEOF && request->hdr.req_opcode == kCmdReadFile && _currentOperation == kCORead) {
+            // The file is shorter than Open reported. Drop the ranges past the end and carry on.
+            _markDownloadReceived(_downloadRequestOffset, _downloadFileSize - _downloadRequestOffset);
+            _downloadFileSize = _downloadRequestOffset;
+            _downloadFile.resize(_downloadFileSize);
+            _sendNextDownloadRead();
+            return;
+        } else if (request->hdr.req_opcode == kCmdCalcFileCRC32 && _currentOperation == kCODownloadCRC32) {
+            // The download still works without the CRC32, it just can't be resumed
+            qCDebug(FileManagerLog) << "Download CRC32 failed:" << errorString(errorCode);
+            _sendDownloadOpen();
+            return;
+        }
+        
         _currentOperation = kCOIdle;
 
         if (request->hdr.req_opcode == kCmdListDirectory && errorCode == kErrEOF) {
             // This is not an error, just the end of the list loop
             emit commandComplete();
             return;
-        } else if ((request->hdr.req_opcode == kCmdReadFile || request->hdr.req_opcode == kCmdBurstReadFile) && errorCode == kErrEOF) {
-            // This is not an error, just the end of the download loop
-            _closeDownloadSession(true /* success */);
-            return;
         } else if (request->hdr.req_opcode == kCmdCreateFile) {
             _emitErrorMessage(tr("Nak received creating file, error: %1").arg(errorString(request->data[0])));
             return;
@@ -496,7 +922,18 @@ void FileManager::streamPath(const QString& from, const QDir& downloadDir)
 	_downloadWorker(from, downloadDir, false /* stream file */);
 }
 
-void FileManager::_downloadWorker(const QString& from, const QDir& downloadDir, bool readFile)
+void FileManager::streamPath(const QString& from, const QDir& downloadDir, quint32 crc32)
+{
+    if (_currentOperation != kCOIdle) {
+        _emitErrorMessage(tr("Command not sent. Waiting for previous command to complete."));
+        return;
+    }
+    
+	qCDebug(FileManagerLog) << "streamPath from:to:crc32" << from << downloadDir << crc32;
+	_downloadWorker(from, downloadDir, false /* stream file */, true /* crc32 known */, crc32);
+}
+
+void FileManager::_downloadWorker(const QString& from, const QDir& downloadDir, bool readFile, bool crc32Known, quint32 crc32)
 {
 	if (from.isEmpty()) {
 		return;
@@ -514,18 +951,79 @@ void FileManager::_downloadWorker(const QString& from, const QDir& downloadDir,
 	}
 	i++; // move past slash
 	_readFileDownloadFilename = from.right(from.size() - i);
+	_downloadRemotePath = from;
+	_downloadStream = !readFile;
+	_downloadCRC32Valid = false;
 	
-	_currentOperation = readFile ? kCOOpenRead : kCOOpenBurst;
+	if (crc32Known) {
+		_downloadCRC32 = crc32;
+		_downloadCRC32Valid = true;
+		_sendDownloadOpen();
+		return;
+	}
+	
+	// The CRC32 identifies the file on the vehicle, a previous download is only resumed if it is still the same
+	_currentOperation = kCODownloadCRC32;
 	
 	Request request;
 	request.hdr.session = 0;
-	request.hdr.opcode = kCmdOpenFileRO;
+	request.hdr.opcode = kCmdCalcFileCRC32;
 	request.hdr.offset = 0;
 	request.hdr.size = 0;
 	_fillRequestWithString(&request, from);
 	_sendRequest(&request);
 }
 
+void FileManager::calcFileCRC32(const QString& path)
+{
+    if (_currentOperation != kCOIdle) {
+        _emitErrorMessage(tr("Command not sent. Waiting for previous command to complete."));
+        return;
+    }
+    
+    qCDebug(FileManagerLog) << "calcFileCRC32 path:" << path;
+    
+    _currentOperation = kCOCalcCRC32;
+    
+    Request request;
+    request.hdr.session = 0;
+    request.hdr.opcode = kCmdCalcFileCRC32;
+    request.hdr.offset = 0;
+    request.hdr.size = 0;
+    _fillRequestWithString(&request, path);
+    _sendRequest(&request);
+}
+
+void FileManager::cancel(void)
+{
+    qCDebug(FileManagerLog) << "cancel _currentOperation:" << _currentOperation;
+    
+    _clearAckTimeout();
+    
+    switch (_currentOperation) {
+        case kCORead:
+        case kCOBurst:
+            _closeDownloadSession(false /* failure */);
+            break;
+            
+        case kCOWrite:
+            _closeUploadSession(false /* failure */);
+            break;
+            
+        case kCOOpenRead:
+        case kCOOpenBurst:
+        case kCOCreate:
+            // The open may have made it to the vehicle
+            _currentOperation = kCOIdle;
+            _sendResetCommand();
+            break;
+            
+        default:
+            _currentOperation = kCOIdle;
+            break;
+    }
+}
+
 /// @brief Uploads the specified file.
 ///     @param toPath File in UAS to upload to, fully qualified path
 ///     @param uploadFile Local file to upload from
@@ -545,18 +1043,17 @@ void FileManager::uploadPath(const QString& toPath, const QFileInfo& uploadFile)
         return;
     }
 
-    QFile file(uploadFile.absoluteFilePath());
-    if (!file.open(QIODevice::ReadOnly)) {
-            _emitErrorMessage(tr("Unable to open local file for upload (%1)").arg(uploadFile.absoluteFilePath()));
-            return;
-        }
-
-    _writeFileAccumulator = file.readAll();
-    _writeFileSize = _writeFileAccumulator.size();
+    // The file stays open for the upload, data blocks are read from it as they are sent
+    _writeFile.setFileName(uploadFile.absoluteFilePath());
+    if (!_writeFile.open(QIODevice::ReadOnly)) {
+        _emitErrorMessage(tr("Unable to open local file for upload (%1)").arg(uploadFile.absoluteFilePath()));
+        return;
+    }
 
-    file.close();
+    _writeFileSize = _writeFile.size();
 
-    if (_writeFileAccumulator.size() == 0) {
+    if (_writeFileSize == 0) {
+        _writeFile.close();
         _emitErrorMessage(tr("Unable to read data from local file (%1)").arg(uploadFile.absoluteFilePath()));
         return;
     }
@@ -652,10 +1149,19 @@ void FileManager::_ackTimeout(void)
     // to idle. FileView UI works this way with the List command.
 
     switch (_currentOperation) {
-        case kCORead:
         case kCOBurst:
-            _closeDownloadSession(false /* failure */);
-            _emitErrorMessage(tr("Timeout waiting for ack: Download failed"));
+            // The burst stalled, read what is missing instead
+            _downloadBurstComplete();
+            break;
+            
+        case kCORead:
+            if (++_downloadRetryCount <= _maxDownloadRetries) {
+                qCDebug(FileManagerLog) << "_ackTimeout resending read: offset:retry" << _downloadRequestOffset << _downloadRetryCount;
+                _sendNextDownloadRead();
+            } else {
+                _closeDownloadSession(false /* failure */);
+                _emitErrorMessage(tr("Timeout waiting for ack: Download failed"));
+            }
             break;
             
         case kCOOpenRead:
@@ -665,6 +1171,11 @@ void FileManager::_ackTimeout(void)
             _sendResetCommand();
             break;
             
+        case kCODownloadCRC32:
+            _currentOperation = kCOIdle;
+            _emitErrorMessage(tr("Timeout waiting for ack: Download failed"));
+            break;
+            
         case kCOCreate:
             _currentOperation = kCOIdle;
             _emitErrorMessage(tr("Timeout waiting for ack: Upload failed"));
@@ -672,8 +1183,7 @@ void FileManager::_ackTimeout(void)
             break;
             
         case kCOWrite:
-            _closeUploadSession(false /* failure */);
-            _emitErrorMessage(tr("Timeout waiting for ack: Upload failed"));
+            _writeTimeout();
             break;
 			
         default:
@@ -683,12 +1193,46 @@ void FileManager::_ackTimeout(void)
     }
 }
 
+/// @brief Resets all sessions on the vehicle. This also closes the sessions of other FileManagers, so it is only used
+/// when an open may have made it to the vehicle without the session being known. The ack is not waited for.
 void FileManager::_sendResetCommand(void)
 {
     Request request;
     request.hdr.opcode = kCmdResetSessions;
     request.hdr.size = 0;
-    _sendRequest(&request);
+    _sendRequestNoTimeout(&request);
+}
+
+/// @brief Closes the active session on the vehicle. The ack is not waited for.
+void FileManager::_sendTerminateCommand(void)
+{
+    Request request;
+    request.hdr.session = _activeSession;
+    request.hdr.opcode = kCmdTerminateSession;
+    request.hdr.size = 0;
+    _sendRequestNoTimeout(&request);
+    
+    _activeSession = 0;
+}
+
+/// @brief Determines whether a response belongs to the command in progress. Several FileManagers may talk to the same
+/// vehicle, each one in its own range of sequence numbers.
+bool FileManager::_isOwnResponse(Request* response)
+{
+    bool sessionOperation = _currentOperation == kCORead || _currentOperation == kCOBurst || _currentOperation == kCOWrite;
+    if (sessionOperation && response->hdr.session != 0) {
+        return response->hdr.session == _activeSession;
+    }
+    
+    // Responses without our session are matched by the request they answer
+    int16_t seqNumberDelta = (int16_t)(response->hdr.seqNumber - (uint16_t)(_lastOutgoingSeqNumber + 1));
+    return response->hdr.req_opcode == _outstandingOpcode && qAbs((int)seqNumberDelta) < _seqNumberWindow;
+}
+
+void FileManager::setSequenceSpace(int space)
+{
+    Q_ASSERT(_currentOperation == kCOIdle);
+    _lastOutgoingSeqNumber = (uint16_t)(space * _sequenceSpaceSize);
 }
 
 void FileManager::_emitErrorMessage(const QString& msg)
@@ -703,17 +1247,24 @@ void FileManager::_emitListEntry(const QString& entry)
     emit listEntry(entry);
 }
 
-/// @brief Sends the specified Request out to the UAS.
+/// @brief Sends the specified Request out to the UAS and starts the ack timeout.
 void FileManager::_sendRequest(Request* request)
 {
+    _setupAckTimeout();
+    _sendRequestNoTimeout(request);
+}
 
+/// @brief Sends the specified Request out to the UAS. The caller is responsible for the ack timeout.
+void FileManager::_sendRequestNoTimeout(Request* request)
+{
     mavlink_message_t message;
 
-    _setupAckTimeout();
-    
     _lastOutgoingSeqNumber++;
 
     request->hdr.seqNumber = _lastOutgoingSeqNumber;
+    if (request->hdr.opcode != kCmdResetSessions && request->hdr.opcode != kCmdTerminateSession) {
+        _outstandingOpcode = request->hdr.opcode;
+    }
     
     qCDebug(FileManagerLog) << "_sendRequest opcode:" << request->hdr.opcode << "seqNumber:" << request->hdr.seqNumber;
     
@@ -27,6 +27,9 @@
 #include <QObject>
 #include <QDir>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
 
 #include "UASInterface.h"
 #include "QGCLoggingCategory.h"
@@ -55,16 +58,49 @@ public:
 	///     @param downloadDir Local directory to download file to
 	void downloadPath(const QString& from, const QDir& downloadDir);
 	
-	/// Stream downloads the specified file.
+	/// Stream downloads the specified file. Burst packets which are lost are read again with individual read
+	/// requests once the burst completes.
 	///     @param from File to download from UAS, fully qualified path
 	///     @param downloadDir Local directory to download file to
 	void streamPath(const QString& from, const QDir& downloadDir);
 	
+	/// Stream downloads the specified file whose CRC32 on the vehicle is already known, which saves the vehicle
+	/// calculating it again before the download starts.
+	///     @param crc32 CRC32 of the file on the vehicle as returned by calcFileCRC32
+	void streamPath(const QString& from, const QDir& downloadDir, quint32 crc32);
+	
+	// Downloads are written to <filename>.partial as the data arrives. If a download fails the ranges which are still
+	// missing are saved to <filename>.partial.state together with the size and CRC32 of the file on the vehicle. The
+	// next download of the same file only reads those ranges, provided the file on the vehicle still has the same
+	// size and CRC32.
+	
 	/// Lists the specified directory. Emits listEntry signal for each entry, followed by listComplete signal.
 	///		@param dirPath Fully qualified path to list
 	void listDirectory(const QString& dirPath);
 	
-    /// Upload the specified file to the specified location
+    /// Calculates the CRC32 of the specified file on the vehicle. Emits fileCRC32 followed by commandComplete.
+    ///     @param path Fully qualified path of file on the vehicle
+    void calcFileCRC32(const QString& path);
+    
+    /// Cancels the command in progress. A cancelled download can be resumed by downloading the same file again.
+    /// No commandComplete or commandError signal is sent for the cancelled command.
+    void cancel(void);
+    
+    /// Limits the download rate in bytes per second, 0 for no limit. While limited, downloads use paced read
+    /// requests instead of bursts.
+    void setDownloadRateLimit(int bytesPerSecond) { _downloadRateLimit = bytesPerSecond; }
+    int downloadRateLimit(void) { return _downloadRateLimit; }
+    
+    /// Several FileManagers can talk to the same vehicle at once as long as each one uses its own sequence space.
+    /// Space 0 is used by the FileManager of the vehicle. Must be set before the first command is sent.
+    ///     @param space 0 to sequenceSpaceCount - 1
+    void setSequenceSpace(int space);
+    static const int sequenceSpaceCount = 4;
+    
+    Vehicle* vehicle(void) { return _vehicle; }
+    
+    /// Upload the specified file to the specified location. Several write requests are kept in flight at a time
+    /// and only the writes which are not acked are resent.
     void uploadPath(const QString& toPath, const QFileInfo& uploadFile);
     
 signals:
@@ -73,6 +109,9 @@ signals:
     /// Signalled to indicate a new directory entry was received.
     void listEntry(const QString& entry);
     
+    /// Signalled with the result of calcFileCRC32
+    void fileCRC32(quint32 crc32);
+    
     // Signals associated with all commands
     
     /// Signalled after a command has completed
@@ -122,6 +161,9 @@ private:
 
             // Length of file chunk written by write command
             uint32_t writeFileLength;
+            
+            // CRC32 returned by CalcFileCRC32 command
+            uint32_t crc32;
         };
     };
 
@@ -177,26 +219,53 @@ private:
 			kCOBurst,		// waiting for Burst response
             kCOWrite,       // waiting for Write response
             kCOCreate,      // waiting for Create response
+            kCOCalcCRC32,   // waiting for CalcFileCRC32 response
+            kCODownloadCRC32,   // waiting for CalcFileCRC32 response, followed by Open for download
         };
     
+    /// A write request which has been sent but not yet acked
+    typedef struct {
+        uint8_t size;           ///< Number of data bytes written
+        int     retryCount;     ///< Number of times the request has been resent
+        qint64  sentMsecs;      ///< Time of the last send in _writeClock time
+    } WriteRequest_t;
+    
     bool _sendOpcodeOnlyCmd(uint8_t opcode, OperationState newOpState);
     void _setupAckTimeout(void);
     void _clearAckTimeout(void);
     void _emitErrorMessage(const QString& msg);
     void _emitListEntry(const QString& entry);
     void _sendRequest(Request* request);
+    void _sendRequestNoTimeout(Request* request);
     void _fillRequestWithString(Request* request, const QString& str);
     void _openAckResponse(Request* openAck);
     void _downloadAckResponse(Request* readAck, bool readFile);
     void _listAckResponse(Request* listAck);
+    void _crc32AckResponse(Request* crc32Ack);
+    void _downloadCRC32AckResponse(Request* crc32Ack);
+    void _sendDownloadOpen(void);
     void _createAckResponse(Request* createAck);
     void _writeAckResponse(Request* writeAck);
-    void _writeFileDatablock(void);
+    void _fillWriteWindow(void);
+    bool _sendWriteRequest(uint32_t offset, WriteRequest_t& writeRequest);
+    void _writeTimeout(void);
+    void _setupWriteTimeout(void);
+    void _updateWriteRto(int rttMsecs);
     void _sendListCommand(void);
     void _sendResetCommand(void);
+    void _sendTerminateCommand(void);
+    bool _isOwnResponse(Request* response);
     void _closeDownloadSession(bool success);
+    bool _openDownloadFile(bool* resumed);
+    void _markDownloadReceived(uint32_t offset, uint32_t size);
+    void _sendNextDownloadRead(void);
+    void _downloadBurstComplete(void);
+    bool _loadDownloadState(void);
+    void _saveDownloadState(void);
+    QString _downloadPartialFilePath(void);
+    QString _downloadStateFilePath(void);
     void _closeUploadSession(bool success);
-	void _downloadWorker(const QString& from, const QDir& downloadDir, bool readFile);
+	void _downloadWorker(const QString& from, const QDir& downloadDir, bool readFile, bool crc32Known = false, quint32 crc32 = 0);
     
     static QString errorString(uint8_t errorCode);
 
@@ -206,6 +275,7 @@ private:
     Vehicle* _vehicle;
     
     uint16_t _lastOutgoingSeqNumber; ///< Sequence number sent in last outgoing packet
+    uint8_t  _outstandingOpcode;     ///< Opcode of the last request which expects a response
 
     unsigned    _listOffset;    ///< offset for the current List operation
     QString     _listPath;      ///< path for the current List operation
@@ -214,20 +284,43 @@ private:
     
     uint32_t    _readOffset;                ///< current read offset
     
-    uint32_t    _writeOffset;               ///< current write offset
-    uint32_t    _writeSize;                 ///< current write data size
+    uint32_t    _writeOffset;               ///< offset of the next data block which has not been sent yet
     uint32_t    _writeFileSize;             ///< Size of file being uploaded
-    QByteArray  _writeFileAccumulator;      ///< Holds file being uploaded
+    QFile       _writeFile;                 ///< Local file being uploaded, data blocks are read as they are sent
+    QMap<uint32_t, WriteRequest_t> _writePending; ///< Write requests waiting for an ack, keyed by file offset
+    QElapsedTimer _writeClock;              ///< Time base for WriteRequest_t::sentMsecs
+    int         _writeSrttMsecs;            ///< Smoothed write round trip time, -1 for no sample yet
+    int         _writeRttvarMsecs;          ///< Write round trip time variation
+    int         _writeRtoMsecs;             ///< Time after which an unacked write is resent
     
-    uint32_t    _downloadOffset;            ///< current download offset
-    QByteArray  _readFileAccumulator;       ///< Holds file being downloaded
+    uint32_t    _downloadOffset;            ///< offset expected for the next burst packet
+    uint32_t    _downloadRequestOffset;     ///< offset of the outstanding read request
+    int         _downloadRetryCount;        ///< number of times the outstanding read request has been resent
+    int         _downloadRateLimit;         ///< download rate limit in bytes per second, 0 for none
+    QTimer      _downloadPaceTimer;         ///< Delays the next read request to stay within _downloadRateLimit
+    QElapsedTimer _downloadRequestTime;     ///< Time since the outstanding read request was sent
+    QFile       _downloadFile;              ///< Partial download file, data is written at its offset as it arrives
+    QMap<uint32_t, uint32_t> _downloadMissing; ///< Ranges of the file not yet received: start offset -> end offset (exclusive)
+    uint32_t    _downloadMissingBytes;      ///< Total number of bytes in _downloadMissing
     QDir        _readFileDownloadDir;       ///< Directory to download file to
     QString     _readFileDownloadFilename;  ///< Filename (no path) for download file
     uint32_t    _downloadFileSize;          ///< Size of file being downloaded
+    QString     _downloadRemotePath;        ///< Fully qualified path of the file being downloaded
+    bool        _downloadStream;            ///< true: download uses burst reads
+    bool        _downloadCRC32Valid;        ///< false: vehicle could not calculate the CRC32, download can't be resumed
+    quint32     _downloadCRC32;             ///< CRC32 of the file on the vehicle
 
     uint8_t     _systemIdQGC;               ///< System ID for QGC
     uint8_t     _systemIdServer;            ///< System ID for server
     
+    static const int _maxDownloadRetries = 3;   ///< Number of times a read request is resent before the download fails
+    static const int _maxWriteRetries = 5;      ///< Number of times a write request is resent before the upload fails
+    static const int _writeWindowSize = 4;      ///< Maximum number of write requests in flight
+    static const int _initialWriteRtoMsecs = 1000;
+    static const int _minWriteRtoMsecs = 200;
+    static const int _sequenceSpaceSize = 0x10000 / sequenceSpaceCount;
+    static const int _seqNumberWindow = 0x1000;    ///< Responses without a session must be this close to the expected sequence number
+    
     // We give MockLinkFileServer friend access so that it can use the data structures and opcodes
     // to build a mock mavlink file server for testing.
     friend class MockLinkFileServer;
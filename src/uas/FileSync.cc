@@ -0,0 +1,422 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "FileSync.h"
+#include "MAVLinkProtocol.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+QGC_LOGGING_CATEGORY(FileSyncLog, "FileSyncLog")
+
+FileSync::FileSync(FileManager* fileManager, QObject* parent)
+    : QObject(parent)
+    , _fileManager(fileManager)
+    , _phase(phaseIdle)
+    , _bandwidthBudget(0)
+    , _remoteCRC32Valid(false)
+    , _remoteCRC32(0)
+    , _checkCount(0)
+    , _totalWeight(0)
+    , _completedWeight(0)
+    , _downloadedCount(0)
+    , _skippedCount(0)
+{
+    connect(_fileManager, &FileManager::listEntry,          this, &FileSync::_listEntry);
+    connect(_fileManager, &FileManager::fileCRC32,          this, &FileSync::_fileCRC32);
+    connect(_fileManager, &FileManager::commandComplete,    this, &FileSync::_commandComplete);
+    connect(_fileManager, &FileManager::commandError,       this, &FileSync::_commandError);
+}
+
+void FileSync::sync(const QString& remoteDir, const QDir& localDir)
+{
+    if (running()) {
+        emit error(tr("Sync already in progress"));
+        return;
+    }
+
+    qCDebug(FileSyncLog) << "sync remote:local" << remoteDir << localDir.absolutePath();
+
+    _remoteRoot = remoteDir.endsWith('/') ? remoteDir : remoteDir + '/';
+    _localRoot.setPath(localDir.absolutePath());
+
+    _dirQueue.clear();
+    _checkQueue.clear();
+    _downloadQueue.clear();
+    _checkCount = 0;
+    _totalWeight = 0;
+    _completedWeight = 0;
+    _downloadedCount = 0;
+    _skippedCount = 0;
+
+    _phase = phaseList;
+    emit progress(0);
+
+    _dirQueue.append(remoteDir);
+    _listNextDirectory();
+}
+
+void FileSync::cancel(void)
+{
+    if (!running()) {
+        return;
+    }
+
+    qCDebug(FileSyncLog) << "cancel";
+
+    _phase = phaseIdle;
+    _fileManager->cancel();
+    _cancelDownloads();
+
+    emit error(tr("Sync cancelled"));
+}
+
+quint32 FileSync::crc32(const char* data, qint64 length, quint32 crc)
+{
+    static quint32 table[256];
+    static bool tableInitialized = false;
+
+    if (!tableInitialized) {
+        for (quint32 i=0; i<256; i++) {
+            quint32 value = i;
+            for (int bit=0; bit<8; bit++) {
+                value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+            }
+            table[i] = value;
+        }
+        tableInitialized = true;
+    }
+
+    for (qint64 i=0; i<length; i++) {
+        crc = table[(crc ^ (quint8)data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+void FileSync::_listEntry(const QString& entry)
+{
+    if (_phase != phaseList) {
+        return;
+    }
+
+    // Entries are the type character followed by the name, files are followed by a tab and the size
+    QStringList fields = entry.mid(1).split('\t');
+    QString name = fields[0];
+    if (name.isEmpty() || name == "." || name == "..") {
+        return;
+    }
+
+    QString remotePath = _listDir.endsWith('/') ? _listDir + name : _listDir + '/' + name;
+
+    if (entry.startsWith('D')) {
+        _dirQueue.append(remotePath);
+    } else if (entry.startsWith('F')) {
+        File_t file;
+
+        file.remotePath = remotePath;
+        file.localPath = _localRoot.absoluteFilePath(remotePath.mid(_remoteRoot.length()));
+        file.size = -1;
+        file.crc32Valid = false;
+        file.crc32 = 0;
+        if (fields.count() > 1) {
+            bool ok;
+            qint64 size = fields[1].toLongLong(&ok);
+            if (ok) {
+                file.size = size;
+            }
+        }
+
+        _checkQueue.append(file);
+    }
+}
+
+void FileSync::_fileCRC32(quint32 crc32)
+{
+    if (_phase == phaseCheck) {
+        _remoteCRC32 = crc32;
+        _remoteCRC32Valid = true;
+    }
+}
+
+void FileSync::_commandComplete(void)
+{
+    switch (_phase) {
+        case phaseList:
+            _listNextDirectory();
+            break;
+
+        case phaseCheck:
+        {
+            quint32 localCRC32;
+            if (_remoteCRC32Valid && _localFileCRC32(_currentFile.localPath, &localCRC32) && localCRC32 == _remoteCRC32) {
+                qCDebug(FileSyncLog) << "Skipping unchanged file" << _currentFile.remotePath;
+                _skippedCount++;
+                emit fileSkipped(_currentFile.remotePath);
+            } else {
+                // The download doesn't need to ask the vehicle for the CRC32 again
+                _currentFile.crc32Valid = _remoteCRC32Valid;
+                _currentFile.crc32 = _remoteCRC32;
+                _downloadQueue.append(_currentFile);
+            }
+            _checkNextFile();
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void FileSync::_commandError(const QString& msg)
+{
+    switch (_phase) {
+        case phaseList:
+            _fail(tr("Sync failed listing %1: %2").arg(_listDir).arg(msg));
+            break;
+
+        case phaseCheck:
+            // Vehicle may not support CRC32, so the file can't be shown to be unchanged
+            qCDebug(FileSyncLog) << "CRC32 failed, downloading" << _currentFile.remotePath << msg;
+            _downloadQueue.append(_currentFile);
+            _checkNextFile();
+            break;
+
+        default:
+            break;
+    }
+}
+
+void FileSync::_sessionComplete(void)
+{
+    FileManager* session = qobject_cast<FileManager*>(sender());
+    if (_phase != phaseDownload || !_activeDownloads.contains(session)) {
+        return;
+    }
+
+    File_t file = _activeDownloads.take(session);
+    _downloadProgress.remove(session);
+
+    _completedWeight += _fileWeight(file);
+    _downloadedCount++;
+    emit fileDownloaded(file.remotePath);
+
+    _startDownloads();
+}
+
+void FileSync::_sessionError(const QString& msg)
+{
+    FileManager* session = qobject_cast<FileManager*>(sender());
+    if (_phase != phaseDownload || !_activeDownloads.contains(session)) {
+        return;
+    }
+
+    File_t file = _activeDownloads.take(session);
+    _downloadProgress.remove(session);
+
+    _fail(tr("Sync failed downloading %1: %2").arg(file.remotePath).arg(msg));
+}
+
+void FileSync::_sessionProgress(int value)
+{
+    FileManager* session = qobject_cast<FileManager*>(sender());
+    if (_phase != phaseDownload || !_activeDownloads.contains(session)) {
+        return;
+    }
+
+    _downloadProgress[session] = value;
+    _emitDownloadProgress();
+}
+
+void FileSync::_listNextDirectory(void)
+{
+    if (_dirQueue.isEmpty()) {
+        qCDebug(FileSyncLog) << "List complete, files:" << _checkQueue.count();
+
+        _phase = phaseCheck;
+        _checkCount = _checkQueue.count();
+        _checkNextFile();
+        return;
+    }
+
+    _listDir = _dirQueue.takeFirst();
+    _fileManager->listDirectory(_listDir);
+}
+
+void FileSync::_checkNextFile(void)
+{
+    if (_checkCount) {
+        emit progress((_checkProgressPercent * (_checkCount - _checkQueue.count())) / _checkCount);
+    }
+
+    while (!_checkQueue.isEmpty()) {
+        _currentFile = _checkQueue.takeFirst();
+
+        // A missing file or one with a different size doesn't need the vehicle to calculate a CRC32
+        QFileInfo localInfo(_currentFile.localPath);
+        if (!localInfo.exists() || (_currentFile.size >= 0 && localInfo.size() != _currentFile.size)) {
+            _downloadQueue.append(_currentFile);
+            continue;
+        }
+
+        _remoteCRC32Valid = false;
+        _fileManager->calcFileCRC32(_currentFile.remotePath);
+        return;
+    }
+
+    qCDebug(FileSyncLog) << "Check complete, downloads:skipped" << _downloadQueue.count() << _skippedCount;
+
+    _phase = phaseDownload;
+    _totalWeight = 0;
+    foreach (const File_t& file, _downloadQueue) {
+        _totalWeight += _fileWeight(file);
+    }
+    _completedWeight = 0;
+
+    _createSessions();
+    _startDownloads();
+}
+
+/// Creates the FileManagers used for downloads. Each one has its own sequence space so their responses can be told
+/// apart, the vehicle FileManager keeps sequence space 0.
+void FileSync::_createSessions(void)
+{
+    if (_sessions.isEmpty()) {
+        for (int i=0; i<maxDownloadSessions; i++) {
+            FileManager* session = new FileManager(this, _fileManager->vehicle());
+            session->setSequenceSpace(i + 1);
+
+            connect(MAVLinkProtocol::instance(), &MAVLinkProtocol::messageReceived, session, &FileManager::receiveMessage);
+            connect(session, &FileManager::commandComplete, this, &FileSync::_sessionComplete);
+            connect(session, &FileManager::commandError,    this, &FileSync::_sessionError);
+            connect(session, &FileManager::commandProgress, this, &FileSync::_sessionProgress);
+
+            _sessions.append(session);
+        }
+    }
+
+    int rateLimit = _bandwidthBudget > 0 ? qMax(_bandwidthBudget / _sessions.count(), 1) : 0;
+    foreach (FileManager* session, _sessions) {
+        session->setDownloadRateLimit(rateLimit);
+    }
+}
+
+/// Starts the next queued download on every idle session. Completes the sync once nothing is left.
+void FileSync::_startDownloads(void)
+{
+    _emitDownloadProgress();
+
+    if (_downloadQueue.isEmpty() && _activeDownloads.isEmpty()) {
+        qCDebug(FileSyncLog) << "Sync complete, downloaded:skipped" << _downloadedCount << _skippedCount;
+
+        _phase = phaseIdle;
+        emit progress(100);
+        emit complete(_downloadedCount, _skippedCount);
+        return;
+    }
+
+    foreach (FileManager* session, _sessions) {
+        if (_downloadQueue.isEmpty()) {
+            break;
+        }
+        if (_activeDownloads.contains(session)) {
+            continue;
+        }
+
+        File_t file = _downloadQueue.takeFirst();
+
+        QFileInfo localInfo(file.localPath);
+        if (!QDir().mkpath(localInfo.absolutePath())) {
+            _fail(tr("Unable to create local directory (%1)").arg(localInfo.absolutePath()));
+            return;
+        }
+
+        qCDebug(FileSyncLog) << "Downloading" << file.remotePath << "to" << localInfo.absolutePath();
+        _activeDownloads[session] = file;
+        _downloadProgress[session] = 0;
+        if (file.crc32Valid) {
+            session->streamPath(file.remotePath, localInfo.absoluteDir(), file.crc32);
+        } else {
+            session->streamPath(file.remotePath, localInfo.absoluteDir());
+        }
+
+        if (_phase != phaseDownload) {
+            // The download failed right away and took the sync down with it
+            return;
+        }
+    }
+}
+
+void FileSync::_emitDownloadProgress(void)
+{
+    if (_totalWeight == 0) {
+        return;
+    }
+
+    qint64 weight = _completedWeight;
+    for (QMap<FileManager*, File_t>::const_iterator download=_activeDownloads.constBegin(); download!=_activeDownloads.constEnd(); download++) {
+        weight += (_fileWeight(download.value()) * _downloadProgress[download.key()]) / 100;
+    }
+    emit progress(_checkProgressPercent + ((100 - _checkProgressPercent) * weight) / _totalWeight);
+}
+
+/// Cancels the downloads in progress, they are resumed by the next sync
+void FileSync::_cancelDownloads(void)
+{
+    foreach (FileManager* session, _activeDownloads.keys()) {
+        session->cancel();
+    }
+    _activeDownloads.clear();
+    _downloadProgress.clear();
+}
+
+void FileSync::_fail(const QString& msg)
+{
+    qCDebug(FileSyncLog) << "Sync failed" << msg;
+
+    _phase = phaseIdle;
+    _cancelDownloads();
+
+    emit error(msg);
+}
+
+bool FileSync::_localFileCRC32(const QString& localPath, quint32* crc32)
+{
+    QFile file(localPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    quint32 crc = 0;
+    char buffer[4096];
+    qint64 cBytes;
+    while ((cBytes = file.read(buffer, sizeof(buffer))) > 0) {
+        crc = FileSync::crc32(buffer, cBytes, crc);
+    }
+    if (cBytes < 0) {
+        return false;
+    }
+
+    *crc32 = crc;
+    return true;
+}
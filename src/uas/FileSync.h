@@ -0,0 +1,150 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef FileSync_H
+#define FileSync_H
+
+#include "FileManager.h"
+#include "QGCLoggingCategory.h"
+
+#include <QObject>
+#include <QDir>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+
+Q_DECLARE_LOGGING_CATEGORY(FileSyncLog)
+
+/// @file
+///     @brief Mirrors a directory tree on the vehicle into a local directory. Files which are already present
+///             locally with the same size and CRC32 are skipped, everything else is downloaded. Downloads run over
+///             several sessions at once, each with its own FileManager.
+
+class FileSync : public QObject
+{
+    Q_OBJECT
+
+public:
+    FileSync(FileManager* fileManager, QObject* parent = NULL);
+
+    /// Starts syncing the remote directory tree into the local directory
+    ///     @param remoteDir Fully qualified path of the directory on the vehicle
+    ///     @param localDir Local directory to mirror into, created if needed
+    void sync(const QString& remoteDir, const QDir& localDir);
+
+    /// Stops the sync. Partially downloaded files are resumed by the next sync.
+    void cancel(void);
+
+    bool running(void) { return _phase != phaseIdle; }
+
+    /// Download bandwidth budget in bytes per second, 0 for no limit. The budget is shared by the download sessions.
+    int bandwidthBudget(void) { return _bandwidthBudget; }
+    void setBandwidthBudget(int bytesPerSecond) { _bandwidthBudget = bytesPerSecond; }
+
+    /// CRC32 as calculated by the vehicle for kCmdCalcFileCRC32: reflected 0xEDB88320 polynomial, zero initial
+    /// value, no final xor.
+    ///     @param crc32 CRC32 of the preceding data, 0 to start
+    static quint32 crc32(const char* data, qint64 length, quint32 crc32 = 0);
+
+    /// Number of files downloaded at the same time
+    static const int maxDownloadSessions = 2;
+
+signals:
+    /// Signalled with the overall progress of the sync: 0-100
+    void progress(int value);
+
+    /// Signalled for each file which is already up to date
+    void fileSkipped(const QString& remotePath);
+
+    /// Signalled for each file which has been downloaded
+    void fileDownloaded(const QString& remotePath);
+
+    /// Signalled when the sync is complete
+    void complete(int downloadedCount, int skippedCount);
+
+    /// Signalled if the sync fails or is cancelled. No complete signal follows.
+    void error(const QString& msg);
+
+private slots:
+    void _listEntry(const QString& entry);
+    void _fileCRC32(quint32 crc32);
+    void _commandComplete(void);
+    void _commandError(const QString& msg);
+    void _sessionComplete(void);
+    void _sessionError(const QString& msg);
+    void _sessionProgress(int value);
+
+private:
+    typedef struct {
+        QString remotePath;
+        QString localPath;
+        qint64  size;           ///< Size reported by the directory list, -1 if not known
+        bool    crc32Valid;     ///< true: crc32 was calculated by the vehicle during the check phase
+        quint32 crc32;          ///< CRC32 of the file on the vehicle, passed on to the download
+    } File_t;
+
+    enum Phase {
+        phaseIdle,
+        phaseList,      ///< Listing the remote directory tree
+        phaseCheck,     ///< Comparing remote files against the local mirror
+        phaseDownload   ///< Downloading changed files
+    };
+
+    void _listNextDirectory(void);
+    void _checkNextFile(void);
+    void _createSessions(void);
+    void _startDownloads(void);
+    void _emitDownloadProgress(void);
+    void _cancelDownloads(void);
+    void _fail(const QString& msg);
+    bool _localFileCRC32(const QString& localPath, quint32* crc32);
+    static qint64 _fileWeight(const File_t& file) { return qMax(file.size, (qint64)1); }
+
+    FileManager*    _fileManager;
+    Phase           _phase;
+    QString         _remoteRoot;
+    QDir            _localRoot;
+    int             _bandwidthBudget;
+
+    QList<FileManager*>         _sessions;          ///< FileManagers used for downloads, created on first use
+    QMap<FileManager*, File_t>  _activeDownloads;   ///< Download in progress on each busy session
+    QMap<FileManager*, int>     _downloadProgress;  ///< Percent complete of each active download
+
+    QStringList     _dirQueue;          ///< Remote directories still to be listed
+    QString         _listDir;           ///< Remote directory being listed
+    QList<File_t>   _checkQueue;        ///< Files still to be compared
+    QList<File_t>   _downloadQueue;     ///< Files still to be downloaded
+    File_t          _currentFile;       ///< File being compared
+    bool            _remoteCRC32Valid;
+    quint32         _remoteCRC32;
+
+    int             _checkCount;        ///< Number of files found by the list phase
+    qint64          _totalWeight;       ///< Sum of the weights of all files to download
+    qint64          _completedWeight;   ///< Sum of the weights of the files downloaded so far
+    int             _downloadedCount;
+    int             _skippedCount;
+
+    static const int _checkProgressPercent = 10;    ///< Share of the overall progress used by the list and check phases
+};
+
+#endif
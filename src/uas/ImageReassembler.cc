@@ -0,0 +1,259 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "ImageReassembler.h"
+
+#include <QtConcurrent>
+#include <QFutureWatcher>
+
+QGC_LOGGING_CATEGORY(ImageReassemblerLog, "ImageReassemblerLog")
+
+ImageReassembler::ImageReassembler(QObject* parent)
+    : QObject(parent)
+{
+    _gapTimer.setInterval(_gapTimerIntervalMsecs);
+    connect(&_gapTimer, &QTimer::timeout, this, &ImageReassembler::_checkGaps);
+}
+
+ImageReassembler::~ImageReassembler()
+{
+    qDeleteAll(_transfers);
+    
+    // Don't leave decodes running which reference nothing once we are gone
+    foreach (QFutureWatcherBase* watcher, findChildren<QFutureWatcherBase*>()) {
+        watcher->disconnect(this);
+        watcher->waitForFinished();
+    }
+}
+
+bool ImageReassembler::_sameImage(const mavlink_data_transmission_handshake_t& a, const mavlink_data_transmission_handshake_t& b)
+{
+    return a.type == b.type &&
+            a.size == b.size &&
+            a.width == b.width &&
+            a.height == b.height &&
+            a.packets == b.packets &&
+            a.payload == b.payload;
+}
+
+void ImageReassembler::handshakeReceived(int sysid, int compid, const mavlink_data_transmission_handshake_t& handshake)
+{
+    quint16 key = _transferKey(sysid, compid);
+    
+    if (_transfers.contains(key)) {
+        Transfer_t* transfer = _transfers[key];
+        
+        if (_sameImage(transfer->handshake, handshake)) {
+            // Sender restarted the same image, keep what we already have
+            qCDebug(ImageReassemblerLog) << "Resuming transfer" << sysid << compid << "received" << transfer->receivedCount << "of" << transfer->handshake.packets;
+            transfer->lastActivity.start();
+            return;
+        }
+        
+        qCDebug(ImageReassemblerLog) << "New image replaces incomplete transfer" << sysid << compid;
+        delete _transfers.take(key);
+    }
+    
+    if (handshake.packets == 0 || handshake.payload == 0 || handshake.payload > MAVLINK_MSG_ENCAPSULATED_DATA_FIELD_DATA_LEN ||
+            handshake.size == 0 || handshake.size > (quint32)_maxImageBytes || handshake.size > (quint32)handshake.packets * handshake.payload) {
+        // Also filters out handshakes which are requests, not transfer announcements
+        qCDebug(ImageReassemblerLog) << "Ignoring handshake size:packets:payload" << handshake.size << handshake.packets << handshake.payload;
+        return;
+    }
+    
+    Transfer_t* transfer = new Transfer_t;
+    
+    transfer->handshake = handshake;
+    transfer->buffer = QByteArray(handshake.size, 0);
+    transfer->received = QBitArray(handshake.packets);
+    transfer->receivedCount = 0;
+    transfer->rerequestCount = 0;
+    transfer->lastActivity.start();
+    _transfers[key] = transfer;
+    
+    qCDebug(ImageReassemblerLog) << "Transfer started" << sysid << compid << "size:packets:payload" << handshake.size << handshake.packets << handshake.payload;
+    
+    if (!_gapTimer.isActive()) {
+        _gapTimer.start();
+    }
+}
+
+void ImageReassembler::dataReceived(int sysid, int compid, const mavlink_encapsulated_data_t& data)
+{
+    quint16 key = _transferKey(sysid, compid);
+    
+    if (!_transfers.contains(key)) {
+        // No valid transaction
+        return;
+    }
+    
+    Transfer_t* transfer = _transfers[key];
+    int seq = data.seqnr;
+    
+    if (seq >= transfer->received.size() || transfer->received.testBit(seq)) {
+        // Out of range or duplicate
+        return;
+    }
+    
+    int offset = seq * transfer->handshake.payload;
+    int count = qMin((int)transfer->handshake.payload, transfer->buffer.size() - offset);
+    if (count > 0) {
+        memcpy(transfer->buffer.data() + offset, data.data, count);
+    }
+    
+    transfer->received.setBit(seq);
+    transfer->receivedCount++;
+    transfer->rerequestCount = 0;
+    transfer->lastActivity.start();
+    
+    if (transfer->receivedCount == transfer->received.size()) {
+        _completeTransfer(key);
+    }
+}
+
+int ImageReassembler::packetsReceived(int sysid, int compid)
+{
+    quint16 key = _transferKey(sysid, compid);
+    
+    return _transfers.contains(key) ? _transfers[key]->receivedCount : -1;
+}
+
+void ImageReassembler::cancelTransfer(int sysid, int compid)
+{
+    delete _transfers.take(_transferKey(sysid, compid));
+    
+    if (_transfers.isEmpty()) {
+        _gapTimer.stop();
+    }
+}
+
+void ImageReassembler::_checkGaps(void)
+{
+    foreach (quint16 key, _transfers.keys()) {
+        Transfer_t* transfer = _transfers[key];
+        int sysid = key >> 8;
+        int compid = key & 0xFF;
+        
+        if (transfer->lastActivity.elapsed() < gapTimeoutMsecs) {
+            continue;
+        }
+        
+        if (transfer->rerequestCount >= maxRerequests) {
+            qCDebug(ImageReassemblerLog) << "Transfer failed" << sysid << compid << "received" << transfer->receivedCount << "of" << transfer->handshake.packets;
+            delete _transfers.take(key);
+            emit transferFailed(sysid, compid);
+            continue;
+        }
+        
+        // Request each run of missing packets
+        int runs = 0;
+        int seq = 0;
+        int packets = transfer->received.size();
+        while (seq < packets && runs < _maxRunsPerRerequest) {
+            if (transfer->received.testBit(seq)) {
+                seq++;
+                continue;
+            }
+            
+            int firstMissing = seq;
+            while (seq < packets && !transfer->received.testBit(seq)) {
+                seq++;
+            }
+            
+            mavlink_data_transmission_handshake_t request = transfer->handshake;
+            request.size = firstMissing;
+            request.packets = seq - firstMissing;
+            
+            qCDebug(ImageReassemblerLog) << "Requesting missing packets" << sysid << compid << firstMissing << "count" << request.packets;
+            emit requestPackets(sysid, compid, request);
+            runs++;
+        }
+        
+        transfer->rerequestCount++;
+        transfer->lastActivity.start();
+    }
+    
+    if (_transfers.isEmpty()) {
+        _gapTimer.stop();
+    }
+}
+
+void ImageReassembler::_completeTransfer(quint16 key)
+{
+    Transfer_t* transfer = _transfers.take(key);
+    
+    qCDebug(ImageReassemblerLog) << "Transfer complete" << (key >> 8) << (key & 0xFF) << "bytes" << transfer->buffer.size();
+    
+    // Decoding a large jpeg takes long enough to stall the ui, so it is done on a worker thread
+    QFutureWatcher<QImage>* watcher = new QFutureWatcher<QImage>(this);
+    watcher->setProperty("transferKey", key);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, &ImageReassembler::_decodeFinished);
+    watcher->setFuture(QtConcurrent::run(&ImageReassembler::decodeImage,
+                                         transfer->buffer,
+                                         (int)transfer->handshake.type,
+                                         (int)transfer->handshake.width,
+                                         (int)transfer->handshake.height));
+    delete transfer;
+    
+    if (_transfers.isEmpty()) {
+        _gapTimer.stop();
+    }
+}
+
+void ImageReassembler::_decodeFinished(void)
+{
+    // Only decode watchers are connected to this slot
+    QFutureWatcher<QImage>* watcher = static_cast<QFutureWatcher<QImage>*>(sender());
+    
+    quint16 key = watcher->property("transferKey").toUInt();
+    QImage image = watcher->result();
+    watcher->deleteLater();
+    
+    emit imageDecoded(key >> 8, key & 0xFF, image);
+}
+
+QImage ImageReassembler::decodeImage(const QByteArray& bytes, int type, int width, int height)
+{
+    QImage image;
+    
+    if (type == MAVLINK_DATA_STREAM_IMG_RAW8U) {
+        // RAW greyscale, construct PGM header
+        QByteArray pgm = QString("P5\n%1 %2\n%3\n").arg(width).arg(height).arg(255).toLatin1();
+        pgm.append(bytes);
+        
+        if (!image.loadFromData(pgm, "PGM")) {
+            qWarning() << "ImageReassembler: could not create raw image";
+        }
+    } else if (type == MAVLINK_DATA_STREAM_IMG_BMP ||
+               type == MAVLINK_DATA_STREAM_IMG_JPEG ||
+               type == MAVLINK_DATA_STREAM_IMG_PGM ||
+               type == MAVLINK_DATA_STREAM_IMG_PNG) {
+        if (!image.loadFromData(bytes)) {
+            qWarning() << "ImageReassembler: loading data from image buffer failed";
+        }
+    } else {
+        qWarning() << "ImageReassembler: unsupported image type" << type;
+    }
+    
+    return image;
+}
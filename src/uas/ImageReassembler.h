@@ -0,0 +1,123 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef ImageReassembler_H
+#define ImageReassembler_H
+
+#include <QObject>
+#include <QMap>
+#include <QByteArray>
+#include <QBitArray>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QImage>
+
+#include "QGCMAVLink.h"
+#include "QGCLoggingCategory.h"
+
+Q_DECLARE_LOGGING_CATEGORY(ImageReassemblerLog)
+
+/// @file
+///     @brief Reassembles images sent through DATA_TRANSMISSION_HANDSHAKE/ENCAPSULATED_DATA. Packets can arrive
+///             out of order. Missing packets are tracked in a bitmap and re-requested once the transfer stalls.
+///             A repeated handshake for the same image resumes the transfer instead of restarting it. Each
+///             (sysid, compid) pair has its own transfer. Completed images are decoded on a worker thread.
+///
+///             Gaps are re-requested with a DATA_TRANSMISSION_HANDSHAKE which repeats the original handshake, but
+///             with size set to the first missing sequence number and packets set to the number of missing
+///             packets. A sender which doesn't understand this resends the whole image. The resumed
+///             transfer then fills in only the missing packets.
+
+class ImageReassembler : public QObject
+{
+    Q_OBJECT
+    
+public:
+    ImageReassembler(QObject* parent = NULL);
+    ~ImageReassembler();
+    
+    /// Starts a new transfer, or resumes the current one if the handshake describes the same image
+    void handshakeReceived(int sysid, int compid, const mavlink_data_transmission_handshake_t& handshake);
+    
+    /// Adds a packet to the transfer for the sender
+    void dataReceived(int sysid, int compid, const mavlink_encapsulated_data_t& data);
+    
+    /// @return Number of transfers in progress
+    int activeTransferCount(void) { return _transfers.count(); }
+    
+    /// @return Number of packets received so far for the sender's transfer, -1 if no transfer is active
+    int packetsReceived(int sysid, int compid);
+    
+    /// Cancels the transfer for the sender
+    void cancelTransfer(int sysid, int compid);
+    
+    /// Decodes a completed image buffer
+    ///     @param type MAVLINK_DATA_STREAM_IMG_* type from the handshake
+    ///     @param width Image width, only needed for raw images
+    ///     @param height Image height, only needed for raw images
+    static QImage decodeImage(const QByteArray& bytes, int type, int width, int height);
+    
+    /// Time in msecs without a new packet after which missing packets are re-requested. Public for unit tests.
+    static const int gapTimeoutMsecs = 300;
+    
+    /// Number of re-requests without progress before a transfer is given up
+    static const int maxRerequests = 10;
+    
+signals:
+    /// Asks the sender to resend a run of missing packets
+    ///     @param request Handshake to send to sysid/compid
+    void requestPackets(int sysid, int compid, const mavlink_data_transmission_handshake_t& request);
+    
+    /// Signalled when all packets have arrived and the image has been decoded. The image is null if decoding failed.
+    void imageDecoded(int sysid, int compid, const QImage& image);
+    
+    /// Signalled when a transfer is given up because the missing packets never arrived
+    void transferFailed(int sysid, int compid);
+    
+private slots:
+    void _checkGaps(void);
+    void _decodeFinished(void);
+    
+private:
+    typedef struct {
+        mavlink_data_transmission_handshake_t   handshake;
+        QByteArray                              buffer;
+        QBitArray                               received;           ///< true: packet with this sequence number has arrived
+        int                                     receivedCount;
+        int                                     rerequestCount;     ///< Re-requests since the last new packet
+        QElapsedTimer                           lastActivity;       ///< Time since the last new packet or re-request
+    } Transfer_t;
+    
+    static quint16 _transferKey(int sysid, int compid) { return (quint16)((sysid << 8) | compid); }
+    static bool _sameImage(const mavlink_data_transmission_handshake_t& a, const mavlink_data_transmission_handshake_t& b);
+    void _completeTransfer(quint16 key);
+    
+    QMap<quint16, Transfer_t*>  _transfers;
+    QTimer                      _gapTimer;
+    
+    static const int _gapTimerIntervalMsecs = 100;
+    static const int _maxImageBytes = 16 * 1024 * 1024;
+    static const int _maxRunsPerRerequest = 8;          ///< Limits the re-request burst for a heavily damaged transfer
+};
+
+#endif
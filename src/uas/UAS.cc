@@ -36,13 +36,19 @@
 #include "FirmwarePluginManager.h"
 #include "QGCMessageBox.h"
 #include "QGCLoggingCategory.h"
+#include "QGCTrace.h"
 #include "Vehicle.h"
+#include "VehicleCommandManager.h"
+#include "VehicleTimeSync.h"
 #include "Joystick.h"
 
 QGC_LOGGING_CATEGORY(UASLog, "UASLog")
 
 #define UAS_DEFAULT_BATTERY_WARNLEVEL 20
 
+UAS::MessageHandlerInfo_t   UAS::_rgMessageHandlers[256];
+bool                        UAS::_messageHandlersInitialized = false;
+
 /**
 * Gets the settings from the previous UAS (name, airframe, autopilot, battery specs)
 * by calling readSettings. This means the new UAS will have the same settings
@@ -127,8 +133,6 @@ UAS::UAS(MAVLinkProtocol* protocol, Vehicle* vehicle) : UASInterface(),
     pitch(0.0),
     yaw(0.0),
 
-    imagePackets(0),    // We must initialize to 0, otherwise extended data packets maybe incorrectly thought to be images
-
     blockHomePositionChanges(false),
     receivedMode(false),
 
@@ -180,12 +184,19 @@ UAS::UAS(MAVLinkProtocol* protocol, Vehicle* vehicle) : UASInterface(),
     _vehicle(vehicle)
 {
     
-    for (unsigned int i = 0; i<255;++i)
+    for (unsigned int i = 0; i<256;++i)
     {
         componentID[i] = -1;
         componentMulti[i] = false;
+        _componentSeen[i] = false;
     }
 
+    _initMessageHandlers();
+    _initValueSeries();
+
+    connect(&imageReassembler, &ImageReassembler::imageDecoded, this, &UAS::_imageDecoded);
+    connect(&imageReassembler, &ImageReassembler::requestPackets, this, &UAS::_requestImagePackets);
+
     connect(mavlink, SIGNAL(messageReceived(LinkInterface*,mavlink_message_t)), &fileManager, SLOT(receiveMessage(LinkInterface*,mavlink_message_t)));
 
     color = UASInterface::getNextColor();
@@ -288,7 +299,9 @@ void UAS::updateState()
 
 void UAS::receiveMessage(mavlink_message_t message)
 {
-    if (!components.contains(message.compid))
+    QGC_TRACE_SCOPE("uas", "UAS::receiveMessage");
+    
+    if (!_componentSeen[message.compid])
     {
         QString componentName;
 
@@ -317,770 +330,833 @@ void UAS::receiveMessage(mavlink_message_t message)
         }
 
         components.insert(message.compid, componentName);
+        _componentSeen[message.compid] = true;
     }
 
-    //    qDebug() << "UAS RECEIVED from" << message.sysid << "component" << message.compid << "msg id" << message.msgid << "seq no" << message.seq;
-
     // Only accept messages from this system (condition 1)
     // and only then if a) attitudeStamped is disabled OR b) attitudeStamped is enabled
     // and we already got one attitude packet
-    if (message.sysid == uasId && (!attitudeStamped || (attitudeStamped && (lastAttitude != 0)) || message.msgid == MAVLINK_MSG_ID_ATTITUDE))
+    if (message.sysid != uasId || (attitudeStamped && lastAttitude == 0 && message.msgid != MAVLINK_MSG_ID_ATTITUDE))
     {
-        QString uasState;
-        QString stateDescription;
+        return;
+    }
 
-        bool multiComponentSourceDetected = false;
-        bool wrongComponent = false;
+    const MessageHandlerInfo_t& handlerInfo = _rgMessageHandlers[message.msgid];
 
-        switch (message.compid)
+    // Messages without a handler skip all further work
+    if (!handlerInfo.handler)
+    {
+        if (!handlerInfo.ignored && !unknownPackets.contains(message.msgid))
         {
-        case MAV_COMP_ID_IMU_2:
-            // Prefer IMU 2 over IMU 1 (FIXME)
-            componentID[message.msgid] = MAV_COMP_ID_IMU_2;
-            break;
-        default:
-            // Do nothing
-            break;
+            unknownPackets.append(message.msgid);
+            qDebug() << "Unknown message from system:" << uasId << "message:" << message.msgid;
         }
+        return;
+    }
+
+    bool multiComponentSourceDetected = false;
+    bool wrongComponent = false;
+
+    switch (message.compid)
+    {
+    case MAV_COMP_ID_IMU_2:
+        // Prefer IMU 2 over IMU 1 (FIXME)
+        componentID[message.msgid] = MAV_COMP_ID_IMU_2;
+        break;
+    default:
+        // Do nothing
+        break;
+    }
 
-        // Store component ID
-        if (componentID[message.msgid] == -1)
+    // Store component ID
+    if (componentID[message.msgid] == -1)
+    {
+        // Prefer the first component
+        componentID[message.msgid] = message.compid;
+    }
+    else
+    {
+        // Got this message already
+        if (componentID[message.msgid] != message.compid)
         {
-            // Prefer the first component
-            componentID[message.msgid] = message.compid;
+            componentMulti[message.msgid] = true;
+            wrongComponent = true;
         }
-        else
-        {
-            // Got this message already
-            if (componentID[message.msgid] != message.compid)
-            {
-                componentMulti[message.msgid] = true;
-                wrongComponent = true;
-            }
+    }
+
+    if (componentMulti[message.msgid] == true) multiComponentSourceDetected = true;
+
+    if (handlerInfo.filterComponents && multiComponentSourceDetected && wrongComponent)
+    {
+        return;
+    }
+
+    (this->*handlerInfo.handler)(message, wrongComponent);
+}
+
+/// Builds the message handler table which is shared by all UAS instances
+void UAS::_initMessageHandlers(void)
+{
+    if (_messageHandlersInitialized) {
+        return;
+    }
+
+    static const struct {
+        int             msgid;
+        MessageHandler  handler;
+        bool            filterComponents;
+    } rgHandlers[] = {
+        { MAVLINK_MSG_ID_HEARTBEAT, &UAS::_handleHeartbeat, true },
+        { MAVLINK_MSG_ID_BATTERY_STATUS, &UAS::_handleBatteryStatus, true },
+        { MAVLINK_MSG_ID_SYS_STATUS, &UAS::_handleSysStatus, true },
+        { MAVLINK_MSG_ID_ATTITUDE, &UAS::_handleAttitude, false },
+        { MAVLINK_MSG_ID_ATTITUDE_QUATERNION, &UAS::_handleAttitudeQuaternion, false },
+        { MAVLINK_MSG_ID_HIL_CONTROLS, &UAS::_handleHilControls, false },
+        { MAVLINK_MSG_ID_VFR_HUD, &UAS::_handleVfrHud, false },
+        { MAVLINK_MSG_ID_LOCAL_POSITION_NED, &UAS::_handleLocalPositionNed, false },
+        { MAVLINK_MSG_ID_GLOBAL_VISION_POSITION_ESTIMATE, &UAS::_handleGlobalVisionPositionEstimate, false },
+        { MAVLINK_MSG_ID_GLOBAL_POSITION_INT, &UAS::_handleGlobalPositionInt, false },
+        { MAVLINK_MSG_ID_GPS_RAW_INT, &UAS::_handleGpsRawInt, false },
+        { MAVLINK_MSG_ID_GPS_STATUS, &UAS::_handleGpsStatus, false },
+        { MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN, &UAS::_handleGpsGlobalOrigin, false },
+        { MAVLINK_MSG_ID_RC_CHANNELS, &UAS::_handleRcChannels, false },
+        { MAVLINK_MSG_ID_RC_CHANNELS_SCALED, &UAS::_handleRcChannelsScaled, false },
+        { MAVLINK_MSG_ID_PARAM_VALUE, &UAS::_handleParamValue, false },
+        { MAVLINK_MSG_ID_COMMAND_ACK, &UAS::_handleCommandAck, false },
+        { MAVLINK_MSG_ID_ATTITUDE_TARGET, &UAS::_handleAttitudeTarget, false },
+        { MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED, &UAS::_handlePositionTargetLocalNed, true },
+        { MAVLINK_MSG_ID_SET_POSITION_TARGET_LOCAL_NED, &UAS::_handleSetPositionTargetLocalNed, false },
+        { MAVLINK_MSG_ID_STATUSTEXT, &UAS::_handleStatustext, false },
+        { MAVLINK_MSG_ID_DATA_TRANSMISSION_HANDSHAKE, &UAS::_handleDataTransmissionHandshake, false },
+        { MAVLINK_MSG_ID_ENCAPSULATED_DATA, &UAS::_handleEncapsulatedData, false },
+        { MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT, &UAS::_handleNavControllerOutput, false },
+    };
+
+    // Messages which are known but not processed by UAS
+    static const int rgIgnored[] = {
+        MAVLINK_MSG_ID_RAW_IMU,
+        MAVLINK_MSG_ID_SCALED_IMU,
+        MAVLINK_MSG_ID_RAW_PRESSURE,
+        MAVLINK_MSG_ID_SCALED_PRESSURE,
+        MAVLINK_MSG_ID_OPTICAL_FLOW,
+        MAVLINK_MSG_ID_DEBUG_VECT,
+        MAVLINK_MSG_ID_DEBUG,
+        MAVLINK_MSG_ID_NAMED_VALUE_FLOAT,
+        MAVLINK_MSG_ID_NAMED_VALUE_INT,
+        MAVLINK_MSG_ID_MANUAL_CONTROL,
+        MAVLINK_MSG_ID_HIGHRES_IMU,
+        MAVLINK_MSG_ID_DISTANCE_SENSOR,
+    };
+
+    for (int i=0; i<256; i++) {
+        _rgMessageHandlers[i].handler = NULL;
+        _rgMessageHandlers[i].ignored = false;
+        _rgMessageHandlers[i].filterComponents = false;
+    }
+    for (size_t i=0; i<sizeof(rgHandlers)/sizeof(rgHandlers[0]); i++) {
+        _rgMessageHandlers[rgHandlers[i].msgid].handler = rgHandlers[i].handler;
+        _rgMessageHandlers[rgHandlers[i].msgid].filterComponents = rgHandlers[i].filterComponents;
+    }
+    for (size_t i=0; i<sizeof(rgIgnored)/sizeof(rgIgnored[0]); i++) {
+        _rgMessageHandlers[rgIgnored[i]].ignored = true;
+    }
+
+    _messageHandlersInitialized = true;
+}
+
+/// Builds the names of the plot series emitted by this UAS. This is done once up front instead of building
+/// new strings for every message.
+void UAS::_initValueSeries(void)
+{
+    static const struct {
+        ValueSeries_t   series;
+        const char*     message;    ///< NULL for series which are not prefixed with the system id and message name
+        const char*     field;
+        const char*     unit;
+    } rgValueSeries[] = {
+        { ValueSeriesHeartbeatBaseMode, "HEARTBEAT", "base_mode", "bits" },
+        { ValueSeriesHeartbeatCustomMode, "HEARTBEAT", "custom_mode", "bits" },
+        { ValueSeriesHeartbeatSystemStatus, "HEARTBEAT", "system_status", "-" },
+        { ValueSeriesSysStatusSensorsEnabled, "SYS_STATUS", "sensors_enabled", "bits" },
+        { ValueSeriesSysStatusSensorsHealth, "SYS_STATUS", "sensors_health", "bits" },
+        { ValueSeriesSysStatusErrorsComm, "SYS_STATUS", "errors_comm", "-" },
+        { ValueSeriesSysStatusErrorsCount1, "SYS_STATUS", "errors_count1", "-" },
+        { ValueSeriesSysStatusErrorsCount2, "SYS_STATUS", "errors_count2", "-" },
+        { ValueSeriesSysStatusErrorsCount3, "SYS_STATUS", "errors_count3", "-" },
+        { ValueSeriesSysStatusErrorsCount4, "SYS_STATUS", "errors_count4", "-" },
+        { ValueSeriesSysStatusLoad, "SYS_STATUS", "load", "%" },
+        { ValueSeriesSysStatusBatteryRemaining, "SYS_STATUS", "battery_remaining", "%" },
+        { ValueSeriesSysStatusBatteryVoltage, "SYS_STATUS", "battery_voltage", "V" },
+        { ValueSeriesSysStatusBatteryCurrent, "SYS_STATUS", "battery_current", "A" },
+        { ValueSeriesSysStatusDropRateComm, "SYS_STATUS", "drop_rate_comm", "%" },
+        { ValueSeriesRollSetpoint, NULL, "roll sp", "rad" },
+        { ValueSeriesPitchSetpoint, NULL, "pitch sp", "rad" },
+        { ValueSeriesYawSetpoint, NULL, "yaw sp", "rad" },
+    };
+    Q_ASSERT(sizeof(rgValueSeries)/sizeof(rgValueSeries[0]) == ValueSeriesCount);
+
+    for (size_t i=0; i<sizeof(rgValueSeries)/sizeof(rgValueSeries[0]); i++) {
+        ValueSeries_t series = rgValueSeries[i].series;
+
+        if (rgValueSeries[i].message) {
+            _valueSeriesNames[series] = QString("M%1:%2.%3").arg(uasId).arg(rgValueSeries[i].message).arg(rgValueSeries[i].field);
+        } else {
+            _valueSeriesNames[series] = rgValueSeries[i].field;
         }
+        _valueSeriesUnits[series] = rgValueSeries[i].unit;
+    }
+}
 
-        if (componentMulti[message.msgid] == true) multiComponentSourceDetected = true;
+void UAS::_emitValue(ValueSeries_t series, const QVariant& value, quint64 time)
+{
+    emit valueChanged(uasId, _valueSeriesNames[series], _valueSeriesUnits[series], value, time);
+}
 
+void UAS::_handleHeartbeat(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    QString uasState;
+    QString stateDescription;
+
+    lastHeartbeat = QGC::groundTimeUsecs();
+    emit heartbeat(this);
+    mavlink_heartbeat_t state;
+    mavlink_msg_heartbeat_decode(&message, &state);
+
+    // Send the base_mode and system_status values to the plotter. This uses the ground time
+    // so the Ground Time checkbox must be ticked for these values to display
+    quint64 time = getUnixTime();
+    _emitValue(ValueSeriesHeartbeatBaseMode, state.base_mode, time);
+    _emitValue(ValueSeriesHeartbeatCustomMode, state.custom_mode, time);
+    _emitValue(ValueSeriesHeartbeatSystemStatus, state.system_status, time);
+
+    // Set new type if it has changed
+    if (this->type != state.type)
+    {
+        this->autopilot = state.autopilot;
+        setSystemType(state.type);
+    }
 
-        switch (message.msgid)
-        {
-        case MAVLINK_MSG_ID_HEARTBEAT:
-        {
-            if (multiComponentSourceDetected && wrongComponent)
-            {
-                break;
-            }
-            lastHeartbeat = QGC::groundTimeUsecs();
-            emit heartbeat(this);
-            mavlink_heartbeat_t state;
-            mavlink_msg_heartbeat_decode(&message, &state);
-
-            // Send the base_mode and system_status values to the plotter. This uses the ground time
-            // so the Ground Time checkbox must be ticked for these values to display
-            quint64 time = getUnixTime();
-            QString name = QString("M%1:HEARTBEAT.%2").arg(message.sysid);
-            emit valueChanged(uasId, name.arg("base_mode"), "bits", state.base_mode, time);
-            emit valueChanged(uasId, name.arg("custom_mode"), "bits", state.custom_mode, time);
-            emit valueChanged(uasId, name.arg("system_status"), "-", state.system_status, time);
-
-            // Set new type if it has changed
-            if (this->type != state.type)
-            {
-                this->autopilot = state.autopilot;
-                setSystemType(state.type);
-            }
+    QString audiostring = QString("System %1").arg(uasId);
+    QString stateAudio = "";
+    QString modeAudio = "";
+    QString navModeAudio = "";
+    bool statechanged = false;
+    bool modechanged = false;
 
-            QString audiostring = QString("System %1").arg(uasId);
-            QString stateAudio = "";
-            QString modeAudio = "";
-            QString navModeAudio = "";
-            bool statechanged = false;
-            bool modechanged = false;
-
-            QString audiomodeText = FirmwarePluginManager::instance()->firmwarePluginForAutopilot((MAV_AUTOPILOT)state.autopilot, (MAV_TYPE)state.type)->flightMode(state.base_mode, state.custom_mode);
-
-            if ((state.system_status != this->status) && state.system_status != MAV_STATE_UNINIT)
-            {
-                statechanged = true;
-                this->status = state.system_status;
-                getStatusForCode((int)state.system_status, uasState, stateDescription);
-                emit statusChanged(this, uasState, stateDescription);
-                emit statusChanged(this->status);
-
-                // Adjust for better audio
-                if (uasState == QString("STANDBY")) uasState = QString("standing by");
-                if (uasState == QString("EMERGENCY")) uasState = QString("emergency condition");
-                if (uasState == QString("CRITICAL")) uasState = QString("critical condition");
-                if (uasState == QString("SHUTDOWN")) uasState = QString("shutting down");
-
-                stateAudio = uasState;
-            }
+    QString audiomodeText = FirmwarePluginManager::instance()->firmwarePluginForAutopilot((MAV_AUTOPILOT)state.autopilot, (MAV_TYPE)state.type)->flightMode(state.base_mode, state.custom_mode);
 
-            if (this->base_mode != state.base_mode || this->custom_mode != state.custom_mode)
-            {
-                modechanged = true;
-                this->base_mode = state.base_mode;
-                this->custom_mode = state.custom_mode;
-                modeAudio = " is now in " + audiomodeText + "flight mode";
-            }
+    if ((state.system_status != this->status) && state.system_status != MAV_STATE_UNINIT)
+    {
+        statechanged = true;
+        this->status = state.system_status;
+        getStatusForCode((int)state.system_status, uasState, stateDescription);
+        emit statusChanged(this, uasState, stateDescription);
+        emit statusChanged(this->status);
 
-            // We got the mode
-            receivedMode = true;
+        // Adjust for better audio
+        if (uasState == QString("STANDBY")) uasState = QString("standing by");
+        if (uasState == QString("EMERGENCY")) uasState = QString("emergency condition");
+        if (uasState == QString("CRITICAL")) uasState = QString("critical condition");
+        if (uasState == QString("SHUTDOWN")) uasState = QString("shutting down");
 
-            // AUDIO
-            if (modechanged && statechanged)
-            {
-                // Output both messages
-                audiostring += modeAudio + " and " + stateAudio;
-            }
-            else if (modechanged || statechanged)
-            {
-                // Output the one message
-                audiostring += modeAudio + stateAudio;
-            }
+        stateAudio = uasState;
+    }
 
-            if (statechanged && ((int)state.system_status == (int)MAV_STATE_CRITICAL || state.system_status == (int)MAV_STATE_EMERGENCY))
-            {
-                _say(QString("Emergency for system %1").arg(this->getUASID()), GAudioOutput::AUDIO_SEVERITY_EMERGENCY);
-                QTimer::singleShot(3000, GAudioOutput::instance(), SLOT(startEmergency()));
-            }
-            else if (modechanged || statechanged)
-            {
-                _say(audiostring.toLower());
-            }
-        }
+    if (this->base_mode != state.base_mode || this->custom_mode != state.custom_mode)
+    {
+        modechanged = true;
+        this->base_mode = state.base_mode;
+        this->custom_mode = state.custom_mode;
+        modeAudio = " is now in " + audiomodeText + "flight mode";
+    }
 
-            break;
+    // We got the mode
+    receivedMode = true;
+
+    // AUDIO
+    if (modechanged && statechanged)
+    {
+        // Output both messages
+        audiostring += modeAudio + " and " + stateAudio;
+    }
+    else if (modechanged || statechanged)
+    {
+        // Output the one message
+        audiostring += modeAudio + stateAudio;
+    }
+
+    if (statechanged && ((int)state.system_status == (int)MAV_STATE_CRITICAL || state.system_status == (int)MAV_STATE_EMERGENCY))
+    {
+        _say(QString("Emergency for system %1").arg(this->getUASID()), GAudioOutput::AUDIO_SEVERITY_EMERGENCY);
+        QTimer::singleShot(3000, GAudioOutput::instance(), SLOT(startEmergency()));
+    }
+    else if (modechanged || statechanged)
+    {
+        _say(audiostring.toLower());
+    }
+}
+
+void UAS::_handleBatteryStatus(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_battery_status_t bat_status;
+    mavlink_msg_battery_status_decode(&message, &bat_status);
+    emit batteryConsumedChanged(this, (double)bat_status.current_consumed);
+}
 
-        case MAVLINK_MSG_ID_BATTERY_STATUS:
+void UAS::_handleSysStatus(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_sys_status_t state;
+    mavlink_msg_sys_status_decode(&message, &state);
+
+    // Prepare for sending data to the realtime plotter, which is every field excluding onboard_control_sensors_present.
+    quint64 time = getUnixTime();
+    _emitValue(ValueSeriesSysStatusSensorsEnabled, state.onboard_control_sensors_enabled, time);
+    _emitValue(ValueSeriesSysStatusSensorsHealth, state.onboard_control_sensors_health, time);
+    _emitValue(ValueSeriesSysStatusErrorsComm, state.errors_comm, time);
+    _emitValue(ValueSeriesSysStatusErrorsCount1, state.errors_count1, time);
+    _emitValue(ValueSeriesSysStatusErrorsCount2, state.errors_count2, time);
+    _emitValue(ValueSeriesSysStatusErrorsCount3, state.errors_count3, time);
+    _emitValue(ValueSeriesSysStatusErrorsCount4, state.errors_count4, time);
+
+    // Process CPU load.
+    emit loadChanged(this,state.load/10.0f);
+    _emitValue(ValueSeriesSysStatusLoad, state.load/10.0f, time);
+
+    if (state.voltage_battery > 0.0f && state.voltage_battery != UINT16_MAX) {
+        // Battery charge/time remaining/voltage calculations
+        currentVoltage = state.voltage_battery/1000.0f;
+        filterVoltage(currentVoltage);
+        tickLowpassVoltage = tickLowpassVoltage * 0.8f + 0.2f * currentVoltage;
+
+        // We don't want to tick above the threshold
+        if (tickLowpassVoltage > tickVoltage)
         {
-            if (multiComponentSourceDetected && wrongComponent)
-            {
-                break;
-            }
-            mavlink_battery_status_t bat_status;
-            mavlink_msg_battery_status_decode(&message, &bat_status);
-            emit batteryConsumedChanged(this, (double)bat_status.current_consumed);
+            lastTickVoltageValue = tickLowpassVoltage;
         }
-            break;
 
-        case MAVLINK_MSG_ID_SYS_STATUS:
+        if ((startVoltage > 0.0f) && (tickLowpassVoltage < tickVoltage) && (fabs(lastTickVoltageValue - tickLowpassVoltage) > 0.1f)
+                /* warn if lower than treshold */
+                && (lpVoltage < tickVoltage)
+                /* warn only if we have at least the voltage of an empty LiPo cell, else we're sampling something wrong */
+                && (currentVoltage > 3.3f)
+                /* warn only if current voltage is really still lower by a reasonable amount */
+                && ((currentVoltage - 0.2f) < tickVoltage)
+                /* warn only every 20 seconds */
+                && (QGC::groundTimeUsecs() - lastVoltageWarning) > 20000000)
         {
-            if (multiComponentSourceDetected && wrongComponent)
-            {
-                break;
-            }
-            mavlink_sys_status_t state;
-            mavlink_msg_sys_status_decode(&message, &state);
-
-            // Prepare for sending data to the realtime plotter, which is every field excluding onboard_control_sensors_present.
-            quint64 time = getUnixTime();
-            QString name = QString("M%1:SYS_STATUS.%2").arg(message.sysid);
-            emit valueChanged(uasId, name.arg("sensors_enabled"), "bits", state.onboard_control_sensors_enabled, time);
-            emit valueChanged(uasId, name.arg("sensors_health"), "bits", state.onboard_control_sensors_health, time);
-            emit valueChanged(uasId, name.arg("errors_comm"), "-", state.errors_comm, time);
-            emit valueChanged(uasId, name.arg("errors_count1"), "-", state.errors_count1, time);
-            emit valueChanged(uasId, name.arg("errors_count2"), "-", state.errors_count2, time);
-            emit valueChanged(uasId, name.arg("errors_count3"), "-", state.errors_count3, time);
-            emit valueChanged(uasId, name.arg("errors_count4"), "-", state.errors_count4, time);
-
-            // Process CPU load.
-            emit loadChanged(this,state.load/10.0f);
-            emit valueChanged(uasId, name.arg("load"), "%", state.load/10.0f, time);
-
-            if (state.voltage_battery > 0.0f && state.voltage_battery != UINT16_MAX) {
-                // Battery charge/time remaining/voltage calculations
-                currentVoltage = state.voltage_battery/1000.0f;
-                filterVoltage(currentVoltage);
-                tickLowpassVoltage = tickLowpassVoltage * 0.8f + 0.2f * currentVoltage;
-
-                // We don't want to tick above the threshold
-                if (tickLowpassVoltage > tickVoltage)
-                {
-                    lastTickVoltageValue = tickLowpassVoltage;
-                }
-
-                if ((startVoltage > 0.0f) && (tickLowpassVoltage < tickVoltage) && (fabs(lastTickVoltageValue - tickLowpassVoltage) > 0.1f)
-                        /* warn if lower than treshold */
-                        && (lpVoltage < tickVoltage)
-                        /* warn only if we have at least the voltage of an empty LiPo cell, else we're sampling something wrong */
-                        && (currentVoltage > 3.3f)
-                        /* warn only if current voltage is really still lower by a reasonable amount */
-                        && ((currentVoltage - 0.2f) < tickVoltage)
-                        /* warn only every 20 seconds */
-                        && (QGC::groundTimeUsecs() - lastVoltageWarning) > 20000000)
-                {
-                    _say(QString("Low battery system %1: %2 volts").arg(getUASID()).arg(lpVoltage, 0, 'f', 1, QChar(' ')));
-                    lastVoltageWarning = QGC::groundTimeUsecs();
-                    lastTickVoltageValue = tickLowpassVoltage;
-                }
-
-                if (startVoltage == -1.0f && currentVoltage > 0.1f) startVoltage = currentVoltage;
-                chargeLevel = state.battery_remaining;
-
-                emit batteryChanged(this, lpVoltage, currentCurrent, getChargeLevel(), 0);
-            }
+            _say(QString("Low battery system %1: %2 volts").arg(getUASID()).arg(lpVoltage, 0, 'f', 1, QChar(' ')));
+            lastVoltageWarning = QGC::groundTimeUsecs();
+            lastTickVoltageValue = tickLowpassVoltage;
+        }
 
-            emit valueChanged(uasId, name.arg("battery_remaining"), "%", getChargeLevel(), time);
-            emit valueChanged(uasId, name.arg("battery_voltage"), "V", currentVoltage, time);
+        if (startVoltage == -1.0f && currentVoltage > 0.1f) startVoltage = currentVoltage;
+        chargeLevel = state.battery_remaining;
 
-            // And if the battery current draw is measured, log that also.
-            if (state.current_battery != -1)
-            {
-                currentCurrent = ((double)state.current_battery)/100.0f;
-                emit valueChanged(uasId, name.arg("battery_current"), "A", currentCurrent, time);
-            }
+        emit batteryChanged(this, lpVoltage, currentCurrent, getChargeLevel(), 0);
+    }
 
-            // LOW BATTERY ALARM
-            if (chargeLevel >= 0 && (getChargeLevel() < warnLevelPercent))
-            {
-                // An audio alarm. Does not generate any signals.
-                startLowBattAlarm();
-            }
-            else
-            {
-                stopLowBattAlarm();
-            }
+    _emitValue(ValueSeriesSysStatusBatteryRemaining, getChargeLevel(), time);
+    _emitValue(ValueSeriesSysStatusBatteryVoltage, currentVoltage, time);
 
-            // control_sensors_enabled:
-            // relevant bits: 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control
-            emit attitudeControlEnabled(state.onboard_control_sensors_enabled & (1 << 11));
-            emit positionYawControlEnabled(state.onboard_control_sensors_enabled & (1 << 12));
-            emit positionZControlEnabled(state.onboard_control_sensors_enabled & (1 << 13));
-            emit positionXYControlEnabled(state.onboard_control_sensors_enabled & (1 << 14));
-
-            // Trigger drop rate updates as needed. Here we convert the incoming
-            // drop_rate_comm value from 1/100 of a percent in a uint16 to a true
-            // percentage as a float. We also cap the incoming value at 100% as defined
-            // by the MAVLink specifications.
-            if (state.drop_rate_comm > 10000)
-            {
-                state.drop_rate_comm = 10000;
-            }
-            emit dropRateChanged(this->getUASID(), state.drop_rate_comm/100.0f);
-            emit valueChanged(uasId, name.arg("drop_rate_comm"), "%", state.drop_rate_comm/100.0f, time);
-        }
-            break;
-        case MAVLINK_MSG_ID_ATTITUDE:
-        {
-            mavlink_attitude_t attitude;
-            mavlink_msg_attitude_decode(&message, &attitude);
-            quint64 time = getUnixReferenceTime(attitude.time_boot_ms);
-
-            emit attitudeChanged(this, message.compid, QGC::limitAngleToPMPIf(attitude.roll), QGC::limitAngleToPMPIf(attitude.pitch), QGC::limitAngleToPMPIf(attitude.yaw), time);
-
-            if (!wrongComponent)
-            {
-                lastAttitude = time;
-                setRoll(QGC::limitAngleToPMPIf(attitude.roll));
-                setPitch(QGC::limitAngleToPMPIf(attitude.pitch));
-                setYaw(QGC::limitAngleToPMPIf(attitude.yaw));
-
-                attitudeKnown = true;
-                emit attitudeChanged(this, getRoll(), getPitch(), getYaw(), time);
-                emit attitudeRotationRatesChanged(uasId, attitude.rollspeed, attitude.pitchspeed, attitude.yawspeed, time);
-            }
-        }
-            break;
-        case MAVLINK_MSG_ID_ATTITUDE_QUATERNION:
-        {
-            mavlink_attitude_quaternion_t attitude;
-            mavlink_msg_attitude_quaternion_decode(&message, &attitude);
-            quint64 time = getUnixReferenceTime(attitude.time_boot_ms);
-
-            double a = attitude.q1;
-            double b = attitude.q2;
-            double c = attitude.q3;
-            double d = attitude.q4;
-
-            double aSq = a * a;
-            double bSq = b * b;
-            double cSq = c * c;
-            double dSq = d * d;
-            float dcm[3][3];
-            dcm[0][0] = aSq + bSq - cSq - dSq;
-            dcm[0][1] = 2.0 * (b * c - a * d);
-            dcm[0][2] = 2.0 * (a * c + b * d);
-            dcm[1][0] = 2.0 * (b * c + a * d);
-            dcm[1][1] = aSq - bSq + cSq - dSq;
-            dcm[1][2] = 2.0 * (c * d - a * b);
-            dcm[2][0] = 2.0 * (b * d - a * c);
-            dcm[2][1] = 2.0 * (a * b + c * d);
-            dcm[2][2] = aSq - bSq - cSq + dSq;
-
-            float phi, theta, psi;
-            theta = asin(-dcm[2][0]);
-
-            if (fabs(theta - M_PI_2) < 1.0e-3f) {
-                phi = 0.0f;
-                psi = (atan2(dcm[1][2] - dcm[0][1],
-                        dcm[0][2] + dcm[1][1]) + phi);
-
-            } else if (fabs(theta + M_PI_2) < 1.0e-3f) {
-                phi = 0.0f;
-                psi = atan2f(dcm[1][2] - dcm[0][1],
-                          dcm[0][2] + dcm[1][1] - phi);
+    // And if the battery current draw is measured, log that also.
+    if (state.current_battery != -1)
+    {
+        currentCurrent = ((double)state.current_battery)/100.0f;
+        _emitValue(ValueSeriesSysStatusBatteryCurrent, currentCurrent, time);
+    }
 
-            } else {
-                phi = atan2f(dcm[2][1], dcm[2][2]);
-                psi = atan2f(dcm[1][0], dcm[0][0]);
-            }
+    // LOW BATTERY ALARM
+    if (chargeLevel >= 0 && (getChargeLevel() < warnLevelPercent))
+    {
+        // An audio alarm. Does not generate any signals.
+        startLowBattAlarm();
+    }
+    else
+    {
+        stopLowBattAlarm();
+    }
 
-            emit attitudeChanged(this, message.compid, QGC::limitAngleToPMPIf(phi),
-                                 QGC::limitAngleToPMPIf(theta),
-                                 QGC::limitAngleToPMPIf(psi), time);
+    // control_sensors_enabled:
+    // relevant bits: 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control
+    emit attitudeControlEnabled(state.onboard_control_sensors_enabled & (1 << 11));
+    emit positionYawControlEnabled(state.onboard_control_sensors_enabled & (1 << 12));
+    emit positionZControlEnabled(state.onboard_control_sensors_enabled & (1 << 13));
+    emit positionXYControlEnabled(state.onboard_control_sensors_enabled & (1 << 14));
 
-            if (!wrongComponent)
-            {
-                lastAttitude = time;
-                setRoll(QGC::limitAngleToPMPIf(phi));
-                setPitch(QGC::limitAngleToPMPIf(theta));
-                setYaw(QGC::limitAngleToPMPIf(psi));
+    // Trigger drop rate updates as needed. Here we convert the incoming
+    // drop_rate_comm value from 1/100 of a percent in a uint16 to a true
+    // percentage as a float. We also cap the incoming value at 100% as defined
+    // by the MAVLink specifications.
+    if (state.drop_rate_comm > 10000)
+    {
+        state.drop_rate_comm = 10000;
+    }
+    emit dropRateChanged(this->getUASID(), state.drop_rate_comm/100.0f);
+    _emitValue(ValueSeriesSysStatusDropRateComm, state.drop_rate_comm/100.0f, time);
+}
 
-                attitudeKnown = true;
-                emit attitudeChanged(this, getRoll(), getPitch(), getYaw(), time);
-                emit attitudeRotationRatesChanged(uasId, attitude.rollspeed, attitude.pitchspeed, attitude.yawspeed, time);
-            }
-        }
-            break;
-        case MAVLINK_MSG_ID_HIL_CONTROLS:
-        {
-            mavlink_hil_controls_t hil;
-            mavlink_msg_hil_controls_decode(&message, &hil);
-            emit hilControlsChanged(hil.time_usec, hil.roll_ailerons, hil.pitch_elevator, hil.yaw_rudder, hil.throttle, hil.mode, hil.nav_mode);
-        }
-            break;
-        case MAVLINK_MSG_ID_VFR_HUD:
-        {
-            mavlink_vfr_hud_t hud;
-            mavlink_msg_vfr_hud_decode(&message, &hud);
-            quint64 time = getUnixTime();
-            // Display updated values
-            emit thrustChanged(this, hud.throttle/100.0);
-
-            if (!attitudeKnown)
-            {
-                setYaw(QGC::limitAngleToPMPId((((double)hud.heading)/180.0)*M_PI));
-                emit attitudeChanged(this, getRoll(), getPitch(), getYaw(), time);
-            }
+void UAS::_handleAttitude(mavlink_message_t& message, bool wrongComponent)
+{
+    mavlink_attitude_t attitude;
+    mavlink_msg_attitude_decode(&message, &attitude);
+    quint64 time = getUnixReferenceTime(attitude.time_boot_ms);
 
-            setAltitudeAMSL(hud.alt);
-            setGroundSpeed(hud.groundspeed);
-            if (!isnan(hud.airspeed))
-                setAirSpeed(hud.airspeed);
-            speedZ = -hud.climb;
-            emit altitudeChanged(this, altitudeAMSL, altitudeWGS84, altitudeRelative, -speedZ, time);
-            emit speedChanged(this, groundSpeed, airSpeed, time);
-        }
-            break;
-        case MAVLINK_MSG_ID_LOCAL_POSITION_NED:
-            //std::cerr << std::endl;
-            //std::cerr << "Decoded attitude message:" << " roll: " << std::dec << mavlink_msg_attitude_get_roll(message.payload) << " pitch: " << mavlink_msg_attitude_get_pitch(message.payload) << " yaw: " << mavlink_msg_attitude_get_yaw(message.payload) << std::endl;
-        {
-            mavlink_local_position_ned_t pos;
-            mavlink_msg_local_position_ned_decode(&message, &pos);
-            quint64 time = getUnixTime(pos.time_boot_ms);
+    emit attitudeChanged(this, message.compid, QGC::limitAngleToPMPIf(attitude.roll), QGC::limitAngleToPMPIf(attitude.pitch), QGC::limitAngleToPMPIf(attitude.yaw), time);
 
-            // Emit position always with component ID
-            emit localPositionChanged(this, message.compid, pos.x, pos.y, pos.z, time);
+    if (!wrongComponent)
+    {
+        lastAttitude = time;
+        setRoll(QGC::limitAngleToPMPIf(attitude.roll));
+        setPitch(QGC::limitAngleToPMPIf(attitude.pitch));
+        setYaw(QGC::limitAngleToPMPIf(attitude.yaw));
 
-            if (!wrongComponent)
-            {
-                setLocalX(pos.x);
-                setLocalY(pos.y);
-                setLocalZ(pos.z);
+        attitudeKnown = true;
+        emit attitudeChanged(this, getRoll(), getPitch(), getYaw(), time);
+        emit attitudeRotationRatesChanged(uasId, attitude.rollspeed, attitude.pitchspeed, attitude.yawspeed, time);
+    }
+}
 
-                speedX = pos.vx;
-                speedY = pos.vy;
-                speedZ = pos.vz;
+void UAS::_handleAttitudeQuaternion(mavlink_message_t& message, bool wrongComponent)
+{
+    mavlink_attitude_quaternion_t attitude;
+    mavlink_msg_attitude_quaternion_decode(&message, &attitude);
+    quint64 time = getUnixReferenceTime(attitude.time_boot_ms);
+
+    double a = attitude.q1;
+    double b = attitude.q2;
+    double c = attitude.q3;
+    double d = attitude.q4;
+
+    double aSq = a * a;
+    double bSq = b * b;
+    double cSq = c * c;
+    double dSq = d * d;
+    float dcm[3][3];
+    dcm[0][0] = aSq + bSq - cSq - dSq;
+    dcm[0][1] = 2.0 * (b * c - a * d);
+    dcm[0][2] = 2.0 * (a * c + b * d);
+    dcm[1][0] = 2.0 * (b * c + a * d);
+    dcm[1][1] = aSq - bSq + cSq - dSq;
+    dcm[1][2] = 2.0 * (c * d - a * b);
+    dcm[2][0] = 2.0 * (b * d - a * c);
+    dcm[2][1] = 2.0 * (a * b + c * d);
+    dcm[2][2] = aSq - bSq - cSq + dSq;
+
+    float phi, theta, psi;
+    theta = asin(-dcm[2][0]);
+
+    if (fabs(theta - M_PI_2) < 1.0e-3f) {
+        phi = 0.0f;
+        psi = (atan2(dcm[1][2] - dcm[0][1],
+                dcm[0][2] + dcm[1][1]) + phi);
+
+    } else if (fabs(theta + M_PI_2) < 1.0e-3f) {
+        phi = 0.0f;
+        psi = atan2f(dcm[1][2] - dcm[0][1],
+                  dcm[0][2] + dcm[1][1] - phi);
 
-                // Emit
-                emit localPositionChanged(this, localX, localY, localZ, time);
-                emit velocityChanged_NED(this, speedX, speedY, speedZ, time);
+    } else {
+        phi = atan2f(dcm[2][1], dcm[2][2]);
+        psi = atan2f(dcm[1][0], dcm[0][0]);
+    }
 
-                positionLock = true;
-                isLocalPositionKnown = true;
-            }
-        }
-            break;
-        case MAVLINK_MSG_ID_GLOBAL_VISION_POSITION_ESTIMATE:
-        {
-            mavlink_global_vision_position_estimate_t pos;
-            mavlink_msg_global_vision_position_estimate_decode(&message, &pos);
-            quint64 time = getUnixTime(pos.usec);
-            emit localPositionChanged(this, message.compid, pos.x, pos.y, pos.z, time);
-            emit attitudeChanged(this, message.compid, pos.roll, pos.pitch, pos.yaw, time);
-        }
-            break;
-        case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
-            //std::cerr << std::endl;
-            //std::cerr << "Decoded attitude message:" << " roll: " << std::dec << mavlink_msg_attitude_get_roll(message.payload) << " pitch: " << mavlink_msg_attitude_get_pitch(message.payload) << " yaw: " << mavlink_msg_attitude_get_yaw(message.payload) << std::endl;
-        {
-            mavlink_global_position_int_t pos;
-            mavlink_msg_global_position_int_decode(&message, &pos);
+    emit attitudeChanged(this, message.compid, QGC::limitAngleToPMPIf(phi),
+                         QGC::limitAngleToPMPIf(theta),
+                         QGC::limitAngleToPMPIf(psi), time);
 
-            quint64 time = getUnixTime();
+    if (!wrongComponent)
+    {
+        lastAttitude = time;
+        setRoll(QGC::limitAngleToPMPIf(phi));
+        setPitch(QGC::limitAngleToPMPIf(theta));
+        setYaw(QGC::limitAngleToPMPIf(psi));
 
-            setLatitude(pos.lat/(double)1E7);
-            setLongitude(pos.lon/(double)1E7);
-            setAltitudeWGS84(pos.alt/1000.0);
-            setAltitudeRelative(pos.relative_alt/1000.0);
+        attitudeKnown = true;
+        emit attitudeChanged(this, getRoll(), getPitch(), getYaw(), time);
+        emit attitudeRotationRatesChanged(uasId, attitude.rollspeed, attitude.pitchspeed, attitude.yawspeed, time);
+    }
+}
 
-            globalEstimatorActive = true;
+void UAS::_handleHilControls(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_hil_controls_t hil;
+    mavlink_msg_hil_controls_decode(&message, &hil);
+    emit hilControlsChanged(hil.time_usec, hil.roll_ailerons, hil.pitch_elevator, hil.yaw_rudder, hil.throttle, hil.mode, hil.nav_mode);
+}
 
-            speedX = pos.vx/100.0;
-            speedY = pos.vy/100.0;
-            speedZ = pos.vz/100.0;
+void UAS::_handleVfrHud(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_vfr_hud_t hud;
+    mavlink_msg_vfr_hud_decode(&message, &hud);
+    quint64 time = getUnixTime();
+    // Display updated values
+    emit thrustChanged(this, hud.throttle/100.0);
+
+    if (!attitudeKnown)
+    {
+        setYaw(QGC::limitAngleToPMPId((((double)hud.heading)/180.0)*M_PI));
+        emit attitudeChanged(this, getRoll(), getPitch(), getYaw(), time);
+    }
 
-            emit globalPositionChanged(this, getLatitude(), getLongitude(), getAltitudeAMSL(), getAltitudeWGS84(), time);
-            emit altitudeChanged(this, altitudeAMSL, altitudeWGS84, altitudeRelative, -speedZ, time);
-            // We had some frame mess here, global and local axes were mixed.
-            emit velocityChanged_NED(this, speedX, speedY, speedZ, time);
+    setAltitudeAMSL(hud.alt);
+    setGroundSpeed(hud.groundspeed);
+    if (!isnan(hud.airspeed))
+        setAirSpeed(hud.airspeed);
+    speedZ = -hud.climb;
+    emit altitudeChanged(this, altitudeAMSL, altitudeWGS84, altitudeRelative, -speedZ, time);
+    emit speedChanged(this, groundSpeed, airSpeed, time);
+}
 
-            setGroundSpeed(qSqrt(speedX*speedX+speedY*speedY));
-            emit speedChanged(this, groundSpeed, airSpeed, time);
+void UAS::_handleLocalPositionNed(mavlink_message_t& message, bool wrongComponent)
+{
+    mavlink_local_position_ned_t pos;
+    mavlink_msg_local_position_ned_decode(&message, &pos);
+    quint64 time = getUnixTime(pos.time_boot_ms);
 
-            positionLock = true;
-            isGlobalPositionKnown = true;
-        }
-            break;
-        case MAVLINK_MSG_ID_GPS_RAW_INT:
-        {
-            mavlink_gps_raw_int_t pos;
-            mavlink_msg_gps_raw_int_decode(&message, &pos);
+    // Emit position always with component ID
+    emit localPositionChanged(this, message.compid, pos.x, pos.y, pos.z, time);
 
-            quint64 time = getUnixTime(pos.time_usec);
+    if (!wrongComponent)
+    {
+        setLocalX(pos.x);
+        setLocalY(pos.y);
+        setLocalZ(pos.z);
 
-            // TODO: track localization state not only for gps but also for other loc. sources
-            int loc_type = pos.fix_type;
-            if (loc_type == 1)
-            {
-                loc_type = 0;
-            }
-            emit localizationChanged(this, loc_type);
-            setSatelliteCount(pos.satellites_visible);
-
-            if (pos.fix_type > 2)
-            {
-                positionLock = true;
-                isGlobalPositionKnown = true;
-
-                latitude_gps = pos.lat/(double)1E7;
-                longitude_gps = pos.lon/(double)1E7;
-                altitude_gps = pos.alt/1000.0;
-
-                // If no GLOBAL_POSITION_INT messages ever received, use these raw GPS values instead.
-                if (!globalEstimatorActive) {
-                    setLatitude(latitude_gps);
-                    setLongitude(longitude_gps);
-                    setAltitudeWGS84(altitude_gps);
-                    emit globalPositionChanged(this, getLatitude(), getLongitude(), getAltitudeAMSL(), getAltitudeWGS84(), time);
-                    emit altitudeChanged(this, altitudeAMSL, altitudeWGS84, altitudeRelative, -speedZ, time);
-
-                    float vel = pos.vel/100.0f;
-                    // Smaller than threshold and not NaN
-                    if ((vel < 1000000) && !isnan(vel) && !isinf(vel)) {
-                        setGroundSpeed(vel);
-                        emit speedChanged(this, groundSpeed, airSpeed, time);
-                    } else {
-                        emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_NOTICE, QString("GCS ERROR: RECEIVED INVALID SPEED OF %1 m/s").arg(vel));
-                    }
-                }
-            }
-        }
-            break;
-        case MAVLINK_MSG_ID_GPS_STATUS:
-        {
-            mavlink_gps_status_t pos;
-            mavlink_msg_gps_status_decode(&message, &pos);
-            for(int i = 0; i < (int)pos.satellites_visible; i++)
-            {
-                emit gpsSatelliteStatusChanged(uasId, (unsigned char)pos.satellite_prn[i], (unsigned char)pos.satellite_elevation[i], (unsigned char)pos.satellite_azimuth[i], (unsigned char)pos.satellite_snr[i], static_cast<bool>(pos.satellite_used[i]));
-            }
-            setSatelliteCount(pos.satellites_visible);
-        }
-            break;
-        case MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN:
-        {
-            mavlink_gps_global_origin_t pos;
-            mavlink_msg_gps_global_origin_decode(&message, &pos);
-            emit homePositionChanged(uasId, pos.latitude / 10000000.0, pos.longitude / 10000000.0, pos.altitude / 1000.0);
-        }
-            break;
-        case MAVLINK_MSG_ID_RC_CHANNELS:
-        {
-            mavlink_rc_channels_t channels;
-            mavlink_msg_rc_channels_decode(&message, &channels);
-
-            emit remoteControlRSSIChanged(channels.rssi);
-
-            if (channels.chan1_raw != UINT16_MAX && channels.chancount > 0)
-                emit remoteControlChannelRawChanged(0, channels.chan1_raw);
-            if (channels.chan2_raw != UINT16_MAX && channels.chancount > 1)
-                emit remoteControlChannelRawChanged(1, channels.chan2_raw);
-            if (channels.chan3_raw != UINT16_MAX && channels.chancount > 2)
-                emit remoteControlChannelRawChanged(2, channels.chan3_raw);
-            if (channels.chan4_raw != UINT16_MAX && channels.chancount > 3)
-                emit remoteControlChannelRawChanged(3, channels.chan4_raw);
-            if (channels.chan5_raw != UINT16_MAX && channels.chancount > 4)
-                emit remoteControlChannelRawChanged(4, channels.chan5_raw);
-            if (channels.chan6_raw != UINT16_MAX && channels.chancount > 5)
-                emit remoteControlChannelRawChanged(5, channels.chan6_raw);
-            if (channels.chan7_raw != UINT16_MAX && channels.chancount > 6)
-                emit remoteControlChannelRawChanged(6, channels.chan7_raw);
-            if (channels.chan8_raw != UINT16_MAX && channels.chancount > 7)
-                emit remoteControlChannelRawChanged(7, channels.chan8_raw);
-            if (channels.chan9_raw != UINT16_MAX && channels.chancount > 8)
-                emit remoteControlChannelRawChanged(8, channels.chan9_raw);
-            if (channels.chan10_raw != UINT16_MAX && channels.chancount > 9)
-                emit remoteControlChannelRawChanged(9, channels.chan10_raw);
-            if (channels.chan11_raw != UINT16_MAX && channels.chancount > 10)
-                emit remoteControlChannelRawChanged(10, channels.chan11_raw);
-            if (channels.chan12_raw != UINT16_MAX && channels.chancount > 11)
-                emit remoteControlChannelRawChanged(11, channels.chan12_raw);
-            if (channels.chan13_raw != UINT16_MAX && channels.chancount > 12)
-                emit remoteControlChannelRawChanged(12, channels.chan13_raw);
-            if (channels.chan14_raw != UINT16_MAX && channels.chancount > 13)
-                emit remoteControlChannelRawChanged(13, channels.chan14_raw);
-            if (channels.chan15_raw != UINT16_MAX && channels.chancount > 14)
-                emit remoteControlChannelRawChanged(14, channels.chan15_raw);
-            if (channels.chan16_raw != UINT16_MAX && channels.chancount > 15)
-                emit remoteControlChannelRawChanged(15, channels.chan16_raw);
-            if (channels.chan17_raw != UINT16_MAX && channels.chancount > 16)
-                emit remoteControlChannelRawChanged(16, channels.chan17_raw);
-            if (channels.chan18_raw != UINT16_MAX && channels.chancount > 17)
-                emit remoteControlChannelRawChanged(17, channels.chan18_raw);
+        speedX = pos.vx;
+        speedY = pos.vy;
+        speedZ = pos.vz;
 
-        }
-            break;
+        // Emit
+        emit localPositionChanged(this, localX, localY, localZ, time);
+        emit velocityChanged_NED(this, speedX, speedY, speedZ, time);
 
-        // TODO: (gg 20150420) PX4 Firmware does not seem to send this message. Don't know what to do about it.
-        case MAVLINK_MSG_ID_RC_CHANNELS_SCALED:
-        {
-            mavlink_rc_channels_scaled_t channels;
-            mavlink_msg_rc_channels_scaled_decode(&message, &channels);
-
-            const unsigned int portWidth = 8; // XXX magic number
-
-            emit remoteControlRSSIChanged(channels.rssi);
-            if (static_cast<uint16_t>(channels.chan1_scaled) != UINT16_MAX)
-                emit remoteControlChannelScaledChanged(channels.port * portWidth + 0, channels.chan1_scaled/10000.0f);
-            if (static_cast<uint16_t>(channels.chan2_scaled) != UINT16_MAX)
-                emit remoteControlChannelScaledChanged(channels.port * portWidth + 1, channels.chan2_scaled/10000.0f);
-            if (static_cast<uint16_t>(channels.chan3_scaled) != UINT16_MAX)
-                emit remoteControlChannelScaledChanged(channels.port * portWidth + 2, channels.chan3_scaled/10000.0f);
-            if (static_cast<uint16_t>(channels.chan4_scaled) != UINT16_MAX)
-                emit remoteControlChannelScaledChanged(channels.port * portWidth + 3, channels.chan4_scaled/10000.0f);
-            if (static_cast<uint16_t>(channels.chan5_scaled) != UINT16_MAX)
-                emit remoteControlChannelScaledChanged(channels.port * portWidth + 4, channels.chan5_scaled/10000.0f);
-            if (static_cast<uint16_t>(channels.chan6_scaled) != UINT16_MAX)
-                emit remoteControlChannelScaledChanged(channels.port * portWidth + 5, channels.chan6_scaled/10000.0f);
-            if (static_cast<uint16_t>(channels.chan7_scaled) != UINT16_MAX)
-                emit remoteControlChannelScaledChanged(channels.port * portWidth + 6, channels.chan7_scaled/10000.0f);
-            if (static_cast<uint16_t>(channels.chan8_scaled) != UINT16_MAX)
-                emit remoteControlChannelScaledChanged(channels.port * portWidth + 7, channels.chan8_scaled/10000.0f);
-        }
-            break;
-        case MAVLINK_MSG_ID_PARAM_VALUE:
-        {
-            mavlink_param_value_t rawValue;
-            mavlink_msg_param_value_decode(&message, &rawValue);
-            QByteArray bytes(rawValue.param_id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
-            // Construct a string stopping at the first NUL (0) character, else copy the whole
-            // byte array (max MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN, so safe)
-            QString parameterName(bytes);
-            mavlink_param_union_t paramVal;
-            paramVal.param_float = rawValue.param_value;
-            paramVal.type = rawValue.param_type;
-
-            processParamValueMsg(message, parameterName,rawValue,paramVal);
-         }
-            break;
-        case MAVLINK_MSG_ID_COMMAND_ACK:
-        {
-            mavlink_command_ack_t ack;
-            mavlink_msg_command_ack_decode(&message, &ack);
-            switch (ack.result)
-            {
-            case MAV_RESULT_ACCEPTED:
-            {
-                emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_INFO, tr("SUCCESS: Executed CMD: %1").arg(ack.command));
-            }
-                break;
-            case MAV_RESULT_TEMPORARILY_REJECTED:
-            {
-                emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_WARNING, tr("FAILURE: Temporarily rejected CMD: %1").arg(ack.command));
-            }
-                break;
-            case MAV_RESULT_DENIED:
-            {
-                emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_ERROR, tr("FAILURE: Denied CMD: %1").arg(ack.command));
-            }
-                break;
-            case MAV_RESULT_UNSUPPORTED:
-            {
-                emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_WARNING, tr("FAILURE: Unsupported CMD: %1").arg(ack.command));
-            }
-                break;
-            case MAV_RESULT_FAILED:
-            {
-                emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_ERROR, tr("FAILURE: Failed CMD: %1").arg(ack.command));
-            }
-                break;
-            }
-        }
-        case MAVLINK_MSG_ID_ATTITUDE_TARGET:
-        {
-            mavlink_attitude_target_t out;
-            mavlink_msg_attitude_target_decode(&message, &out);
-            float roll, pitch, yaw;
-            mavlink_quaternion_to_euler(out.q, &roll, &pitch, &yaw);
-            quint64 time = getUnixTimeFromMs(out.time_boot_ms);
-            emit attitudeThrustSetPointChanged(this, roll, pitch, yaw, out.thrust, time);
-
-            // For plotting emit roll sp, pitch sp and yaw sp values
-            emit valueChanged(uasId, "roll sp", "rad", roll, time);
-            emit valueChanged(uasId, "pitch sp", "rad", pitch, time);
-            emit valueChanged(uasId, "yaw sp", "rad", yaw, time);
-        }
-            break;
-                
-        case MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED:
-        {
-            if (multiComponentSourceDetected && wrongComponent)
-            {
-                break;
-            }
-            mavlink_position_target_local_ned_t p;
-            mavlink_msg_position_target_local_ned_decode(&message, &p);
-            quint64 time = getUnixTimeFromMs(p.time_boot_ms);
-            emit positionSetPointsChanged(uasId, p.x, p.y, p.z, 0/* XXX remove yaw and move it to attitude */, time);
-        }
-            break;
-        case MAVLINK_MSG_ID_SET_POSITION_TARGET_LOCAL_NED:
-        {
-            mavlink_set_position_target_local_ned_t p;
-            mavlink_msg_set_position_target_local_ned_decode(&message, &p);
-            emit userPositionSetPointsChanged(uasId, p.x, p.y, p.z, 0/* XXX remove yaw and move it to attitude */);
-        }
-            break;
-        case MAVLINK_MSG_ID_STATUSTEXT:
-        {
-            QByteArray b;
-            b.resize(MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN+1);
-            mavlink_msg_statustext_get_text(&message, b.data());
- 
-            // Ensure NUL-termination
-            b[b.length()-1] = '\0';
-            QString text = QString(b);
-            int severity = mavlink_msg_statustext_get_severity(&message);
+        positionLock = true;
+        isLocalPositionKnown = true;
+    }
+}
 
-	    // If the message is NOTIFY or higher severity, or starts with a '#',
-	    // then read it aloud.
-            if (text.startsWith("#") || severity <= MAV_SEVERITY_NOTICE)
-            {
-                text.remove("#");
-                emit textMessageReceived(uasId, message.compid, severity, text);
-                _say(text.toLower(), severity);
-            }
-            else
-            {
-                emit textMessageReceived(uasId, message.compid, severity, text);
-            }
-        }
-            break;
+void UAS::_handleGlobalVisionPositionEstimate(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_global_vision_position_estimate_t pos;
+    mavlink_msg_global_vision_position_estimate_decode(&message, &pos);
+    quint64 time = getUnixTime(pos.usec);
+    emit localPositionChanged(this, message.compid, pos.x, pos.y, pos.z, time);
+    emit attitudeChanged(this, message.compid, pos.roll, pos.pitch, pos.yaw, time);
+}
 
-        case MAVLINK_MSG_ID_DATA_TRANSMISSION_HANDSHAKE:
-        {
-            mavlink_data_transmission_handshake_t p;
-            mavlink_msg_data_transmission_handshake_decode(&message, &p);
-            imageSize = p.size;
-            imagePackets = p.packets;
-            imagePayload = p.payload;
-            imageQuality = p.jpg_quality;
-            imageType = p.type;
-            imageWidth = p.width;
-            imageHeight = p.height;
-            imageStart = QGC::groundTimeMilliseconds();
-            imagePacketsArrived = 0;
+void UAS::_handleGlobalPositionInt(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_global_position_int_t pos;
+    mavlink_msg_global_position_int_decode(&message, &pos);
 
-        }
-            break;
+    quint64 time = getUnixTime();
 
-        case MAVLINK_MSG_ID_ENCAPSULATED_DATA:
-        {
-            mavlink_encapsulated_data_t img;
-            mavlink_msg_encapsulated_data_decode(&message, &img);
-            int seq = img.seqnr;
-            int pos = seq * imagePayload;
-
-            // Check if we have a valid transaction
-            if (imagePackets == 0)
-            {
-                // NO VALID TRANSACTION - ABORT
-                // Restart statemachine
-                imagePacketsArrived = 0;
-                break;
-            }
+    setLatitude(pos.lat/(double)1E7);
+    setLongitude(pos.lon/(double)1E7);
+    setAltitudeWGS84(pos.alt/1000.0);
+    setAltitudeRelative(pos.relative_alt/1000.0);
 
-            for (int i = 0; i < imagePayload; ++i)
-            {
-                if (pos <= imageSize) {
-                    imageRecBuffer[pos] = img.data[i];
-                }
-                ++pos;
-            }
+    globalEstimatorActive = true;
 
-            ++imagePacketsArrived;
+    speedX = pos.vx/100.0;
+    speedY = pos.vy/100.0;
+    speedZ = pos.vz/100.0;
 
-            // emit signal if all packets arrived
-            if (imagePacketsArrived >= imagePackets)
-            {
-                // Restart statemachine
-                imagePackets = 0;
-                imagePacketsArrived = 0;
-                emit imageReady(this);
-            }
-        }
-            break;
+    emit globalPositionChanged(this, getLatitude(), getLongitude(), getAltitudeAMSL(), getAltitudeWGS84(), time);
+    emit altitudeChanged(this, altitudeAMSL, altitudeWGS84, altitudeRelative, -speedZ, time);
+    // We had some frame mess here, global and local axes were mixed.
+    emit velocityChanged_NED(this, speedX, speedY, speedZ, time);
 
-        case MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT:
-        {
-            mavlink_nav_controller_output_t p;
-            mavlink_msg_nav_controller_output_decode(&message,&p);
-            setDistToWaypoint(p.wp_dist);
-            setBearingToWaypoint(p.nav_bearing);
-            emit navigationControllerErrorsChanged(this, p.alt_error, p.aspd_error, p.xtrack_error);
-            emit NavigationControllerDataChanged(this, p.nav_roll, p.nav_pitch, p.nav_bearing, p.target_bearing, p.wp_dist);
-        }
-            break;
-        // Messages to ignore
-        case MAVLINK_MSG_ID_RAW_IMU:
-        case MAVLINK_MSG_ID_SCALED_IMU:
-        case MAVLINK_MSG_ID_RAW_PRESSURE:
-        case MAVLINK_MSG_ID_SCALED_PRESSURE:
-        case MAVLINK_MSG_ID_OPTICAL_FLOW:
-        case MAVLINK_MSG_ID_DEBUG_VECT:
-        case MAVLINK_MSG_ID_DEBUG:
-        case MAVLINK_MSG_ID_NAMED_VALUE_FLOAT:
-        case MAVLINK_MSG_ID_NAMED_VALUE_INT:
-        case MAVLINK_MSG_ID_MANUAL_CONTROL:
-        case MAVLINK_MSG_ID_HIGHRES_IMU:
-        case MAVLINK_MSG_ID_DISTANCE_SENSOR:
-            break;
-        default:
-        {
-            if (!unknownPackets.contains(message.msgid))
-            {
-                unknownPackets.append(message.msgid);
-                qDebug() << "Unknown message from system:" << uasId << "message:" << message.msgid;
+    setGroundSpeed(qSqrt(speedX*speedX+speedY*speedY));
+    emit speedChanged(this, groundSpeed, airSpeed, time);
+
+    positionLock = true;
+    isGlobalPositionKnown = true;
+}
+
+void UAS::_handleGpsRawInt(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_gps_raw_int_t pos;
+    mavlink_msg_gps_raw_int_decode(&message, &pos);
+
+    quint64 time = getUnixTime(pos.time_usec);
+
+    // TODO: track localization state not only for gps but also for other loc. sources
+    int loc_type = pos.fix_type;
+    if (loc_type == 1)
+    {
+        loc_type = 0;
+    }
+    emit localizationChanged(this, loc_type);
+    setSatelliteCount(pos.satellites_visible);
+
+    if (pos.fix_type > 2)
+    {
+        positionLock = true;
+        isGlobalPositionKnown = true;
+
+        latitude_gps = pos.lat/(double)1E7;
+        longitude_gps = pos.lon/(double)1E7;
+        altitude_gps = pos.alt/1000.0;
+
+        // If no GLOBAL_POSITION_INT messages ever received, use these raw GPS values instead.
+        if (!globalEstimatorActive) {
+            setLatitude(latitude_gps);
+            setLongitude(longitude_gps);
+            setAltitudeWGS84(altitude_gps);
+            emit globalPositionChanged(this, getLatitude(), getLongitude(), getAltitudeAMSL(), getAltitudeWGS84(), time);
+            emit altitudeChanged(this, altitudeAMSL, altitudeWGS84, altitudeRelative, -speedZ, time);
+
+            float vel = pos.vel/100.0f;
+            // Smaller than threshold and not NaN
+            if ((vel < 1000000) && !isnan(vel) && !isinf(vel)) {
+                setGroundSpeed(vel);
+                emit speedChanged(this, groundSpeed, airSpeed, time);
+            } else {
+                emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_NOTICE, QString("GCS ERROR: RECEIVED INVALID SPEED OF %1 m/s").arg(vel));
             }
         }
-            break;
-        }
     }
 }
 
+void UAS::_handleGpsStatus(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_gps_status_t pos;
+    mavlink_msg_gps_status_decode(&message, &pos);
+    for(int i = 0; i < (int)pos.satellites_visible; i++)
+    {
+        emit gpsSatelliteStatusChanged(uasId, (unsigned char)pos.satellite_prn[i], (unsigned char)pos.satellite_elevation[i], (unsigned char)pos.satellite_azimuth[i], (unsigned char)pos.satellite_snr[i], static_cast<bool>(pos.satellite_used[i]));
+    }
+    setSatelliteCount(pos.satellites_visible);
+}
+
+void UAS::_handleGpsGlobalOrigin(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_gps_global_origin_t pos;
+    mavlink_msg_gps_global_origin_decode(&message, &pos);
+    emit homePositionChanged(uasId, pos.latitude / 10000000.0, pos.longitude / 10000000.0, pos.altitude / 1000.0);
+}
+
+void UAS::_handleRcChannels(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_rc_channels_t channels;
+    mavlink_msg_rc_channels_decode(&message, &channels);
+
+    emit remoteControlRSSIChanged(channels.rssi);
+
+    if (channels.chan1_raw != UINT16_MAX && channels.chancount > 0)
+        emit remoteControlChannelRawChanged(0, channels.chan1_raw);
+    if (channels.chan2_raw != UINT16_MAX && channels.chancount > 1)
+        emit remoteControlChannelRawChanged(1, channels.chan2_raw);
+    if (channels.chan3_raw != UINT16_MAX && channels.chancount > 2)
+        emit remoteControlChannelRawChanged(2, channels.chan3_raw);
+    if (channels.chan4_raw != UINT16_MAX && channels.chancount > 3)
+        emit remoteControlChannelRawChanged(3, channels.chan4_raw);
+    if (channels.chan5_raw != UINT16_MAX && channels.chancount > 4)
+        emit remoteControlChannelRawChanged(4, channels.chan5_raw);
+    if (channels.chan6_raw != UINT16_MAX && channels.chancount > 5)
+        emit remoteControlChannelRawChanged(5, channels.chan6_raw);
+    if (channels.chan7_raw != UINT16_MAX && channels.chancount > 6)
+        emit remoteControlChannelRawChanged(6, channels.chan7_raw);
+    if (channels.chan8_raw != UINT16_MAX && channels.chancount > 7)
+        emit remoteControlChannelRawChanged(7, channels.chan8_raw);
+    if (channels.chan9_raw != UINT16_MAX && channels.chancount > 8)
+        emit remoteControlChannelRawChanged(8, channels.chan9_raw);
+    if (channels.chan10_raw != UINT16_MAX && channels.chancount > 9)
+        emit remoteControlChannelRawChanged(9, channels.chan10_raw);
+    if (channels.chan11_raw != UINT16_MAX && channels.chancount > 10)
+        emit remoteControlChannelRawChanged(10, channels.chan11_raw);
+    if (channels.chan12_raw != UINT16_MAX && channels.chancount > 11)
+        emit remoteControlChannelRawChanged(11, channels.chan12_raw);
+    if (channels.chan13_raw != UINT16_MAX && channels.chancount > 12)
+        emit remoteControlChannelRawChanged(12, channels.chan13_raw);
+    if (channels.chan14_raw != UINT16_MAX && channels.chancount > 13)
+        emit remoteControlChannelRawChanged(13, channels.chan14_raw);
+    if (channels.chan15_raw != UINT16_MAX && channels.chancount > 14)
+        emit remoteControlChannelRawChanged(14, channels.chan15_raw);
+    if (channels.chan16_raw != UINT16_MAX && channels.chancount > 15)
+        emit remoteControlChannelRawChanged(15, channels.chan16_raw);
+    if (channels.chan17_raw != UINT16_MAX && channels.chancount > 16)
+        emit remoteControlChannelRawChanged(16, channels.chan17_raw);
+    if (channels.chan18_raw != UINT16_MAX && channels.chancount > 17)
+        emit remoteControlChannelRawChanged(17, channels.chan18_raw);
+}
+
+void UAS::_handleRcChannelsScaled(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_rc_channels_scaled_t channels;
+    mavlink_msg_rc_channels_scaled_decode(&message, &channels);
+
+    const unsigned int portWidth = 8; // XXX magic number
+
+    emit remoteControlRSSIChanged(channels.rssi);
+    if (static_cast<uint16_t>(channels.chan1_scaled) != UINT16_MAX)
+        emit remoteControlChannelScaledChanged(channels.port * portWidth + 0, channels.chan1_scaled/10000.0f);
+    if (static_cast<uint16_t>(channels.chan2_scaled) != UINT16_MAX)
+        emit remoteControlChannelScaledChanged(channels.port * portWidth + 1, channels.chan2_scaled/10000.0f);
+    if (static_cast<uint16_t>(channels.chan3_scaled) != UINT16_MAX)
+        emit remoteControlChannelScaledChanged(channels.port * portWidth + 2, channels.chan3_scaled/10000.0f);
+    if (static_cast<uint16_t>(channels.chan4_scaled) != UINT16_MAX)
+        emit remoteControlChannelScaledChanged(channels.port * portWidth + 3, channels.chan4_scaled/10000.0f);
+    if (static_cast<uint16_t>(channels.chan5_scaled) != UINT16_MAX)
+        emit remoteControlChannelScaledChanged(channels.port * portWidth + 4, channels.chan5_scaled/10000.0f);
+    if (static_cast<uint16_t>(channels.chan6_scaled) != UINT16_MAX)
+        emit remoteControlChannelScaledChanged(channels.port * portWidth + 5, channels.chan6_scaled/10000.0f);
+    if (static_cast<uint16_t>(channels.chan7_scaled) != UINT16_MAX)
+        emit remoteControlChannelScaledChanged(channels.port * portWidth + 6, channels.chan7_scaled/10000.0f);
+    if (static_cast<uint16_t>(channels.chan8_scaled) != UINT16_MAX)
+        emit remoteControlChannelScaledChanged(channels.port * portWidth + 7, channels.chan8_scaled/10000.0f);
+}
+
+void UAS::_handleParamValue(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_param_value_t rawValue;
+    mavlink_msg_param_value_decode(&message, &rawValue);
+    QByteArray bytes(rawValue.param_id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
+    // Construct a string stopping at the first NUL (0) character, else copy the whole
+    // byte array (max MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN, so safe)
+    QString parameterName(bytes);
+    mavlink_param_union_t paramVal;
+    paramVal.param_float = rawValue.param_value;
+    paramVal.type = rawValue.param_type;
+
+    processParamValueMsg(message, parameterName,rawValue,paramVal);
+}
+
+void UAS::_handleCommandAck(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_command_ack_t ack;
+    mavlink_msg_command_ack_decode(&message, &ack);
+    switch (ack.result)
+    {
+    case MAV_RESULT_ACCEPTED:
+    {
+        emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_INFO, tr("SUCCESS: Executed CMD: %1").arg(ack.command));
+    }
+        break;
+    case MAV_RESULT_TEMPORARILY_REJECTED:
+    {
+        emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_WARNING, tr("FAILURE: Temporarily rejected CMD: %1").arg(ack.command));
+    }
+        break;
+    case MAV_RESULT_DENIED:
+    {
+        emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_ERROR, tr("FAILURE: Denied CMD: %1").arg(ack.command));
+    }
+        break;
+    case MAV_RESULT_UNSUPPORTED:
+    {
+        emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_WARNING, tr("FAILURE: Unsupported CMD: %1").arg(ack.command));
+    }
+        break;
+    case MAV_RESULT_FAILED:
+    {
+        emit textMessageReceived(uasId, message.compid, MAV_SEVERITY_ERROR, tr("FAILURE: Failed CMD: %1").arg(ack.command));
+    }
+        break;
+    }
+}
+
+void UAS::_handleAttitudeTarget(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_attitude_target_t out;
+    mavlink_msg_attitude_target_decode(&message, &out);
+    float roll, pitch, yaw;
+    mavlink_quaternion_to_euler(out.q, &roll, &pitch, &yaw);
+    quint64 time = getUnixTimeFromMs(out.time_boot_ms);
+    emit attitudeThrustSetPointChanged(this, roll, pitch, yaw, out.thrust, time);
+
+    // For plotting emit roll sp, pitch sp and yaw sp values
+    _emitValue(ValueSeriesRollSetpoint, roll, time);
+    _emitValue(ValueSeriesPitchSetpoint, pitch, time);
+    _emitValue(ValueSeriesYawSetpoint, yaw, time);
+}
+
+void UAS::_handlePositionTargetLocalNed(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_position_target_local_ned_t p;
+    mavlink_msg_position_target_local_ned_decode(&message, &p);
+    quint64 time = getUnixTimeFromMs(p.time_boot_ms);
+    emit positionSetPointsChanged(uasId, p.x, p.y, p.z, 0/* XXX remove yaw and move it to attitude */, time);
+}
+
+void UAS::_handleSetPositionTargetLocalNed(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_set_position_target_local_ned_t p;
+    mavlink_msg_set_position_target_local_ned_decode(&message, &p);
+    emit userPositionSetPointsChanged(uasId, p.x, p.y, p.z, 0/* XXX remove yaw and move it to attitude */);
+}
+
+void UAS::_handleStatustext(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    QByteArray b;
+    b.resize(MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN+1);
+    mavlink_msg_statustext_get_text(&message, b.data());
+
+    // Ensure NUL-termination
+    b[b.length()-1] = '\0';
+    QString text = QString(b);
+    int severity = mavlink_msg_statustext_get_severity(&message);
+
+	    // If the message is NOTIFY or higher severity, or starts with a '#',
+	    // then read it aloud.
+    if (text.startsWith("#") || severity <= MAV_SEVERITY_NOTICE)
+    {
+        text.remove("#");
+        emit textMessageReceived(uasId, message.compid, severity, text);
+        _say(text.toLower(), severity);
+    }
+    else
+    {
+        emit textMessageReceived(uasId, message.compid, severity, text);
+    }
+}
+
+void UAS::_handleDataTransmissionHandshake(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_data_transmission_handshake_t p;
+    mavlink_msg_data_transmission_handshake_decode(&message, &p);
+    imageReassembler.handshakeReceived(message.sysid, message.compid, p);
+}
+
+void UAS::_handleEncapsulatedData(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_encapsulated_data_t img;
+    mavlink_msg_encapsulated_data_decode(&message, &img);
+    imageReassembler.dataReceived(message.sysid, message.compid, img);
+}
+
+void UAS::_handleNavControllerOutput(mavlink_message_t& message, bool wrongComponent)
+{
+    Q_UNUSED(wrongComponent);
+    mavlink_nav_controller_output_t p;
+    mavlink_msg_nav_controller_output_decode(&message,&p);
+    setDistToWaypoint(p.wp_dist);
+    setBearingToWaypoint(p.nav_bearing);
+    emit navigationControllerErrorsChanged(this, p.alt_error, p.aspd_error, p.xtrack_error);
+    emit NavigationControllerDataChanged(this, p.nav_roll, p.nav_pitch, p.nav_bearing, p.target_bearing, p.wp_dist);
+}
+
 /**
 * Set the home position of the UAS.
 * @param lat The latitude fo the home position
@@ -1102,10 +1178,9 @@ void UAS::setHomePosition(double lat, double lon, double alt)
                                                                  QMessageBox::Cancel);
     if (button == QMessageBox::Yes)
     {
+        _vehicle->commandManager()->sendCommand(0, MAV_CMD_DO_SET_HOME, 0, 0, 0, 0, lat, lon, alt);
+
         mavlink_message_t msg;
-        mavlink_msg_command_long_pack(mavlink->getSystemId(), mavlink->getComponentId(), &msg, this->getUASID(), 0, MAV_CMD_DO_SET_HOME, 1, 0, 0, 0, 0, lat, lon, alt);
-        // Send message twice to increase chance that it reaches its goal
-        _vehicle->sendMessage(msg);
 
         // Send new home position to UAS
         mavlink_set_gps_global_origin_t home;
@@ -1164,22 +1239,17 @@ void UAS::startCalibration(UASInterface::StartCalibrationType calType)
             break;
     }
     
-    mavlink_message_t msg;
-    mavlink_msg_command_long_pack(mavlink->getSystemId(),
-                                  mavlink->getComponentId(),
-                                  &msg,
-                                  uasId,
-                                  0,                                // target component
-                                  MAV_CMD_PREFLIGHT_CALIBRATION,    // command id
-                                  0,                                // 0=first transmission of command
-                                  gyroCal,                          // gyro cal
-                                  magCal,                           // mag cal
-                                  0,                                // ground pressure
-                                  radioCal,                         // radio cal
-                                  accelCal,                         // accel cal
-                                  airspeedCal,                      // airspeed cal
-                                  escCal);                          // esc cal
-    _vehicle->sendMessage(msg);
+    // Calibration restarts if the command runs twice so it is sent once, the result is signalled through
+    // VehicleCommandManager::commandResult
+    _vehicle->commandManager()->sendCommandOnce(0,                              // target component
+                                                MAV_CMD_PREFLIGHT_CALIBRATION,
+                                                gyroCal,                        // gyro cal
+                                                magCal,                         // mag cal
+                                                0,                              // ground pressure
+                                                radioCal,                       // radio cal
+                                                accelCal,                       // accel cal
+                                                airspeedCal,                    // airspeed cal
+                                                escCal);                        // esc cal
 }
 
 void UAS::stopCalibration(void)
@@ -1188,22 +1258,10 @@ void UAS::stopCalibration(void)
         return;
     }
     
-    mavlink_message_t msg;
-    mavlink_msg_command_long_pack(mavlink->getSystemId(),
-                                  mavlink->getComponentId(),
-                                  &msg,
-                                  uasId,
-                                  0,                                // target component
-                                  MAV_CMD_PREFLIGHT_CALIBRATION,    // command id
-                                  0,                                // 0=first transmission of command
-                                  0,                                // gyro cal
-                                  0,                                // mag cal
-                                  0,                                // ground pressure
-                                  0,                                // radio cal
-                                  0,                                // accel cal
-                                  0,                                // airspeed cal
-                                  0);                               // unused
-    _vehicle->sendMessage(msg);
+    // The start command may still be waiting for its ack, stop tracking it so the stop command can go out
+    VehicleCommandManager* commandManager = _vehicle->commandManager();
+    commandManager->cancelCommand(0, MAV_CMD_PREFLIGHT_CALIBRATION);
+    commandManager->sendCommandOnce(0, MAV_CMD_PREFLIGHT_CALIBRATION);
 }
 
 void UAS::startBusConfig(UASInterface::StartBusConfigType calType)
@@ -1223,22 +1281,10 @@ void UAS::startBusConfig(UASInterface::StartBusConfigType calType)
         break;
     }
 
-    mavlink_message_t msg;
-    mavlink_msg_command_long_pack(mavlink->getSystemId(),
-                                  mavlink->getComponentId(),
-                                  &msg,
-                                  uasId,
-                                  0,                                // target component
-                                  MAV_CMD_PREFLIGHT_UAVCAN,    // command id
-                                  0,                                // 0=first transmission of command
-                                  actuatorCal,                      // actuators
-                                  0,
-                                  0,
-                                  0,
-                                  0,
-                                  0,
-                                  0);
-    _vehicle->sendMessage(msg);
+    // Ending bus config may follow the start before it is acked
+    VehicleCommandManager* commandManager = _vehicle->commandManager();
+    commandManager->cancelCommand(0, MAV_CMD_PREFLIGHT_UAVCAN);
+    commandManager->sendCommandOnce(0, MAV_CMD_PREFLIGHT_UAVCAN, actuatorCal);
 }
 
 void UAS::stopBusConfig(void)
@@ -1247,22 +1293,9 @@ void UAS::stopBusConfig(void)
         return;
     }
     
-    mavlink_message_t msg;
-    mavlink_msg_command_long_pack(mavlink->getSystemId(),
-                                  mavlink->getComponentId(),
-                                  &msg,
-                                  uasId,
-                                  0,                                // target component
-                                  MAV_CMD_PREFLIGHT_UAVCAN,    // command id
-                                  0,                                // 0=first transmission of command
-                                  0,
-                                  0,
-                                  0,
-                                  0,
-                                  0,
-                                  0,
-                                  0);
-    _vehicle->sendMessage(msg);
+    VehicleCommandManager* commandManager = _vehicle->commandManager();
+    commandManager->cancelCommand(0, MAV_CMD_PREFLIGHT_UAVCAN);
+    commandManager->sendCommandOnce(0, MAV_CMD_PREFLIGHT_UAVCAN);
 }
 
 /**
@@ -1373,6 +1406,12 @@ quint64 UAS::getUnixTime(quint64 time)
     else if (time < 1261440000000000)
 #endif
     {
+        // Prefer the filtered TIMESYNC mapping, the fallback below carries the link delay of a single sample
+        if (VehicleTimeSync::onboardToGcsMsecs(uasId, time/1000, &ret))
+        {
+            return ret;
+        }
+
         //        qDebug() << "GEN time:" << time/1000 + onboardTimeOffset;
         if (onboardTimeOffset == 0 || time < (lastNonNullTime - 100))
         {
@@ -1462,53 +1501,6 @@ void UAS::getStatusForCode(int statusCode, QString& uasState, QString& stateDesc
 
 QImage UAS::getImage()
 {
-
-//    qDebug() << "IMAGE TYPE:" << imageType;
-
-    // RAW greyscale
-    if (imageType == MAVLINK_DATA_STREAM_IMG_RAW8U)
-    {
-        int imgColors = 255;
-
-        // Construct PGM header
-        QString header("P5\n%1 %2\n%3\n");
-        header = header.arg(imageWidth).arg(imageHeight).arg(imgColors);
-
-        QByteArray tmpImage(header.toStdString().c_str(), header.length());
-        tmpImage.append(imageRecBuffer);
-
-        //qDebug() << "IMAGE SIZE:" << tmpImage.size() << "HEADER SIZE: (15):" << header.size() << "HEADER: " << header;
-
-        if (imageRecBuffer.isNull())
-        {
-            qDebug()<< "could not convertToPGM()";
-            return QImage();
-        }
-
-        if (!image.loadFromData(tmpImage, "PGM"))
-        {
-            qDebug()<< __FILE__ << __LINE__ << "could not create extracted image";
-            return QImage();
-        }
-
-    }
-    // BMP with header
-    else if (imageType == MAVLINK_DATA_STREAM_IMG_BMP ||
-             imageType == MAVLINK_DATA_STREAM_IMG_JPEG ||
-             imageType == MAVLINK_DATA_STREAM_IMG_PGM ||
-             imageType == MAVLINK_DATA_STREAM_IMG_PNG)
-    {
-        if (!image.loadFromData(imageRecBuffer))
-        {
-            qDebug() << __FILE__ << __LINE__ << "Loading data from image buffer failed!";
-            return QImage();
-        }
-    }
-
-    // Restart statemachine
-    imagePacketsArrived = 0;
-    imagePackets = 0;
-    imageRecBuffer.clear();
     return image;
 }
 
@@ -1521,7 +1513,7 @@ void UAS::requestImage()
    qDebug() << "trying to get an image from the uas...";
 
     // check if there is already an image transmission going on
-    if (imagePacketsArrived == 0)
+    if (imageReassembler.activeTransferCount() == 0)
     {
         mavlink_message_t msg;
         mavlink_msg_data_transmission_handshake_pack(mavlink->getSystemId(), mavlink->getComponentId(), &msg, MAVLINK_DATA_STREAM_IMG_JPEG, 0, 0, 0, 0, 0, 50);
@@ -1529,6 +1521,32 @@ void UAS::requestImage()
     }
 }
 
+void UAS::_imageDecoded(int sysid, int compid, const QImage& decodedImage)
+{
+    Q_UNUSED(sysid);
+    Q_UNUSED(compid);
+
+    if (!decodedImage.isNull()) {
+        image = decodedImage;
+        emit imageReady(this);
+    }
+}
+
+void UAS::_requestImagePackets(int sysid, int compid, const mavlink_data_transmission_handshake_t& request)
+{
+    Q_UNUSED(sysid);
+    Q_UNUSED(compid);
+
+    if (!_vehicle) {
+        return;
+    }
+
+    // The handshake has no target fields, the vehicle is addressed through the link
+    mavlink_message_t msg;
+    mavlink_msg_data_transmission_handshake_encode(mavlink->getSystemId(), mavlink->getComponentId(), &msg, &request);
+    _vehicle->sendMessage(msg);
+}
+
 
 /* MANAGEMENT */
 
@@ -1580,42 +1598,10 @@ void UAS::processParamValueMsg(mavlink_message_t& msg, const QString& paramName,
 {
     int compId = msg.compid;
 
-    QVariant paramValue;
-
-    // Insert with correct type
+    // The raw bits are passed through untouched, the receiver interprets them according to the Fact type
+    qCDebug(UASLog) << "Received PARAM_VALUE" << paramName << rawValue.param_type << paramUnion.param_uint32;
 
-    switch (rawValue.param_type) {
-        case MAV_PARAM_TYPE_REAL32:
-            paramValue = QVariant(paramUnion.param_float);
-            break;
-
-        case MAV_PARAM_TYPE_UINT8:
-            paramValue = QVariant(paramUnion.param_uint8);
-            break;
-
-        case MAV_PARAM_TYPE_INT8:
-            paramValue = QVariant(paramUnion.param_int8);
-            break;
-
-        case MAV_PARAM_TYPE_INT16:
-            paramValue = QVariant(paramUnion.param_int16);
-            break;
-
-        case MAV_PARAM_TYPE_UINT32:
-            paramValue = QVariant(paramUnion.param_uint32);
-            break;
-            
-        case MAV_PARAM_TYPE_INT32:
-            paramValue = QVariant(paramUnion.param_int32);
-            break;
-
-        default:
-            qCritical() << "INVALID DATA TYPE USED AS PARAMETER VALUE: " << rawValue.param_type;
-    }
-
-    qCDebug(UASLog) << "Received PARAM_VALUE" << paramName << paramValue << rawValue.param_type;
-
-    emit parameterUpdate(uasId, compId, paramName, rawValue.param_count, rawValue.param_index, rawValue.param_type, paramValue);
+    emit parameterUpdate(uasId, compId, paramName, rawValue.param_count, rawValue.param_index, rawValue.param_type, paramUnion.param_uint32);
 }
 
 /**
@@ -1652,27 +1638,20 @@ void UAS::setSystemType(int systemType)
    }
 }
 
-void UAS::executeCommand(MAV_CMD command, int confirmation, float param1, float param2, float param3, float param4, float param5, float param6, float param7, int component)
+bool UAS::executeCommand(MAV_CMD command, int confirmation, float param1, float param2, float param3, float param4, float param5, float param6, float param7, int component)
 {
+    // The confirmation field is owned by the command manager which increments it on each retransmit
+    Q_UNUSED(confirmation);
+    
     if (!_vehicle) {
-        return;
+        return false;
     }
     
-    mavlink_message_t msg;
-    mavlink_command_long_t cmd;
-    cmd.command = (uint16_t)command;
-    cmd.confirmation = confirmation;
-    cmd.param1 = param1;
-    cmd.param2 = param2;
-    cmd.param3 = param3;
-    cmd.param4 = param4;
-    cmd.param5 = param5;
-    cmd.param6 = param6;
-    cmd.param7 = param7;
-    cmd.target_system = uasId;
-    cmd.target_component = component;
-    mavlink_msg_command_long_encode(mavlink->getSystemId(), mavlink->getComponentId(), &msg, &cmd);
-    _vehicle->sendMessage(msg);
+    VehicleCommandManager* commandManager = _vehicle->commandManager();
+    if (VehicleCommandManager::isSendOnceCommand(command)) {
+        return commandManager->sendCommandOnce(component, command, param1, param2, param3, param4, param5, param6, param7);
+    }
+    return commandManager->sendCommand(component, command, param1, param2, param3, param4, param5, param6, param7);
 }
 
 /**
@@ -1935,10 +1914,7 @@ void UAS::pairRX(int rxType, int rxSubType)
         return;
     }
     
-    mavlink_message_t msg;
-
-    mavlink_msg_command_long_pack(mavlink->getSystemId(), mavlink->getComponentId(), &msg, uasId, MAV_COMP_ID_ALL, MAV_CMD_START_RX_PAIR, 0, rxType, rxSubType, 0, 0, 0, 0, 0);
-    _vehicle->sendMessage(msg);
+    _vehicle->commandManager()->sendCommand(MAV_COMP_ID_ALL, MAV_CMD_START_RX_PAIR, rxType, rxSubType);
 }
 
 /**
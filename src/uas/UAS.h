@@ -37,6 +37,7 @@ This file is part of the QGROUNDCONTROL project
 #include <QVector3D>
 #include "QGCMAVLink.h"
 #include "FileManager.h"
+#include "ImageReassembler.h"
 #include "Vehicle.h"
 
 #ifndef __mobile__
@@ -464,19 +465,9 @@ protected: //COMMENTS FOR TEST UNIT
     double pitch;
     double yaw;
 
-    // dongfang: This looks like a candidate for being moved off to a separate class.
     /// IMAGING
-    int imageSize;              ///< Image size being transmitted (bytes)
-    int imagePackets;           ///< Number of data packets being sent for this image
-    int imagePacketsArrived;    ///< Number of data packets recieved
-    int imagePayload;           ///< Payload size per transmitted packet (bytes). Standard is 254, and decreases when image resolution increases.
-    int imageQuality;           ///< Quality of the transmitted image (percentage)
-    int imageType;              ///< Type of the transmitted image (BMP, PNG, JPEG, RAW 8 bit, RAW 32 bit)
-    int imageWidth;             ///< Width of the image stream
-    int imageHeight;            ///< Width of the image stream
-    QByteArray imageRecBuffer;  ///< Buffer for the incoming bytestream
+    ImageReassembler imageReassembler;  ///< Reassembles image transfers from the vehicle
     QImage image;               ///< Image data of last completely transmitted image
-    quint64 imageStart;
     bool blockHomePositionChanges;   ///< Block changes to the home position
     bool receivedMode;          ///< True if mode was retrieved from current conenction to UAS
 
@@ -548,7 +539,7 @@ public slots:
 
     }
     /** @brief Executes a command with 7 params */
-    void executeCommand(MAV_CMD command, int confirmation, float param1, float param2, float param3, float param4, float param5, float param6, float param7, int component);
+    bool executeCommand(MAV_CMD command, int confirmation, float param1, float param2, float param3, float param4, float param5, float param6, float param7, int component);
 
     /** @brief Order the robot to pair its receiver **/
     void pairRX(int rxType, int rxSubType);
@@ -691,11 +682,84 @@ protected slots:
     /** @brief Read settings from disk */
     void readSettings();
     
+private slots:
+    void _imageDecoded(int sysid, int compid, const QImage& image);
+    void _requestImagePackets(int sysid, int compid, const mavlink_data_transmission_handshake_t& request);
+    
 private:
     void _say(const QString& text, int severity = 6);
     
+    /// Handles a single message id. wrongComponent is true if the message comes from a different component
+    /// than the first one which sent this message id.
+    typedef void (UAS::*MessageHandler)(mavlink_message_t& message, bool wrongComponent);
+    
+    typedef struct {
+        MessageHandler  handler;            ///< NULL if the message is not processed
+        bool            ignored;            ///< true: message is known but not processed, don't report it as unknown
+        bool            filterComponents;   ///< true: drop the message from other components once multiple senders are detected
+    } MessageHandlerInfo_t;
+    
+    /// Plot series emitted through valueChanged
+    typedef enum {
+        ValueSeriesHeartbeatBaseMode,
+        ValueSeriesHeartbeatCustomMode,
+        ValueSeriesHeartbeatSystemStatus,
+        ValueSeriesSysStatusSensorsEnabled,
+        ValueSeriesSysStatusSensorsHealth,
+        ValueSeriesSysStatusErrorsComm,
+        ValueSeriesSysStatusErrorsCount1,
+        ValueSeriesSysStatusErrorsCount2,
+        ValueSeriesSysStatusErrorsCount3,
+        ValueSeriesSysStatusErrorsCount4,
+        ValueSeriesSysStatusLoad,
+        ValueSeriesSysStatusBatteryRemaining,
+        ValueSeriesSysStatusBatteryVoltage,
+        ValueSeriesSysStatusBatteryCurrent,
+        ValueSeriesSysStatusDropRateComm,
+        ValueSeriesRollSetpoint,
+        ValueSeriesPitchSetpoint,
+        ValueSeriesYawSetpoint,
+        ValueSeriesCount
+    } ValueSeries_t;
+    
+    static void _initMessageHandlers(void);
+    void _initValueSeries(void);
+    void _emitValue(ValueSeries_t series, const QVariant& value, quint64 time);
+    
+    void _handleHeartbeat(mavlink_message_t& message, bool wrongComponent);
+    void _handleBatteryStatus(mavlink_message_t& message, bool wrongComponent);
+    void _handleSysStatus(mavlink_message_t& message, bool wrongComponent);
+    void _handleAttitude(mavlink_message_t& message, bool wrongComponent);
+    void _handleAttitudeQuaternion(mavlink_message_t& message, bool wrongComponent);
+    void _handleHilControls(mavlink_message_t& message, bool wrongComponent);
+    void _handleVfrHud(mavlink_message_t& message, bool wrongComponent);
+    void _handleLocalPositionNed(mavlink_message_t& message, bool wrongComponent);
+    void _handleGlobalVisionPositionEstimate(mavlink_message_t& message, bool wrongComponent);
+    void _handleGlobalPositionInt(mavlink_message_t& message, bool wrongComponent);
+    void _handleGpsRawInt(mavlink_message_t& message, bool wrongComponent);
+    void _handleGpsStatus(mavlink_message_t& message, bool wrongComponent);
+    void _handleGpsGlobalOrigin(mavlink_message_t& message, bool wrongComponent);
+    void _handleRcChannels(mavlink_message_t& message, bool wrongComponent);
+    void _handleRcChannelsScaled(mavlink_message_t& message, bool wrongComponent);
+    void _handleParamValue(mavlink_message_t& message, bool wrongComponent);
+    void _handleCommandAck(mavlink_message_t& message, bool wrongComponent);
+    void _handleAttitudeTarget(mavlink_message_t& message, bool wrongComponent);
+    void _handlePositionTargetLocalNed(mavlink_message_t& message, bool wrongComponent);
+    void _handleSetPositionTargetLocalNed(mavlink_message_t& message, bool wrongComponent);
+    void _handleStatustext(mavlink_message_t& message, bool wrongComponent);
+    void _handleDataTransmissionHandshake(mavlink_message_t& message, bool wrongComponent);
+    void _handleEncapsulatedData(mavlink_message_t& message, bool wrongComponent);
+    void _handleNavControllerOutput(mavlink_message_t& message, bool wrongComponent);
+    
 private:
     Vehicle*            _vehicle;
+    
+    static MessageHandlerInfo_t _rgMessageHandlers[256];    ///< Handler table indexed by message id
+    static bool                 _messageHandlersInitialized;
+    
+    QString _valueSeriesNames[ValueSeriesCount];    ///< Plot series names, built once in _initValueSeries
+    QString _valueSeriesUnits[ValueSeriesCount];
+    bool    _componentSeen[256];                    ///< true: component id has been added to components
 };
 
 
@@ -201,8 +201,10 @@ public:
 
 public slots:
 
-    /** @brief Executes a command **/
-    virtual void executeCommand(MAV_CMD command, int confirmation, float param1, float param2, float param3, float param4, float param5, float param6, float param7, int component) = 0;
+    /** @brief Executes a command
+     *  @return false: The same command is still waiting for an ack from the vehicle, nothing was sent
+     */
+    virtual bool executeCommand(MAV_CMD command, int confirmation, float param1, float param2, float param3, float param4, float param5, float param6, float param7, int component) = 0;
 
     /** @brief Selects the airframe */
     virtual void setAirframe(int airframe) = 0;
@@ -299,7 +301,7 @@ signals:
       */
     void valueChanged(const int uasid, const QString& name, const QString& unit, const QVariant &value,const quint64 msecs);
 
-    void parameterUpdate(int uas, int component, QString parameterName, int parameterCount, int parameterId, int type, QVariant value);
+    void parameterUpdate(int uas, int component, QString parameterName, int parameterCount, int parameterId, int type, quint32 paramBits);
 
     /**
      * @brief The battery status has been updated
@@ -32,11 +32,20 @@ This file is part of the QGROUNDCONTROL project
 #include "MultiVehicleManager.h"
 #include "UAS.h"
 
-UASMessage::UASMessage(int componentid, int severity, QString text)
+UASMessage::UASMessage()
+    : _compId(0)
+    , _severity(0)
+{
+
+}
+
+void UASMessage::_set(int componentid, int severity, const QString& text)
 {
     _compId   = componentid;
     _severity = severity;
     _text     = text;
+    _time     = QTime::currentTime();
+    _formatedText.clear();
 }
 
 bool UASMessage::severityIsError()
@@ -52,17 +61,57 @@ bool UASMessage::severityIsError()
     }
 }
 
+QString UASMessage::getFormatedText()
+{
+    if (!_formatedText.isEmpty()) {
+        return _formatedText;
+    }
+    
+    // Color the output depending on the message severity. We have 3 distinct cases:
+    // 1: If we have an ERROR or worse, make it bigger, bolder, and highlight it red.
+    // 2: If we have a warning or notice, just make it bold and color it orange.
+    // 3: Otherwise color it the standard color, white.
+
+    // So first determine the styling based on the severity.
+    QString style;
+    switch (_severity)
+    {
+    case MAV_SEVERITY_EMERGENCY:
+    case MAV_SEVERITY_ALERT:
+    case MAV_SEVERITY_CRITICAL:
+    case MAV_SEVERITY_ERROR:
+        //Use set RGB values from given color from QGC
+        style = QString("color: rgb(%1, %2, %3); font-weight:bold").arg(QGC::colorRed.red()).arg(QGC::colorRed.green()).arg(QGC::colorRed.blue());
+        break;
+    case MAV_SEVERITY_NOTICE:
+    case MAV_SEVERITY_WARNING:
+        style = QString("color: rgb(%1, %2, %3); font-weight:bold").arg(QGC::colorOrange.red()).arg(QGC::colorOrange.green()).arg(QGC::colorOrange.blue());
+        break;
+    default:
+        style = QString("color:white; font-weight:bold");
+        break;
+    }
+
+    // Finally preppend the properly-styled text with a timestamp.
+    QString dateString = _time.toString("hh:mm:ss.zzz");
+    _formatedText = QString("<p style=\"color:#CCCCCC\">[%2 - COMP:%3]<font style=\"%1\">%4 %5</font></p>").arg(style).arg(dateString).arg(_compId).arg(UASMessageHandler::severityText(_severity)).arg(_text);
+    
+    return _formatedText;
+}
+
 IMPLEMENT_QGC_SINGLETON(UASMessageHandler, UASMessageHandler)
 
 UASMessageHandler::UASMessageHandler(QObject *parent)
     : QGCSingleton(parent)
     , _activeUAS(NULL)
+    , _ring(defaultCapacity)
     , _errorCount(0)
     , _errorCountTotal(0)
     , _warningCount(0)
     , _normalCount(0)
     , _showErrorsInToolbar(false)
 {
+    _resetIndices();
     connect(MultiVehicleManager::instance(), &MultiVehicleManager::activeVehicleChanged, this, &UASMessageHandler::_activeVehicleChanged);
     emit textMessageReceived(NULL);
     emit textMessageCountChanged(0);
@@ -70,23 +119,139 @@ UASMessageHandler::UASMessageHandler(QObject *parent)
 
 UASMessageHandler::~UASMessageHandler()
 {
-    clearMessages();
+
+}
+
+void UASMessageHandler::_resetIndices()
+{
+    _nextIndex     = 0;
+    _retainedCount = 0;
+    _receivedCount = 0;
+    for (int i=0; i<_severityIndexCount; i++) {
+        _severityIndex[i].clear();
+    }
+    for (int i=0; i<_componentIndexCount; i++) {
+        _componentIndex[i].clear();
+    }
+}
+
+void UASMessageHandler::setCapacity(int capacity)
+{
+    capacity = qMax(capacity, 1);
+    if (capacity != _ring.count()) {
+        // Changing the capacity drops the kept messages, it is meant to be set once at startup
+        _ring = QVector<UASMessage>(capacity);
+        clearMessages();
+    }
 }
 
 void UASMessageHandler::clearMessages()
 {
-    _mutex.lock();
-    while(_messages.count()) {
-        delete _messages.last();
-        _messages.pop_back();
+    for (int i=0; i<_ring.count(); i++) {
+        _ring[i]._set(0, 0, QString());
     }
-    _errorCount   = 0;
-    _warningCount = 0;
-    _normalCount  = 0;
-    _mutex.unlock();
+    _resetIndices();
+    _errorCount.store(0);
+    _warningCount.store(0);
+    _normalCount.store(0);
     emit textMessageCountChanged(0);
 }
 
+UASMessage* UASMessageHandler::message(int index)
+{
+    if (index < 0 || index >= _retainedCount) {
+        return NULL;
+    }
+    
+    // The oldest message is the one which will be overwritten next once the ring is full
+    int oldest = _retainedCount == _ring.count() ? _nextIndex : 0;
+    
+    return &_ring[(oldest + index) % _ring.count()];
+}
+
+int UASMessageHandler::_severityIndexFor(int severity)
+{
+    return severity >= 0 && severity < _severityIndexCount - 1 ? severity : _severityIndexCount - 1;
+}
+
+int UASMessageHandler::severityCount(int severity)
+{
+    return _severityIndex[_severityIndexFor(severity)].count();
+}
+
+UASMessage* UASMessageHandler::severityMessage(int severity, int index)
+{
+    return _indexedMessage(_severityIndex[_severityIndexFor(severity)], index);
+}
+
+int UASMessageHandler::componentCount(int componentId)
+{
+    return componentId >= 0 && componentId < _componentIndexCount ? _componentIndex[componentId].count() : 0;
+}
+
+UASMessage* UASMessageHandler::componentMessage(int componentId, int index)
+{
+    if (componentId < 0 || componentId >= _componentIndexCount) {
+        return NULL;
+    }
+    return _indexedMessage(_componentIndex[componentId], index);
+}
+
+UASMessage* UASMessageHandler::_indexedMessage(const QList<int>& index, int position)
+{
+    if (position < 0 || position >= index.count()) {
+        return NULL;
+    }
+    return &_ring[index[position]];
+}
+
+void UASMessageHandler::_addToIndices(int slot)
+{
+    const UASMessage& message = _ring[slot];
+    _severityIndex[_severityIndexFor(message._severity)].append(slot);
+    if (message._compId >= 0 && message._compId < _componentIndexCount) {
+        _componentIndex[message._compId].append(slot);
+    }
+}
+
+void UASMessageHandler::_removeFromIndices(int slot)
+{
+    const UASMessage& message = _ring[slot];
+    QList<int>& severityIndex = _severityIndex[_severityIndexFor(message._severity)];
+    Q_ASSERT(!severityIndex.isEmpty() && severityIndex.first() == slot);
+    severityIndex.removeFirst();
+    if (message._compId >= 0 && message._compId < _componentIndexCount) {
+        QList<int>& componentIndex = _componentIndex[message._compId];
+        Q_ASSERT(!componentIndex.isEmpty() && componentIndex.first() == slot);
+        componentIndex.removeFirst();
+    }
+}
+
+QString UASMessageHandler::severityText(int severity)
+{
+    switch (severity)
+    {
+    case MAV_SEVERITY_EMERGENCY:
+        return tr(" EMERGENCY:");
+    case MAV_SEVERITY_ALERT:
+        return tr(" ALERT:");
+    case MAV_SEVERITY_CRITICAL:
+        return tr(" Critical:");
+    case MAV_SEVERITY_ERROR:
+        return tr(" Error:");
+    case MAV_SEVERITY_WARNING:
+        return tr(" Warning:");
+    case MAV_SEVERITY_NOTICE:
+        return tr(" Notice:");
+    case MAV_SEVERITY_INFO:
+        return tr(" Info:");
+    case MAV_SEVERITY_DEBUG:
+        return tr(" Debug:");
+    default:
+        return QString();
+    }
+}
+
 void UASMessageHandler::_activeVehicleChanged(Vehicle* vehicle)
 {
     // If we were already attached to an autopilot, disconnect it.
@@ -111,83 +276,41 @@ void UASMessageHandler::_activeVehicleChanged(Vehicle* vehicle)
 
 void UASMessageHandler::handleTextMessage(int, int compId, int severity, QString text)
 {
-
-    // Color the output depending on the message severity. We have 3 distinct cases:
-    // 1: If we have an ERROR or worse, make it bigger, bolder, and highlight it red.
-    // 2: If we have a warning or notice, just make it bold and color it orange.
-    // 3: Otherwise color it the standard color, white.
-
-    _mutex.lock();
-
-    // So first determine the styling based on the severity.
-    QString style;
-    switch (severity)
-    {
-    case MAV_SEVERITY_EMERGENCY:
-    case MAV_SEVERITY_ALERT:
-    case MAV_SEVERITY_CRITICAL:
-    case MAV_SEVERITY_ERROR:
-        //Use set RGB values from given color from QGC
-        style = QString("color: rgb(%1, %2, %3); font-weight:bold").arg(QGC::colorRed.red()).arg(QGC::colorRed.green()).arg(QGC::colorRed.blue());
-        _errorCount++;
-        _errorCountTotal++;
-        break;
-    case MAV_SEVERITY_NOTICE:
-    case MAV_SEVERITY_WARNING:
-        style = QString("color: rgb(%1, %2, %3); font-weight:bold").arg(QGC::colorOrange.red()).arg(QGC::colorOrange.green()).arg(QGC::colorOrange.blue());
-        _warningCount++;
-        break;
-    default:
-        style = QString("color:white; font-weight:bold");
-        _normalCount++;
-        break;
+    // Reuse the oldest slot once the ring is full, no allocation other than the text itself
+    UASMessage* message = &_ring[_nextIndex];
+    if (_retainedCount == _ring.count()) {
+        _removeFromIndices(_nextIndex);
+    } else {
+        _retainedCount++;
     }
-
-    // And determine the text for the severitie
-    QString severityText("");
+    message->_set(compId, severity, text);
+    _addToIndices(_nextIndex);
+    _nextIndex = (_nextIndex + 1) % _ring.count();
+    _receivedCount++;
+    
     switch (severity)
     {
     case MAV_SEVERITY_EMERGENCY:
-        severityText = QString(tr(" EMERGENCY:"));
-        break;
     case MAV_SEVERITY_ALERT:
-        severityText = QString(tr(" ALERT:"));
-        break;
     case MAV_SEVERITY_CRITICAL:
-        severityText = QString(tr(" Critical:"));
-        break;
     case MAV_SEVERITY_ERROR:
-        severityText = QString(tr(" Error:"));
-        break;
-    case MAV_SEVERITY_WARNING:
-        severityText = QString(tr(" Warning:"));
+        _errorCount.ref();
+        _errorCountTotal.ref();
         break;
     case MAV_SEVERITY_NOTICE:
-        severityText = QString(tr(" Notice:"));
-        break;
-    case MAV_SEVERITY_INFO:
-        severityText = QString(tr(" Info:"));
-        break;
-    case MAV_SEVERITY_DEBUG:
-        severityText = QString(tr(" Debug:"));
+    case MAV_SEVERITY_WARNING:
+        _warningCount.ref();
         break;
     default:
-        severityText = QString(tr(""));
+        _normalCount.ref();
         break;
     }
-
-    // Finally preppend the properly-styled text with a timestamp.
-    QString dateString = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
-    UASMessage* message = new UASMessage(compId, severity, text);
-    message->_setFormatedText(QString("<p style=\"color:#CCCCCC\">[%2 - COMP:%3]<font style=\"%1\">%4 %5</font></p>").arg(style).arg(dateString).arg(compId).arg(severityText).arg(text));
-    _messages.append(message);
-    int count = _messages.count();
+    
     if (message->severityIsError()) {
-        _latestError = severityText + " " + text;
+        _latestError = severityText(severity) + " " + text;
     }
-    _mutex.unlock();
     emit textMessageReceived(message);
-    emit textMessageCountChanged(count);
+    emit textMessageCountChanged(_receivedCount);
     
     if (_showErrorsInToolbar && message->severityIsError()) {
         qgcApp()->showToolBarMessage(message->getText());
@@ -195,32 +318,17 @@ void UASMessageHandler::handleTextMessage(int, int compId, int severity, QString
 }
 
 int UASMessageHandler::getErrorCountTotal() {
-    _mutex.lock();
-    int c = _errorCountTotal;
-    _mutex.unlock();
-    return c;
+    return _errorCountTotal.load();
 }
 
 int UASMessageHandler::getErrorCount() {
-    _mutex.lock();
-    int c = _errorCount;
-    _errorCount = 0;
-    _mutex.unlock();
-    return c;
+    return _errorCount.fetchAndStoreRelaxed(0);
 }
 
 int UASMessageHandler::getWarningCount() {
-    _mutex.lock();
-    int c = _warningCount;
-    _warningCount = 0;
-    _mutex.unlock();
-    return c;
+    return _warningCount.fetchAndStoreRelaxed(0);
 }
 
 int UASMessageHandler::getNormalCount() {
-    _mutex.lock();
-    int c = _normalCount;
-    _normalCount = 0;
-    _mutex.unlock();
-    return c;
+    return _normalCount.fetchAndStoreRelaxed(0);
 }
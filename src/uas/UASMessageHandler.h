@@ -32,7 +32,9 @@ This file is part of the QGROUNDCONTROL project
 
 #include <QObject>
 #include <QVector>
-#include <QMutex>
+#include <QList>
+#include <QDateTime>
+#include <QAtomicInt>
 
 #include "QGCSingleton.h"
 #include "Vehicle.h"
@@ -42,12 +44,15 @@ class UASMessageHandler;
 
 /*!
  * @class UASMessage
- * @brief Message element
+ * @brief Message element. Messages live in a fixed size ring owned by UASMessageHandler and are reused
+ *        once the ring wraps, so a pointer to a message is only valid until capacity() newer messages
+ *        have arrived.
  */
 class UASMessage
 {
     friend class UASMessageHandler;
 public:
+    UASMessage();
     /**
      * @brief Get message source component ID
      */
@@ -61,21 +66,22 @@ public:
      */
     QString getText()           { return _text; }
     /**
-     * @brief Get (html) formatted text (in the form: "[11:44:21.137 - COMP:50] Info: [pm] sending list")
+     * @brief Get (html) formatted text (in the form: "[11:44:21.137 - COMP:50] Info: [pm] sending list").
+     *        The html is built the first time it is asked for, only messages which are displayed pay for it.
      */
-    QString getFormatedText()   { return _formatedText; }
+    QString getFormatedText();
     /**
      * @return true: This message is a of a severity which is considered an error
      */
     bool severityIsError();
     
 private:
-    UASMessage(int componentid, int severity, QString text);
-    void _setFormatedText(const QString formatedText) { _formatedText = formatedText; }
-    int _compId;
-    int _severity;
-    QString _text;
-    QString _formatedText;
+    void _set(int componentid, int severity, const QString& text);
+    int         _compId;
+    int         _severity;
+    QString     _text;
+    QTime       _time;
+    QString     _formatedText;  ///< Empty until getFormatedText is called
 };
 
 class UASMessageHandler : public QGCSingleton
@@ -87,17 +93,34 @@ public:
     explicit UASMessageHandler(QObject *parent = 0);
     ~UASMessageHandler();
     /**
-     * @brief Locks access to the message list
+     * @brief Maximum number of messages kept, older messages are dropped
      */
-    void lockAccess()   {_mutex.lock(); }
+    int capacity() { return _ring.count(); }
+    void setCapacity(int capacity);
     /**
-     * @brief Unlocks access to the message list
+     * @brief Number of messages currently kept, at most capacity()
      */
-    void unlockAccess() {_mutex.unlock(); }
+    int messageCount() { return _retainedCount; }
     /**
-     * @brief Access to the message list
+     * @brief Access to a kept message, 0 is the oldest
      */
-    const QVector<UASMessage*>& messages() { return _messages; }
+    UASMessage* message(int index);
+    /**
+     * @brief Number of kept messages with the specified severity
+     */
+    int severityCount(int severity);
+    /**
+     * @brief Access to a kept message with the specified severity, 0 is the oldest
+     */
+    UASMessage* severityMessage(int severity, int index);
+    /**
+     * @brief Number of kept messages from the specified component
+     */
+    int componentCount(int componentId);
+    /**
+     * @brief Access to a kept message from the specified component, 0 is the oldest
+     */
+    UASMessage* componentMessage(int componentId, int index);
     /**
      * @brief Clear messages
      */
@@ -123,9 +146,14 @@ public:
      */
     QString getLatestError()   { return _latestError; }
     
+    /// @return Text shown for the specified MAV_SEVERITY value, for example " Warning:"
+    static QString severityText(int severity);
+    
     /// Begin to show message which are errors in the toolbar
     void showErrorsInToolbar(void) { _showErrorsInToolbar = true; }
     
+    static const int defaultCapacity = 1000;
+    
 public slots:
     /**
      * @brief Handle text message from current active UAS
@@ -144,7 +172,7 @@ signals:
     void textMessageReceived(UASMessage* message);
     /**
      * @brief Sent out when the message count changes
-     * @param count The new message count
+     * @param count Number of messages received since the last clear, including those which have been dropped
      */
     void textMessageCountChanged(int count);
     
@@ -152,16 +180,34 @@ private slots:
     void _activeVehicleChanged(Vehicle* vehicle);
     
 private:
+    void _resetIndices(void);
+    void _addToIndices(int slot);
+    void _removeFromIndices(int slot);
+    UASMessage* _indexedMessage(const QList<int>& index, int position);
+    static int _severityIndexFor(int severity);
+    
+    static const int _severityIndexCount = MAV_SEVERITY_DEBUG + 2;  ///< All MAV_SEVERITY values plus one for unknown
+    static const int _componentIndexCount = 256;
+    
     // Stores the UAS that we're currently receiving messages from.
     UASInterface* _activeUAS;
-    QVector<UASMessage*> _messages;
-    QMutex  _mutex;
-    int     _errorCount;
-    int     _errorCountTotal;
-    int     _warningCount;
-    int     _normalCount;
-    QString _latestError;
-    bool    _showErrorsInToolbar;
+    
+    // Messages are only appended and read on the gui thread. The counters below are atomic so that the
+    // counts can be read from any thread without locking.
+    QVector<UASMessage> _ring;
+    int         _nextIndex;         ///< Ring slot the next message is written to
+    int         _retainedCount;
+    int         _receivedCount;     ///< Messages received since last clear
+    // Ring slots of the kept messages by key, oldest first. The ring always drops its oldest message so removal
+    // is always from the front of these lists.
+    QList<int>  _severityIndex[_severityIndexCount];
+    QList<int>  _componentIndex[_componentIndexCount];
+    QAtomicInt  _errorCount;
+    QAtomicInt  _errorCountTotal;
+    QAtomicInt  _warningCount;
+    QAtomicInt  _normalCount;
+    QString     _latestError;
+    bool        _showErrorsInToolbar;
 };
 
 #endif // QGCMESSAGEHANDLER_H
@@ -0,0 +1,120 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "EventLoopMonitorWidget.h"
+#include "EventLoopMonitor.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QTimer>
+
+EventLoopMonitorWidget::EventLoopMonitorWidget(QWidget* parent)
+    : QWidget(parent)
+    , _summaryLabel(new QLabel(this))
+    , _histogramTable(new QTableWidget(EventLoopMonitor::histogramBucketCount, 2, this))
+    , _stallTable(new QTableWidget(0, 3, this))
+    , _resetButton(new QPushButton(tr("Reset"), this))
+    , _updatePending(false)
+{
+    setObjectName("EventLoopMonitorWidget");
+
+    _histogramTable->setHorizontalHeaderLabels(QStringList() << tr("Latency") << tr("Probes"));
+    _histogramTable->verticalHeader()->setVisible(false);
+    _histogramTable->horizontalHeader()->setStretchLastSection(true);
+    _histogramTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    for (int bucket=0; bucket<EventLoopMonitor::histogramBucketCount; bucket++) {
+        int upperMsecs = EventLoopMonitor::histogramBucketUpperMsecs(bucket);
+        QString label = upperMsecs == -1 ?
+                    tr("> %1 ms").arg(EventLoopMonitor::histogramBucketUpperMsecs(bucket - 1)) :
+                    tr("<= %1 ms").arg(upperMsecs);
+        _histogramTable->setItem(bucket, 0, new QTableWidgetItem(label));
+        _histogramTable->setItem(bucket, 1, new QTableWidgetItem());
+    }
+
+    _stallTable->setHorizontalHeaderLabels(QStringList() << tr("Time") << tr("Duration") << tr("Activity"));
+    _stallTable->verticalHeader()->setVisible(false);
+    _stallTable->horizontalHeader()->setStretchLastSection(true);
+    _stallTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    QHBoxLayout* summaryLayout = new QHBoxLayout();
+    summaryLayout->addWidget(_summaryLabel, 1);
+    summaryLayout->addWidget(_resetButton);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addLayout(summaryLayout);
+    layout->addWidget(new QLabel(tr("Dispatch latency"), this));
+    layout->addWidget(_histogramTable);
+    layout->addWidget(new QLabel(tr("Recent stalls"), this));
+    layout->addWidget(_stallTable, 1);
+
+    connect(EventLoopMonitor::instance(), &EventLoopMonitor::statisticsChanged, this, &EventLoopMonitorWidget::_statisticsChanged);
+    connect(_resetButton, &QPushButton::clicked, this, &EventLoopMonitorWidget::_reset);
+
+    _updateDisplay();
+}
+
+void EventLoopMonitorWidget::_statisticsChanged(void)
+{
+    // Statistics change with every probe. Refresh at most once a second so the panel itself doesn't load the
+    // event loop it is monitoring.
+    if (!_updatePending) {
+        _updatePending = true;
+        QTimer::singleShot(1000, this, SLOT(_updateDisplay()));
+    }
+}
+
+void EventLoopMonitorWidget::_updateDisplay(void)
+{
+    _updatePending = false;
+
+    EventLoopMonitor* monitor = EventLoopMonitor::instance();
+
+    _summaryLabel->setText(tr("%1 probes, mean %2 ms, max %3 ms, %4 stalls%5")
+                           .arg(monitor->probeCount())
+                           .arg(monitor->meanLatencyMsecs(), 0, 'f', 2)
+                           .arg(monitor->maxLatencyMsecs())
+                           .arg(monitor->stallCount())
+                           .arg(monitor->running() ? QString() : tr(" (not running)")));
+
+    for (int bucket=0; bucket<EventLoopMonitor::histogramBucketCount; bucket++) {
+        _histogramTable->item(bucket, 1)->setText(QString::number(monitor->histogramCount(bucket)));
+    }
+
+    // Newest stall first
+    QList<EventLoopMonitor::Stall_t> stalls = monitor->recentStalls();
+    _stallTable->setRowCount(stalls.count());
+    for (int i=0; i<stalls.count(); i++) {
+        const EventLoopMonitor::Stall_t& stall = stalls[stalls.count() - 1 - i];
+
+        _stallTable->setItem(i, 0, new QTableWidgetItem(stall.time.toString("hh:mm:ss.zzz")));
+        _stallTable->setItem(i, 1, new QTableWidgetItem(tr("%1 ms").arg(stall.durationMsecs)));
+        _stallTable->setItem(i, 2, new QTableWidgetItem(stall.activity.isEmpty() ? tr("unknown") : stall.activity));
+    }
+}
+
+void EventLoopMonitorWidget::_reset(void)
+{
+    EventLoopMonitor::instance()->resetStatistics();
+    _updateDisplay();
+}
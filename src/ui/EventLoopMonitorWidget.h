@@ -0,0 +1,55 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef EventLoopMonitorWidget_H
+#define EventLoopMonitorWidget_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QTableWidget>
+#include <QPushButton>
+
+/// @file
+///     @brief Diagnostics panel which shows the EventLoopMonitor latency histogram and recent stalls
+
+class EventLoopMonitorWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    EventLoopMonitorWidget(QWidget* parent = NULL);
+
+private slots:
+    void _statisticsChanged(void);
+    void _updateDisplay(void);
+    void _reset(void);
+
+private:
+    QLabel*         _summaryLabel;
+    QTableWidget*   _histogramTable;
+    QTableWidget*   _stallTable;
+    QPushButton*    _resetButton;
+    bool            _updatePending;     ///< true: refresh has been scheduled, coalesces bursts of statistics changes
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#include "ImpairedLinkConfigurationWidget.h"
+
+ImpairedLinkConfigurationWidget::ImpairedLinkConfigurationWidget(ImpairedLinkConfiguration *config, QWidget *parent, Qt::WindowFlags flags) :
+    QWidget(parent, flags)
+{
+    _ui.setupUi(this);
+    
+    Q_ASSERT(config != NULL);
+    _config = config;
+    
+    _ui.latencySpin->setValue(_config->latencyMsecs());
+    _ui.jitterSpin->setValue(_config->jitterMsecs());
+    _ui.bandwidthSpin->setValue(_config->bandwidthBitsPerSecond());
+    _ui.lossSpin->setValue(_config->lossPercent());
+    _ui.burstLossStartSpin->setValue(_config->burstLossStartPercent());
+    _ui.burstLossLengthSpin->setValue(_config->burstLossLength());
+    _ui.duplicateSpin->setValue(_config->duplicatePercent());
+    _ui.reorderSpin->setValue(_config->reorderPercent());
+    _ui.seedSpin->setValue(_config->seed());
+    
+    connect(_ui.latencySpin, SIGNAL(valueChanged(int)), this, SLOT(_latencyChanged(int)));
+    connect(_ui.jitterSpin, SIGNAL(valueChanged(int)), this, SLOT(_jitterChanged(int)));
+    connect(_ui.bandwidthSpin, SIGNAL(valueChanged(int)), this, SLOT(_bandwidthChanged(int)));
+    connect(_ui.lossSpin, SIGNAL(valueChanged(double)), this, SLOT(_lossChanged(double)));
+    connect(_ui.burstLossStartSpin, SIGNAL(valueChanged(double)), this, SLOT(_burstLossStartChanged(double)));
+    connect(_ui.burstLossLengthSpin, SIGNAL(valueChanged(int)), this, SLOT(_burstLossLengthChanged(int)));
+    connect(_ui.duplicateSpin, SIGNAL(valueChanged(double)), this, SLOT(_duplicateChanged(double)));
+    connect(_ui.reorderSpin, SIGNAL(valueChanged(double)), this, SLOT(_reorderChanged(double)));
+    connect(_ui.seedSpin, SIGNAL(valueChanged(int)), this, SLOT(_seedChanged(int)));
+}
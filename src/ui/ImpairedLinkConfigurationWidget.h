@@ -0,0 +1,56 @@
+/*=====================================================================
+
+ QGroundControl Open Source Ground Control Station
+
+ (c) 2009 - 2015 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+
+ This file is part of the QGROUNDCONTROL project
+
+ QGROUNDCONTROL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ QGROUNDCONTROL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with QGROUNDCONTROL. If not, see <http://www.gnu.org/licenses/>.
+
+ ======================================================================*/
+
+#ifndef _ImpairedLinkConfigurationWidget_H_
+#define _ImpairedLinkConfigurationWidget_H_
+
+#include <QWidget>
+
+#include "ImpairedLink.h"
+#include "ui_ImpairedLinkConfigurationWidget.h"
+
+class ImpairedLinkConfigurationWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    ImpairedLinkConfigurationWidget(ImpairedLinkConfiguration* config, QWidget *parent = 0, Qt::WindowFlags flags = Qt::Sheet);
+    
+private slots:
+    void _latencyChanged(int latencyMsecs)              { _config->setLatencyMsecs(latencyMsecs); }
+    void _jitterChanged(int jitterMsecs)                { _config->setJitterMsecs(jitterMsecs); }
+    void _bandwidthChanged(int bitsPerSecond)           { _config->setBandwidthBitsPerSecond(bitsPerSecond); }
+    void _lossChanged(double percent)                   { _config->setLossPercent(percent); }
+    void _burstLossStartChanged(double percent)         { _config->setBurstLossStartPercent(percent); }
+    void _burstLossLengthChanged(int length)            { _config->setBurstLossLength(length); }
+    void _duplicateChanged(double percent)              { _config->setDuplicatePercent(percent); }
+    void _reorderChanged(double percent)                { _config->setReorderPercent(percent); }
+    void _seedChanged(int seed)                         { _config->setSeed(seed); }
+
+private:
+    Ui::ImpairedLinkConfigurationWidget _ui;
+    ImpairedLinkConfiguration*          _config;
+};
+
+
+#endif
@@ -1,4 +1,5 @@
 #include "MAVLinkDecoder.h"
+#include "VehicleTimeSync.h"
 
 #include <QDebug>
 
@@ -45,6 +46,7 @@ MAVLinkDecoder::MAVLinkDecoder(MAVLinkProtocol* protocol, QObject *parent) :
     #endif
     messageFilter.insert(MAVLINK_MSG_ID_EXTENDED_MESSAGE, false);
     messageFilter.insert(MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL, false);
+    messageFilter.insert(MAVLINK_MSG_ID_TIMESYNC, false);
 
     textMessageFilter.insert(MAVLINK_MSG_ID_DEBUG, false);
     textMessageFilter.insert(MAVLINK_MSG_ID_DEBUG_VECT, false);
@@ -143,15 +145,19 @@ quint64 MAVLinkDecoder::getUnixTimeFromMs(int systemID, quint64 time)
     else if (time < 1261440000000)
 #endif
     {
-        if (onboardTimeOffset[systemID] == 0 || time < (firstOnboardTime[systemID]-100))
+        // Prefer the filtered TIMESYNC mapping, the fallback below carries the link delay of a single sample
+        if (!VehicleTimeSync::onboardToGcsMsecs(systemID, time, &ret))
         {
-            firstOnboardTime[systemID] = time;
-            onboardTimeOffset[systemID] = QGC::groundTimeMilliseconds() - time;
-        }
+            if (onboardTimeOffset[systemID] == 0 || time < (firstOnboardTime[systemID]-100))
+            {
+                firstOnboardTime[systemID] = time;
+                onboardTimeOffset[systemID] = QGC::groundTimeMilliseconds() - time;
+            }
 
-        if (time > firstOnboardTime[systemID]) firstOnboardTime[systemID] = time;
+            if (time > firstOnboardTime[systemID]) firstOnboardTime[systemID] = time;
 
-        ret = time + onboardTimeOffset[systemID];
+            ret = time + onboardTimeOffset[systemID];
+        }
     }
     else
     {
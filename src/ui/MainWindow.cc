@@ -38,6 +38,7 @@ This file is part of the QGROUNDCONTROL project
 #include <QDesktopWidget>
 #include <QScreen>
 #include <QDesktopServices>
+#include <QStandardPaths>
 
 #include "QGC.h"
 #include "MAVLinkProtocol.h"
@@ -65,6 +66,8 @@ This file is part of the QGROUNDCONTROL project
 #include "HomePositionManager.h"
 #include "MissionEditor.h"
 #include "LogCompressor.h"
+#include "QGCTrace.h"
+#include "EventLoopMonitorWidget.h"
 
 #ifndef __mobile__
 #include "HILDockWidget.h"
@@ -94,6 +97,7 @@ const char* MainWindow::_mapViewDockWidgetName = "MAP_VIEW_DOCKWIDGET";
 const char* MainWindow::_pfdDockWidgetName = "PRIMARY_FLIGHT_DISPLAY_DOCKWIDGET";
 const char* MainWindow::_uasInfoViewDockWidgetName = "UAS_INFO_INFOVIEW_DOCKWIDGET";
 const char* MainWindow::_hilDockWidgetName = "HIL_DOCKWIDGET";
+const char* MainWindow::_eventLoopMonitorDockWidgetName = "EVENT_LOOP_MONITOR_DOCKWIDGET";
 
 static MainWindow* _instance = NULL;   ///< @brief MainWindow singleton
 
@@ -168,6 +172,12 @@ MainWindow::MainWindow(QSplashScreen* splashScreen)
     _ui.menuWidgets->addAction(qmlTestAction);
 #endif
 
+#ifdef QGC_TRACING_ENABLED
+    QAction* saveTraceAction = new QAction(tr("Save Trace..."), this);
+    connect(saveTraceAction, &QAction::triggered, this, &MainWindow::_saveTrace);
+    _ui.menuMGround->insertAction(_ui.actionExit, saveTraceAction);
+#endif
+
     // Load QML Toolbar
     QDockWidget* widget = new QDockWidget(this);
     widget->setObjectName("ToolBarDockWidget");
@@ -392,6 +402,7 @@ void MainWindow::_buildCommonWidgets(void)
         { _pfdDockWidgetName,               "Primary Flight Display",   Qt::RightDockWidgetArea },
         { _uasInfoViewDockWidgetName,       "Info View",                Qt::LeftDockWidgetArea },
         { _hilDockWidgetName,               "HIL Config",               Qt::LeftDockWidgetArea },
+        { _eventLoopMonitorDockWidgetName,  "Event Loop Monitor",       Qt::RightDockWidgetArea },
     };
     static const size_t cDockWidgetInfo = sizeof(rgDockWidgetInfo) / sizeof(rgDockWidgetInfo[0]);
 
@@ -491,6 +502,8 @@ void MainWindow::_createInnerDockWidget(const QString& widgetName)
         QGCTabbedInfoView* pInfoView = new QGCTabbedInfoView(this);
         pInfoView->addSource(mavlinkDecoder);
         widget = pInfoView;
+    } else if (widgetName == _eventLoopMonitorDockWidgetName) {
+        widget = new EventLoopMonitorWidget(this);
     } else {
         qWarning() << "Attempt to create unknown Inner Dock Widget" << widgetName;
     }
@@ -948,3 +961,22 @@ void MainWindow::_showQmlTestWidget(void)
     new QmlTestWidget();
 }
 #endif
+
+#ifdef QGC_TRACING_ENABLED
+/// Saves the recent hot path trace events in Chrome trace format for loading into about:tracing or Perfetto
+void MainWindow::_saveTrace(void)
+{
+    QString fileName = QGCFileDialog::getSaveFileName(this,
+        tr("Save Trace"),
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
+        tr("Chrome Trace Files (*.json)"),
+        "json");
+
+    if (!fileName.isEmpty()) {
+        QString errorString;
+        if (!QGCTrace::writeChromeTrace(fileName, errorString)) {
+            QGCMessageBox::warning(tr("Save Trace"), tr("Unable to save trace: %1").arg(errorString));
+        }
+    }
+}
+#endif
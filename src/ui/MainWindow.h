@@ -255,6 +255,9 @@ private slots:
     void _linkStateChange(LinkInterface*);
 #ifdef UNITTEST_BUILD
     void _showQmlTestWidget(void);
+#endif
+#ifdef QGC_TRACING_ENABLED
+    void _saveTrace(void);
 #endif
 	void _closeWindow(void) { close(); }
     
@@ -285,6 +288,7 @@ private:
     static const char* _pfdDockWidgetName;
     static const char* _uasInfoViewDockWidgetName;
     static const char* _hilDockWidgetName;
+    static const char* _eventLoopMonitorDockWidgetName;
 
     QMap<QString, QDockWidget*>     _mapName2DockWidget;
     QMap<QDockWidget*, QAction*>    _mapDockWidget2Action;
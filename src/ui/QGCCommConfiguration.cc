@@ -37,6 +37,7 @@ This file is part of the QGROUNDCONTROL project
 #include "QGCUDPLinkConfiguration.h"
 #include "QGCTCPLinkConfiguration.h"
 #include "LogReplayLinkConfigurationWidget.h"
+#include "ImpairedLinkConfigurationWidget.h"
 #include "QGCCommConfiguration.h"
 #include "ui_QGCCommConfiguration.h"
 
@@ -56,6 +57,7 @@ QGCCommConfiguration::QGCCommConfiguration(QWidget *parent, LinkConfiguration *c
     _ui->typeCombo->addItem(tr("Log replay"),   LinkConfiguration::TypeLogReplay);
 #ifdef QT_DEBUG
     _ui->typeCombo->addItem(tr("Mock"),         LinkConfiguration::TypeMock);
+    _ui->typeCombo->addItem(tr("Impaired"),     LinkConfiguration::TypeImpaired);
 #endif
 
 #if 0
@@ -156,6 +158,13 @@ void QGCCommConfiguration::_loadTypeConfigWidget(int type)
             _ui->typeCombo->setCurrentIndex(_ui->typeCombo->findData(LinkConfiguration::TypeMock));
         }
         break;
+        case LinkConfiguration::TypeImpaired: {
+            QWidget* conf = new ImpairedLinkConfigurationWidget((ImpairedLinkConfiguration*)_config, this);
+            _ui->linkScrollArea->setWidget(conf);
+            _ui->linkGroupBox->setTitle(tr("Impaired Link"));
+            _ui->typeCombo->setCurrentIndex(_ui->typeCombo->findData(LinkConfiguration::TypeImpaired));
+        }
+        break;
 #endif
         // Cannot be the case, but in case it gets here, we cannot continue.
         default:
@@ -172,6 +172,10 @@ void QGCLinkConfiguration::_fixUnnamed(LinkConfiguration* config)
                 config->setName(
                     QString("Mock Link"));
                 break;
+            case LinkConfiguration::TypeImpaired:
+                config->setName(
+                    QString("Impaired Link"));
+                break;
 #endif
         }
     }
@@ -32,6 +32,7 @@
 QGCUASFileView::QGCUASFileView(QWidget *parent, FileManager *manager) :
     QWidget(parent),
     _manager(manager),
+    _fileSync(manager),
     _currentCommand(commandNone)
 {
     _ui.setupUi(this);
@@ -42,6 +43,7 @@ QGCUASFileView::QGCUASFileView(QWidget *parent, FileManager *manager) :
     connect(_ui.listFilesButton,    &QPushButton::clicked,              this, &QGCUASFileView::_refreshTree);
     connect(_ui.downloadButton,     &QPushButton::clicked,              this, &QGCUASFileView::_downloadFile);
     connect(_ui.uploadButton,       &QPushButton::clicked,              this, &QGCUASFileView::_uploadFile);
+    connect(_ui.syncButton,         &QPushButton::clicked,              this, &QGCUASFileView::_syncDirectory);
     connect(_ui.treeWidget,         &QTreeWidget::currentItemChanged,   this, &QGCUASFileView::_currentItemChanged);
 
     // Connect signals from FileManager
@@ -49,6 +51,11 @@ QGCUASFileView::QGCUASFileView(QWidget *parent, FileManager *manager) :
     connect(_manager, &FileManager::commandComplete,    this, &QGCUASFileView::_commandComplete);
     connect(_manager, &FileManager::commandError,       this, &QGCUASFileView::_commandError);
     connect(_manager, &FileManager::listEntry,  this, &QGCUASFileView::_listEntryReceived);
+    
+    // Connect signals from FileSync
+    connect(&_fileSync, &FileSync::progress,    _ui.progressBar,    &QProgressBar::setValue);
+    connect(&_fileSync, &FileSync::complete,    this,               &QGCUASFileView::_syncComplete);
+    connect(&_fileSync, &FileSync::error,       this,               &QGCUASFileView::_syncError);
 }
 
 /// @brief Downloads the file currently selected in the tree view
@@ -130,10 +137,81 @@ void QGCUASFileView::_uploadFile(void)
     _manager->uploadPath(path, uploadFromHere);
 }
 
+/// @brief Syncs the directory currently selected in the tree view to a local directory. Cancels the sync if one is
+/// already running.
+void QGCUASFileView::_syncDirectory(void)
+{
+    if (_currentCommand == commandSync) {
+        _fileSync.cancel();
+        return;
+    }
+    
+    if (_currentCommand != commandNone) {
+        qWarning() << QString("Sync attempted while another command was in progress: _currentCommand(%1)").arg(_currentCommand);
+        return;
+    }
+    
+    _ui.statusText->clear();
+    
+    QTreeWidgetItem* item = _ui.treeWidget->currentItem();
+    if (!item || item->type() != _typeDir) {
+        return;
+    }
+    
+    // Find complete path for sync directory
+    QString path;
+    do {
+        QString name = item->text(0).split("\t")[0];    // Strip off file sizes
+        path.prepend("/" + name);
+        item = item->parent();
+    } while (item);
+    
+    QString syncToHere = QGCFileDialog::getExistingDirectory(this,
+                                                             "Sync Directory",
+                                                             QDir::homePath(),
+                                                             QGCFileDialog::ShowDirsOnly | QGCFileDialog::DontResolveSymlinks);
+    if (syncToHere.isEmpty()) {
+        return;
+    }
+    
+    _setAllButtonsEnabled(false);
+    _ui.syncButton->setEnabled(true);
+    _ui.syncButton->setText("Cancel Sync");
+    _currentCommand = commandSync;
+    
+    _ui.statusText->setText(QString("Syncing: %1").arg(path));
+    
+    _fileSync.sync(path, QDir(syncToHere));
+}
+
+/// @brief Called when a directory sync completes successfully
+void QGCUASFileView::_syncComplete(int downloadedCount, int skippedCount)
+{
+    _currentCommand = commandNone;
+    _ui.syncButton->setText("Sync Directory");
+    _setAllButtonsEnabled(true);
+    _ui.statusText->setText(QString("Sync complete: %1 downloaded, %2 unchanged").arg(downloadedCount).arg(skippedCount));
+    _ui.progressBar->reset();
+}
+
+/// @brief Called when a directory sync fails or is cancelled
+void QGCUASFileView::_syncError(const QString& msg)
+{
+    _currentCommand = commandNone;
+    _ui.syncButton->setText("Sync Directory");
+    _setAllButtonsEnabled(true);
+    _ui.statusText->setText(QString("Error: %1").arg(msg));
+}
+
 /// @brief Called to update the progress of the download.
 ///     @param value Progress bar value
 void QGCUASFileView::_commandProgress(int value)
 {
+    if (_currentCommand == commandSync) {
+        // FileSync reports overall progress
+        return;
+    }
+    
     _ui.progressBar->setValue(value);
 }
 
@@ -141,6 +219,11 @@ void QGCUASFileView::_commandProgress(int value)
 ///     @param msg Error message
 void QGCUASFileView::_commandError(const QString& msg)
 {
+    if (_currentCommand == commandSync) {
+        // Handled by FileSync
+        return;
+    }
+    
     _setAllButtonsEnabled(true);
     _currentCommand = commandNone;
     _ui.statusText->setText(QString("Error: %1").arg(msg));
@@ -171,6 +254,11 @@ void QGCUASFileView::_refreshTree(void)
 /// @brief Adds the specified directory entry to the tree view.
 void QGCUASFileView::_listEntryReceived(const QString& entry)
 {
+    if (_currentCommand == commandSync) {
+        // Directory list issued by FileSync
+        return;
+    }
+    
     if (_currentCommand != commandList) {
         qWarning() << QString("List entry received while no list command in progress: _currentCommand(%1)").arg(_currentCommand);
         return;
@@ -199,6 +287,11 @@ void QGCUASFileView::_listEntryReceived(const QString& entry)
 /// @brief Called when a command completes successfully
 void QGCUASFileView::_commandComplete(void)
 {
+    if (_currentCommand == commandSync) {
+        // Individual steps of a directory sync
+        return;
+    }
+    
     QString statusText;
     
     if (_currentCommand == commandDownload) {
@@ -270,6 +363,7 @@ void QGCUASFileView::_currentItemChanged(QTreeWidgetItem* current, QTreeWidgetIt
     
     _ui.downloadButton->setEnabled(current ? (current->type() == _typeFile) : false);
     _ui.uploadButton->setEnabled(current ? (current->type() == _typeDir) : false);
+    _ui.syncButton->setEnabled(current ? (current->type() == _typeDir) : false);
 }
 
 void QGCUASFileView::_requestDirectoryList(const QString& dir)
@@ -283,6 +377,7 @@ void QGCUASFileView::_setAllButtonsEnabled(bool enabled)
     _ui.downloadButton->setEnabled(enabled);
     _ui.listFilesButton->setEnabled(enabled);
     _ui.uploadButton->setEnabled(enabled);
+    _ui.syncButton->setEnabled(enabled);
     
     if (enabled) {
         _currentItemChanged(_ui.treeWidget->currentItem(), NULL);
@@ -28,6 +28,7 @@
 #include <QTreeWidgetItem>
 
 #include "uas/FileManager.h"
+#include "uas/FileSync.h"
 #include "ui_QGCUASFileView.h"
 
 class QGCUASFileView : public QWidget
@@ -46,10 +47,14 @@ private slots:
     void _refreshTree(void);
     void _downloadFile(void);
     void _uploadFile(void);
+    void _syncDirectory(void);
     
     void _commandProgress(int value);
     void _commandError(const QString& msg);
     void _commandComplete(void);
+    
+    void _syncComplete(int downloadedCount, int skippedCount);
+    void _syncError(const QString& msg);
 
     void _currentItemChanged(QTreeWidgetItem* current, QTreeWidgetItem* previous);
 
@@ -65,12 +70,14 @@ private:
     QList<int>              _walkIndexStack;
     QList<QTreeWidgetItem*> _walkItemStack;
     Ui::QGCUASFileView      _ui;
+    FileSync                _fileSync;
     
     enum CommandState {
         commandNone,        ///< No command active
         commandList,        ///< List command active
         commandDownload,    ///< Download command active
-        commandUpload       ///< Upload command active
+        commandUpload,      ///< Upload command active
+        commandSync         ///< Directory sync active
     };
     
     CommandState _currentCommand;   ///< Current active command
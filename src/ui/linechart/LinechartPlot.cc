@@ -25,6 +25,7 @@
 #include "ChartPlot.h"
 
 #include "QGC.h"
+#include "QGCTrace.h"
 
 /**
  * @brief The default constructor
@@ -646,6 +647,8 @@ void LinechartPlot::setAverageWindow(int windowSize)
  **/
 void LinechartPlot::paintRealtime()
 {
+    QGC_TRACE_SCOPE("plot", "LinechartPlot::paintRealtime");
+    
     if (m_active) {
 #if (QGC_EVENTLOOP_DEBUG)
         static quint64 timestamp = 0;
@@ -217,7 +217,7 @@ void MainToolBar::onConnect(QString conf)
 void MainToolBar::onEnterMessageArea(int x, int y)
 {
     // If not already there and messages are actually present
-    if(!_rollDownMessages && UASMessageHandler::instance()->messages().count())
+    if(!_rollDownMessages && UASMessageHandler::instance()->messageCount())
     {
         if (MultiVehicleManager::instance()->activeVehicle())
             MultiVehicleManager::instance()->activeVehicle()->resetMessages();
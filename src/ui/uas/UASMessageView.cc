@@ -66,6 +66,8 @@ UASMessageViewWidget::UASMessageViewWidget(QWidget *parent)
     QAction* clearAction = new QAction(tr("Clear Messages"), this);
     connect(clearAction, &QAction::triggered, this, &UASMessageViewWidget::clearMessages);
     ui()->plainTextEdit->addAction(clearAction);
+    // Keep no more lines than the message handler keeps messages
+    ui()->plainTextEdit->setMaximumBlockCount(UASMessageHandler::instance()->capacity());
     // Connect message handler
     connect(UASMessageHandler::instance(), &UASMessageHandler::textMessageReceived, this, &UASMessageViewWidget::handleTextMessage);
 }
@@ -118,17 +120,16 @@ UASMessageViewRollDown::UASMessageViewRollDown(QWidget *parent)
     setStyleSheet("background-color: rgba(0%,0%,0%,80%); border: 2px;");
     QPlainTextEdit *msgWidget = ui()->plainTextEdit;
     // Init Messages
-    UASMessageHandler::instance()->lockAccess();
+    UASMessageHandler* msgHandler = UASMessageHandler::instance();
+    msgWidget->setMaximumBlockCount(msgHandler->capacity());
     msgWidget->setUpdatesEnabled(false);
-    QVector<UASMessage*> messages = UASMessageHandler::instance()->messages();
-    for(int i = 0; i < messages.count(); i++) {
-        msgWidget->appendHtml(messages.at(i)->getFormatedText());
+    for(int i = 0; i < msgHandler->messageCount(); i++) {
+        msgWidget->appendHtml(msgHandler->message(i)->getFormatedText());
     }
     QScrollBar *scroller = msgWidget->verticalScrollBar();
     scroller->setValue(scroller->maximum());
     msgWidget->setUpdatesEnabled(true);
-    connect(UASMessageHandler::instance(), &UASMessageHandler::textMessageReceived, this, &UASMessageViewRollDown::handleTextMessage);
-    UASMessageHandler::instance()->unlockAccess();
+    connect(msgHandler, &UASMessageHandler::textMessageReceived, this, &UASMessageViewRollDown::handleTextMessage);
 }
 
 UASMessageViewRollDown::~UASMessageViewRollDown()